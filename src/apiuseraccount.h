@@ -47,6 +47,16 @@ struct APIStats
 {
   // number of API requests currently queued
   int requestsQueued = 0;
+
+  // number of API requests sent since startup
+  int requestsSent = 0;
+
+  // number of sent requests that went over HTTP/2
+  int http2Requests = 0;
+
+  // number of TLS handshakes with the API, the other requests reused an
+  // existing connection
+  int handshakes = 0;
 };
 
 
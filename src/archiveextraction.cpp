@@ -0,0 +1,263 @@
+#include "archiveextraction.h"
+#include "taskexecutor.h"
+#include <bsatk.h>
+#include <log.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <algorithm>
+#include <vector>
+
+using namespace MOBase;
+using namespace MOShared;
+
+// ranges smaller than this are not worth the cost of opening the archive
+// again in another task
+static constexpr std::size_t MinFilesPerTask = 200;
+
+// errors after this many are only counted
+static constexpr int MaxErrors = 10;
+
+// a file of an archive along with the directory it's extracted to
+//
+struct ExtractedFile
+{
+  BSA::File::Ptr file;
+  std::string directory;
+};
+
+// lists the files of the given folder and its subfolders in a stable order,
+// every task of an archive lists them the same way; directories are created
+// if `mkdirs` is true
+//
+static void listFiles(
+  const BSA::Folder::Ptr& folder, const QString& dir,
+  std::vector<ExtractedFile>& out, bool mkdirs)
+{
+  if (mkdirs) {
+    QDir().mkpath(dir);
+  }
+
+  const auto native = QDir::toNativeSeparators(dir).toLocal8Bit();
+
+  for (unsigned int i = 0; i < folder->getNumFiles(); ++i) {
+    out.push_back({folder->getFile(i), native.constData()});
+  }
+
+  for (unsigned int i = 0; i < folder->getNumSubFolders(); ++i) {
+    const BSA::Folder::Ptr sub = folder->getSubFolder(i);
+
+    listFiles(
+      sub, dir + "/" + QString::fromStdString(sub->getName()), out, mkdirs);
+  }
+}
+
+// opens the given archive, returns false if it can't be read; `res` can be
+// ERROR_INVALIDHASHES when this returns true
+//
+static bool openArchive(
+  BSA::Archive& archive, const QString& path, bool testHashes,
+  BSA::EErrorCode& res)
+{
+  try
+  {
+    // read() can return an error, but it can also throw if the file is not a
+    // valid bsa
+    res = archive.read(path.toLocal8Bit().constData(), testHashes);
+  }
+  catch(std::exception& e)
+  {
+    log::error("invalid archive '{}', error {}", path, e.what());
+    res = BSA::ERROR_INVALIDDATA;
+    return false;
+  }
+
+  return (res == BSA::ERROR_NONE || res == BSA::ERROR_INVALIDHASHES);
+}
+
+
+std::shared_ptr<ArchiveExtraction> ArchiveExtraction::start(
+  QStringList archives, QString destination)
+{
+  std::shared_ptr<ArchiveExtraction> p(
+    new ArchiveExtraction(std::move(archives), std::move(destination)));
+
+  TaskExecutor::instance().post(TaskPriority::Normal, [p] { p->run(); });
+
+  return p;
+}
+
+ArchiveExtraction::ArchiveExtraction(QStringList archives, QString destination)
+  : m_archives(std::move(archives)), m_destination(std::move(destination)),
+    m_cancelled(false), m_finished(false), m_done(0), m_total(0),
+    m_errorCount(0)
+{
+}
+
+void ArchiveExtraction::cancel()
+{
+  m_cancelled = true;
+}
+
+bool ArchiveExtraction::cancelled() const
+{
+  return m_cancelled;
+}
+
+bool ArchiveExtraction::finished() const
+{
+  return m_finished;
+}
+
+std::size_t ArchiveExtraction::filesDone() const
+{
+  return m_done;
+}
+
+std::size_t ArchiveExtraction::filesTotal() const
+{
+  return m_total;
+}
+
+QString ArchiveExtraction::currentArchive() const
+{
+  std::scoped_lock lock(m_mutex);
+  return m_current;
+}
+
+QStringList ArchiveExtraction::errors() const
+{
+  std::scoped_lock lock(m_mutex);
+
+  auto v = m_errors;
+  const auto shown = static_cast<std::size_t>(m_errors.size());
+
+  if (m_errorCount > shown) {
+    v.append(QCoreApplication::translate("ArchiveExtraction", "%1 more errors")
+      .arg(m_errorCount - shown));
+  }
+
+  return v;
+}
+
+QStringList ArchiveExtraction::invalidHashes() const
+{
+  std::scoped_lock lock(m_mutex);
+  return m_invalidHashes;
+}
+
+void ArchiveExtraction::run()
+{
+  for (const auto& path : m_archives) {
+    if (m_cancelled) {
+      break;
+    }
+
+    {
+      std::scoped_lock lock(m_mutex);
+      m_current = path;
+    }
+
+    extractArchive(path);
+  }
+
+  m_finished = true;
+}
+
+void ArchiveExtraction::extractArchive(const QString& path)
+{
+  log::debug("extracting '{}' to '{}'", path, m_destination);
+
+  std::size_t count = 0;
+
+  {
+    // the archive is read once here to check it, count the files and create
+    // the directories, so the tasks don't race to create them
+    BSA::Archive archive;
+    BSA::EErrorCode res = BSA::ERROR_NONE;
+
+    if (!openArchive(archive, path, true, res)) {
+      addError(QCoreApplication::translate("ArchiveExtraction", "failed to read %1: %2")
+        .arg(path).arg(res));
+
+      return;
+    }
+
+    if (res == BSA::ERROR_INVALIDHASHES) {
+      std::scoped_lock lock(m_mutex);
+      m_invalidHashes.append(path);
+    }
+
+    std::vector<ExtractedFile> files;
+    listFiles(archive.getRoot(), m_destination, files, true);
+    archive.close();
+
+    count = files.size();
+  }
+
+  m_total += count;
+
+  const std::size_t tasks = std::clamp<std::size_t>(
+    count / MinFilesPerTask, 1, TaskExecutor::instance().threadCount());
+
+  const std::size_t perTask = (count + tasks - 1) / tasks;
+
+  TaskGroup g(TaskPriority::Normal);
+
+  for (std::size_t begin = 0; begin < count; begin += perTask) {
+    const std::size_t end = std::min(begin + perTask, count);
+    g.run([this, path, begin, end] { extractRange(path, begin, end); });
+  }
+
+  g.wait();
+}
+
+void ArchiveExtraction::extractRange(
+  const QString& path, std::size_t begin, std::size_t end)
+{
+  BSA::Archive archive;
+  BSA::EErrorCode res = BSA::ERROR_NONE;
+
+  if (!openArchive(archive, path, false, res)) {
+    addError(QCoreApplication::translate("ArchiveExtraction", "failed to read %1: %2")
+      .arg(path).arg(res));
+
+    // the files are counted as done so the progress still completes
+    m_done += end - begin;
+    return;
+  }
+
+  std::vector<ExtractedFile> files;
+  listFiles(archive.getRoot(), m_destination, files, false);
+
+  // contiguous files are next to each other in the archive, so each task
+  // mostly reads sequentially
+  for (std::size_t i = begin; i < end && i < files.size(); ++i) {
+    if (m_cancelled) {
+      break;
+    }
+
+    const auto& f = files[i];
+
+    res = archive.extract(f.file, f.directory.c_str());
+    if (res != BSA::ERROR_NONE) {
+      addError(QCoreApplication::translate("ArchiveExtraction", "failed to extract %1: %2")
+        .arg(QString::fromStdString(f.file->getName())).arg(res));
+    }
+
+    ++m_done;
+  }
+
+  archive.close();
+}
+
+void ArchiveExtraction::addError(QString s)
+{
+  log::error("{}", s);
+
+  std::scoped_lock lock(m_mutex);
+
+  ++m_errorCount;
+  if (m_errors.size() < MaxErrors) {
+    m_errors.append(std::move(s));
+  }
+}
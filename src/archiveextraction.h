@@ -0,0 +1,85 @@
+#ifndef MODORGANIZER_ARCHIVEEXTRACTION_INCLUDED
+#define MODORGANIZER_ARCHIVEEXTRACTION_INCLUDED
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+// extracts bsa and ba2 archives into a directory in the background
+//
+// the files of an archive are independent, so they're split in contiguous
+// ranges extracted in parallel on the TaskExecutor; each task opens the
+// archive on its own because an archive can only read one file at a time
+//
+// the state is shared with the tasks, so the object returned by start() can
+// be released at any time; it's polled from the ui thread for progress and
+// cancel() stops the tasks after the file they're extracting
+//
+class ArchiveExtraction
+{
+public:
+  // starts extracting the given archives, in order, into `destination`
+  //
+  static std::shared_ptr<ArchiveExtraction> start(
+    QStringList archives, QString destination);
+
+  // stops after the files being extracted, the remaining archives are
+  // skipped
+  //
+  void cancel();
+
+  bool cancelled() const;
+
+  // whether all the archives have been extracted or the extraction has been
+  // cancelled and the tasks have stopped
+  //
+  bool finished() const;
+
+  // number of files extracted so far and number of files in the archives
+  // that have been read; the total grows as archives are read
+  //
+  std::size_t filesDone() const;
+  std::size_t filesTotal() const;
+
+  // path of the archive being extracted
+  //
+  QString currentArchive() const;
+
+  // errors that happened so far, only the first few are kept
+  //
+  QStringList errors() const;
+
+  // paths of the archives that have invalid hashes, their files may be
+  // broken
+  //
+  QStringList invalidHashes() const;
+
+private:
+  struct Range;
+
+  QStringList m_archives;
+  QString m_destination;
+
+  std::atomic<bool> m_cancelled;
+  std::atomic<bool> m_finished;
+  std::atomic<std::size_t> m_done;
+  std::atomic<std::size_t> m_total;
+
+  mutable std::mutex m_mutex;
+  QString m_current;
+  QStringList m_errors;
+  std::size_t m_errorCount;
+  QStringList m_invalidHashes;
+
+  ArchiveExtraction(QStringList archives, QString destination);
+
+  void run();
+  void extractArchive(const QString& path);
+  void extractRange(const QString& path, std::size_t begin, std::size_t end);
+
+  void addError(QString s);
+};
+
+#endif // MODORGANIZER_ARCHIVEEXTRACTION_INCLUDED
@@ -19,6 +19,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 // For QObject::tr:
 #include <QObject>
+#include <QSet>
 
 #include "archivefiletree.h"
 
@@ -58,12 +59,27 @@ public:
 class ArchiveFileTreeImpl: public virtual ArchiveFileTree, public virtual ArchiveFileEntry {
 public:
 
-  using File = std::tuple<QStringList, bool, int>;
+  /**
+   * Path components of every entry in the archive, by archive index. This is built
+   * once and shared by all the trees so the components are not copied for each level.
+   */
+  using Paths = std::shared_ptr<const std::vector<QStringList>>;
+
+  struct File {
+    // Index of the entry in the archive and in the paths:
+    int index;
+
+    // Index of the path component at the level of the tree holding this file:
+    int depth;
+
+    bool isDirectory;
+  };
 
 public: // Public for make_shared (but not accessible by other since not exposed in .h):
 
-  ArchiveFileTreeImpl(std::shared_ptr<const IFileTree> parent, QString name, int index, std::vector<File> files)
-    : FileTreeEntry(parent, name), ArchiveFileEntry(parent, name, index), IFileTree(), m_Files(std::move(files)) { }
+  ArchiveFileTreeImpl(std::shared_ptr<const IFileTree> parent, QString name, int index, Paths paths, std::vector<File> files)
+    : FileTreeEntry(parent, name), ArchiveFileEntry(parent, name, index), IFileTree(),
+      m_Paths(std::move(paths)), m_Files(std::move(files)) { }
 
 public: // Override to avoid VS warnings:
 
@@ -132,7 +148,7 @@ protected:
    */
   virtual std::shared_ptr<IFileTree> makeDirectory(
     std::shared_ptr<const IFileTree> parent, QString name) const override {
-    return std::make_shared<ArchiveFileTreeImpl>(parent, name, -1, std::vector<File>{});
+    return std::make_shared<ArchiveFileTreeImpl>(parent, name, -1, nullptr, std::vector<File>{});
   }
 
   virtual std::shared_ptr<FileTreeEntry> makeFile(
@@ -142,10 +158,14 @@ protected:
 
   virtual bool doPopulate(std::shared_ptr<const IFileTree> parent, std::vector<std::shared_ptr<FileTreeEntry>>& entries) const override {
 
+    // The name of the file at this level, and whether it is the last component:
+    auto name = [this](const File& f) -> const QString& { return (*m_Paths)[f.index][f.depth]; };
+    auto isLast = [this](const File& f) { return f.depth + 1 == (*m_Paths)[f.index].size(); };
+
     // Sort by name:
     std::sort(std::begin(m_Files), std::end(m_Files),
-      [](const auto& a, const auto& b) {
-        return std::get<0>(a)[0].compare(std::get<0>(b)[0], Qt::CaseInsensitive) < 0; });
+      [&](const auto& a, const auto& b) {
+        return name(a).compare(name(b), Qt::CaseInsensitive) < 0; });
 
     // We know that the files are sorted:
     QString currentName = "";
@@ -155,16 +175,16 @@ protected:
 
       // At the start or if we have reset, just retrieve the current name:
       if (currentName == "") {
-        currentName = std::get<0>(p)[0];
+        currentName = name(p);
       }
 
       // If the name is different, we need to create a directory from what we have 
       // accumulated:
-      if (currentName != std::get<0>(p)[0]) {
+      if (currentName != name(p)) {
 
         // We may or may not have an index here, it depends on the type of archive (some archives list
         // intermediate non-empty folders, some don't):
-        entries.push_back(std::make_shared<ArchiveFileTreeImpl>(parent, currentName, currentIndex, std::move(currentFiles)));
+        entries.push_back(std::make_shared<ArchiveFileTreeImpl>(parent, currentName, currentIndex, m_Paths, std::move(currentFiles)));
         
         currentFiles.clear(); // Back to a valid state.
 
@@ -173,32 +193,30 @@ protected:
       }
 
       // We can always override the current name:
-      currentName = std::get<0>(p)[0];
+      currentName = name(p);
 
       // If the current path contains only one components:
-      if (std::get<0>(p).size() == 1) {
+      if (isLast(p)) {
 
         // If it is not a directory, then it is a file in directly under this tree:
-        if (!std::get<1>(p)) {
+        if (!p.isDirectory) {
           entries.push_back(
-            std::make_shared<ArchiveFileEntry>(parent, currentName, std::get<2>(p)));
+            std::make_shared<ArchiveFileEntry>(parent, currentName, p.index));
           currentName = "";
         }
         else {
           // Otherwize, it is the actual "file" corresponding to the directory we are listing, so we can retrieve
           // the index here:
-          currentIndex = std::get<2>(p);
+          currentIndex = p.index;
         }
       }
       else {
-        currentFiles.push_back({
-          QStringList(std::get<0>(p).begin() + 1, std::get<0>(p).end()), std::get<1>(p), std::get<2>(p)
-        });
+        currentFiles.push_back({ p.index, p.depth + 1, p.isDirectory });
       }
     }
 
     if (currentName != "") {
-      entries.push_back(std::make_shared<ArchiveFileTreeImpl>(parent, currentName, currentIndex, std::move(currentFiles)));
+      entries.push_back(std::make_shared<ArchiveFileTreeImpl>(parent, currentName, currentIndex, m_Paths, std::move(currentFiles)));
     }
     
     // Let the parent class sort the entries:
@@ -206,11 +224,12 @@ protected:
   }
 
   virtual std::shared_ptr<IFileTree> doClone() const override {
-    return std::make_shared<ArchiveFileTreeImpl>(nullptr, name(), m_Index, m_Files);
+    return std::make_shared<ArchiveFileTreeImpl>(nullptr, name(), m_Index, m_Paths, m_Files);
   }
 
 private:
 
+  Paths m_Paths;
   mutable std::vector<File> m_Files;
 };
 
@@ -218,17 +237,38 @@ std::shared_ptr<ArchiveFileTree> ArchiveFileTree::makeTree(Archive const& archiv
 {
   auto const& data = archive.getFileList();
 
+  auto paths = std::make_shared<std::vector<QStringList>>();
+  paths->reserve(data.size());
+
   std::vector<ArchiveFileTreeImpl::File> files;
   files.reserve(data.size());
 
+  // The same directory names are repeated for many entries, so equal components
+  // share their data:
+  QSet<QString> names;
+
   for (size_t i = 0; i < data.size(); ++i) {
-    files.push_back(std::make_tuple(
-      QString::fromStdWString(data[i]->getArchiveFilePath()).replace("\\", "/").split("/", Qt::SkipEmptyParts), 
-      data[i]->isDirectory(), 
-      (int) i));
+    QStringList components =
+      QString::fromStdWString(data[i]->getArchiveFilePath()).replace("\\", "/").split("/", Qt::SkipEmptyParts);
+
+    for (auto& c : components) {
+      auto it = names.constFind(c);
+      if (it == names.cend()) {
+        names.insert(c);
+      }
+      else {
+        c = *it;
+      }
+    }
+
+    if (!components.isEmpty()) {
+      files.push_back({ (int) i, 0, data[i]->isDirectory() });
+    }
+
+    paths->push_back(std::move(components));
   }
 
-  auto tree = std::make_shared<ArchiveFileTreeImpl>(nullptr, "", -1, std::move(files));
+  auto tree = std::make_shared<ArchiveFileTreeImpl>(nullptr, "", -1, std::move(paths), std::move(files));
   return tree;
 }
 
@@ -0,0 +1,70 @@
+#include "backgroundfilewriter.h"
+#include <log.h>
+#include <safewritefile.h>
+
+using namespace MOBase;
+
+BackgroundFileWriter::BackgroundFileWriter()
+  : m_Tasks(MOShared::TaskPriority::Normal), m_Running(false)
+{
+}
+
+BackgroundFileWriter::~BackgroundFileWriter()
+{
+  flush();
+}
+
+void BackgroundFileWriter::write(const QString& path, QByteArray content)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    m_Pending[path] = std::move(content);
+
+    if (m_Running) {
+      // the running task will pick it up
+      return;
+    }
+
+    m_Running = true;
+  }
+
+  m_Tasks.run([this]{ drain(); });
+}
+
+void BackgroundFileWriter::flush()
+{
+  m_Tasks.wait();
+}
+
+void BackgroundFileWriter::drain()
+{
+  for (;;) {
+    std::map<QString, QByteArray> files;
+
+    {
+      std::scoped_lock lock(m_Mutex);
+
+      if (m_Pending.empty()) {
+        m_Running = false;
+        return;
+      }
+
+      files.swap(m_Pending);
+    }
+
+    for (auto&& [path, content] : files) {
+      try
+      {
+        SafeWriteFile file(path);
+        file->resize(0);
+        file->write(content);
+        file.commit();
+      }
+      catch(std::exception& e)
+      {
+        log::error("failed to write {}: {}", path, e.what());
+      }
+    }
+  }
+}
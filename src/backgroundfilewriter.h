@@ -0,0 +1,55 @@
+#ifndef MODORGANIZER_BACKGROUNDFILEWRITER_INCLUDED
+#define MODORGANIZER_BACKGROUNDFILEWRITER_INCLUDED
+
+#include "taskexecutor.h"
+#include <QByteArray>
+#include <QString>
+#include <map>
+#include <mutex>
+
+// writes files on the task executor, each file is replaced atomically with
+// SafeWriteFile
+//
+// the content is given already rendered, so it's a snapshot of whatever state
+// it came from; writes to the same file are done in order, and if a file is
+// written again while the previous content hasn't been written yet, only the
+// most recent content is written
+//
+// the destructor waits for all pending writes
+//
+class BackgroundFileWriter
+{
+public:
+  BackgroundFileWriter();
+  ~BackgroundFileWriter();
+
+  // noncopyable
+  BackgroundFileWriter(const BackgroundFileWriter&) = delete;
+  BackgroundFileWriter& operator=(const BackgroundFileWriter&) = delete;
+
+  // queues the given content to be written to the given file
+  //
+  void write(const QString& path, QByteArray content);
+
+  // blocks until everything that was queued has been written
+  //
+  void flush();
+
+private:
+  MOShared::TaskGroup m_Tasks;
+
+  std::mutex m_Mutex;
+
+  // content that hasn't been written yet, by path
+  std::map<QString, QByteArray> m_Pending;
+
+  // whether a task is currently writing m_Pending; there is only ever one so
+  // writes to the same file can't race
+  bool m_Running;
+
+  // writes pending files until there are none left
+  //
+  void drain();
+};
+
+#endif // MODORGANIZER_BACKGROUNDFILEWRITER_INCLUDED
@@ -17,264 +17,385 @@ You should have received a copy of the GNU General Public License
 along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+
 #include "bbcode.h"
-#include <log.h>
-#include <QRegExp>
+#include <QRegularExpression>
 #include <map>
+#include <vector>
 
 namespace BBCode {
 
-namespace log = MOBase::log;
+namespace {
 
-class BBCodeMap {
+// a tag that wraps its converted content
+//
+struct TagDef
+{
+  // html written before the content, %1 is replaced by the argument of the
+  // tag, if any
+  QString open;
 
-  typedef std::map<QString, std::pair<QRegExp, QString> > TagMap;
+  // html written after the content
+  QString close;
+};
+
+// tags that take an argument end with '='; tags that use their raw content,
+// like links and images, are handled in Converter::rawTag()
+//
+const std::map<QString, TagDef>& tagDefs()
+{
+  static const std::map<QString, TagDef> map = {
+    {"b",       {"<b>", "</b>"}},
+    {"i",       {"<i>", "</i>"}},
+    {"u",       {"<u>", "</u>"}},
+    {"s",       {"<s>", "</s>"}},
+    {"sub",     {"<sub>", "</sub>"}},
+    {"sup",     {"<sup>", "</sup>"}},
+    {"size=",   {"<font size=\"%1\">", "</font>"}},
+    {"color=",  {"<font style=\"color: %1;\">", "</font>"}},
+    {"font=",   {"<font style=\"font-family: %1;\">", "</font>"}},
+    {"center",  {"<div align=\"center\">", "</div>"}},
+    {"quote",   {"<figure class=\"quote\"><blockquote>", "</blockquote></figure>"}},
+    {"quote=",  {"<figure class=\"quote\"><blockquote>", "</blockquote></figure>"}},
+    {"code",    {"<code>", "</code>"}},
+    {"heading", {"<h2><strong>", "</strong></h2>"}},
+    {"url=",    {"<a href=\"%1\">", "</a>"}},
+    {"email=",  {"<a href=\"mailto:%1\">", "</a>"}},
+
+    {"spoiler", {
+      "<details><summary>Spoiler:  <div class=\"bbc_spoiler_show\">Show</div></summary><div class=\"spoiler_content\">",
+      "</div></details>"}},
+
+    // lists
+    {"list",    {"<ul>", "</ul>"}},
+    {"list=",   {"<ol>", "</ol>"}},
+    {"ul",      {"<ul>", "</ul>"}},
+    {"ol",      {"<ol>", "</ol>"}},
+    {"li",      {"<li>", "</li>"}},
+    {"*",       {"<li>", "</li>"}},
+
+    // tables
+    {"table",   {"<table>", "</table>"}},
+    {"tr",      {"<tr>", "</tr>"}},
+    {"th",      {"<th>", "</th>"}},
+    {"td",      {"<td>", "</td>"}},
+  };
+
+  return map;
+}
+
+const std::map<QString, QString>& colors()
+{
+  static const std::map<QString, QString> map = {
+    {"red",         "FF0000"},
+    {"green",       "00FF00"},
+    {"blue",        "0000FF"},
+    {"black",       "000000"},
+    {"gray",        "7F7F7F"},
+    {"white",       "FFFFFF"},
+    {"yellow",      "FFFF00"},
+    {"cyan",        "00FFFF"},
+    {"magenta",     "FF00FF"},
+    {"brown",       "A52A2A"},
+    {"orange",      "FFA500"},
+    {"gold",        "FFD700"},
+    {"deepskyblue", "00BFFF"},
+    {"salmon",      "FA8072"},
+    {"dodgerblue",  "1E90FF"},
+    {"greenyellow", "ADFF2F"},
+    {"peru",        "CD853F"},
+  };
+
+  return map;
+}
 
-public:
 
-  static BBCodeMap &instance() {
-    static BBCodeMap s_Instance;
-    return s_Instance;
+// goes over the input once, copying text as is and converting tags as they
+// come; open tags are kept on a stack so a closing tag also closes the tags
+// that were opened inside it, and tags that are never closed are closed at
+// the end
+//
+class Converter
+{
+public:
+  explicit Converter(const QString& input)
+    : m_input(input), m_pos(0)
+  {
   }
 
-  QString convertTag(QString input, int &length)
+  QString run()
   {
-    // extract the tag name
-    m_TagNameExp.indexIn(input, 1, QRegExp::CaretAtOffset);
-    QString tagName = m_TagNameExp.cap(0).toLower();
-    TagMap::iterator tagIter = m_TagMap.find(tagName);
-    if (tagIter != m_TagMap.end()) {
-      // recognized tag
-      if (tagName.endsWith('=')) {
-        tagName.chop(1);
+    m_out.reserve(m_input.size());
+
+    while (m_pos < m_input.size()) {
+      const int open = m_input.indexOf('[', m_pos);
+      if (open == -1) {
+        break;
       }
 
-      int closeTagPos = 0;
-      int closeTagLength = 0;
-      if (tagName == "*") {
-        // ends at the next bullet point
-        closeTagPos = input.indexOf(QRegExp("(\\[\\*\\]|</ul>)", Qt::CaseInsensitive), 3);
-        // leave closeTagLength at 0 because we don't want to "eat" the next bullet point
-      } else if (tagName == "line") {
-        // ends immediately after the tag
-        closeTagPos = 6;
-        // leave closeTagLength at 0 because there is no close tag to skip over
-      } else {
-        QString closeTag = QString("[/%1]").arg(tagName);
-        closeTagPos = input.indexOf(closeTag, 0, Qt::CaseInsensitive);
-        if (closeTagPos == -1) {
-          // workaround to improve compatibility: add fake closing tag
-          input.append(closeTag);
-          closeTagPos = input.size() - closeTag.size();
-        }
-        closeTagLength = closeTag.size();
+      m_out.append(m_input.midRef(m_pos, open - m_pos));
+      m_pos = open;
+
+      const int end = tagEnd(open);
+      if (end == -1) {
+        // not a tag
+        m_out.append('[');
+        m_pos = open + 1;
+        continue;
       }
 
-      if (closeTagPos > -1) {
-        length = closeTagPos + closeTagLength;
-        QString temp = input.mid(0, length);
-        if (tagIter->second.first.indexIn(temp) == 0) {
-          if (tagIter->second.second.isEmpty()) {
-            if (tagName == "color") {
-              QString color = tagIter->second.first.cap(1);
-              QString content = tagIter->second.first.cap(2);
-              if (color.at(0) == '#') {
-                return temp.replace(tagIter->second.first, QString("<font style=\"color: %1;\">%2</font>").arg(color, content));
-              } else {
-                auto colIter = m_ColorMap.find(color.toLower());
-                if (colIter != m_ColorMap.end()) {
-                  color = colIter->second;
-                }
-                return temp.replace(tagIter->second.first, QString("<font style=\"color: #%1;\">%2</font>").arg(color, content));
-              }
-            } else {
-              log::warn("don't know how to deal with tag {}", tagName);
-            }
-          } else {
-            if (tagName == "*") {
-              temp.remove(QRegExp("(\\[/\\*\\])?(<br/>)?$"));
-            }
-            return temp.replace(tagIter->second.first, tagIter->second.second);
-          }
-        } else {
-          // expression doesn't match. either the input string is invalid
-          // or the expression is
-          log::warn("{} doesn't match the expression for {}", temp, tagName);
-          length = 0;
-          return QString();
-        }
+      const QString text = m_input.mid(open + 1, end - open - 1);
+
+      if (text.startsWith('/')) {
+        // closing tags that weren't opened are dropped
+        closeTag(text.mid(1).trimmed().toLower());
+        m_pos = end + 1;
+      } else if (!openTag(text, end + 1)) {
+        // unknown tag, written as is
+        m_out.append('[');
+        m_pos = open + 1;
       }
     }
 
-    // not a recognized tag or tag invalid
-    length = 0;
-    return QString();
+    m_out.append(m_input.midRef(m_pos));
+    closeUntil(0);
+
+    return m_out;
   }
 
 private:
-  BBCodeMap()
-    : m_TagNameExp("^[a-zA-Z*]*=?")
+  struct Open
   {
-    m_TagMap["b"]      = std::make_pair(QRegExp("\\[b\\](.*)\\[/b\\]"),
-                                        "<b>\\1</b>");
-    m_TagMap["i"]      = std::make_pair(QRegExp("\\[i\\](.*)\\[/i\\]"),
-                                        "<i>\\1</i>");
-    m_TagMap["u"]      = std::make_pair(QRegExp("\\[u\\](.*)\\[/u\\]"),
-                                        "<u>\\1</u>");
-    m_TagMap["s"]      = std::make_pair(QRegExp("\\[s\\](.*)\\[/s\\]"),
-                                        "<s>\\1</s>");
-    m_TagMap["sub"]    = std::make_pair(QRegExp("\\[sub\\](.*)\\[/sub\\]"),
-                                        "<sub>\\1</sub>");
-    m_TagMap["sup"]    = std::make_pair(QRegExp("\\[sup\\](.*)\\[/sup\\]"),
-                                        "<sup>\\1</sup>");
-    m_TagMap["size="]  = std::make_pair(QRegExp("\\[size=([^\\]]*)\\](.*)\\[/size\\]"),
-                                        "<font size=\"\\1\">\\2</font>");
-    m_TagMap["color="] = std::make_pair(QRegExp("\\[color=([^\\]]*)\\](.*)\\[/color\\]"),
-                                        "");
-    m_TagMap["font="]  = std::make_pair(QRegExp("\\[font=([^\\]]*)\\](.*)\\[/font\\]"),
-                                        "<font style=\"font-family: \\1;\">\\2</font>");
-    m_TagMap["center"] = std::make_pair(QRegExp("\\[center\\](.*)\\[/center\\]"),
-                                        "<div align=\"center\">\\1</div>");
-    m_TagMap["quote"]  = std::make_pair(QRegExp("\\[quote\\](.*)\\[/quote\\]"),
-                                        "<figure class=\"quote\"><blockquote>\\1</blockquote></figure>");
-    m_TagMap["quote="] = std::make_pair(QRegExp("\\[quote=([^\\]]*)\\](.*)\\[/quote\\]"),
-                                        "<figure class=\"quote\"><blockquote>\\2</blockquote></figure>");
-    m_TagMap["spoiler"] = std::make_pair(QRegExp("\\[spoiler\\](.*)\\[/spoiler\\]"),
-      "<details><summary>Spoiler:  <div class=\"bbc_spoiler_show\">Show</div></summary><div class=\"spoiler_content\">\\1</div></details>");
-    m_TagMap["code"]   = std::make_pair(QRegExp("\\[code\\](.*)\\[/code\\]"),
-                                        "<code>\\1</code>");
-    m_TagMap["heading"]= std::make_pair(QRegExp("\\[heading\\](.*)\\[/heading\\]"),
-                                        "<h2><strong>\\1</strong></h2>");
-    m_TagMap["line"]   = std::make_pair(QRegExp("\\[line\\]"),
-                                        "<hr>");
+    QString name;
+    QString close;
+  };
 
-    // lists
-    m_TagMap["list"]  = std::make_pair(QRegExp("\\[list\\](.*)\\[/list\\]"),
-                                       "<ul>\\1</ul>");
-    m_TagMap["list="] = std::make_pair(QRegExp("\\[list.*\\](.*)\\[/list\\]"),
-                                       "<ol>\\1</ol>");
-    m_TagMap["ul"]    = std::make_pair(QRegExp("\\[ul\\](.*)\\[/ul\\]"),
-                                       "<ul>\\1</ul>");
-    m_TagMap["ol"]    = std::make_pair(QRegExp("\\[ol\\](.*)\\[/ol\\]"),
-                                       "<ol>\\1</ol>");
-    m_TagMap["li"]    = std::make_pair(QRegExp("\\[li\\](.*)\\[/li\\]"),
-                                       "<li>\\1</li>");
+  const QString& m_input;
+  QString m_out;
+  std::vector<Open> m_stack;
+  int m_pos;
 
-    // tables
-    m_TagMap["table"] = std::make_pair(QRegExp("\\[table\\](.*)\\[/table\\]"),
-                                       "<table>\\1</table>");
-    m_TagMap["tr"]    = std::make_pair(QRegExp("\\[tr\\](.*)\\[/tr\\]"),
-                                       "<tr>\\1</tr>");
-    m_TagMap["th"]    = std::make_pair(QRegExp("\\[th\\](.*)\\[/th\\]"),
-                                       "<th>\\1</th>");
-    m_TagMap["td"]    = std::make_pair(QRegExp("\\[td\\](.*)\\[/td\\]"),
-                                       "<td>\\1</td>");
-
-    // web content
-    m_TagMap["url"]     = std::make_pair(QRegExp("\\[url\\](.*)\\[/url\\]"),
-                                         "<a href=\"\\1\">\\1</a>");
-    m_TagMap["url="]    = std::make_pair(QRegExp("\\[url=([^\\]]*)\\](.*)\\[/url\\]"),
-                                         "<a href=\"\\1\">\\2</a>");
-    m_TagMap["img"] = std::make_pair(QRegExp("\\[img(?:\\s*width=\\d+\\s*,?\\s*height=\\d+)?\\](.*)\\[/img\\]"),
-                                     "<img src=\"\\1\">");
-    m_TagMap["img="] = std::make_pair(QRegExp("\\[img=([^\\]]*)\\](.*)\\[/img\\]"),
-                                      "<img src=\"\\2\" alt=\"\\1\">");
-    m_TagMap["email="]  = std::make_pair(QRegExp("\\[email=\"?([^\\]]*)\"?\\](.*)\\[/email\\]"),
-                                         "<a href=\"mailto:\\1\">\\2</a>");
-    m_TagMap["youtube"] = std::make_pair(QRegExp("\\[youtube\\](.*)\\[/youtube\\]"),
-                                         "<a href=\"https://www.youtube.com/watch?v=\\1\">https://www.youtube.com/watch?v=\\1</a>");
-
-
-    // make all patterns non-greedy and case-insensitive
-    for (TagMap::iterator iter = m_TagMap.begin(); iter != m_TagMap.end(); ++iter) {
-      iter->second.first.setCaseSensitivity(Qt::CaseInsensitive);
-      iter->second.first.setMinimal(true);
+  // position of the ']' closing the tag starting at `open`, or -1 if there's
+  // another '[' before it, which keeps the scan linear
+  //
+  int tagEnd(int open) const
+  {
+    for (int i=open + 1; i<m_input.size(); ++i) {
+      const QChar c = m_input[i];
+
+      if (c == ']') {
+        return i;
+      } else if (c == '[') {
+        break;
+      }
     }
 
-    // this tag is in fact greedy
-    m_TagMap["*"]     = std::make_pair(QRegExp("\\[\\*\\](.*)"),
-                                       "<li>\\1</li>");
-
-    m_ColorMap.insert(std::make_pair<QString, QString>("red", "FF0000"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("green", "00FF00"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("blue", "0000FF"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("black", "000000"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("gray", "7F7F7F"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("white", "FFFFFF"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("yellow", "FFFF00"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("cyan", "00FFFF"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("magenta", "FF00FF"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("brown", "A52A2A"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("orange", "FFA500"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("gold", "FFD700"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("deepskyblue", "00BFFF"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("salmon", "FA8072"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("dodgerblue", "1E90FF"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("greenyellow", "ADFF2F"));
-    m_ColorMap.insert(std::make_pair<QString, QString>("peru", "CD853F"));
+    return -1;
   }
 
-private:
+  // converts the tag with the given text, `after` is the position right after
+  // it; returns false if the tag is not recognized
+  //
+  bool openTag(const QString& text, int after)
+  {
+    // name, optional argument, and the size attributes of images
+    static const QRegularExpression exp(
+      "^([a-z*]+)(?:(=)(.*)|(\\s+width=\\d+\\s*,?\\s*height=\\d+))?$",
+      QRegularExpression::CaseInsensitiveOption |
+      QRegularExpression::DotMatchesEverythingOption);
+
+    const auto m = exp.match(text);
+    if (!m.hasMatch()) {
+      return false;
+    }
 
-  QRegExp m_TagNameExp;
-  TagMap m_TagMap;
-  std::map<QString, QString> m_ColorMap;
-};
+    const QString name = m.captured(1).toLower();
+    const bool hasArg = !m.captured(2).isEmpty();
+    const QString arg = m.captured(3);
 
+    if (!m.captured(4).isEmpty() && name != "img") {
+      return false;
+    }
 
-QString convertToHTML(const QString &inputParam)
-{
-  // this code goes over the input string once and replaces all bbtags
-  // it encounters. This function is called recursively for every replaced
-  // string to convert nested tags.
+    if (name == "line" && !hasArg) {
+      m_out.append("<hr>");
+      m_pos = after;
+      return true;
+    }
+
+    if (rawTag(name, hasArg, arg, after)) {
+      return true;
+    }
+
+    const auto& defs = tagDefs();
+    const auto itor = defs.find(hasArg ? name + "=" : name);
+
+    if (itor == defs.end()) {
+      return false;
+    }
+
+    if (name == "*") {
+      // ends the previous item of the same list
+      closeItem();
+    }
+
+    if (hasArg && itor->second.open.contains("%1")) {
+      m_out.append(itor->second.open.arg(argument(name, arg)));
+    } else {
+      m_out.append(itor->second.open);
+    }
+
+    m_stack.push_back({name, itor->second.close});
+    m_pos = after;
+
+    return true;
+  }
+
+  // tags that use their content as is, up to their closing tag; returns false
+  // if this is not one of them
   //
-  // This could be implemented simpler by applying a set of regular expressions
-  // for each recognized bb-tag one after the other but that would probably be
-  // very inefficient (O(n^2)).
+  bool rawTag(const QString& name, bool hasArg, const QString& arg, int after)
+  {
+    if (name == "img") {
+      const QString src = rawContent(name, after);
 
-  QString input = inputParam.mid(0).replace("\r\n", "<br/>");
-  input.replace("\\\"", "\"").replace("\\'", "'");
-  QString result;
-  int lastBlock = 0;
-  int pos = 0;
-
-  // iterate over the input buffer
-  while ((pos = input.indexOf('[', lastBlock)) != -1) {
-    // append everything between the previous tag-block and the current one
-    result.append(input.midRef(lastBlock, pos - lastBlock));
-
-    if ((pos < (input.size() - 1)) && (input.at(pos + 1) == '/')) {
-       // skip invalid end tag
-      int tagEnd = input.indexOf(']',  pos) + 1;
-      if (tagEnd == 0) {
-        //no closing tag found
-        //move the pos up one so that the opening bracket is ignored next iteration
-        pos++;
+      if (hasArg) {
+        m_out.append(QString("<img src=\"%1\" alt=\"%2\">").arg(src, arg));
+      } else {
+        m_out.append(QString("<img src=\"%1\">").arg(src));
+      }
+
+      return true;
+    }
+
+    if (hasArg) {
+      return false;
+    }
+
+    if (name == "url") {
+      const QString url = rawContent(name, after);
+
+      m_out.append(QString("<a href=\"%1\">%2</a>")
+        .arg(url, Converter(url).run()));
+
+      return true;
+    } else if (name == "youtube") {
+      const QString id = rawContent(name, after);
+
+      m_out.append(QString(
+        "<a href=\"https://www.youtube.com/watch?v=%1\">"
+        "https://www.youtube.com/watch?v=%1</a>").arg(id));
+
+      return true;
+    }
+
+    return false;
+  }
+
+  // content from `from` up to the closing tag for `name`, or up to the end
+  // of the input if there's none; moves past the closing tag
+  //
+  QString rawContent(const QString& name, int from)
+  {
+    const QString close = "[/" + name + "]";
+    const int i = m_input.indexOf(close, from, Qt::CaseInsensitive);
+
+    if (i == -1) {
+      m_pos = m_input.size();
+      return m_input.mid(from);
+    }
+
+    m_pos = i + close.size();
+    return m_input.mid(from, i - from);
+  }
+
+  QString argument(const QString& name, const QString& arg) const
+  {
+    if (name == "color") {
+      if (arg.startsWith('#')) {
+        return arg;
       }
-      else {
-        pos = tagEnd;
+
+      const auto itor = colors().find(arg.toLower());
+      if (itor != colors().end()) {
+        return "#" + itor->second;
       }
-    } else {
-      // convert the tag and content if necessary
-      int length = -1;
-      QString replacement = BBCodeMap::instance().convertTag(input.mid(pos), length);
-      if (length != 0) {
-        result.append(convertToHTML(replacement));
-        // length contains the number of characters in the original tag
-        pos += length;
-      } else {
-        // nothing replaced
-        result.append('[');
-        ++pos;
+
+      return "#" + arg;
+    } else if (name == "email") {
+      QString s = arg;
+
+      if (s.startsWith('"')) {
+        s.remove(0, 1);
       }
+
+      if (s.endsWith('"')) {
+        s.chop(1);
+      }
+
+      return s;
     }
-    lastBlock = pos;
+
+    return arg;
   }
 
-  // append the remainder (everything after the last tag)
-  result.append(input.midRef(lastBlock));
-  return result;
+  // closes the innermost open tag with the given name and everything that
+  // was opened inside it, does nothing if it's not open
+  //
+  void closeTag(const QString& name)
+  {
+    for (std::size_t i=m_stack.size(); i>0; --i) {
+      if (m_stack[i - 1].name == name) {
+        closeUntil(i - 1);
+        return;
+      }
+    }
+  }
+
+  // closes the current list item, if any
+  //
+  void closeItem()
+  {
+    for (std::size_t i=m_stack.size(); i>0; --i) {
+      const auto& name = m_stack[i - 1].name;
+
+      if (name == "*") {
+        closeUntil(i - 1);
+        return;
+      } else if (name == "list" || name == "ul" || name == "ol") {
+        return;
+      }
+    }
+  }
+
+  // closes open tags until `size` are left
+  //
+  void closeUntil(std::size_t size)
+  {
+    while (m_stack.size() > size) {
+      const Open& o = m_stack.back();
+
+      if (o.name == "*" && m_out.endsWith("<br/>")) {
+        // items are typically on their own line
+        m_out.chop(5);
+      }
+
+      m_out.append(o.close);
+      m_stack.pop_back();
+    }
+  }
+};
+
+} // namespace
+
+
+QString convertToHTML(const QString &inputParam)
+{
+  QString input = inputParam;
+  input.replace("\r\n", "<br/>");
+  input.replace("\\\"", "\"").replace("\\'", "'");
+
+  return Converter(input).run();
 }
 
 } // namespace BBCode
-
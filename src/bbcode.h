@@ -27,9 +27,10 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 namespace BBCode {
 
 /**
- * @brief convert a string with BB Code-Tags to HTML
+ * @brief convert a string with BB Code-Tags to HTML in a single pass;
+ *        unknown tags are kept as is and tags that are never closed are
+ *        closed at the end
  * @param input the input string with BB tags
- * @param replaceOccured if not nullptr, this parameter will be set to true if any bb tags were replaced
  * @return the same string in html representation
  **/
 QString convertToHTML(const QString &input);
@@ -0,0 +1,313 @@
+#include "browsercache.h"
+#include <log.h>
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QQueue>
+#include <QRegularExpression>
+#include <QWebEngineProfile>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+#include <QWebEngineUrlSchemeHandler>
+#include <functional>
+
+using namespace MOBase;
+
+// scheme of the rewritten images, the path is the encoded original url
+static const QByteArray SchemeName = "mo-cache";
+
+// how long images from the known image hosts are kept
+static constexpr qint64 LongTTL = 30 * 24 * 60 * 60;
+
+// images from other hosts are kept at least this long even if the server says
+// otherwise
+static constexpr qint64 ShortTTL = 24 * 60 * 60;
+
+// hosts that serve images that never change for a given url, including their
+// subdomains
+static const QStringList ImageHosts = {
+  "nexusmods.com", "imgur.com", "ibb.co", "postimg.cc", "staticflickr.com",
+  "googleusercontent.com", "discordapp.com", "discordapp.net"
+};
+
+static constexpr qint64 ResourcesCacheSize = 512 * 1024 * 1024;
+static constexpr int ProfileCacheSize = 256 * 1024 * 1024;
+
+// number of prefetched images loading at once
+static constexpr int MaxPrefetching = 4;
+
+
+namespace
+{
+
+class Handler : public QWebEngineUrlSchemeHandler
+{
+public:
+  using QWebEngineUrlSchemeHandler::QWebEngineUrlSchemeHandler;
+
+  void requestStarted(QWebEngineUrlRequestJob* job) override;
+};
+
+struct State
+{
+  QNetworkAccessManager* manager = nullptr;
+  QNetworkDiskCache* cache = nullptr;
+
+  QQueue<QUrl> prefetchQueue;
+  int prefetching = 0;
+};
+
+State g_state;
+
+
+QUrl originalUrl(const QUrl& url)
+{
+  return QUrl(QUrl::fromPercentEncoding(url.path(QUrl::FullyEncoded).toLatin1()));
+}
+
+QString cachedUrl(const QUrl& url)
+{
+  return QString::fromLatin1(
+    SchemeName + ":" + QUrl::toPercentEncoding(url.toString(QUrl::FullyEncoded)));
+}
+
+qint64 ttl(const QUrl& url)
+{
+  const QString host = url.host().toLower();
+
+  for (const auto& h : ImageHosts) {
+    if (host == h || host.endsWith("." + h)) {
+      return LongTTL;
+    }
+  }
+
+  return ShortTTL;
+}
+
+bool isCached(const QUrl& url)
+{
+  const auto md = g_state.cache->metaData(url);
+  return md.isValid() && md.expirationDate() > QDateTime::currentDateTimeUtc();
+}
+
+// calls f() with the reply once it's finished, the reply is deleted after
+//
+void get(const QUrl& url, std::function<void (QNetworkReply*)> f)
+{
+  QNetworkRequest request(url);
+
+  request.setAttribute(
+    QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+
+  request.setAttribute(
+    QNetworkRequest::RedirectPolicyAttribute,
+    QNetworkRequest::NoLessSafeRedirectPolicy);
+
+  auto* reply = g_state.manager->get(request);
+
+  QObject::connect(reply, &QNetworkReply::finished, [reply, url, f] {
+    reply->deleteLater();
+
+    const bool fromCache = reply->attribute(
+      QNetworkRequest::SourceIsFromCacheAttribute).toBool();
+
+    if (reply->error() == QNetworkReply::NoError && !fromCache) {
+      // servers often say images expire right away, they're kept anyway;
+      // the reply has the url after redirects, which is what was cached
+      auto md = g_state.cache->metaData(reply->url());
+
+      if (md.isValid()) {
+        const auto expires = QDateTime::currentDateTimeUtc().addSecs(ttl(url));
+
+        if (!md.expirationDate().isValid() || md.expirationDate() < expires) {
+          md.setExpirationDate(expires);
+          g_state.cache->updateMetaData(md);
+        }
+      }
+    }
+
+    f(reply);
+  });
+}
+
+void startPrefetches()
+{
+  while (g_state.prefetching < MaxPrefetching && !g_state.prefetchQueue.empty()) {
+    const QUrl url = g_state.prefetchQueue.dequeue();
+
+    if (isCached(url)) {
+      continue;
+    }
+
+    ++g_state.prefetching;
+
+    get(url, [url](QNetworkReply* reply) {
+      --g_state.prefetching;
+
+      if (reply->error() != QNetworkReply::NoError) {
+        log::debug("failed to prefetch '{}': {}", url.toString(), reply->errorString());
+      }
+
+      startPrefetches();
+    });
+  }
+}
+
+void Handler::requestStarted(QWebEngineUrlRequestJob* job)
+{
+  const QUrl url = originalUrl(job->requestUrl());
+
+  if (!url.isValid() || !g_state.manager) {
+    job->fail(QWebEngineUrlRequestJob::UrlInvalid);
+    return;
+  }
+
+  // the job is deleted if the page goes away before the image is loaded
+  QPointer<QWebEngineUrlRequestJob> p(job);
+
+  get(url, [p](QNetworkReply* reply) {
+    if (!p) {
+      return;
+    }
+
+    if (reply->error() != QNetworkReply::NoError) {
+      p->fail(QWebEngineUrlRequestJob::RequestFailed);
+      return;
+    }
+
+    QByteArray type = reply->header(QNetworkRequest::ContentTypeHeader)
+      .toByteArray().split(';').front().trimmed();
+
+    if (type.isEmpty()) {
+      type = "application/octet-stream";
+    }
+
+    // owned by the job
+    auto* buffer = new QBuffer(p);
+    buffer->setData(reply->readAll());
+    buffer->open(QIODevice::ReadOnly);
+
+    p->reply(type, buffer);
+  });
+}
+
+// calls f() with every http image in the given html, f() returns the new src
+// or an empty string to leave it as it is
+//
+template <class F>
+QString forEachImage(const QString& html, F&& f)
+{
+  static const QRegularExpression re(
+    R"((<img\b[^>]*?\bsrc\s*=\s*["'])(https?://[^"']+))",
+    QRegularExpression::CaseInsensitiveOption);
+
+  QString out;
+  int last = 0;
+
+  auto itor = re.globalMatch(html);
+
+  while (itor.hasNext()) {
+    const auto m = itor.next();
+
+    // the description is html, the url is escaped
+    QString src = m.captured(2);
+    src.replace("&amp;", "&");
+
+    const QString replacement = f(QUrl(src));
+    if (replacement.isEmpty()) {
+      continue;
+    }
+
+    out += html.midRef(last, m.capturedEnd(1) - last);
+    out += replacement;
+    last = m.capturedEnd(2);
+  }
+
+  out += html.midRef(last);
+
+  return out;
+}
+
+} // namespace
+
+
+void BrowserCache::registerScheme()
+{
+  QWebEngineUrlScheme scheme(SchemeName);
+
+  scheme.setSyntax(QWebEngineUrlScheme::Syntax::Path);
+  scheme.setFlags(
+    QWebEngineUrlScheme::SecureScheme |
+    QWebEngineUrlScheme::ContentSecurityPolicyIgnored);
+
+  QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+void BrowserCache::setDirectory(const QString& directory)
+{
+  const QString path = QDir(directory).filePath("browser");
+  auto* profile = QWebEngineProfile::defaultProfile();
+
+  if (!g_state.manager) {
+    g_state.manager = new QNetworkAccessManager(qApp);
+    g_state.cache = new QNetworkDiskCache(g_state.manager);
+    g_state.cache->setMaximumCacheSize(ResourcesCacheSize);
+    g_state.cache->setCacheDirectory(QDir(path).filePath("resources"));
+    g_state.manager->setCache(g_state.cache);
+
+    profile->setHttpCacheType(QWebEngineProfile::DiskHttpCache);
+    profile->setHttpCacheMaximumSize(ProfileCacheSize);
+    profile->installUrlSchemeHandler(SchemeName, new Handler(profile));
+  }
+
+  g_state.cache->setCacheDirectory(QDir(path).filePath("resources"));
+  profile->setCachePath(QDir(path).filePath("profile"));
+}
+
+void BrowserCache::clear()
+{
+  if (g_state.cache) {
+    g_state.cache->clear();
+  }
+
+  QWebEngineProfile::defaultProfile()->clearHttpCache();
+}
+
+QString BrowserCache::rewriteImages(const QString& html)
+{
+  if (!g_state.manager) {
+    return html;
+  }
+
+  return forEachImage(html, [](const QUrl& url) -> QString {
+    if (!url.isValid()) {
+      return {};
+    }
+
+    return cachedUrl(url);
+  });
+}
+
+void BrowserCache::prefetch(const QString& html)
+{
+  if (!g_state.manager) {
+    return;
+  }
+
+  g_state.prefetchQueue.clear();
+
+  forEachImage(html, [](const QUrl& url) -> QString {
+    if (url.isValid()) {
+      g_state.prefetchQueue.enqueue(url);
+    }
+
+    return {};
+  });
+
+  startPrefetches();
+}
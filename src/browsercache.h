@@ -0,0 +1,54 @@
+#ifndef MODORGANIZER_BROWSERCACHE_INCLUDED
+#define MODORGANIZER_BROWSERCACHE_INCLUDED
+
+#include <QString>
+#include <QUrl>
+
+// on-disk cache for the images of the nexus descriptions shown in the
+// embedded browser
+//
+// the web engine's own http cache only keeps images for as long as the
+// servers allow, which is often not at all, so images were downloaded again
+// every time a mod was shown; the images of a description are instead
+// rewritten by rewriteImages() to a custom scheme that the web engine asks
+// BrowserCache for, which serves them from a QNetworkDiskCache and keeps
+// images from the known image hosts for a long time
+//
+// prefetch() loads the images of descriptions that will probably be shown
+// soon, such as the mods next to the one shown in the mod info dialog, so
+// they're in the cache by the time the user gets to them
+//
+// the shared web engine profile also gets a larger disk cache in the same
+// directory, which is used by everything else the embedded browser loads
+//
+// everything must be called on the ui thread
+//
+class BrowserCache
+{
+public:
+  // registers the scheme with the web engine, must be called before the
+  // application object is created
+  //
+  static void registerScheme();
+
+  // sets the directory of the cache, sets up the web engine profile on the
+  // first call
+  //
+  static void setDirectory(const QString& directory);
+
+  // forgets everything in the cache
+  //
+  static void clear();
+
+  // returns the given html with the http images going through the cache
+  //
+  static QString rewriteImages(const QString& html);
+
+  // loads the http images of the given html that aren't cached yet in the
+  // background, the html is the one given to rewriteImages(); replaces the
+  // images given by the previous call that haven't started loading yet
+  //
+  static void prefetch(const QString& html);
+};
+
+#endif // MODORGANIZER_BROWSERCACHE_INCLUDED
@@ -43,6 +43,7 @@ QString CategoryFactory::categoriesFilePath()
 
 
 CategoryFactory::CategoryFactory()
+  : m_Revision(0)
 {
   atexit(&cleanup);
 }
@@ -107,6 +108,7 @@ CategoryFactory &CategoryFactory::instance()
 
 void CategoryFactory::reset()
 {
+  ++m_Revision;
   m_Categories.clear();
   m_IDMap.clear();
   // 28 =
@@ -119,6 +121,8 @@ void CategoryFactory::reset()
 
 void CategoryFactory::setParents()
 {
+  ++m_Revision;
+
   for (std::vector<Category>::iterator iter = m_Categories.begin();
        iter != m_Categories.end(); ++iter) {
     iter->m_HasChildren = false;
@@ -193,6 +197,8 @@ int CategoryFactory::addCategory(const QString &name, const std::vector<int> &ne
 
 void CategoryFactory::addCategory(int id, const QString &name, const std::vector<int> &nexusIDs, int parentID)
 {
+  ++m_Revision;
+
   int index = static_cast<int>(m_Categories.size());
   m_Categories.push_back(Category(index, id, name, nexusIDs, parentID));
   for (int nexusID : nexusIDs) {
@@ -289,6 +295,37 @@ bool CategoryFactory::isDescendantOf(int id, int parentID) const
   return isDescendantOfImpl(id, parentID, seen);
 }
 
+std::vector<int> CategoryFactory::withParents(const std::set<int>& ids) const
+{
+  std::vector<int> v;
+
+  for (int id : ids) {
+    std::set<int> seen;
+    int current = id;
+
+    while (current != 0) {
+      if (!seen.insert(current).second) {
+        log::warn("cycle in categories: {}", SetJoin(seen, ", "));
+        break;
+      }
+
+      v.push_back(current);
+
+      auto iter = m_IDMap.find(current);
+      if (iter == m_IDMap.end()) {
+        break;
+      }
+
+      current = m_Categories[iter->second].m_ParentID;
+    }
+  }
+
+  std::sort(v.begin(), v.end());
+  v.erase(std::unique(v.begin(), v.end()), v.end());
+
+  return v;
+}
+
 bool CategoryFactory::isDescendantOfImpl(
   int id, int parentID, std::set<int>& seen) const
 {
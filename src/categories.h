@@ -126,6 +126,21 @@ public:
    **/
   bool isDescendantOf(int id, int parentID) const;
 
+  /**
+   * @brief the given categories along with all of their parents
+   * @param ids the categories, typically the ones of a mod
+   * @return sorted ids without duplicates; a mod that has one of the given
+   *         categories matches the filter of any of these
+   * @note cycles are logged and ignored
+   **/
+  std::vector<int> withParents(const std::set<int>& ids) const;
+
+  /**
+   * @brief incremented every time the list of categories or their parents
+   *        change, so results of withParents() can be kept until then
+   **/
+  int revision() const { return m_Revision; }
+
   /**
    * @brief test if the specified category has child categories
    *
@@ -207,6 +222,7 @@ private:
   std::vector<Category> m_Categories;
   std::map<int, unsigned int> m_IDMap;
   std::map<int, unsigned int> m_NexusMap;
+  int m_Revision;
 
 private:
   // called by isDescendantOf()
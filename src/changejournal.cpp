@@ -0,0 +1,278 @@
+#include "changejournal.h"
+#include "shared/util.h"
+#include <log.h>
+#include <utility.h>
+#include <Windows.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace MOBase;
+
+struct ChangeJournal::Watch
+{
+  std::wstring root;
+  bool perChild = false;
+
+  HANDLE dir = INVALID_HANDLE_VALUE;
+  HANDLE stop = nullptr;
+  std::thread thread;
+
+  std::mutex mutex;
+  std::set<std::wstring> paths;
+
+  Listener listener;
+
+  // set when changes may have been missed
+  std::atomic<bool> lost = false;
+
+  ~Watch()
+  {
+    if (thread.joinable()) {
+      ::SetEvent(stop);
+      thread.join();
+    }
+
+    if (stop) {
+      ::CloseHandle(stop);
+    }
+
+    if (dir != INVALID_HANDLE_VALUE) {
+      ::CloseHandle(dir);
+    }
+  }
+
+  void record(std::wstring_view name)
+  {
+    std::wstring path = root;
+
+    if (perChild) {
+      path += L"\\";
+      path += MOShared::ToLowerCopy(name.substr(0, name.find(L'\\')));
+    }
+
+    std::scoped_lock lock(mutex);
+    paths.insert(std::move(path));
+  }
+
+  void run()
+  {
+    const DWORD filter =
+      FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+      FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE |
+      FILE_NOTIFY_CHANGE_CREATION;
+
+    // must be dword-aligned
+    std::vector<DWORD> buffer(16 * 1024);
+    const auto bufferSize = static_cast<DWORD>(buffer.size() * sizeof(DWORD));
+
+    OVERLAPPED ov = {};
+    ov.hEvent = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    if (!ov.hEvent) {
+      lost = true;
+      return;
+    }
+
+    for (;;) {
+      ::ResetEvent(ov.hEvent);
+
+      if (!::ReadDirectoryChangesW(
+        dir, buffer.data(), bufferSize, TRUE, filter, nullptr, &ov, nullptr)) {
+        const auto e = ::GetLastError();
+        log::warn("failed to watch {}, {}", root, formatSystemMessage(e));
+        lost = true;
+        break;
+      }
+
+      // when both are signalled, the lowest index is returned, so changes
+      // that were already reported are handled before stopping
+      HANDLE handles[] = {ov.hEvent, stop};
+      const auto r = ::WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+
+      if (r != WAIT_OBJECT_0) {
+        DWORD bytes = 0;
+        ::CancelIoEx(dir, &ov);
+        ::GetOverlappedResult(dir, &ov, &bytes, TRUE);
+        break;
+      }
+
+      DWORD bytes = 0;
+      if (!::GetOverlappedResult(dir, &ov, &bytes, FALSE)) {
+        lost = true;
+        break;
+      }
+
+      if (bytes == 0) {
+        // the system buffer overflowed, there's no way to know what changed
+        log::debug("too many changes in {}, changes were lost", root);
+        lost = true;
+
+        if (!listener) {
+          break;
+        }
+
+        listener(root, {});
+        continue;
+      }
+
+      auto* p = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer.data());
+      std::vector<std::wstring> names;
+
+      for (;;) {
+        const std::wstring_view name(
+          p->FileName, p->FileNameLength / sizeof(wchar_t));
+
+        record(name);
+
+        if (listener) {
+          names.push_back(MOShared::ToLowerCopy(name));
+        }
+
+        if (p->NextEntryOffset == 0) {
+          break;
+        }
+
+        p = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(
+          reinterpret_cast<const char*>(p) + p->NextEntryOffset);
+      }
+
+      if (listener && !names.empty()) {
+        listener(root, std::move(names));
+      }
+    }
+
+    ::CloseHandle(ov.hEvent);
+  }
+
+  // changes inside reparse points are reported for their target, not here
+  void recordReparsePoints()
+  {
+    WIN32_FIND_DATAW fd = {};
+
+    HANDLE h = ::FindFirstFileExW(
+      (root + L"\\*").c_str(), FindExInfoBasic, &fd,
+      FindExSearchLimitToDirectories, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+
+    if (h == INVALID_HANDLE_VALUE) {
+      return;
+    }
+
+    do
+    {
+      if (fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+        record(fd.cFileName);
+      }
+    }
+    while (::FindNextFileW(h, &fd));
+
+    ::FindClose(h);
+  }
+};
+
+
+bool ChangeJournal::Changes::covers(const std::wstring& path) const
+{
+  for (const auto& r : roots) {
+    if (path == r || path.rfind(r + L"\\", 0) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ChangeJournal::Changes::changed(const std::wstring& path) const
+{
+  for (const auto& p : paths) {
+    if (path == p || path.rfind(p + L"\\", 0) == 0 || p.rfind(path + L"\\", 0) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+ChangeJournal::~ChangeJournal()
+{
+  stop();
+}
+
+void ChangeJournal::watch(const std::wstring& dir, bool perChild)
+{
+  auto w = std::make_unique<Watch>();
+
+  w->root = MOShared::ToLowerCopy(dir);
+  while (!w->root.empty() && (w->root.back() == L'\\' || w->root.back() == L'/')) {
+    w->root.pop_back();
+  }
+
+  w->perChild = perChild;
+  w->listener = m_listener;
+
+  w->dir = ::CreateFileW(
+    dir.c_str(), FILE_LIST_DIRECTORY,
+    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+    OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+
+  w->stop = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+  if (w->dir == INVALID_HANDLE_VALUE || !w->stop) {
+    const auto e = ::GetLastError();
+    log::debug("can't watch {} for changes, {}", dir, formatSystemMessage(e));
+    w->lost = true;
+  } else {
+    if (perChild) {
+      w->recordReparsePoints();
+    }
+
+    w->thread = std::thread([p=w.get()] {
+      MOShared::SetThisThreadName("ChangeJournal");
+      p->run();
+    });
+  }
+
+  m_watches.push_back(std::move(w));
+}
+
+void ChangeJournal::setListener(Listener f)
+{
+  m_listener = std::move(f);
+}
+
+bool ChangeJournal::running() const
+{
+  return !m_watches.empty();
+}
+
+std::optional<ChangeJournal::Changes> ChangeJournal::stop()
+{
+  if (m_watches.empty()) {
+    return {};
+  }
+
+  Changes c;
+  bool lost = false;
+
+  for (auto& w : m_watches) {
+    // stops the thread
+    if (w->thread.joinable()) {
+      ::SetEvent(w->stop);
+      w->thread.join();
+    }
+
+    lost |= w->lost;
+
+    c.roots.push_back(w->root);
+    c.paths.insert(w->paths.begin(), w->paths.end());
+  }
+
+  m_watches.clear();
+
+  if (lost) {
+    return {};
+  }
+
+  return c;
+}
@@ -0,0 +1,83 @@
+#ifndef MODORGANIZER_CHANGEJOURNAL_INCLUDED
+#define MODORGANIZER_CHANGEJOURNAL_INCLUDED
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+// records which directories had something change inside them while it's
+// running, used to know which origins have to be walked again on the next
+// refresh, such as after a program exits, see
+// DirectoryRefresher::refreshIncremental()
+//
+// each watched directory is watched recursively on its own thread with
+// ReadDirectoryChangesW(); all paths are native and lowercase
+//
+class ChangeJournal
+{
+public:
+  struct Changes
+  {
+    // the watched directories, a path outside of these is unknown
+    std::vector<std::wstring> roots;
+
+    // paths that had something change inside them
+    std::set<std::wstring> paths;
+
+    // whether the given path is in one of the roots; paths that are not can't
+    // be answered by changed()
+    //
+    bool covers(const std::wstring& path) const;
+
+    // whether something changed inside the given path, which must be covered
+    //
+    bool changed(const std::wstring& path) const;
+  };
+
+  // called on the thread of a watched directory for each batch of changes
+  // reported by the system, with the root as given in Changes::roots and the
+  // lowercase paths relative to it; an empty list means changes were lost
+  //
+  using Listener = std::function<
+    void (const std::wstring& root, std::vector<std::wstring> paths)>;
+
+  ChangeJournal() = default;
+  ~ChangeJournal();
+
+  // noncopyable
+  ChangeJournal(const ChangeJournal&) = delete;
+  ChangeJournal& operator=(const ChangeJournal&) = delete;
+
+  // starts watching the given directory; when `perChild` is true, a change
+  // is recorded as the direct child of the directory it happened in, such as
+  // a mod in the mods directory, otherwise as the directory itself
+  //
+  // children that are reparse points are always recorded as changed because
+  // changes inside their targets aren't reported
+  //
+  void watch(const std::wstring& dir, bool perChild);
+
+  // the listener for the directories watched after this; directories keep
+  // being watched after losing changes when there's a listener
+  //
+  void setListener(Listener f);
+
+  // whether any directory is watched
+  //
+  bool running() const;
+
+  // stops watching and returns what changed, empty if changes were lost,
+  // such as when a buffer overflowed or a directory couldn't be watched
+  //
+  std::optional<Changes> stop();
+
+private:
+  struct Watch;
+  std::vector<std::unique_ptr<Watch>> m_watches;
+  Listener m_listener;
+};
+
+#endif // MODORGANIZER_CHANGEJOURNAL_INCLUDED
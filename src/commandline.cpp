@@ -6,8 +6,14 @@
 #include "loglist.h"
 #include "shared/util.h"
 #include "shared/appconfig.h"
+#include "shared/structurebenchmark.h"
+#include "refreshrecording.h"
+#include "loot.h"
+#include "profile.h"
 #include <log.h>
 #include <report.h>
+#include <QFileInfo>
+#include <thread>
 
 namespace cl
 {
@@ -62,6 +68,10 @@ CommandLine::CommandLine()
     ReloadPluginCommand,
     RefreshCommand,
     CrashDumpCommand,
+    DeployCommand,
+    BenchmarkStructureCommand,
+    RecordRefreshCommand,
+    ReplayRefreshCommand,
     LaunchCommand>();
 }
 
@@ -230,6 +240,26 @@ bool CommandLine::forwardToPrimary(MOMultiProcess& multiProcess)
   return true;
 }
 
+std::optional<QString> CommandLine::earlyForward() const
+{
+  if (m_command || multiple()) {
+    return {};
+  }
+
+  // -i with no arguments is handled in runPostApplication()
+  if (m_vm.count("instance") && m_vm["instance"].as<std::string>() == "") {
+    return {};
+  }
+
+  if (m_shortcut.isValid()) {
+    return m_shortcut.toString();
+  } else if (m_nxmLink) {
+    return *m_nxmLink;
+  }
+
+  return {};
+}
+
 std::optional<int> CommandLine::runEarly()
 {
   if (m_vm.count("logs")) {
@@ -350,6 +380,10 @@ void CommandLine::createOptions()
     ("logs",
       "duplicates the logs to stdout")
 
+    ("startup-profile",
+      "times the startup, writes it to startup_trace.json in the logs "
+      "folder and exits after the first refresh")
+
     ("instance,i",
       po::value<std::string>()->implicit_value(""),
       "use the given instance (defaults to last used)")
@@ -434,9 +468,18 @@ bool CommandLine::pick() const
 
 bool CommandLine::multiple() const
 {
+  if (m_command && m_command->allowMultiple()) {
+    return true;
+  }
+
   return (m_vm.count("multiple") > 0);
 }
 
+bool CommandLine::startupProfile() const
+{
+  return (m_vm.count("startup-profile") > 0);
+}
+
 std::optional<QString> CommandLine::profile() const
 {
   if (m_vm.count("profile")) {
@@ -611,6 +654,11 @@ bool Command::canForwardToPrimary() const
   return false;
 }
 
+bool Command::allowMultiple() const
+{
+  return false;
+}
+
 const std::wstring& Command::originalCmd() const
 {
   return m_original;
@@ -929,4 +977,321 @@ std::optional<int> RefreshCommand::runPostOrganizer(OrganizerCore& core)
   return {};
 }
 
+
+Command::Meta DeployCommand::meta() const
+{
+  return {
+    "deploy",
+    "prepares the instance without showing the ui",
+    "[options]",
+    "Archives are installed in the order of the list, then the instance is "
+    "refreshed and the plugin list is saved."
+  };
+}
+
+bool DeployCommand::allowMultiple() const
+{
+  return true;
+}
+
+po::options_description DeployCommand::getVisibleOptions() const
+{
+  po::options_description d;
+
+  d.add_options()
+    ("install", po::value<std::string>(), "file with the archives to install, one per line")
+    ("sort", "sorts the plugins with loot")
+    ("mapping", po::value<std::string>(), "writes the file mappings to this file");
+
+  return d;
+}
+
+std::optional<int> DeployCommand::runPostOrganizer(OrganizerCore& core)
+{
+  int failures = 0;
+
+  if (vm().count("install")) {
+    failures += install(
+      core, QString::fromStdString(vm()["install"].as<std::string>()));
+  }
+
+  // the refresh runs on all the threads of the task executor, this only waits
+  // for it
+  core.refresh();
+  core.waitForRefresh();
+
+  if (vm().count("sort")) {
+    if (runLootHeadless(core, false)) {
+      core.refreshESPList(false);
+    } else {
+      log::error("sorting the plugins failed");
+      ++failures;
+    }
+  }
+
+  core.savePluginList();
+  core.currentProfile()->writeModlistNow(true);
+
+  if (vm().count("mapping")) {
+    const auto path = QString::fromStdString(vm()["mapping"].as<std::string>());
+
+    if (!writeMapping(core, path)) {
+      ++failures;
+    }
+  }
+
+  log::info("deploy done, {} failure(s)", failures);
+
+  return (failures == 0 ? 0 : 1);
+}
+
+int DeployCommand::install(OrganizerCore& core, const QString& listFile)
+{
+  QFile f(listFile);
+  if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    log::error(
+      "can't open install list {}, {}",
+      QDir::toNativeSeparators(listFile), f.errorString());
+
+    return 1;
+  }
+
+  int failures = 0;
+
+  while (!f.atEnd()) {
+    const QString line = QString::fromUtf8(f.readLine()).trimmed();
+    if (line.isEmpty() || line.startsWith("#")) {
+      continue;
+    }
+
+    const QString archive = QFileInfo(line).absoluteFilePath();
+    log::info("installing {}", QDir::toNativeSeparators(archive));
+
+    auto mod = core.installArchive(archive);
+    if (!mod) {
+      log::error("failed to install {}", QDir::toNativeSeparators(archive));
+      ++failures;
+      continue;
+    }
+
+    const auto index = ModInfo::getIndex(mod->name());
+    if (index != UINT_MAX) {
+      core.currentProfile()->setModEnabled(index, true);
+    }
+  }
+
+  return failures;
+}
+
+bool DeployCommand::writeMapping(OrganizerCore& core, const QString& path)
+{
+  std::vector<Mapping> mappings;
+
+  try
+  {
+    mappings = core.fileMapping(core.profileName(), QString());
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to create the file mappings, {}", e.what());
+    return false;
+  }
+
+  QByteArray data;
+
+  for (const auto& m : mappings) {
+    data += QString("%1\t%2\t%3\t%4\n")
+      .arg(m.source)
+      .arg(m.destination)
+      .arg(m.isDirectory ? "dir" : "file")
+      .arg(m.createTarget ? "create" : "")
+      .toUtf8();
+  }
+
+  QFile f(path);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || f.write(data) != data.size()) {
+    log::error(
+      "failed to write the file mappings to {}, {}",
+      QDir::toNativeSeparators(path), f.errorString());
+
+    return false;
+  }
+
+  log::info(
+    "wrote {} file mappings to {}",
+    mappings.size(), QDir::toNativeSeparators(path));
+
+  return true;
+}
+
+
+Command::Meta BenchmarkStructureCommand::meta() const
+{
+  return {
+    "benchmark-structure",
+    "times the directory structure on synthetic mods",
+    "[options]",
+    "Prints one csv row per phase and run, followed by the median of each "
+    "phase."
+  };
+}
+
+po::options_description BenchmarkStructureCommand::getVisibleOptions() const
+{
+  const MOShared::StructureBenchmark::Options defaults;
+
+  po::options_description d;
+
+  d.add_options()
+    ("mods", po::value<int>()->default_value(defaults.mods), "number of mods")
+    ("files", po::value<int>()->default_value(defaults.files), "loose files per mod")
+    ("depth", po::value<int>()->default_value(defaults.depth), "directories above each file")
+    ("overlap", po::value<int>()->default_value(defaults.overlap), "percentage of files shared by all mods")
+    ("archives", po::value<int>()->default_value(defaults.archives), "number of mods with an archive")
+    ("runs", po::value<int>()->default_value(defaults.runs), "runs for each source");
+
+  return d;
+}
+
+std::optional<int> BenchmarkStructureCommand::runPostApplication(MOApplication&)
+{
+  env::Console console;
+
+  MOShared::StructureBenchmark::Options o;
+  o.mods = std::max(vm()["mods"].as<int>(), 1);
+  o.files = std::max(vm()["files"].as<int>(), 1);
+  o.depth = std::max(vm()["depth"].as<int>(), 0);
+  o.overlap = std::clamp(vm()["overlap"].as<int>(), 0, 100);
+  o.archives = std::max(vm()["archives"].as<int>(), 0);
+  o.runs = std::max(vm()["runs"].as<int>(), 1);
+
+  MOShared::StructureBenchmark b(o);
+
+  std::cout << MOShared::StructureBenchmark::csvHeader() << "\n";
+
+  for (const auto& r : b.run()) {
+    std::cout << b.toCsv(r) << "\n";
+  }
+
+  std::cout.flush();
+
+  return 0;
+}
+
+
+Command::Meta RecordRefreshCommand::meta() const
+{
+  return {
+    "record-refresh",
+    "records the mods of the current profile for replay-refresh",
+    "FILE",
+    "Only the directory trees, file sizes and times, and the contents of "
+    "enabled archives are recorded, not the files themselves."
+  };
+}
+
+po::options_description RecordRefreshCommand::getInternalOptions() const
+{
+  po::options_description d;
+
+  d.add_options()
+    ("FILE", po::value<std::string>()->required(), "recording file");
+
+  return d;
+}
+
+po::positional_options_description RecordRefreshCommand::getPositional() const
+{
+  po::positional_options_description d;
+
+  d.add("FILE", 1);
+
+  return d;
+}
+
+std::optional<int> RecordRefreshCommand::runPostOrganizer(OrganizerCore& core)
+{
+  const QString path = QString::fromStdString(vm()["FILE"].as<std::string>());
+
+  if (!RefreshRecording::record(core, QFileInfo(path).absoluteFilePath())) {
+    reportError(QObject::tr(
+      "Failed to record the refresh to '%1', see the log for details.")
+        .arg(QDir::toNativeSeparators(path)));
+
+    return 1;
+  }
+
+  return 0;
+}
+
+
+Command::Meta ReplayRefreshCommand::meta() const
+{
+  return {
+    "replay-refresh",
+    "times the directory structure from a file written by record-refresh",
+    "[options] FILE",
+    "Prints one csv row per phase and run."
+  };
+}
+
+po::options_description ReplayRefreshCommand::getVisibleOptions() const
+{
+  const int threads = static_cast<int>(
+    std::max(std::thread::hardware_concurrency(), 1u));
+
+  po::options_description d;
+
+  d.add_options()
+    ("threads", po::value<int>()->default_value(threads), "threads adding the mods")
+    ("runs", po::value<int>()->default_value(5), "number of runs");
+
+  return d;
+}
+
+po::options_description ReplayRefreshCommand::getInternalOptions() const
+{
+  po::options_description d;
+
+  d.add_options()
+    ("FILE", po::value<std::string>()->required(), "recording file");
+
+  return d;
+}
+
+po::positional_options_description ReplayRefreshCommand::getPositional() const
+{
+  po::positional_options_description d;
+
+  d.add("FILE", 1);
+
+  return d;
+}
+
+std::optional<int> ReplayRefreshCommand::runPostApplication(MOApplication&)
+{
+  env::Console console;
+
+  const QString path = QString::fromStdString(vm()["FILE"].as<std::string>());
+
+  const auto r = RefreshRecording::read(path);
+  if (!r) {
+    std::cerr << "failed to read " << path.toStdString() << ", see the log\n";
+    return 1;
+  }
+
+  const int threads = std::max(vm()["threads"].as<int>(), 1);
+  const int runs = std::max(vm()["runs"].as<int>(), 1);
+
+  std::cout << RefreshRecording::csvHeader().toStdString() << "\n";
+
+  for (const auto& result : r->replay(threads, runs)) {
+    std::cout << r->toCsv(result, threads).toStdString() << "\n";
+  }
+
+  std::cout.flush();
+
+  return 0;
+}
+
 } // namespace
@@ -98,6 +98,11 @@ public:
   //
   virtual bool canForwardToPrimary() const;
 
+  // whether this command can run while other MO processes are running, as if
+  // --multiple had been given
+  //
+  virtual bool allowMultiple() const;
+
 protected:
   // meta information about this command, returned by derived classes
   //
@@ -230,6 +235,77 @@ protected:
 
 
 
+// builds directory structures from synthetic mod layouts and prints the time
+// taken by each phase as csv, see MOShared::StructureBenchmark
+//
+class BenchmarkStructureCommand : public Command
+{
+protected:
+  Meta meta() const override;
+  po::options_description getVisibleOptions() const override;
+  std::optional<int> runPostApplication(MOApplication& a) override;
+};
+
+
+// prepares an instance without showing the ui: installs the archives in the
+// given list and enables them, refreshes, optionally sorts the plugins with
+// loot, saves the plugin list and can write the virtual file system mappings
+// to a file
+//
+// this runs before the main window is created and exits once it's done; it
+// can run while other MO processes are running, such as for other instances
+//
+class DeployCommand : public Command
+{
+public:
+  bool allowMultiple() const override;
+
+protected:
+  Meta meta() const override;
+
+  po::options_description getVisibleOptions() const override;
+  std::optional<int> runPostOrganizer(OrganizerCore& core) override;
+
+  // installs the archives listed in the given file, one per line; returns
+  // the number of archives that failed
+  //
+  int install(OrganizerCore& core, const QString& listFile);
+
+  bool writeMapping(OrganizerCore& core, const QString& path);
+};
+
+
+// records what a refresh of the current profile reads from the disk to the
+// given file, see RefreshRecording
+//
+class RecordRefreshCommand : public Command
+{
+protected:
+  Meta meta() const override;
+
+  po::options_description getInternalOptions() const override;
+  po::positional_options_description getPositional() const override;
+
+  std::optional<int> runPostOrganizer(OrganizerCore& core) override;
+};
+
+
+// builds the directory structure from a file written by record-refresh and
+// prints the time taken by each phase as csv
+//
+class ReplayRefreshCommand : public Command
+{
+protected:
+  Meta meta() const override;
+
+  po::options_description getVisibleOptions() const override;
+  po::options_description getInternalOptions() const override;
+  po::positional_options_description getPositional() const override;
+
+  std::optional<int> runPostApplication(MOApplication& a) override;
+};
+
+
 // parses the command line and runs any given command
 //
 // the command line used to support a few commands but with no real conventions;
@@ -308,6 +384,13 @@ public:
   //
   bool forwardToPrimary(MOMultiProcess& multiProcess);
 
+  // the nxm link or the shortcut given on the command line when it can be
+  // forwarded to a running instance before anything is set up, see
+  // MOMultiProcess::forwardEarly(); empty if there's none, if there's a
+  // command or if another instance is allowed with --multiple
+  //
+  std::optional<QString> earlyForward() const;
+
 
   // clears parsed options, used when MO is "restarted" so the options aren't
   // processed again
@@ -326,6 +409,10 @@ public:
   //
   bool multiple() const;
 
+  // whether --startup-profile was given
+  //
+  bool startupProfile() const;
+
   // profile override (-p)
   //
   std::optional<QString> profile() const;
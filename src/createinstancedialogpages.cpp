@@ -3,6 +3,7 @@
 #include "instancemanager.h"
 #include "settings.h"
 #include "plugincontainer.h"
+#include "gamedetection.h"
 #include "settingsdialognexus.h"
 #include "shared/appconfig.h"
 #include <iplugingame.h>
@@ -232,19 +233,17 @@ void TypePage::doActivated(bool firstTime)
 
 
 GamePage::Game::Game(IPluginGame* g)
-  : game(g), installed(g->isInstalled())
+  : game(g)
 {
-  if (installed) {
-    dir = game->gameDirectory().path();
-  }
 }
 
 
 GamePage::GamePage(CreateInstanceDialog& dlg)
-  : Page(dlg), m_selection(nullptr)
+  : Page(dlg), m_selection(nullptr), m_refillQueued(false)
 {
   createGames();
   fillList();
+  detectGames();
 
   m_filter.setEdit(ui->gamesFilter);
 
@@ -292,6 +291,12 @@ void GamePage::select(IPluginGame* game, const QString& dir)
   Game* checked = findGame(game);
 
   if (checked) {
+    if (!checked->installed && !checked->detected && dir.isEmpty()) {
+      // the plugin is still looking for the game, wait for it instead of
+      // asking the user for a folder it might find
+      onDetected(game, GameDetection::detectNow(game));
+    }
+
     if (!checked->installed) {
       if (dir.isEmpty()) {
         // the selected game has no installation directory and none was given,
@@ -354,20 +359,24 @@ void GamePage::selectCustom()
   }
 
   // try to find a plugin that likes this directory
+  std::vector<IPluginGame*> games;
   for (auto& g : m_games) {
-    if (g->game->looksValid(path)) {
-      // found one
-      g->dir = path;
-      g->installed = true;
+    games.push_back(g->game);
+  }
+
+  if (auto* game=GameDetection::findForDirectory(path, games, m_pc)) {
+    // found one
+    Game* g = findGame(game);
+    g->dir = path;
+    g->installed = true;
 
-      // select it
-      select(g->game);
+    // select it
+    select(g->game);
 
-      // update the button because the path has changed
-      updateButton(g.get());
+    // update the button because the path has changed
+    updateButton(g);
 
-      return;
-    }
+    return;
   }
 
   // warning to the user
@@ -426,6 +435,54 @@ void GamePage::createGames()
   }
 }
 
+void GamePage::detectGames()
+{
+  std::vector<IPluginGame*> games;
+  for (auto& g : m_games) {
+    games.push_back(g->game);
+  }
+
+  GameDetection::detect(games, m_pc, &m_detection, [&](auto* game, auto&& r) {
+    onDetected(game, r);
+  });
+}
+
+void GamePage::onDetected(IPluginGame* game, const GameDetection::Result& r)
+{
+  Game* g = findGame(game);
+  if (!g || g->detected) {
+    return;
+  }
+
+  g->detected = true;
+
+  if (g->installed || !r.installed) {
+    // the user has already picked a directory, or nothing was found; this
+    // only changes the description
+    updateButton(g);
+    return;
+  }
+
+  g->dir = r.directory;
+  g->installed = true;
+
+  if (g->button) {
+    updateButton(g);
+    return;
+  }
+
+  // the game was hidden because it wasn't installed; results tend to come in
+  // bunches, so the list is only filled once for all of them
+  if (!m_refillQueued) {
+    m_refillQueued = true;
+
+    QMetaObject::invokeMethod(&m_detection, [&] {
+      m_refillQueued = false;
+      fillList();
+    }, Qt::QueuedConnection);
+  }
+}
+
 GamePage::Game* GamePage::findGame(IPluginGame* game)
 {
   for (auto& g : m_games) {
@@ -468,6 +525,8 @@ void GamePage::updateButton(Game* g)
 
   if (g->installed) {
     g->button->setDescription(g->dir);
+  } else if (!g->detected) {
+    g->button->setDescription(QObject::tr("Looking for an installation..."));
   } else {
     g->button->setDescription(QObject::tr("No installation found"));
   }
@@ -584,6 +643,11 @@ void GamePage::fillList()
   if (firstButton) {
     firstButton->button->setDefault(true);
   }
+
+  // the list can be refilled as games are detected, keep the selection
+  if (m_selection && m_selection->button) {
+    m_selection->button->setChecked(true);
+  }
 }
 
 GamePage::Game* GamePage::checkInstallation(const QString& path, Game* g)
@@ -594,14 +658,8 @@ GamePage::Game* GamePage::checkInstallation(const QString& path, Game* g)
   }
 
   // the selected game can't use that folder, find another one
-  IPluginGame* otherGame = nullptr;
-
-  for (auto* gg : m_pc.plugins<IPluginGame>()) {
-    if (gg->looksValid(path)) {
-      otherGame = gg;
-      break;
-    }
-  }
+  IPluginGame* otherGame = GameDetection::findForDirectory(
+    path, m_pc.plugins<IPluginGame>(), m_pc);
 
   if (otherGame == g->game) {
     // shouldn't happen, but okay
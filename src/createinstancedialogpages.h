@@ -2,6 +2,7 @@
 #define MODORGANIZER_CREATEINSTANCEDIALOGPAGES_INCLUDED
 
 #include "createinstancedialog.h"
+#include "gamedetection.h"
 #include <filterwidget.h>
 
 #include <QLabel>
@@ -252,14 +253,17 @@ private:
     // button on the ui
     QCommandLinkButton* button = nullptr;
 
-    // game directory; set in ctor if the plugin has detected the game, or
-    // set later when the user selects a directory
+    // game directory; set once the plugin has detected the game, or when the
+    // user selects a directory
     QString dir;
 
     // whether a directory has been set for this game, either auto detected
     // or by the user
     bool installed = false;
 
+    // whether the plugin has finished looking for the game
+    bool detected = false;
+
 
     Game(MOBase::IPluginGame* g);
     Game(const Game&) = delete;
@@ -276,6 +280,13 @@ private:
   // filter
   MOBase::FilterWidget m_filter;
 
+  // receives the detection results, they're dropped once the page is gone
+  QObject m_detection;
+
+  // whether fillList() has been queued because detected games have to be
+  // shown
+  bool m_refillQueued;
+
 
   // returns a list of all the game plugins sorted with natsort
   //
@@ -285,6 +296,16 @@ private:
   //
   void createGames();
 
+  // starts detecting all the games, see onDetected()
+  //
+  void detectGames();
+
+  // called on the ui thread when a plugin has finished looking for its game;
+  // updates its button, or queues a refill of the list if the game has to be
+  // shown
+  //
+  void onDetected(MOBase::IPluginGame* game, const GameDetection::Result& r);
+
   // finds the game struct associated with the given game
   //
   Game* findGame(MOBase::IPluginGame* game);
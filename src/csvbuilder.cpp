@@ -1,4 +1,5 @@
 #include "csvbuilder.h"
+#include <algorithm>
 
 
 CSVBuilder::CSVBuilder(QIODevice *target)
@@ -14,7 +15,7 @@ CSVBuilder::CSVBuilder(QIODevice *target)
 
 CSVBuilder::~CSVBuilder()
 {
-
+  m_Out.flush();
 }
 
 
@@ -46,31 +47,40 @@ void CSVBuilder::setEscapeMode(CSVBuilder::EFieldType type, CSVBuilder::EQuoteMo
 void CSVBuilder::setFields(const std::vector<std::pair<QString, EFieldType> > &fields)
 {
   std::vector<QString> fieldNames;
-  std::map<QString, EFieldType> fieldTypes;
+  std::vector<EFieldType> fieldTypes;
+  std::map<QString, int> fieldIndexes;
 
   for (auto iter = fields.begin(); iter != fields.end(); ++iter) {
+    fieldIndexes[iter->first] = static_cast<int>(fieldNames.size());
     fieldNames.push_back(iter->first);
-    fieldTypes[iter->first] = iter->second;
+    fieldTypes.push_back(iter->second);
   }
 
   checkFields(fieldNames);
 
   m_Fields = fieldNames;
   m_FieldTypes = fieldTypes;
-  m_Defaults.clear();
-  m_RowBuffer.clear();
+  m_FieldIndexes = fieldIndexes;
+  m_Defaults.assign(m_Fields.size(), QVariant());
+  m_RowBuffer.assign(m_Fields.size(), QVariant());
 
 }
 
 
-void CSVBuilder::checkValue(const QString &field, const QVariant &value)
+int CSVBuilder::fieldIndex(const QString &field) const
 {
-  auto typeIter = m_FieldTypes.find(field);
-  if (typeIter == m_FieldTypes.end()) {
+  auto iter = m_FieldIndexes.find(field);
+  if (iter == m_FieldIndexes.end()) {
     throw CSVException(QObject::tr("invalid field name \"%1\"").arg(field));
   }
 
-  switch (typeIter->second) {
+  return iter->second;
+}
+
+
+void CSVBuilder::checkValue(const QString &field, const QVariant &value)
+{
+  switch (m_FieldTypes[fieldIndex(field)]) {
     case TYPE_INTEGER: {
       if (!value.canConvert<int>()) {
         throw CSVException(QObject::tr("invalid type for \"%1\" (should be integer)").arg(field));
@@ -93,7 +103,7 @@ void CSVBuilder::checkValue(const QString &field, const QVariant &value)
 void CSVBuilder::setDefault(const QString &field, const QVariant &value)
 {
   checkValue(field, value);
-  m_Defaults[field] = value;
+  m_Defaults[fieldIndex(field)] = value;
 }
 
 
@@ -117,52 +127,45 @@ void CSVBuilder::writeHeader()
 void CSVBuilder::setRowField(const QString &field, const QVariant &value)
 {
   checkValue(field, value);
-  m_RowBuffer[field] = value;
+  m_RowBuffer[fieldIndex(field)] = value;
 }
 
 
-void CSVBuilder::writeData(const std::map<QString, QVariant> &data, bool check)
+void CSVBuilder::writeData(const std::vector<QVariant> &data, bool check)
 {
-  QString line;
-  QTextStream temp(&line);
-
-  for (auto iter = m_Fields.begin(); iter != m_Fields.end(); ++iter) {
-    if (iter != m_Fields.begin()) {
-      temp << separator();
+  // all the fields must be set before anything is written, the row goes
+  // straight to the stream
+  for (std::size_t i = 0; i < m_Fields.size(); ++i) {
+    if (!data[i].isValid() && !m_Defaults[i].isValid()) {
+      throw CSVException(QObject::tr("field not set \"%1\"").arg(m_Fields[i]));
     }
+  }
 
-    QVariant val;
-
-    auto valIter = data.find(*iter);
-    if (valIter == data.end()) {
-      auto defaultIter = m_Defaults.find(*iter);
-      if (defaultIter == m_Defaults.end()) {
-        throw CSVException(QObject::tr("field not set \"%1\"").arg(*iter));
-      } else {
-        val = defaultIter->second;
-      }
-    } else {
-      val = valIter->second;
+  for (std::size_t i = 0; i < m_Fields.size(); ++i) {
+    if (i > 0) {
+      m_Out << separator();
     }
 
+    const QVariant& val = data[i].isValid() ? data[i] : m_Defaults[i];
+
     if (check) {
-      checkValue(*iter, val);
+      checkValue(m_Fields[i], val);
     }
 
-    switch (m_FieldTypes[*iter]) {
+    switch (m_FieldTypes[i]) {
       case TYPE_INTEGER: {
-        quoteInsert(temp, val.toInt());
+        quoteInsert(m_Out, val.toInt());
       } break;
       case TYPE_FLOAT: {
-        quoteInsert(temp, val.toFloat());
+        quoteInsert(m_Out, val.toFloat());
       } break;
       case TYPE_STRING: {
-        quoteInsert(temp, val.toString());
+        quoteInsert(m_Out, val.toString());
       } break;
     }
   }
-  m_Out << line << lineBreak();
-  m_Out.flush();
+
+  m_Out << lineBreak();
 }
 
 
@@ -201,7 +204,11 @@ void CSVBuilder::quoteInsert(QTextStream &stream, const QString &value)
       stream << value;
     } break;
     case QUOTE_ONDEMAND: {
-      if (value.contains("[,\r\n]")) {
+      const bool needsQuotes = std::any_of(value.begin(), value.end(), [&](QChar c) {
+        return (c == m_Separator || c == '"' || c == '\r' || c == '\n');
+      });
+
+      if (needsQuotes) {
         stream << "\"" << value.mid(0).replace("\"", "\"\"") << "\"";
       } else {
         stream << value;
@@ -217,13 +224,25 @@ void CSVBuilder::quoteInsert(QTextStream &stream, const QString &value)
 void CSVBuilder::writeRow()
 {
   writeData(m_RowBuffer, false); // data was tested on input
-  m_RowBuffer.clear();
+  m_RowBuffer.assign(m_Fields.size(), QVariant());
 }
 
 
 void CSVBuilder::addRow(const std::map<QString, QVariant> &data)
 {
-  writeData(data, true);
+  std::vector<QVariant> row(m_Fields.size());
+
+  for (auto&& [field, value] : data) {
+    row[fieldIndex(field)] = value;
+  }
+
+  writeData(row, true);
+}
+
+
+void CSVBuilder::flush()
+{
+  m_Out.flush();
 }
 
 
@@ -2,6 +2,7 @@
 #define CSVBUILDER_H
 
 
+#include <map>
 #include <vector>
 #include <QString>
 #include <QVariant>
@@ -47,6 +48,9 @@ public:
 
 public:
 
+  // rows are written to the device as they're added, through the stream's
+  // buffer; call flush() before reading the device
+  //
   CSVBuilder(QIODevice *target);
   ~CSVBuilder();
 
@@ -63,6 +67,10 @@ public:
 
   void addRow(const std::map<QString, QVariant> &data);
 
+  // writes what's left in the buffer to the device
+  //
+  void flush();
+
 private:
 
   const char *lineBreak();
@@ -71,7 +79,8 @@ private:
   void fieldValid();
   void checkFields(const std::vector<QString> &fields);
   void checkValue(const QString &field, const QVariant &value);
-  void writeData(const std::map<QString, QVariant> &data, bool check);
+  int fieldIndex(const QString &field) const;
+  void writeData(const std::vector<QVariant> &data, bool check);
 
   void quoteInsert(QTextStream &stream, int value);
   void quoteInsert(QTextStream &stream, float value);
@@ -84,9 +93,12 @@ private:
   ELineBreak m_LineBreak;
   std::map<EFieldType, EQuoteMode> m_QuoteMode;
   std::vector<QString> m_Fields;
-  std::map<QString, EFieldType> m_FieldTypes;
-  std::map<QString, QVariant> m_Defaults;
-  std::map<QString, QVariant> m_RowBuffer;
+  std::vector<EFieldType> m_FieldTypes;
+  std::map<QString, int> m_FieldIndexes;
+
+  // by field index, invalid for fields that have no value or default
+  std::vector<QVariant> m_Defaults;
+  std::vector<QVariant> m_RowBuffer;
 
 };
 
@@ -0,0 +1,380 @@
+#include "datadirectorycache.h"
+#include "metrics.h"
+#include "shared/directoryentry.h"
+#include "shared/filesorigin.h"
+#include <log.h>
+#include <safewritefile.h>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <stack>
+
+using namespace MOBase;
+using namespace MOShared;
+
+// changed every time the format of the file changes, files with another
+// version are ignored
+static constexpr quint32 CacheMagic = 0x4d4f4444;  // "MODD"
+static constexpr quint32 CacheVersion = 1;
+
+static bool sameTime(const FILETIME& a, const FILETIME& b)
+{
+  return
+    a.dwLowDateTime == b.dwLowDateTime &&
+    a.dwHighDateTime == b.dwHighDateTime;
+}
+
+static bool isZero(const FILETIME& ft)
+{
+  return (ft.dwLowDateTime == 0 && ft.dwHighDateTime == 0);
+}
+
+// gets the attributes of the given file or directory, false if it doesn't
+// exist
+//
+static bool getAttributes(
+  const std::wstring& path, WIN32_FILE_ATTRIBUTE_DATA& data)
+{
+  // long path prefix, like the walker
+  const std::wstring fullPath = L"\\\\?\\" + path;
+  return ::GetFileAttributesExW(fullPath.c_str(), GetFileExInfoStandard, &data);
+}
+
+static void writeTime(QDataStream& s, const FILETIME& ft)
+{
+  s
+    << static_cast<quint32>(ft.dwLowDateTime)
+    << static_cast<quint32>(ft.dwHighDateTime);
+}
+
+static FILETIME readTime(QDataStream& s)
+{
+  quint32 low = 0, high = 0;
+  s >> low >> high;
+
+  FILETIME ft;
+  ft.dwLowDateTime = low;
+  ft.dwHighDateTime = high;
+
+  return ft;
+}
+
+static void writeDirectory(QDataStream& s, const env::Directory& d)
+{
+  s << static_cast<quint32>(d.files.size());
+
+  for (const auto& f : d.files) {
+    s << QString::fromStdWString(f.name) << static_cast<quint64>(f.size);
+    writeTime(s, f.lastModified);
+  }
+
+  s << static_cast<quint32>(d.dirs.size());
+
+  for (const auto& sd : d.dirs) {
+    s << QString::fromStdWString(sd.name);
+    writeDirectory(s, sd);
+  }
+}
+
+static bool readDirectory(QDataStream& s, env::Directory& d)
+{
+  quint32 fileCount = 0;
+  s >> fileCount;
+
+  d.files.reserve(fileCount);
+
+  for (quint32 i=0; i<fileCount; ++i) {
+    QString name;
+    quint64 size = 0;
+
+    s >> name >> size;
+    const FILETIME ft = readTime(s);
+
+    if (s.status() != QDataStream::Ok) {
+      return false;
+    }
+
+    d.files.push_back(env::File(name.toStdWString(), ft, size));
+  }
+
+  quint32 dirCount = 0;
+  s >> dirCount;
+
+  d.dirs.reserve(dirCount);
+
+  for (quint32 i=0; i<dirCount; ++i) {
+    QString name;
+    s >> name;
+
+    if (s.status() != QDataStream::Ok) {
+      return false;
+    }
+
+    d.dirs.push_back(env::Directory(name.toStdWString()));
+
+    if (!readDirectory(s, d.dirs.back())) {
+      return false;
+    }
+  }
+
+  return (s.status() == QDataStream::Ok);
+}
+
+
+DataDirectoryCache::DataDirectoryCache()
+  : m_Dirty(false), m_Size(0)
+{
+}
+
+void DataDirectoryCache::setFilename(const QString& path)
+{
+  if (m_Filename == path) {
+    return;
+  }
+
+  save();
+
+  m_Filename = path;
+  m_Dirty = false;
+  clear();
+
+  load();
+}
+
+bool DataDirectoryCache::addToStructure(
+  DirectoryEntry& root, const std::wstring& originName,
+  const std::wstring& directory, int priority, DirectoryStats& stats)
+{
+  const bool cached = isValid(directory);
+
+  if (!cached) {
+    walk(directory);
+  }
+
+  root.addFromList(originName, directory, m_Tree, priority, stats);
+
+  auto& origin = root.getOriginByName(originName);
+
+  origin.clearDirectoryStamps();
+  for (const auto& stamp : m_Stamps) {
+    origin.addDirectoryStamp(stamp.path, stamp.lastModified);
+  }
+
+  origin.setLooseSize(m_Size);
+
+  return cached;
+}
+
+void DataDirectoryCache::save()
+{
+  if (!m_Dirty || m_Filename.isEmpty()) {
+    return;
+  }
+
+  QByteArray data;
+
+  {
+    QDataStream s(&data, QIODevice::WriteOnly);
+    s.setVersion(QDataStream::Qt_5_12);
+
+    s
+      << CacheMagic << CacheVersion
+      << QString::fromStdWString(m_Directory)
+      << static_cast<quint64>(m_Size)
+      << static_cast<quint32>(m_Stamps.size());
+
+    for (const auto& stamp : m_Stamps) {
+      s << QString::fromStdWString(stamp.path);
+      writeTime(s, stamp.lastModified);
+    }
+
+    writeDirectory(s, m_Tree);
+  }
+
+  // the cache directory may not exist yet
+  QDir().mkpath(QFileInfo(m_Filename).absolutePath());
+
+  try
+  {
+    SafeWriteFile file(m_Filename);
+    file->resize(0);
+    file->write(data);
+    file.commit();
+
+    m_Dirty = false;
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to save data directory cache to {}: {}", m_Filename, e.what());
+  }
+}
+
+bool DataDirectoryCache::isValid(const std::wstring& directory) const
+{
+  Metrics::Timer tt("DataDirectoryCache::isValid()");
+
+  if (m_Directory.empty() || m_Directory != directory) {
+    return false;
+  }
+
+  for (const auto& stamp : m_Stamps) {
+    WIN32_FILE_ATTRIBUTE_DATA data = {};
+
+    // a zeroed time means the directory couldn't be opened when it was
+    // walked, it's walked again in case it can be now
+    if (isZero(stamp.lastModified) || !getAttributes(stamp.path, data)) {
+      return false;
+    }
+
+    if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+      return false;
+    }
+
+    if (!sameTime(data.ftLastWriteTime, stamp.lastModified)) {
+      return false;
+    }
+  }
+
+  // plugins and archives are sometimes patched in place by game updates
+  for (const auto& f : m_Tree.files) {
+    WIN32_FILE_ATTRIBUTE_DATA data = {};
+
+    if (!getAttributes(directory + L"\\" + f.name, data)) {
+      return false;
+    }
+
+    const uint64_t size =
+      (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+
+    if (size != f.size || !sameTime(data.ftLastWriteTime, f.lastModified)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void DataDirectoryCache::walk(const std::wstring& directory)
+{
+  Metrics::Timer tt("DataDirectoryCache::walk()");
+
+  struct Context
+  {
+    std::stack<env::Directory*> current;
+    std::wstring path;
+    std::vector<Stamp>& stamps;
+    uint64_t size;
+  };
+
+  clear();
+
+  m_Directory = directory;
+  m_Dirty = true;
+
+  {
+    // if this fails, the time stays zeroed and the directory is walked again
+    // next time
+    WIN32_FILE_ATTRIBUTE_DATA data = {};
+    getAttributes(directory, data);
+
+    m_Stamps.push_back({directory, data.ftLastWriteTime});
+  }
+
+  Context cx = {{}, directory, m_Stamps, 0};
+  cx.current.push(&m_Tree);
+
+  env::DirectoryWalker walker;
+
+  walker.forEachEntry(directory, &cx,
+    [](void* pcx, std::wstring_view name, FILETIME ft) {
+      Context* cx = (Context*)pcx;
+
+      auto& dirs = cx->current.top()->dirs;
+      dirs.push_back(env::Directory(name));
+      cx->current.push(&dirs.back());
+
+      cx->path.append(L"\\").append(name);
+      cx->stamps.push_back({cx->path, ft});
+    },
+
+    [](void* pcx, std::wstring_view name) {
+      Context* cx = (Context*)pcx;
+
+      cx->current.pop();
+
+      const auto sep = cx->path.find_last_of(L'\\');
+      if (sep != std::wstring::npos) {
+        cx->path.resize(sep);
+      }
+    },
+
+    [](void* pcx, std::wstring_view name, FILETIME ft, uint64_t s) {
+      Context* cx = (Context*)pcx;
+
+      cx->current.top()->files.push_back(env::File(name, ft, s));
+      cx->size += s;
+    }
+  );
+
+  m_Size = cx.size;
+
+  log::debug(
+    "walked data directory {}, {} directories",
+    QString::fromStdWString(directory), m_Stamps.size());
+}
+
+void DataDirectoryCache::clear()
+{
+  m_Directory.clear();
+  m_Tree = {};
+  m_Stamps.clear();
+  m_Size = 0;
+}
+
+void DataDirectoryCache::load()
+{
+  QFile file(m_Filename);
+  if (!file.open(QIODevice::ReadOnly)) {
+    // not necessarily a problem, the file may just not exist (yet)
+    return;
+  }
+
+  QDataStream s(&file);
+  s.setVersion(QDataStream::Qt_5_12);
+
+  quint32 magic = 0, version = 0;
+  s >> magic >> version;
+
+  if (magic != CacheMagic || version != CacheVersion) {
+    log::debug("ignoring data directory cache {}, wrong version", m_Filename);
+    return;
+  }
+
+  QString directory;
+  quint64 size = 0;
+  quint32 stampCount = 0;
+
+  s >> directory >> size >> stampCount;
+
+  for (quint32 i=0; i<stampCount && s.status() == QDataStream::Ok; ++i) {
+    QString path;
+    s >> path;
+
+    const FILETIME ft = readTime(s);
+    m_Stamps.push_back({path.toStdWString(), ft});
+  }
+
+  if (s.status() != QDataStream::Ok || !readDirectory(s, m_Tree)) {
+    log::error("data directory cache {} is corrupted, ignoring it", m_Filename);
+    clear();
+    return;
+  }
+
+  m_Directory = directory.toStdWString();
+  m_Size = size;
+
+  log::debug(
+    "loaded data directory {} from {}, {} directories",
+    directory, m_Filename, m_Stamps.size());
+}
@@ -0,0 +1,85 @@
+#ifndef MODORGANIZER_DATADIRECTORYCACHE_INCLUDED
+#define MODORGANIZER_DATADIRECTORYCACHE_INCLUDED
+
+#include "envfs.h"
+#include "shared/fileregisterfwd.h"
+#include <QString>
+#include <string>
+#include <vector>
+
+// the files of the game's data directory, remembered across refreshes and
+// runs so the directory, which is large for some games and almost never
+// changes, isn't walked on every full refresh
+//
+// the listing is only used if the modification time of every directory is
+// the same as when it was walked, which catches files and directories being
+// added, removed or renamed, and if the size and time of the files directly
+// in the data directory haven't changed, which is where plugins and archives
+// are; other files modified in place are only seen once a directory changes,
+// like with FilesOrigin::directoriesChanged()
+//
+// the listing is stored in the cache directory of the instance, it's loaded
+// by setFilename() and written by save() if it changed
+//
+// this is not thread-safe, it's only used by DirectoryRefresher::refresh()
+//
+class DataDirectoryCache
+{
+public:
+  DataDirectoryCache();
+
+  // loads the cache from the given file, does nothing if it's the file that's
+  // already loaded; an unsaved cache is written to the previous file first
+  //
+  void setFilename(const QString& path);
+
+  // adds the files of the given directory to the structure as a new origin,
+  // from the cache if it's still valid or by walking the directory, which
+  // updates the cache; the directory stamps of the origin are set either way
+  // so incremental refreshes can tell when the directory changes
+  //
+  // returns true if the cache was used
+  //
+  bool addToStructure(
+    MOShared::DirectoryEntry& root, const std::wstring& originName,
+    const std::wstring& directory, int priority,
+    MOShared::DirectoryStats& stats);
+
+  // writes the cache file if the directory was walked since it was loaded
+  //
+  void save();
+
+private:
+  struct Stamp
+  {
+    std::wstring path;
+    FILETIME lastModified;
+  };
+
+  QString m_Filename;
+  bool m_Dirty;
+
+  // directory that was walked, empty if there's nothing in the cache
+  std::wstring m_Directory;
+
+  env::Directory m_Tree;
+
+  // every directory that was walked, including the data directory itself,
+  // with its last modification time
+  std::vector<Stamp> m_Stamps;
+
+  // total size of the files, see FilesOrigin::looseSize()
+  uint64_t m_Size;
+
+  // whether the cache was walked from the given directory and nothing in it
+  // has changed since
+  //
+  bool isValid(const std::wstring& directory) const;
+
+  void walk(const std::wstring& directory);
+
+  void clear();
+  void load();
+};
+
+#endif // MODORGANIZER_DATADIRECTORYCACHE_INCLUDED
@@ -14,6 +14,9 @@ using namespace MOBase;
 // in mainwindow.cpp
 QString UnmanagedModName();
 
+// matches shown by the search box, the search has to be refined for more
+static constexpr std::size_t MaxSearchResults = 5000;
+
 
 DataTab::DataTab(
   OrganizerCore& core, PluginContainer& pc,
@@ -21,7 +24,8 @@ DataTab::DataTab(
     m_core(core), m_pluginContainer(pc), m_parent(parent),
     ui{
       mwui->tabWidget, mwui->dataTab, mwui->dataTabRefresh, mwui->dataTree,
-      mwui->dataTabShowOnlyConflicts, mwui->dataTabShowFromArchives},
+      mwui->dataTabShowOnlyConflicts, mwui->dataTabShowFromArchives,
+      mwui->dataTabSearch, mwui->dataTabSearchResults},
     m_needUpdate(true)
 {
   m_filetree.reset(new FileTree(core, m_pluginContainer, ui.tree));
@@ -51,6 +55,17 @@ DataTab::DataTab(
     ui.archives, &QCheckBox::toggled,
     [&]{ onArchives(); });
 
+  // the results replace the tree while there's something to search for
+  ui.searchResults->hide();
+
+  connect(
+    ui.search, &QLineEdit::textChanged,
+    [&]{ onSearch(); });
+
+  connect(
+    &m_core, &OrganizerCore::fileSearchIndexChanged, this,
+    [&]{ onSearch(); });
+
   connect(
     m_filetree.get(), &FileTree::executablesChanged,
     this, &DataTab::executablesChanged);
@@ -140,6 +155,51 @@ void DataTab::ensureFullyLoaded()
   }
 }
 
+void DataTab::onSearch()
+{
+  const QString text = ui.search->text().trimmed();
+
+  if (text.isEmpty()) {
+    ui.searchResults->hide();
+    ui.searchResults->clear();
+    ui.tree->show();
+    return;
+  }
+
+  auto originName = [](const QString& name) {
+    return (name == "data" ? UnmanagedModName() : name);
+  };
+
+  bool truncated = false;
+  const auto matches = m_core.searchFiles(text, MaxSearchResults, &truncated);
+
+  QList<QTreeWidgetItem*> items;
+  items.reserve(static_cast<int>(matches.size()) + 1);
+
+  for (const auto& m : matches) {
+    QStringList alternatives;
+    for (const auto& a : m.alternatives) {
+      alternatives.append(originName(a));
+    }
+
+    items.append(new QTreeWidgetItem({
+      m.path, originName(m.origin), alternatives.join(", ")}));
+  }
+
+  if (truncated) {
+    items.append(new QTreeWidgetItem({
+      tr("More than %1 files match, refine the search").arg(MaxSearchResults)}));
+  }
+
+  ui.searchResults->setUpdatesEnabled(false);
+  ui.searchResults->clear();
+  ui.searchResults->addTopLevelItems(items);
+  ui.searchResults->setUpdatesEnabled(true);
+
+  ui.tree->hide();
+  ui.searchResults->show();
+}
+
 void DataTab::onConflicts()
 {
   updateOptions();
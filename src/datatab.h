@@ -7,6 +7,7 @@
 #include <QPushButton>
 #include <QTreeWidget>
 #include <QCheckBox>
+#include <QLineEdit>
 
 namespace Ui { class MainWindow; }
 class OrganizerCore;
@@ -49,6 +50,8 @@ private:
     QTreeView* tree;
     QCheckBox* conflicts;
     QCheckBox* archives;
+    QLineEdit* search;
+    QTreeWidget* searchResults;
   };
 
   OrganizerCore& m_core;
@@ -63,6 +66,7 @@ private:
   void onRefresh();
   void onItemExpanded(QTreeWidgetItem* item);
   void onConflicts();
+  void onSearch();
   void onArchives();
   void updateOptions();
   void ensureFullyLoaded();
@@ -0,0 +1,254 @@
+#include "deletionqueue.h"
+#include "shared/util.h"
+#include <log.h>
+#include <report.h>
+#include <utility.h>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <windows.h>
+
+using namespace MOBase;
+using namespace MOShared;
+
+// time the thread waits for more files once something was queued, files
+// queued in the meantime are deleted in the same operation
+static constexpr std::chrono::milliseconds BatchDelay(250);
+
+
+namespace
+{
+
+struct Item
+{
+  // where the file was and its hidden name
+  QString original;
+  QString moved;
+  bool recycle;
+};
+
+// shared with the thread
+struct State
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<Item> items;
+  std::thread thread;
+  bool stop = false;
+};
+
+State g_state;
+
+// a hidden name next to the given path that doesn't exist yet
+//
+QString hiddenName(const QFileInfo& fi)
+{
+  const QDir dir = fi.absoluteDir();
+
+  for (int i=0; ; ++i) {
+    const QString name = QString("%1.mo-deleted-%2")
+      .arg(fi.fileName())
+      .arg(::GetTickCount64() + i, 0, 16);
+
+    if (!dir.exists(name)) {
+      return dir.absoluteFilePath(name);
+    }
+  }
+}
+
+// deletes the given items with one shell operation; when that fails, they're
+// deleted one by one to find the ones that failed, returns their original
+// paths
+//
+QStringList deleteBatch(const std::vector<Item>& items, bool recycle)
+{
+  QStringList paths;
+  for (const auto& i : items) {
+    paths.append(QDir::toNativeSeparators(i.moved));
+  }
+
+  if (shellDelete(paths, recycle)) {
+    return {};
+  }
+
+  log::warn(
+    "deletion queue: failed to delete {} files at once, {}; trying them "
+    "one by one", paths.size(), formatSystemMessage(::GetLastError()));
+
+  QStringList failed;
+
+  for (const auto& i : items) {
+    if (shellDelete({QDir::toNativeSeparators(i.moved)}, recycle)) {
+      continue;
+    }
+
+    const auto e = ::GetLastError();
+    log::error(
+      "deletion queue: failed to delete '{}' (was '{}'), {}",
+      i.moved, i.original, formatSystemMessage(e));
+
+    failed.append(i.original);
+  }
+
+  return failed;
+}
+
+void run()
+{
+  // the shell operations need com on this thread
+  const auto r = ::CoInitializeEx(
+    nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+
+  if (FAILED(r)) {
+    log::error(
+      "deletion queue: can't initialize com, {}", formatSystemMessage(r));
+  }
+
+  for (;;) {
+    std::vector<Item> recycled, deleted;
+
+    {
+      std::unique_lock lock(g_state.mutex);
+      g_state.cv.wait(lock, [&]{ return g_state.stop || !g_state.items.empty(); });
+
+      if (g_state.items.empty()) {
+        break;
+      }
+
+      // gives a loop removing files one at a time a chance to queue the
+      // others, unless exiting
+      g_state.cv.wait_for(lock, BatchDelay, [&]{ return g_state.stop; });
+
+      for (auto& i : g_state.items) {
+        (i.recycle ? recycled : deleted).push_back(std::move(i));
+      }
+
+      g_state.items.clear();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    QStringList failed;
+
+    if (!recycled.empty()) {
+      failed += deleteBatch(recycled, true);
+    }
+
+    if (!deleted.empty()) {
+      failed += deleteBatch(deleted, false);
+    }
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count();
+
+    log::debug(
+      "deletion queue: {} recycled and {} deleted in {}ms, {} failed",
+      recycled.size(), deleted.size(), ms, failed.size());
+
+    if (!failed.isEmpty()) {
+      QMetaObject::invokeMethod(qApp, [failed] {
+        reportError(QObject::tr(
+          "The following could not be deleted. They have been renamed and "
+          "hidden in the same folder, and must be deleted manually:\n%1")
+          .arg(failed.join("\n")));
+      }, Qt::QueuedConnection);
+    }
+  }
+
+  if (SUCCEEDED(r)) {
+    ::CoUninitialize();
+  }
+}
+
+} // namespace
+
+
+QStringList DeletionQueue::add(const QStringList& paths, bool recycle)
+{
+  QStringList notMoved;
+  std::vector<Item> items;
+
+  for (const auto& path : paths) {
+    const QFileInfo fi(path);
+
+    if (!fi.exists()) {
+      continue;
+    }
+
+    const QString moved = hiddenName(fi);
+    const auto movedW = QDir::toNativeSeparators(moved).toStdWString();
+
+    if (!::MoveFileExW(
+      QDir::toNativeSeparators(fi.absoluteFilePath()).toStdWString().c_str(),
+      movedW.c_str(), 0)) {
+      const auto e = ::GetLastError();
+      log::warn(
+        "deletion queue: can't move '{}', {}", path, formatSystemMessage(e));
+
+      notMoved.append(path);
+      continue;
+    }
+
+    // mods and profiles are listed without hidden directories
+    const DWORD attributes = ::GetFileAttributesW(movedW.c_str());
+    if (attributes != INVALID_FILE_ATTRIBUTES) {
+      ::SetFileAttributesW(movedW.c_str(), attributes | FILE_ATTRIBUTE_HIDDEN);
+    }
+
+    log::debug(
+      "deletion queue: {} '{}'", (recycle ? "recycling" : "deleting"), path);
+
+    items.push_back({fi.absoluteFilePath(), moved, recycle});
+  }
+
+  if (items.empty()) {
+    return notMoved;
+  }
+
+  {
+    std::scoped_lock lock(g_state.mutex);
+
+    for (auto& i : items) {
+      g_state.items.push_back(std::move(i));
+    }
+
+    if (!g_state.thread.joinable()) {
+      g_state.stop = false;
+      g_state.thread = std::thread([]{
+        SetThisThreadName("deletion queue");
+        run();
+      });
+    }
+  }
+
+  g_state.cv.notify_one();
+
+  return notMoved;
+}
+
+void DeletionQueue::finish()
+{
+  {
+    std::scoped_lock lock(g_state.mutex);
+
+    if (!g_state.thread.joinable()) {
+      return;
+    }
+
+    if (!g_state.items.empty()) {
+      log::debug(
+        "deletion queue: waiting for {} files to be deleted",
+        g_state.items.size());
+    }
+
+    g_state.stop = true;
+  }
+
+  g_state.cv.notify_one();
+  g_state.thread.join();
+  g_state.thread = {};
+}
@@ -0,0 +1,34 @@
+#ifndef MODORGANIZER_DELETIONQUEUE_INCLUDED
+#define MODORGANIZER_DELETIONQUEUE_INCLUDED
+
+#include <QString>
+#include <QStringList>
+
+// deletes mods, profiles and instances in the background
+//
+// sending a large mod to the recycle bin can take minutes, so the files are
+// only renamed on the calling thread: each one gets a hidden name next to
+// where it was, which is instant because it stays on the same volume, and that
+// mods and profiles don't list; a thread then deletes them with the shell
+//
+// files queued close together are deleted with a single shell operation, so
+// removing a bunch of mods doesn't run one operation per mod; failures are
+// logged and reported once the batch is done
+//
+class DeletionQueue
+{
+public:
+  // moves the given files or directories out of the way and queues them for
+  // deletion, or for the recycle bin; returns the paths that couldn't be
+  // moved, such as when a program has a file open, which are left untouched
+  // and must be deleted by the caller
+  //
+  static QStringList add(const QStringList& paths, bool recycle);
+
+  // deletes everything that's still queued and stops the thread; blocks until
+  // it's done, called before exiting or switching instances
+  //
+  static void finish();
+};
+
+#endif // MODORGANIZER_DELETIONQUEUE_INCLUDED
@@ -1,507 +1,1055 @@
-/*
-Copyright (C) 2012 Sebastian Herbord. All rights reserved.
-
-This file is part of Mod Organizer.
-
-Mod Organizer is free software: you can redistribute it and/or modify
-it under the terms of the GNU General Public License as published by
-the Free Software Foundation, either version 3 of the License, or
-(at your option) any later version.
-
-Mod Organizer is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#include "directoryrefresher.h"
-#include "shared/fileentry.h"
-#include "shared/filesorigin.h"
-#include "shared/directoryentry.h"
-
-#include "iplugingame.h"
-#include "utility.h"
-#include "report.h"
-#include "modinfo.h"
-#include "settings.h"
-#include "envfs.h"
-#include "modinfodialogfwd.h"
-#include "shared/util.h"
-
-#include <gameplugins.h>
-
-#include <QApplication>
-#include <QDir>
-#include <QString>
-#include <QTextCodec>
-
-#include <fstream>
-
-
-using namespace MOBase;
-using namespace MOShared;
-
-
-DirectoryStats::DirectoryStats()
-{
-  std::memset(this, 0, sizeof(DirectoryStats));
-}
-
-DirectoryStats& DirectoryStats::operator+=(const DirectoryStats& o)
-{
-  dirTimes += o.dirTimes;
-  fileTimes += o.fileTimes;
-  sortTimes += o.sortTimes;
-
-  subdirLookupTimes += o.subdirLookupTimes;
-  addDirectoryTimes += o.addDirectoryTimes;
-
-  filesLookupTimes += o.filesLookupTimes;
-  addFileTimes += o.addFileTimes;
-  addOriginToFileTimes += o.addOriginToFileTimes;
-  addFileToOriginTimes += o.addFileToOriginTimes;
-  addFileToRegisterTimes += o.addFileToRegisterTimes;
-
-  originExists += o.originExists;
-  originCreate += o.originCreate;
-  originsNeededEnabled += o.originsNeededEnabled;
-
-  subdirExists += o.subdirExists;
-  subdirCreate += o.subdirCreate;
-
-  fileExists += o.fileExists;
-  fileCreate += o.fileCreate;
-  filesInsertedInRegister += o.filesInsertedInRegister;
-  filesAssignedInRegister += o.filesAssignedInRegister;
-
-  return *this;
-}
-
-std::string DirectoryStats::csvHeader()
-{
-  QStringList sl = {
-    "dirTimes",
-    "fileTimes",
-    "sortTimes",
-    "subdirLookupTimes",
-    "addDirectoryTimes",
-    "filesLookupTimes",
-    "addFileTimes",
-    "addOriginToFileTimes",
-    "addFileToOriginTimes",
-    "addFileToRegisterTimes",
-    "originExists",
-    "originCreate",
-    "originsNeededEnabled",
-    "subdirExists",
-    "subdirCreate",
-    "fileExists",
-    "fileCreate",
-    "filesInsertedInRegister",
-    "filesAssignedInRegister"};
-
-  return sl.join(",").toStdString();
-}
-
-std::string DirectoryStats::toCsv() const
-{
-  QStringList oss;
-
-  auto s = [](auto ns) {
-    return ns.count() / 1000.0 / 1000.0 / 1000.0;
-  };
-
-  oss
-    << QString::number(s(dirTimes))
-    << QString::number(s(fileTimes))
-    << QString::number(s(sortTimes))
-
-    << QString::number(s(subdirLookupTimes))
-    << QString::number(s(addDirectoryTimes))
-
-    << QString::number(s(filesLookupTimes))
-    << QString::number(s(addFileTimes))
-    << QString::number(s(addOriginToFileTimes))
-    << QString::number(s(addFileToOriginTimes))
-    << QString::number(s(addFileToRegisterTimes))
-
-    << QString::number(originExists)
-    << QString::number(originCreate)
-    << QString::number(originsNeededEnabled)
-
-    << QString::number(subdirExists)
-    << QString::number(subdirCreate)
-
-    << QString::number(fileExists)
-    << QString::number(fileCreate)
-    << QString::number(filesInsertedInRegister)
-    << QString::number(filesAssignedInRegister);
-
-  return oss.join(",").toStdString();
-}
-
-void dumpStats(std::vector<DirectoryStats>& stats)
-{
-  static int run = 0;
-  static const std::string file("c:\\tmp\\data.csv");
-
-  if (run == 0) {
-    std::ofstream out(file, std::ios::out|std::ios::trunc);
-    out << fmt::format("what,run,{}", DirectoryStats::csvHeader()) << "\n";
-  }
-
-  std::sort(stats.begin(), stats.end(), [](auto&& a, auto&& b){
-    return (naturalCompare(QString::fromStdString(a.mod), QString::fromStdString(b.mod)) < 0);
-    });
-
-  std::ofstream out(file, std::ios::app);
-
-  DirectoryStats total;
-  for (const auto& s : stats) {
-    out << fmt::format("{},{},{}", s.mod, run, s.toCsv()) << "\n";
-    total += s;
-  }
-
-  out << fmt::format("total,{},{}", run, total.toCsv()) << "\n";
-
-  ++run;
-}
-
-
-DirectoryRefresher::DirectoryRefresher(std::size_t threadCount)
-  : m_threadCount(threadCount), m_lastFileCount(0)
-{
-}
-
-DirectoryEntry *DirectoryRefresher::stealDirectoryStructure()
-{
-  QMutexLocker locker(&m_RefreshLock);
-  return m_Root.release();
-}
-
-void DirectoryRefresher::setMods(const std::vector<std::tuple<QString, QString, int> > &mods
-                                 , const std::set<QString> &managedArchives)
-{
-  QMutexLocker locker(&m_RefreshLock);
-
-  m_Mods.clear();
-  for (auto mod = mods.begin(); mod != mods.end(); ++mod) {
-    QString name = std::get<0>(*mod);
-    ModInfo::Ptr info = ModInfo::getByIndex(ModInfo::getIndex(name));
-    m_Mods.push_back(EntryInfo(name, std::get<1>(*mod), info->stealFiles(), info->archives(), std::get<2>(*mod)));
-  }
-
-  m_EnabledArchives = managedArchives;
-}
-
-void DirectoryRefresher::cleanStructure(DirectoryEntry *structure)
-{
-  static const wchar_t *files[] = { L"meta.ini", L"readme.txt" };
-  for (int i = 0; i < sizeof(files) / sizeof(wchar_t*); ++i) {
-    structure->removeFile(files[i]);
-  }
-
-  static const wchar_t *dirs[] = { L"fomod" };
-  for (int i = 0; i < sizeof(dirs) / sizeof(wchar_t*); ++i) {
-    structure->removeDir(std::wstring(dirs[i]));
-  }
-}
-
-void DirectoryRefresher::addModBSAToStructure(
-  DirectoryEntry* root, const QString& modName,
-  int priority, const QString& directory, const QStringList& archives)
-{
-  const IPluginGame *game = qApp->property("managed_game").value<IPluginGame*>();
-
-  QStringList loadOrder;
-
-  GamePlugins* gamePlugins = game->feature<GamePlugins>();
-  if (gamePlugins) {
-    loadOrder = gamePlugins->getLoadOrder();
-  }
-
-  std::vector<std::wstring> lo;
-  for (auto&& s : loadOrder) {
-    lo.push_back(s.toStdWString());
-  }
-
-  std::vector<std::wstring> archivesW;
-  for (auto&& a : archives) {
-    archivesW.push_back(a.toStdWString());
-  }
-
-  std::set<std::wstring> enabledArchives;
-  for (auto&& a : m_EnabledArchives) {
-    enabledArchives.insert(a.toStdWString());
-  }
-
-  DirectoryStats dummy;
-
-  root->addFromAllBSAs(
-    modName.toStdWString(),
-    QDir::toNativeSeparators(directory).toStdWString(),
-    priority,
-    archivesW,
-    enabledArchives,
-    lo,
-    dummy);
-}
-
-void DirectoryRefresher::stealModFilesIntoStructure(
-  DirectoryEntry *directoryStructure, const QString &modName,
-  int priority, const QString &directory, const QStringList &stealFiles)
-{
-  std::wstring directoryW = ToWString(QDir::toNativeSeparators(directory));
-
-  // instead of adding all the files of the target directory, we just change the root of the specified
-  // files to this mod
-  DirectoryStats dummy;
-  FilesOrigin &origin = directoryStructure->createOrigin(
-    ToWString(modName), directoryW, priority, dummy);
-
-  for (const QString &filename : stealFiles) {
-    if (filename.isEmpty()) {
-      log::warn("Trying to find file with no name");
-      continue;
-    }
-    QFileInfo fileInfo(filename);
-    FileEntryPtr file = directoryStructure->findFile(ToWString(fileInfo.fileName()));
-    if (file.get() != nullptr) {
-      if (file->getOrigin() == 0) {
-        // replace data as the origin on this bsa
-        file->removeOrigin(0);
-      }
-      origin.addFile(file->getIndex());
-      file->addOrigin(origin.getID(), file->getFileTime(), L"", -1);
-    } else {
-      QString warnStr = fileInfo.absolutePath();
-      if (warnStr.isEmpty())
-        warnStr = filename;
-      log::warn("file not found: {}", warnStr);
-    }
-  }
-}
-
-void DirectoryRefresher::addModFilesToStructure(
-  DirectoryEntry *directoryStructure, const QString &modName,
-  int priority, const QString &directory, const QStringList &stealFiles)
-{
-  TimeThis tt("DirectoryRefresher::addModFilesToStructure()");
-
-  std::wstring directoryW = ToWString(QDir::toNativeSeparators(directory));
-  DirectoryStats dummy;
-
-  if (stealFiles.length() > 0) {
-    stealModFilesIntoStructure(
-      directoryStructure, modName, priority, directory, stealFiles);
-  } else {
-    directoryStructure->addFromOrigin(
-      ToWString(modName), directoryW, priority, dummy);
-  }
-}
-
-void DirectoryRefresher::addModToStructure(DirectoryEntry *directoryStructure
-  , const QString &modName
-  , int priority
-  , const QString &directory
-  , const QStringList &stealFiles
-  , const QStringList &archives)
-{
-  TimeThis tt("DirectoryRefresher::addModToStructure()");
-
-  DirectoryStats dummy;
-
-  if (stealFiles.length() > 0) {
-    stealModFilesIntoStructure(
-      directoryStructure, modName, priority, directory, stealFiles);
-  } else {
-    std::wstring directoryW = ToWString(QDir::toNativeSeparators(directory));
-    directoryStructure->addFromOrigin(
-      ToWString(modName), directoryW, priority, dummy);
-  }
-
-  if (Settings::instance().archiveParsing()) {
-    addModBSAToStructure(
-      directoryStructure, modName, priority, directory, archives);
-  }
-}
-
-
-struct ModThread
-{
-  DirectoryRefreshProgress* progress = nullptr;
-  DirectoryEntry* ds = nullptr;
-  std::wstring modName;
-  std::wstring path;
-  int prio = -1;
-  std::vector<std::wstring> archives;
-  std::set<std::wstring> enabledArchives;
-  DirectoryStats* stats =  nullptr;
-  env::DirectoryWalker walker;
-
-  std::condition_variable cv;
-  std::mutex mutex;
-  bool ready = false;
-
-  void wakeup()
-  {
-    {
-      std::scoped_lock lock(mutex);
-      ready = true;
-    }
-
-    cv.notify_one();
-  }
-
-  void run()
-  {
-    std::unique_lock lock(mutex);
-    cv.wait(lock, [&]{ return ready; });
-
-    SetThisThreadName(QString::fromStdWString(modName + L" refresher"));
-    ds->addFromOrigin(walker, modName, path, prio, *stats);
-
-    if (Settings::instance().archiveParsing()) {
-      const IPluginGame *game = qApp->property("managed_game").value<IPluginGame*>();
-
-      QStringList loadOrder;
-      GamePlugins* gamePlugins = game->feature<GamePlugins>();
-      if (gamePlugins) {
-        loadOrder = gamePlugins->getLoadOrder();
-      }
-
-      std::vector<std::wstring> lo;
-      for (auto&& s : loadOrder) {
-        lo.push_back(s.toStdWString());
-      }
-
-      ds->addFromAllBSAs(
-        modName, path, prio, archives, enabledArchives, lo, *stats);
-    }
-
-    if (progress) {
-      progress->addDone();
-    }
-
-    SetThisThreadName(QString::fromStdWString(L"idle refresher"));
-    ready = false;
-  }
-};
-
-env::ThreadPool<ModThread> g_threads;
-
-
-void DirectoryRefresher::updateProgress(const DirectoryRefreshProgress* p)
-{
-  // careful: called from multiple threads
-  emit progress(p);
-}
-
-void DirectoryRefresher::addMultipleModsFilesToStructure(
-  MOShared::DirectoryEntry *directoryStructure,
-  const std::vector<EntryInfo>& entries, DirectoryRefreshProgress* progress)
-{
-  std::vector<DirectoryStats> stats(entries.size());
-
-  if (progress) {
-    progress->start(entries.size());
-  }
-
-  log::debug("refresher: using {} threads", m_threadCount);
-  g_threads.setMax(m_threadCount);
-
-  for (std::size_t i=0; i<entries.size(); ++i) {
-    const auto& e = entries[i];
-    const int prio = e.priority + 1;
-
-    if constexpr (DirectoryStats::EnableInstrumentation) {
-      stats[i].mod = entries[i].modName.toStdString();
-    }
-
-    try
-    {
-      if (e.stealFiles.length() > 0) {
-        stealModFilesIntoStructure(
-          directoryStructure, e.modName, prio, e.absolutePath, e.stealFiles);
-
-        if (progress) {
-          progress->addDone();
-        }
-      } else {
-        auto& mt = g_threads.request();
-
-        mt.progress = progress;
-        mt.ds = directoryStructure;
-        mt.modName = e.modName.toStdWString();
-        mt.path = QDir::toNativeSeparators(e.absolutePath).toStdWString();
-        mt.prio = prio;
-
-        mt.archives.clear();
-        for (auto&& a : e.archives) {
-          mt.archives.push_back(a.toStdWString());
-        }
-
-        mt.enabledArchives.clear();
-        for (auto&& a : m_EnabledArchives) {
-          mt.enabledArchives.insert(a.toStdWString());
-        }
-
-        mt.stats = &stats[i];
-
-        mt.wakeup();
-      }
-    } catch (const std::exception& ex) {
-      emit error(tr("failed to read mod (%1): %2").arg(e.modName, ex.what()));
-    }
-  }
-
-  g_threads.waitForAll();
-
-  if constexpr (DirectoryStats::EnableInstrumentation) {
-    dumpStats(stats);
-  }
-}
-
-void DirectoryRefresher::refresh()
-{
-  SetThisThreadName("DirectoryRefresher");
-  TimeThis tt("DirectoryRefresher::refresh()");
-  auto* p = new DirectoryRefreshProgress(this);
-
-  {
-    QMutexLocker locker(&m_RefreshLock);
-
-    m_Root.reset(new DirectoryEntry(L"data", nullptr, 0));
-
-    IPluginGame *game = qApp->property("managed_game").value<IPluginGame*>();
-
-    std::wstring dataDirectory =
-      QDir::toNativeSeparators(game->dataDirectory().absolutePath()).toStdWString();
-
-    {
-      DirectoryStats dummy;
-      m_Root->addFromOrigin(L"data", dataDirectory, 0, dummy);
-    }
-
-    std::sort(m_Mods.begin(), m_Mods.end(), [](auto lhs, auto rhs) {
-      return lhs.priority < rhs.priority;
-    });
-
-    addMultipleModsFilesToStructure(m_Root.get(), m_Mods, p);
-
-    m_Root->getFileRegister()->sortOrigins();
-
-    cleanStructure(m_Root.get());
-
-    m_lastFileCount = m_Root->getFileRegister()->highestCount();
-    log::debug("refresher saw {} files", m_lastFileCount);
-  }
-
-  p->finish();
-
-  emit progress(p);
-  emit refreshed();
-}
+/*
+Copyright (C) 2012 Sebastian Herbord. All rights reserved.
+
+This file is part of Mod Organizer.
+
+Mod Organizer is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Mod Organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "directoryrefresher.h"
+#include "metrics.h"
+#include "shared/fileentry.h"
+#include "shared/filesorigin.h"
+#include "shared/directoryentry.h"
+#include "shared/archiveindex.h"
+#include "refreshtrace.h"
+#include "taskexecutor.h"
+#include "usvfsconnector.h"
+
+#include "iplugingame.h"
+#include "utility.h"
+#include "report.h"
+#include "modinfo.h"
+#include "settings.h"
+#include "envfs.h"
+#include "modinfodialogfwd.h"
+#include "shared/util.h"
+
+#include <gameplugins.h>
+
+#include <QApplication>
+#include <QDir>
+#include <QString>
+#include <QTextCodec>
+
+#include <fstream>
+
+
+using namespace MOBase;
+using namespace MOShared;
+
+
+static std::atomic<bool> g_statsEnabled(false);
+
+DirectoryStats::DirectoryStats()
+{
+  std::memset(this, 0, sizeof(DirectoryStats));
+}
+
+bool DirectoryStats::enabled()
+{
+  return g_statsEnabled.load(std::memory_order_relaxed);
+}
+
+void DirectoryStats::setEnabled(bool b)
+{
+  g_statsEnabled = b;
+}
+
+DirectoryStats& DirectoryStats::operator+=(const DirectoryStats& o)
+{
+  walkTime += o.walkTime;
+  archivesTime += o.archivesTime;
+  lockWaitTimes += o.lockWaitTimes;
+  lockWaits += o.lockWaits;
+
+  dirTimes += o.dirTimes;
+  fileTimes += o.fileTimes;
+  sortTimes += o.sortTimes;
+
+  subdirLookupTimes += o.subdirLookupTimes;
+  addDirectoryTimes += o.addDirectoryTimes;
+
+  filesLookupTimes += o.filesLookupTimes;
+  addFileTimes += o.addFileTimes;
+  addOriginToFileTimes += o.addOriginToFileTimes;
+  addFileToOriginTimes += o.addFileToOriginTimes;
+  addFileToRegisterTimes += o.addFileToRegisterTimes;
+
+  originExists += o.originExists;
+  originCreate += o.originCreate;
+  originsNeededEnabled += o.originsNeededEnabled;
+
+  subdirExists += o.subdirExists;
+  subdirCreate += o.subdirCreate;
+
+  fileExists += o.fileExists;
+  fileCreate += o.fileCreate;
+  filesInsertedInRegister += o.filesInsertedInRegister;
+  filesAssignedInRegister += o.filesAssignedInRegister;
+
+  return *this;
+}
+
+std::string DirectoryStats::csvHeader()
+{
+  QStringList sl = {
+    "dirTimes",
+    "fileTimes",
+    "sortTimes",
+    "subdirLookupTimes",
+    "addDirectoryTimes",
+    "filesLookupTimes",
+    "addFileTimes",
+    "addOriginToFileTimes",
+    "addFileToOriginTimes",
+    "addFileToRegisterTimes",
+    "originExists",
+    "originCreate",
+    "originsNeededEnabled",
+    "subdirExists",
+    "subdirCreate",
+    "fileExists",
+    "fileCreate",
+    "filesInsertedInRegister",
+    "filesAssignedInRegister"};
+
+  return sl.join(",").toStdString();
+}
+
+std::string DirectoryStats::toCsv() const
+{
+  QStringList oss;
+
+  auto s = [](auto ns) {
+    return ns.count() / 1000.0 / 1000.0 / 1000.0;
+  };
+
+  oss
+    << QString::number(s(dirTimes))
+    << QString::number(s(fileTimes))
+    << QString::number(s(sortTimes))
+
+    << QString::number(s(subdirLookupTimes))
+    << QString::number(s(addDirectoryTimes))
+
+    << QString::number(s(filesLookupTimes))
+    << QString::number(s(addFileTimes))
+    << QString::number(s(addOriginToFileTimes))
+    << QString::number(s(addFileToOriginTimes))
+    << QString::number(s(addFileToRegisterTimes))
+
+    << QString::number(originExists)
+    << QString::number(originCreate)
+    << QString::number(originsNeededEnabled)
+
+    << QString::number(subdirExists)
+    << QString::number(subdirCreate)
+
+    << QString::number(fileExists)
+    << QString::number(fileCreate)
+    << QString::number(filesInsertedInRegister)
+    << QString::number(filesAssignedInRegister);
+
+  return oss.join(",").toStdString();
+}
+
+static QStringList gameLoadOrder()
+{
+  const IPluginGame *game = qApp->property("managed_game").value<IPluginGame*>();
+
+  if (GamePlugins* gamePlugins = game->feature<GamePlugins>()) {
+    return gamePlugins->getLoadOrder();
+  }
+
+  return {};
+}
+
+void dumpStats(std::vector<DirectoryStats>& stats)
+{
+  static int run = 0;
+  static const std::string file("c:\\tmp\\data.csv");
+
+  if (run == 0) {
+    std::ofstream out(file, std::ios::out|std::ios::trunc);
+    out << fmt::format("what,run,{}", DirectoryStats::csvHeader()) << "\n";
+  }
+
+  std::sort(stats.begin(), stats.end(), [](auto&& a, auto&& b){
+    return (naturalCompare(QString::fromStdString(a.mod), QString::fromStdString(b.mod)) < 0);
+    });
+
+  std::ofstream out(file, std::ios::app);
+
+  DirectoryStats total;
+  for (const auto& s : stats) {
+    out << fmt::format("{},{},{}", s.mod, run, s.toCsv()) << "\n";
+    total += s;
+  }
+
+  out << fmt::format("total,{},{}", run, total.toCsv()) << "\n";
+
+  ++run;
+}
+
+// runs f(); when instrumentation is enabled, the time it took is added to
+// `out` and recorded as an event for the given mod in the refresh trace
+//
+template <class F>
+void timed(
+  const std::wstring& mod, const char* category,
+  std::chrono::nanoseconds& out, F&& f)
+{
+  if (!DirectoryStats::enabled()) {
+    f();
+    return;
+  }
+
+  const auto start = RefreshTrace::Clock::now();
+  f();
+  const auto d = RefreshTrace::Clock::now() - start;
+
+  out += d;
+
+  RefreshTrace::addEvent({
+    QString::fromStdWString(mod), category, start, d,
+    RefreshTrace::currentThread()});
+}
+
+
+DirectoryRefresher::DirectoryRefresher()
+  : m_lastFileCount(0)
+{
+}
+
+DirectoryEntry *DirectoryRefresher::stealDirectoryStructure()
+{
+  QMutexLocker locker(&m_RefreshLock);
+  return m_Root.release();
+}
+
+void DirectoryRefresher::setMods(const std::vector<std::tuple<QString, QString, int> > &mods
+                                 , const std::set<QString> &managedArchives)
+{
+  QMutexLocker locker(&m_RefreshLock);
+
+  m_Mods.clear();
+  for (auto mod = mods.begin(); mod != mods.end(); ++mod) {
+    QString name = std::get<0>(*mod);
+    ModInfo::Ptr info = ModInfo::getByIndex(ModInfo::getIndex(name));
+    m_Mods.push_back(EntryInfo(name, std::get<1>(*mod), info->stealFiles(), info->archives(), std::get<2>(*mod)));
+  }
+
+  m_EnabledArchives = managedArchives;
+}
+
+void DirectoryRefresher::cleanStructure(DirectoryEntry *structure)
+{
+  static const wchar_t *files[] = { L"meta.ini", L"readme.txt" };
+  for (int i = 0; i < sizeof(files) / sizeof(wchar_t*); ++i) {
+    structure->removeFile(files[i]);
+  }
+
+  static const wchar_t *dirs[] = { L"fomod" };
+  for (int i = 0; i < sizeof(dirs) / sizeof(wchar_t*); ++i) {
+    structure->removeDir(std::wstring(dirs[i]));
+  }
+}
+
+void DirectoryRefresher::rebuildConflicts(DirectoryEntry *structure)
+{
+  Metrics::Timer tt("DirectoryRefresher::rebuildConflicts()");
+  RefreshTrace::Scope scope("DirectoryRefresher::rebuildConflicts()");
+
+  structure->getFileRegister()->conflicts().rebuild(
+    ModInfo::s_HiddenExt.toStdWString());
+}
+
+void DirectoryRefresher::addModBSAToStructure(
+  DirectoryEntry* root, const QString& modName,
+  int priority, const QString& directory, const QStringList& archives)
+{
+  const IPluginGame *game = qApp->property("managed_game").value<IPluginGame*>();
+
+  QStringList loadOrder;
+
+  GamePlugins* gamePlugins = game->feature<GamePlugins>();
+  if (gamePlugins) {
+    loadOrder = gamePlugins->getLoadOrder();
+  }
+
+  std::vector<std::wstring> lo;
+  for (auto&& s : loadOrder) {
+    lo.push_back(s.toStdWString());
+  }
+
+  std::vector<std::wstring> archivesW;
+  for (auto&& a : archives) {
+    archivesW.push_back(a.toStdWString());
+  }
+
+  std::set<std::wstring> enabledArchives;
+  for (auto&& a : m_EnabledArchives) {
+    enabledArchives.insert(a.toStdWString());
+  }
+
+  DirectoryStats dummy;
+
+  root->addFromAllBSAs(
+    modName.toStdWString(),
+    QDir::toNativeSeparators(directory).toStdWString(),
+    priority,
+    archivesW,
+    enabledArchives,
+    lo,
+    dummy);
+}
+
+void DirectoryRefresher::stealModFilesIntoStructure(
+  DirectoryEntry *directoryStructure, const QString &modName,
+  int priority, const QString &directory, const QStringList &stealFiles)
+{
+  std::wstring directoryW = ToWString(QDir::toNativeSeparators(directory));
+
+  // instead of adding all the files of the target directory, we just change the root of the specified
+  // files to this mod
+  DirectoryStats dummy;
+  FilesOrigin &origin = directoryStructure->createOrigin(
+    ToWString(modName), directoryW, priority, dummy);
+
+  for (const QString &filename : stealFiles) {
+    if (filename.isEmpty()) {
+      log::warn("Trying to find file with no name");
+      continue;
+    }
+    QFileInfo fileInfo(filename);
+    FileEntryPtr file = directoryStructure->findFile(ToWString(fileInfo.fileName()));
+    if (file.get() != nullptr) {
+      if (file->getOrigin() == 0) {
+        // replace data as the origin on this bsa
+        file->removeOrigin(0);
+      }
+      origin.addFile(file->getIndex());
+      file->addOrigin(origin.getID(), file->getFileTime(), L"", -1);
+    } else {
+      QString warnStr = fileInfo.absolutePath();
+      if (warnStr.isEmpty())
+        warnStr = filename;
+      log::warn("file not found: {}", warnStr);
+    }
+  }
+}
+
+void DirectoryRefresher::addModFilesToStructure(
+  DirectoryEntry *directoryStructure, const QString &modName,
+  int priority, const QString &directory, const QStringList &stealFiles)
+{
+  Metrics::Timer tt("DirectoryRefresher::addModFilesToStructure()");
+
+  std::wstring directoryW = ToWString(QDir::toNativeSeparators(directory));
+  DirectoryStats dummy;
+
+  if (stealFiles.length() > 0) {
+    stealModFilesIntoStructure(
+      directoryStructure, modName, priority, directory, stealFiles);
+  } else {
+    directoryStructure->addFromOrigin(
+      ToWString(modName), directoryW, priority, dummy);
+  }
+}
+
+void DirectoryRefresher::addModToStructure(DirectoryEntry *directoryStructure
+  , const QString &modName
+  , int priority
+  , const QString &directory
+  , const QStringList &stealFiles
+  , const QStringList &archives)
+{
+  Metrics::Timer tt("DirectoryRefresher::addModToStructure()");
+
+  DirectoryStats dummy;
+
+  if (stealFiles.length() > 0) {
+    stealModFilesIntoStructure(
+      directoryStructure, modName, priority, directory, stealFiles);
+  } else {
+    std::wstring directoryW = ToWString(QDir::toNativeSeparators(directory));
+    directoryStructure->addFromOrigin(
+      ToWString(modName), directoryW, priority, dummy);
+  }
+
+  if (Settings::instance().archiveParsing()) {
+    addModBSAToStructure(
+      directoryStructure, modName, priority, directory, archives);
+  }
+}
+
+
+// walks the loose files of a mod into its tree, they're merged into the
+// structure once all the mods have been walked
+//
+void walkMod(
+  DirectoryEntry* ds, const std::wstring& modName, const std::wstring& path,
+  int prio, WalkedDirectory& tree, FilesOrigin*& origin,
+  DirectoryStats& stats, DirectoryRefreshProgress* progress)
+{
+  // the walker keeps its buffers between walks on the same thread
+  thread_local env::DirectoryWalker walker;
+
+  SetThisThreadName(QString::fromStdWString(modName + L" refresher"));
+
+  timed(modName, "walk", stats.walkTime, [&] {
+    NameArena::Local names(ds->getFileRegister()->names());
+    origin = &ds->walkOrigin(walker, names, modName, path, prio, tree, stats);
+  });
+
+  if (progress) {
+    progress->addDone();
+  }
+
+  SetThisThreadName(QString::fromStdWString(L"idle refresher"));
+}
+
+// number of files and directories in the given tree, used to measure the
+// throughput of the walks
+//
+std::size_t countEntries(const WalkedDirectory& d)
+{
+  std::size_t n = d.files.size() + d.dirs.size();
+
+  for (const auto& sd : d.dirs) {
+    n += countEntries(sd);
+  }
+
+  return n;
+}
+
+// whether programs started by this instance are running
+//
+bool programsRunning()
+{
+  const auto running = getRunningUSVFSProcesses();
+
+  for (auto&& h : running) {
+    ::CloseHandle(h);
+  }
+
+  return !running.empty();
+}
+
+// adds the files from the mod's archives, once the loose files have been
+// merged and the archives have been indexed
+//
+void addModArchives(
+  DirectoryEntry* ds, const DirectoryRefresher::RefreshPlan& plan,
+  std::size_t i, DirectoryStats& stats)
+{
+  const auto& m = plan.mods[i];
+
+  SetThisThreadName(QString::fromStdWString(m.name + L" refresher"));
+
+  timed(m.name, "archives", stats.archivesTime, [&] {
+    ds->addFromAllBSAs(
+      m.name, m.path, m.priority, plan.archives[i],
+      plan.enabledArchives, plan.loadOrder, stats);
+  });
+
+  SetThisThreadName(QString::fromStdWString(L"idle refresher"));
+}
+
+// parses an archive so it's in the ArchiveIndex cache by the time the
+// archives are added to the structure; archives are indexed in parallel
+// regardless of which mod they belong to, so a mod with many large archives
+// doesn't hold back the refresh
+//
+void indexArchive(const std::wstring& path)
+{
+  SetThisThreadName(QString::fromStdWString(L"archive refresher"));
+
+  {
+    RefreshTrace::Scope scope(
+      QString::fromStdWString(std::filesystem::path(path).filename().native()),
+      "index");
+
+    ArchiveIndex::get(path);
+  }
+
+  SetThisThreadName(QString::fromStdWString(L"idle refresher"));
+}
+
+// directories this deep or less are merged on the calling thread, deeper ones
+// are merged in parallel; the first levels have few files but they're shared
+// by most mods (textures, meshes, etc.), so the subtrees below them are
+// smaller and more balanced
+constexpr int ParallelMergeDepth = 2;
+
+// merges the walked trees of all the mods into the structure; subtrees are
+// disjoint, so the tasks don't contend on the same directories
+//
+void mergeWalkedTrees(
+  DirectoryEntry* directoryStructure,
+  const DirectoryEntry::MergeSources& rootSources)
+{
+  if (rootSources.empty()) {
+    return;
+  }
+
+  DirectoryStats dummy;
+
+  // merge the first levels on this thread
+  std::vector<DirectoryEntry::MergeTask> tasks = {{directoryStructure, rootSources}};
+
+  for (int depth=0; depth<ParallelMergeDepth; ++depth) {
+    std::vector<DirectoryEntry::MergeTask> next;
+
+    for (const auto& t : tasks) {
+      auto sub = t.target->merge(t.sources, dummy);
+      next.insert(
+        next.end(),
+        std::make_move_iterator(sub.begin()), std::make_move_iterator(sub.end()));
+    }
+
+    tasks = std::move(next);
+  }
+
+  // merge the subtrees in parallel
+  TaskGroup merges(TaskPriority::High);
+
+  for (const auto& t : tasks) {
+    merges.run([&t] {
+      SetThisThreadName(QString::fromStdWString(L"merge refresher"));
+
+      {
+        RefreshTrace::Scope scope(
+          QString::fromStdWString(t.target->getName()), "merge");
+
+        DirectoryStats stats;
+        t.target->mergeRecursive(t.sources, stats);
+      }
+
+      SetThisThreadName(QString::fromStdWString(L"idle refresher"));
+    });
+  }
+
+  merges.wait();
+}
+
+
+void DirectoryRefresher::updateProgress(const DirectoryRefreshProgress* p)
+{
+  // careful: called from multiple threads
+  emit progress(p);
+}
+
+const std::vector<DirectoryRefresher::Phase>& DirectoryRefresher::phases() const
+{
+  return m_phases;
+}
+
+DirectoryRefresher::RefreshPlan DirectoryRefresher::planMods(
+  const std::vector<EntryInfo>& entries)
+{
+  RefreshPlan plan;
+  plan.mods.reserve(entries.size());
+
+  for (const auto& e : entries) {
+    plan.mods.push_back({
+      e.modName.toStdWString(),
+      QDir::toNativeSeparators(e.absolutePath).toStdWString(),
+      e.priority + 1});
+  }
+
+  return plan;
+}
+
+void DirectoryRefresher::planArchives(
+  RefreshPlan& plan, const std::vector<EntryInfo>& entries) const
+{
+  for (auto&& a : m_EnabledArchives) {
+    plan.enabledArchives.insert(plan.enabledArchives.end(), a.toStdWString());
+  }
+
+  for (auto&& s : gameLoadOrder()) {
+    plan.loadOrder.push_back(s.toStdWString());
+  }
+
+  plan.archives.resize(entries.size());
+
+  for (std::size_t i=0; i<entries.size(); ++i) {
+    auto& v = plan.archives[i];
+    v.reserve(entries[i].archives.size());
+
+    for (auto&& a : entries[i].archives) {
+      v.push_back(a.toStdWString());
+    }
+  }
+}
+
+void DirectoryRefresher::addMultipleModsFilesToStructure(
+  MOShared::DirectoryEntry *directoryStructure,
+  const std::vector<EntryInfo>& entries, DirectoryRefreshProgress* progress)
+{
+  std::vector<DirectoryStats> stats(entries.size());
+
+  if (progress) {
+    progress->start(entries.size());
+  }
+
+  RefreshPlan plan = planMods(entries);
+  const bool archiveParsing = Settings::instance().archiveParsing();
+
+  // the archives are only needed once the loose files are in the structure,
+  // so their part of the plan is built while the mods are walked; it's
+  // queued before the walks so it doesn't wait behind them
+  TaskGroup planning(TaskPriority::High);
+
+  if (archiveParsing) {
+    planning.run([&] { planArchives(plan, entries); });
+  }
+
+  // filled by the threads, null origins are for mods that failed or had
+  // their files stolen
+  std::vector<WalkedDirectory> trees(entries.size());
+  std::vector<FilesOrigin*> origins(entries.size(), nullptr);
+
+  // mods that are walked, by index in `entries`, and their paths
+  std::vector<std::size_t> walked;
+  std::vector<std::wstring> paths;
+
+  for (std::size_t i=0; i<entries.size(); ++i) {
+    const auto& e = entries[i];
+    const int prio = e.priority + 1;
+
+    if (DirectoryStats::EnableInstrumentation || DirectoryStats::enabled()) {
+      stats[i].mod = entries[i].modName.toStdString();
+    }
+
+    try
+    {
+      if (e.stealFiles.length() > 0) {
+        stealModFilesIntoStructure(
+          directoryStructure, e.modName, prio, e.absolutePath, e.stealFiles);
+
+        if (progress) {
+          progress->addDone();
+        }
+      } else {
+        walked.push_back(i);
+        paths.push_back(plan.mods[i].path);
+      }
+    } catch (const std::exception& ex) {
+      emit error(tr("failed to read mod (%1): %2").arg(e.modName, ex.what()));
+    }
+  }
+
+  // programs started from here are running on the files being walked, the
+  // refresh shouldn't make them stutter
+  const bool background = programsRunning();
+
+  m_Volumes.run(paths, background, [&](std::size_t w) {
+    const std::size_t i = walked[w];
+    const auto& m = plan.mods[i];
+
+    walkMod(
+      directoryStructure, m.name, m.path,
+      m.priority, trees[i], origins[i], stats[i], progress);
+
+    return countEntries(trees[i]);
+  });
+
+  {
+    RefreshTrace::Scope scope("merge");
+
+    DirectoryEntry::MergeSources sources;
+
+    for (std::size_t i=0; i<trees.size(); ++i) {
+      if (origins[i]) {
+        sources.push_back({origins[i], &trees[i]});
+      }
+    }
+
+    mergeWalkedTrees(directoryStructure, sources);
+  }
+
+  // the origins keep their trees so they can be restored without walking
+  // them when they're disabled and enabled again, see refreshIncremental()
+  for (std::size_t i=0; i<trees.size(); ++i) {
+    if (origins[i]) {
+      origins[i]->setWalkedTree(
+        std::make_shared<const WalkedDirectory>(std::move(trees[i])));
+    }
+  }
+
+  trees = {};
+
+  // the plan is also read by the task until it's done
+  planning.wait();
+
+  if (archiveParsing) {
+    addMultipleModsArchivesToStructure(directoryStructure, plan, origins, stats);
+  }
+
+  if (DirectoryStats::enabled()) {
+    for (const auto& s : stats) {
+      RefreshTrace::addMod({
+        QString::fromStdString(s.mod),
+        s.walkTime, s.archivesTime, s.lockWaitTimes,
+        s.fileCreate + s.fileExists,
+        s.subdirCreate + s.subdirExists});
+    }
+  }
+
+  if constexpr (DirectoryStats::EnableInstrumentation) {
+    dumpStats(stats);
+  }
+}
+
+void DirectoryRefresher::addMultipleModsArchivesToStructure(
+  MOShared::DirectoryEntry *directoryStructure,
+  const RefreshPlan& plan,
+  const std::vector<FilesOrigin*>& origins,
+  std::vector<DirectoryStats>& stats)
+{
+  std::vector<const std::wstring*> archives;
+
+  for (std::size_t i=0; i<plan.mods.size(); ++i) {
+    if (!origins[i]) {
+      continue;
+    }
+
+    for (const auto& path : plan.archives[i]) {
+      const auto filename = std::filesystem::path(path).filename().native();
+
+      if (plan.enabledArchives.contains(filename)) {
+        archives.push_back(&path);
+      }
+    }
+  }
+
+  // index all the archives in parallel, unchanged ones are already in the
+  // cache
+  {
+    RefreshTrace::Scope scope("index archives");
+    TaskGroup indexing(TaskPriority::High);
+
+    for (const auto* a : archives) {
+      indexing.run([a] { indexArchive(*a); });
+    }
+
+    indexing.wait();
+  }
+
+  // add the archives to the structure, this doesn't read them anymore
+  TaskGroup adds(TaskPriority::High);
+
+  for (std::size_t i=0; i<plan.mods.size(); ++i) {
+    if (!origins[i]) {
+      continue;
+    }
+
+    adds.run([=, &plan, &stats] {
+      addModArchives(directoryStructure, plan, i, stats[i]);
+    });
+  }
+
+  adds.wait();
+}
+
+void DirectoryRefresher::restoreMultipleModsToStructure(
+  MOShared::DirectoryEntry *directoryStructure,
+  const std::vector<EntryInfo>& entries)
+{
+  // the trees are shared with the origins, this keeps them alive even if an
+  // origin forgets its tree during the merge
+  std::vector<std::shared_ptr<const WalkedDirectory>> trees;
+  std::vector<FilesOrigin*> origins;
+  DirectoryEntry::MergeSources sources;
+
+  RefreshPlan plan = planMods(entries);
+
+  for (const auto& m : plan.mods) {
+    FilesOrigin& origin = directoryStructure->getOriginByName(m.name);
+
+    auto tree = origin.walkedTree();
+    origin.enable(true);
+
+    sources.push_back({&origin, tree.get()});
+    origins.push_back(&origin);
+    trees.push_back(std::move(tree));
+  }
+
+  {
+    RefreshTrace::Scope scope("restore");
+    mergeWalkedTrees(directoryStructure, sources);
+  }
+
+  if (Settings::instance().archiveParsing()) {
+    planArchives(plan, entries);
+
+    std::vector<DirectoryStats> stats(entries.size());
+    addMultipleModsArchivesToStructure(directoryStructure, plan, origins, stats);
+  }
+}
+
+bool DirectoryRefresher::refreshIncremental(
+  DirectoryEntry* root, const ChangeJournal::Changes* known)
+{
+  Metrics::Timer tt("DirectoryRefresher::refreshIncremental()");
+  RefreshTrace::Scope scope("DirectoryRefresher::refreshIncremental()");
+  QMutexLocker locker(&m_RefreshLock);
+
+  if (root == nullptr || !root->isPopulated()) {
+    return false;
+  }
+
+  if (Settings::instance().archiveParsing()) {
+    if (m_EnabledArchives != m_RefreshedArchives ||
+        gameLoadOrder() != m_RefreshedLoadOrder) {
+      log::debug("incremental refresh: archives or load order have changed");
+      return false;
+    }
+  }
+
+  // the data directory is the base of everything and stolen files come from
+  // it, it can't be walked again without rebuilding the structure
+  const FilesOrigin* data = root->findOriginByID(0);
+  if (!data || !data->hasDirectoryStamps() || data->directoriesChanged()) {
+    log::debug("incremental refresh: data directory has changed");
+    return false;
+  }
+
+  // whether the origin must be walked again; origins that were disabled
+  // were not checked by the previous refreshes, so their stamps are always
+  // checked in addition to the journal
+  auto modified = [&](const FilesOrigin& origin, const std::wstring& path) {
+    if (!origin.hasDirectoryStamps()) {
+      return true;
+    }
+
+    if (known) {
+      const auto lcPath = ToLowerCopy(path);
+
+      if (known->covers(lcPath)) {
+        // the journal also sees files that were modified in place, which
+        // don't change the directory times
+        if (known->changed(lcPath)) {
+          return true;
+        }
+
+        if (!origin.isDisabled()) {
+          return false;
+        }
+      }
+    }
+
+    return origin.directoriesChanged();
+  };
+
+  std::set<std::wstring> wanted = {data->getName()};
+  std::vector<EntryInfo> changed;
+  std::vector<EntryInfo> restored;
+
+  for (const auto& e : m_Mods) {
+    const auto name = e.modName.toStdWString();
+    wanted.insert(name);
+
+    if (!root->originExists(name)) {
+      changed.push_back(e);
+      continue;
+    }
+
+    const FilesOrigin& origin = root->getOriginByName(name);
+    const auto path = QDir::toNativeSeparators(e.absolutePath).toStdWString();
+
+    if (origin.getPath() != path) {
+      log::debug(
+        "incremental refresh: path for origin '{}' has changed", e.modName);
+      return false;
+    }
+
+    if (origin.isDisabled()) {
+      // the origin still has the files from its last walk if it was disabled
+      // by a previous refresh, such as when switching profiles
+      if (e.stealFiles.isEmpty() && origin.walkedTree() &&
+          !modified(origin, path)) {
+        restored.push_back(e);
+      } else {
+        changed.push_back(e);
+      }
+    } else if (e.stealFiles.isEmpty()) {
+      if (modified(origin, path)) {
+        changed.push_back(e);
+      }
+    }
+  }
+
+  std::vector<FilesOrigin*> removed;
+  bool stolen = false;
+
+  root->getOriginConnection()->forEachOrigin([&](FilesOrigin& o) {
+    if (!o.isDisabled() && !wanted.contains(o.getName())) {
+      // origins without stamps steal files from the data directory, which
+      // can only be given back by walking it again
+      if (!o.hasDirectoryStamps()) {
+        stolen = true;
+      }
+
+      removed.push_back(&o);
+    }
+  });
+
+  if (stolen) {
+    log::debug("incremental refresh: an origin with stolen files was removed");
+    return false;
+  }
+
+  // walking many mods from scratch in parallel is faster than removing them
+  // and walking them again; removed and restored origins don't touch the
+  // disk, they're not counted
+  if (changed.size() > (m_Mods.size() / 2 + 1)) {
+    log::debug(
+      "incremental refresh: too many changes ({} changed, {} removed, "
+      "{} restored)", changed.size(), removed.size(), restored.size());
+
+    return false;
+  }
+
+  log::debug(
+    "incremental refresh: {} changed, {} removed, {} restored",
+    changed.size(), removed.size(), restored.size());
+
+  for (auto* o : removed) {
+    o->enable(false);
+  }
+
+  for (const auto& e : m_Mods) {
+    const auto name = e.modName.toStdWString();
+
+    if (root->originExists(name)) {
+      FilesOrigin& origin = root->getOriginByName(name);
+
+      // priorities in the directory structure are one higher because data
+      // is 0
+      origin.setPriority(e.priority + 1);
+    }
+  }
+
+  for (const auto& e : changed) {
+    const auto name = e.modName.toStdWString();
+
+    if (root->originExists(name)) {
+      FilesOrigin& origin = root->getOriginByName(name);
+
+      if (!origin.isDisabled()) {
+        origin.enable(false);
+      }
+    }
+  }
+
+  if (!restored.empty()) {
+    restoreMultipleModsToStructure(root, restored);
+  }
+
+  if (!changed.empty()) {
+    addMultipleModsFilesToStructure(root, changed);
+  }
+
+  root->getFileRegister()->sortOrigins();
+  cleanStructure(root);
+  rebuildConflicts(root);
+
+  // does nothing unless archives of mods that changed were parsed
+  ArchiveIndex::save();
+
+  m_lastFileCount = root->getFileRegister()->highestCount();
+  log::debug("refresher saw {} files", m_lastFileCount);
+
+  return true;
+}
+
+void DirectoryRefresher::refresh()
+{
+  SetThisThreadName("DirectoryRefresher");
+  Metrics::Timer tt("DirectoryRefresher::refresh()");
+  RefreshTrace::Scope scope("DirectoryRefresher::refresh()");
+  auto* p = new DirectoryRefreshProgress(this);
+
+  {
+    QMutexLocker locker(&m_RefreshLock);
+
+    m_phases.clear();
+
+    auto phase = [&](const char* name, auto&& f) {
+      const auto start = std::chrono::steady_clock::now();
+      f();
+      m_phases.push_back({name, std::chrono::steady_clock::now() - start});
+    };
+
+    m_Root.reset(new DirectoryEntry(L"data", nullptr, 0));
+
+    IPluginGame *game = qApp->property("managed_game").value<IPluginGame*>();
+
+    std::wstring dataDirectory =
+      QDir::toNativeSeparators(game->dataDirectory().absolutePath()).toStdWString();
+
+    phase("data", [&] {
+      m_DataCache.setFilename(
+        Settings::instance().paths().cache() + "/datadirectory.cache");
+
+      DirectoryStats dummy;
+      if (m_DataCache.addToStructure(*m_Root, L"data", dataDirectory, 0, dummy)) {
+        log::debug("data directory hasn't changed, using the cache");
+      } else {
+        m_DataCache.save();
+      }
+    });
+
+    std::sort(m_Mods.begin(), m_Mods.end(), [](auto lhs, auto rhs) {
+      return lhs.priority < rhs.priority;
+    });
+
+    m_RefreshedArchives = m_EnabledArchives;
+    m_RefreshedLoadOrder = gameLoadOrder();
+
+    phase("mods", [&] {
+      addMultipleModsFilesToStructure(m_Root.get(), m_Mods, p);
+    });
+
+    if (Settings::instance().archiveParsing()) {
+      // drop the archives that are not used by any mod anymore
+      std::vector<std::wstring> archives;
+
+      for (const auto& m : m_Mods) {
+        for (auto&& a : m.archives) {
+          archives.push_back(a.toStdWString());
+        }
+      }
+
+      ArchiveIndex::prune(archives);
+      ArchiveIndex::save();
+    }
+
+    phase("sort", [&] { m_Root->getFileRegister()->sortOrigins(); });
+    phase("clean", [&] { cleanStructure(m_Root.get()); });
+    phase("conflicts", [&] { rebuildConflicts(m_Root.get()); });
+
+    m_lastFileCount = m_Root->getFileRegister()->highestCount();
+    log::debug("refresher saw {} files", m_lastFileCount);
+  }
+
+  p->finish();
+
+  emit progress(p);
+  emit refreshed();
+}
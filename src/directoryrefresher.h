@@ -1,214 +1,334 @@
-/*
-Copyright (C) 2012 Sebastian Herbord. All rights reserved.
-
-This file is part of Mod Organizer.
-
-Mod Organizer is free software: you can redistribute it and/or modify
-it under the terms of the GNU General Public License as published by
-the Free Software Foundation, either version 3 of the License, or
-(at your option) any later version.
-
-Mod Organizer is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#ifndef DIRECTORYREFRESHER_H
-#define DIRECTORYREFRESHER_H
-
-#include "shared/fileregisterfwd.h"
-#include "profile.h"
-#include <QObject>
-#include <QMutex>
-#include <QStringList>
-#include <vector>
-#include <set>
-#include <tuple>
-
-/**
- * @brief used to asynchronously generate the virtual view of the combined data directory
- **/
-class DirectoryRefresher : public QObject
-{
-
-  Q_OBJECT
-
-public:
-  struct EntryInfo
-  {
-    EntryInfo(const QString &modName, const QString &absolutePath,
-      const QStringList &stealFiles, const QStringList &archives, int priority)
-      : modName(modName), absolutePath(absolutePath), stealFiles(stealFiles)
-      , archives(archives), priority(priority)
-    {
-    }
-
-    QString modName;
-    QString absolutePath;
-    QStringList stealFiles;
-    QStringList archives;
-    int priority;
-  };
-
-  DirectoryRefresher(std::size_t threadCount);
-
-  // noncopyable
-  DirectoryRefresher(const DirectoryRefresher&) = delete;
-  DirectoryRefresher& operator=(const DirectoryRefresher&) = delete;
-
-  /**
-   * @brief retrieve the updated directory structure
-   *
-   * returns a pointer to the updated directory structure. DirectoryRefresher
-   * deletes its own pointer and the caller takes custody of the pointer
-   *
-   * @return updated directory structure
-   **/
-  MOShared::DirectoryEntry* stealDirectoryStructure();
-
-  /**
-   * @brief sets up the mods to be included in the directory structure
-   *
-   * @param mods list of the mods to include
-   **/
-  void setMods(const std::vector<std::tuple<QString, QString, int> > &mods, const std::set<QString> &managedArchives);
-
-  /**
-   * @brief sets up the directory where mods are stored
-   * @param modDirectory the mod directory
-   * @note this function could be obsoleted easily by storing absolute paths in the parameter to setMods. This is legacy
-   */
-  void setModDirectory(const QString &modDirectory);
-
-  /**
-   * @brief remove files from the directory structure that are known to be irrelevant to the game
-   * @param the structure to clean
-   */
-  static void cleanStructure(MOShared::DirectoryEntry *structure);
-
-  /**
-   * @brief add files for a mod to the directory structure, including bsas
-   * @param directoryStructure
-   * @param modName
-   * @param priority
-   * @param directory
-   * @param stealFiles
-   * @param archives
-   */
-  void addModToStructure(MOShared::DirectoryEntry *directoryStructure, const QString &modName, int priority, const QString &directory, const QStringList &stealFiles, const QStringList &archives);
-
-  /**
-   * @brief add only the bsas of a mod to the directory structure
-   * @param directoryStructure
-   * @param modName
-   * @param priority
-   * @param directory
-   * @param archives
-   */
-  void addModBSAToStructure(MOShared::DirectoryEntry *directoryStructure, const QString &modName, int priority, const QString &directory, const QStringList &archives);
-
-  /**
-   * @brief add only regular files ofr a mod to the directory structure
-   * @param directoryStructure
-   * @param modName
-   * @param priority
-   * @param directory
-   * @param stealFiles
-   */
-  void addModFilesToStructure(
-    MOShared::DirectoryEntry *directoryStructure, const QString &modName,
-    int priority, const QString &directory, const QStringList &stealFiles);
-
-  void addMultipleModsFilesToStructure(
-    MOShared::DirectoryEntry *directoryStructure,
-    const std::vector<EntryInfo>& entries,
-    DirectoryRefreshProgress* progress=nullptr);
-
-  void updateProgress(const DirectoryRefreshProgress* p);
-
-public slots:
-
-  /**
-   * @brief generate a directory structure from the mods set earlier
-   **/
-  void refresh();
-
-signals:
-
-  void progress(const DirectoryRefreshProgress* p);
-  void error(const QString &error);
-  void refreshed();
-
-private:
-  std::vector<EntryInfo> m_Mods;
-  std::set<QString> m_EnabledArchives;
-  std::unique_ptr<MOShared::DirectoryEntry> m_Root;
-  QMutex m_RefreshLock;
-  std::size_t m_threadCount;
-  std::size_t m_lastFileCount;
-
-  void stealModFilesIntoStructure(
-    MOShared::DirectoryEntry *directoryStructure, const QString &modName,
-    int priority, const QString &directory, const QStringList &stealFiles);
-};
-
-
-class DirectoryRefreshProgress : QObject
-{
-  Q_OBJECT;
-
-public:
-  DirectoryRefreshProgress(DirectoryRefresher* r) :
-    QObject(r), m_refresher(r), m_modCount(0), m_modDone(0), m_finished(false)
-  {
-  }
-
-  void start(std::size_t modCount)
-  {
-    m_modCount = modCount;
-    m_modDone = 0;
-    m_finished = false;
-  }
-
-
-  bool finished() const
-  {
-    return m_finished;
-  }
-
-  int percentDone() const
-  {
-    int percent = 100;
-
-    if (m_modCount > 0) {
-      const double d = static_cast<double>(m_modDone) / m_modCount;
-      percent = static_cast<int>(d * 100);
-    }
-
-    return percent;
-  }
-
-
-  void finish()
-  {
-    m_finished = true;
-  }
-
-  void addDone()
-  {
-    ++m_modDone;
-    m_refresher->updateProgress(this);
-  }
-
-private:
-  DirectoryRefresher* m_refresher;
-  std::size_t m_modCount;
-  std::atomic<std::size_t> m_modDone;
-  bool m_finished;
-};
-
-#endif // DIRECTORYREFRESHER_H
+/*
+Copyright (C) 2012 Sebastian Herbord. All rights reserved.
+
+This file is part of Mod Organizer.
+
+Mod Organizer is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Mod Organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIRECTORYREFRESHER_H
+#define DIRECTORYREFRESHER_H
+
+#include "shared/fileregisterfwd.h"
+#include "changejournal.h"
+#include "datadirectorycache.h"
+#include "volumescheduler.h"
+#include "profile.h"
+#include <QObject>
+#include <QMutex>
+#include <QStringList>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <set>
+#include <tuple>
+
+/**
+ * @brief used to asynchronously generate the virtual view of the combined data directory
+ **/
+class DirectoryRefresher : public QObject
+{
+
+  Q_OBJECT
+
+public:
+  struct EntryInfo
+  {
+    EntryInfo(const QString &modName, const QString &absolutePath,
+      const QStringList &stealFiles, const QStringList &archives, int priority)
+      : modName(modName), absolutePath(absolutePath), stealFiles(stealFiles)
+      , archives(archives), priority(priority)
+    {
+    }
+
+    QString modName;
+    QString absolutePath;
+    QStringList stealFiles;
+    QStringList archives;
+    int priority;
+  };
+
+  // name and duration of a phase of refresh()
+  using Phase = std::pair<QString, std::chrono::nanoseconds>;
+
+  DirectoryRefresher();
+
+  // noncopyable
+  DirectoryRefresher(const DirectoryRefresher&) = delete;
+  DirectoryRefresher& operator=(const DirectoryRefresher&) = delete;
+
+  /**
+   * @brief retrieve the updated directory structure
+   *
+   * returns a pointer to the updated directory structure. DirectoryRefresher
+   * deletes its own pointer and the caller takes custody of the pointer
+   *
+   * @return updated directory structure
+   **/
+  MOShared::DirectoryEntry* stealDirectoryStructure();
+
+  /**
+   * @brief sets up the mods to be included in the directory structure
+   *
+   * @param mods list of the mods to include
+   **/
+  void setMods(const std::vector<std::tuple<QString, QString, int> > &mods, const std::set<QString> &managedArchives);
+
+  /**
+   * @brief sets up the directory where mods are stored
+   * @param modDirectory the mod directory
+   * @note this function could be obsoleted easily by storing absolute paths in the parameter to setMods. This is legacy
+   */
+  void setModDirectory(const QString &modDirectory);
+
+  /**
+   * @brief remove files from the directory structure that are known to be irrelevant to the game
+   * @param the structure to clean
+   */
+  static void cleanStructure(MOShared::DirectoryEntry *structure);
+
+  /**
+   * @brief recomputes the conflicts between all the mods of the structure,
+   *        must be called once the structure is complete and sorted
+   * @param the structure to update
+   */
+  static void rebuildConflicts(MOShared::DirectoryEntry *structure);
+
+  /**
+   * @brief add files for a mod to the directory structure, including bsas
+   * @param directoryStructure
+   * @param modName
+   * @param priority
+   * @param directory
+   * @param stealFiles
+   * @param archives
+   */
+  void addModToStructure(MOShared::DirectoryEntry *directoryStructure, const QString &modName, int priority, const QString &directory, const QStringList &stealFiles, const QStringList &archives);
+
+  /**
+   * @brief add only the bsas of a mod to the directory structure
+   * @param directoryStructure
+   * @param modName
+   * @param priority
+   * @param directory
+   * @param archives
+   */
+  void addModBSAToStructure(MOShared::DirectoryEntry *directoryStructure, const QString &modName, int priority, const QString &directory, const QStringList &archives);
+
+  /**
+   * @brief add only regular files ofr a mod to the directory structure
+   * @param directoryStructure
+   * @param modName
+   * @param priority
+   * @param directory
+   * @param stealFiles
+   */
+  void addModFilesToStructure(
+    MOShared::DirectoryEntry *directoryStructure, const QString &modName,
+    int priority, const QString &directory, const QStringList &stealFiles);
+
+  void addMultipleModsFilesToStructure(
+    MOShared::DirectoryEntry *directoryStructure,
+    const std::vector<EntryInfo>& entries,
+    DirectoryRefreshProgress* progress=nullptr);
+
+  /**
+   * @brief everything the workers of a refresh need from the mods, converted
+   *        once before they start and only read while they run
+   *
+   * the names and paths are needed by the walks and are built first; the
+   * archives, the enabled archives and the load order are only needed once
+   * the loose files are in the structure, see planArchives()
+   */
+  struct RefreshPlan
+  {
+    struct Mod
+    {
+      std::wstring name;
+
+      // with native separators
+      std::wstring path;
+
+      // in the structure, one higher than the mod's because data is 0
+      int priority = 0;
+    };
+
+    // same order as the entries the plan was made from
+    std::vector<Mod> mods;
+
+    // archives of each mod, same order as `mods`
+    std::vector<std::vector<std::wstring>> archives;
+
+    std::set<std::wstring> enabledArchives;
+    std::vector<std::wstring> loadOrder;
+  };
+
+  /**
+   * @brief fills the names, paths and priorities of the plan
+   */
+  static RefreshPlan planMods(const std::vector<EntryInfo>& entries);
+
+  /**
+   * @brief fills the archive part of the plan, can run on another thread
+   *        while the mods are walked
+   */
+  void planArchives(
+    RefreshPlan& plan, const std::vector<EntryInfo>& entries) const;
+
+  /**
+   * @brief adds the archives of the given mods after their loose files
+   *
+   * all the archives are indexed in parallel first, see
+   * MOShared::ArchiveIndex, then each mod's archives are added to the
+   * structure; mods with a null origin are skipped
+   */
+  void addMultipleModsArchivesToStructure(
+    MOShared::DirectoryEntry *directoryStructure,
+    const RefreshPlan& plan,
+    const std::vector<MOShared::FilesOrigin*>& origins,
+    std::vector<MOShared::DirectoryStats>& stats);
+
+  /**
+   * @brief enables the given disabled mods again and merges the files from
+   *        their last walk, without walking them
+   *
+   * the origins must exist and have a walked tree, see
+   * MOShared::FilesOrigin::walkedTree(); their archives are added again
+   */
+  void restoreMultipleModsToStructure(
+    MOShared::DirectoryEntry *directoryStructure,
+    const std::vector<EntryInfo>& entries);
+
+  /**
+   * @brief updates the given structure in place instead of rebuilding it
+   *
+   * only the origins that have changed on disk since they were last walked,
+   * along with the ones that were enabled or disabled since, are updated;
+   * origins that are enabled again and haven't changed are restored from
+   * their last walk, so switching between profiles that use the same mods
+   * doesn't walk anything; this uses the mods given in setMods() and must not
+   * run concurrently with refresh()
+   *
+   * @param root the structure to update
+   * @param known what changed on disk since the structure was last updated,
+   *        if it's known; origins it covers are not checked for changes
+   * @return false if the structure cannot be updated incrementally, in which
+   *         case it is left untouched and a full refresh is required
+   **/
+  bool refreshIncremental(
+    MOShared::DirectoryEntry* root,
+    const ChangeJournal::Changes* known=nullptr);
+
+  void updateProgress(const DirectoryRefreshProgress* p);
+
+  /**
+   * @brief durations of the phases of the last refresh(); they are always
+   *        collected and must only be read once refreshed() was emitted
+   **/
+  const std::vector<Phase>& phases() const;
+
+public slots:
+
+  /**
+   * @brief generate a directory structure from the mods set earlier
+   **/
+  void refresh();
+
+signals:
+
+  void progress(const DirectoryRefreshProgress* p);
+  void error(const QString &error);
+  void refreshed();
+
+private:
+  std::vector<EntryInfo> m_Mods;
+  std::set<QString> m_EnabledArchives;
+  std::unique_ptr<MOShared::DirectoryEntry> m_Root;
+  QMutex m_RefreshLock;
+  std::size_t m_lastFileCount;
+  std::vector<Phase> m_phases;
+
+  // the game's data directory, only walked again when it changes
+  DataDirectoryCache m_DataCache;
+
+  // concurrency of the walks for each volume mods are on
+  VolumeScheduler m_Volumes;
+
+  // archive state used by the last full refresh; archive orders in the
+  // structure depend on it, so an incremental refresh is not possible when it
+  // changes
+  std::set<QString> m_RefreshedArchives;
+  QStringList m_RefreshedLoadOrder;
+
+  void stealModFilesIntoStructure(
+    MOShared::DirectoryEntry *directoryStructure, const QString &modName,
+    int priority, const QString &directory, const QStringList &stealFiles);
+};
+
+
+class DirectoryRefreshProgress : QObject
+{
+  Q_OBJECT;
+
+public:
+  DirectoryRefreshProgress(DirectoryRefresher* r) :
+    QObject(r), m_refresher(r), m_modCount(0), m_modDone(0), m_finished(false)
+  {
+  }
+
+  void start(std::size_t modCount)
+  {
+    m_modCount = modCount;
+    m_modDone = 0;
+    m_finished = false;
+  }
+
+
+  bool finished() const
+  {
+    return m_finished;
+  }
+
+  int percentDone() const
+  {
+    int percent = 100;
+
+    if (m_modCount > 0) {
+      const double d = static_cast<double>(m_modDone) / m_modCount;
+      percent = static_cast<int>(d * 100);
+    }
+
+    return percent;
+  }
+
+
+  void finish()
+  {
+    m_finished = true;
+  }
+
+  void addDone()
+  {
+    ++m_modDone;
+    m_refresher->updateProgress(this);
+  }
+
+private:
+  DirectoryRefresher* m_refresher;
+  std::size_t m_modCount;
+  std::atomic<std::size_t> m_modDone;
+  bool m_finished;
+};
+
+#endif // DIRECTORYREFRESHER_H
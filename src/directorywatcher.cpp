@@ -0,0 +1,135 @@
+#include "directorywatcher.h"
+#include "changejournal.h"
+#include <log.h>
+#include <QDir>
+
+using namespace MOBase;
+
+// how long changes are collected after the first one before being reported
+static constexpr std::chrono::milliseconds BatchDelay(500);
+
+// how long changes are still dropped after a suppression ended, long enough
+// for the system to report what MO itself did
+static constexpr std::chrono::milliseconds SuppressionGrace(250);
+
+
+void WatcherSuppression::start()
+{
+  ++m_count;
+}
+
+void WatcherSuppression::end()
+{
+  if (m_count > 0) {
+    --m_count;
+  }
+
+  if (m_count == 0) {
+    m_ended = std::chrono::steady_clock::now();
+  }
+}
+
+bool WatcherSuppression::active() const
+{
+  if (m_count > 0) {
+    return true;
+  }
+
+  return (std::chrono::steady_clock::now() - m_ended) < SuppressionGrace;
+}
+
+
+DirectoryWatcher::DirectoryWatcher(QObject* parent)
+  : QObject(parent), m_suppression(nullptr)
+{
+  m_timer.setSingleShot(true);
+  m_timer.setInterval(BatchDelay);
+
+  connect(&m_timer, &QTimer::timeout, [&]{ flush(); });
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+  // joins the threads before anything else is destroyed, they post to this
+  m_journal.reset();
+}
+
+void DirectoryWatcher::watch(const QStringList& dirs)
+{
+  m_journal.reset();
+
+  if (dirs.isEmpty()) {
+    return;
+  }
+
+  m_journal = std::make_unique<ChangeJournal>();
+
+  m_journal->setListener([this](auto&& root, auto&& paths) {
+    post(root, std::move(paths));
+  });
+
+  for (const auto& d : dirs) {
+    m_journal->watch(QDir::toNativeSeparators(d).toStdWString(), false);
+  }
+}
+
+void DirectoryWatcher::setSuppression(const WatcherSuppression* s)
+{
+  m_suppression = s;
+}
+
+void DirectoryWatcher::post(const std::wstring& root, std::vector<std::wstring> paths)
+{
+  QMetaObject::invokeMethod(this, [this, root, paths=std::move(paths)] {
+    onPosted(root, paths);
+  }, Qt::QueuedConnection);
+}
+
+void DirectoryWatcher::onPosted(
+  const std::wstring& root, const std::vector<std::wstring>& paths)
+{
+  if (m_suppression && m_suppression->active()) {
+    return;
+  }
+
+  auto& b = m_pending[root];
+
+  if (paths.empty()) {
+    b.lost = true;
+  } else {
+    b.paths.insert(paths.begin(), paths.end());
+  }
+
+  // not restarted by later changes, a program that keeps writing must not
+  // delay the notification forever
+  if (!m_timer.isActive()) {
+    m_timer.start();
+  }
+}
+
+void DirectoryWatcher::flush()
+{
+  if (m_suppression && m_suppression->active()) {
+    // MO is writing to the directories, tried again once it's done so the
+    // changes collected before aren't lost
+    m_timer.start();
+    return;
+  }
+
+  const auto pending = std::move(m_pending);
+  m_pending.clear();
+
+  for (auto&& [root, b] : pending) {
+    QStringList paths;
+
+    if (!b.lost) {
+      paths.reserve(static_cast<int>(b.paths.size()));
+
+      for (const auto& p : b.paths) {
+        paths.push_back(QString::fromStdWString(p));
+      }
+    }
+
+    emit changed(QString::fromStdWString(root), paths);
+  }
+}
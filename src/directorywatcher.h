@@ -0,0 +1,91 @@
+#ifndef MODORGANIZER_DIRECTORYWATCHER_INCLUDED
+#define MODORGANIZER_DIRECTORYWATCHER_INCLUDED
+
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+class ChangeJournal;
+
+// drops the changes reported while MO itself writes to a watched directory,
+// see DirectoryWatcher::setSuppression(); start() and end() can be nested and
+// must be called from the ui thread
+//
+// the system reports changes asynchronously, so the changes delivered
+// shortly after the last end() are dropped as well
+//
+class WatcherSuppression
+{
+public:
+  void start();
+  void end();
+
+  // whether changes are dropped right now
+  //
+  bool active() const;
+
+private:
+  int m_count = 0;
+  std::chrono::steady_clock::time_point m_ended;
+};
+
+
+// watches directories recursively and reports what changed in them on the ui
+// thread, in batches: changes are collected for a short while after the
+// first one, so a program writing many files gives a single notification
+//
+// the directories are watched by a ChangeJournal; changes can also be posted
+// by another journal, such as the one OrganizerCore restarts on each refresh
+//
+class DirectoryWatcher : public QObject
+{
+  Q_OBJECT;
+
+public:
+  DirectoryWatcher(QObject* parent=nullptr);
+  ~DirectoryWatcher();
+
+  // replaces the watched directories, empty to stop watching
+  //
+  void watch(const QStringList& dirs);
+
+  // changes delivered while the suppression is active are dropped; it must
+  // outlive the watcher, null to report everything
+  //
+  void setSuppression(const WatcherSuppression* s);
+
+  // batch of changes in the given root, with lowercase native paths relative
+  // to it; an empty list means changes were lost; this can be called from
+  // any thread, such as from a ChangeJournal::Listener
+  //
+  void post(const std::wstring& root, std::vector<std::wstring> paths);
+
+signals:
+  // `root` is lowercase and native, `paths` are relative to it; an empty list
+  // means changes were lost and anything in the root may have changed
+  //
+  void changed(const QString& root, const QStringList& paths);
+
+private:
+  struct Batch
+  {
+    std::set<std::wstring> paths;
+    bool lost = false;
+  };
+
+  std::unique_ptr<ChangeJournal> m_journal;
+  const WatcherSuppression* m_suppression;
+  std::map<std::wstring, Batch> m_pending;
+  QTimer m_timer;
+
+  void onPosted(const std::wstring& root, const std::vector<std::wstring>& paths);
+  void flush();
+};
+
+#endif // MODORGANIZER_DIRECTORYWATCHER_INCLUDED
@@ -28,14 +28,23 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QColor>
 #include <QIcon>
 #include <QSortFilterProxyModel>
+#include <map>
 
 using namespace MOBase;
 
+
 DownloadList::DownloadList(OrganizerCore& core, QObject *parent)
   : QAbstractTableModel(parent), m_manager(*core.downloadManager()), m_settings(core.settings())
 {
-  connect(&m_manager, SIGNAL(update(int)), this, SLOT(update(int)));
-  connect(&m_manager, SIGNAL(aboutToUpdate()), this, SLOT(aboutToUpdate()));
+  m_timer.setSingleShot(true);
+  m_timer.setInterval(UpdateInterval);
+  connect(&m_timer, &QTimer::timeout, [&]{ updateChanged(); });
+
+  connect(&m_manager, &DownloadManager::update, this, &DownloadList::update);
+  connect(&m_manager, &DownloadManager::progressChanged, this, &DownloadList::updateProgress);
+  connect(&m_manager, &DownloadManager::stateChanged, [&](int row, DownloadManager::DownloadState) { update(row); });
+
+  rebuild();
 }
 
 
@@ -43,7 +52,7 @@ int DownloadList::rowCount(const QModelIndex& parent) const
 {
   if (!parent.isValid()) {
     // root item
-    return m_manager.numTotalDownloads() + m_manager.numPendingDownloads();
+    return static_cast<int>(m_rows.size());
   } else {
     return 0;
   }
@@ -100,12 +109,25 @@ QMimeData* DownloadList::mimeData(const QModelIndexList& indexes) const
   return result;
 }
 
+const DownloadList::Row* DownloadList::row(int i) const
+{
+  if (i < 0 || i >= static_cast<int>(m_rows.size())) {
+    return nullptr;
+  }
+
+  return &m_rows[i];
+}
+
 QVariant DownloadList::data(const QModelIndex &index, int role) const
 {
-  bool pendingDownload = index.row() >= m_manager.numTotalDownloads();
+  const Row* r = row(index.row());
+  if (!r) {
+    return QVariant();
+  }
+
   if (role == Qt::DisplayRole) {
-    if (pendingDownload) {
-      std::tuple<QString, int, int> nexusids = m_manager.getPendingDownload(index.row() - m_manager.numTotalDownloads());
+    if (r->pending) {
+      const auto& nexusids = r->pendingIDs;
       switch (index.column()) {
         case COL_NAME: return tr("< game %1 mod %2 file %3 >").arg(std::get<0>(nexusids)).arg(std::get<1>(nexusids)).arg(std::get<2>(nexusids));
         case COL_SIZE: return tr("Unknown");
@@ -113,41 +135,39 @@ QVariant DownloadList::data(const QModelIndex &index, int role) const
       }
     } else {
       switch (index.column()) {
-        case COL_NAME: return m_settings.interface().metaDownloads() ? m_manager.getDisplayName(index.row()) : m_manager.getFileName(index.row());
+        case COL_NAME: return m_settings.interface().metaDownloads() ? r->displayName : r->fileName;
         case COL_MODNAME: {
-          if (m_manager.isInfoIncomplete(index.row())) {
+          if (r->infoIncomplete) {
             return {};
           } else {
-            const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(index.row());
-            return info->modName;
+            return r->modName;
           }
         }
         case COL_VERSION: {
-          if (m_manager.isInfoIncomplete(index.row())) {
+          if (r->infoIncomplete) {
             return {};
           } else {
-            const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(index.row());
-            return info->version.canonicalString();
+            return r->version.canonicalString();
           }
         }
         case COL_ID: {
-          if (m_manager.isInfoIncomplete(index.row())) {
+          if (r->infoIncomplete) {
             return {};
           } else {
-            return QString("%1").arg(m_manager.getModID(index.row()));
+            return QString("%1").arg(r->modID);
           }
         }
         case COL_SOURCEGAME: {
-          if (m_manager.isInfoIncomplete(index.row())) {
+          if (r->infoIncomplete) {
             return {};
           } else {
-            return QString("%1").arg(m_manager.getDisplayGameName(index.row()));
+            return QString("%1").arg(r->gameName);
           }
         }
-        case COL_SIZE: return MOBase::localizedByteSize(m_manager.getFileSize(index.row()));
-        case COL_FILETIME: return m_manager.getFileTime(index.row());
+        case COL_SIZE: return MOBase::localizedByteSize(r->size);
+        case COL_FILETIME: return r->fileTime;
         case COL_STATUS:
-          switch (m_manager.getState(index.row())) {
+          switch (r->state) {
             // STATE_DOWNLOADING handled by DownloadProgressDelegate
             case DownloadManager::STATE_STARTED: return tr("Started");
             case DownloadManager::STATE_CANCELING: return tr("Canceling");
@@ -165,10 +185,10 @@ QVariant DownloadList::data(const QModelIndex &index, int role) const
       }
     }
   } else if (role == Qt::ForegroundRole && index.column() == COL_STATUS) {
-    if (pendingDownload) {
+    if (r->pending) {
       return QColor(Qt::darkBlue);
     } else {
-      DownloadManager::DownloadState state = m_manager.getState(index.row());
+      DownloadManager::DownloadState state = r->state;
       if (state == DownloadManager::STATE_READY)
         return QColor(Qt::darkGreen);
       else if (state == DownloadManager::STATE_UNINSTALLED)
@@ -177,21 +197,20 @@ QVariant DownloadList::data(const QModelIndex &index, int role) const
         return QColor(Qt::darkRed);
     }
   } else if (role == Qt::ToolTipRole) {
-    if (pendingDownload) {
+    if (r->pending) {
       return tr("Pending download");
     } else {
-      QString text = m_manager.getFileName(index.row()) + "\n";
-      if (m_manager.isInfoIncomplete(index.row())) {
+      QString text = r->fileName + "\n";
+      if (r->infoIncomplete) {
         text += tr("Information missing, please select \"Query Info\" from the context menu to re-retrieve.");
       } else {
-        const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(index.row());
-        return QString("%1 (ID %2) %3<br><span>%4</span>").arg(info->modName).arg(m_manager.getModID(index.row())).arg(info->version.canonicalString()).arg(info->description.chopped(4096));
+        return QString("%1 (ID %2) %3<br><span>%4</span>").arg(r->modName).arg(r->modID).arg(r->version.canonicalString()).arg(r->description.chopped(4096));
       }
       return text;
     }
   } else if (role == Qt::DecorationRole && index.column() == COL_NAME) {
-    if (!pendingDownload && m_manager.getState(index.row()) >= DownloadManager::STATE_READY
-        && m_manager.isInfoIncomplete(index.row()))
+    if (!r->pending && r->state >= DownloadManager::STATE_READY
+        && r->infoIncomplete)
       return QIcon(":/MO/gui/warning_16");
   } else if (role == Qt::TextAlignmentRole) {
     if (index.column() == COL_SIZE)
@@ -203,85 +222,288 @@ QVariant DownloadList::data(const QModelIndex &index, int role) const
 }
 
 
-void DownloadList::aboutToUpdate()
+DownloadList::Row DownloadList::createRow(int i) const
+{
+  Row r;
+
+  const int total = m_manager.numTotalDownloads();
+
+  if (i >= total) {
+    r.pending = true;
+    r.pendingIDs = m_manager.getPendingDownload(i - total);
+    return r;
+  }
+
+  r.id = m_manager.getDownloadID(i);
+  r.displayName = m_manager.getDisplayName(i);
+  r.fileName = m_manager.getFileName(i);
+  r.size = m_manager.getFileSize(i);
+  r.fileTime = m_manager.getFileTime(i);
+  r.state = m_manager.getState(i);
+  r.progress = m_manager.getProgress(i);
+  r.infoIncomplete = m_manager.isInfoIncomplete(i);
+  r.gameName = m_manager.getDisplayGameName(i);
+
+  if (!r.infoIncomplete) {
+    const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(i);
+    r.modName = info->modName;
+    r.version = info->version;
+    r.description = info->description;
+    r.modID = m_manager.getModID(i);
+  }
+
+  return r;
+}
+
+bool DownloadList::sameDownload(const Row& a, const Row& b)
 {
-  emit beginResetModel();
+  if (a.pending != b.pending) {
+    return false;
+  }
+
+  if (a.pending) {
+    return (a.pendingIDs == b.pendingIDs);
+  } else {
+    return (a.id == b.id);
+  }
 }
 
+void DownloadList::rebuild()
+{
+  // every row is created again
+  m_changed.clear();
+  m_progressChanged.clear();
+  m_timer.stop();
+
+  const int count = m_manager.numTotalDownloads() + m_manager.numPendingDownloads();
+
+  std::vector<Row> rows;
+  rows.reserve(count);
+
+  for (int i=0; i<count; ++i) {
+    rows.push_back(createRow(i));
+  }
+
+  using Key = std::tuple<bool, unsigned int, QString, int, int>;
+
+  auto key = [](const Row& r) {
+    return Key(
+      r.pending, r.id, std::get<0>(r.pendingIDs),
+      std::get<1>(r.pendingIDs), std::get<2>(r.pendingIDs));
+  };
+
+  auto reset = [&] {
+    beginResetModel();
+    m_rows = std::move(rows);
+    endResetModel();
+  };
+
+  // position of the current rows
+  std::map<Key, int> current;
+
+  for (int i=0; i<static_cast<int>(m_rows.size()); ++i) {
+    if (!current.emplace(key(m_rows[i]), i).second) {
+      // the same pending download twice
+      reset();
+      return;
+    }
+  }
+
+  // new position of the current rows, -1 for rows that were removed, and
+  // whether the new rows were already there
+  std::vector<int> moved(m_rows.size(), -1);
+  std::vector<bool> kept(rows.size(), false);
+  int last = -1;
+
+  for (int i=0; i<static_cast<int>(rows.size()); ++i) {
+    auto itor = current.find(key(rows[i]));
+    if (itor == current.end()) {
+      continue;
+    }
+
+    if (itor->second < last || moved[itor->second] != -1) {
+      // downloads only get added and removed, this isn't worth handling
+      reset();
+      return;
+    }
+
+    last = itor->second;
+    moved[itor->second] = i;
+    kept[i] = true;
+  }
+
+  // removed rows, from the end so the indices of the others don't change
+  for (int i=static_cast<int>(m_rows.size()) - 1; i>=0;) {
+    if (moved[i] != -1) {
+      --i;
+      continue;
+    }
+
+    const int lastRemoved = i;
+    while (i >= 0 && moved[i] == -1) {
+      --i;
+    }
+
+    beginRemoveRows(QModelIndex(), i + 1, lastRemoved);
+    m_rows.erase(m_rows.begin() + i + 1, m_rows.begin() + lastRemoved + 1);
+    endRemoveRows();
+  }
+
+  // added rows, the rows that are left are in the same order as the new ones
+  // so every new row that was kept is at the right index once the rows
+  // before it were inserted
+  for (int i=0; i<static_cast<int>(rows.size());) {
+    if (kept[i]) {
+      m_rows[i] = std::move(rows[i]);
+      ++i;
+      continue;
+    }
+
+    const int first = i;
+    while (i < static_cast<int>(rows.size()) && !kept[i]) {
+      ++i;
+    }
+
+    beginInsertRows(QModelIndex(), first, i - 1);
+    m_rows.insert(
+      m_rows.begin() + first,
+      std::make_move_iterator(rows.begin() + first),
+      std::make_move_iterator(rows.begin() + i));
+    endInsertRows();
+  }
+
+  // anything else about the rows that were kept may have changed
+  if (!m_rows.empty()) {
+    emit dataChanged(
+      index(0, 0, QModelIndex()),
+      index(static_cast<int>(m_rows.size()) - 1, COL_COUNT - 1, QModelIndex()));
+  }
+}
 
 void DownloadList::update(int row)
 {
-  if (row < 0)
-    emit endResetModel();
-  else if (row < this->rowCount())
-    emit dataChanged(this->index(row, 0, QModelIndex()), this->index(row, this->columnCount(QModelIndex())-1, QModelIndex()));
-  else
+  if (row < 0) {
+    rebuild();
+  } else if (row < this->rowCount()) {
+    m_changed.insert(row);
+
+    if (!m_timer.isActive()) {
+      m_timer.start();
+    }
+  } else {
     log::error("invalid row {} in download list, update failed", row);
+  }
 }
 
-bool DownloadList::lessThanPredicate(const QModelIndex &left, const QModelIndex &right)
+void DownloadList::updateProgress(int row)
 {
-  int leftIndex  = left.row();
-  int rightIndex = right.row();
-  if ((leftIndex < m_manager.numTotalDownloads())
-      && (rightIndex < m_manager.numTotalDownloads())) {
-    if (left.column() == DownloadList::COL_NAME) {
-      return m_manager.getFileName(left.row()).compare(m_manager.getFileName(right.row()), Qt::CaseInsensitive) < 0;
-    } else if (left.column() == DownloadList::COL_MODNAME) {
-      QString leftName, rightName;
+  if (row < 0 || row >= this->rowCount()) {
+    log::error("invalid row {} in download list, progress update failed", row);
+    return;
+  }
 
-      if (!m_manager.isInfoIncomplete(left.row())) {
-        const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(left.row());
-        leftName = info->modName;
-      }
+  m_progressChanged.insert(row);
 
-      if (!m_manager.isInfoIncomplete(right.row())) {
-        const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(right.row());
-        rightName = info->modName;
-      }
+  if (!m_timer.isActive()) {
+    m_timer.start();
+  }
+}
 
-      return leftName.compare(rightName, Qt::CaseInsensitive) < 0;
-    } else if (left.column() == DownloadList::COL_VERSION) {
-        MOBase::VersionInfo versionLeft, versionRight;
+void DownloadList::updateChanged()
+{
+  std::set<int> changed, progressChanged;
+  changed.swap(m_changed);
+  progressChanged.swap(m_progressChanged);
 
-        if (!m_manager.isInfoIncomplete(left.row())) {
-          const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(left.row());
-          versionLeft = info->version;
-        }
+  const int count = m_manager.numTotalDownloads() + m_manager.numPendingDownloads();
 
-        if (!m_manager.isInfoIncomplete(right.row())) {
-          const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(right.row());
-          versionRight = info->version;
-        }
+  if (count != this->rowCount()) {
+    // the list changed without saying so
+    rebuild();
+    return;
+  }
 
-        return versionLeft < versionRight;
-    } else if (left.column() == DownloadList::COL_ID) {
-      int leftID=0, rightID=0;
+  std::vector<int> rows;
 
-      if (!m_manager.isInfoIncomplete(left.row())) {
-        const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(left.row());
-        leftID = info->modID;
-      }
+  for (const int i : changed) {
+    Row r = createRow(i);
 
-      if (!m_manager.isInfoIncomplete(right.row())) {
-        const MOBase::ModRepositoryFileInfo *info = m_manager.getFileInfo(right.row());
-        rightID = info->modID;
-      }
+    if (!sameDownload(r, m_rows[i])) {
+      rebuild();
+      return;
+    }
+
+    m_rows[i] = std::move(r);
+    rows.push_back(i);
+  }
 
-      return leftID < rightID;
+  emitChanged(rows, 0, COL_COUNT - 1);
+  rows.clear();
+
+  for (const int i : progressChanged) {
+    if (changed.count(i)) {
+      continue;
+    }
+
+    auto& r = m_rows[i];
+
+    if (r.pending || m_manager.getDownloadID(i) != r.id) {
+      rebuild();
+      return;
+    }
+
+    r.progress = m_manager.getProgress(i);
+    rows.push_back(i);
+  }
+
+  emitChanged(rows, COL_STATUS, COL_STATUS);
+}
+
+void DownloadList::emitChanged(
+  const std::vector<int>& rows, int firstColumn, int lastColumn)
+{
+  for (std::size_t i=0; i<rows.size();) {
+    std::size_t last = i;
+    while (last + 1 < rows.size() && rows[last + 1] == rows[last] + 1) {
+      ++last;
+    }
+
+    emit dataChanged(
+      index(rows[i], firstColumn, QModelIndex()),
+      index(rows[last], lastColumn, QModelIndex()));
+
+    i = last + 1;
+  }
+}
+
+bool DownloadList::lessThanPredicate(const QModelIndex &left, const QModelIndex &right)
+{
+  int leftIndex  = left.row();
+  int rightIndex = right.row();
+
+  const Row* l = row(leftIndex);
+  const Row* r = row(rightIndex);
+
+  if (l && r && !l->pending && !r->pending) {
+    if (left.column() == DownloadList::COL_NAME) {
+      return l->fileName.compare(r->fileName, Qt::CaseInsensitive) < 0;
+    } else if (left.column() == DownloadList::COL_MODNAME) {
+      return l->modName.compare(r->modName, Qt::CaseInsensitive) < 0;
+    } else if (left.column() == DownloadList::COL_VERSION) {
+      return l->version < r->version;
+    } else if (left.column() == DownloadList::COL_ID) {
+      return l->modID < r->modID;
     } else if (left.column() == DownloadList::COL_STATUS) {
-      DownloadManager::DownloadState leftState = m_manager.getState(left.row());
-      DownloadManager::DownloadState rightState = m_manager.getState(right.row());
-      if (leftState == rightState)
-        return m_manager.getFileTime(left.row()) < m_manager.getFileTime(right.row());
+      if (l->state == r->state)
+        return l->fileTime < r->fileTime;
       else
-        return leftState > rightState;
+        return l->state > r->state;
     } else if (left.column() == DownloadList::COL_SIZE) {
-      return m_manager.getFileSize(left.row()) < m_manager.getFileSize(right.row());
+      return l->size < r->size;
     } else if (left.column() == DownloadList::COL_FILETIME) {
-      return m_manager.getFileTime(left.row()) < m_manager.getFileTime(right.row());
+      return l->fileTime < r->fileTime;
     } else if (left.column() == DownloadList::COL_SOURCEGAME) {
-      return m_manager.getDisplayGameName(left.row()) < m_manager.getDisplayGameName(right.row());
+      return l->gameName < r->gameName;
     } else {
       return leftIndex < rightIndex;
     }
@@ -20,15 +20,27 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DOWNLOADLIST_H
 #define DOWNLOADLIST_H
 
+#include "downloadmanager.h"
 #include <QAbstractTableModel>
+#include <QDateTime>
+#include <QTimer>
+#include <chrono>
+#include <set>
+#include <tuple>
+#include <vector>
 
 class OrganizerCore;
-class DownloadManager;
 class Settings;
 
 
 /**
  * @brief model of the list of active and completed downloads
+ *
+ * the model keeps a copy of what it shows for every download, so painting and
+ * sorting don't go through the download manager; the rows are updated from the
+ * signals of the manager a few times per second at most, and when downloads
+ * are added or removed, the rows are compared with the new list so only these
+ * are inserted or removed instead of resetting the view
  **/
 class DownloadList : public QAbstractTableModel
 {
@@ -37,6 +49,32 @@ class DownloadList : public QAbstractTableModel
 
 public:
 
+  // what the model shows for a download
+  //
+  struct Row
+  {
+    // pending downloads have no id yet and are identified by their game, mod
+    // id and file id
+    bool pending = false;
+    unsigned int id = 0;
+    std::tuple<QString, int, int> pendingIDs;
+
+    QString displayName;
+    QString fileName;
+    qint64 size = 0;
+    QDateTime fileTime;
+    DownloadManager::DownloadState state = DownloadManager::STATE_STARTED;
+    std::pair<int, QString> progress;
+    QString gameName;
+
+    // nexus information, empty when it's incomplete
+    bool infoIncomplete = true;
+    QString modName;
+    MOBase::VersionInfo version;
+    QString description;
+    int modID = 0;
+  };
+
   enum EColumn {
     COL_NAME = 0,
     COL_STATUS,
@@ -80,6 +118,10 @@ public:
    **/
   virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
 
+  // the given row, null if it's out of range
+  //
+  const Row* row(int i) const;
+
   // used in DownloadsTab as the sorting predicate for the filter widget
   //
   bool lessThanPredicate(const QModelIndex &left, const QModelIndex &right);
@@ -93,12 +135,51 @@ public slots:
    **/
   void update(int row);
 
-  void aboutToUpdate();
+  /**
+   * @brief used to inform the model that the progress of a download has
+   *        changed, only the status column is updated
+   *
+   * @param row the row that changed
+   **/
+  void updateProgress(int row);
 
 private:
 
+  // time between two updates of the rows that changed
+  static constexpr std::chrono::milliseconds UpdateInterval{100};
+
   DownloadManager& m_manager;
   Settings& m_settings;
+
+  std::vector<Row> m_rows;
+
+  // rows that changed, and rows of which only the progress changed, since the
+  // last time the timer fired
+  std::set<int> m_changed;
+  std::set<int> m_progressChanged;
+  QTimer m_timer;
+
+  // creates the given row from the download manager
+  //
+  Row createRow(int i) const;
+
+  // whether both rows are for the same download
+  //
+  static bool sameDownload(const Row& a, const Row& b);
+
+  // creates all the rows again, inserting and removing the ones that were
+  // added or removed from the download manager
+  //
+  void rebuild();
+
+  // updates the rows that changed since the last time
+  //
+  void updateChanged();
+
+  // emits dataChanged() for the given rows and columns, with one signal per
+  // range of consecutive rows
+  //
+  void emitChanged(const std::vector<int>& rows, int firstColumn, int lastColumn);
 };
 
 #endif // DOWNLOADLIST_H
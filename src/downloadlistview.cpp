@@ -30,12 +30,13 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QHeaderView>
 #include <QCheckBox>
 #include <QWidgetAction>
+#include <algorithm>
 
 using namespace MOBase;
 
 DownloadProgressDelegate::DownloadProgressDelegate(
-  DownloadManager* manager, DownloadListView* list)
-    : QStyledItemDelegate(list), m_Manager(manager), m_List(list)
+  DownloadList* model, DownloadListView* list)
+    : QStyledItemDelegate(list), m_Model(model), m_List(list)
 {
 }
 
@@ -50,27 +51,36 @@ void DownloadProgressDelegate::paint(
     sourceIndex = index;
   }
 
-  bool pendingDownload = (sourceIndex.row() >= m_Manager->numTotalDownloads());
-  if (sourceIndex.column() == DownloadList::COL_STATUS && !pendingDownload
-      && m_Manager->getState(sourceIndex.row()) == DownloadManager::STATE_DOWNLOADING) {
-    QProgressBar progressBar;
-    progressBar.setProperty("downloadView", option.widget->property("downloadView"));
-    progressBar.setProperty("downloadProgress", true);
-    progressBar.resize(option.rect.width(), option.rect.height());
-    progressBar.setTextVisible(true);
-    progressBar.setAlignment(Qt::AlignCenter);
-    progressBar.setMinimum(0);
-    progressBar.setMaximum(100);
-    progressBar.setValue(m_Manager->getProgress(sourceIndex.row()).first);
-    progressBar.setFormat(m_Manager->getProgress(sourceIndex.row()).second);
-    progressBar.setStyle(QApplication::style());
+  const DownloadList::Row* row = m_Model->row(sourceIndex.row());
+
+  if (sourceIndex.column() == DownloadList::COL_STATUS && row && !row->pending
+      && row->state == DownloadManager::STATE_DOWNLOADING) {
+    const QVariant view = option.widget->property("downloadView");
+
+    if (!m_Bar || m_BarStyle != QApplication::style() || m_BarView != view) {
+      m_Bar = std::make_unique<QProgressBar>();
+      m_Bar->setProperty("downloadView", view);
+      m_Bar->setProperty("downloadProgress", true);
+      m_Bar->setTextVisible(true);
+      m_Bar->setAlignment(Qt::AlignCenter);
+      m_Bar->setMinimum(0);
+      m_Bar->setMaximum(100);
+      m_Bar->setStyle(QApplication::style());
+
+      m_BarStyle = QApplication::style();
+      m_BarView = view;
+    }
+
+    m_Bar->resize(option.rect.width(), option.rect.height());
+    m_Bar->setValue(row->progress.first);
+    m_Bar->setFormat(row->progress.second);
 
     // paint the background with default delegate first to preserve table cell styling
     QStyledItemDelegate::paint(painter, option, index);
 
     painter->save();
     painter->translate(option.rect.topLeft());
-    progressBar.render(painter);
+    m_Bar->render(painter);
     painter->restore();
   } else {
     QStyledItemDelegate::paint(painter, option, index);
@@ -127,6 +137,7 @@ DownloadListView::DownloadListView(QWidget *parent)
   header()->setDefaultSectionSize(100);
 
   setUniformRowHeights(true);
+  setSelectionMode(QAbstractItemView::ExtendedSelection);
   setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   sortByColumn(1, Qt::DescendingOrder);
 
@@ -224,6 +235,14 @@ void DownloadListView::onCustomContextMenu(const QPoint &point)
 
       if (state >= DownloadManager::STATE_READY) {
         menu.addAction(tr("Install"), [=] { issueInstall(row); });
+
+        const auto selected = selectedInstallable();
+        if (selected.size() > 1) {
+          menu.addAction(
+            tr("Install Selected (%1)").arg(selected.size()),
+            [=] { issueInstallSelected(); });
+        }
+
         if (m_Manager->isInfoIncomplete(row))
           menu.addAction(tr("Query Info"), [=] { issueQueryInfoMd5(row); });
         else
@@ -242,12 +261,14 @@ void DownloadListView::onCustomContextMenu(const QPoint &point)
       } else if (state == DownloadManager::STATE_DOWNLOADING) {
         menu.addAction(tr("Cancel"), [=] { issueCancel(row); });
         menu.addAction(tr("Pause"), [=] { issuePause(row); });
+        addInstallWhenFinished(menu, row);
         menu.addAction(tr("Reveal in Explorer"), [=] { issueOpenInDownloadsFolder(row); });
       }
       else if ((state == DownloadManager::STATE_PAUSED) || (state == DownloadManager::STATE_ERROR)
         || (state == DownloadManager::STATE_PAUSING)) {
         menu.addAction(tr("Delete..."), [=] { issueDelete(row); });
         menu.addAction(tr("Resume"), [=] { issueResume(row); });
+        addInstallWhenFinished(menu, row);
         menu.addAction(tr("Reveal in Explorer"), [=] { issueOpenInDownloadsFolder(row); });
       }
 
@@ -259,6 +280,9 @@ void DownloadListView::onCustomContextMenu(const QPoint &point)
     // display download-specific actions
   }
 
+  menu.addAction(tr("Query Info for All Downloads"), [=] { issueQueryInfoAll(); });
+
+  menu.addSeparator();
   menu.addAction(tr("Delete Installed Downloads..."), [=] { issueDeleteCompleted(); });
   menu.addAction(tr("Delete Uninstalled Downloads..."), [=] { issueDeleteUninstalled(); });
   menu.addAction(tr("Delete All Downloads..."), [=] { issueDeleteAll(); });
@@ -310,11 +334,47 @@ void DownloadListView::keyPressEvent(QKeyEvent* event)
   QTreeView::keyPressEvent(event);
 }
 
+void DownloadListView::addInstallWhenFinished(QMenu& menu, int row)
+{
+  auto* a = menu.addAction(tr("Install When Finished"), [=](bool checked) {
+    m_Manager->setInstallWhenFinished(row, checked);
+  });
+
+  a->setCheckable(true);
+  a->setChecked(m_Manager->installWhenFinished(row));
+}
+
 void DownloadListView::issueInstall(int index)
 {
   emit installDownload(index);
 }
 
+void DownloadListView::issueInstallSelected()
+{
+  emit installDownloads(selectedInstallable());
+}
+
+std::vector<int> DownloadListView::selectedInstallable() const
+{
+  std::vector<int> rows;
+
+  auto* proxy = qobject_cast<QSortFilterProxyModel*>(model());
+  for (const QModelIndex& index : selectionModel()->selectedRows()) {
+    const int row = proxy->mapToSource(index).row();
+    if (m_Manager->getState(row) >= DownloadManager::STATE_READY) {
+      rows.push_back(row);
+    }
+  }
+
+  // in the order they're shown
+  std::sort(rows.begin(), rows.end(), [&](int a, int b) {
+    return proxy->mapFromSource(proxy->sourceModel()->index(a, 0)).row()
+         < proxy->mapFromSource(proxy->sourceModel()->index(b, 0)).row();
+  });
+
+  return rows;
+}
+
 void DownloadListView::issueQueryInfo(int index)
 {
   emit queryInfo(index);
@@ -325,6 +385,11 @@ void DownloadListView::issueQueryInfoMd5(int index)
   emit queryInfoMd5(index);
 }
 
+void DownloadListView::issueQueryInfoAll()
+{
+  emit queryInfoAll();
+}
+
 void DownloadListView::issueDelete(int index)
 {
   const auto r = MOBase::TaskDialog(this, tr("Delete download"))
@@ -25,10 +25,13 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QWidget>
 #include <QItemDelegate>
 #include <QLabel>
+#include <QMenu>
 #include <QProgressBar>
 #include <QTreeView>
 #include <QHeaderView>
 #include <QStyledItemDelegate>
+#include <memory>
+#include <vector>
 
 
 namespace Ui {
@@ -42,14 +45,20 @@ class DownloadProgressDelegate : public QStyledItemDelegate
   Q_OBJECT
 
 public:
-  DownloadProgressDelegate(DownloadManager* manager, DownloadListView* list);
+  DownloadProgressDelegate(DownloadList* model, DownloadListView* list);
 
   void paint(QPainter *painter, const QStyleOptionViewItem &option,
     const QModelIndex &index) const override;
 
 private:
-  DownloadManager* m_Manager;
+  DownloadList* m_Model;
   DownloadListView* m_List;
+
+  // rendered for every download in progress, created again when the style
+  // or the view changes
+  mutable std::unique_ptr<QProgressBar> m_Bar;
+  mutable QStyle* m_BarStyle = nullptr;
+  mutable QVariant m_BarView;
 };
 
 class DownloadListHeader : public QHeaderView
@@ -77,8 +86,10 @@ public:
 
 signals:
   void installDownload(int index);
+  void installDownloads(const std::vector<int>& indexes);
   void queryInfo(int index);
   void queryInfoMd5(int index);
+  void queryInfoAll();
   void removeDownload(int index, bool deleteFile);
   void restoreDownload(int index);
   void cancelDownload(int index);
@@ -98,6 +109,7 @@ private slots:
   void onHeaderCustomContextMenu(const QPoint& point);
 
   void issueInstall(int index);
+  void issueInstallSelected();
   void issueDelete(int index);
   void issueRemoveFromView(int index);
   void issueRestoreToView(int index);
@@ -117,12 +129,19 @@ private slots:
   void issueRemoveFromViewUninstalled();
   void issueQueryInfo(int index);
   void issueQueryInfoMd5(int index);
+  void issueQueryInfoAll();
+
+  // selected rows that can be installed, in source model indexes
+  std::vector<int> selectedInstallable() const;
 
 private:
   DownloadManager *m_Manager;
   DownloadList *m_SourceModel = 0;
 
   void resizeEvent(QResizeEvent *event);
+
+  // checkable action for DownloadManager::setInstallWhenFinished()
+  void addInstallWhenFinished(QMenu& menu, int row);
 };
 
 #endif // DOWNLOADLISTWIDGET_H
@@ -18,6 +18,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "downloadmanager.h"
+#include "metrics.h"
 
 #include "organizercore.h"
 #include "nxmurl.h"
@@ -31,6 +32,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "selectiondialog.h"
 #include "bbcode.h"
 #include "shared/util.h"
+#include "taskexecutor.h"
 #include <utility.h>
 #include <report.h>
 
@@ -43,12 +45,17 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMessageBox>
 #include <QCoreApplication>
 #include <QTextDocument>
+#include <QProgressDialog>
+#include <QEventLoop>
 
 #include <boost/bind/bind.hpp>
+#include <algorithm>
+#include <limits>
 #include <regex>
 
 
 using namespace MOBase;
+using namespace MOShared;
 
 
 // TODO limit number of downloads, also display download during nxm requests, store modid/fileid with downloads
@@ -57,9 +64,22 @@ using namespace MOBase;
 static const char UNFINISHED[] = ".unfinished";
 
 unsigned int DownloadManager::DownloadInfo::s_NextDownloadID = 1U;
-int DownloadManager::m_DirWatcherDisabler = 0;
+WatcherSuppression DownloadManager::m_DirWatcherDisabler;
 
 
+DownloadManager::DownloadInfo::~DownloadInfo()
+{
+  for (auto& segment : m_Segments) {
+    if (segment.reply != nullptr) {
+      segment.reply->disconnect();
+      segment.reply->abort();
+      segment.reply->deleteLater();
+    }
+  }
+
+  delete m_FileInfo;
+}
+
 DownloadManager::DownloadInfo *DownloadManager::DownloadInfo::createNew(const ModRepositoryFileInfo *fileInfo, const QStringList &URLs)
 {
   DownloadInfo *info = new DownloadInfo;
@@ -81,14 +101,14 @@ DownloadManager::DownloadInfo *DownloadManager::DownloadInfo::createNew(const Mo
 
 DownloadManager::DownloadInfo *DownloadManager::DownloadInfo::createFromMeta(
   const QString &filePath, bool showHidden, const QString outputDirectory,
-  std::optional<uint64_t> fileSize)
+  std::optional<uint64_t> fileSize, const QVariantMap* meta)
 {
   DownloadInfo *info = new DownloadInfo;
 
   QString metaFileName = filePath + ".meta";
   QFileInfo metaFileInfo(metaFileName);
   if (QDir::fromNativeSeparators(metaFileInfo.path()).compare(QDir::fromNativeSeparators(outputDirectory), Qt::CaseInsensitive) != 0) return nullptr;
-  QSettings metaFile(metaFileName, QSettings::IniFormat);
+  const QVariantMap metaFile = meta ? *meta : DownloadMetaCache::read(metaFileName);
   if (!showHidden && metaFile.value("removed", false).toBool()) {
     return nullptr;
   } else {
@@ -145,26 +165,47 @@ DownloadManager::DownloadInfo *DownloadManager::DownloadInfo::createFromMeta(
   info->m_FileInfo->userData = metaFile.value("userData").toMap();
   info->m_Reply = nullptr;
 
+  // hash of the finished file computed while downloading, see
+  // DownloadManager::hashData()
+  if (info->m_State != STATE_PAUSED) {
+    info->m_Hash = QByteArray::fromHex(metaFile.value("md5").toByteArray());
+  }
+
+  // "begin:end:received" for each segment of a segmented download, only
+  // relevant while it's unfinished
+  const QStringList segments = (info->m_State == STATE_PAUSED) ?
+    metaFile.value("segments").toStringList() : QStringList();
+
+  for (const QString& s : segments) {
+    const QStringList parts = s.split(":");
+    if (parts.size() != 3) {
+      log::warn("bad segment '{}' in {}", s, metaFileName);
+      info->m_Segments.clear();
+      break;
+    }
+
+    Segment segment;
+    segment.begin = parts[0].toLongLong();
+    segment.end = parts[1].toLongLong();
+    segment.received = parts[2].toLongLong();
+    segment.url = static_cast<int>(info->m_Segments.size());
+    info->m_Segments.push_back(segment);
+  }
+
   return info;
 }
 
 void DownloadManager::startDisableDirWatcher()
 {
-  DownloadManager::m_DirWatcherDisabler++;
+  DownloadManager::m_DirWatcherDisabler.start();
 }
 
 
 void DownloadManager::endDisableDirWatcher()
 {
-  if (DownloadManager::m_DirWatcherDisabler > 0)
-  {
-    if (DownloadManager::m_DirWatcherDisabler == 1)
-      QCoreApplication::processEvents();
-    DownloadManager::m_DirWatcherDisabler--;
-  }
-  else {
-    DownloadManager::m_DirWatcherDisabler = 0;
-  }
+  // the changes reported shortly after this are still dropped, so they don't
+  // have to be processed here
+  DownloadManager::m_DirWatcherDisabler.end();
 }
 
 void DownloadManager::DownloadInfo::setName(QString newName, bool renameFile)
@@ -203,16 +244,47 @@ QString DownloadManager::DownloadInfo::currentURL()
   return m_Urls[m_CurrentUrl];
 }
 
+qint64 DownloadManager::DownloadInfo::segmentsReceived() const
+{
+  qint64 received = 0;
+  for (const auto& segment : m_Segments) {
+    received += segment.received + segment.pending.size();
+  }
+
+  return received;
+}
+
 
 DownloadManager::DownloadManager(NexusInterface *nexusInterface, QObject *parent) :
   m_NexusInterface(nexusInterface), m_DirWatcher(), m_ShowHidden(false),
-  m_ParentWidget(nullptr)
+  m_ParentWidget(nullptr), m_MaxDownloads(0), m_MaxSpeedPerDownload(0)
 {
   m_OrganizerCore = dynamic_cast<OrganizerCore*>(parent);
-  connect(&m_DirWatcher, SIGNAL(directoryChanged(QString)), this, SLOT(directoryChanged(QString)));
+  m_DirWatcher.setSuppression(&m_DirWatcherDisabler);
+  connect(&m_DirWatcher, &DirectoryWatcher::changed, this, &DownloadManager::directoryChanged);
   m_TimeoutTimer.setSingleShot(false);
   //connect(&m_TimeoutTimer, SIGNAL(timeout()), this, SLOT(checkDownloadTimeout()));
   m_TimeoutTimer.start(5 * 1000);
+
+  m_ThrottleTimer.setSingleShot(true);
+  m_ThrottleTimer.setInterval(100);
+  connect(&m_ThrottleTimer, SIGNAL(timeout()), this, SLOT(readThrottled()));
+
+  m_ScheduleTimer.setSingleShot(true);
+  m_ScheduleTimer.setInterval(0);
+  connect(&m_ScheduleTimer, SIGNAL(timeout()), this, SLOT(startQueued()));
+
+  m_ProgressTimer.setSingleShot(true);
+  m_ProgressTimer.setInterval(PROGRESS_INTERVAL);
+  connect(&m_ProgressTimer, SIGNAL(timeout()), this, SLOT(publishProgress()));
+
+  m_NXMBatchTimer.setSingleShot(true);
+  m_NXMBatchTimer.setInterval(NXM_BATCH_INTERVAL);
+  connect(&m_NXMBatchTimer, SIGNAL(timeout()), this, SLOT(processNXMBatch()));
+
+  m_BulkMetaTimer.setSingleShot(true);
+  m_BulkMetaTimer.setInterval(BULK_META_INTERVAL);
+  connect(&m_BulkMetaTimer, &QTimer::timeout, [&]{ writeBulkMeta(); });
 }
 
 
@@ -229,6 +301,20 @@ void DownloadManager::setParentWidget(QWidget* w)
   m_ParentWidget = w;
 }
 
+void DownloadManager::setLimits(int maxDownloads, qint64 maxSpeed, qint64 maxSpeedPerDownload)
+{
+  m_MaxDownloads = std::max(maxDownloads, 0);
+  m_MaxSpeedPerDownload = std::max<qint64>(maxSpeedPerDownload, 0);
+  m_Bandwidth.setRate(maxSpeed);
+
+  for (DownloadInfo *info : m_ActiveDownloads) {
+    info->m_Bandwidth.setRate(m_MaxSpeedPerDownload);
+  }
+
+  // the limit might have been raised
+  m_ScheduleTimer.start();
+}
+
 bool DownloadManager::downloadsInProgress()
 {
   for (QVector<DownloadInfo*>::iterator iter = m_ActiveDownloads.begin(); iter != m_ActiveDownloads.end(); ++iter) {
@@ -287,15 +373,12 @@ void DownloadManager::pauseAll()
 
 void DownloadManager::setOutputDirectory(const QString &outputDirectory, const bool refresh)
 {
-  QStringList directories = m_DirWatcher.directories();
-  if (directories.length() != 0) {
-    m_DirWatcher.removePaths(directories);
-  }
+  m_DirWatcher.watch({});
   m_OutputDirectory = QDir::fromNativeSeparators(outputDirectory);
   if (refresh) {
     refreshList();
   }
-  m_DirWatcher.addPath(m_OutputDirectory);
+  m_DirWatcher.watch({m_OutputDirectory});
 }
 
 void DownloadManager::setShowHidden(bool showHidden)
@@ -311,7 +394,7 @@ void DownloadManager::setPluginContainer(PluginContainer *pluginContainer)
 
 void DownloadManager::refreshList()
 {
-  TimeThis tt("DownloadManager::refreshList()");
+  Metrics::Timer tt("DownloadManager::refreshList()");
 
   try {
     //avoid triggering other refreshes
@@ -338,15 +421,57 @@ void DownloadManager::refreshList()
     nameFilters.push_back(QString(UNFINISHED).toLower().toStdWString());
 
 
-    QDir dir(QDir::fromNativeSeparators(m_OutputDirectory));
+    m_MetaCache.load(m_OutputDirectory);
+
+    // the directory is only listed once, the meta files are found in there
+    // instead of checking for each archive
+    struct File
+    {
+      std::wstring name;
+      FILETIME time;
+      uint64_t size;
+    };
+
+    struct Context
+    {
+      std::vector<File> files;
+      int depth = 0;
+    };
+
+    Context cx;
+
+    // only the files directly in the directory are downloads
+    env::forEachEntry(
+      QDir::toNativeSeparators(m_OutputDirectory).toStdWString(), &cx,
+      [](void* data, std::wstring_view, FILETIME) {
+        ++static_cast<Context*>(data)->depth;
+      },
+      [](void* data, std::wstring_view) {
+        --static_cast<Context*>(data)->depth;
+      },
+      [](void* data, std::wstring_view f, FILETIME ft, uint64_t size) {
+        auto& cx = *static_cast<Context*>(data);
+        if (cx.depth == 0) {
+          cx.files.push_back({std::wstring(f), ft, size});
+        }
+    });
+
+    const std::vector<File>& files = cx.files;
+    std::map<std::wstring, std::size_t> byName;
+
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      byName.emplace(MOShared::ToLowerCopy(files[i].name), i);
+    }
+
+    const QString dir = QDir::fromNativeSeparators(m_OutputDirectory) + "/";
+    const std::wstring metaExt = L".meta";
 
     // find orphaned meta files and delete them (sounds cruel but it's better for everyone)
     QStringList orphans;
-    QStringList metaFiles = dir.entryList(QStringList() << "*.meta");
-    foreach (const QString &metaFile, metaFiles) {
-      QString baseFile = metaFile.left(metaFile.length() - 5);
-      if (!QFile::exists(dir.absoluteFilePath(baseFile))) {
-        orphans.append(dir.absoluteFilePath(metaFile));
+    for (auto&& [lc, i] : byName) {
+      if (lc.ends_with(metaExt) &&
+          !byName.contains(lc.substr(0, lc.size() - metaExt.size()))) {
+        orphans.append(dir + QString::fromStdWString(files[i].name));
       }
     }
     if (orphans.size() > 0) {
@@ -357,59 +482,78 @@ void DownloadManager::refreshList()
 
     std::set<std::wstring> seen;
 
-    struct Context
-    {
-      DownloadManager& self;
-      std::set<std::wstring>& seen;
-      std::vector<std::wstring>& extensions;
-    };
-
-    Context cx = {*this, seen, nameFilters};
+    // new downloads go before the existing ones, they're inserted at once
+    // below instead of one by one at the front
+    std::vector<DownloadInfo*> added;
 
     for (auto&& d : m_ActiveDownloads) {
-      cx.seen.insert(d->m_FileName.toLower().toStdWString());
-      cx.seen.insert(QFileInfo(d->m_Output.fileName()).fileName().toLower().toStdWString());
+      seen.insert(d->m_FileName.toLower().toStdWString());
+      seen.insert(QFileInfo(d->m_Output.fileName()).fileName().toLower().toStdWString());
     }
 
+    std::wstring lc;
 
-    env::forEachEntry(
-      QDir::toNativeSeparators(m_OutputDirectory).toStdWString(), &cx, nullptr, nullptr,
-      [](void* data, std::wstring_view f, FILETIME, uint64_t size) {
-        auto& cx = *static_cast<Context*>(data);
-
-        std::wstring lc = MOShared::ToLowerCopy(f);
+    for (const auto& f : files) {
+      MOShared::ToLowerCopy(f.name, lc);
 
-        bool interestingExt = false;
-        for (auto&& ext : cx.extensions) {
-          if (lc.ends_with(ext)) {
-            interestingExt = true;
-            break;
-          }
+      bool interestingExt = false;
+      for (auto&& ext : nameFilters) {
+        if (lc.ends_with(ext)) {
+          interestingExt = true;
+          break;
         }
+      }
 
-        if (!interestingExt) {
-          return;
-        }
+      if (!interestingExt) {
+        continue;
+      }
 
-        if (cx.seen.contains(lc)) {
-          return;
-        }
+      if (seen.contains(lc)) {
+        continue;
+      }
 
-        QString fileName =
-          QDir::fromNativeSeparators(cx.self.m_OutputDirectory) + "/" +
-          QString::fromWCharArray(f.data(), f.size());
+      const QString fileName = dir + QString::fromStdWString(f.name);
 
-        DownloadInfo *info = DownloadInfo::createFromMeta(
-          fileName, cx.self.m_ShowHidden, cx.self.m_OutputDirectory, size);
+      // a missing meta file gives empty values, same as an empty one
+      static const QVariantMap noMeta;
+      const QVariantMap* meta = &noMeta;
 
-        if (info == nullptr) {
-          return;
-        }
+      auto itor = byName.find(lc + metaExt);
+      if (itor != byName.end()) {
+        const File& mf = files[itor->second];
+        const qint64 time =
+          (static_cast<qint64>(mf.time.dwHighDateTime) << 32) | mf.time.dwLowDateTime;
 
-        cx.self.m_ActiveDownloads.push_front(info);
-        cx.seen.insert(std::move(lc));
-        cx.seen.insert(QFileInfo(info->m_Output.fileName()).fileName().toLower().toStdWString());
-    });
+        meta = &m_MetaCache.get(fileName + ".meta", time, mf.size);
+      }
+
+      DownloadInfo *info = DownloadInfo::createFromMeta(
+        fileName, m_ShowHidden, m_OutputDirectory, f.size, meta);
+
+      if (info == nullptr) {
+        continue;
+      }
+
+      added.push_back(info);
+      seen.insert(std::move(lc));
+      seen.insert(QFileInfo(info->m_Output.fileName()).fileName().toLower().toStdWString());
+    }
+
+    if (!added.empty()) {
+      QVector<DownloadInfo*> all;
+      all.reserve(static_cast<int>(added.size()) + m_ActiveDownloads.size());
+
+      // in the same order as if they had been pushed to the front
+      for (auto itor = added.rbegin(); itor != added.rend(); ++itor) {
+        all.push_back(*itor);
+      }
+
+      all += m_ActiveDownloads;
+      m_ActiveDownloads = std::move(all);
+    }
+
+    m_MetaCache.prune();
+    m_MetaCache.save();
 
     log::debug("saw {} downloads", m_ActiveDownloads.size());
 
@@ -512,6 +656,7 @@ void DownloadManager::startDownload(QNetworkReply *reply, DownloadInfo *newDownl
 {
   reply->setReadBufferSize(1024 * 1024); // don't read more than 1MB at once to avoid memory troubles
   newDownload->m_Reply = reply;
+  newDownload->m_Bandwidth.setRate(m_MaxSpeedPerDownload);
   setState(newDownload, STATE_DOWNLOADING);
   if (newDownload->m_Urls.count() == 0) {
     newDownload->m_Urls = QStringList(reply->url().toString());
@@ -531,6 +676,15 @@ void DownloadManager::startDownload(QNetworkReply *reply, DownloadInfo *newDownl
     return;
   }
 
+  // a resumed download keeps hashing if the hash covers everything that's
+  // already in the file, which isn't the case after a restart
+  if (newDownload->m_Output.size() == 0) {
+    newDownload->m_Hasher.reset(new QCryptographicHash(QCryptographicHash::Md5));
+    newDownload->m_HashedSize = 0;
+  } else if (newDownload->m_HashedSize != newDownload->m_Output.size()) {
+    newDownload->m_Hasher.reset();
+  }
+
   connect(newDownload->m_Reply, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(downloadProgress(qint64, qint64)));
   connect(newDownload->m_Reply, SIGNAL(error(QNetworkReply::NetworkError)), this, SLOT(downloadError(QNetworkReply::NetworkError)));
   connect(newDownload->m_Reply, SIGNAL(readyRead()), this, SLOT(downloadReadyRead()));
@@ -584,6 +738,72 @@ void DownloadManager::startDownload(QNetworkReply *reply, DownloadInfo *newDownl
 
 
 void DownloadManager::addNXMDownload(const QString &url)
+{
+  log::debug("add nxm download: {}", url);
+
+  // tools sending many links at once would otherwise start as many lookups,
+  // the timer isn't restarted so the first link doesn't wait forever
+  if (!m_NXMBatch.contains(url)) {
+    m_NXMBatch.append(url);
+  }
+
+  if (!m_NXMBatchTimer.isActive()) {
+    m_NXMBatchTimer.start();
+  }
+}
+
+void DownloadManager::processNXMBatch()
+{
+  const QStringList links = std::move(m_NXMBatch);
+  m_NXMBatch.clear();
+
+  if (links.size() > 1) {
+    log::debug("handling {} nxm links", links.size());
+  }
+
+  QString title, message;
+  int skipped = 0;
+
+  for (const auto& url : links) {
+    QString t, m;
+
+    if (!queueNXMDownload(url, t, m)) {
+      ++skipped;
+      title = t;
+      message = m;
+    }
+  }
+
+  startNXMLookups();
+
+  if (skipped == 1) {
+    QMessageBox::information(m_ParentWidget, title, message, QMessageBox::Ok);
+  } else if (skipped > 1) {
+    QMessageBox::information(
+      m_ParentWidget, tr("Links Skipped"),
+      tr("%1 of the %2 download links were skipped because they are for "
+         "another game or were already queued or started. See the log for "
+         "details.").arg(skipped).arg(links.size()),
+      QMessageBox::Ok);
+  }
+}
+
+void DownloadManager::startNXMLookups()
+{
+  while (!m_NXMLookupQueue.isEmpty() && m_NXMLookups.size() < MAX_NXM_LOOKUPS) {
+    const NXMLookup lookup = m_NXMLookupQueue.dequeue();
+
+    QObject *test = lookup.info;
+    const int id = m_NexusInterface->requestFileInfo(
+      lookup.gameName, lookup.modID, lookup.fileID, this,
+      QVariant::fromValue(test), "");
+
+    m_RequestIDs.insert(id);
+    m_NXMLookups.insert(id);
+  }
+}
+
+bool DownloadManager::queueNXMDownload(const QString &url, QString &title, QString &message)
 {
   NXMUrl nxmInfo(url);
 
@@ -611,26 +831,25 @@ void DownloadManager::addNXMDownload(const QString &url)
       break;
     }
   }
-  log::debug("add nxm download: {}", url);
   if (foundGame == nullptr) {
     log::debug("download requested for wrong game (game: {}, url: {})", m_ManagedGame->gameShortName(), nxmInfo.game());
-    QMessageBox::information(m_ParentWidget, tr("Wrong Game"), tr("The download link is for a mod for \"%1\" but this instance of MO "
-    "has been set up for \"%2\".").arg(nxmInfo.game()).arg(m_ManagedGame->gameShortName()), QMessageBox::Ok);
-    return;
+    title = tr("Wrong Game");
+    message = tr("The download link is for a mod for \"%1\" but this instance of MO "
+    "has been set up for \"%2\".").arg(nxmInfo.game()).arg(m_ManagedGame->gameShortName());
+    return false;
   }
 
   for (auto tuple : m_PendingDownloads) {
-    if (std::get<0>(tuple).compare(foundGame->gameShortName(), Qt::CaseInsensitive) == 0, std::get<1>(tuple) == nxmInfo.modId() && std::get<2>(tuple) == nxmInfo.fileId()) {
-      const auto infoStr =
-        tr("There is already a download queued for this file.\n\nMod %1\nFile %2")
-        .arg(nxmInfo.modId()).arg(nxmInfo.fileId());
-
+    if (std::get<0>(tuple).compare(foundGame->gameShortName(), Qt::CaseInsensitive) == 0 && std::get<1>(tuple) == nxmInfo.modId() && std::get<2>(tuple) == nxmInfo.fileId()) {
       log::debug(
         "download requested is already queued (mod: {}, file: {})",
         nxmInfo.modId(), nxmInfo.fileId());
 
-      QMessageBox::information(m_ParentWidget, tr("Already Queued"), infoStr, QMessageBox::Ok);
-      return;
+      title = tr("Already Queued");
+      message =
+        tr("There is already a download queued for this file.\n\nMod %1\nFile %2")
+        .arg(nxmInfo.modId()).arg(nxmInfo.fileId());
+      return false;
     }
   }
 
@@ -673,8 +892,9 @@ void DownloadManager::addNXMDownload(const QString &url)
         }
 
         log::debug("{}", debugStr);
-        QMessageBox::information(m_ParentWidget, tr("Already Started"), infoStr, QMessageBox::Ok);
-        return;
+        title = tr("Already Started");
+        message = infoStr;
+        return false;
       }
     }
   }
@@ -691,8 +911,9 @@ void DownloadManager::addNXMDownload(const QString &url)
   info->nexusExpires = nxmInfo.expires();
   info->nexusDownloadUser = nxmInfo.userId();
 
-  QObject *test = info;
-  m_RequestIDs.insert(m_NexusInterface->requestFileInfo(foundGame->gameShortName(), nxmInfo.modId(), nxmInfo.fileId(), this, QVariant::fromValue(test), ""));
+  m_NXMLookupQueue.enqueue({foundGame->gameShortName(), nxmInfo.modId(), nxmInfo.fileId(), info});
+
+  return true;
 }
 
 
@@ -863,7 +1084,13 @@ void DownloadManager::cancelDownload(int index)
   }
 
   if (m_ActiveDownloads.at(index)->m_State == STATE_DOWNLOADING) {
-    setState(m_ActiveDownloads.at(index), STATE_CANCELING);
+    DownloadInfo *info = m_ActiveDownloads.at(index);
+    setState(info, STATE_CANCELING);
+
+    if (!info->m_Segments.empty()) {
+      // segments don't wait for the next chunk of data to stop
+      stopSegmented(info, index);
+    }
   }
 }
 
@@ -877,8 +1104,15 @@ void DownloadManager::pauseDownload(int index)
 
   DownloadInfo *info = m_ActiveDownloads.at(index);
 
+  // paused by the user, the scheduler leaves it alone until it's resumed
+  info->m_Queued = false;
+  info->m_Admitted = false;
+
   if (info->m_State == STATE_DOWNLOADING) {
-    if ((info->m_Reply != nullptr) && (info->m_Reply->isRunning())) {
+    if (!info->m_Segments.empty()) {
+      setState(info, STATE_PAUSING);
+      stopSegmented(info, index);
+    } else if ((info->m_Reply != nullptr) && (info->m_Reply->isRunning())) {
       setState(info, STATE_PAUSING);
     } else {
       setState(info, STATE_PAUSED);
@@ -909,6 +1143,11 @@ void DownloadManager::resumeDownloadInt(int index)
   }
   DownloadInfo *info = m_ActiveDownloads[index];
 
+  if (!info->m_Segments.empty()) {
+    resumeSegmented(info, index);
+    return;
+  }
+
   // Check for finished download;
   if (info->m_TotalSize <= info->m_Output.size() && info->m_Reply != nullptr
       && info->m_Reply->isOpen() && info->m_Reply->isFinished() && info->m_State != STATE_ERROR) {
@@ -956,13 +1195,11 @@ void DownloadManager::resumeDownloadInt(int index)
 
 DownloadManager::DownloadInfo *DownloadManager::downloadInfoByID(unsigned int id)
 {
-  auto iter = std::find_if(m_ActiveDownloads.begin(), m_ActiveDownloads.end(),
-               [id](DownloadInfo *info) { return info->m_DownloadID == id; });
-  if (iter != m_ActiveDownloads.end()) {
-    return *iter;
-  } else {
-    return nullptr;
-  }
+  const int i = findIndex(m_IndexByID, id, [&](auto&& d) {
+    return (d.m_DownloadID == id);
+  });
+
+  return (i < 0 ? nullptr : m_ActiveDownloads[i]);
 }
 
 
@@ -1046,17 +1283,259 @@ void DownloadManager::queryInfoMd5(int index)
   info->m_GamesToQuery << m_ManagedGame->gameShortName();
   info->m_GamesToQuery << m_ManagedGame->validShortNames();
 
+  // downloads hashed while they were received don't need to be read again
+  if (info->m_Hash.isEmpty()) {
+    info->m_Hash = hashFile(info);
+    if (info->m_Hash.isEmpty()) {
+      return;
+    }
+  }
+
+  info->m_ReQueried = true;
+  setState(info, STATE_FETCHINGMODINFO_MD5);
+}
+
+// md5 of the given file, read through mappings of part of the file at a time
+// so the data isn't copied; empty on failure or if the group was cancelled
+//
+static QByteArray hashMapped(const QString& path, qint64 mapSize, const TaskGroup& group)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    log::error("can't open download file '{}': {}", path, file.errorString());
+    return {};
+  }
+
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  const qint64 size = file.size();
+
+  for (qint64 offset = 0; offset < size; offset += mapSize) {
+    if (group.cancelled()) {
+      return {};
+    }
+
+    const qint64 length = std::min(mapSize, size - offset);
+
+    if (uchar* data = file.map(offset, length)) {
+      hash.addData(reinterpret_cast<const char*>(data), static_cast<int>(length));
+      file.unmap(data);
+    } else {
+      // mapping isn't supported everywhere, such as on some network drives
+      file.seek(offset);
+      const QByteArray data = file.read(length);
+
+      if (data.size() != length) {
+        log::error("can't read download file '{}': {}", path, file.errorString());
+        return {};
+      }
+
+      hash.addData(data);
+    }
+  }
+
+  return hash.result();
+}
+
+void DownloadManager::queryInfoAll()
+{
+  // queries that never came back, such as when the request queue was cleared
+  // because of the api limits, are started again
+  for (auto itor = m_BulkQueries.begin(); itor != m_BulkQueries.end();) {
+    const DownloadInfo* info = downloadInfoByID(itor->first);
+
+    if (info == nullptr || info->m_State < STATE_FETCHINGMODINFO || info->m_State > STATE_FETCHINGMODINFO_MD5) {
+      itor = m_BulkQueries.erase(itor);
+    } else {
+      ++itor;
+    }
+  }
+
+  struct File
+  {
+    unsigned int id;
+    QString path;
+    QByteArray hash;
+  };
+
+  std::vector<File> files;
+  std::size_t toHash = 0;
+
+  for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
+    const DownloadInfo* info = m_ActiveDownloads[i];
+
+    if (info->m_State < STATE_READY || !isInfoIncomplete(i) || m_BulkQueries.count(info->m_DownloadID) > 0) {
+      continue;
+    }
+
+    // downloads hashed while they were received or by an earlier query have
+    // their hash in the meta file
+    files.push_back({info->m_DownloadID, getFilePath(i), info->m_Hash});
+
+    if (info->m_Hash.isEmpty()) {
+      ++toHash;
+    }
+  }
+
+  if (files.empty()) {
+    emit showMessage(tr("No download is missing its info"));
+    return;
+  }
+
+  log::debug("identifying {} downloads, {} need to be hashed", files.size(), toHash);
+
+  if (toHash > 0) {
+    std::atomic<std::size_t> done = 0;
+    TaskGroup group(TaskPriority::High);
+
+    for (auto& f : files) {
+      if (!f.hash.isEmpty()) {
+        continue;
+      }
+
+      group.run([&f, &done, &group] {
+        f.hash = hashMapped(f.path, HASH_MAP_SIZE, group);
+        ++done;
+      });
+    }
+
+    QProgressDialog progress(
+      tr("Hashing downloads..."), tr("Cancel"), 0, static_cast<int>(toHash));
+
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setAutoReset(false);
+    progress.setMinimumDuration(500);
+
+    QEventLoop loop;
+    QTimer timer;
+
+    connect(&progress, &QProgressDialog::canceled, [&]{ group.cancel(); });
+
+    connect(&timer, &QTimer::timeout, [&]{
+      progress.setValue(static_cast<int>(done.load()));
+
+      if (group.finished()) {
+        loop.quit();
+      }
+    });
+
+    timer.start(50);
+    loop.exec();
+    group.wait();
+
+    // the hashes that were done are kept even if the user canceled, they'll
+    // be saved in the meta files later
+    for (const auto& f : files) {
+      if (DownloadInfo* info = downloadInfoByID(f.id)) {
+        if (info->m_Hash.isEmpty() && !f.hash.isEmpty()) {
+          info->m_Hash = f.hash;
+        }
+      }
+    }
+
+    if (group.cancelled()) {
+      log::debug("identifying downloads canceled");
+      return;
+    }
+  }
+
+  // events were processed while hashing, downloads may have been removed or
+  // queried by the user
+  int queried = 0;
+
+  for (const auto& f : files) {
+    DownloadInfo* info = downloadInfoByID(f.id);
+    if (info == nullptr || f.hash.isEmpty() || info->m_State < STATE_READY) {
+      continue;
+    }
+
+    info->m_Hash = f.hash;
+    info->m_GamesToQuery = QStringList(m_ManagedGame->gameShortName()) + m_ManagedGame->validShortNames();
+
+    // the replies would show a message or a dialog for every download
+    info->m_ReQueried = false;
+
+    m_BulkQueries[f.id] = info->m_State;
+    setState(info, STATE_FETCHINGMODINFO_MD5);
+    ++queried;
+  }
+
+  log::info("looking up {} downloads by md5", queried);
+}
+
+bool DownloadManager::finishBulkQuery(DownloadInfo *info)
+{
+  auto itor = m_BulkQueries.find(info->m_DownloadID);
+  if (itor == m_BulkQueries.end()) {
+    return false;
+  }
+
+  // the query doesn't change whether the download was installed
+  info->m_State = itor->second;
+
+  m_BulkQueries.erase(itor);
+  m_BulkFinished.push_back(info->m_DownloadID);
+
+  if (m_BulkQueries.empty()) {
+    writeBulkMeta();
+  } else if (!m_BulkMetaTimer.isActive()) {
+    m_BulkMetaTimer.start();
+  }
+
+  return true;
+}
+
+void DownloadManager::writeBulkMeta()
+{
+  m_BulkMetaTimer.stop();
+
+  if (m_BulkFinished.empty()) {
+    return;
+  }
+
+  int written = 0;
+  int identified = 0;
+
+  //Avoid triggering refreshes from DirWatcher
+  startDisableDirWatcher();
+
+  for (const unsigned int id : m_BulkFinished) {
+    DownloadInfo* info = downloadInfoByID(id);
+    if (info == nullptr) {
+      continue;
+    }
+
+    writeMetaFile(info);
+    ++written;
+
+    if (info->m_FileInfo->modID != 0 && info->m_FileInfo->fileID != 0) {
+      ++identified;
+    }
+  }
+
+  endDisableDirWatcher();
+
+  log::info(
+    "identified {} of {} downloads, {} still being looked up",
+    identified, written, m_BulkQueries.size());
+
+  m_BulkFinished.clear();
+  emit update(-1);
+}
+
+
+QByteArray DownloadManager::hashFile(DownloadInfo *info)
+{
   QFile downloadFile(info->m_FileName);
   if (!downloadFile.exists()) {
     downloadFile.setFileName(m_OrganizerCore->downloadsPath() + "\\" + info->m_FileName);
   }
   if (!downloadFile.exists()) {
     log::error("Can't find download file '{}'", info->m_FileName);
-    return;
+    return {};
   }
   if (!downloadFile.open(QIODevice::ReadOnly)) {
     log::error("Can't open download file '{}'", info->m_FileName);
-    return;
+    return {};
   }
 
   QCryptographicHash hash(QCryptographicHash::Md5);
@@ -1077,15 +1556,13 @@ void DownloadManager::queryInfoMd5(int index)
   }
   if (progress.wasCanceled()) {
     downloadFile.close();
-    return;
+    return {};
   }
 
   progress.close();
   downloadFile.close();
 
-  info->m_Hash = hash.result();
-  info->m_ReQueried = true;
-  setState(info, STATE_FETCHINGMODINFO_MD5);
+  return hash.result();
 }
 
 void DownloadManager::visitOnNexus(int index)
@@ -1190,10 +1667,24 @@ int DownloadManager::numTotalDownloads() const
   return m_ActiveDownloads.size();
 }
 
-int DownloadManager::numPendingDownloads() const
+double DownloadManager::currentSpeed() const
 {
-  return m_PendingDownloads.size();
-}
+  double speed = 0;
+
+  for (const DownloadInfo *info : m_ActiveDownloads) {
+    if (info->m_State == STATE_DOWNLOADING) {
+      // same as in publishProgress()
+      speed += (std::get<4>(info->m_SpeedDiff) * 1000.0) / (5 * 1000);
+    }
+  }
+
+  return speed;
+}
+
+int DownloadManager::numPendingDownloads() const
+{
+  return m_PendingDownloads.size();
+}
 
 std::tuple<QString, int, int> DownloadManager::getPendingDownload(int index)
 {
@@ -1319,6 +1810,14 @@ bool DownloadManager::isInfoIncomplete(int index) const
 }
 
 
+unsigned int DownloadManager::getDownloadID(int index) const
+{
+  if ((index < 0) || (index >= m_ActiveDownloads.size())) {
+    throw MyException(tr("download id: invalid download index %1").arg(index));
+  }
+  return m_ActiveDownloads.at(index)->m_DownloadID;
+}
+
 int DownloadManager::getModID(int index) const
 {
   if ((index < 0) || (index >= m_ActiveDownloads.size())) {
@@ -1431,6 +1930,26 @@ void DownloadManager::markUninstalled(int index)
 }
 
 
+bool DownloadManager::installWhenFinished(int index) const
+{
+  if ((index < 0) || (index >= m_ActiveDownloads.size())) {
+    throw MyException(tr("install when finished: invalid download index %1").arg(index));
+  }
+
+  return m_ActiveDownloads.at(index)->m_InstallWhenFinished;
+}
+
+void DownloadManager::setInstallWhenFinished(int index, bool b)
+{
+  if ((index < 0) || (index >= m_ActiveDownloads.size())) {
+    throw MyException(tr("install when finished: invalid download index %1").arg(index));
+  }
+
+  m_ActiveDownloads.at(index)->m_InstallWhenFinished = b;
+  emit update(index);
+}
+
+
 void DownloadManager::markUninstalled(QString fileName)
 {
   int index = indexByName(fileName);
@@ -1496,17 +2015,28 @@ void DownloadManager::setState(DownloadManager::DownloadInfo *info, DownloadMana
   info->m_State = state;
   switch (state) {
     case STATE_PAUSED: {
-      info->m_Reply->abort();
+      if (info->m_Reply != nullptr) {
+        info->m_Reply->abort();
+      }
+      abortSegments(info);
+      flushData(info);
       info->m_Output.close();
       m_DownloadPaused(row);
     } break;
     case STATE_ERROR: {
-      info->m_Reply->abort();
+      if (info->m_Reply != nullptr) {
+        info->m_Reply->abort();
+      }
+      abortSegments(info);
+      flushData(info);
       info->m_Output.close();
       m_DownloadFailed(row);
     } break;
     case STATE_CANCELED: {
-      info->m_Reply->abort();
+      if (info->m_Reply != nullptr) {
+        info->m_Reply->abort();
+      }
+      abortSegments(info);
       m_DownloadFailed(row);
     } break;
     case STATE_FETCHINGMODINFO: {
@@ -1517,30 +2047,83 @@ void DownloadManager::setState(DownloadManager::DownloadInfo *info, DownloadMana
     } break;
     case STATE_FETCHINGMODINFO_MD5: {
       log::debug("Searching {} for MD5 of {}", info->m_GamesToQuery[0], QString(info->m_Hash.toHex()));
-      m_RequestIDs.insert(m_NexusInterface->requestInfoFromMd5(info->m_GamesToQuery[0], info->m_Hash, this, info->m_DownloadID, QString()));
+      if (m_BulkQueries.count(info->m_DownloadID) > 0) {
+        m_RequestIDs.insert(m_NexusInterface->requestInfoFromMd5Bulk(info->m_GamesToQuery[0], info->m_Hash, this, info->m_DownloadID, QString()));
+      } else {
+        m_RequestIDs.insert(m_NexusInterface->requestInfoFromMd5(info->m_GamesToQuery[0], info->m_Hash, this, info->m_DownloadID, QString()));
+      }
     } break;
     case STATE_READY: {
-      createMetaFile(info);
+      if (!finishBulkQuery(info)) {
+        createMetaFile(info);
+      }
+
       m_DownloadComplete(row);
+
+      if (info->m_InstallWhenFinished) {
+        // handed over right away, the data that was just written is still in
+        // the file cache when the installer reads it back
+        info->m_InstallWhenFinished = false;
+        emit readyToInstall(info->m_FileName);
+      }
     } break;
     default: /* NOP */ break;
   }
+
+  if (state != STATE_DOWNLOADING) {
+    // this might have freed a slot for a queued download
+    m_ScheduleTimer.start();
+  }
+
   emit stateChanged(row, state);
 }
 
 
 DownloadManager::DownloadInfo *DownloadManager::findDownload(QObject *reply, int *index) const
 {
-  // reverse search as newer, thus more relevant, downloads are at the end
-  for (int i = m_ActiveDownloads.size() - 1; i >= 0; --i) {
-    if (m_ActiveDownloads[i]->m_Reply == reply) {
-      if (index != nullptr) {
-        *index = i;
-      }
-      return m_ActiveDownloads[i];
+  if (reply == nullptr) {
+    return nullptr;
+  }
+
+  const int i = findIndex<const QObject*>(m_IndexByReply, reply, [&](auto&& d) {
+    return (d.m_Reply == reply);
+  });
+
+  if (i < 0) {
+    return nullptr;
+  }
+
+  if (index != nullptr) {
+    *index = i;
+  }
+
+  return m_ActiveDownloads[i];
+}
+
+void DownloadManager::rebuildIndices() const
+{
+  m_IndexByInfo.clear();
+  m_IndexByReply.clear();
+  m_IndexByName.clear();
+  m_IndexByID.clear();
+
+  for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
+    const DownloadInfo* info = m_ActiveDownloads[i];
+
+    m_IndexByInfo.insert(info, i);
+    m_IndexByID.insert(info->m_DownloadID, i);
+
+    // newer, thus more relevant, downloads are at the end
+    if (info->m_Reply != nullptr) {
+      m_IndexByReply.insert(info->m_Reply, i);
+    }
+
+    // the first download with a name wins
+    const auto name = info->m_FileName.toLower();
+    if (!m_IndexByName.contains(name)) {
+      m_IndexByName.insert(name, i);
     }
   }
-  return nullptr;
 }
 
 
@@ -1560,34 +2143,65 @@ void DownloadManager::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
         setState(info, STATE_PAUSED);
       }
       else {
-        if (bytesTotal > info->m_TotalSize) {
-          info->m_TotalSize = bytesTotal;
-        }
-        int oldProgress = info->m_Progress.first;
-        info->m_Progress.first = ((info->m_ResumePos + bytesReceived) * 100) / (info->m_ResumePos + bytesTotal);
+        updateProgress(info, index, bytesReceived, bytesTotal);
+      }
+    }
+  } catch (const std::bad_alloc&) {
+    reportError(tr("Memory allocation error (in processing progress event)."));
+  }
+}
 
-        int elapsed = info->m_StartTime.elapsed();
-        std::get<0>(info->m_SpeedDiff) = bytesReceived - std::get<2>(info->m_SpeedDiff);
-        std::get<1>(info->m_SpeedDiff) = elapsed - std::get<3>(info->m_SpeedDiff);
-        std::get<2>(info->m_SpeedDiff) = bytesReceived;
-        std::get<3>(info->m_SpeedDiff) = elapsed;
 
-        double calc = ((double)std::get<0>(info->m_SpeedDiff)) / (((double)(std::get<1>(info->m_SpeedDiff)) / 5000.0));
-        std::get<4>(info->m_SpeedDiff) = ((calc*0.5) + (std::get<4>(info->m_SpeedDiff)*1.5)) / 2;
+void DownloadManager::updateProgress(DownloadInfo *info, int index, qint64 bytesReceived, qint64 bytesTotal)
+{
+  if (bytesTotal > info->m_TotalSize) {
+    info->m_TotalSize = bytesTotal;
+  }
+  int oldProgress = info->m_Progress.first;
+  info->m_Progress.first = ((info->m_ResumePos + bytesReceived) * 100) / (info->m_ResumePos + bytesTotal);
 
-        // calculate the download speed
-        const double speed = (std::get<4>(info->m_SpeedDiff) * 1000.0) / (5 * 1000);
+  int elapsed = info->m_StartTime.elapsed();
+  std::get<0>(info->m_SpeedDiff) = bytesReceived - std::get<2>(info->m_SpeedDiff);
+  std::get<1>(info->m_SpeedDiff) = elapsed - std::get<3>(info->m_SpeedDiff);
+  std::get<2>(info->m_SpeedDiff) = bytesReceived;
+  std::get<3>(info->m_SpeedDiff) = elapsed;
 
-        info->m_Progress.second = QString::fromLatin1("%1% - %2")
-          .arg(info->m_Progress.first)
-          .arg(MOBase::localizedByteSpeed(speed));
+  double calc = ((double)std::get<0>(info->m_SpeedDiff)) / (((double)(std::get<1>(info->m_SpeedDiff)) / 5000.0));
+  std::get<4>(info->m_SpeedDiff) = ((calc*0.5) + (std::get<4>(info->m_SpeedDiff)*1.5)) / 2;
 
-        TaskProgressManager::instance().updateProgress(info->m_TaskProgressId, bytesReceived, bytesTotal);
-        emit update(index);
-      }
+  info->m_ProgressBytes = {bytesReceived, bytesTotal};
+
+  // progress signals come for every chunk, the view is only updated a few
+  // times per second
+  m_ProgressChanged.insert(info->m_DownloadID);
+  if (!m_ProgressTimer.isActive()) {
+    m_ProgressTimer.start();
+  }
+}
+
+
+void DownloadManager::publishProgress()
+{
+  std::set<unsigned int> changed;
+  changed.swap(m_ProgressChanged);
+
+  for (unsigned int id : changed) {
+    DownloadInfo *info = downloadInfoByID(id);
+    if ((info == nullptr) || (info->m_State != STATE_DOWNLOADING)) {
+      continue;
     }
-  } catch (const std::bad_alloc&) {
-    reportError(tr("Memory allocation error (in processing progress event)."));
+
+    // calculate the download speed
+    const double speed = (std::get<4>(info->m_SpeedDiff) * 1000.0) / (5 * 1000);
+
+    info->m_Progress.second = QString::fromLatin1("%1% - %2")
+      .arg(info->m_Progress.first)
+      .arg(MOBase::localizedByteSpeed(speed));
+
+    TaskProgressManager::instance().updateProgress(
+      info->m_TaskProgressId, info->m_ProgressBytes.first, info->m_ProgressBytes.second);
+
+    emit progressChanged(indexByInfo(info));
   }
 }
 
@@ -1595,7 +2209,7 @@ void DownloadManager::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 void DownloadManager::downloadReadyRead()
 {
   try {
-    writeData(findDownload(this->sender()));
+    writeData(findDownload(this->sender()), true);
   } catch (const std::bad_alloc&) {
     reportError(tr("Memory allocation error (in processing downloaded data)."));
   }
@@ -1606,7 +2220,19 @@ void DownloadManager::createMetaFile(DownloadInfo *info)
 {
   //Avoid triggering refreshes from DirWatcher
   startDisableDirWatcher();
+  writeMetaFile(info);
+  endDisableDirWatcher();
 
+  // slightly hackish...
+  for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
+    if (m_ActiveDownloads[i] == info) {
+      emit update(i);
+    }
+  }
+}
+
+void DownloadManager::writeMetaFile(DownloadInfo *info)
+{
   QSettings metaFile(QString("%1.meta").arg(info->m_Output.fileName()), QSettings::IniFormat);
   metaFile.setValue("gameName", info->m_FileInfo->gameName);
   metaFile.setValue("modID", info->m_FileInfo->modID);
@@ -1628,12 +2254,19 @@ void DownloadManager::createMetaFile(DownloadInfo *info)
                               (info->m_State == DownloadManager::STATE_ERROR));
   metaFile.setValue("removed", info->m_Hidden);
 
-  endDisableDirWatcher();
-  // slightly hackish...
-  for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
-    if (m_ActiveDownloads[i] == info) {
-      emit update(i);
+  if (!info->m_Hash.isEmpty()) {
+    metaFile.setValue("md5", QString(info->m_Hash.toHex()));
+  }
+
+  if (info->m_Segments.empty()) {
+    metaFile.remove("segments");
+  } else {
+    QStringList segments;
+    for (const auto& segment : info->m_Segments) {
+      segments.append(QString("%1:%2:%3")
+        .arg(segment.begin).arg(segment.end).arg(segment.received));
     }
+    metaFile.setValue("segments", segments);
   }
 }
 
@@ -1784,7 +2417,13 @@ void DownloadManager::nxmFileInfoAvailable(QString gameName, int modID, int file
   info->fileID = fileID;
 
   QObject *test = info;
-  m_RequestIDs.insert(m_NexusInterface->requestDownloadURL(info->gameName, info->modID, info->fileID, this, QVariant::fromValue(test), QString()));
+  const int id = m_NexusInterface->requestDownloadURL(info->gameName, info->modID, info->fileID, this, QVariant::fromValue(test), QString());
+  m_RequestIDs.insert(id);
+
+  // the lookup goes on with this request
+  if (m_NXMLookups.erase(requestID) > 0) {
+    m_NXMLookups.insert(id);
+  }
 }
 
 static int evaluateFileInfoMap(
@@ -1862,22 +2501,20 @@ boost::signals2::connection DownloadManager::onDownloadRemoved(const std::functi
 
 int DownloadManager::indexByName(const QString &fileName) const
 {
-  for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
-    if (m_ActiveDownloads[i]->m_FileName == fileName) {
-      return i;
-    }
-  }
-  return -1;
+  return findIndex(m_IndexByName, fileName.toLower(), [&](auto&& d) {
+    return (d.m_FileName.compare(fileName, Qt::CaseInsensitive) == 0);
+  });
 }
 
 int DownloadManager::indexByInfo(const DownloadInfo* info) const
 {
-  for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
-    if (m_ActiveDownloads[i] == info) {
-      return i;
-    }
+  if (info == nullptr) {
+    return -1;
   }
-  return -1;
+
+  return findIndex(m_IndexByInfo, info, [&](auto&& d) {
+    return (&d == info);
+  });
 }
 
 void DownloadManager::nxmDownloadURLsAvailable(QString gameName, int modID, int fileID, QVariant userData, QVariant resultData, int requestID)
@@ -1891,6 +2528,10 @@ void DownloadManager::nxmDownloadURLsAvailable(QString gameName, int modID, int
     m_RequestIDs.erase(idIter);
   }
 
+  if (m_NXMLookups.erase(requestID) > 0) {
+    startNXMLookups();
+  }
+
   ModRepositoryFileInfo *info = qobject_cast<ModRepositoryFileInfo*>(qvariant_cast<QObject*>(userData));
   QVariantList resultList = resultData.toList();
   if (resultList.length() == 0) {
@@ -1973,7 +2614,15 @@ void DownloadManager::nxmFileInfoFromMd5Available(QString gameName, QVariant use
   if (chosenIdx < 0) {
     //don't use the normal state set function as we don't want to create a meta file
     info->m_State = DownloadManager::STATE_READY;
-    queryInfo(m_ActiveDownloads.indexOf(info));
+
+    // asking for the mod id of thousands of files isn't an option, these are
+    // left for the user to query one by one
+    if (finishBulkQuery(info)) {
+      emit update(indexByInfo(info));
+      return;
+    }
+
+    queryInfo(indexByInfo(info));
     return;
   }
 
@@ -2025,6 +2674,10 @@ void DownloadManager::nxmRequestFailed(QString gameName, int modID, int fileID,
     m_RequestIDs.erase(idIter);
   }
 
+  if (m_NXMLookups.erase(requestID) > 0) {
+    startNXMLookups();
+  }
+
   DownloadInfo *userDataInfo = downloadInfoByID(userData.toInt());
 
   int index = 0;
@@ -2042,7 +2695,9 @@ void DownloadManager::nxmRequestFailed(QString gameName, int modID, int fileID,
         return;
       } else {
         info->m_State = STATE_READY;
-        queryInfo(index);
+        if (!finishBulkQuery(info)) {
+          queryInfo(index);
+        }
         emit update(index);
         return;
       }
@@ -2050,12 +2705,14 @@ void DownloadManager::nxmRequestFailed(QString gameName, int modID, int fileID,
 
     if (info->m_FileInfo->modID == modID) {
       if (info->m_State < STATE_FETCHINGMODINFO) {
+        emit aboutToUpdate();
         m_ActiveDownloads.erase(iter);
         delete info;
+        emit update(-1);
       } else {
         setState(info, STATE_READY);
+        emit update(index);
       }
-      emit update(index);
       break;
     }
   }
@@ -2076,8 +2733,10 @@ void DownloadManager::downloadFinished(int index)
   if (info != nullptr) {
     QNetworkReply *reply = info->m_Reply;
     QByteArray data;
+    flushData(info);
     if (reply->isOpen() && info->m_HasData) {
       data = reply->readAll();
+      hashData(info, data);
       info->m_Output.write(data);
     }
     info->m_Output.close();
@@ -2124,44 +2783,7 @@ void DownloadManager::downloadFinished(int index)
       createMetaFile(info);
       emit update(index);
     } else {
-      QString url = info->m_Urls[info->m_CurrentUrl];
-      if (info->m_FileInfo->userData.contains("downloadMap")) {
-        foreach (const QVariant &server, info->m_FileInfo->userData["downloadMap"].toList()) {
-          QVariantMap serverMap = server.toMap();
-          if (serverMap["URI"].toString() == url) {
-            int deltaTime = info->m_StartTime.elapsed() / 1000;
-            if (deltaTime > 5) {
-              emit downloadSpeed(serverMap["short_name"].toString(), (info->m_TotalSize - info->m_PreResumeSize) / deltaTime);
-            } // no division by zero please! Also, if the download is shorter than a few seconds, the result is way to inprecise
-            break;
-          }
-        }
-      }
-
-      bool isNexus = info->m_FileInfo->repository == "Nexus";
-      // need to change state before changing the file name, otherwise .unfinished is appended
-      if (isNexus) {
-        setState(info, STATE_FETCHINGMODINFO);
-      } else {
-        setState(info, STATE_NOFETCH);
-      }
-
-      QString newName = getFileNameFromNetworkReply(reply);
-      QString oldName = QFileInfo(info->m_Output).fileName();
-
-      startDisableDirWatcher();
-      if (!newName.isEmpty() && (oldName.isEmpty())) {
-        info->setName(getDownloadFileName(newName), true);
-      } else {
-        info->setName(m_OutputDirectory + "/" + info->m_FileName, true); // don't rename but remove the ".unfinished" extension
-      }
-      endDisableDirWatcher();
-
-      if (!isNexus) {
-        setState(info, STATE_READY);
-      }
-
-      emit update(index);
+      downloadCompleted(info, index, getFileNameFromNetworkReply(reply));
     }
     reply->close();
     reply->deleteLater();
@@ -2176,6 +2798,59 @@ void DownloadManager::downloadFinished(int index)
 }
 
 
+void DownloadManager::downloadCompleted(DownloadInfo *info, int index, const QString &newName)
+{
+  if (info->m_Hasher && (info->m_HashedSize == info->m_Output.size())) {
+    info->m_Hash = info->m_Hasher->result();
+  }
+  info->m_Hasher.reset();
+
+  QString url = info->m_Urls[info->m_CurrentUrl];
+  if (info->m_FileInfo->userData.contains("downloadMap")) {
+    foreach (const QVariant &server, info->m_FileInfo->userData["downloadMap"].toList()) {
+      QVariantMap serverMap = server.toMap();
+      if (serverMap["URI"].toString() == url) {
+        int deltaTime = info->m_StartTime.elapsed() / 1000;
+        if (deltaTime > 5) {
+          emit downloadSpeed(serverMap["short_name"].toString(), (info->m_TotalSize - info->m_PreResumeSize) / deltaTime);
+        } // no division by zero please! Also, if the download is shorter than a few seconds, the result is way to inprecise
+        break;
+      }
+    }
+  }
+
+  if (const auto elapsed = info->m_StartTime.elapsed(); elapsed > 0) {
+    Metrics::value(
+      "download.speed",
+      (info->m_TotalSize - info->m_PreResumeSize) * 1000.0 / elapsed, "B/s");
+  }
+
+  bool isNexus = info->m_FileInfo->repository == "Nexus";
+  // need to change state before changing the file name, otherwise .unfinished is appended
+  if (isNexus) {
+    setState(info, STATE_FETCHINGMODINFO);
+  } else {
+    setState(info, STATE_NOFETCH);
+  }
+
+  QString oldName = QFileInfo(info->m_Output).fileName();
+
+  startDisableDirWatcher();
+  if (!newName.isEmpty() && (oldName.isEmpty())) {
+    info->setName(getDownloadFileName(newName), true);
+  } else {
+    info->setName(m_OutputDirectory + "/" + info->m_FileName, true); // don't rename but remove the ".unfinished" extension
+  }
+  endDisableDirWatcher();
+
+  if (!isNexus) {
+    setState(info, STATE_READY);
+  }
+
+  emit update(index);
+}
+
+
 void DownloadManager::downloadError(QNetworkReply::NetworkError error)
 {
   if (error != QNetworkReply::OperationCanceledError) {
@@ -2202,17 +2877,37 @@ void DownloadManager::metaDataChanged()
       if (!info->m_Output.isOpen() && !info->m_Output.open(QIODevice::WriteOnly | QIODevice::Append)) {
         reportError(tr("failed to re-open %1").arg(info->m_FileName));
         setState(info, STATE_CANCELING);
+        return;
       }
     }
+
+    if (queueDownload(info, index)) {
+      return;
+    }
+
+    startSegmented(info, info->m_Reply);
   } else {
     log::warn("meta data event for unknown download");
   }
 }
 
-void DownloadManager::directoryChanged(const QString&)
+void DownloadManager::directoryChanged(const QString&, const QStringList &paths)
 {
-  if(DownloadManager::m_DirWatcherDisabler==0)
+  // only the files directly in the directory are listed, downloads in
+  // progress are written to all the time and the .meta files are written by
+  // MO whenever the state of a download changes; the other changes made by MO
+  // itself have already been dropped, see startDisableDirWatcher()
+  const bool listed = paths.isEmpty() || std::any_of(
+    paths.begin(), paths.end(), [](const QString& p) {
+      return
+        !p.contains('\\') &&
+        !p.endsWith(UNFINISHED) &&
+        !p.endsWith(".meta");
+    });
+
+  if (listed) {
     refreshList();
+  }
 }
 
 void DownloadManager::managedGameChanged(MOBase::IPluginGame const *managedGame)
@@ -2223,9 +2918,11 @@ void DownloadManager::managedGameChanged(MOBase::IPluginGame const *managedGame)
 void DownloadManager::checkDownloadTimeout()
 {
   for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
+    // a reply that still has data can't receive more only because the rate
+    // limits didn't allow reading it yet, it's not stalled
     if (m_ActiveDownloads[i]->m_StartTime.elapsed() - std::get<3>(m_ActiveDownloads[i]->m_SpeedDiff) > 5 * 1000 &&
         m_ActiveDownloads[i]->m_State == STATE_DOWNLOADING && m_ActiveDownloads[i]->m_Reply != nullptr &&
-        m_ActiveDownloads[i]->m_Reply->isOpen()) {
+        m_ActiveDownloads[i]->m_Reply->isOpen() && m_ActiveDownloads[i]->m_Reply->bytesAvailable() == 0) {
       pauseDownload(i);
       downloadFinished(i);
       resumeDownload(i);
@@ -2233,11 +2930,35 @@ void DownloadManager::checkDownloadTimeout()
   }
 }
 
-void DownloadManager::writeData(DownloadInfo *info)
+void DownloadManager::writeData(DownloadInfo *info, bool throttle)
 {
   if (info != nullptr) {
-    qint64 ret = info->m_Output.write(info->m_Reply->readAll());
-    if (ret < info->m_Reply->size()) {
+    QByteArray data;
+
+    if (throttle) {
+      data = info->m_Reply->read(allowedBytes(info, info->m_Reply->bytesAvailable()));
+
+      if (info->m_Reply->bytesAvailable() > 0 && !m_ThrottleTimer.isActive()) {
+        m_ThrottleTimer.start();
+      }
+    } else {
+      data = info->m_Reply->readAll();
+    }
+
+    consumeBytes(info, data.size());
+    hashData(info, data);
+
+    // small chunks are collected and written in one go, see flushData()
+    info->m_Pending.append(data);
+    if (info->m_Pending.size() < WRITE_BUFFER_SIZE) {
+      return;
+    }
+
+    qint64 ret = info->m_Output.write(info->m_Pending);
+    const bool failed = (ret < info->m_Pending.size());
+    info->m_Pending.clear();
+
+    if (failed) {
       QString fileName = info->m_FileName; // m_FileName may be destroyed after setState
       setState(info, DownloadState::STATE_CANCELED);
 
@@ -2251,3 +2972,585 @@ void DownloadManager::writeData(DownloadInfo *info)
     }
   }
 }
+
+void DownloadManager::hashData(DownloadInfo *info, const QByteArray& data)
+{
+  if (info->m_Hasher) {
+    info->m_Hasher->addData(data);
+    info->m_HashedSize += data.size();
+  }
+}
+
+qint64 DownloadManager::allowedBytes(DownloadInfo *info, qint64 wanted)
+{
+  return std::min({wanted, m_Bandwidth.available(), info->m_Bandwidth.available()});
+}
+
+void DownloadManager::consumeBytes(DownloadInfo *info, qint64 bytes)
+{
+  m_Bandwidth.consume(bytes);
+  info->m_Bandwidth.consume(bytes);
+}
+
+void DownloadManager::readThrottled()
+{
+  try {
+    for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
+      DownloadInfo *info = m_ActiveDownloads[i];
+
+      if (info->m_State != STATE_DOWNLOADING) {
+        continue;
+      }
+
+      if (info->m_Segments.empty()) {
+        if ((info->m_Reply != nullptr) && (info->m_Reply->bytesAvailable() > 0)) {
+          writeData(info, true);
+        }
+
+        continue;
+      }
+
+      for (std::size_t s = 0; s < info->m_Segments.size(); ++s) {
+        if (info->m_State != STATE_DOWNLOADING) {
+          break;
+        }
+
+        QNetworkReply* reply = info->m_Segments[s].reply;
+        if ((reply != nullptr) && (reply->bytesAvailable() > 0)) {
+          readSegment(info, i, s);
+        }
+      }
+    }
+  } catch (const std::bad_alloc&) {
+    reportError(tr("Memory allocation error (in processing downloaded data)."));
+  }
+}
+
+int DownloadManager::transferringCount() const
+{
+  int count = 0;
+
+  for (const DownloadInfo *info : m_ActiveDownloads) {
+    if (info->m_Admitted && (info->m_State == STATE_DOWNLOADING)) {
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+bool DownloadManager::queueDownload(DownloadInfo *info, int index)
+{
+  if (info->m_Admitted || (info->m_State != STATE_DOWNLOADING)) {
+    return false;
+  }
+
+  // the size is used to start smaller downloads first
+  const qint64 size = info->m_Reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+  if (info->m_ResumePos + size > info->m_TotalSize) {
+    info->m_TotalSize = info->m_ResumePos + size;
+  }
+
+  if ((m_MaxDownloads == 0) || (transferringCount() < m_MaxDownloads)) {
+    info->m_Admitted = true;
+    info->m_Queued = false;
+    return false;
+  }
+
+  log::debug(
+    "{} downloads in progress, queueing {}",
+    m_MaxDownloads, info->m_FileName);
+
+  // this goes through the normal pause handling, the reply is aborted the next
+  // time it reports progress
+  info->m_Queued = true;
+  setState(info, STATE_PAUSING);
+  emit update(index);
+
+  return true;
+}
+
+void DownloadManager::startQueued()
+{
+  for (;;) {
+    if ((m_MaxDownloads > 0) && (transferringCount() >= m_MaxDownloads)) {
+      return;
+    }
+
+    // smallest remaining size first, unknown sizes last
+    int next = -1;
+    qint64 nextLeft = 0;
+
+    for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
+      DownloadInfo *info = m_ActiveDownloads[i];
+      if (!info->m_Queued || (info->m_State != STATE_PAUSED)) {
+        continue;
+      }
+
+      const qint64 left = (info->m_TotalSize > 0) ?
+        info->m_TotalSize - info->m_Output.size() :
+        std::numeric_limits<qint64>::max();
+
+      if ((next == -1) || (left < nextLeft)) {
+        next = i;
+        nextLeft = left;
+      }
+    }
+
+    if (next == -1) {
+      return;
+    }
+
+    DownloadInfo *info = m_ActiveDownloads[next];
+    log::debug("resuming queued download {}", info->m_FileName);
+
+    // resumeDownload() may fail without changing the state, so the download
+    // is taken out of the queue first
+    info->m_Queued = false;
+    info->m_Admitted = true;
+    resumeDownload(next);
+  }
+}
+
+bool DownloadManager::startSegmented(DownloadInfo *info, QNetworkReply *reply)
+{
+  if (!info->m_Segments.empty() || reply == nullptr || info->m_Urls.isEmpty()) {
+    return false;
+  }
+
+  // only fresh downloads are split, a resumed download continues on its
+  // single connection
+  if (info->m_State != STATE_DOWNLOADING || info->m_ResumePos != 0) {
+    return false;
+  }
+
+  const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  const QByteArray ranges = reply->rawHeader("Accept-Ranges").trimmed().toLower();
+  const qint64 total = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+
+  if (status != 200 || ranges != "bytes" || total < 2 * SEGMENT_MIN_SIZE) {
+    return false;
+  }
+
+  const int count = static_cast<int>(std::min<qint64>(SEGMENT_CONNECTIONS, total / SEGMENT_MIN_SIZE));
+
+  if (!info->m_Output.isOpen() || !info->m_Output.resize(total)) {
+    log::warn(
+      "can't preallocate {} bytes for {}, downloading on one connection",
+      total, info->m_Output.fileName());
+    return false;
+  }
+
+  log::debug(
+    "downloading {} bytes of {} on {} connections",
+    total, info->m_FileName, count);
+
+  // this reply is only used for the headers, the segments reopen the
+  // connections from the start
+  disconnect(reply, nullptr, this, nullptr);
+  reply->abort();
+  reply->deleteLater();
+  info->m_Reply = nullptr;
+
+  info->m_TotalSize = total;
+  info->m_ResumePos = 0;
+
+  // the segments don't arrive in order, the file is hashed when queried
+  info->m_Hasher.reset();
+
+  const qint64 size = (total + count - 1) / count;
+  for (int i = 0; i < count; ++i) {
+    DownloadInfo::Segment segment;
+    segment.begin = i * size;
+    segment.end = std::min(total, (i + 1) * size);
+
+    // spread the segments over the mirrors
+    segment.url = (info->m_CurrentUrl + i) % info->m_Urls.count();
+
+    info->m_Segments.push_back(segment);
+  }
+
+  createMetaFile(info);
+
+  for (std::size_t i = 0; i < info->m_Segments.size(); ++i) {
+    startSegment(info, i);
+  }
+
+  return true;
+}
+
+void DownloadManager::startSegment(DownloadInfo *info, std::size_t segment)
+{
+  auto& s = info->m_Segments[segment];
+
+  const QString url = info->m_Urls[s.url % info->m_Urls.count()];
+
+  QNetworkRequest request(QUrl::fromEncoded(url.toLocal8Bit()));
+  request.setHeader(QNetworkRequest::UserAgentHeader, m_NexusInterface->getAccessManager()->userAgent());
+  request.setRawHeader("Range",
+    "bytes=" + QByteArray::number(s.begin + s.received) + "-" + QByteArray::number(s.end - 1));
+
+  s.reply = m_NexusInterface->getAccessManager()->get(request);
+  s.reply->setReadBufferSize(1024 * 1024);
+
+  connect(s.reply, SIGNAL(readyRead()), this, SLOT(segmentReadyRead()));
+  connect(s.reply, SIGNAL(finished()), this, SLOT(segmentFinished()));
+}
+
+bool DownloadManager::writeSegment(DownloadInfo *info, std::size_t segment, bool throttle)
+{
+  auto& s = info->m_Segments[segment];
+
+  // a server that ignores the range sends the whole file
+  const int status = s.reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  if (status != 206) {
+    log::warn("range request for {} answered with status {}", info->m_FileName, status);
+    return false;
+  }
+
+  QByteArray data;
+  if (throttle) {
+    data = s.reply->read(allowedBytes(info, s.reply->bytesAvailable()));
+
+    if (s.reply->bytesAvailable() > 0 && !m_ThrottleTimer.isActive()) {
+      m_ThrottleTimer.start();
+    }
+  } else {
+    data = s.reply->readAll();
+  }
+
+  consumeBytes(info, data.size());
+
+  const qint64 left = s.end - s.begin - s.received - s.pending.size();
+  if (data.size() > left) {
+    data.truncate(static_cast<int>(left));
+  }
+
+  if (data.isEmpty()) {
+    return true;
+  }
+
+  info->m_HasData = true;
+  s.pending.append(data);
+
+  // the last bytes of a segment are always written right away so complete()
+  // is true as soon as everything was received
+  if (s.pending.size() < WRITE_BUFFER_SIZE && data.size() < left) {
+    return true;
+  }
+
+  const qint64 ret = writePending(info, segment);
+
+  if (ret < 0) {
+    QString fileName = info->m_FileName; // m_FileName may be destroyed after setState
+    setState(info, DownloadState::STATE_CANCELED);
+
+    log::error(
+      "Unable to write download \"{}\" to drive (return {})",
+      fileName, ret);
+
+    reportError(tr("Unable to write download to drive (return %1).\n"
+                   "Check the drive's available storage.\n\n"
+                   "Canceling download \"%2\"...").arg(ret).arg(fileName));
+
+    return false;
+  }
+
+  return true;
+}
+
+qint64 DownloadManager::writePending(DownloadInfo *info, std::size_t segment)
+{
+  auto& s = info->m_Segments[segment];
+
+  if (s.pending.isEmpty()) {
+    return 0;
+  }
+
+  qint64 ret = -1;
+  if (info->m_Output.isOpen() && info->m_Output.seek(s.begin + s.received)) {
+    ret = info->m_Output.write(s.pending);
+  }
+
+  // on failure, the bytes are not counted and will be downloaded again
+  if (ret == s.pending.size()) {
+    s.received += ret;
+  } else {
+    ret = -1;
+  }
+
+  s.pending.clear();
+
+  return ret;
+}
+
+void DownloadManager::flushData(DownloadInfo *info)
+{
+  if (!info->m_Pending.isEmpty()) {
+    const qint64 ret = info->m_Output.isOpen() ? info->m_Output.write(info->m_Pending) : -1;
+
+    if (ret < info->m_Pending.size()) {
+      log::error(
+        "Unable to write download "{}" to drive (return {})",
+        info->m_FileName, ret);
+    }
+
+    info->m_Pending.clear();
+  }
+
+  for (std::size_t i = 0; i < info->m_Segments.size(); ++i) {
+    if (writePending(info, i) < 0) {
+      log::error(
+        "Unable to write segment {} of download "{}" to drive",
+        i, info->m_FileName);
+    }
+  }
+}
+
+void DownloadManager::segmentReadyRead()
+{
+  int index = 0;
+  std::size_t segment = 0;
+
+  try {
+    DownloadInfo *info = findSegment(this->sender(), &index, &segment);
+    if (info == nullptr) {
+      return;
+    }
+
+    readSegment(info, index, segment);
+  } catch (const std::bad_alloc&) {
+    reportError(tr("Memory allocation error (in processing downloaded data)."));
+  }
+}
+
+void DownloadManager::readSegment(DownloadInfo *info, int index, std::size_t segment)
+{
+  if (info->m_State == STATE_CANCELING || info->m_State == STATE_PAUSING) {
+    stopSegmented(info, index);
+    return;
+  }
+
+  if (!writeSegment(info, segment, true)) {
+    if (info->m_State == STATE_DOWNLOADING) {
+      segmentFailed(info, index, segment);
+    } else if (info->m_State == STATE_CANCELED) {
+      stopSegmented(info, index);
+    }
+    return;
+  }
+
+  updateProgress(
+    info, index,
+    info->segmentsReceived() - info->m_ResumePos,
+    info->m_TotalSize - info->m_ResumePos);
+}
+
+void DownloadManager::segmentFinished()
+{
+  int index = 0;
+  std::size_t segment = 0;
+
+  DownloadInfo *info = findSegment(this->sender(), &index, &segment);
+  if (info == nullptr) {
+    return;
+  }
+
+  if (info->m_State == STATE_CANCELING || info->m_State == STATE_PAUSING) {
+    stopSegmented(info, index);
+    return;
+  }
+
+  auto& s = info->m_Segments[segment];
+
+  if (s.reply->error() != QNetworkReply::NoError) {
+    log::warn(
+      "segment {} of {} failed: {}",
+      segment, info->m_FileName, s.reply->errorString());
+
+    segmentFailed(info, index, segment);
+    return;
+  }
+
+  if (!writeSegment(info, segment)) {
+    if (info->m_State == STATE_DOWNLOADING) {
+      segmentFailed(info, index, segment);
+    } else if (info->m_State == STATE_CANCELED) {
+      stopSegmented(info, index);
+    }
+    return;
+  }
+
+  s.reply->deleteLater();
+  s.reply = nullptr;
+
+  if (!s.complete()) {
+    log::warn(
+      "segment {} of {} ended {} bytes early",
+      segment, info->m_FileName, s.end - s.begin - s.received);
+
+    segmentFailed(info, index, segment);
+    return;
+  }
+
+  for (const auto& other : info->m_Segments) {
+    if (!other.complete()) {
+      return;
+    }
+  }
+
+  completeSegmented(info, index);
+}
+
+void DownloadManager::segmentFailed(DownloadInfo *info, int index, std::size_t segment)
+{
+  auto& s = info->m_Segments[segment];
+
+  if (s.reply != nullptr) {
+    disconnect(s.reply, nullptr, this, nullptr);
+    s.reply->abort();
+    s.reply->deleteLater();
+    s.reply = nullptr;
+  }
+
+  // what was received so far is kept, the segment continues from there
+  if (writePending(info, segment) < 0) {
+    log::warn("segment {} of {} couldn't be written, downloading it again", segment, info->m_FileName);
+  }
+
+  if (info->m_Tries > 0) {
+    // try the next mirror for this segment, the others keep going
+    --info->m_Tries;
+    s.url = (s.url + 1) % info->m_Urls.count();
+    startSegment(info, segment);
+    return;
+  }
+
+  // the file is kept so the download can be resumed manually
+  emit showMessage(tr("Download failed: %1").arg(info->m_FileName));
+  setState(info, STATE_ERROR);
+  createMetaFile(info);
+  emit update(index);
+}
+
+void DownloadManager::resumeSegmented(DownloadInfo *info, int index)
+{
+  if (info->m_State == STATE_PAUSING) {
+    stopSegmented(info, index);
+  }
+
+  if (!info->isPausedState()) {
+    emit update(index);
+    return;
+  }
+
+  if ((info->m_Urls.size() == 0)
+      || ((info->m_Urls.size() == 1) && (info->m_Urls[0].size() == 0))) {
+    emit showMessage(tr("No known download urls. Sorry, this download can't be resumed."));
+    return;
+  }
+
+  // the file is preallocated, it must not be truncated
+  if (!info->m_Output.isOpen() && !info->m_Output.open(QIODevice::ReadWrite)) {
+    reportError(tr("failed to download %1: could not open output file: %2")
+                .arg(info->m_FileName).arg(info->m_Output.fileName()));
+    return;
+  }
+
+  info->m_ResumePos = info->segmentsReceived();
+  info->m_PreResumeSize = info->m_ResumePos;
+  info->m_SpeedDiff = std::tuple<int, int, int, int, int>(0, 0, 0, 0, 0);
+  info->m_StartTime.start();
+
+  log::debug(
+    "resuming {} at {} of {} bytes",
+    info->m_FileName, info->m_ResumePos, info->m_TotalSize);
+
+  setState(info, STATE_DOWNLOADING);
+  createMetaFile(info);
+
+  bool complete = true;
+
+  for (std::size_t i = 0; i < info->m_Segments.size(); ++i) {
+    if (!info->m_Segments[i].complete()) {
+      complete = false;
+      startSegment(info, i);
+    }
+  }
+
+  if (complete) {
+    completeSegmented(info, index);
+    return;
+  }
+
+  emit update(index);
+}
+
+void DownloadManager::stopSegmented(DownloadInfo *info, int index)
+{
+  abortSegments(info);
+  flushData(info);
+  info->m_Output.close();
+  TaskProgressManager::instance().forgetMe(info->m_TaskProgressId);
+
+  if (info->m_State == STATE_CANCELING || info->m_State == STATE_CANCELED) {
+    if (info->m_State == STATE_CANCELING) {
+      setState(info, STATE_CANCELED);
+    }
+
+    emit aboutToUpdate();
+    info->m_Output.remove();
+    delete info;
+    m_ActiveDownloads.erase(m_ActiveDownloads.begin() + index);
+    emit update(-1);
+  } else {
+    if (info->m_State == STATE_PAUSING) {
+      setState(info, STATE_PAUSED);
+    }
+
+    createMetaFile(info);
+    emit update(index);
+  }
+}
+
+void DownloadManager::completeSegmented(DownloadInfo *info, int index)
+{
+  flushData(info);
+  info->m_Output.close();
+  TaskProgressManager::instance().forgetMe(info->m_TaskProgressId);
+
+  // the meta file is written again when the state changes, without segments
+  info->m_Segments.clear();
+
+  downloadCompleted(info, index, QString());
+}
+
+void DownloadManager::abortSegments(DownloadInfo *info)
+{
+  for (auto& segment : info->m_Segments) {
+    if (segment.reply != nullptr) {
+      disconnect(segment.reply, nullptr, this, nullptr);
+      segment.reply->abort();
+      segment.reply->deleteLater();
+      segment.reply = nullptr;
+    }
+  }
+}
+
+DownloadManager::DownloadInfo *DownloadManager::findSegment(
+  QObject *reply, int *index, std::size_t *segment) const
+{
+  for (int i = m_ActiveDownloads.size() - 1; i >= 0; --i) {
+    const auto& segments = m_ActiveDownloads[i]->m_Segments;
+
+    for (std::size_t j = 0; j < segments.size(); ++j) {
+      if (segments[j].reply == reply) {
+        *index = i;
+        *segment = j;
+        return m_ActiveDownloads[i];
+      }
+    }
+  }
+
+  return nullptr;
+}
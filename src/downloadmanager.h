@@ -21,8 +21,11 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #define DOWNLOADMANAGER_H
 
 #include "serverinfo.h"
+#include "downloadmetacache.h"
+#include "tokenbucket.h"
 #include <idownloadmanager.h>
 #include <modrepositoryfileinfo.h>
+#include <map>
 #include <set>
 #include <QObject>
 #include <QUrl>
@@ -32,12 +35,16 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTime>
 #include <QTimer>
 #include <QElapsedTimer>
+#include <QCryptographicHash>
 #include <QVector>
 #include <QMap>
+#include <QHash>
 #include <QStringList>
-#include <QFileSystemWatcher>
 #include <QSettings>
 #include <boost/signals2.hpp>
+#include "directorywatcher.h"
+#include <memory>
+#include <vector>
 
 namespace MOBase { class IPluginGame; }
 
@@ -74,7 +81,21 @@ public:
 private:
 
   struct DownloadInfo {
-    ~DownloadInfo() { delete m_FileInfo; }
+    // a range of the file downloaded on its own connection, see
+    // DownloadManager::startSegmented()
+    struct Segment
+    {
+      qint64 begin = 0;     // offset of the first byte
+      qint64 end = 0;       // offset past the last byte
+      qint64 received = 0;  // bytes written so far, from begin
+      int url = 0;          // index in m_Urls
+      QNetworkReply* reply = nullptr;
+      QByteArray pending;   // received but not written yet, after received
+
+      bool complete() const { return begin + received >= end; }
+    };
+
+    ~DownloadInfo();
     unsigned int m_DownloadID;
     QString m_FileName;
     QFile m_Output;
@@ -103,10 +124,41 @@ private:
 
     bool m_Hidden;
 
+    // segments downloaded in parallel; empty when the file is downloaded in
+    // one piece through m_Reply, which is null while there are segments
+    std::vector<Segment> m_Segments;
+
+    // md5 of the data received so far, in file order; null when the data
+    // can't be hashed as it arrives, see DownloadManager::hashData()
+    std::unique_ptr<QCryptographicHash> m_Hasher;
+    qint64 m_HashedSize;
+
+    // received but not written yet, see DownloadManager::flushData()
+    QByteArray m_Pending;
+
+    // last values given to DownloadManager::updateProgress(), published by
+    // DownloadManager::publishProgress()
+    std::pair<qint64, qint64> m_ProgressBytes;
+
+    // limits the speed of this download, see DownloadManager::setLimits()
+    TokenBucket m_Bandwidth;
+
+    // whether this download was paused by the scheduler because too many
+    // downloads were transferring, it is resumed automatically
+    bool m_Queued;
+
+    // whether the scheduler let this download transfer, reset when it's
+    // paused by the user
+    bool m_Admitted;
+
+    // whether readyToInstall() is emitted when the download is ready, the
+    // flag is cleared when it is; not saved in the meta file
+    bool m_InstallWhenFinished;
+
     static DownloadInfo *createNew(const MOBase::ModRepositoryFileInfo *fileInfo, const QStringList &URLs);
     static DownloadInfo *createFromMeta(
       const QString &filePath, bool showHidden, const QString outputDirectory,
-      std::optional<uint64_t> fileSize={});
+      std::optional<uint64_t> fileSize={}, const QVariantMap* meta=nullptr);
 
     /**
      * @brief rename the file
@@ -123,10 +175,13 @@ private:
     bool isPausedState();
 
     QString currentURL();
+
+    // total number of bytes written by all segments
+    qint64 segmentsReceived() const;
   private:
     static unsigned int s_NextDownloadID;
   private:
-    DownloadInfo() : m_TotalSize(0), m_ReQueried(false), m_Hidden(false), m_SpeedDiff(std::tuple<int,int,int,int,int>(0,0,0,0,0)), m_HasData(false) {}
+    DownloadInfo() : m_TotalSize(0), m_ReQueried(false), m_Hidden(false), m_SpeedDiff(std::tuple<int,int,int,int,int>(0,0,0,0,0)), m_HasData(false), m_HashedSize(0), m_Queued(false), m_Admitted(false), m_InstallWhenFinished(false) {}
   };
 
   friend class DownloadManagerProxy;
@@ -191,6 +246,18 @@ public:
 
   void setPluginContainer(PluginContainer *pluginContainer);
 
+  /**
+   * @brief sets the limits used to schedule downloads
+   *
+   * downloads over the maximum are queued as paused and resumed when others
+   * are done, smallest first
+   *
+   * @param maxDownloads maximum number of downloads transferring at the same time, 0 for no limit
+   * @param maxSpeed maximum speed in bytes per second for all downloads together, 0 for no limit
+   * @param maxSpeedPerDownload maximum speed in bytes per second for each download, 0 for no limit
+   **/
+  void setLimits(int maxDownloads, qint64 maxSpeed, qint64 maxSpeedPerDownload);
+
   /**
    * @brief download from an already open network connection
    *
@@ -215,6 +282,9 @@ public:
    *
    * starts a download using a nxm-link. The download manager will first query the nexus
    * page for file information.
+   * links are not handled right away: those arriving within a short interval are
+   * handled together and only a few of them query the nexus at the same time, see
+   * processNXMBatch()
    * @param url a nxm link looking like this: nxm://skyrim/mods/1234/files/4711
    * @todo the game name encoded into the link is currently ignored, all downloads are incorrectly assumed to be for the identified game
    **/
@@ -233,6 +303,12 @@ public:
    */
   int numPendingDownloads() const;
 
+  /**
+   * @brief retrieve the combined speed of all the running downloads
+   * @return speed in bytes per second
+   */
+  double currentSpeed() const;
+
   /**
    * @brief retrieve the info of a pending download
    * @param index index of the pending download (index in the range [0, numPendingDownloads()[)
@@ -240,6 +316,15 @@ public:
    */
   std::tuple<QString, int, int> getPendingDownload(int index);
 
+  /**
+   * @brief retrieve the id of the download specified by index, which doesn't
+   *        change when downloads are added or removed
+   *
+   * @param index the index to look up
+   * @return id of the download
+   **/
+  unsigned int getDownloadID(int index) const;
+
   /**
    * @brief retrieve the full path to the download specified by index
    *
@@ -363,6 +448,15 @@ public:
 
   void markUninstalled(QString download);
 
+  /**
+   * @brief whether the download is installed as soon as it's ready, see
+   *        readyToInstall()
+   *
+   * @param index index of the download, which must not be ready yet
+   */
+  bool installWhenFinished(int index) const;
+  void setInstallWhenFinished(int index, bool b);
+
   /**
    * @brief refreshes the list of downloads
    */
@@ -400,6 +494,14 @@ Q_SIGNALS:
    **/
   void update(int row);
 
+  /**
+   * @brief signals that the progress of the specified download has changed,
+   *        nothing else about it has
+   *
+   * @param row the row that changed. This corresponds to the download index
+   **/
+  void progressChanged(int row);
+
   /**
    * @brief signals the ui that a message should be displayed
    *
@@ -424,6 +526,13 @@ Q_SIGNALS:
    */
   void downloadAdded();
 
+  /**
+   * @brief emitted when a download that was marked to be installed when
+   *        finished is ready; the file has its final name
+   * @param fileName name of the download, as given to indexByName()
+   */
+  void readyToInstall(const QString& fileName);
+
 public slots:
 
   /**
@@ -455,6 +564,14 @@ public slots:
 
   void queryInfoMd5(int index);
 
+  // looks up every finished download without nexus info by its md5: files
+  // that weren't hashed yet are hashed in parallel, the lookups are sent
+  // through the bulk queue of the nexus interface and the meta files are
+  // written in batches as the results come in; downloads that can't be
+  // identified are left for queryInfoMd5()
+  //
+  void queryInfoAll();
+
   void visitOnNexus(int index);
 
   void openFile(int index);
@@ -484,12 +601,34 @@ private slots:
   void downloadFinished(int index = 0);
   void downloadError(QNetworkReply::NetworkError error);
   void metaDataChanged();
-  void directoryChanged(const QString &dirctory);
+  void directoryChanged(const QString &directory, const QStringList &paths);
   void checkDownloadTimeout();
+  void segmentReadyRead();
+  void segmentFinished();
+  void readThrottled();
+  void startQueued();
+  void publishProgress();
+
+  // handles the nxm links received since the batch timer was started, links
+  // that can't be queued are reported once for the whole batch
+  void processNXMBatch();
 
 private:
 
   void createMetaFile(DownloadInfo *info);
+
+  // writes the meta file of the download, createMetaFile() also suppresses
+  // the directory watcher and updates the view
+  void writeMetaFile(DownloadInfo *info);
+
+  // called when a download queried by queryInfoAll() is done, identified or
+  // not; restores its state and leaves its meta file to writeBulkMeta()
+  //
+  // returns false if the download isn't part of a bulk query
+  bool finishBulkQuery(DownloadInfo *info);
+
+  // writes the meta files of the downloads done since the last call
+  void writeBulkMeta();
   DownloadManager::DownloadInfo* getDownloadInfo(QString fileName);
 
 public:
@@ -522,6 +661,33 @@ private:
   // important: the caller has to lock the list-mutex, otherwise the DownloadInfo-pointer might get invalidated at any time
   DownloadInfo *findDownload(QObject *reply, int *index = nullptr) const;
 
+  // returns the index in the given map for the given key if the download at
+  // that index matches, rebuilds the maps from m_ActiveDownloads and tries
+  // again otherwise; returns -1 if no download matches
+  //
+  template <class K, class F>
+  int findIndex(const QHash<K, int>& map, const K& key, F&& matches) const
+  {
+    auto check = [&]{
+      const auto itor = map.find(key);
+      if (itor == map.end() || *itor >= m_ActiveDownloads.size()) {
+        return -1;
+      }
+
+      return (matches(*m_ActiveDownloads[*itor]) ? *itor : -1);
+    };
+
+    const int i = check();
+    if (i >= 0) {
+      return i;
+    }
+
+    rebuildIndices();
+    return check();
+  }
+
+  void rebuildIndices() const;
+
   void removeFile(int index, bool deleteFile);
 
   void refreshAlphabeticalTranslation();
@@ -538,12 +704,104 @@ private:
 
   static QString getFileTypeString(int fileType);
 
-  void writeData(DownloadInfo *info);
+  // adds data written to the end of the file to the download's hash
+  void hashData(DownloadInfo *info, const QByteArray& data);
+
+  // reads the whole file to compute its md5, returns an empty array on
+  // failure or if the user canceled
+  QByteArray hashFile(DownloadInfo *info);
+
+  // writes what the reply has received to the file; if throttle is true,
+  // only takes what the rate limits allow and leaves the rest for
+  // readThrottled()
+  void writeData(DownloadInfo *info, bool throttle = false);
+
+  // number of bytes the rate limits allow reading now for the given download,
+  // at most `wanted`
+  qint64 allowedBytes(DownloadInfo *info, qint64 wanted);
+  void consumeBytes(DownloadInfo *info, qint64 bytes);
+
+  // number of downloads the scheduler let transfer that are still doing so
+  int transferringCount() const;
+
+  // called when a download gets its headers, pauses it if too many downloads
+  // are already transferring; returns true if it was queued
+  bool queueDownload(DownloadInfo *info, int index);
+
+  // remembers the progress of a download, publishProgress() updates the view
+  // with it later
+  void updateProgress(DownloadInfo *info, int index, qint64 bytesReceived, qint64 bytesTotal);
+
+  // writes what was buffered for the download and its segments; failures are
+  // logged, the bytes will be downloaded again when resuming
+  void flushData(DownloadInfo *info);
+
+  // renames the file of a download that was fully received and moves on to
+  // fetching its info
+  void downloadCompleted(DownloadInfo *info, int index, const QString &newName);
+
+  // splits the download in segments if the reply allows it, in which case the
+  // reply is aborted and the segments are started on new connections
+  bool startSegmented(DownloadInfo *info, QNetworkReply *reply);
+
+  void startSegment(DownloadInfo *info, std::size_t segment);
+  bool writeSegment(DownloadInfo *info, std::size_t segment, bool throttle = false);
+  void readSegment(DownloadInfo *info, int index, std::size_t segment);
+
+  // writes what was buffered for the segment, returns the number of bytes
+  // written or -1 on failure
+  qint64 writePending(DownloadInfo *info, std::size_t segment);
+  void segmentFailed(DownloadInfo *info, int index, std::size_t segment);
+  void resumeSegmented(DownloadInfo *info, int index);
+
+  // handles a pausing or canceling segmented download
+  void stopSegmented(DownloadInfo *info, int index);
+
+  void completeSegmented(DownloadInfo *info, int index);
+  void abortSegments(DownloadInfo *info);
+
+  // important: same as findDownload()
+  DownloadInfo *findSegment(QObject *reply, int *index, std::size_t *segment) const;
+
+  // adds the link as a pending download and queues its lookup; returns false
+  // if it's for another game or if it's already pending or started, in which
+  // case `title` and `message` explain why
+  bool queueNXMDownload(const QString &url, QString &title, QString &message);
+
+  // starts the queued lookups of nxm links, as long as there are fewer than
+  // MAX_NXM_LOOKUPS running
+  void startNXMLookups();
 
 private:
 
   static const int AUTOMATIC_RETRIES = 3;
 
+  // files smaller than twice this are never split, and segments are never
+  // smaller than this
+  static const qint64 SEGMENT_MIN_SIZE = 32 * 1024 * 1024;
+
+  // maximum number of connections for one download
+  static const int SEGMENT_CONNECTIONS = 4;
+
+  // received data is written to the file in chunks of this size
+  static const int WRITE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+  // milliseconds between updates of the progress in the view
+  static const int PROGRESS_INTERVAL = 250;
+
+  // milliseconds during which nxm links are gathered before being handled
+  static const int NXM_BATCH_INTERVAL = 500;
+
+  // milliseconds between writes of the meta files of bulk queries
+  static const int BULK_META_INTERVAL = 5000;
+
+  // files are hashed by queryInfoAll() through mappings of this size
+  static const qint64 HASH_MAP_SIZE = 64 * 1024 * 1024;
+
+  // maximum number of nxm links being looked up on the nexus at once, each
+  // lookup is a file info request followed by a download url request
+  static const int MAX_NXM_LOOKUPS = 4;
+
 private:
 
   NexusInterface *m_NexusInterface;
@@ -555,11 +813,20 @@ private:
 
   QVector<DownloadInfo*> m_ActiveDownloads;
 
+  // indices in m_ActiveDownloads by info, reply, lowercase file name and id;
+  // entries are checked against the download they point to when they're
+  // used and the maps are rebuilt when one is stale or missing, see
+  // findIndex(), so they don't have to be updated when the list changes
+  mutable QHash<const DownloadInfo*, int> m_IndexByInfo;
+  mutable QHash<const QObject*, int> m_IndexByReply;
+  mutable QHash<QString, int> m_IndexByName;
+  mutable QHash<unsigned int, int> m_IndexByID;
+
   QString m_OutputDirectory;
   std::set<int> m_RequestIDs;
   QVector<int> m_AlphabeticalTranslation;
 
-  QFileSystemWatcher m_DirWatcher;
+  DirectoryWatcher m_DirWatcher;
 
   SignalDownloadCallback m_DownloadComplete;
   SignalDownloadCallback m_DownloadPaused;
@@ -569,7 +836,7 @@ private:
   //The dirWatcher is actually triggering off normal Mo operations such as deleting downloads or editing .meta files
   //so it needs to be disabled during operations that are known to cause the creation or deletion of files in the Downloads folder.
   //Notably using QSettings to edit a file creates a temporarily .lock file that causes the Watcher to trigger multiple listRefreshes freezing the ui.
-  static int m_DirWatcherDisabler;
+  static WatcherSuppression m_DirWatcherDisabler;
 
 
   std::map<QString, int> m_DownloadFails;
@@ -579,6 +846,52 @@ private:
   MOBase::IPluginGame const *m_ManagedGame;
 
   QTimer m_TimeoutTimer;
+
+  // content of the meta files in m_OutputDirectory, see refreshList()
+  DownloadMetaCache m_MetaCache;
+
+  // see setLimits()
+  int m_MaxDownloads;
+  qint64 m_MaxSpeedPerDownload;
+  TokenBucket m_Bandwidth;
+
+  // reads data that was left in the replies because of the rate limits
+  QTimer m_ThrottleTimer;
+
+  // resumes queued downloads once the current event is done
+  QTimer m_ScheduleTimer;
+
+  // downloads whose progress changed since the last publishProgress(), by id
+  std::set<unsigned int> m_ProgressChanged;
+  QTimer m_ProgressTimer;
+
+  // a link that's pending but hasn't requested its file info yet
+  struct NXMLookup
+  {
+    QString gameName;
+    int modID;
+    int fileID;
+    MOBase::ModRepositoryFileInfo *info;
+  };
+
+  // links received by addNXMDownload() and not handled yet
+  QStringList m_NXMBatch;
+  QTimer m_NXMBatchTimer;
+
+  // lookups waiting for one of the running ones to finish
+  QQueue<NXMLookup> m_NXMLookupQueue;
+
+  // ids of the requests of the running lookups, also in m_RequestIDs
+  std::set<int> m_NXMLookups;
+
+  // downloads being identified by queryInfoAll(), by id, with the state they
+  // had before
+  std::map<unsigned int, DownloadState> m_BulkQueries;
+
+  // bulk queries that are done but whose meta file hasn't been written yet,
+  // by id; written when all the queries are done or by m_BulkMetaTimer
+  std::vector<unsigned int> m_BulkFinished;
+  QTimer m_BulkMetaTimer;
 };
 
 
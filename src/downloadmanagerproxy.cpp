@@ -16,10 +16,10 @@ DownloadManagerProxy::~DownloadManagerProxy()
 
 void DownloadManagerProxy::connectSignals()
 {
-  m_Connections.push_back(m_Proxied->onDownloadComplete(callSignalIfPluginActive(m_OrganizerProxy, m_DownloadComplete)));
-  m_Connections.push_back(m_Proxied->onDownloadFailed(callSignalIfPluginActive(m_OrganizerProxy, m_DownloadFailed)));
-  m_Connections.push_back(m_Proxied->onDownloadRemoved(callSignalIfPluginActive(m_OrganizerProxy, m_DownloadRemoved)));
-  m_Connections.push_back(m_Proxied->onDownloadPaused(callSignalIfPluginActive(m_OrganizerProxy, m_DownloadPaused)));
+  m_Connections.push_back(m_Proxied->onDownloadComplete(callTimedSignalIfPluginActive(m_OrganizerProxy, m_DownloadComplete, "onDownloadComplete")));
+  m_Connections.push_back(m_Proxied->onDownloadFailed(callTimedSignalIfPluginActive(m_OrganizerProxy, m_DownloadFailed, "onDownloadFailed")));
+  m_Connections.push_back(m_Proxied->onDownloadRemoved(callTimedSignalIfPluginActive(m_OrganizerProxy, m_DownloadRemoved, "onDownloadRemoved")));
+  m_Connections.push_back(m_Proxied->onDownloadPaused(callTimedSignalIfPluginActive(m_OrganizerProxy, m_DownloadPaused, "onDownloadPaused")));
 }
 
 void DownloadManagerProxy::disconnectSignals()
@@ -0,0 +1,153 @@
+#include "downloadmetacache.h"
+#include "shared/ioaccounting.h"
+#include <log.h>
+#include <safewritefile.h>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+
+using namespace MOBase;
+using MOShared::IoAccounting;
+
+// "MODC" and the format version, the cache is ignored when either doesn't
+// match
+static const quint32 CacheMagic = 0x4d4f4443;
+static const quint32 CacheVersion = 1;
+
+static const QString CacheFileName = "downloads.cache";
+
+
+void DownloadMetaCache::load(const QString& directory)
+{
+  if (QDir::fromNativeSeparators(directory) == m_Directory) {
+    return;
+  }
+
+  // whatever was read for the previous directory is kept for it
+  save();
+
+  m_Directory = QDir::fromNativeSeparators(directory);
+  m_Entries.clear();
+  m_Changed = false;
+
+  QFile file(cachePath());
+  if (!file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_9);
+
+  quint32 magic = 0, version = 0, count = 0;
+  in >> magic >> version >> count;
+
+  if (magic != CacheMagic || version != CacheVersion) {
+    log::debug("ignoring download cache {}, wrong version", file.fileName());
+    return;
+  }
+
+  for (quint32 i = 0; i < count; ++i) {
+    QString name;
+    Entry e;
+    in >> name >> e.time >> e.size >> e.values;
+
+    if (in.status() != QDataStream::Ok) {
+      log::warn("download cache {} is corrupted, ignoring", file.fileName());
+      m_Entries.clear();
+      return;
+    }
+
+    m_Entries.emplace(std::move(name), std::move(e));
+  }
+}
+
+void DownloadMetaCache::save()
+{
+  if (!m_Changed || m_Directory.isEmpty()) {
+    return;
+  }
+
+  QByteArray content;
+
+  {
+    QDataStream out(&content, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_9);
+
+    out << CacheMagic << CacheVersion << static_cast<quint32>(m_Entries.size());
+    for (const auto& [name, e] : m_Entries) {
+      out << name << e.time << e.size << e.values;
+    }
+  }
+
+  try
+  {
+    SafeWriteFile file(cachePath());
+    file->resize(0);
+    file->write(content);
+    file.commit();
+
+    m_Changed = false;
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to write {}: {}", cachePath(), e.what());
+  }
+}
+
+const QVariantMap& DownloadMetaCache::get(
+  const QString& path, qint64 time, quint64 size)
+{
+  auto& e = m_Entries[QFileInfo(path).fileName().toLower()];
+  e.used = true;
+
+  if (e.time != time || e.size != size) {
+    e.time = time;
+    e.size = size;
+    e.values = read(path);
+    m_Changed = true;
+
+    IoAccounting::read(IoAccounting::Subsystem::DownloadMeta, size);
+  }
+
+  return e.values;
+}
+
+void DownloadMetaCache::prune()
+{
+  for (auto itor = m_Entries.begin(); itor != m_Entries.end();) {
+    if (itor->second.used) {
+      itor->second.used = false;
+      ++itor;
+    } else {
+      itor = m_Entries.erase(itor);
+      m_Changed = true;
+    }
+  }
+}
+
+QVariantMap DownloadMetaCache::read(const QString& path)
+{
+  QVariantMap values;
+
+  IoAccounting::stat(IoAccounting::Subsystem::DownloadMeta);
+
+  if (!QFile::exists(path)) {
+    return values;
+  }
+
+  IoAccounting::open(IoAccounting::Subsystem::DownloadMeta);
+
+  QSettings file(path, QSettings::IniFormat);
+  for (const QString& key : file.allKeys()) {
+    values[key] = file.value(key);
+  }
+
+  return values;
+}
+
+QString DownloadMetaCache::cachePath() const
+{
+  return m_Directory + "/" + CacheFileName;
+}
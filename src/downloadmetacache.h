@@ -0,0 +1,63 @@
+#ifndef MODORGANIZER_DOWNLOADMETACACHE_INCLUDED
+#define MODORGANIZER_DOWNLOADMETACACHE_INCLUDED
+
+#include <QString>
+#include <QVariantMap>
+#include <map>
+
+// remembers the content of the .meta files in the downloads directory so they
+// don't have to be parsed on every refresh
+//
+// the .meta files are the source of truth: one is only read again when its
+// modification time or size is different from what was cached; the cache is
+// saved in a binary file in the downloads directory and loaded the next time
+//
+class DownloadMetaCache
+{
+public:
+  // loads the cache for the given directory, starts empty if it doesn't
+  // exist or is invalid; does nothing if the directory is the same as the
+  // last call
+  //
+  void load(const QString& directory);
+
+  // saves the cache if anything changed since it was loaded
+  //
+  void save();
+
+  // returns the values in the given meta file, reads it if it's not cached
+  // or if it changed; `time` and `size` are the file's current modification
+  // time and size
+  //
+  const QVariantMap& get(const QString& path, qint64 time, quint64 size);
+
+  // forgets the files that weren't given to get() since the last prune(),
+  // which are the files that don't exist anymore
+  //
+  void prune();
+
+  // reads the given meta file, empty if it doesn't exist
+  //
+  static QVariantMap read(const QString& path);
+
+private:
+  struct Entry
+  {
+    qint64 time = 0;
+    quint64 size = 0;
+    QVariantMap values;
+    bool used = false;
+  };
+
+  QString m_Directory;
+
+  // by lowercase file name, without the path
+  std::map<QString, Entry> m_Entries;
+
+  // whether m_Entries is different from what's in the file
+  bool m_Changed = false;
+
+  QString cachePath() const;
+};
+
+#endif // MODORGANIZER_DOWNLOADMETACACHE_INCLUDED
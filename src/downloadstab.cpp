@@ -14,7 +14,7 @@ DownloadsTab::DownloadsTab(OrganizerCore& core, Ui::MainWindow* mwui)
   ui.list->setModel(sourceModel);
   ui.list->setManager(m_core.downloadManager());
   ui.list->setItemDelegate(new DownloadProgressDelegate(
-    m_core.downloadManager(), ui.list));
+    sourceModel, ui.list));
 
   update();
 
@@ -26,8 +26,10 @@ DownloadsTab::DownloadsTab(OrganizerCore& core, Ui::MainWindow* mwui)
 
   connect(ui.refresh, &QPushButton::clicked, [&]{ refresh(); });
   connect(ui.list, SIGNAL(installDownload(int)), &m_core, SLOT(installDownload(int)));
+  connect(ui.list, &DownloadListView::installDownloads, [&](auto&& indexes){ m_core.installDownloads(indexes); });
   connect(ui.list, SIGNAL(queryInfo(int)), m_core.downloadManager(), SLOT(queryInfo(int)));
   connect(ui.list, SIGNAL(queryInfoMd5(int)), m_core.downloadManager(), SLOT(queryInfoMd5(int)));
+  connect(ui.list, SIGNAL(queryInfoAll()), m_core.downloadManager(), SLOT(queryInfoAll()));
   connect(ui.list, SIGNAL(visitOnNexus(int)), m_core.downloadManager(), SLOT(visitOnNexus(int)));
   connect(ui.list, SIGNAL(openFile(int)), m_core.downloadManager(), SLOT(openFile(int)));
   connect(ui.list, SIGNAL(openMetaFile(int)), m_core.downloadManager(), SLOT(openMetaFile(int)));
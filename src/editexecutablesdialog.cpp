@@ -112,6 +112,7 @@ EditExecutablesDialog::EditExecutablesDialog(OrganizerCore& oc, int sel, QWidget
   connect(ui->mods, &QComboBox::currentTextChanged, [&]{ save(); });
   connect(ui->useApplicationIcon, &QCheckBox::toggled, [&]{ save(); });
   connect(ui->hide, &QCheckBox::toggled, [&]{ save(); });
+  connect(ui->lightLock, &QCheckBox::toggled, [&]{ save(); });
   connect(ui->list->model(), &QAbstractItemModel::rowsMoved, [&]{ saveOrder(); });
 }
 
@@ -378,6 +379,8 @@ void EditExecutablesDialog::clearEdits()
   ui->useApplicationIcon->setChecked(false);
   ui->hide->setEnabled(false);
   ui->hide->setChecked(false);
+  ui->lightLock->setEnabled(false);
+  ui->lightLock->setChecked(false);
 
   m_lastGoodTitle = "";
 }
@@ -393,6 +396,7 @@ void EditExecutablesDialog::setEdits(const Executable& e)
   ui->steamAppID->setText(e.steamAppID());
   ui->useApplicationIcon->setChecked(e.usesOwnIcon());
   ui->hide->setChecked(e.hide());
+  ui->lightLock->setChecked(e.lightLock());
 
   m_lastGoodTitle = e.title();
 
@@ -439,6 +443,7 @@ void EditExecutablesDialog::setEdits(const Executable& e)
   ui->createFilesInMod->setEnabled(true);
   ui->forceLoadLibraries->setEnabled(true);
   ui->hide->setEnabled(true);
+  ui->lightLock->setEnabled(true);
 }
 
 void EditExecutablesDialog::save()
@@ -504,6 +509,12 @@ void EditExecutablesDialog::save()
     e->flags(e->flags() & (~Executable::Hide));
   }
 
+  if (ui->lightLock->isChecked()) {
+    e->flags(e->flags() | Executable::LightLock);
+  } else {
+    e->flags(e->flags() & (~Executable::LightLock));
+  }
+
   setDirty(true);
 }
 
@@ -7,6 +7,7 @@
 #include "envdump.h"
 #include "settings.h"
 #include "shared/util.h"
+#include "taskexecutor.h"
 #include <log.h>
 #include <utility.h>
 
@@ -130,6 +131,16 @@ void ModuleNotification::fire(QString path, std::size_t fileSize)
 }
 
 
+// one group per data source so each accessor only waits for its own
+//
+struct Environment::Prefetch
+{
+  MOShared::TaskGroup modules{MOShared::TaskPriority::Normal};
+  MOShared::TaskGroup windows{MOShared::TaskPriority::Normal};
+  MOShared::TaskGroup security{MOShared::TaskPriority::Normal};
+};
+
+
 Environment::Environment()
 {
 }
@@ -137,9 +148,24 @@ Environment::Environment()
 // anchor
 Environment::~Environment() = default;
 
+void Environment::prefetch()
+{
+  if (m_prefetch) {
+    return;
+  }
+
+  m_prefetch.reset(new Prefetch);
+
+  m_prefetch->modules.run([this] { m_modules = getLoadedModules(); });
+  m_prefetch->windows.run([this] { m_windows.reset(new WindowsInfo); });
+  m_prefetch->security.run([this] { m_security = getSecurityProducts(); });
+}
+
 const std::vector<Module>& Environment::loadedModules() const
 {
-  if (m_modules.empty()){
+  if (m_prefetch) {
+    m_prefetch->modules.wait();
+  } else if (m_modules.empty()){
     m_modules = getLoadedModules();
   }
 
@@ -153,6 +179,10 @@ std::vector<Process> Environment::runningProcesses() const
 
 const WindowsInfo& Environment::windowsInfo() const
 {
+  if (m_prefetch) {
+    m_prefetch->windows.wait();
+  }
+
   if (!m_windows) {
     m_windows.reset(new WindowsInfo);
   }
@@ -162,7 +192,9 @@ const WindowsInfo& Environment::windowsInfo() const
 
 const std::vector<SecurityProduct>& Environment::securityProducts() const
 {
-  if (m_security.empty()) {
+  if (m_prefetch) {
+    m_prefetch->security.wait();
+  } else if (m_security.empty()) {
     m_security = getSecurityProducts();
   }
 
@@ -319,6 +351,24 @@ std::unique_ptr<ModuleNotification> Environment::onModuleLoaded(
 }
 
 void Environment::dump(const Settings& s) const
+{
+  dump(dumpPaths(s), metrics().desktopGeometry());
+}
+
+std::vector<QString> Environment::dumpPaths(const Settings& s)
+{
+  return {
+    s.paths().base(),
+    s.paths().downloads(),
+    s.paths().mods(),
+    s.paths().cache(),
+    s.paths().profiles(),
+    s.paths().overwrite()
+  };
+}
+
+void Environment::dump(
+  const std::vector<QString>& paths, const QRect& desktop) const
 {
   log::debug("windows: {}", windowsInfo().toString());
 
@@ -355,15 +405,14 @@ void Environment::dump(const Settings& s) const
     log::debug(" . {}", d.toString());
   }
 
-  const auto r = metrics().desktopGeometry();
   log::debug(
     "desktop geometry: ({},{})-({},{})",
-    r.left(), r.top(), r.right(), r.bottom());
+    desktop.left(), desktop.top(), desktop.right(), desktop.bottom());
 
-  dumpDisks(s);
+  dumpDisks(paths);
 }
 
-void Environment::dumpDisks(const Settings& s) const
+void Environment::dumpDisks(const std::vector<QString>& paths) const
 {
   std::set<QString> rootPaths;
 
@@ -389,12 +438,11 @@ void Environment::dumpDisks(const Settings& s) const
   log::debug("drives:");
 
   dump(QStorageInfo::root().rootPath());
-  dump(s.paths().base());
-  dump(s.paths().downloads());
-  dump(s.paths().mods());
-  dump(s.paths().cache());
-  dump(s.paths().profiles());
-  dump(s.paths().overwrite());
+
+  for (auto&& p : paths) {
+    dump(p);
+  }
+
   dump(QCoreApplication::applicationDirPath());
 }
 
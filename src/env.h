@@ -184,6 +184,15 @@ public:
   Environment();
   ~Environment();
 
+  // starts getting the loaded modules, the windows info and the security
+  // products in parallel in the background; the accessors wait for their
+  // own data only, so a slow WMI query only delays securityProducts()
+  //
+  // without this, each accessor gets its data on first use on the calling
+  // thread
+  //
+  void prefetch();
+
   // list of loaded modules in the current process
   //
   const std::vector<Module>& loadedModules() const;
@@ -218,15 +227,31 @@ public:
   //
   void dump(const Settings& s) const;
 
+  // logs the environment without using the settings or the screens, so it can
+  // be called on another thread; `paths` are the directories whose drives are
+  // logged and `desktop` is the geometry of the desktop, see dumpPaths() and
+  // Metrics::desktopGeometry()
+  //
+  void dump(const std::vector<QString>& paths, const QRect& desktop) const;
+
+  // the directories from the settings whose drives are logged by dump()
+  //
+  static std::vector<QString> dumpPaths(const Settings& s);
+
 private:
   mutable std::vector<Module> m_modules;
   mutable std::unique_ptr<WindowsInfo> m_windows;
   mutable std::vector<SecurityProduct> m_security;
   mutable std::unique_ptr<Metrics> m_metrics;
 
-  // dumps all the disks involved in the settings
+  // tasks started by prefetch(), declared last so they're waited for before
+  // the members they fill are destroyed
+  struct Prefetch;
+  std::unique_ptr<Prefetch> m_prefetch;
+
+  // dumps all the disks involved in the given paths
   //
-  void dumpDisks(const Settings& s) const;
+  void dumpDisks(const std::vector<QString>& paths) const;
 };
 
 
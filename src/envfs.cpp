@@ -1,10 +1,13 @@
 #include "envfs.h"
 #include "env.h"
+#include "shared/ioaccounting.h"
 #include "shared/util.h"
+#include "taskexecutor.h"
 #include <utility.h>
 #include <log.h>
 
 using namespace MOBase;
+using MOShared::IoAccounting;
 
 typedef struct _UNICODE_STRING {
   USHORT Length;
@@ -56,8 +59,18 @@ typedef VOID(NTAPI *PIO_APC_ROUTINE)(PVOID ApcContext,
   ULONG Reserved);
 
 
+typedef struct _FILE_BASIC_INFORMATION {
+  LARGE_INTEGER CreationTime;
+  LARGE_INTEGER LastAccessTime;
+  LARGE_INTEGER LastWriteTime;
+  LARGE_INTEGER ChangeTime;
+  ULONG         FileAttributes;
+} FILE_BASIC_INFORMATION, *PFILE_BASIC_INFORMATION;
+
+
 typedef enum _FILE_INFORMATION_CLASS {
-  FileDirectoryInformation = 1
+  FileDirectoryInformation = 1,
+  FileBasicInformation = 4
 } FILE_INFORMATION_CLASS;
 
 typedef NTSTATUS(WINAPI *NtQueryDirectoryFile_type)(
@@ -68,11 +81,15 @@ typedef NTSTATUS(WINAPI *NtOpenFile_type)(PHANDLE, ACCESS_MASK,
   POBJECT_ATTRIBUTES, PIO_STATUS_BLOCK,
   ULONG, ULONG);
 
+typedef NTSTATUS(WINAPI *NtQueryInformationFile_type)(
+  HANDLE, PIO_STATUS_BLOCK, PVOID, ULONG, FILE_INFORMATION_CLASS);
+
 typedef NTSTATUS(WINAPI *NtClose_type)(HANDLE);
 
 
 NtOpenFile_type NtOpenFile = nullptr;
 NtQueryDirectoryFile_type NtQueryDirectoryFile = nullptr;
+NtQueryInformationFile_type NtQueryInformationFile = nullptr;
 extern NtClose_type NtClose = nullptr;
 
 
@@ -152,102 +169,131 @@ QString toString(POBJECT_ATTRIBUTES poa)
 }
 
 
-class HandleCloserThread
+// closing handles is slow, so the handles opened while walking a directory are
+// closed in a low priority task once the walk is finished
+//
+class HandleCloser
 {
 public:
-  HandleCloserThread()
-    : m_ready(false)
-  {
-    m_handles.reserve(50000);
-  }
-
-  void shrink()
-  {
-    m_handles.shrink_to_fit();
-  }
-
   void add(HANDLE h)
   {
     m_handles.push_back(h);
   }
 
-  void wakeup()
+  void closeLater()
   {
-    {
-      std::unique_lock lock(m_mutex);
-      m_ready = true;
+    if (m_handles.empty()) {
+      return;
     }
 
-    m_cv.notify_one();
-  }
-
-  void run()
-  {
-    MOShared::SetThisThreadName("HandleCloserThread");
-
-    std::unique_lock lock(m_mutex);
-    m_cv.wait(lock, [&]{ return m_ready; });
+    MOShared::TaskExecutor::instance().post(
+      MOShared::TaskPriority::Low, [handles=std::move(m_handles)] {
+        for (auto& h : handles) {
+          NtClose(h);
+        }
+      });
 
-    closeHandles();
+    m_handles = {};
   }
 
 private:
   std::vector<HANDLE> m_handles;
-  std::condition_variable m_cv;
-  std::mutex m_mutex;
-  bool m_ready;
+};
 
-  void closeHandles()
-  {
-    for (auto& h : m_handles) {
-      NtClose(h);
-    }
+// the query buffer of each depth starts small, most directories only have a
+// handful of entries, and grows when a query fills most of it so large
+// directories need fewer queries
+constexpr std::size_t MinBufferSize = 64 * 1024;
+constexpr std::size_t MaxBufferSize = 4 * 1024 * 1024;
 
-    m_handles.clear();
-    m_ready = false;
+DirectoryWalker::Buffer& getBuffer(
+  std::vector<DirectoryWalker::Buffer>& buffers, std::size_t depth)
+{
+  if (depth >= buffers.size()) {
+    buffers.resize(depth + 1);
   }
-};
 
-constexpr std::size_t AllocSize = 1024 * 1024;
-static ThreadPool<HandleCloserThread> g_handleClosers;
+  auto& b = buffers[depth];
 
-void setHandleCloserThreadCount(std::size_t n)
+  if (!b.data) {
+    b.data = std::make_unique<unsigned char[]>(MinBufferSize);
+    b.size = MinBufferSize;
+  }
+
+  return b;
+}
+
+void growBuffer(DirectoryWalker::Buffer& b)
 {
-  g_handleClosers.setMax(n);
+  if (b.size >= MaxBufferSize) {
+    return;
+  }
+
+  b.size *= 2;
+  b.data = std::make_unique<unsigned char[]>(b.size);
 }
 
-void forEachEntryImpl(
-  void* cx, HandleCloserThread& hc, std::vector<std::unique_ptr<unsigned char[]>>& buffers,
-  POBJECT_ATTRIBUTES poa, std::size_t depth,
-  DirStartF* dirStartF, DirEndF* dirEndF, FileF* fileF)
+// opens the directory given in `poa`, which is relative to the handle in its
+// RootDirectory for subdirectories so the full path doesn't have to be
+// resolved again; returns null on failure, which has been logged
+//
+HANDLE openDirectory(POBJECT_ATTRIBUTES poa, HandleCloser& hc)
 {
   IO_STATUS_BLOCK iosb;
-  UNICODE_STRING ObjectName;
-  OBJECT_ATTRIBUTES oa = { sizeof(oa), 0, &ObjectName };
-  NTSTATUS status;
+  HANDLE h = 0;
+
+  IoAccounting::open(IoAccounting::Subsystem::Walks);
 
-  status = NtOpenFile(
-    &oa.RootDirectory, FILE_GENERIC_READ, poa, &iosb, FILE_SHARE_VALID_FLAGS,
-    FILE_SYNCHRONOUS_IO_NONALERT|FILE_OPEN_FOR_BACKUP_INTENT);
+  const NTSTATUS status = NtOpenFile(
+    &h, FILE_LIST_DIRECTORY|FILE_READ_ATTRIBUTES|SYNCHRONIZE, poa, &iosb,
+    FILE_SHARE_VALID_FLAGS,
+    FILE_DIRECTORY_FILE|FILE_SYNCHRONOUS_IO_NONALERT|FILE_OPEN_FOR_BACKUP_INTENT);
 
   if (status < 0) {
     log::error(
       "NtOpenFile() failed for '{}', {}",
       toString(poa), formatSystemMessage(status));
 
-    return;
+    return 0;
   }
 
-  hc.add(oa.RootDirectory);
-  unsigned char* buffer;
+  hc.add(h);
+  return h;
+}
 
-  if (depth >= buffers.size()) {
-    buffers.emplace_back(std::make_unique<unsigned char[]>(AllocSize));
-    buffer = buffers.back().get();
-  } else {
-    buffer = buffers[depth].get();
+// last modification time of an open directory; this is the time of the
+// directory itself, the one given for the directory when enumerating its
+// parent is not always updated when the directory's contents change
+//
+FILETIME getLastWriteTime(HANDLE h)
+{
+  IO_STATUS_BLOCK iosb;
+  FILE_BASIC_INFORMATION info = {};
+  FILETIME ft = {};
+
+  IoAccounting::stat(IoAccounting::Subsystem::Walks);
+
+  const NTSTATUS status = NtQueryInformationFile(
+    h, &iosb, &info, sizeof(info), FileBasicInformation);
+
+  if (status >= 0) {
+    ft.dwLowDateTime = info.LastWriteTime.LowPart;
+    ft.dwHighDateTime = info.LastWriteTime.HighPart;
   }
 
+  return ft;
+}
+
+void forEachEntryImpl(
+  void* cx, HandleCloser& hc, std::vector<DirectoryWalker::Buffer>& buffers,
+  HANDLE dir, POBJECT_ATTRIBUTES poa, std::size_t depth,
+  DirStartF* dirStartF, DirEndF* dirEndF, FileF* fileF)
+{
+  IO_STATUS_BLOCK iosb;
+  UNICODE_STRING ObjectName;
+  OBJECT_ATTRIBUTES oa = { sizeof(oa), dir, &ObjectName };
+  NTSTATUS status;
+
   union
   {
     PVOID pv;
@@ -256,11 +302,17 @@ void forEachEntryImpl(
   };
 
   for (;;) {
+    // the buffer can be reallocated between queries, but not while its
+    // entries are being processed
+    auto& buffer = getBuffer(buffers, depth);
+
     status = NtQueryDirectoryFile(
-      oa.RootDirectory, NULL, NULL, NULL, &iosb,
-      buffer, AllocSize, FileDirectoryInformation, FALSE, NULL, FALSE);
+      dir, NULL, NULL, NULL, &iosb,
+      buffer.data.get(), static_cast<ULONG>(buffer.size),
+      FileDirectoryInformation, FALSE, NULL, FALSE);
 
     if (status == STATUS_NO_MORE_FILES) {
+      IoAccounting::enumerate(IoAccounting::Subsystem::Walks, 0);
       break;
     } else if (status < 0) {
       log::error(
@@ -269,9 +321,13 @@ void forEachEntryImpl(
       break;
     }
 
+    IoAccounting::enumerate(IoAccounting::Subsystem::Walks, iosb.Information);
+
+    const bool mostlyFull = (iosb.Information > (buffer.size / 2));
+
     ULONG NextEntryOffset = 0;
 
-    pv = buffer;
+    pv = buffer.data.get();
 
     auto isDotDir = [](auto* o) {
       if (o->Length == 2 && o->Buffer[0] == '.') {
@@ -285,10 +341,7 @@ void forEachEntryImpl(
       return false;
     };
 
-    std::size_t count = 0;
-
     for (;;) {
-      ++count;
       pb += NextEntryOffset;
 
       ObjectName.Buffer = DirInfo->FileName;
@@ -299,8 +352,17 @@ void forEachEntryImpl(
 
         if (DirInfo->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
           if (dirStartF && dirEndF) {
-            dirStartF(cx, toStringView(&oa));
-            forEachEntryImpl(cx, hc, buffers, &oa, depth+1, dirStartF, dirEndF, fileF);
+            // still reported when it can't be opened, it'll just be empty
+            HANDLE sub = openDirectory(&oa, hc);
+            const FILETIME ft = (sub ? getLastWriteTime(sub) : FILETIME{});
+
+            dirStartF(cx, toStringView(&oa), ft);
+
+            if (sub) {
+              forEachEntryImpl(
+                cx, hc, buffers, sub, &oa, depth+1, dirStartF, dirEndF, fileF);
+            }
+
             dirEndF(cx, toStringView(&oa));
           }
         } else {
@@ -308,7 +370,7 @@ void forEachEntryImpl(
           ft.dwLowDateTime = DirInfo->LastWriteTime.LowPart;
           ft.dwHighDateTime = DirInfo->LastWriteTime.HighPart;
 
-          fileF(cx, toStringView(&oa), ft, DirInfo->AllocationSize.QuadPart);
+          fileF(cx, toStringView(&oa), ft, DirInfo->EndOfFile.QuadPart);
         }
       }
 
@@ -318,6 +380,12 @@ void forEachEntryImpl(
         break;
       }
     }
+
+    if (mostlyFull) {
+      // the subdirectories are done with this depth's buffer, there are
+      // probably more entries to come
+      growBuffer(getBuffer(buffers, depth));
+    }
   }
 }
 
@@ -326,13 +394,14 @@ void DirectoryWalker::forEachEntry(
   const std::wstring& path, void* cx,
   DirStartF* dirStartF, DirEndF* dirEndF, FileF* fileF)
 {
-  auto& hc = g_handleClosers.request();
+  HandleCloser hc;
 
   if (!NtOpenFile) {
     LibraryPtr m(::LoadLibraryW(L"ntdll.dll"));
     NtOpenFile = (NtOpenFile_type)::GetProcAddress(m.get(), "NtOpenFile");
     NtQueryDirectoryFile = (NtQueryDirectoryFile_type)::GetProcAddress(m.get(), "NtQueryDirectoryFile");
     NtClose = (NtClose_type)::GetProcAddress(m.get(), "NtClose");
+    NtQueryInformationFile = (NtQueryInformationFile_type)::GetProcAddress(m.get(), "NtQueryInformationFile");
   }
 
   const std::wstring ntpath = std::wstring(L"\\??\\") + path;
@@ -346,8 +415,12 @@ void DirectoryWalker::forEachEntry(
   oa.Length = sizeof(oa);
   oa.ObjectName = &ObjectName;
 
-  forEachEntryImpl(cx, hc, m_buffers, &oa, 0, dirStartF, dirEndF, fileF);
-  hc.wakeup();
+  if (HANDLE root=openDirectory(&oa, hc)) {
+    forEachEntryImpl(
+      cx, hc, m_buffers, root, &oa, 0, dirStartF, dirEndF, fileF);
+  }
+
+  hc.closeLater();
 }
 
 
@@ -371,7 +444,7 @@ Directory getFilesAndDirs(const std::wstring& path)
   cx.current.push(&root);
 
   env::forEachEntry(path, &cx,
-    [](void* pcx, std::wstring_view path) {
+    [](void* pcx, std::wstring_view path, FILETIME) {
       Context* cx = (Context*)pcx;
 
       cx->current.top()->dirs.push_back(Directory(path));
@@ -226,7 +226,7 @@ const std::vector<Display>& Metrics::displays() const
   return m_displays;
 }
 
-QRect Metrics::desktopGeometry() const
+QRect Metrics::desktopGeometry()
 {
   QRect r;
 
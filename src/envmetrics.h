@@ -66,9 +66,10 @@ public:
   //
   const std::vector<Display>& displays() const;
 
-  // full resolution
+  // full resolution, uses the screens from Qt so it must be called on the ui
+  // thread
   //
-  QRect desktopGeometry() const;
+  static QRect desktopGeometry();
 
 private:
   std::vector<Display> m_displays;
@@ -1,7 +1,11 @@
 #include "envmodule.h"
 #include "env.h"
+#include "taskexecutor.h"
 #include <utility.h>
 #include <log.h>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 namespace env
 {
@@ -22,10 +26,6 @@ Module::Module(QString path, std::size_t fileSize)
   m_version = getVersion(fi.ffi);
   m_timestamp = getTimestamp(fi.ffi);
   m_versionString = fi.fileDescription;
-
-  if (UseMD5) {
-    m_md5 = getMD5();
-  }
 }
 
 const QString& Module::path() const
@@ -60,7 +60,34 @@ const QDateTime& Module::timestamp() const
 
 const QString& Module::md5() const
 {
-  return m_md5;
+  // hashes are the same for every snapshot of the modules as long as the file
+  // doesn't change
+  using Key = std::tuple<QString, std::size_t, qint64>;
+  static std::mutex mutex;
+  static std::map<Key, QString> cache;
+
+  if (!m_md5) {
+    const Key key(
+      m_path.toLower(), m_fileSize,
+      m_timestamp.isValid() ? m_timestamp.toMSecsSinceEpoch() : 0);
+
+    {
+      std::scoped_lock lock(mutex);
+      auto itor = cache.find(key);
+      if (itor != cache.end()) {
+        m_md5 = itor->second;
+        return *m_md5;
+      }
+    }
+
+    // not hashed under the lock, other modules can be hashed in parallel
+    m_md5 = getMD5();
+
+    std::scoped_lock lock(mutex);
+    cache.emplace(key, *m_md5);
+  }
+
+  return *m_md5;
 }
 
 QString Module::timestampString() const
@@ -101,8 +128,8 @@ QString Module::toString() const
   }
 
   // md5
-  if (!m_md5.isEmpty()) {
-    sl.push_back(m_md5);
+  if (UseMD5 && !md5().isEmpty()) {
+    sl.push_back(md5());
   }
 
   return sl.join(", ");
@@ -478,13 +505,13 @@ std::vector<Module> getLoadedModules()
     return {};
   }
 
-  std::vector<Module> v;
+  std::vector<std::pair<QString, std::size_t>> entries;
 
   for (;;)
   {
     const auto path = QString::fromWCharArray(me.szExePath);
     if (!path.isEmpty()) {
-      v.push_back(Module(path, me.modBaseSize));
+      entries.push_back({path, me.modBaseSize});
     }
 
     // next module
@@ -500,6 +527,29 @@ std::vector<Module> getLoadedModules()
     }
   }
 
+  // reading the version resource of each module hits the disk, there can be
+  // a few hundred of them with overlays and such
+  std::vector<std::optional<Module>> modules(entries.size());
+
+  {
+    MOShared::TaskGroup g(MOShared::TaskPriority::Normal);
+
+    for (std::size_t i=0; i<entries.size(); ++i) {
+      g.run([&, i] {
+        modules[i].emplace(entries[i].first, entries[i].second);
+      });
+    }
+
+    g.wait();
+  }
+
+  std::vector<Module> v;
+  v.reserve(modules.size());
+
+  for (auto& m : modules) {
+    v.push_back(std::move(*m));
+  }
+
   // sorting by display name
   std::sort(v.begin(), v.end(), [](auto&& a, auto&& b) {
     return (a.displayPath().compare(b.displayPath(), Qt::CaseInsensitive) < 0);
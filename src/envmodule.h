@@ -3,6 +3,7 @@
 
 #include <QString>
 #include <QDateTime>
+#include <optional>
 
 namespace env
 {
@@ -57,7 +58,9 @@ public:
   //
   const QDateTime& timestamp() const;
 
-  // returns the md5 of the file, may be empty for system files
+  // returns the md5 of the file, may be empty for system files; it's
+  // computed on first use and cached by path, size and timestamp for all
+  // modules
   //
   const QString& md5() const;
 
@@ -88,7 +91,7 @@ private:
   QString m_version;
   QDateTime m_timestamp;
   QString m_versionString;
-  QString m_md5;
+  mutable std::optional<QString> m_md5;
 
   // returns information from the version resource
   //
@@ -413,8 +413,36 @@ std::optional<SecurityProduct> getWindowsFirewall()
 }
 
 
+// initializes com on the calling thread for as long as it lives, does
+// nothing if it was already initialized, such as on the ui thread
+//
+class COMInitializer
+{
+public:
+  COMInitializer()
+    : m_hr(CoInitializeEx(nullptr, COINIT_MULTITHREADED))
+  {
+  }
+
+  ~COMInitializer()
+  {
+    if (SUCCEEDED(m_hr)) {
+      CoUninitialize();
+    }
+  }
+
+  COMInitializer(const COMInitializer&) = delete;
+  COMInitializer& operator=(const COMInitializer&) = delete;
+
+private:
+  HRESULT m_hr;
+};
+
 std::vector<SecurityProduct> getSecurityProducts()
 {
+  // this is called from the background, where com is not initialized
+  COMInitializer com;
+
   std::vector<SecurityProduct> v;
 
   {
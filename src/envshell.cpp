@@ -1,4 +1,5 @@
 #include "envshell.h"
+#include "thread_utils.h"
 #include <log.h>
 #include <utility.h>
 #include <windowsx.h>
@@ -190,11 +191,11 @@ int ShellMenu::fileCount() const
   return static_cast<int>(m_files.size());
 }
 
-void ShellMenu::exec(const QPoint& pos)
+bool ShellMenu::exec(const QPoint& pos)
 {
   HMENU menu = getMenu();
   if (!menu) {
-    return;
+    return false;
   }
 
   try
@@ -218,10 +219,11 @@ void ShellMenu::exec(const QPoint& pos)
     }
 
     if (cmd <= 0) {
-      return;
+      return false;
     }
 
     invoke(pos, cmd - QCM_FIRST);
+    return true;
   }
   catch(MenuFailed& e)
   {
@@ -234,6 +236,9 @@ void ShellMenu::exec(const QPoint& pos)
         "can't exec shell menu for {} files: {}",
         m_files.size(), e.what());
     }
+
+    // the command may have been invoked before failing
+    return true;
   }
 }
 
@@ -529,6 +534,77 @@ void ShellMenu::invoke(const QPoint& p, int cmd)
 }
 
 
+ShellMenuPreloader::ShellMenuPreloader(QString path)
+  : m_stop(::CreateEventW(nullptr, TRUE, FALSE, nullptr))
+{
+  if (!m_stop) {
+    const auto e = GetLastError();
+    log::error(
+      "can't create event for shell menu preloader, {}",
+      formatSystemMessage(e));
+    return;
+  }
+
+  m_thread = MOShared::startSafeThread([this, path=std::move(path)] {
+    run(path);
+  });
+}
+
+ShellMenuPreloader::~ShellMenuPreloader()
+{
+  if (m_thread.joinable()) {
+    ::SetEvent(m_stop);
+    m_thread.join();
+  }
+
+  if (m_stop) {
+    ::CloseHandle(m_stop);
+  }
+}
+
+void ShellMenuPreloader::run(const QString& path)
+{
+  const auto r = CoInitializeEx(
+    nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+
+  if (FAILED(r)) {
+    log::error(
+      "can't initialize com for shell menu preloader, {}",
+      formatSystemMessage(r));
+
+    return;
+  }
+
+  {
+    ShellMenu menu(nullptr);
+    menu.addFile(path);
+
+    if (menu.getMenu()) {
+      log::debug("shell extensions preloaded for '{}'", path);
+    }
+
+    // handlers can post messages to their apartment, so it has to be pumped
+    // while the menu is alive
+    for (;;) {
+      const auto w = MsgWaitForMultipleObjects(
+        1, &m_stop, FALSE, INFINITE, QS_ALLINPUT);
+
+      if (w != WAIT_OBJECT_0 + 1) {
+        break;
+      }
+
+      MSG msg;
+      while (PeekMessageW(&msg, 0, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+      }
+    }
+  }
+
+  CoUninitialize();
+}
+
+
 ShellMenuCollection::ShellMenuCollection(QMainWindow* mw)
   : m_mw(mw), m_active(nullptr)
 {
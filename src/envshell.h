@@ -4,6 +4,7 @@
 #include "env.h"
 #include <QFileInfo>
 #include <QPoint>
+#include <thread>
 
 namespace env
 {
@@ -22,7 +23,11 @@ public:
   void addFile(QFileInfo fi);
   int fileCount() const;
 
-  void exec(const QPoint& pos);
+  // shows the menu and invokes the selected command, returns whether a
+  // command was invoked
+  //
+  bool exec(const QPoint& pos);
+
   HMENU getMenu();
   bool wndProc(HWND hwnd, UINT m, WPARAM wp, LPARAM lp, LRESULT* out);
   void invoke(const QPoint& p, int cmd);
@@ -53,6 +58,35 @@ private:
 };
 
 
+// loads the shell extensions that add items to context menus on a
+// background thread, so the first ShellMenu doesn't spend seconds loading
+// their dlls on the ui thread
+//
+// context menu handlers are apartment threaded and can't be used from
+// another thread, so the menu built here is never shown; it's kept alive
+// along with its thread until this object is destroyed, which keeps the dlls
+// loaded for the menus created on the ui thread
+//
+class ShellMenuPreloader
+{
+public:
+  // builds the context menu of the given file
+  //
+  ShellMenuPreloader(QString path);
+  ~ShellMenuPreloader();
+
+  // noncopyable
+  ShellMenuPreloader(const ShellMenuPreloader&) = delete;
+  ShellMenuPreloader& operator=(const ShellMenuPreloader&) = delete;
+
+private:
+  HANDLE m_stop;
+  std::thread m_thread;
+
+  void run(const QString& path);
+};
+
+
 class ShellMenuCollection
 {
 public:
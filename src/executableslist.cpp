@@ -87,6 +87,9 @@ void ExecutablesList::load(const MOBase::IPluginGame* game, const Settings& s)
     if (map["hide"].toBool())
       flags |= Executable::Hide;
 
+    if (map["lightlock"].toBool())
+      flags |= Executable::LightLock;
+
     if (map.contains("custom")) {
       // the "custom" setting only exists in older versions
       needsUpgrade = true;
@@ -120,6 +123,7 @@ void ExecutablesList::store(Settings& s)
     map["toolbar"] = item.isShownOnToolbar();
     map["ownicon"] = item.usesOwnIcon();
     map["hide"] = item.hide();
+    map["lightlock"] = item.lightLock();
     map["binary"] = item.binaryInfo().filePath();
     map["arguments"] = item.arguments();
     map["workingDirectory"] = item.workingDirectory();
@@ -359,6 +363,10 @@ void ExecutablesList::dump() const
       flags.push_back("hide");
     }
 
+    if (e.flags() & Executable::LightLock) {
+      flags.push_back("lightlock");
+    }
+
     log::debug(
       " . executable '{}'\n"
       "    binary: {}\n"
@@ -477,6 +485,11 @@ bool Executable::hide() const
   return m_flags.testFlag(Hide);
 }
 
+bool Executable::lightLock() const
+{
+  return m_flags.testFlag(LightLock);
+}
+
 void Executable::mergeFrom(const Executable& other)
 {
   // this happens after executables are loaded from settings and plugin
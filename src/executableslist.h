@@ -41,7 +41,10 @@ public:
   {
     ShowInToolbar      = 0x02,
     UseApplicationIcon = 0x04,
-    Hide               = 0x08
+    Hide               = 0x08,
+
+    // the ui is locked with UILocker::LightLock while it runs
+    LightLock          = 0x10
   };
 
   Q_DECLARE_FLAGS(Flags, Flag);
@@ -71,6 +74,7 @@ public:
   void setShownOnToolbar(bool state);
   bool usesOwnIcon() const;
   bool hide() const;
+  bool lightLock() const;
 
   void mergeFrom(const Executable& other);
 
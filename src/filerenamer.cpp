@@ -1,10 +1,22 @@
 #include "filerenamer.h"
+#include "taskexecutor.h"
+#include "shared/directoryentry.h"
+#include "shared/filesorigin.h"
+#include "shared/util.h"
 #include <utility.h>
 #include <log.h>
+#include <QEventLoop>
 #include <QMessageBox>
 #include <QFileInfo>
+#include <QProgressDialog>
+#include <QTimer>
+#include <atomic>
 
 using namespace MOBase;
+using namespace MOShared;
+
+// number of files renamed by a single task in a batch
+static constexpr std::size_t RenamesPerTask = 256;
 
 FileRenamer::FileRenamer(QWidget* parent, QFlags<RenameFlags> flags)
   : m_parent(parent), m_flags(flags)
@@ -92,6 +104,199 @@ FileRenamer::RenameResults FileRenamer::rename(const QString& oldName, const QSt
   return RESULT_OK;
 }
 
+std::vector<FileRenamer::RenameResults> FileRenamer::rename(
+  const std::vector<Rename>& files)
+{
+  // everything is cancelled until it's renamed or skipped
+  std::vector<RenameResults> results(files.size(), RESULT_CANCEL);
+  std::vector<std::size_t> todo;
+
+  // existing files are handled here because they need the user
+  for (std::size_t i=0; i<files.size(); ++i) {
+    const auto& f = files[i];
+
+    if (!QFileInfo(f.newName).exists()) {
+      todo.push_back(i);
+      continue;
+    }
+
+    log::debug("{} already exists", f.newName);
+
+    const auto answer = confirmReplace(f.newName);
+
+    if (answer == DECISION_SKIP) {
+      log::debug("skipping {}", f.oldName);
+      results[i] = RESULT_SKIP;
+      continue;
+    } else if (answer != DECISION_REPLACE) {
+      log::debug("canceling");
+      break;
+    }
+
+    log::debug("removing {}", f.newName);
+    const auto r = shell::Delete(f.newName);
+
+    if (!r.success()) {
+      log::error("failed to remove '{}': {}", f.newName, r.toString());
+
+      if (!removeFailed(f.newName, r)) {
+        log::debug("canceling");
+        break;
+      }
+
+      log::debug("skipping {}", f.oldName);
+      results[i] = RESULT_SKIP;
+      continue;
+    }
+
+    todo.push_back(i);
+  }
+
+  if (todo.empty()) {
+    return results;
+  }
+
+  log::debug("renaming {} files", todo.size());
+
+  std::vector<DWORD> errors(files.size(), 0);
+  std::atomic<std::size_t> done = 0;
+
+  TaskGroup group(TaskPriority::High);
+
+  for (std::size_t begin=0; begin<todo.size(); begin+=RenamesPerTask) {
+    const auto end = std::min(begin + RenamesPerTask, todo.size());
+
+    group.run([&, begin, end] {
+      for (std::size_t t=begin; t<end; ++t) {
+        if (group.cancelled()) {
+          return;
+        }
+
+        const std::size_t i = todo[t];
+
+        const BOOL r = ::MoveFileExW(
+          QDir::toNativeSeparators(files[i].oldName).toStdWString().c_str(),
+          QDir::toNativeSeparators(files[i].newName).toStdWString().c_str(),
+          0);
+
+        if (r) {
+          results[i] = RESULT_OK;
+        } else {
+          errors[i] = ::GetLastError();
+          results[i] = RESULT_SKIP;
+        }
+
+        ++done;
+      }
+    });
+  }
+
+  QProgressDialog progress(
+    (m_flags & HIDE) ? QObject::tr("Hiding files...") : QObject::tr("Unhiding files..."),
+    QObject::tr("Cancel"), 0, static_cast<int>(todo.size()), m_parent);
+
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setAutoReset(false);
+  progress.setMinimumDuration(500);
+
+  QEventLoop loop;
+  QTimer timer;
+
+  QObject::connect(&progress, &QProgressDialog::canceled, [&]{ group.cancel(); });
+
+  QObject::connect(&timer, &QTimer::timeout, [&]{
+    progress.setValue(static_cast<int>(done.load()));
+
+    if (group.finished()) {
+      loop.quit();
+    }
+  });
+
+  timer.start(50);
+  loop.exec();
+  group.wait();
+
+  std::size_t failed = 0;
+  QString firstError;
+
+  for (std::size_t i=0; i<files.size(); ++i) {
+    if (errors[i] == 0) {
+      continue;
+    }
+
+    const auto e = formatSystemMessage(errors[i]);
+
+    log::error(
+      "failed to rename '{}' to '{}': {}",
+      files[i].oldName, files[i].newName, e);
+
+    if (failed == 0) {
+      firstError = QObject::tr("Failed to rename file: %1.\r\n\r\n"
+        "Source:\r\n\"%2\"\r\n\r\n"
+        "Destination:\r\n\"%3\"")
+          .arg(e)
+          .arg(QDir::toNativeSeparators(files[i].oldName))
+          .arg(QDir::toNativeSeparators(files[i].newName));
+    }
+
+    ++failed;
+  }
+
+  if (failed > 0) {
+    QString text = firstError;
+
+    if (failed > 1) {
+      text = QObject::tr("%1 files could not be renamed, see the log for details.")
+        .arg(failed) + "\r\n\r\n" + text;
+    }
+
+    QMessageBox::critical(
+      m_parent, QObject::tr("File operation failed"), text);
+  }
+
+  return results;
+}
+
+bool FileRenamer::patchStructure(
+  DirectoryEntry& root, FilesOrigin& origin,
+  const std::vector<Rename>& files, const std::vector<RenameResults>& results)
+{
+  const QString originPath =
+    QDir::fromNativeSeparators(ToQString(origin.getPath())) + "/";
+
+  // the graph must be updated around the change, see ConflictGraph
+  const std::vector<OriginID> ids = {origin.getID()};
+  root.getFileRegister()->conflicts().exclude(ids);
+
+  bool all = true;
+
+  for (std::size_t i=0; i<files.size(); ++i) {
+    if (results[i] != RESULT_OK) {
+      continue;
+    }
+
+    const QString oldName = QDir::fromNativeSeparators(files[i].oldName);
+
+    if (!oldName.startsWith(originPath, Qt::CaseInsensitive)) {
+      all = false;
+      continue;
+    }
+
+    const QString relative = QDir::toNativeSeparators(
+      oldName.mid(originPath.size()));
+
+    if (!root.renameFile(
+      ToWString(relative), ToWString(QFileInfo(files[i].newName).fileName()),
+      origin)) {
+      all = false;
+    }
+  }
+
+  root.getFileRegister()->conflicts().include(ids);
+
+  return all;
+}
+
 FileRenamer::RenameDecision FileRenamer::confirmReplace(const QString& newName)
 {
   if (m_flags & REPLACE_ALL) {
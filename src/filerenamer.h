@@ -2,9 +2,16 @@
 #define FILERENAMER_H
 
 #include <QWidget>
+#include <vector>
 
 namespace MOBase::shell { class Result; }
 
+namespace MOShared
+{
+  class DirectoryEntry;
+  class FilesOrigin;
+}
+
 /**
 * Renames individual files and handles dialog boxes to confirm replacements and
 * failures with the user
@@ -71,6 +78,16 @@ public:
   };
 
 
+  /**
+  * a file to rename in a batch
+  **/
+  struct Rename
+  {
+    QString oldName;
+    QString newName;
+  };
+
+
   /**
   * @param parent Parent widget for dialog boxes
   **/
@@ -84,6 +101,27 @@ public:
   **/
   RenameResults rename(const QString& oldName, const QString& newName);
 
+  /**
+  * renames all the given files; replacements are confirmed with the user
+  * first, then the renames run on the task executor behind a progress dialog
+  * and failures are reported once at the end
+  * @param files files to rename
+  * @return the result for each file, in the same order; files that were not
+  *         renamed because the user cancelled are RESULT_CANCEL
+  **/
+  std::vector<RenameResults> rename(const std::vector<Rename>& files);
+
+  /**
+  * updates the given origin of the structure for the files renamed by
+  * rename(), instead of walking the origin again; see
+  * DirectoryEntry::renameFile()
+  * @return false if some of the renamed files, such as directories, could not
+  *         be patched, in which case the origin must be walked again
+  **/
+  static bool patchStructure(
+    MOShared::DirectoryEntry& root, MOShared::FilesOrigin& origin,
+    const std::vector<Rename>& files, const std::vector<RenameResults>& results);
+
 private:
   /**
   *user's decision when replacing
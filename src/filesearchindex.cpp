@@ -0,0 +1,492 @@
+#include "filesearchindex.h"
+#include "metrics.h"
+#include "structureview.h"
+#include "shared/directoryentry.h"
+#include "shared/fileentry.h"
+#include <log.h>
+#include <algorithm>
+#include <unordered_map>
+
+using namespace MOBase;
+using namespace MOShared;
+
+// lowercase of the given characters as utf-8, slashes become backslashes;
+// surrogates are encoded one by one, which doesn't matter since queries are
+// encoded the same way
+//
+static void appendFolded(std::string& out, std::wstring_view s)
+{
+  for (wchar_t wc : s) {
+    if (wc == L'/') {
+      wc = L'\\';
+    }
+
+    const auto c = static_cast<std::uint32_t>(DirectoryEntryFileKey::fold(wc));
+
+    if (c < 0x80) {
+      out.push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+      out.push_back(static_cast<char>(0xc0 | (c >> 6)));
+      out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    } else {
+      out.push_back(static_cast<char>(0xe0 | (c >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+      out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    }
+  }
+}
+
+static std::string folded(const QString& s)
+{
+  std::string out;
+  appendFolded(out, s.toStdWString());
+  return out;
+}
+
+// the reverse of appendFolded()
+//
+static QString decode(std::string_view s)
+{
+  std::wstring out;
+  out.reserve(s.size());
+
+  for (std::size_t i=0; i<s.size();) {
+    const auto c = static_cast<unsigned char>(s[i]);
+
+    if (c < 0x80) {
+      out.push_back(static_cast<wchar_t>(c));
+      i += 1;
+    } else if (c < 0xe0 && i + 1 < s.size()) {
+      out.push_back(static_cast<wchar_t>(
+        ((c & 0x1f) << 6) | (s[i + 1] & 0x3f)));
+      i += 2;
+    } else if (i + 2 < s.size()) {
+      out.push_back(static_cast<wchar_t>(
+        ((c & 0x0f) << 12) | ((s[i + 1] & 0x3f) << 6) | (s[i + 2] & 0x3f)));
+      i += 3;
+    } else {
+      break;
+    }
+  }
+
+  return QString::fromStdWString(out);
+}
+
+static std::uint32_t trigram(std::string_view s, std::size_t i)
+{
+  return
+    (static_cast<std::uint32_t>(static_cast<unsigned char>(s[i])) << 16) |
+    (static_cast<std::uint32_t>(static_cast<unsigned char>(s[i + 1])) << 8) |
+    static_cast<std::uint32_t>(static_cast<unsigned char>(s[i + 2]));
+}
+
+static void appendVarint(std::string& out, std::uint32_t v)
+{
+  while (v >= 0x80) {
+    out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+
+  out.push_back(static_cast<char>(v));
+}
+
+static std::uint32_t readVarint(const char*& p)
+{
+  std::uint32_t v = 0;
+
+  for (int shift=0; ; shift+=7) {
+    const auto b = static_cast<unsigned char>(*p++);
+    v |= static_cast<std::uint32_t>(b & 0x7f) << shift;
+
+    if ((b & 0x80) == 0) {
+      break;
+    }
+  }
+
+  return v;
+}
+
+
+// walks the structure once, filling in the directories and names, and the
+// trigrams as delta-encoded lists that are concatenated at the end
+//
+class FileSearchIndex::Builder
+{
+public:
+  Builder(FileSearchIndex& index, const std::function<bool ()>& cancelled)
+    : m_index(index), m_cancelled(cancelled)
+  {
+  }
+
+  // returns false if cancelled
+  //
+  bool walk(const DirectoryEntry& d, std::string& path)
+  {
+    if (m_cancelled()) {
+      return false;
+    }
+
+    const std::size_t dirIndex = m_index.m_dirs.size();
+
+    Directory dir = {};
+    dir.path = static_cast<std::uint32_t>(m_index.m_paths.size());
+    m_index.m_paths += path;
+    dir.pathEnd = static_cast<std::uint32_t>(m_index.m_paths.size());
+    dir.firstFile = files();
+
+    m_index.m_dirs.push_back(dir);
+
+    d.forEachFile([&](const FileEntry& file) {
+      addFile(file.getName());
+      return true;
+    });
+
+    m_index.m_dirs[dirIndex].endFiles = files();
+
+    bool ok = true;
+
+    d.forEachDirectory([&](const DirectoryEntry& sub) {
+      const std::size_t size = path.size();
+
+      appendFolded(path, sub.getName());
+      path += '\\';
+
+      ok = walk(sub, path);
+      path.resize(size);
+
+      return ok;
+    });
+
+    return ok;
+  }
+
+  void finish()
+  {
+    m_index.m_nameStarts.push_back(
+      static_cast<std::uint32_t>(m_index.m_names.size()));
+
+    m_index.m_trigrams.reserve(m_postings.size());
+
+    for (auto&& [key, p] : m_postings) {
+      m_index.m_trigrams.push_back({key, p.count, 0});
+    }
+
+    std::sort(
+      m_index.m_trigrams.begin(), m_index.m_trigrams.end(),
+      [](auto&& a, auto&& b) { return a.key < b.key; });
+
+    for (auto& t : m_index.m_trigrams) {
+      auto& p = m_postings[t.key];
+
+      t.postings = static_cast<std::uint32_t>(m_index.m_postings.size());
+      m_index.m_postings += p.bytes;
+
+      p.bytes = {};
+    }
+
+    m_index.m_paths.shrink_to_fit();
+    m_index.m_dirs.shrink_to_fit();
+    m_index.m_names.shrink_to_fit();
+    m_index.m_nameStarts.shrink_to_fit();
+    m_index.m_postings.shrink_to_fit();
+  }
+
+private:
+  struct Postings
+  {
+    std::string bytes;
+    std::uint32_t last = 0;
+    std::uint32_t count = 0;
+  };
+
+  FileSearchIndex& m_index;
+  const std::function<bool ()>& m_cancelled;
+  std::unordered_map<std::uint32_t, Postings> m_postings;
+
+  // trigrams of the current name, reused
+  std::vector<std::uint32_t> m_keys;
+
+  std::uint32_t files() const
+  {
+    return static_cast<std::uint32_t>(m_index.m_nameStarts.size());
+  }
+
+  void addFile(std::wstring_view name)
+  {
+    const std::uint32_t id = files();
+    const std::size_t start = m_index.m_names.size();
+
+    m_index.m_nameStarts.push_back(static_cast<std::uint32_t>(start));
+    appendFolded(m_index.m_names, name);
+
+    const std::string_view s(
+      m_index.m_names.data() + start, m_index.m_names.size() - start);
+
+    m_keys.clear();
+    for (std::size_t i=0; i + 3 <= s.size(); ++i) {
+      m_keys.push_back(trigram(s, i));
+    }
+
+    std::sort(m_keys.begin(), m_keys.end());
+    m_keys.erase(std::unique(m_keys.begin(), m_keys.end()), m_keys.end());
+
+    for (const auto key : m_keys) {
+      auto& p = m_postings[key];
+
+      // files are added in order, so the deltas are positive
+      appendVarint(p.bytes, id - p.last);
+      p.last = id;
+      ++p.count;
+    }
+  }
+};
+
+
+std::shared_ptr<const FileSearchIndex> FileSearchIndex::build(
+  const StructureView& view, const std::function<bool ()>& cancelled)
+{
+  Metrics::Timer tt("FileSearchIndex::build()");
+
+  const auto* root = view.root();
+  if (!root) {
+    return {};
+  }
+
+  auto index = std::make_shared<FileSearchIndex>();
+  Builder b(*index, cancelled);
+
+  std::string path = "\\";
+  if (!b.walk(*root, path)) {
+    return {};
+  }
+
+  b.finish();
+
+  log::debug(
+    "search index has {} files in {} directories, {} trigrams",
+    index->fileCount(), index->m_dirs.size(), index->m_trigrams.size());
+
+  return index;
+}
+
+QStringList FileSearchIndex::find(
+  const QString& text, std::size_t max, bool* truncated) const
+{
+  const std::string q = folded(text);
+
+  if (truncated) {
+    *truncated = false;
+  }
+
+  if (q.empty()) {
+    return {};
+  }
+
+  std::vector<std::uint32_t> ids;
+
+  // a match that crosses into the name must end the directory path with the
+  // part of the query up to its last separator, the rest starts the name
+  const auto sep = q.rfind('\\');
+  const std::string_view head =
+    (sep == std::string::npos) ? std::string_view() : std::string_view(q).substr(0, sep + 1);
+  const std::string_view tail =
+    (sep == std::string::npos) ? std::string_view() : std::string_view(q).substr(sep + 1);
+
+  for (const auto& d : m_dirs) {
+    const std::string_view p(m_paths.data() + d.path, d.pathEnd - d.path);
+
+    if (p.find(q) != std::string_view::npos) {
+      // the path of the directory is part of the path of all its files
+      for (auto id=d.firstFile; id<d.endFiles; ++id) {
+        ids.push_back(id);
+      }
+    } else if (!head.empty() && p.ends_with(head)) {
+      for (auto id=d.firstFile; id<d.endFiles; ++id) {
+        if (name(id).starts_with(tail)) {
+          ids.push_back(id);
+        }
+      }
+    }
+  }
+
+  if (sep == std::string::npos) {
+    findInNames(q, 0, fileCount(), ids);
+  }
+
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  if (ids.size() > max) {
+    ids.resize(max);
+
+    if (truncated) {
+      *truncated = true;
+    }
+  }
+
+  QStringList list;
+  list.reserve(static_cast<int>(ids.size()));
+
+  for (const auto id : ids) {
+    list.append(relativePath(id));
+  }
+
+  return list;
+}
+
+QStringList FileSearchIndex::findNames(
+  const QString& dir, const QString& text) const
+{
+  const std::string q = folded(text);
+  if (q.empty() || q.find('\\') != std::string::npos) {
+    return {};
+  }
+
+  std::wstring d = dir.toStdWString();
+  if (d == L".") {
+    d.clear();
+  }
+
+  std::replace(d.begin(), d.end(), L'/', L'\\');
+
+  const auto first = d.find_first_not_of(L'\\');
+  const auto last = d.find_last_not_of(L'\\');
+
+  std::string p = "\\";
+
+  if (first != std::wstring::npos) {
+    appendFolded(p, std::wstring_view(d).substr(first, last - first + 1));
+    p += '\\';
+  }
+
+  for (std::size_t i=0; i<m_dirs.size(); ++i) {
+    if (path(i) != p) {
+      continue;
+    }
+
+    std::vector<std::uint32_t> ids;
+    findInNames(q, m_dirs[i].firstFile, m_dirs[i].endFiles, ids);
+
+    QStringList list;
+    list.reserve(static_cast<int>(ids.size()));
+
+    for (const auto id : ids) {
+      list.append(relativePath(id));
+    }
+
+    return list;
+  }
+
+  return {};
+}
+
+std::size_t FileSearchIndex::fileCount() const
+{
+  return (m_nameStarts.empty() ? 0 : m_nameStarts.size() - 1);
+}
+
+MemoryUsage FileSearchIndex::memoryUsage() const
+{
+  MemoryUsage u;
+
+  u.count = fileCount();
+  u.bytes =
+    m_paths.capacity() +
+    m_dirs.capacity() * sizeof(Directory) +
+    m_names.capacity() +
+    m_nameStarts.capacity() * sizeof(std::uint32_t) +
+    m_trigrams.capacity() * sizeof(Trigram) +
+    m_postings.capacity();
+
+  return u;
+}
+
+std::string_view FileSearchIndex::path(std::size_t dir) const
+{
+  const auto& d = m_dirs[dir];
+  return {m_paths.data() + d.path, d.pathEnd - d.path};
+}
+
+std::string_view FileSearchIndex::name(std::size_t file) const
+{
+  return {
+    m_names.data() + m_nameStarts[file],
+    m_nameStarts[file + 1] - m_nameStarts[file]};
+}
+
+std::size_t FileSearchIndex::dirOf(std::size_t file) const
+{
+  // the last directory starting at or before the file; empty directories
+  // after the one that has the file start after it
+  auto itor = std::upper_bound(
+    m_dirs.begin(), m_dirs.end(), file,
+    [](std::size_t f, auto&& d) { return f < d.firstFile; });
+
+  return static_cast<std::size_t>(std::distance(m_dirs.begin(), itor)) - 1;
+}
+
+void FileSearchIndex::findInNames(
+  std::string_view q, std::size_t begin, std::size_t end,
+  std::vector<std::uint32_t>& out) const
+{
+  if (q.size() < 3) {
+    for (auto id=begin; id<end; ++id) {
+      if (name(id).find(q) != std::string_view::npos) {
+        out.push_back(static_cast<std::uint32_t>(id));
+      }
+    }
+
+    return;
+  }
+
+  // only the files having the rarest trigram of the query are checked
+  const Trigram* best = nullptr;
+
+  for (std::size_t i=0; i + 3 <= q.size(); ++i) {
+    const auto key = trigram(q, i);
+
+    auto itor = std::lower_bound(
+      m_trigrams.begin(), m_trigrams.end(), key,
+      [](auto&& t, std::uint32_t k) { return t.key < k; });
+
+    if (itor == m_trigrams.end() || itor->key != key) {
+      // no name has this trigram
+      return;
+    }
+
+    if (!best || itor->count < best->count) {
+      best = &*itor;
+    }
+  }
+
+  const char* p = m_postings.data() + best->postings;
+  std::uint32_t id = 0;
+
+  for (std::uint32_t i=0; i<best->count; ++i) {
+    id += readVarint(p);
+
+    if (id < begin) {
+      continue;
+    } else if (id >= end) {
+      break;
+    }
+
+    if (name(id).find(q) != std::string_view::npos) {
+      out.push_back(id);
+    }
+  }
+}
+
+QString FileSearchIndex::relativePath(std::size_t file) const
+{
+  // without the leading backslash
+  const auto p = path(dirOf(file)).substr(1);
+  const auto n = name(file);
+
+  std::string s;
+  s.reserve(p.size() + n.size());
+  s += p;
+  s += n;
+
+  return decode(s);
+}
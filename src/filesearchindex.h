@@ -0,0 +1,111 @@
+#ifndef MODORGANIZER_FILESEARCHINDEX_INCLUDED
+#define MODORGANIZER_FILESEARCHINDEX_INCLUDED
+
+#include "shared/memoryusage.h"
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class StructureView;
+
+// a substring index over the relative paths of all the files in the directory
+// structure, used by the search box of the data tab and by findFiles()
+//
+// paths are stored lowercase as utf-8 and split in directories and file
+// names: the files of a directory are contiguous and in the order of the
+// directories, so files only store where their name starts; file names are also indexed by trigram, each trigram has the
+// sorted list of the files whose name contains it, delta-encoded
+//
+// a query on a name looks up the trigram of the query that has the fewest
+// files and only checks those, queries shorter than a trigram check all the
+// names; directory paths are few enough that they're always checked directly
+//
+// the index is a snapshot, it doesn't change once built and can be used from
+// any thread; it's rebuilt in the background after refreshes, so matches
+// must be looked up in the structure, which may not have them anymore
+//
+class FileSearchIndex
+{
+public:
+  // builds an index over the structure of the given view; `cancelled` is
+  // checked regularly, null is returned once it returns true
+  //
+  static std::shared_ptr<const FileSearchIndex> build(
+    const StructureView& view, const std::function<bool ()>& cancelled);
+
+  // relative paths of the files whose relative path contains the given text,
+  // case-insensitive, slashes are backslashes; at most `max` paths are
+  // returned, `truncated` is set when there were more
+  //
+  // the paths are lowercase and in the order of the structure
+  //
+  QStringList find(
+    const QString& text, std::size_t max, bool* truncated=nullptr) const;
+
+  // relative paths of the files whose name contains the given text,
+  // case-insensitive, directly in the given directory like findFiles(); ""
+  // and "." are the root
+  //
+  QStringList findNames(const QString& dir, const QString& text) const;
+
+  std::size_t fileCount() const;
+
+  MOShared::MemoryUsage memoryUsage() const;
+
+private:
+  struct Directory
+  {
+    // the path is between these offsets in m_paths, it starts and ends with a
+    // backslash; the root is a single backslash
+    std::uint32_t path;
+    std::uint32_t pathEnd;
+
+    // files directly in this directory
+    std::uint32_t firstFile;
+    std::uint32_t endFiles;
+  };
+
+  struct Trigram
+  {
+    std::uint32_t key;
+    std::uint32_t count;
+
+    // offset of the delta-encoded file indices in m_postings
+    std::uint32_t postings;
+  };
+
+  class Builder;
+
+  std::string m_paths;
+  std::vector<Directory> m_dirs;
+
+  // names of all the files one after the other, file `i` is between
+  // m_nameStarts[i] and m_nameStarts[i + 1]
+  std::string m_names;
+  std::vector<std::uint32_t> m_nameStarts;
+
+  // sorted by key
+  std::vector<Trigram> m_trigrams;
+  std::string m_postings;
+
+  std::string_view path(std::size_t dir) const;
+  std::string_view name(std::size_t file) const;
+
+  // the directory containing the given file
+  //
+  std::size_t dirOf(std::size_t file) const;
+
+  // appends the files in [begin, end) whose name contains `q`
+  //
+  void findInNames(
+    std::string_view q, std::size_t begin, std::size_t end,
+    std::vector<std::uint32_t>& out) const;
+
+  QString relativePath(std::size_t file) const;
+};
+
+#endif // MODORGANIZER_FILESEARCHINDEX_INCLUDED
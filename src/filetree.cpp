@@ -6,6 +6,9 @@
 #include "shared/fileentry.h"
 #include "shared/directoryentry.h"
 #include "shared/filesorigin.h"
+#include "shared/util.h"
+#include "structureview.h"
+#include "taskexecutor.h"
 #include <log.h>
 #include <widgetutility.h>
 
@@ -16,22 +19,22 @@ using namespace MOBase;
 bool canPreviewFile(const PluginContainer& pc, const FileEntry& file)
 {
   return canPreviewFile(
-    pc, file.isFromArchive(), QString::fromStdWString(file.getName()));
+    pc, file.isFromArchive(), ToQString(file.getName()));
 }
 
 bool canRunFile(const FileEntry& file)
 {
-  return canRunFile(file.isFromArchive(), QString::fromStdWString(file.getName()));
+  return canRunFile(file.isFromArchive(), ToQString(file.getName()));
 }
 
 bool canOpenFile(const FileEntry& file)
 {
-  return canOpenFile(file.isFromArchive(), QString::fromStdWString(file.getName()));
+  return canOpenFile(file.isFromArchive(), ToQString(file.getName()));
 }
 
 bool isHidden(const FileEntry& file)
 {
-  return (QString::fromStdWString(file.getName()).endsWith(ModInfo::s_HiddenExt, Qt::CaseInsensitive));
+  return (ToQString(file.getName()).endsWith(ModInfo::s_HiddenExt, Qt::CaseInsensitive));
 }
 
 bool canExploreFile(const FileEntry& file);
@@ -145,8 +148,14 @@ FileTree::FileTree(OrganizerCore& core, PluginContainer& pc, QTreeView* tree)
   connect(
     m_tree, &QTreeView::activated,
     [&](auto&& index){ onItemActivated(index); });
+
+  connect(
+    m_tree->selectionModel(), &QItemSelectionModel::currentChanged,
+    [&](auto&& index){ onCurrentChanged(index); });
 }
 
+FileTree::~FileTree() = default;
+
 FileTreeModel* FileTree::model()
 {
   return m_model;
@@ -154,11 +163,17 @@ FileTreeModel* FileTree::model()
 
 void FileTree::refresh()
 {
+  m_shellMenu.reset();
+  m_shellMenuFiles.clear();
+
   m_model->refresh();
 }
 
 void FileTree::clear()
 {
+  m_shellMenu.reset();
+  m_shellMenuFiles.clear();
+
   m_model->clear();
 }
 
@@ -357,11 +372,11 @@ void FileTree::openModInfo(FileTreeItem* item)
   }
 
   const auto& origin = m_core.directoryStructure()->getOriginByID(originID);
-  const auto& name = QString::fromStdWString(origin.getName());
-
-  unsigned int index = ModInfo::getIndex(name);
+  unsigned int index = ModInfo::getIndex(origin);
   if (index == UINT_MAX) {
-    log::error("can't open mod info, mod '{}' not found", name);
+    log::error(
+      "can't open mod info, mod '{}' not found",
+      QString::fromStdWString(origin.getName()));
     return;
   }
 
@@ -412,8 +427,18 @@ void FileTree::toggleVisibility(bool visible, FileTreeItem* item)
     m_tree->window(),
     (visible ? FileRenamer::UNHIDE : FileRenamer::HIDE));
 
-  if (renamer.rename(currentName, newName) == FileRenamer::RESULT_OK) {
-    emit originModified(item->originID());
+  const std::vector<FileRenamer::Rename> renames = {{currentName, newName}};
+  const auto results = renamer.rename(renames);
+
+  if (results.front() == FileRenamer::RESULT_OK) {
+    auto* structure = m_core.directoryStructure();
+
+    // the origin is patched in place, it's only walked again if that fails
+    if (!FileRenamer::patchStructure(
+      *structure, structure->getOriginByID(item->originID()), renames, results)) {
+      emit originModified(item->originID());
+    }
+
     refresh();
   }
 }
@@ -434,13 +459,30 @@ void FileTree::dumpToFile() const
 {
   log::debug("dumping filetree to file");
 
-  QString file = QFileDialog::getSaveFileName(m_tree->window());
+  const QString textFilter = tr("Text files") + " (*.txt)";
+  const QString snapshotFilter = tr("Structure snapshots") + " (*.snapshot)";
+
+  QString filter;
+  const QString file = QFileDialog::getSaveFileName(
+    m_tree->window(), {}, {}, textFilter + ";;" + snapshotFilter, &filter);
+
   if (file.isEmpty()) {
     log::debug("user canceled");
     return;
   }
 
-  m_core.directoryStructure()->dump(file.toStdWString());
+  const auto format = (filter == snapshotFilter) ?
+    StructureView::DumpFormat::Snapshot : StructureView::DumpFormat::Text;
+
+  // large structures take a while, the view keeps the structure alive even if
+  // it's replaced by a refresh in the meantime
+  auto view = m_core.structureView();
+
+  TaskExecutor::instance().post(TaskPriority::Low, [view, file, format] {
+    if (view.dump(file, format)) {
+      log::debug("filetree dumped to '{}'", file);
+    }
+  });
 }
 
 void FileTree::onExpandedChanged(const QModelIndex& index, bool expanded)
@@ -460,6 +502,24 @@ void FileTree::onItemActivated(const QModelIndex& index)
   activate(item);
 }
 
+void FileTree::onCurrentChanged(const QModelIndex& index)
+{
+  if (m_shellMenuPreloader) {
+    return;
+  }
+
+  auto* item = m_model->itemFromIndex(proxiedIndex(index));
+  if (!item || item->isDirectory() || item->isFromArchive()) {
+    return;
+  }
+
+  // the first shell menu loads all the shell extensions, which can take
+  // seconds; they're loaded in the background as soon as a file is selected
+  // so it's faster if the menu is requested later
+  m_shellMenuPreloader = std::make_unique<env::ShellMenuPreloader>(
+    item->realPath());
+}
+
 void FileTree::onContextMenu(const QPoint &pos)
 {
   const auto m = QApplication::keyboardModifiers();
@@ -528,6 +588,7 @@ bool FileTree::showShellMenu(QPoint pos)
 
   // menus by origin
   std::map<int, env::ShellMenu> menus;
+  std::vector<QString> files;
   int totalFiles = 0;
   bool warnOnEmpty = true;
 
@@ -569,6 +630,7 @@ bool FileTree::showShellMenu(QPoint pos)
     }
 
     itor->second.addFile(item->realPath());
+    files.push_back(item->realPath());
     ++totalFiles;
 
     if (item->isConflicted()) {
@@ -612,6 +674,7 @@ bool FileTree::showShellMenu(QPoint pos)
         }
 
         itor->second.addFile(QString::fromStdWString(fullPath));
+        files.push_back(QString::fromStdWString(fullPath));
       }
     }
   }
@@ -626,8 +689,20 @@ bool FileTree::showShellMenu(QPoint pos)
     return false;
   }
   else if (menus.size() == 1) {
-    auto& menu = menus.begin()->second;
-    menu.exec(m_tree->viewport()->mapToGlobal(pos));
+    // creating the shell objects can take a while, so they're kept and
+    // reused if the same files are right-clicked again; they're recreated
+    // once a command was invoked because it may have changed the files
+    if (!m_shellMenu || m_shellMenuFiles != files) {
+      m_shellMenu = std::make_unique<env::ShellMenu>(
+        std::move(menus.begin()->second));
+
+      m_shellMenuFiles = std::move(files);
+    }
+
+    if (m_shellMenu->exec(m_tree->viewport()->mapToGlobal(pos))) {
+      m_shellMenu.reset();
+      m_shellMenuFiles.clear();
+    }
   } else {
     env::ShellMenuCollection mc(mw);
     bool hasDiscrepancies = false;
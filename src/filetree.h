@@ -5,6 +5,7 @@
 #include "modinfodialogfwd.h"
 
 namespace MOShared { class FileEntry; }
+namespace env { class ShellMenu; class ShellMenuPreloader; }
 
 class OrganizerCore;
 class PluginContainer;
@@ -17,6 +18,7 @@ class FileTree : public QObject
 
 public:
   FileTree(OrganizerCore& core, PluginContainer& pc, QTreeView* tree);
+  ~FileTree();
 
   FileTreeModel* model();
   void refresh();
@@ -53,10 +55,19 @@ private:
   QTreeView* m_tree;
   FileTreeModel* m_model;
 
+  // shell menu of the last files right-clicked, reused when the same files
+  // are right-clicked again, see showShellMenu()
+  std::vector<QString> m_shellMenuFiles;
+  std::unique_ptr<env::ShellMenu> m_shellMenu;
+
+  // started when a file is first selected, see onCurrentChanged()
+  std::unique_ptr<env::ShellMenuPreloader> m_shellMenuPreloader;
+
   FileTreeItem* singleSelection();
 
   void onExpandedChanged(const QModelIndex& index, bool expanded);
   void onItemActivated(const QModelIndex& index);
+  void onCurrentChanged(const QModelIndex& index);
   void onContextMenu(const QPoint &pos);
   bool showShellMenu(QPoint pos);
 
@@ -3,6 +3,7 @@
 #include "modinfo.h"
 #include "shared/util.h"
 #include "modinfodialogfwd.h"
+#include "memoryaccounting.h"
 #include <log.h>
 #include <utility.h>
 
@@ -113,13 +114,9 @@ const QString& cachedFileType(const std::wstring& file, bool isOnFilesystem)
 
 FileTreeItem::FileTreeItem(
   FileTreeModel* model, FileTreeItem* parent,
-  std::wstring dataRelativeParentPath, bool isDirectory, std::wstring file) :
+  bool isDirectory, std::wstring_view file) :
     m_model(model), m_parent(parent), m_indexGuess(NoIndexGuess),
-    m_virtualParentPath(QString::fromStdWString(dataRelativeParentPath)),
-    m_wsFile(file),
-    m_wsLcFile(ToLowerCopy(file)),
-    m_key(m_wsLcFile),
-    m_file(QString::fromStdWString(file)),
+    m_file(QString::fromWCharArray(file.data(), static_cast<int>(file.size()))),
     m_isDirectory(isDirectory),
     m_originID(-1),
     m_flags(NoFlags),
@@ -130,30 +127,26 @@ FileTreeItem::FileTreeItem(
 }
 
 FileTreeItem::Ptr FileTreeItem::createFile(
-  FileTreeModel* model, FileTreeItem* parent,
-  std::wstring dataRelativeParentPath, std::wstring file)
+  FileTreeModel* model, FileTreeItem* parent, std::wstring_view file)
 {
-  return std::unique_ptr<FileTreeItem>(new FileTreeItem(
-    model, parent, std::move(dataRelativeParentPath), false, std::move(file)));
+  return std::unique_ptr<FileTreeItem>(
+    new FileTreeItem(model, parent, false, file));
 }
 
 FileTreeItem::Ptr FileTreeItem::createDirectory(
-  FileTreeModel* model, FileTreeItem* parent,
-  std::wstring dataRelativeParentPath, std::wstring file)
+  FileTreeModel* model, FileTreeItem* parent, std::wstring_view file)
 {
-  return std::unique_ptr<FileTreeItem>(new FileTreeItem(
-    model, parent, std::move(dataRelativeParentPath), true, std::move(file)));
+  return std::unique_ptr<FileTreeItem>(
+    new FileTreeItem(model, parent, true, file));
 }
 
 void FileTreeItem::setOrigin(
-  int originID, const std::wstring& realPath, Flags flags,
-  const std::wstring& mod)
+  int originID, QString originPath, Flags flags, QString mod)
 {
   m_originID = originID;
-  m_wsRealPath = realPath;
-  m_realPath = QString::fromStdWString(realPath);
+  m_originPath = std::move(originPath);
   m_flags = flags;
-  m_mod = QString::fromStdWString(mod);
+  m_mod = std::move(mod);
 
   m_fileSize.reset();
   m_lastModified.reset();
@@ -263,42 +256,75 @@ void FileTreeItem::makeSortingStale()
   }
 }
 
+MOShared::MemoryUsage FileTreeItem::memoryUsage() const
+{
+  MOShared::MemoryUsage u{1, sizeof(FileTreeItem)};
+
+  u.bytes += MemoryAccounting::bytes(m_file);
+  u.bytes += MOShared::vectorBytes(m_children);
+
+  if (m_fileType.value) {
+    u.bytes += MemoryAccounting::bytes(*m_fileType.value);
+  }
+
+  for (const auto& c : m_children) {
+    u += c->memoryUsage();
+  }
+
+  return u;
+}
+
+bool FileTreeItem::canSortChildren(int column)
+{
+  return (column == FileTreeModel::FileName || column == FileTreeModel::ModName);
+}
+
+void FileTreeItem::sortChildren(
+  Children& children, int column, Qt::SortOrder order)
+{
+  std::sort(children.begin(), children.end(), [&](auto&& a, auto&& b) {
+    int r = 0;
+
+    if (a->isDirectory() && !b->isDirectory()) {
+      if constexpr (AlwaysSortDirectoriesFirst) {
+        return true;
+      } else {
+        r = -1;
+      }
+    } else if (!a->isDirectory() && b->isDirectory()) {
+      if constexpr (AlwaysSortDirectoriesFirst) {
+        return false;
+      } else {
+        r = 1;
+      }
+    } else {
+      r = FileTreeItem::Sorter::compare(column, a.get(), b.get());
+    }
+
+    if (order == Qt::AscendingOrder) {
+      return (r < 0);
+    } else {
+      return (r > 0);
+    }
+  });
+}
+
 void FileTreeItem::sort(int column, Qt::SortOrder order, bool force)
 {
   if (!m_expanded) {
-    m_sortingStale = true;
+    // children that are already sorted stay sorted until the sort order
+    // changes, which forces the sort
+    if (force) {
+      m_sortingStale = true;
+    }
+
     return;
   }
 
   if (m_sortingStale || force) {
     //log::debug("sorting is stale for {}, sorting now", debugName());
     m_sortingStale = false;
-
-    std::sort(m_children.begin(), m_children.end(), [&](auto&& a, auto&& b) {
-      int r = 0;
-
-      if (a->isDirectory() && !b->isDirectory()) {
-        if constexpr (AlwaysSortDirectoriesFirst) {
-          return true;
-        } else {
-          r = -1;
-        }
-      } else if (!a->isDirectory() && b->isDirectory()) {
-        if constexpr (AlwaysSortDirectoriesFirst) {
-          return false;
-        } else {
-          r = 1;
-        }
-      } else {
-        r = FileTreeItem::Sorter::compare(column, a.get(), b.get());
-      }
-
-      if (order == Qt::AscendingOrder) {
-        return (r < 0);
-      } else {
-        return (r > 0);
-      }
-    });
+    sortChildren(m_children, column, order);
   }
 
   for (auto& child : m_children) {
@@ -310,8 +336,9 @@ QString FileTreeItem::virtualPath() const
 {
   QString s = "Data\\";
 
-  if (!m_virtualParentPath.isEmpty()) {
-    s += m_virtualParentPath + "\\";
+  const auto parentPath = dataRelativeParentPath();
+  if (!parentPath.isEmpty()) {
+    s += parentPath + "\\";
   }
 
   s += m_file;
@@ -319,6 +346,31 @@ QString FileTreeItem::virtualPath() const
   return s;
 }
 
+std::wstring FileTreeItem::filenameWsLowerCase() const
+{
+  return ToLowerCopy(m_file.toStdWString());
+}
+
+QString FileTreeItem::realPath() const
+{
+  if (m_isDirectory || m_originPath.isEmpty()) {
+    return {};
+  }
+
+  // same as FileEntry::getFullPath()
+  return m_originPath + "\\" + dataRelativeFilePath();
+}
+
+QString FileTreeItem::dataRelativeParentPath() const
+{
+  // the root has no name, so top level items have no parent path
+  if (!m_parent || !m_parent->m_parent) {
+    return {};
+  }
+
+  return m_parent->dataRelativeFilePath();
+}
+
 QString FileTreeItem::dataRelativeFilePath() const
 {
   auto path = dataRelativeParentPath();
@@ -346,10 +398,11 @@ std::optional<uint64_t> FileTreeItem::fileSize() const
 {
   if (m_fileSize.empty() && !m_isDirectory) {
     std::error_code ec;
-    const auto size = fs::file_size(fs::path(m_wsRealPath), ec);
+    const auto path = realPath();
+    const auto size = fs::file_size(fs::path(path.toStdWString()), ec);
 
     if (ec) {
-      log::error("can't get file size for '{}', {}", m_realPath, ec.message());
+      log::error("can't get file size for '{}', {}", path, ec.message());
       m_fileSize.fail();
     } else {
       m_fileSize.set(size);
@@ -362,7 +415,9 @@ std::optional<uint64_t> FileTreeItem::fileSize() const
 std::optional<QDateTime> FileTreeItem::lastModified() const
 {
   if (m_lastModified.empty()) {
-    if (m_realPath.isEmpty()) {
+    const auto path = realPath();
+
+    if (path.isEmpty()) {
       // this is a virtual directory
       m_lastModified.set({});
     } else if (isFromArchive()) {
@@ -370,11 +425,11 @@ std::optional<QDateTime> FileTreeItem::lastModified() const
       m_lastModified.set({});
     } else {
       // looks like a regular file on the filesystem
-      const QFileInfo fi(m_realPath);
+      const QFileInfo fi(path);
       const auto d = fi.lastModified();
 
       if (!d.isValid()) {
-        log::error("can't get last modified date for '{}'", m_realPath);
+        log::error("can't get last modified date for '{}'", path);
         m_lastModified.fail();
       } else {
         m_lastModified.set(d);
@@ -401,7 +456,7 @@ void FileTreeItem::getFileType() const
     return;
   }
 
-  const auto& t = cachedFileType(m_wsRealPath, !isFromArchive());
+  const auto& t = cachedFileType(realPath().toStdWString(), !isFromArchive());
   if (t.isEmpty()) {
     m_fileType.fail();
   } else {
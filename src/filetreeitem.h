@@ -2,6 +2,7 @@
 #define MODORGANIZER_FILETREEITEM_INCLUDED
 
 #include "shared/fileregisterfwd.h"
+#include "shared/memoryusage.h"
 #include <QFileIconProvider>
 
 class FileTreeModel;
@@ -24,22 +25,25 @@ public:
 
   Q_DECLARE_FLAGS(Flags, Flag);
 
+  // the paths of an item are derived from its parents, so the parent must
+  // be the item that will contain it
+  //
   static Ptr createFile(
-    FileTreeModel* model, FileTreeItem* parent,
-    std::wstring dataRelativeParentPath, std::wstring file);
+    FileTreeModel* model, FileTreeItem* parent, std::wstring_view file);
 
   static Ptr createDirectory(
-    FileTreeModel* model, FileTreeItem* parent,
-    std::wstring dataRelativeParentPath, std::wstring file);
+    FileTreeModel* model, FileTreeItem* parent, std::wstring_view file);
 
   FileTreeItem(const FileTreeItem&) = delete;
   FileTreeItem& operator=(const FileTreeItem&) = delete;
   FileTreeItem(FileTreeItem&&) = default;
   FileTreeItem& operator=(FileTreeItem&&) = default;
 
+  // the strings are usually shared by all the items from the same origin,
+  // see FileTreeModel::originStrings()
+  //
   void setOrigin(
-    int originID, const std::wstring& realPath,
-    Flags flags, const std::wstring& mod);
+    int originID, QString originPath, Flags flags, QString mod);
 
   void add(Ptr child)
   {
@@ -95,6 +99,27 @@ public:
   void sort(int column, Qt::SortOrder order, bool force);
   void makeSortingStale();
 
+  // estimated memory used by this item and its children; the origin strings
+  // are shared and not counted, see FileTreeModel::originStrings()
+  //
+  MOShared::MemoryUsage memoryUsage() const;
+
+  // sorts the given children without touching the model, used to sort items
+  // that are not in the tree yet, see FileTreeModel::ensureFullyLoaded();
+  // only sorting by name or mod is supported because the other columns may
+  // have to query the shell
+  //
+  static bool canSortChildren(int column);
+  static void sortChildren(Children& children, int column, Qt::SortOrder order);
+
+  // the children have been sorted with sortChildren() with the current sort
+  // order
+  //
+  void setSorted()
+  {
+    m_sortingStale = false;
+  }
+
   FileTreeItem* parent()
   {
     return m_parent;
@@ -105,11 +130,6 @@ public:
     return m_originID;
   }
 
-  const QString& virtualParentPath() const
-  {
-    return m_virtualParentPath;
-  }
-
   QString virtualPath() const;
 
   const QString& filename() const
@@ -117,19 +137,11 @@ public:
     return m_file;
   }
 
-  const std::wstring& filenameWs() const
-  {
-    return m_wsFile;
-  }
-
-  const std::wstring& filenameWsLowerCase() const
-  {
-    return m_wsLcFile;
-  }
+  std::wstring filenameWsLowerCase() const;
 
-  const MOShared::DirectoryEntryFileKey& key() const
+  MOShared::DirectoryEntryFileKey key() const
   {
-    return m_key;
+    return {filenameWsLowerCase()};
   }
 
   const QString& mod() const
@@ -158,16 +170,11 @@ public:
     m_compressedFileSize.override(compressedSize);
   }
 
-  const QString& realPath() const
-  {
-    return m_realPath;
-  }
-
-  const QString& dataRelativeParentPath() const
-  {
-    return m_virtualParentPath;
-  }
+  // the path of the file in its origin, empty for directories
+  //
+  QString realPath() const;
 
+  QString dataRelativeParentPath() const;
   QString dataRelativeFilePath() const;
 
   QFileIconProvider::IconType icon() const;
@@ -287,15 +294,13 @@ private:
   FileTreeItem* m_parent;
   mutable std::size_t m_indexGuess;
 
-  const QString m_virtualParentPath;
-  const std::wstring m_wsFile, m_wsLcFile;
-  const MOShared::DirectoryEntryFileKey m_key;
+  // this is the only string owned by an item, the paths are built from the
+  // names of the parents when needed
   const QString m_file;
   const bool m_isDirectory;
 
   int m_originID;
-  QString m_realPath;
-  std::wstring m_wsRealPath;
+  QString m_originPath;
   Flags m_flags;
   QString m_mod;
 
@@ -312,7 +317,7 @@ private:
 
   FileTreeItem(
     FileTreeModel* model, FileTreeItem* parent,
-    std::wstring dataRelativeParentPath, bool isDirectory, std::wstring file);
+    bool isDirectory, std::wstring_view file);
 
   void getFileType() const;
   void queueSort();
@@ -1,9 +1,11 @@
 #include "filetreemodel.h"
+#include "metrics.h"
 #include "organizercore.h"
 #include "shared/filesorigin.h"
 #include "shared/util.h"
 #include "shared/directoryentry.h"
 #include "shared/fileentry.h"
+#include "taskexecutor.h"
 #include <log.h>
 #include <moassert.h>
 
@@ -53,6 +55,24 @@ QString UnmanagedModName();
 // fetching
 
 
+// about loadAll()
+//
+// "expand all" and searching need the whole tree to be loaded, which used to
+// go through fetchMore() for every directory on the ui thread
+//
+// items that were never loaded have no children yet, so there's nothing to
+// compare with the structure: their children are built, filtered and sorted
+// by the task executor without touching the model, and are then inserted
+// with one beginInsertRows()/endInsertRows() per item; the ui thread waits
+// for the tasks, which is also what guarantees the structure doesn't change
+// while it's read
+
+
+// directories this deep or less below an unloaded item have their
+// subdirectories built in parallel
+constexpr int ParallelLoadDepth = 2;
+
+
 // tracks a contiguous range in the model to avoid calling begin*Rows(), etc.
 // for every single item that's added/removed
 //
@@ -195,8 +215,10 @@ void* makeInternalPointer(FileTreeItem* item)
 
 FileTreeModel::FileTreeModel(OrganizerCore& core, QObject* parent) :
   QAbstractItemModel(parent), m_core(core), m_enabled(true),
-  m_root(FileTreeItem::createDirectory(this, nullptr, L"", L"")),
-  m_flags(NoFlags), m_fullyLoaded(false), m_sortingEnabled(true)
+  m_root(FileTreeItem::createDirectory(this, nullptr, L"")),
+  m_flags(NoFlags), m_fullyLoaded(false), m_sortingEnabled(true),
+  m_itemsMemory("file tree: items", [this]{ return itemsMemory(); }),
+  m_iconsMemory("file tree: icons", [this]{ return m_iconFetcher.memoryUsage(); })
 {
   m_root->setExpanded(true);
   m_sortTimer.setSingleShot(true);
@@ -206,11 +228,33 @@ FileTreeModel::FileTreeModel(OrganizerCore& core, QObject* parent) :
   connect(&m_iconPendingTimer, &QTimer::timeout, [&]{ updatePendingIcons(); });
 }
 
+MOShared::MemoryUsage FileTreeModel::itemsMemory() const
+{
+  auto u = m_root->memoryUsage();
+
+  std::scoped_lock lock(m_originStringsMutex);
+
+  u.bytes += MOShared::treeBytes(m_originStrings);
+
+  for (auto&& [key, s] : m_originStrings) {
+    u.bytes += MOShared::stringBytes(key.second);
+    u.bytes += MemoryAccounting::bytes(s.path) + MemoryAccounting::bytes(s.mod);
+  }
+
+  return u;
+}
+
 void FileTreeModel::refresh()
 {
-  TimeThis tt("FileTreeModel::refresh()");
+  Metrics::Timer tt("FileTreeModel::refresh()");
 
   m_fullyLoaded = false;
+
+  {
+    std::scoped_lock lock(m_originStringsMutex);
+    m_originStrings.clear();
+  }
+
   update(*m_root, *m_core.directoryStructure(), L"", false);
   sortItem(*m_root, false);
 }
@@ -224,27 +268,164 @@ void FileTreeModel::clear()
   endResetModel();
 }
 
-void FileTreeModel::recursiveFetchMore(const QModelIndex& m)
+void FileTreeModel::ensureFullyLoaded()
+{
+  if (!m_fullyLoaded) {
+    Metrics::Timer tt("FileTreeModel:: fully loading for search");
+    loadAll();
+    sortItem(*m_root, false);
+    m_fullyLoaded = true;
+  }
+}
+
+void FileTreeModel::loadAll()
 {
-  if (canFetchMore(m)) {
-    doFetchMore(m, false, false);
+  if (!m_enabled) {
+    return;
+  }
+
+  std::vector<PendingLoad> loads;
+  collectUnloaded(*m_root, loads);
+
+  if (loads.empty()) {
+    return;
+  }
+
+  const auto f = filters();
+
+  {
+    TaskGroup tasks(TaskPriority::High);
+
+    for (auto& load : loads) {
+      tasks.run([&, p=&load] {
+        p->children = buildChildren(*p->item, *p->entry, f, 0);
+      });
+    }
+
+    tasks.wait();
   }
 
-  for (int i=0; i<rowCount(m); ++i) {
-    recursiveFetchMore(index(i, 0, m));
+  const bool sorted = FileTreeItem::canSortChildren(m_sort.column);
+
+  for (auto& load : loads) {
+    load.item->setLoaded(true);
+
+    if (load.children.empty()) {
+      continue;
+    }
+
+    Range range(this, *load.item);
+    range.set(0, static_cast<int>(load.children.size()));
+    range.add(std::move(load.children));
+
+    if (sorted) {
+      load.item->setSorted();
+    } else {
+      load.item->makeSortingStale();
+    }
   }
 }
 
-void FileTreeModel::ensureFullyLoaded()
+void FileTreeModel::collectUnloaded(
+  FileTreeItem& item, std::vector<PendingLoad>& out)
 {
-  if (!m_fullyLoaded) {
-    TimeThis tt("FileTreeModel:: fully loading for search");
-    recursiveFetchMore(QModelIndex());
-    sortItem(*m_root, false);
-    m_fullyLoaded = true;
+  if (!item.isLoaded()) {
+    if (item.children().empty()) {
+      DirectoryEntry* entry = m_core.directoryStructure();
+
+      if (&item != m_root.get()) {
+        entry = entry->findSubDirectoryRecursive(
+          item.dataRelativeFilePath().toStdWString());
+
+        if (!entry) {
+          log::error(
+            "FileTreeModel::loadAll(): directory '{}' not found",
+            item.dataRelativeFilePath());
+
+          return;
+        }
+      }
+
+      out.push_back({&item, entry, {}});
+      return;
+    }
+
+    // the item still has children that are queued for removal, see the top
+    // of this file; it's updated normally
+    doFetchMore(indexFromItem(item), false, false);
+  }
+
+  for (auto& child : item.children()) {
+    if (child->isDirectory()) {
+      collectUnloaded(*child, out);
+    }
   }
 }
 
+FileTreeItem::Children FileTreeModel::buildChildren(
+  FileTreeItem& parentItem, const DirectoryEntry& parentEntry,
+  const Filters& filters, int depth)
+{
+  FileTreeItem::Children children;
+  std::vector<std::pair<FileTreeItem*, const DirectoryEntry*>> dirs;
+
+  for (auto&& d : parentEntry.getSubDirectories()) {
+    if (!shouldShowFolder(*d, nullptr, filters)) {
+      continue;
+    }
+
+    auto item = createDirectoryItem(parentItem, *d);
+
+    if (!d->isEmpty()) {
+      dirs.push_back({item.get(), d});
+    }
+
+    children.push_back(std::move(item));
+  }
+
+  parentEntry.forEachFile([&](auto&& file) {
+    if (shouldShowFile(file, filters)) {
+      children.push_back(createFileItem(parentItem, file));
+    }
+
+    return true;
+  });
+
+  const bool sorted = FileTreeItem::canSortChildren(m_sort.column);
+
+  auto load = [&](FileTreeItem* item, const DirectoryEntry* d) {
+    for (auto&& c : buildChildren(*item, *d, filters, depth + 1)) {
+      item->add(std::move(c));
+    }
+
+    item->setLoaded(true);
+
+    if (sorted) {
+      item->setSorted();
+    }
+  };
+
+  if (depth < ParallelLoadDepth && dirs.size() > 1) {
+    TaskGroup tasks(TaskPriority::High);
+
+    for (auto&& [item, d] : dirs) {
+      tasks.run([&load, item=item, d=d] { load(item, d); });
+    }
+
+    tasks.wait();
+  } else {
+    for (auto&& [item, d] : dirs) {
+      load(item, d);
+    }
+  }
+
+  if (sorted) {
+    FileTreeItem::sortChildren(children, m_sort.column, m_sort.order);
+  }
+
+  return children;
+}
+
 bool FileTreeModel::enabled() const
 {
   return m_enabled;
@@ -258,6 +439,9 @@ void FileTreeModel::setEnabled(bool b)
 void FileTreeModel::aboutToExpandAll()
 {
   m_sortingEnabled = false;
+
+  // expanding would otherwise fetch every node on the ui thread
+  ensureFullyLoaded();
 }
 
 void FileTreeModel::expandedAll()
@@ -724,7 +908,7 @@ bool FileTreeModel::addNewDirectories(
       // this is a new directory
       trace(log::debug("new dir {}", QString::fromStdWString(d->getName())));
 
-      toAdd.push_back(createDirectoryItem(parentItem, parentPath, *d));
+      toAdd.push_back(createDirectoryItem(parentItem, *d));
       added = true;
 
       range.includeCurrent();
@@ -847,15 +1031,15 @@ bool FileTreeModel::addNewFiles(
 
       if (shouldShowFile(*file)) {
         // this is a new file
-        trace(log::debug("new file {}", QString::fromStdWString(file->getName())));
+        trace(log::debug("new file {}", ToQString(file->getName())));
 
-        toAdd.push_back(createFileItem(parentItem, parentPath, *file));
+        toAdd.push_back(createFileItem(parentItem, *file));
         added = true;
 
         range.includeCurrent();
       } else {
         // this is a new file, but it shouldn't be shown
-        trace(log::debug("new file {}, not shown", QString::fromStdWString(file->getName())));
+        trace(log::debug("new file {}, not shown", ToQString(file->getName())));
         return true;
       }
     }
@@ -925,11 +1109,9 @@ void FileTreeModel::sortItems()
 }
 
 FileTreeItem::Ptr FileTreeModel::createDirectoryItem(
-  FileTreeItem& parentItem, const std::wstring& parentPath,
-  const DirectoryEntry& d)
+  FileTreeItem& parentItem, const DirectoryEntry& d)
 {
-  auto item = FileTreeItem::createDirectory(
-    this, &parentItem, parentPath, d.getName());
+  auto item = FileTreeItem::createDirectory(this, &parentItem, d.getName());
 
   if (d.isEmpty()) {
     // if this directory is empty, mark the item as loaded so the expand
@@ -941,11 +1123,9 @@ FileTreeItem::Ptr FileTreeModel::createDirectoryItem(
 }
 
 FileTreeItem::Ptr FileTreeModel::createFileItem(
-  FileTreeItem& parentItem, const std::wstring& parentPath,
-  const FileEntry& file)
+  FileTreeItem& parentItem, const FileEntry& file)
 {
-  auto item = FileTreeItem::createFile(
-    this, &parentItem, parentPath, file.getName());
+  auto item = FileTreeItem::createFile(this, &parentItem, file.getName());
 
   updateFileItem(*item, file);
 
@@ -970,8 +1150,10 @@ void FileTreeModel::updateFileItem(
     flags |= FileTreeItem::Conflicted;
   }
 
+  auto strings = originStrings(file, originID);
+
   item.setOrigin(
-    originID, file.getFullPath(), flags, makeModName(file, originID));
+    originID, std::move(strings.path), flags, std::move(strings.mod));
 
   if (file.getFileSize() != FileEntry::NoFileSize) {
     item.setFileSize(file.getFileSize());
@@ -982,25 +1164,13 @@ void FileTreeModel::updateFileItem(
   }
 }
 
-bool FileTreeModel::shouldShowFile(const FileEntry& file) const
+FileTreeModel::Filters FileTreeModel::filters() const
 {
-  if (showConflictsOnly() && (file.getAlternatives().size() == 0)) {
-    // only conflicts should be shown, but this file is not conflicted
-    return false;
-  }
+  Filters f;
 
-  if (!showArchives() && file.isFromArchive()) {
-    // files from archives shouldn't be shown, but this file is from an archive
-    return false;
-  }
-
-  return true;
-}
-
-bool FileTreeModel::shouldShowFolder(
-  const DirectoryEntry& dir, const FileTreeItem* item) const
-{
-  bool shouldPrune = m_flags.testFlag(PruneDirectories);
+  f.conflictsOnly = showConflictsOnly();
+  f.archives = showArchives();
+  f.prune = m_flags.testFlag(PruneDirectories);
 
   if (m_core.settings().archiveParsing()) {
     if (!m_flags.testFlag(Archives)) {
@@ -1014,11 +1184,43 @@ bool FileTreeModel::shouldShowFolder(
       //
       // if directories are ever made first-class so they can retain their
       // origins, this test can be made more accurate
-      shouldPrune = true;
+      f.prune = true;
     }
   }
 
-  if (!shouldPrune) {
+  return f;
+}
+
+bool FileTreeModel::shouldShowFile(const FileEntry& file) const
+{
+  return shouldShowFile(file, filters());
+}
+
+bool FileTreeModel::shouldShowFolder(
+  const DirectoryEntry& dir, const FileTreeItem* item) const
+{
+  return shouldShowFolder(dir, item, filters());
+}
+
+bool FileTreeModel::shouldShowFile(const FileEntry& file, const Filters& f)
+{
+  if (f.conflictsOnly && (file.getAlternatives().size() == 0)) {
+    // only conflicts should be shown, but this file is not conflicted
+    return false;
+  }
+
+  if (!f.archives && file.isFromArchive()) {
+    // files from archives shouldn't be shown, but this file is from an archive
+    return false;
+  }
+
+  return true;
+}
+
+bool FileTreeModel::shouldShowFolder(
+  const DirectoryEntry& dir, const FileTreeItem* item, const Filters& f)
+{
+  if (!f.prune) {
     // always show folders regardless of their content
     return true;
   }
@@ -1033,8 +1235,8 @@ bool FileTreeModel::shouldShowFolder(
   bool foundFile = false;
 
   // check all files in this directory, return early if a file should be shown
-  dir.forEachFile([&](auto&& f) {
-    if (shouldShowFile(f)) {
+  dir.forEachFile([&](auto&& file) {
+    if (shouldShowFile(file, f)) {
       foundFile = true;
 
       // stop
@@ -1051,7 +1253,7 @@ bool FileTreeModel::shouldShowFolder(
 
   // recurse into subdirectories
   for (auto subdir : dir.getSubDirectories()) {
-    if (shouldShowFolder(*subdir, nullptr)) {
+    if (shouldShowFolder(*subdir, nullptr, f)) {
       return true;
     }
   }
@@ -1136,6 +1338,28 @@ std::wstring FileTreeModel::makeModName(
   return name;
 }
 
+FileTreeModel::OriginStrings FileTreeModel::originStrings(
+  const MOShared::FileEntry& file, int originID) const
+{
+  std::pair<int, std::wstring> key(originID, file.getArchive().name());
+
+  std::scoped_lock lock(m_originStringsMutex);
+
+  auto itor = m_originStrings.find(key);
+
+  if (itor == m_originStrings.end()) {
+    const auto& origin = m_core.directoryStructure()->getOriginByID(originID);
+
+    OriginStrings s;
+    s.path = QString::fromStdWString(origin.getPath());
+    s.mod = QString::fromStdWString(makeModName(file, originID));
+
+    itor = m_originStrings.emplace(std::move(key), std::move(s)).first;
+  }
+
+  return itor->second;
+}
+
 QString FileTreeModel::makeTooltip(const FileTreeItem& item) const
 {
   auto nowrap = [&](auto&& s) {
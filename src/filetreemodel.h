@@ -3,7 +3,10 @@
 
 #include "filetreeitem.h"
 #include "iconfetcher.h"
+#include "memoryaccounting.h"
 #include "shared/fileregisterfwd.h"
+#include <map>
+#include <mutex>
 #include <unordered_set>
 
 class OrganizerCore;
@@ -86,6 +89,33 @@ public:
 private:
   class Range;
 
+  // what the tree shows, retrieved on the ui thread so the threads that load
+  // the tree don't need the settings
+  //
+  struct Filters
+  {
+    bool conflictsOnly = false;
+    bool archives = false;
+    bool prune = false;
+  };
+
+  // the path and display name of an origin, shared by all its items
+  //
+  struct OriginStrings
+  {
+    QString path;
+    QString mod;
+  };
+
+  // the children of an unloaded item, built by loadAll()
+  //
+  struct PendingLoad
+  {
+    FileTreeItem* item = nullptr;
+    const MOShared::DirectoryEntry* entry = nullptr;
+    FileTreeItem::Children children;
+  };
+
   using DirectoryIterator = std::vector<MOShared::DirectoryEntry*>::const_iterator;
 
   OrganizerCore& m_core;
@@ -99,12 +129,24 @@ private:
   bool m_fullyLoaded;
   bool m_sortingEnabled;
 
+  // by origin id and archive name, cleared when the structure is refreshed
+  // because ids are not stable across refreshes
+  mutable std::map<std::pair<int, std::wstring>, OriginStrings> m_originStrings;
+  mutable std::mutex m_originStringsMutex;
+
   // see top of filetreemodel.cpp
   std::vector<FileTreeItem*> m_removeItems;
   std::vector<FileTreeItem*> m_sortItems;
   QTimer m_removeTimer;
   QTimer m_sortTimer;
 
+  MemoryAccounting::Source m_itemsMemory;
+  MemoryAccounting::Source m_iconsMemory;
+
+
+  // estimated memory used by the items and the origin strings
+  //
+  MOShared::MemoryUsage itemsMemory() const;
 
   bool showConflictsOnly() const
   {
@@ -121,6 +163,24 @@ private:
 
   void doFetchMore(const QModelIndex& parent, bool forFetch, bool doSort);
 
+  // loads all the items that are not loaded yet; their children are built
+  // and sorted in parallel, then added to the model with one insertion per
+  // item
+  //
+  void loadAll();
+
+  // walks the loaded items and collects the unloaded ones, see loadAll()
+  //
+  void collectUnloaded(FileTreeItem& item, std::vector<PendingLoad>& out);
+
+  // creates the items for the given directory and all its subdirectories
+  // without touching the model, can be called from any thread as long as the
+  // structure doesn't change
+  //
+  FileTreeItem::Children buildChildren(
+    FileTreeItem& parentItem, const MOShared::DirectoryEntry& parentEntry,
+    const Filters& filters, int depth);
+
   void queueRemoveItem(FileTreeItem* item);
   void removeItems();
 
@@ -159,12 +219,10 @@ private:
 
 
   FileTreeItem::Ptr createDirectoryItem(
-    FileTreeItem& parentItem, const std::wstring& parentPath,
-    const MOShared::DirectoryEntry& d);
+    FileTreeItem& parentItem, const MOShared::DirectoryEntry& d);
 
   FileTreeItem::Ptr createFileItem(
-    FileTreeItem& parentItem, const std::wstring& parentPath,
-    const MOShared::FileEntry& file);
+    FileTreeItem& parentItem, const MOShared::FileEntry& file);
 
   void updateFileItem(FileTreeItem& item, const MOShared::FileEntry& file);
 
@@ -172,17 +230,32 @@ private:
   QVariant displayData(const FileTreeItem* item, int column) const;
   std::wstring makeModName(const MOShared::FileEntry& file, int originID) const;
 
+  // returns the strings for the given origin and the archive of the file,
+  // which are created once and then shared by all the items; can be called
+  // from any thread
+  //
+  OriginStrings originStrings(
+    const MOShared::FileEntry& file, int originID) const;
+
   void ensureLoaded(FileTreeItem* item) const;
   void updatePendingIcons();
   void removePendingIcons(const QModelIndex& parent, int first, int last);
 
+  Filters filters() const;
+
   bool shouldShowFile(const MOShared::FileEntry& file) const;
   bool shouldShowFolder(const MOShared::DirectoryEntry& dir, const FileTreeItem* item) const;
+
+  static bool shouldShowFile(
+    const MOShared::FileEntry& file, const Filters& filters);
+
+  static bool shouldShowFolder(
+    const MOShared::DirectoryEntry& dir, const FileTreeItem* item,
+    const Filters& filters);
   QString makeTooltip(const FileTreeItem& item) const;
   QVariant makeIcon(const FileTreeItem& item, const QModelIndex& index) const;
 
   QModelIndex indexFromItem(FileTreeItem& item, int col=0) const;
-  void recursiveFetchMore(const QModelIndex& m);
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(FileTreeModel::Flags);
@@ -319,21 +319,22 @@ void FilterList::refresh()
 
   addContentCriteria();
 
+  // categories of all the mods, mods usually share a handful of them so each
+  // distinct set is only expanded once; parents are also added so they show
+  // up in the tree
   std::set<int> categoriesUsed;
+  std::set<std::set<int>> seen;
+
   for (unsigned int modIdx = 0; modIdx < ModInfo::getNumMods(); ++modIdx) {
     ModInfo::Ptr modInfo = ModInfo::getByIndex(modIdx);
-    for (int categoryID : modInfo->getCategories()) {
-      int currentID = categoryID;
-      std::set<int> cycleTest;
-      // also add parents so they show up in the tree
-      while (currentID != 0) {
-        categoriesUsed.insert(currentID);
-        if (!cycleTest.insert(currentID).second) {
-          log::warn("cycle in categories: {}", SetJoin(cycleTest, ", "));
-          break;
-        }
-        currentID = m_factory.getParentID(m_factory.getCategoryIndex(currentID));
-      }
+    const auto& categories = modInfo->getCategories();
+
+    if (categories.empty() || !seen.insert(categories).second) {
+      continue;
+    }
+
+    for (int id : m_factory.withParents(categories)) {
+      categoriesUsed.insert(id);
     }
   }
 
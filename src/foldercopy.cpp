@@ -0,0 +1,155 @@
+#include "foldercopy.h"
+#include "taskexecutor.h"
+#include <log.h>
+#include <utility.h>
+#include <QDir>
+#include <QDirIterator>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <windows.h>
+
+using namespace MOBase;
+
+// files copied at the same time
+static constexpr std::size_t MaxConcurrentCopies = 4;
+
+// files at least this large are copied without buffering
+static constexpr std::uint64_t UnbufferedSize = 16 * 1024 * 1024;
+
+
+QString FolderCopy::copy(
+  const QString& from, const QString& to, const std::atomic<bool>& cancel,
+  const ProgressF& progress)
+{
+  struct File
+  {
+    std::wstring from, to;
+    std::uint64_t size;
+  };
+
+  const QDir source(from);
+  const QDir dest(to);
+
+  if (!dest.mkpath(".")) {
+    return QObject::tr("Failed to create %1").arg(to);
+  }
+
+  // the directories are created here so the copies don't race to create
+  // them, and the total is known before anything is copied
+  std::vector<File> files;
+  std::uint64_t total = 0;
+
+  QDirIterator itor(
+    source.absolutePath(),
+    QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+    QDirIterator::Subdirectories);
+
+  while (itor.hasNext()) {
+    if (cancel) {
+      return {};
+    }
+
+    itor.next();
+
+    const QString relative = source.relativeFilePath(itor.filePath());
+    const auto fi = itor.fileInfo();
+
+    if (fi.isDir()) {
+      if (!dest.mkpath(relative)) {
+        return QObject::tr("Failed to create %1").arg(dest.filePath(relative));
+      }
+    } else {
+      const auto size = static_cast<std::uint64_t>(fi.size());
+
+      files.push_back({
+        QDir::toNativeSeparators(itor.filePath()).toStdWString(),
+        QDir::toNativeSeparators(dest.filePath(relative)).toStdWString(),
+        size});
+
+      total += size;
+    }
+  }
+
+  // the largest files first, so a large file found last doesn't end up
+  // copied alone
+  std::sort(files.begin(), files.end(), [](auto&& a, auto&& b) {
+    return a.size > b.size;
+  });
+
+  std::atomic<std::size_t> next = 0;
+  std::atomic<std::uint64_t> done = 0;
+
+  std::mutex errorMutex;
+  QString error;
+
+  auto failed = [&] {
+    std::scoped_lock lock(errorMutex);
+    return !error.isEmpty();
+  };
+
+  auto work = [&] {
+    for (;;) {
+      const std::size_t i = next++;
+
+      if (i >= files.size() || cancel || failed()) {
+        break;
+      }
+
+      const auto& f = files[i];
+
+      COPYFILE2_EXTENDED_PARAMETERS params = {};
+      params.dwSize = sizeof(params);
+      params.dwCopyFlags = (f.size >= UnbufferedSize ? COPY_FILE_NO_BUFFERING : 0);
+
+      const HRESULT r = ::CopyFile2(f.from.c_str(), f.to.c_str(), &params);
+
+      if (FAILED(r)) {
+        std::scoped_lock lock(errorMutex);
+
+        if (error.isEmpty()) {
+          error = QObject::tr("Failed to copy %1 to %2: %3")
+            .arg(QString::fromStdWString(f.from))
+            .arg(QString::fromStdWString(f.to))
+            .arg(QString::fromStdWString(formatSystemMessage(r)));
+        }
+
+        break;
+      }
+
+      const auto d = (done += f.size);
+
+      if (progress) {
+        progress(d, total);
+      }
+    }
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+
+  {
+    TaskGroup copies(TaskPriority::Normal);
+
+    const auto tasks = std::min({
+      MaxConcurrentCopies,
+      files.size(),
+      std::max<std::size_t>(TaskExecutor::instance().threadCount(), 1)});
+
+    for (std::size_t i=0; i<tasks; ++i) {
+      copies.run(work);
+    }
+
+    copies.wait();
+  }
+
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - start).count();
+
+  log::debug(
+    "copied {} files, {} bytes, from '{}' to '{}' in {}ms{}",
+    files.size(), done.load(), from, to, ms,
+    (cancel ? ", cancelled" : ""));
+
+  return error;
+}
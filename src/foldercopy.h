@@ -0,0 +1,36 @@
+#ifndef MODORGANIZER_FOLDERCOPY_INCLUDED
+#define MODORGANIZER_FOLDERCOPY_INCLUDED
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+// copies a folder and everything in it, used for folders dropped on the mod
+// list
+//
+// the directories are created first, then the files are copied by a few tasks
+// on the task executor; files are large and usually come from another drive,
+// so only a few are copied at the same time, and the large ones are copied
+// without buffering, which makes the system use large reads and writes and
+// keeps them out of the file cache
+//
+class FolderCopy
+{
+public:
+  // called with the number of bytes copied so far and the total
+  using ProgressF = std::function<void (std::uint64_t done, std::uint64_t total)>;
+
+  // copies the contents of `from` into `to`, which is created if needed;
+  // blocks until it's done or `cancel` is set, files that were copied before
+  // cancelling are left in `to`
+  //
+  // `progress` is called from the executor threads; returns an error message,
+  // empty on success or when cancelled
+  //
+  static QString copy(
+    const QString& from, const QString& to, const std::atomic<bool>& cancel,
+    const ProgressF& progress={});
+};
+
+#endif // MODORGANIZER_FOLDERCOPY_INCLUDED
@@ -0,0 +1,164 @@
+#include "gamedetection.h"
+#include "plugincontainer.h"
+#include "taskexecutor.h"
+#include <iplugingame.h>
+#include <log.h>
+#include <QCoreApplication>
+#include <QPointer>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+
+using namespace MOBase;
+using namespace MOShared;
+
+struct GameDetection::Data
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  // by game name; an entry without a result is being detected
+  std::map<QString, std::optional<Result>> results;
+};
+
+
+GameDetection::Data& GameDetection::data()
+{
+  static Data d;
+  return d;
+}
+
+void GameDetection::detect(
+  const std::vector<IPluginGame*>& games, const PluginContainer& pc,
+  QObject* context, DetectedF f)
+{
+  auto shared = std::make_shared<DetectedF>(std::move(f));
+  QPointer<QObject> ctx(context);
+
+  // posts the result to the ui thread, unless the context is gone
+  auto post = [shared, ctx](IPluginGame* game, Result r) {
+    QMetaObject::invokeMethod(qApp, [shared, ctx, game, r=std::move(r)] {
+      if (ctx) {
+        (*shared)(game, r);
+      }
+    }, Qt::QueuedConnection);
+  };
+
+  for (auto* game : games) {
+    {
+      auto& d = data();
+      std::scoped_lock lock(d.mutex);
+
+      auto itor = d.results.find(game->gameName());
+      if (itor != d.results.end() && itor->second) {
+        (*shared)(game, *itor->second);
+        continue;
+      }
+    }
+
+    if (proxied(game, pc)) {
+      // one per pass of the event loop, so the ui stays responsive while
+      // they're detected
+      QMetaObject::invokeMethod(qApp, [game, post] {
+        post(game, detectNow(game));
+      }, Qt::QueuedConnection);
+    } else {
+      TaskExecutor::instance().post(TaskPriority::High, [game, post] {
+        post(game, detectNow(game));
+      });
+    }
+  }
+}
+
+GameDetection::Result GameDetection::detectNow(IPluginGame* game)
+{
+  auto& d = data();
+  const QString name = game->gameName();
+
+  {
+    std::unique_lock lock(d.mutex);
+
+    auto itor = d.results.find(name);
+
+    if (itor != d.results.end()) {
+      // done, or being detected by another thread
+      d.cv.wait(lock, [&]{ return itor->second.has_value(); });
+      return *itor->second;
+    }
+
+    d.results.emplace(name, std::nullopt);
+  }
+
+  const Result r = run(game);
+
+  {
+    std::scoped_lock lock(d.mutex);
+    d.results[name] = r;
+  }
+
+  d.cv.notify_all();
+
+  return r;
+}
+
+IPluginGame* GameDetection::findForDirectory(
+  const QString& dir, const std::vector<IPluginGame*>& games,
+  const PluginContainer& pc)
+{
+  // one flag per game, written by a single task each
+  std::vector<char> valid(games.size(), 0);
+
+  {
+    TaskGroup group(TaskPriority::High);
+
+    for (std::size_t i=0; i<games.size(); ++i) {
+      if (!proxied(games[i], pc)) {
+        group.run([&, i] { valid[i] = games[i]->looksValid(dir); });
+      }
+    }
+
+    // proxied plugins are asked here while the others run
+    for (std::size_t i=0; i<games.size(); ++i) {
+      if (proxied(games[i], pc)) {
+        valid[i] = games[i]->looksValid(dir);
+      }
+    }
+
+    group.wait();
+  }
+
+  for (std::size_t i=0; i<games.size(); ++i) {
+    if (valid[i]) {
+      return games[i];
+    }
+  }
+
+  return nullptr;
+}
+
+GameDetection::Result GameDetection::run(IPluginGame* game)
+{
+  Result r;
+
+  try
+  {
+    r.installed = game->isInstalled();
+
+    if (r.installed) {
+      r.directory = game->gameDirectory().path();
+    }
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to detect {}: {}", game->gameName(), e.what());
+    r = {};
+  }
+
+  return r;
+}
+
+bool GameDetection::proxied(IPluginGame* game, const PluginContainer& pc)
+{
+  return (pc.requirements(game).proxy() != nullptr);
+}
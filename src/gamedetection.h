@@ -0,0 +1,68 @@
+#ifndef MODORGANIZER_GAMEDETECTION_INCLUDED
+#define MODORGANIZER_GAMEDETECTION_INCLUDED
+
+#include <QObject>
+#include <QString>
+#include <functional>
+#include <vector>
+
+namespace MOBase { class IPluginGame; }
+class PluginContainer;
+
+// asks the game plugins whether they can find their game, or whether they
+// recognize a directory, concurrently
+//
+// many game plugins look in the registry and in the libraries of the various
+// stores, which can take a while for each of them; plugins are asked on the
+// task executor, except for the ones created by a proxy, like python
+// plugins, which are asked on the ui thread one at a time since the proxy
+// may not be safe to call from other threads
+//
+// detected installations are cached for the lifetime of the process, keyed
+// by game name, and a plugin is never asked twice at the same time
+//
+class GameDetection
+{
+public:
+  struct Result
+  {
+    // whether the plugin found an installation
+    bool installed = false;
+
+    // the installation directory, empty if not installed
+    QString directory;
+  };
+
+  using DetectedF = std::function<void (MOBase::IPluginGame*, const Result&)>;
+
+  // detects all the given games; `f` is called on the ui thread for each
+  // game as it comes in, in no particular order, and right away for games
+  // that were already detected
+  //
+  // results arriving after `context` was destroyed are dropped
+  //
+  static void detect(
+    const std::vector<MOBase::IPluginGame*>& games, const PluginContainer& pc,
+    QObject* context, DetectedF f);
+
+  // detects the given game on the calling thread, or waits for it if it's
+  // being detected; returns the cached result if it's already known
+  //
+  static Result detectNow(MOBase::IPluginGame* game);
+
+  // the first of the given games, in order, that recognizes the directory;
+  // all of them are asked concurrently, null if none do
+  //
+  static MOBase::IPluginGame* findForDirectory(
+    const QString& dir, const std::vector<MOBase::IPluginGame*>& games,
+    const PluginContainer& pc);
+
+private:
+  struct Data;
+  static Data& data();
+
+  static Result run(MOBase::IPluginGame* game);
+  static bool proxied(MOBase::IPluginGame* game, const PluginContainer& pc);
+};
+
+#endif // MODORGANIZER_GAMEDETECTION_INCLUDED
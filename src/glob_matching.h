@@ -7,8 +7,11 @@
 #define GLOB_MATCHING_H
 
 #include <cctype>
+#include <cwctype>
 #include <string_view>
+#include <vector>
 #include <QString>
+#include <QStringList>
 
 namespace MOShared {
 
@@ -31,6 +34,25 @@ namespace MOShared {
       static auto empty(string_view const& view) { return view.empty(); }
     };
 
+    // std::tolower() is only defined for values of unsigned char; ascii is
+    // folded inline, which is what file names mostly are
+    template <>
+    struct string_traits<wchar_t> {
+      using string_type = std::wstring;
+      using string_view = std::wstring_view;
+
+      static wchar_t tolower(wchar_t c)
+      {
+        if (c < 128) {
+          return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c + (L'a' - L'A')) : c;
+        }
+
+        return static_cast<wchar_t>(std::towlower(c));
+      }
+
+      static auto empty(string_view const& view) { return view.empty(); }
+    };
+
     template <>
     struct string_traits<QChar> {
       using string_type = QString;
@@ -198,6 +220,115 @@ namespace MOShared {
       string_type v;
   };
 
+  /**
+   * @brief Matches names against a list of glob patterns, case-insensitive.
+   *
+   * Patterns are compiled once: '*' matches everything, patterns such as
+   * "*.esp" only compare the extension of the name and the others go through
+   * GlobPattern. This is meant to be built once per call of something like
+   * findFiles() and used on the names stored in the directory structure.
+   */
+  class GlobMatcher {
+    public:
+
+      GlobMatcher(const QStringList& patterns)
+        : m_all(false)
+      {
+        for (auto&& p : patterns) {
+          add(p.toStdWString());
+        }
+      }
+
+      bool empty() const
+      {
+        return !m_all && m_extensions.empty() && m_patterns.empty();
+      }
+
+      bool match(std::wstring_view name)
+      {
+        if (m_all) {
+          return true;
+        }
+
+        if (!m_extensions.empty()) {
+          const auto dot = name.rfind(L'.');
+
+          if (dot != std::wstring_view::npos) {
+            const auto ext = name.substr(dot + 1);
+
+            for (auto&& e : m_extensions) {
+              if (equals(ext, e)) {
+                return true;
+              }
+            }
+          }
+        }
+
+        for (auto& p : m_patterns) {
+          if (p.match(name)) {
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+    private:
+      using traits = details::string_traits<wchar_t>;
+
+      // whether one of the patterns is "*"
+      bool m_all;
+
+      // lowercase extensions of the "*.ext" patterns
+      std::vector<std::wstring> m_extensions;
+
+      // everything else
+      std::vector<GlobPattern<wchar_t>> m_patterns;
+
+      void add(std::wstring p)
+      {
+        if (p == L"*") {
+          m_all = true;
+          return;
+        }
+
+        if (p.size() > 2 && p[0] == L'*' && p[1] == L'.') {
+          const auto ext = std::wstring_view(p).substr(2);
+
+          if (ext.find_first_of(L"*?[].") == std::wstring_view::npos) {
+            std::wstring lc;
+            lc.reserve(ext.size());
+
+            for (auto c : ext) {
+              lc.push_back(traits::tolower(c));
+            }
+
+            m_extensions.push_back(std::move(lc));
+            return;
+          }
+        }
+
+        m_patterns.emplace_back(p);
+      }
+
+      // `lc` is lowercase
+      static bool equals(std::wstring_view s, std::wstring_view lc)
+      {
+        if (s.size() != lc.size()) {
+          return false;
+        }
+
+        for (std::size_t i=0; i<s.size(); ++i) {
+          if (traits::tolower(s[i]) != lc[i]) {
+            return false;
+          }
+        }
+
+        return true;
+      }
+  };
+
+
   template <class CharT, class Traits, class Allocator>
   GlobPattern(std::basic_string<CharT, Traits, Allocator> const&)
     -> GlobPattern<CharT, Traits, Allocator>;
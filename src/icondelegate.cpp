@@ -43,15 +43,52 @@ void IconDelegate::paintIcons(
   QPainter *painter, const QStyleOptionViewItem &option,
   const QModelIndex &index, const QList<QString>& icons)
 {
-  int x = 4;
-  painter->save();
+  if (icons.isEmpty() || option.rect.height() <= 0) {
+    return;
+  }
 
-  int iconWidth = icons.size() > 0 ? ((option.rect.width() / icons.size()) - 4) : 16;
+  int iconWidth = (option.rect.width() / icons.size()) - 4;
   iconWidth = std::min(16, iconWidth);
 
-  const int margin = (option.rect.height() - iconWidth) / 2;
+  if (iconWidth <= 0) {
+    return;
+  }
+
+  const qreal dpr = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+
+  // rows share a handful of icon combinations, so the whole strip is cached
+  // and painting a row is a single blit
+  QString key = QString("iconstrip_%1_%2_%3_")
+    .arg(iconWidth).arg(option.rect.height()).arg(dpr);
+
+  for (const QString& iconId : icons) {
+    key += iconId;
+    key += '|';
+  }
+
+  QPixmap strip;
+  if (!QPixmapCache::find(key, &strip)) {
+    strip = createStrip(icons, iconWidth, option.rect.height(), dpr);
+    QPixmapCache::insert(key, strip);
+  }
+
+  painter->drawPixmap(option.rect.topLeft(), strip);
+}
+
+QPixmap IconDelegate::createStrip(
+  const QList<QString>& icons, int iconWidth, int height, qreal dpr)
+{
+  const int width = 4 + icons.size() * (iconWidth + 4);
+
+  QPixmap strip(QSize(width, height) * dpr);
+  strip.setDevicePixelRatio(dpr);
+  strip.fill(Qt::transparent);
+
+  QPainter painter(&strip);
+
+  const int margin = (height - iconWidth) / 2;
+  int x = 4;
 
-  painter->translate(option.rect.topLeft());
   for (const QString &iconId : icons) {
     if (iconId.isEmpty()) {
       x += iconWidth + 4;
@@ -66,11 +103,11 @@ void IconDelegate::paintIcons(
       }
       QPixmapCache::insert(fullIconId, icon);
     }
-    painter->drawPixmap(x, margin, iconWidth, iconWidth, icon);
+    painter.drawPixmap(x, margin, iconWidth, iconWidth, icon);
     x += iconWidth + 4;
   }
 
-  painter->restore();
+  return strip;
 }
 
 void IconDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
@@ -1,6 +1,44 @@
 #include "iconfetcher.h"
+#include "settings.h"
 #include "thread_utils.h"
 #include "shared/util.h"
+#include <log.h>
+#include <safewritefile.h>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+
+using namespace MOBase;
+
+// "MOIC" and the format version, the cache is ignored when either doesn't
+// match
+static const quint32 CacheMagic = 0x4d4f4943;
+static const quint32 CacheVersion = 1;
+
+static const QString CacheFileName = "icons.cache";
+
+// the shell can be slow for some files, but there's no point in having more
+// threads than this for a list of icons
+static const unsigned int MaxThreads = 4;
+
+
+static QString cachePath(const QString& filename)
+{
+  return Settings::instance().paths().cache() + "/" + filename;
+}
+
+// last modification time of the given file, in ms since epoch, or -1
+//
+static qint64 fileTime(const QString& path)
+{
+  const auto d = QFileInfo(path).lastModified();
+  if (!d.isValid()) {
+    return -1;
+  }
+
+  return d.toMSecsSinceEpoch();
+}
+
 
 void IconFetcher::Waiter::wait()
 {
@@ -21,23 +59,45 @@ void IconFetcher::Waiter::wakeUp()
 
 
 IconFetcher::IconFetcher()
-  : m_iconSize(GetSystemMetrics(SM_CXSMICON)), m_stop(false)
+  : IconFetcher(CacheFileName, GetSystemMetrics(SM_CXSMICON), MaxThreads)
 {
-  m_quickCache.file = getPixmapIcon(QFileIconProvider::File);
-  m_quickCache.directory = getPixmapIcon(QFileIconProvider::Folder);
+}
 
-  m_thread = MOShared::startSafeThread([&]{ threadFun(); });
+IconFetcher::IconFetcher(
+  QString cacheFileName, int iconSize, unsigned int maxThreads) :
+    m_cacheFileName(std::move(cacheFileName)), m_iconSize(iconSize),
+    m_stop(false), m_changed(false)
+{
+  m_quickCache.file = getPixmapIcon(m_provider, QFileIconProvider::File);
+  m_quickCache.directory = getPixmapIcon(m_provider, QFileIconProvider::Folder);
+
+  loadCache();
+
+  const auto count = std::clamp(
+    std::thread::hardware_concurrency() / 2, 1u, std::max(maxThreads, 1u));
+
+  for (std::size_t i=0; i<count; ++i) {
+    m_threads.push_back(MOShared::startSafeThread([this, i]{ threadFun(i); }));
+  }
 }
 
 IconFetcher::~IconFetcher()
 {
   stop();
-  m_thread.join();
+
+  for (auto& t : m_threads) {
+    t.join();
+  }
+
+  saveCache();
 }
 
 void IconFetcher::stop()
 {
   m_stop = true;
+
+  // each wake up only releases one thread, they wake up the next one when
+  // they stop
   m_waiter.wakeUp();
 }
 
@@ -67,6 +127,37 @@ QPixmap IconFetcher::genericDirectoryIcon() const
   return m_quickCache.directory;
 }
 
+MOShared::MemoryUsage IconFetcher::memoryUsage() const
+{
+  MOShared::MemoryUsage u;
+
+  auto add = [&](const QString& key, const QPixmap& p) {
+    ++u.count;
+    u.bytes +=
+      (key.capacity() + 1) * sizeof(QChar) +
+      static_cast<std::size_t>(p.width()) * p.height() * p.depth() / 8;
+  };
+
+  for (auto* c : {&m_extensionCache, &m_fileCache}) {
+    std::scoped_lock lock(c->mapMutex);
+
+    u.bytes += MOShared::treeBytes(c->map);
+    for (auto&& [key, p] : c->map) {
+      add(key, p);
+    }
+  }
+
+  // guarded by the mutex of the file cache, like m_stored
+  std::scoped_lock lock(m_fileCache.mapMutex);
+
+  u.bytes += MOShared::treeBytes(m_stored) + MOShared::treeBytes(m_fileTimes);
+  for (auto&& [key, s] : m_stored) {
+    add(key, s.pixmap);
+  }
+
+  return u;
+}
+
 bool IconFetcher::hasOwnIcon(const QString& path) const
 {
   static const QString exe = ".exe";
@@ -79,9 +170,12 @@ bool IconFetcher::hasOwnIcon(const QString& path) const
     path.endsWith(ico, Qt::CaseInsensitive);
 }
 
-void IconFetcher::threadFun()
+void IconFetcher::threadFun(std::size_t i)
 {
-  MOShared::SetThisThreadName("IconFetcher");
+  MOShared::SetThisThreadName(QString("IconFetcher %1").arg(i));
+
+  // the provider has lazily created members that are not thread-safe
+  QFileIconProvider provider;
 
   while (!m_stop) {
     m_waiter.wait();
@@ -89,42 +183,92 @@ void IconFetcher::threadFun()
       break;
     }
 
-    checkCache(m_extensionCache);
-    checkCache(m_fileCache);
+    while (!m_stop) {
+      if (!fetchOne(provider, m_extensionCache, false) &&
+          !fetchOne(provider, m_fileCache, true)) {
+        break;
+      }
+    }
   }
+
+  // wakes up the next thread so it can stop too
+  m_waiter.wakeUp();
 }
 
-void IconFetcher::checkCache(Cache& cache)
+bool IconFetcher::fetchOne(
+  const QFileIconProvider& provider, Cache& cache, bool isFile)
 {
-  std::set<QString> queue;
+  QString key;
+  bool more = false;
 
   {
     std::scoped_lock lock(cache.queueMutex);
-    queue = std::move(cache.queue);
-    cache.queue.clear();
+
+    if (cache.queue.empty()) {
+      return false;
+    }
+
+    key = std::move(cache.queue.extract(cache.queue.begin()).value());
+    cache.running.insert(key);
+
+    more = !cache.queue.empty();
   }
 
-  if (queue.empty()) {
-    return;
+  if (more) {
+    // let another thread take the next one
+    m_waiter.wakeUp();
+  }
+
+  QPixmap pixmap;
+  qint64 time = 0;
+
+  if (isFile) {
+    time = fileTime(key);
+
+    std::scoped_lock lock(cache.mapMutex);
+
+    auto itor = m_stored.find(key);
+    if (itor != m_stored.end()) {
+      if (time >= 0 && itor->second.time == time) {
+        // file hasn't changed since the icon was stored
+        pixmap = itor->second.pixmap;
+      }
+
+      m_stored.erase(itor);
+    }
   }
 
-  std::map<QString, QPixmap> map;
-  for (auto&& ext : queue) {
-    map.emplace(std::move(ext), getPixmapIcon(ext));
+  if (pixmap.isNull()) {
+    pixmap = getPixmapIcon(provider, key);
+    m_changed = true;
   }
 
   {
     std::scoped_lock lock(cache.mapMutex);
-    for (auto&& p : map) {
-      cache.map.insert(std::move(p));
+    cache.map.insert_or_assign(key, std::move(pixmap));
+
+    if (isFile) {
+      m_fileTimes[key] = time;
     }
   }
+
+  {
+    std::scoped_lock lock(cache.queueMutex);
+    cache.running.erase(key);
+  }
+
+  return true;
 }
 
 void IconFetcher::queue(Cache& cache, QString path) const
 {
   {
     std::scoped_lock lock(cache.queueMutex);
+
+    if (cache.running.contains(path)) {
+      return;
+    }
+
     cache.queue.insert(std::move(path));
   }
 
@@ -133,16 +277,29 @@ void IconFetcher::queue(Cache& cache, QString path) const
 
 QVariant IconFetcher::fileIcon(const QString& path) const
 {
+  QPixmap stored;
+
   {
     std::scoped_lock lock(m_fileCache.mapMutex);
     auto itor = m_fileCache.map.find(path);
     if (itor != m_fileCache.map.end()) {
       return itor->second;
     }
+
+    // shown while the file is checked, it's replaced if it has changed
+    auto sitor = m_stored.find(path);
+    if (sitor != m_stored.end()) {
+      stored = sitor->second.pixmap;
+    }
   }
 
   queue(m_fileCache, path);
-  return {};
+
+  if (stored.isNull()) {
+    return {};
+  }
+
+  return stored;
 }
 
 QVariant IconFetcher::extensionIcon(const QStringRef& ext) const
@@ -158,3 +315,128 @@ QVariant IconFetcher::extensionIcon(const QStringRef& ext) const
   queue(m_extensionCache, ext.toString());
   return {};
 }
+
+void IconFetcher::loadCache()
+{
+  QFile file(cachePath(m_cacheFileName));
+  if (!file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_9);
+
+  quint32 magic = 0, version = 0;
+  qint32 iconSize = 0;
+  in >> magic >> version >> iconSize;
+
+  if (magic != CacheMagic || version != CacheVersion) {
+    log::debug("ignoring icon cache {}, wrong version", file.fileName());
+    return;
+  }
+
+  if (iconSize != m_iconSize) {
+    // the dpi has changed
+    log::debug("ignoring icon cache {}, wrong icon size", file.fileName());
+    return;
+  }
+
+  std::map<QString, QPixmap, std::less<>> extensions;
+  std::map<QString, StoredIcon, std::less<>> files;
+
+  quint32 count = 0;
+  in >> count;
+
+  for (quint32 i=0; i<count && in.status() == QDataStream::Ok; ++i) {
+    QString ext;
+    QImage image;
+    in >> ext >> image;
+
+    extensions.emplace(std::move(ext), QPixmap::fromImage(image));
+  }
+
+  count = 0;
+  in >> count;
+
+  for (quint32 i=0; i<count && in.status() == QDataStream::Ok; ++i) {
+    QString path;
+    StoredIcon icon;
+    QImage image;
+    in >> path >> icon.time >> image;
+
+    icon.pixmap = QPixmap::fromImage(image);
+    files.emplace(std::move(path), std::move(icon));
+  }
+
+  if (in.status() != QDataStream::Ok) {
+    log::warn("icon cache {} is corrupted, ignoring", file.fileName());
+    return;
+  }
+
+  m_extensionCache.map = std::move(extensions);
+  m_stored = std::move(files);
+
+  log::debug(
+    "loaded {} extension and {} file icons from cache",
+    m_extensionCache.map.size(), m_stored.size());
+}
+
+void IconFetcher::saveCache()
+{
+  if (!m_changed) {
+    return;
+  }
+
+  // the threads are stopped, the caches don't need to be locked
+  QByteArray content;
+
+  {
+    QDataStream out(&content, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_9);
+
+    out << CacheMagic << CacheVersion << static_cast<qint32>(m_iconSize);
+
+    out << static_cast<quint32>(m_extensionCache.map.size());
+    for (const auto& [ext, pixmap] : m_extensionCache.map) {
+      out << ext << pixmap.toImage();
+    }
+
+    // files that were not checked this time are kept as they were; files
+    // that couldn't be found are dropped
+    std::size_t count = m_stored.size();
+    for (const auto& [path, time] : m_fileTimes) {
+      if (time >= 0) {
+        ++count;
+      }
+    }
+
+    out << static_cast<quint32>(count);
+
+    for (const auto& [path, icon] : m_stored) {
+      out << path << icon.time << icon.pixmap.toImage();
+    }
+
+    for (const auto& [path, time] : m_fileTimes) {
+      if (time < 0) {
+        continue;
+      }
+
+      auto itor = m_fileCache.map.find(path);
+      const QPixmap pixmap = (itor != m_fileCache.map.end() ? itor->second : QPixmap());
+
+      out << path << time << pixmap.toImage();
+    }
+  }
+
+  try
+  {
+    SafeWriteFile file(cachePath(m_cacheFileName));
+    file->resize(0);
+    file->write(content);
+    file.commit();
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to write {}: {}", cachePath(m_cacheFileName), e.what());
+  }
+}
@@ -1,13 +1,34 @@
 #ifndef MODORGANIZER_ICONFETCHER_INCLUDED
 #define MODORGANIZER_ICONFETCHER_INCLUDED
 
+#include "shared/memoryusage.h"
 #include <QFileIconProvider>
 #include <mutex>
 
+// fetches file icons on a few threads; icons are cached by extension, except
+// for files that have their own icon, like executables, which are cached by
+// path
+//
+// the icons are saved in the cache directory when the fetcher is destroyed
+// and loaded on startup, so they're available right away on the next run;
+// icons of files are kept along with the last modification time of the file
+// and are fetched again when it changes
+//
+// icon() never touches the disk, so paths on a network share that can't be
+// reached only delay their own icon
+//
 class IconFetcher
 {
 public:
+  // small icons saved in "icons.cache"
+  //
   IconFetcher();
+
+  // icons of the given size saved in the given file of the cache directory,
+  // fetched on at most `maxThreads` threads
+  //
+  IconFetcher(QString cacheFileName, int iconSize, unsigned int maxThreads);
+
   ~IconFetcher();
 
   void stop();
@@ -16,6 +37,11 @@ public:
   QPixmap genericFileIcon() const;
   QPixmap genericDirectoryIcon() const;
 
+  // estimated memory used by the cached icons, the count is the number of
+  // icons
+  //
+  MOShared::MemoryUsage memoryUsage() const;
+
 private:
   struct QuickCache
   {
@@ -28,10 +54,20 @@ private:
     std::map<QString, QPixmap, std::less<>> map;
     std::mutex mapMutex;
 
+    // keys waiting for a fetcher and keys being fetched
     std::set<QString> queue;
+    std::set<QString> running;
     std::mutex queueMutex;
   };
 
+  // an icon of a file from the disk cache
+  struct StoredIcon
+  {
+    // last modification time of the file, in ms since epoch
+    qint64 time = 0;
+    QPixmap pixmap;
+  };
+
   class Waiter
   {
   public:
@@ -45,9 +81,10 @@ private:
   };
 
 
+  const QString m_cacheFileName;
   const int m_iconSize;
   QFileIconProvider m_provider;
-  std::thread m_thread;
+  std::vector<std::thread> m_threads;
   std::atomic<bool> m_stop;
 
   mutable QuickCache m_quickCache;
@@ -55,22 +92,40 @@ private:
   mutable Cache m_fileCache;
   mutable Waiter m_waiter;
 
+  // icons of files loaded from the disk cache by path, they're shown right
+  // away but are only moved into m_fileCache once a fetcher has checked the
+  // time of the file; guarded by m_fileCache.mapMutex, like m_fileTimes
+  mutable std::map<QString, StoredIcon, std::less<>> m_stored;
+
+  // times of the files in m_fileCache
+  std::map<QString, qint64> m_fileTimes;
+
+  // whether an icon was fetched since the disk cache was loaded
+  std::atomic<bool> m_changed;
+
 
   bool hasOwnIcon(const QString& path) const;
 
   template <class T>
-  QPixmap getPixmapIcon(T&& t) const
+  QPixmap getPixmapIcon(const QFileIconProvider& provider, T&& t) const
   {
-    return m_provider.icon(t).pixmap({m_iconSize, m_iconSize});
+    return provider.icon(t).pixmap({m_iconSize, m_iconSize});
   }
 
-  void threadFun();
+  void threadFun(std::size_t i);
+
+  // fetches one queued icon from the given cache, returns false if there was
+  // nothing queued
+  //
+  bool fetchOne(const QFileIconProvider& provider, Cache& cache, bool isFile);
 
-  void checkCache(Cache& cache);
   void queue(Cache& cache, QString path) const;
 
   QVariant fileIcon(const QString& path) const;
   QVariant extensionIcon(const QStringRef& ext) const;
+
+  void loadCache();
+  void saveCache();
 };
 
 #endif // MODORGANIZER_ICONFETCHER_INCLUDED
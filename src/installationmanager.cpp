@@ -17,9 +17,12 @@ You should have received a copy of the GNU General Public License
 along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <tuple>
 
 #include "installationmanager.h"
+#include "metrics.h"
+#include "pluginstats.h"
 
 #include "utility.h"
 #include "report.h"
@@ -63,6 +66,20 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 using namespace MOBase;
 using namespace MOShared;
 
+// archives are extracted with this many handles at most, and only if the
+// files to extract are at least this big, see extractArchive()
+static const int MaxExtractionThreads = 4;
+static const uint64_t ParallelExtractionMinSize = 64 * 1024 * 1024;
+
+// installer assets are not prefetched if they're bigger than this in total,
+// see startPrefetch()
+static const uint64_t MaxPrefetchSize = 128 * 1024 * 1024;
+
+// images installers typically show next to their options
+static const QStringList PrefetchImageSuffixes = {
+  "png", "jpg", "jpeg", "bmp", "gif", "webp"
+};
+
 
 InstallationResult::InstallationResult(IPluginInstaller::EInstallResult result) :
   m_result(result), m_name(), m_iniTweaks(false), m_backup(false), m_merged(false), m_replaced(false)
@@ -86,7 +103,8 @@ static T resolveFunction(QLibrary &lib, const char *name)
 InstallationManager::InstallationManager()
     :
       m_ParentWidget(nullptr),
-      m_IsRunning(false) {
+      m_IsRunning(false),
+      m_ExtractError(Archive::Error::ERROR_NONE) {
   m_ArchiveHandler = CreateArchive();
   if (!m_ArchiveHandler->isValid()) {
     throw MyException(getErrorString(m_ArchiveHandler->getLastError()));
@@ -137,12 +155,14 @@ void InstallationManager::queryPassword() {
 
 bool InstallationManager::extractFiles(QString extractPath, QString title, bool showFilenames, bool silent)
 {
-  TimeThis tt("InstallationManager::extractFiles");
+  Metrics::Timer tt("InstallationManager::extractFiles");
 
   // Callback for errors:
   QString errorMessage;
-  auto errorCallback = [&errorMessage, this](std::wstring const& message) {
-    m_ArchiveHandler->cancel();
+  std::mutex errorMutex;
+  auto errorCallback = [&errorMessage, &errorMutex, this](std::wstring const& message) {
+    cancelExtraction();
+    std::scoped_lock guard(errorMutex);
     errorMessage = QString::fromStdWString(message);
   };
 
@@ -151,8 +171,8 @@ bool InstallationManager::extractFiles(QString extractPath, QString title, bool
 
   if (silent) {
     future = QtConcurrent::run([&]() -> bool {
-      return m_ArchiveHandler->extract(
-        extractPath.toStdWString(),
+      return extractArchive(
+        extractPath,
         nullptr,
         nullptr,
         errorCallback
@@ -190,7 +210,7 @@ bool InstallationManager::extractFiles(QString extractPath, QString title, bool
     connect(this, &InstallationManager::progressUpdate, &loop, &QEventLoop::wakeUp, Qt::QueuedConnection);
 
     // Cancelling progress only cancel the extraction, we do not force exiting the event-loop:
-    connect(installationProgress, &QProgressDialog::canceled, [this]() { m_ArchiveHandler->cancel(); });
+    connect(installationProgress, &QProgressDialog::canceled, [this]() { cancelExtraction(); });
 
     std::mutex mutex;
     int currentProgress = 0;
@@ -222,8 +242,8 @@ bool InstallationManager::extractFiles(QString extractPath, QString title, bool
       &loop, &QEventLoop::wakeUp,
       Qt::QueuedConnection);
     futureWatcher.setFuture(QtConcurrent::run([&]() -> bool {
-      return m_ArchiveHandler->extract(
-        extractPath.toStdWString(),
+      return extractArchive(
+        extractPath,
         progressCallback,
         showFilenames ? fileChangeCallback : nullptr,
         errorCallback
@@ -251,7 +271,7 @@ bool InstallationManager::extractFiles(QString extractPath, QString title, bool
 
   // Check the result:
   if (!future.result()) {
-    if (m_ArchiveHandler->getLastError() == Archive::Error::ERROR_EXTRACT_CANCELLED) {
+    if (m_ExtractError == Archive::Error::ERROR_EXTRACT_CANCELLED) {
       if (!errorMessage.isEmpty()) {
         throw MyException(tr("Extraction failed: %1").arg(errorMessage));
       }
@@ -260,13 +280,307 @@ bool InstallationManager::extractFiles(QString extractPath, QString title, bool
       }
     }
     else {
-      throw MyException(tr("Extraction failed: %1").arg(static_cast<int>(m_ArchiveHandler->getLastError())));
+      throw MyException(tr("Extraction failed: %1").arg(static_cast<int>(m_ExtractError)));
     }
   }
 
   return true;
 }
 
+bool InstallationManager::extractArchive(
+  const QString& extractPath, Archive::ProgressCallback progress,
+  Archive::FileChangeCallback fileChange, Archive::ErrorCallback error)
+{
+  m_ExtractError = Archive::Error::ERROR_NONE;
+
+  auto extractSerial = [&] {
+    if (m_ArchiveHandler->extract(extractPath.toStdWString(), progress, fileChange, error)) {
+      return true;
+    }
+
+    m_ExtractError = m_ArchiveHandler->getLastError();
+    return false;
+  };
+
+  // in zip files, every entry is compressed on its own so different handles
+  // can extract different files without decoding anything twice; solid 7z or
+  // rar blocks would have to be decoded by every handle
+  if (QFileInfo(m_ArchivePath).suffix().compare("zip", Qt::CaseInsensitive) != 0) {
+    return extractSerial();
+  }
+
+  const auto& files = m_ArchiveHandler->getFileList();
+
+  std::vector<std::size_t> mapped;
+  uint64_t totalSize = 0;
+
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    if (!files[i]->isDirectory() && !files[i]->getOutputFilePaths().empty()) {
+      mapped.push_back(i);
+      totalSize += files[i]->getSize();
+    }
+  }
+
+  const int threads = std::min(QThread::idealThreadCount(), MaxExtractionThreads);
+  if (threads < 2 || totalSize < ParallelExtractionMinSize
+      || mapped.size() < static_cast<std::size_t>(threads) * 2) {
+    return extractSerial();
+  }
+
+  std::vector<std::unique_ptr<Archive>> handles;
+  for (int i = 1; i < threads; ++i) {
+    auto a = CreateArchive();
+
+    const bool opened = a->isValid() && a->open(
+      m_ArchivePath.toStdWString(), [this]{ return m_Password.toStdWString(); });
+
+    if (!opened || a->getFileList().size() != files.size()) {
+      log::debug("can't open {} again, extracting with {} handles", m_ArchivePath, i);
+      break;
+    }
+
+    handles.push_back(std::move(a));
+  }
+
+  if (handles.empty()) {
+    return extractSerial();
+  }
+
+  // biggest files first, each to the handle with the least bytes so far;
+  // files for handle 0 stay on m_ArchiveHandler
+  std::sort(mapped.begin(), mapped.end(), [&](auto a, auto b) {
+    return files[a]->getSize() > files[b]->getSize();
+  });
+
+  std::vector<uint64_t> load(handles.size() + 1, 0);
+  for (auto i : mapped) {
+    const auto h = std::min_element(load.begin(), load.end()) - load.begin();
+    load[h] += files[i]->getSize();
+
+    if (h > 0) {
+      FileData* target = handles[h - 1]->getFileList()[i];
+      for (const auto& path : files[i]->getOutputFilePaths()) {
+        target->addOutputFilePath(path);
+      }
+
+      files[i]->clearOutputFilePaths();
+    }
+  }
+
+  log::debug(
+    "extracting {} files from {} with {} handles",
+    mapped.size(), m_ArchivePath, handles.size() + 1);
+
+  // progress is reported for all the handles together
+  std::mutex progressMutex;
+  std::vector<std::pair<uint64_t, uint64_t>> handleProgress(handles.size() + 1);
+
+  auto progressFor = [&](std::size_t h) -> Archive::ProgressCallback {
+    if (!progress) {
+      return nullptr;
+    }
+
+    return [&, h](Archive::ProgressType type, uint64_t current, uint64_t total) {
+      uint64_t allCurrent = 0, allTotal = 0;
+
+      {
+        std::scoped_lock guard(progressMutex);
+        handleProgress[h] = {current, total};
+
+        for (const auto& p : handleProgress) {
+          allCurrent += p.first;
+          allTotal += p.second;
+        }
+      }
+
+      progress(type, allCurrent, std::max<uint64_t>(allTotal, 1));
+    };
+  };
+
+  {
+    std::scoped_lock lock(m_ExtraHandlersMutex);
+    for (auto& a : handles) {
+      m_ExtraHandlers.push_back(a.get());
+    }
+  }
+
+  std::vector<QFuture<bool>> futures;
+  for (std::size_t i = 0; i < handles.size(); ++i) {
+    futures.push_back(QtConcurrent::run([&, i] {
+      return handles[i]->extract(
+        extractPath.toStdWString(), progressFor(i + 1), fileChange, error);
+    }));
+  }
+
+  bool success = m_ArchiveHandler->extract(
+    extractPath.toStdWString(), progressFor(0), fileChange, error);
+
+  if (!success) {
+    m_ExtractError = m_ArchiveHandler->getLastError();
+    cancelExtraction();
+  }
+
+  for (std::size_t i = 0; i < futures.size(); ++i) {
+    futures[i].waitForFinished();
+
+    if (!futures[i].result()) {
+      // a real error is more interesting than the cancellation it caused
+      if (m_ExtractError == Archive::Error::ERROR_NONE ||
+          m_ExtractError == Archive::Error::ERROR_EXTRACT_CANCELLED) {
+        m_ExtractError = handles[i]->getLastError();
+      }
+
+      if (success) {
+        success = false;
+        cancelExtraction();
+      }
+    }
+  }
+
+  {
+    std::scoped_lock lock(m_ExtraHandlersMutex);
+    m_ExtraHandlers.clear();
+  }
+
+  return success;
+}
+
+void InstallationManager::cancelExtraction()
+{
+  m_ArchiveHandler->cancel();
+
+  std::scoped_lock lock(m_ExtraHandlersMutex);
+  for (auto* a : m_ExtraHandlers) {
+    a->cancel();
+  }
+}
+
+// adds the files of the given tree that an installer is likely to show before
+// the installation to `out`: everything in a fomod directory and the images
+//
+static void findInstallerAssets(
+  std::shared_ptr<const IFileTree> tree, bool inFomod,
+  std::vector<std::shared_ptr<const FileTreeEntry>>& out)
+{
+  for (auto entry : *tree) {
+    if (entry->isDir()) {
+      const bool fomod = inFomod ||
+        entry->name().compare("fomod", Qt::CaseInsensitive) == 0;
+
+      findInstallerAssets(entry->astree(), fomod, out);
+    } else if (inFomod || PrefetchImageSuffixes.contains(
+      QFileInfo(entry->name()).suffix(), Qt::CaseInsensitive)) {
+      out.push_back(entry);
+    }
+  }
+}
+
+void InstallationManager::startPrefetch(std::shared_ptr<const IFileTree> tree)
+{
+  // fomod installers look for the directory at the root or in the only
+  // directory at the root
+  auto fomod = tree->find("fomod", FileTreeEntry::DIRECTORY);
+
+  if (!fomod && tree->size() == 1 && (*tree->begin())->isDir()) {
+    fomod = (*tree->begin())->astree()->find("fomod", FileTreeEntry::DIRECTORY);
+  }
+
+  if (!fomod) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<const FileTreeEntry>> assets;
+  findInstallerAssets(tree, false, assets);
+
+  if (assets.empty()) {
+    return;
+  }
+
+  // paths are taken now, installers can change the tree while this runs
+  ArchiveFileTree::mapToArchive(*m_ArchiveHandler, assets);
+
+  uint64_t size = 0;
+  for (auto* f : m_ArchiveHandler->getFileList()) {
+    if (!f->getOutputFilePaths().empty()) {
+      size += f->getSize();
+    }
+  }
+
+  if (size > MaxPrefetchSize) {
+    log::debug(
+      "not prefetching {} installer assets, {} bytes is too big",
+      assets.size(), size);
+
+    for (auto* f : m_ArchiveHandler->getFileList()) {
+      f->clearOutputFilePaths();
+    }
+
+    return;
+  }
+
+  QStringList paths;
+  for (auto& entry : assets) {
+    paths.append(entry->path());
+    m_TempFilesToDelete.insert(entry->path());
+  }
+
+  log::debug("prefetching {} installer assets, {} bytes", paths.size(), size);
+
+  m_Prefetch = QtConcurrent::run([this, paths] {
+    Metrics::Timer tt("InstallationManager::prefetch");
+
+    const bool ok = extractArchive(QDir::tempPath(), nullptr, nullptr,
+      [this](std::wstring const& message) {
+        log::debug("prefetch failed: {}", message);
+        cancelExtraction();
+      });
+
+    // files that were not extracted must not be used by the next extraction
+    for (auto* f : m_ArchiveHandler->getFileList()) {
+      f->clearOutputFilePaths();
+    }
+
+    if (!ok) {
+      return;
+    }
+
+    for (const auto& path : paths) {
+      QFile file(QDir::tempPath() + "/" + path);
+
+      if (file.open(QIODevice::ReadOnly)) {
+        m_Prefetched[path] = file.readAll();
+      }
+    }
+  });
+}
+
+void InstallationManager::waitForPrefetch()
+{
+  if (m_Prefetch.isFinished()) {
+    return;
+  }
+
+  QEventLoop loop;
+  QFutureWatcher<void> watcher;
+  connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+  watcher.setFuture(m_Prefetch);
+
+  if (!watcher.isFinished()) {
+    loop.exec();
+  }
+}
+
+void InstallationManager::stopPrefetch()
+{
+  if (!m_Prefetch.isFinished()) {
+    cancelExtraction();
+    m_Prefetch.waitForFinished();
+  }
+
+  m_Prefetch = {};
+  m_Prefetched.clear();
+}
+
 QString InstallationManager::extractFile(std::shared_ptr<const FileTreeEntry> entry, bool silent)
 {
   QStringList result = this->extractFiles({ entry }, silent);
@@ -275,13 +589,21 @@ QString InstallationManager::extractFile(std::shared_ptr<const FileTreeEntry> en
 
 QStringList InstallationManager::extractFiles(std::vector<std::shared_ptr<const FileTreeEntry>> const& entries, bool silent)
 {
+  // the handle is busy until the prefetch is done
+  waitForPrefetch();
+
   // Remove the directory since mapToArchive would add them:
   std::vector<std::shared_ptr<const FileTreeEntry>> files;
   std::copy_if(entries.begin(), entries.end(), std::back_inserter(files),
     [](auto const& entry) { return entry->isFile(); });
 
+  // prefetched files are already in the temporary directory
+  std::vector<std::shared_ptr<const FileTreeEntry>> missing;
+  std::copy_if(files.begin(), files.end(), std::back_inserter(missing),
+    [this](auto const& entry) { return m_Prefetched.find(entry->path()) == m_Prefetched.end(); });
+
   // Update the archive:
-  ArchiveFileTree::mapToArchive(*m_ArchiveHandler, files);
+  ArchiveFileTree::mapToArchive(*m_ArchiveHandler, missing);
 
   // Retrieve the file path:
   QStringList result;
@@ -292,13 +614,71 @@ QStringList InstallationManager::extractFiles(std::vector<std::shared_ptr<const
     m_TempFilesToDelete.insert(path);
   }
 
-  if (!extractFiles(QDir::tempPath(), tr("Extracting files"), false, silent)) {
+  if (!missing.empty() && !extractFiles(QDir::tempPath(), tr("Extracting files"), false, silent)) {
     return QStringList();
   }
 
   return result;
 }
 
+QByteArray InstallationManager::extractFileToMemory(std::shared_ptr<const FileTreeEntry> entry, bool silent)
+{
+  auto result = extractFilesToMemory({ entry }, silent);
+  return result.empty() ? QByteArray() : result[0];
+}
+
+std::vector<QByteArray> InstallationManager::extractFilesToMemory(std::vector<std::shared_ptr<const FileTreeEntry>> const& entries, bool silent)
+{
+  waitForPrefetch();
+
+  std::vector<QByteArray> result(entries.size());
+
+  // indices of the files that were not prefetched
+  std::vector<std::size_t> missing;
+
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    if (!entries[i]->isFile()) {
+      continue;
+    }
+
+    auto itor = m_Prefetched.find(entries[i]->path());
+
+    if (itor != m_Prefetched.end()) {
+      result[i] = itor->second;
+    } else {
+      missing.push_back(i);
+    }
+  }
+
+  if (missing.empty()) {
+    return result;
+  }
+
+  std::vector<std::shared_ptr<const FileTreeEntry>> files;
+  for (auto i : missing) {
+    files.push_back(entries[i]);
+  }
+
+  const auto paths = extractFiles(files, silent);
+
+  if (paths.size() != static_cast<int>(missing.size())) {
+    // cancelled
+    return std::vector<QByteArray>(entries.size());
+  }
+
+  for (std::size_t i = 0; i < missing.size(); ++i) {
+    QFile file(paths[static_cast<int>(i)]);
+
+    if (file.open(QIODevice::ReadOnly)) {
+      result[missing[i]] = file.readAll();
+    } else {
+      log::error("can't read extracted file {}: {}", paths[static_cast<int>(i)], file.errorString());
+    }
+  }
+
+  return result;
+}
+
 
 QString InstallationManager::createFile(std::shared_ptr<const MOBase::FileTreeEntry> entry)
 {
@@ -363,6 +743,55 @@ IPluginInstaller::EInstallResult InstallationManager::installArchive(GuessedValu
 }
 
 
+// creates `destination` with hard links to the files in `source` so a backup
+// doesn't need the space of a second copy; files that can't be linked are
+// copied
+//
+static bool linkDir(const QString& source, const QString& destination)
+{
+  if (!QDir().mkpath(destination)) {
+    log::error("failed to create {}", destination);
+    return false;
+  }
+
+  const QDir sourceDir(source);
+
+  QDirIterator it(
+    source, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System,
+    QDirIterator::Subdirectories);
+
+  while (it.hasNext()) {
+    const QString path = it.next();
+    const QFileInfo info = it.fileInfo();
+    const QString target = destination + "/" + sourceDir.relativeFilePath(path);
+
+    if (info.isDir()) {
+      if (!QDir().mkpath(target)) {
+        log::error("failed to create {}", target);
+        return false;
+      }
+
+      continue;
+    }
+
+    QDir().mkpath(QFileInfo(target).absolutePath());
+
+    // the meta.ini of both mods is rewritten in place, it can't be shared
+    const bool linked =
+      (info.fileName().compare("meta.ini", Qt::CaseInsensitive) != 0) &&
+      ::CreateHardLinkW(
+        QDir::toNativeSeparators(target).toStdWString().c_str(),
+        QDir::toNativeSeparators(path).toStdWString().c_str(), nullptr);
+
+    if (!linked && !QFile::copy(path, target)) {
+      log::error("failed to copy {} to {}", path, target);
+      return false;
+    }
+  }
+
+  return true;
+}
+
 QString InstallationManager::generateBackupName(const QString &directoryName) const
 {
   QString backupName = directoryName + "_backup";
@@ -399,7 +828,14 @@ InstallationResult InstallationManager::testOverwrite(GuessedValue<QString> &mod
 
       if (overwriteDialog.backup()) {
         QString backupDirectory = generateBackupName(targetDirectory);
-        if (!copyDir(targetDirectory, backupDirectory, false)) {
+
+        // merging writes into the existing files, which would change the
+        // backup too if it shared them
+        const bool backedUp = (overwriteDialog.action() == QueryOverwriteDialog::ACT_MERGE) ?
+          copyDir(targetDirectory, backupDirectory, false) :
+          linkDir(targetDirectory, backupDirectory);
+
+        if (!backedUp) {
           reportError(tr("Failed to create backup"));
           return { IPluginInstaller::RESULT_FAILED };
         }
@@ -504,9 +940,29 @@ InstallationResult InstallationManager::doInstall(
   QString targetDirectory = QDir(m_ModsDirectory + "/" + modName).canonicalPath();
   QString targetDirectoryNative = QDir::toNativeSeparators(targetDirectory);
 
+  // the archive is extracted straight into the mod's directory; a new mod is
+  // removed again if that doesn't complete so a partial mod isn't left behind
+  auto rollback = [&] {
+    if (result.mergedOrReplaced()) {
+      return;
+    }
+
+    log::debug("removing partially installed mod \"{}\"", targetDirectoryNative);
+    if (!QDir(targetDirectory).removeRecursively()) {
+      log::error("failed to remove \"{}\"", targetDirectoryNative);
+    }
+  };
+
   log::debug("installing to \"{}\"", targetDirectoryNative);
-  if (!extractFiles(targetDirectory, "", true, false)) {
-    return { IPluginInstaller::RESULT_CANCELED };
+
+  try {
+    if (!extractFiles(targetDirectory, "", true, false)) {
+      rollback();
+      return { IPluginInstaller::RESULT_CANCELED };
+    }
+  } catch (const std::exception&) {
+    rollback();
+    throw;
   }
 
   // Copy the created files:
@@ -524,7 +980,11 @@ InstallationResult InstallationManager::doInstall(
       dir.mkpath(".");
     }
 
-    QFile::copy(p.second, destPath);
+    // created files are temporary, moving them avoids writing them again when
+    // the temp directory is on the same volume
+    if (!QFile::rename(p.second, destPath)) {
+      QFile::copy(p.second, destPath);
+    }
   }
 
   QSettings settingsFile(targetDirectory + "/meta.ini", QSettings::IniFormat);
@@ -566,7 +1026,8 @@ InstallationResult InstallationManager::doInstall(
 
 bool InstallationManager::wasCancelled() const
 {
-  return m_ArchiveHandler->getLastError() == Archive::Error::ERROR_EXTRACT_CANCELLED;
+  return m_ArchiveHandler->getLastError() == Archive::Error::ERROR_EXTRACT_CANCELLED
+      || m_ExtractError == Archive::Error::ERROR_EXTRACT_CANCELLED;
 }
 
 bool InstallationManager::isRunning() const
@@ -577,6 +1038,9 @@ bool InstallationManager::isRunning() const
 
 void InstallationManager::postInstallCleanup()
 {
+  // the prefetch uses the archive
+  stopPrefetch();
+
   // Clear the list of created files:
   m_CreatedFiles.clear();
 
@@ -620,6 +1084,8 @@ InstallationResult InstallationManager::install(
   m_IsRunning = true;
   ON_BLOCK_EXIT([this]() { m_IsRunning = false; });
 
+  m_ExtractError = Archive::Error::ERROR_NONE;
+
   QFileInfo fileInfo(fileName);
   if (!getSupportedExtensions().contains(fileInfo.suffix(), Qt::CaseInsensitive)) {
     reportError(tr("File format \"%1\" not supported").arg(fileInfo.suffix()));
@@ -684,10 +1150,12 @@ InstallationResult InstallationManager::install(
   //If there's an archive already open, close it. This happens with the bundle
   //installer when it uncompresses a split archive, then finds it has a real archive
   //to deal with.
+  stopPrefetch();
   m_ArchiveHandler->close();
 
   // open the archive and construct the directory tree the installers work on
 
+  m_ArchivePath = fileName;
   bool archiveOpen = m_ArchiveHandler->open(
     fileName.toStdWString(), [this]() -> std::wstring {
       m_Password = QString();
@@ -715,6 +1183,12 @@ InstallationResult InstallationManager::install(
   std::shared_ptr<IFileTree> filesTree =
     archiveOpen ? ArchiveFileTree::makeTree(*m_ArchiveHandler) : nullptr;
 
+  // installer assets are extracted while the installers look at the tree and
+  // open their dialog
+  if (filesTree) {
+    startPrefetch(filesTree);
+  }
+
   auto installers = m_PluginContainer->plugins<IPluginInstaller>();
 
   std::sort(installers.begin(), installers.end(), [] (IPluginInstaller* lhs, IPluginInstaller* rhs) {
@@ -744,8 +1218,15 @@ InstallationResult InstallationManager::install(
             = dynamic_cast<IPluginInstallerSimple *>(installer);
         if ((installerSimple != nullptr) && (filesTree != nullptr)
             && (installer->isArchiveSupported(filesTree))) {
-          installResult.m_result
-              = installerSimple->install(modName, filesTree, version, modID);
+          {
+            PluginCallTimer t(
+              dynamic_cast<IPlugin*>(installer), "install",
+              PluginCallTimer::NeverWarn);
+
+            installResult.m_result
+                = installerSimple->install(modName, filesTree, version, modID);
+          }
+
           if (installResult) {
 
             // Downcast to an actual ArchiveFileTree and map to the archive. Test if
@@ -760,6 +1241,7 @@ InstallationResult InstallationManager::install(
             // stops at this root):
             p->detach();
 
+            waitForPrefetch();
             p->mapToArchive(*m_ArchiveHandler);
 
             // Clean the created files:
@@ -784,8 +1266,15 @@ InstallationResult InstallationManager::install(
           std::set<QString> installerExt
               = installerCustom->supportedExtensions();
           if (installerExt.find(fileInfo.suffix()) != installerExt.end()) {
-            installResult.m_result
-                = installerCustom->install(modName, gameName, fileName, version, modID);
+            {
+              PluginCallTimer t(
+                dynamic_cast<IPlugin*>(installer), "install",
+                PluginCallTimer::NeverWarn);
+
+              installResult.m_result
+                  = installerCustom->install(modName, gameName, fileName, version, modID);
+            }
+
             unsigned int idx = ModInfo::getIndex(modName);
             if (idx != UINT_MAX) {
               ModInfo::Ptr info = ModInfo::getByIndex(idx);
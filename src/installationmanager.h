@@ -30,8 +30,12 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <Windows.h>
 #include <archive.h>
 #include <QProgressDialog>
+#include <QFuture>
+#include <QByteArray>
 #include <set>
 #include <map>
+#include <mutex>
+#include <vector>
 #include <errorcodes.h>
 
 #include "modinfo.h"
@@ -206,6 +210,27 @@ public:
    */
   QStringList extractFiles(std::vector<std::shared_ptr<const MOBase::FileTreeEntry>> const& entries, bool silent = false) override;
 
+  /**
+   * @brief Extract the specified files from the currently opened archive into memory.
+   *
+   * Files that were prefetched when the archive was opened are returned without
+   * touching the archive again, the others are extracted like extractFiles() does.
+   *
+   * @param entries Entries corresponding to the files to extract.
+   * @param silent If true, the dialog showing extraction progress will not be shown.
+   *
+   * @return the content of each entry, in the same order; empty for directories
+   *     or if the extraction was cancelled.
+   */
+  std::vector<QByteArray> extractFilesToMemory(std::vector<std::shared_ptr<const MOBase::FileTreeEntry>> const& entries, bool silent = false);
+
+  /**
+   * @brief Extract the specified file from the currently opened archive into memory.
+   *
+   * @see extractFilesToMemory()
+   */
+  QByteArray extractFileToMemory(std::shared_ptr<const MOBase::FileTreeEntry> entry, bool silent = false);
+
   /**
    * @brief Create a new file on the disk corresponding to the given entry.
    *
@@ -307,6 +332,47 @@ private:
    */
   bool extractFiles(QString extractPath, QString title, bool showFilenames, bool silent);
 
+  /**
+   * @brief Extract the files that have output filenames associated with them.
+   *
+   * Archives that don't decode entries together (zip) are opened a few more
+   * times and the files are split across the handles, which extract in
+   * parallel. Other formats are extracted by m_ArchiveHandler alone.
+   *
+   * @return true if the extraction was successful; m_ExtractError has the
+   *     error otherwise.
+   */
+  bool extractArchive(
+    const QString& extractPath, Archive::ProgressCallback progress,
+    Archive::FileChangeCallback fileChange, Archive::ErrorCallback error);
+
+  /**
+   * @brief Cancel the extraction on all the archive handles.
+   */
+  void cancelExtraction();
+
+  /**
+   * @brief Start extracting the files installers show before the installation
+   *     in the background.
+   *
+   * If the tree has a fomod directory, the files in it and the images of the
+   * archive are extracted to the temporary directory in a single pass and
+   * kept in memory, so the installer doesn't have to go through the archive
+   * for each of them. Nothing is prefetched if they're too big.
+   */
+  void startPrefetch(std::shared_ptr<const MOBase::IFileTree> tree);
+
+  /**
+   * @brief Wait for the prefetch to finish, processing events meanwhile; the
+   *     archive handle can be used once this returns.
+   */
+  void waitForPrefetch();
+
+  /**
+   * @brief Cancel the prefetch, wait for it and forget the prefetched files.
+   */
+  void stopPrefetch();
+
 private:
 
   // The plugin container, mostly to check if installer are enabled or not.
@@ -321,13 +387,26 @@ private:
 
   // Archive management.
   std::unique_ptr<Archive> m_ArchiveHandler;
+  QString m_ArchivePath;
   QString m_CurrentFile;
   QString m_Password;
 
+  // additional handles on the archive while extractArchive() runs, and the
+  // error of the last extraction over all handles
+  std::vector<Archive*> m_ExtraHandlers;
+  std::mutex m_ExtraHandlersMutex;
+  Archive::Error m_ExtractError;
+
   // Map from entries in the tree that is used by the installer and absolute
   // paths to temporary files.
   std::map<std::shared_ptr<const MOBase::FileTreeEntry>, QString> m_CreatedFiles;
   std::set<QString> m_TempFilesToDelete;
+
+  // extraction started by startPrefetch() and the content of the files it
+  // extracted, by path in the tree; the map is only filled by the prefetch and
+  // must not be accessed until waitForPrefetch() returns
+  QFuture<void> m_Prefetch;
+  std::map<QString, QByteArray> m_Prefetched;
 };
 
 
@@ -26,6 +26,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "createinstancedialog.h"
 #include "instancemanagerdialog.h"
 #include "createinstancedialogpages.h"
+#include "gamedetection.h"
 #include "shared/appconfig.h"
 #include "shared/util.h"
 #include <report.h>
@@ -263,16 +264,17 @@ Instance::SetupResults Instance::getGamePlugin(PluginContainer& plugins)
       "game name is missing from ini {} but dir {} is available",
       iniPath(), m_gameDir);
 
-    for (IPluginGame* game : plugins.plugins<IPluginGame>()) {
-      if (game->looksValid(m_gameDir)) {
-        // take it
-        log::warn("found plugin {} that can use dir {}", game->gameName(), m_gameDir);
+    auto* game = GameDetection::findForDirectory(
+      m_gameDir, plugins.plugins<IPluginGame>(), plugins);
 
-        m_plugin = game;
-        m_gameName = game->gameName();
+    if (game) {
+      // take it
+      log::warn("found plugin {} that can use dir {}", game->gameName(), m_gameDir);
 
-        return SetupResults::Okay;
-      }
+      m_plugin = game;
+      m_gameName = game->gameName();
+
+      return SetupResults::Okay;
     }
 
     log::error("no plugins can use dir {}", m_gameDir);
@@ -690,10 +692,9 @@ const MOBase::IPluginGame* InstanceManager::gamePluginForDirectory(
 
   if (gameDir && !gameDir->isEmpty())
   {
-    for (const IPluginGame* game : plugins.plugins<IPluginGame>()) {
-      if (game->looksValid(*gameDir)) {
-        return game;
-      }
+    if (auto* game=GameDetection::findForDirectory(
+      *gameDir, plugins.plugins<IPluginGame>(), plugins)) {
+      return game;
     }
 
     log::error(
@@ -709,14 +710,8 @@ const MOBase::IPluginGame* InstanceManager::gamePluginForDirectory(
   // looking for a plugin that can handle the directory
   log::debug("falling back on looksValid check");
 
-  for (const IPluginGame* game : plugins.plugins<IPluginGame>()) {
-    if (game->looksValid(instanceDir)) {
-      return game;
-    }
-  }
-
-
-  return nullptr;
+  return GameDetection::findForDirectory(
+    instanceDir, plugins.plugins<IPluginGame>(), plugins);
 }
 
 QString InstanceManager::makeUniqueName(const QString& instanceName) const
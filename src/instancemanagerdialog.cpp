@@ -2,6 +2,7 @@
 #include "ui_instancemanagerdialog.h"
 #include "instancemanager.h"
 #include "createinstancedialog.h"
+#include "deletionqueue.h"
 #include "settings.h"
 #include "selectiondialog.h"
 #include "plugincontainer.h"
@@ -13,18 +14,61 @@
 
 using namespace MOBase;
 
+// an empty 32x32 icon, used until the ini of an instance has been read or
+// when its game plugin can't be found
+//
+QIcon emptyInstanceIcon()
+{
+  QPixmap empty(32, 32);
+  empty.fill(QColor(0, 0, 0, 0));
+  return QIcon(empty);
+}
+
+// icons by game name and directory; they're kept as long as MO is running so
+// opening the dialog again doesn't have to get them from the game plugins
+//
+std::map<QString, QIcon>& instanceIconCache()
+{
+  static std::map<QString, QIcon> map;
+  return map;
+}
+
+// finds the game plugin for the given instance, which must have read its ini;
+// the game name is checked first so the plugins don't have to look at the
+// directory unless the name is missing or unknown
+//
+IPluginGame* instanceGamePlugin(PluginContainer& pc, const Instance& i)
+{
+  if (!i.gameName().isEmpty()) {
+    for (IPluginGame* game : pc.plugins<IPluginGame>()) {
+      if (i.gameName().compare(game->gameName(), Qt::CaseInsensitive) == 0) {
+        return game;
+      }
+    }
+  }
+
+  return InstanceManager::singleton().gamePluginForDirectory(i.directory(), pc);
+}
+
 // returns the icon for the given instance or an empty 32x32 icon if the game
 // plugin couldn't be found
 //
 QIcon instanceIcon(PluginContainer& pc, const Instance& i)
 {
-  auto* game = InstanceManager::singleton()
-    .gamePluginForDirectory(i.directory(), pc);
+  const QString key =
+    i.gameName().toLower() + "|" + QDir::cleanPath(i.gameDirectory()).toLower();
+
+  auto& cache = instanceIconCache();
+
+  auto itor = cache.find(key);
+  if (itor != cache.end()) {
+    return itor->second;
+  }
+
+  auto* game = instanceGamePlugin(pc, i);
 
   if (!game) {
-    QPixmap empty(32, 32);
-    empty.fill(QColor(0, 0, 0, 0));
-    return QIcon(empty);
+    return emptyInstanceIcon();
   }
 
   // it's possible to have the game installed in a way that the game plugin
@@ -64,7 +108,10 @@ QIcon instanceIcon(PluginContainer& pc, const Instance& i)
   // set directory for this instance
   game->setGamePath(i.gameDirectory());
 
-  return game->gameIcon();
+  const auto icon = game->gameIcon();
+  cache.emplace(key, icon);
+
+  return icon;
 }
 
 // pops up a dialog to ask for an instance name when renaming
@@ -140,12 +187,18 @@ QString getInstanceName(
 }
 
 
-InstanceManagerDialog::~InstanceManagerDialog() = default;
+InstanceManagerDialog::~InstanceManagerDialog()
+{
+  // the inis that haven't been read yet don't matter anymore
+  if (m_loader) {
+    m_loader->cancel();
+  }
+}
 
 InstanceManagerDialog::InstanceManagerDialog(
   PluginContainer& pc, QWidget *parent) :
     QDialog(parent), ui(new Ui::InstanceManagerDialog), m_pc(pc),
-    m_model(nullptr), m_restartOnSelect(true)
+    m_model(nullptr), m_restartOnSelect(true), m_generation(0)
 {
   ui->setupUi(this);
 
@@ -213,6 +266,13 @@ void InstanceManagerDialog::updateInstances()
 {
   auto& m = InstanceManager::singleton();
 
+  // results from the previous list would go to the wrong instances
+  if (m_loader) {
+    m_loader->cancel();
+    m_loader.reset();
+  }
+
+  ++m_generation;
   m_instances.clear();
 
   for (auto&& d : m.globalInstancePaths()) {
@@ -230,9 +290,67 @@ void InstanceManagerDialog::updateInstances()
       std::make_unique<Instance>(m.portablePath(), true));
   }
 
-  // read all inis, ignore errors
-  for (auto&& i : m_instances) {
-    i->readFromIni();
+  m_iniRead.assign(m_instances.size(), false);
+
+  loadInstances();
+}
+
+void InstanceManagerDialog::loadInstances()
+{
+  m_loader.reset(new MOShared::TaskGroup(MOShared::TaskPriority::Normal));
+
+  // the group waits for its tasks when it's destroyed, so it outlives them
+  auto* group = m_loader.get();
+
+  for (std::size_t i=0; i<m_instances.size(); ++i) {
+    const auto& ii = *m_instances[i];
+
+    group->run([this, group, generation=m_generation, i,
+                dir=ii.directory(), portable=ii.isPortable()] {
+      if (group->cancelled()) {
+        return;
+      }
+
+      // errors are ignored, the instance is shown with whatever could be read
+      auto loaded = std::make_shared<Instance>(dir, portable);
+      loaded->readFromIni();
+
+      QMetaObject::invokeMethod(this, [this, generation, i, loaded] {
+        onInstanceLoaded(generation, i, *loaded);
+      }, Qt::QueuedConnection);
+    });
+  }
+}
+
+void InstanceManagerDialog::onInstanceLoaded(
+  int generation, std::size_t i, const Instance& loaded)
+{
+  if (generation != m_generation || i >= m_instances.size()) {
+    // the list has been refreshed since
+    return;
+  }
+
+  if (m_instances[i]->directory() != loaded.directory()) {
+    // renamed
+    return;
+  }
+
+  if (!m_iniRead[i]) {
+    *m_instances[i] = loaded;
+    m_iniRead[i] = true;
+  }
+
+  if (auto* item=m_model->item(static_cast<int>(i))) {
+    item->setIcon(instanceIcon(m_pc, *m_instances[i]));
+  }
+}
+
+void InstanceManagerDialog::ensureIniRead(std::size_t i)
+{
+  if (i < m_instances.size() && !m_iniRead[i]) {
+    // ignore errors
+    m_instances[i]->readFromIni();
+    m_iniRead[i] = true;
   }
 }
 
@@ -249,8 +367,9 @@ void InstanceManagerDialog::updateList()
   for (std::size_t i=0; i<m_instances.size(); ++i) {
     const auto& ii = *m_instances[i];
 
+    // the icon is set once the ini has been read, see onInstanceLoaded()
     auto* item = new QStandardItem(ii.name());
-    item->setIcon(instanceIcon(m_pc, ii));
+    item->setIcon(m_iniRead[i] ? instanceIcon(m_pc, ii) : emptyInstanceIcon());
 
     m_model->appendRow(item);
 
@@ -281,6 +400,8 @@ void InstanceManagerDialog::updateList()
 void InstanceManagerDialog::select(std::size_t i)
 {
   if (i < m_instances.size()) {
+    ensureIniRead(i);
+
     const auto& ii = m_instances[i];
     fillData(*ii);
 
@@ -434,6 +555,9 @@ void InstanceManagerDialog::rename()
   m_model->item(selIndex)->setText(newName);
   m_instances[selIndex] = std::move(newInstance);
 
+  m_iniRead[selIndex] = false;
+  ensureIniRead(selIndex);
+
   fillData(*i);
 }
 
@@ -581,7 +705,11 @@ bool InstanceManagerDialog::doDelete(const QStringList& files, bool recycle)
     }
   }
 
-  if (MOBase::shellDelete(files, recycle, this)) {
+  // files that can be moved out of the way are deleted in the background,
+  // the others are deleted here
+  const QStringList remaining = DeletionQueue::add(files, recycle);
+
+  if (remaining.isEmpty() || MOBase::shellDelete(remaining, recycle, this)) {
     return true;
   }
 
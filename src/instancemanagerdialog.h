@@ -1,6 +1,7 @@
 #ifndef MODORGANIZER_INSTANCEMANAGERDIALOG_INCLUDED
 #define MODORGANIZER_INSTANCEMANAGERDIALOG_INCLUDED
 
+#include "taskexecutor.h"
 #include <filterwidget.h>
 #include <QDialog>
 
@@ -11,6 +12,11 @@ class PluginContainer;
 
 // a dialog to manage existing instances
 //
+// the list is filled with the names of the instances right away; their inis
+// are read in the background and the icons of their game are set once they're
+// known, so the dialog is usable even when there are a lot of instances or
+// they're on slow drives
+//
 class InstanceManagerDialog : public QDialog
 {
   Q_OBJECT
@@ -97,10 +103,37 @@ private:
   QStandardItemModel* m_model;
   bool m_restartOnSelect;
 
-  // refreshes the list instances from disk
+  // whether the ini of the instance at the same index in m_instances has been
+  // read
+  std::vector<bool> m_iniRead;
+
+  // reads the inis of the instances, see loadInstances()
+  std::unique_ptr<MOShared::TaskGroup> m_loader;
+
+  // incremented every time the list of instances is refreshed, results from
+  // a previous loader are ignored
+  int m_generation;
+
+  // refreshes the list instances from disk, the inis are read later by
+  // loadInstances()
   //
   void updateInstances();
 
+  // reads the inis of all the instances in the background, calls
+  // onInstanceLoaded() on the ui thread for each
+  //
+  void loadInstances();
+
+  // replaces the instance at the given index by one that has read its ini and
+  // sets its icon, unless the list has changed since
+  //
+  void onInstanceLoaded(int generation, std::size_t i, const Instance& loaded);
+
+  // reads the ini of the given instance right away if the loader hasn't done
+  // it yet, used before showing its details
+  //
+  void ensureIniRead(std::size_t i);
+
   // updates the ui for the selected instance
   //
   void onSelection();
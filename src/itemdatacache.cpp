@@ -0,0 +1,124 @@
+#include "itemdatacache.h"
+
+ItemDataCache::ItemDataCache(QAbstractItemModel* model, std::vector<int> roles)
+  : m_model(model), m_roles(std::move(roles))
+{
+  QObject::connect(m_model, &QAbstractItemModel::dataChanged,
+    [this](const QModelIndex& topLeft, const QModelIndex& bottomRight,
+           const QVector<int>& roles) {
+      if (!topLeft.isValid() || !bottomRight.isValid()) {
+        // some models signal changes with indexes that are one past the end
+        invalidate();
+        return;
+      }
+
+      invalidate(
+        topLeft.row(), bottomRight.row(),
+        topLeft.column(), bottomRight.column(), roles);
+    });
+
+  QObject::connect(m_model, &QAbstractItemModel::layoutChanged, [this]{ invalidate(); });
+  QObject::connect(m_model, &QAbstractItemModel::modelReset, [this]{ invalidate(); });
+  QObject::connect(m_model, &QAbstractItemModel::rowsInserted, [this]{ invalidate(); });
+  QObject::connect(m_model, &QAbstractItemModel::rowsRemoved, [this]{ invalidate(); });
+  QObject::connect(m_model, &QAbstractItemModel::rowsMoved, [this]{ invalidate(); });
+  QObject::connect(m_model, &QAbstractItemModel::columnsInserted, [this]{ invalidate(); });
+  QObject::connect(m_model, &QAbstractItemModel::columnsRemoved, [this]{ invalidate(); });
+}
+
+void ItemDataCache::invalidate()
+{
+  m_rows.clear();
+}
+
+void ItemDataCache::invalidate(int first, int last)
+{
+  first = std::max(first, 0);
+  last = std::min(last, static_cast<int>(m_rows.size()) - 1);
+
+  for (int i=first; i<=last; ++i) {
+    m_rows[i].clear();
+  }
+}
+
+void ItemDataCache::invalidate(
+  int first, int last, int firstColumn, int lastColumn,
+  const QVector<int>& roles)
+{
+  const int columns = m_model->columnCount();
+
+  firstColumn = std::max(firstColumn, 0);
+  lastColumn = std::min(lastColumn, columns - 1);
+
+  if (roles.isEmpty() && firstColumn == 0 && lastColumn == columns - 1) {
+    invalidate(first, last);
+    return;
+  }
+
+  // slots of the cached roles that changed
+  std::vector<std::size_t> changed;
+
+  for (int role : roles) {
+    const int r = roleIndex(role);
+    if (r >= 0) {
+      changed.push_back(static_cast<std::size_t>(r));
+    }
+  }
+
+  if (roles.isEmpty()) {
+    for (std::size_t r=0; r<m_roles.size(); ++r) {
+      changed.push_back(r);
+    }
+  }
+
+  if (changed.empty()) {
+    return;
+  }
+
+  first = std::max(first, 0);
+  last = std::min(last, static_cast<int>(m_rows.size()) - 1);
+
+  for (int i=first; i<=last; ++i) {
+    auto& cells = m_rows[i];
+    if (cells.empty()) {
+      continue;
+    }
+
+    for (int c=firstColumn; c<=lastColumn; ++c) {
+      for (std::size_t r : changed) {
+        cells[c * m_roles.size() + r].reset();
+      }
+    }
+  }
+}
+
+int ItemDataCache::roleIndex(int role) const
+{
+  for (std::size_t i=0; i<m_roles.size(); ++i) {
+    if (m_roles[i] == role) {
+      return static_cast<int>(i);
+    }
+  }
+
+  return -1;
+}
+
+ItemDataCache::Slot* ItemDataCache::find(int row, int column, int role) const
+{
+  const int columns = m_model->columnCount();
+
+  if (row < 0 || column < 0 || column >= columns) {
+    return nullptr;
+  }
+
+  if (static_cast<std::size_t>(row) >= m_rows.size()) {
+    m_rows.resize(row + 1);
+  }
+
+  auto& cells = m_rows[row];
+  if (cells.empty()) {
+    cells.resize(columns * m_roles.size());
+  }
+
+  return &cells[column * m_roles.size() + role];
+}
@@ -0,0 +1,83 @@
+#ifndef MODORGANIZER_ITEMDATACACHE_INCLUDED
+#define MODORGANIZER_ITEMDATACACHE_INCLUDED
+
+#include <QAbstractItemModel>
+#include <QVariant>
+#include <optional>
+#include <vector>
+
+// remembers what a flat model returned from data() for a few roles, so
+// repainting rows doesn't compute everything again
+//
+// the cache is cleared for the rows, columns and roles in dataChanged() and
+// entirely for any other change signalled by the model, such as layout changes
+// or rows being inserted; models must call invalidate() themselves when what
+// they return changes without a signal
+//
+// only top-level indexes are cached
+//
+class ItemDataCache
+{
+public:
+  // caches the given roles for the given model, roles can't be changed
+  // afterwards
+  //
+  ItemDataCache(QAbstractItemModel* model, std::vector<int> roles);
+
+  // noncopyable
+  ItemDataCache(const ItemDataCache&) = delete;
+  ItemDataCache& operator=(const ItemDataCache&) = delete;
+
+  // returns the cached value for the given index and role, or calls f() and
+  // caches what it returns; f() is always called for roles that are not
+  // cached
+  //
+  template <class F>
+  QVariant get(const QModelIndex& index, int role, F&& f) const
+  {
+    const int r = roleIndex(role);
+    if (r < 0 || index.parent().isValid()) {
+      return f();
+    }
+
+    auto* slot = find(index.row(), index.column(), r);
+    if (!slot) {
+      return f();
+    }
+
+    if (!*slot) {
+      *slot = f();
+    }
+
+    return **slot;
+  }
+
+  // forgets everything
+  //
+  void invalidate();
+
+  // forgets the given rows, inclusive
+  //
+  void invalidate(int first, int last);
+
+  // forgets the given roles in the given rows and columns, inclusive; all the
+  // cached roles are forgotten if `roles` is empty
+  //
+  void invalidate(
+    int first, int last, int firstColumn, int lastColumn,
+    const QVector<int>& roles);
+
+private:
+  using Slot = std::optional<QVariant>;
+
+  QAbstractItemModel* m_model;
+  std::vector<int> m_roles;
+
+  // one slot per column and cached role, rows are resized on demand
+  mutable std::vector<std::vector<Slot>> m_rows;
+
+  int roleIndex(int role) const;
+  Slot* find(int row, int column, int role) const;
+};
+
+#endif // MODORGANIZER_ITEMDATACACHE_INCLUDED
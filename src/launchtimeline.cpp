@@ -0,0 +1,225 @@
+#include "launchtimeline.h"
+#include "metrics.h"
+#include <log.h>
+#include <QCoreApplication>
+#include <QStringList>
+#include <deque>
+#include <mutex>
+
+using namespace MOBase;
+
+// launches kept in the history
+static constexpr std::size_t MaxLaunches = 20;
+
+
+namespace
+{
+
+struct State
+{
+  std::mutex mutex;
+
+  // the launch being timed
+  std::optional<LaunchTimeline::Launch> current;
+  LaunchTimeline::Clock::time_point start;
+
+  // the last launch while waiting for its first process, 0 otherwise
+  unsigned long waitingPID = 0;
+  LaunchTimeline::Clock::time_point waitingStart;
+
+  std::deque<LaunchTimeline::Launch> history;
+  std::function<void ()> changed;
+};
+
+State g_state;
+
+double ms(std::chrono::nanoseconds d)
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(d).count() / 1000.0;
+}
+
+void notifyChanged()
+{
+  QMetaObject::invokeMethod(qApp, [] {
+    std::function<void ()> f;
+
+    {
+      std::scoped_lock lock(g_state.mutex);
+      f = g_state.changed;
+    }
+
+    if (f) {
+      f();
+    }
+  }, Qt::QueuedConnection);
+}
+
+} // namespace
+
+
+int LaunchTimeline::Launch::longest() const
+{
+  int i = -1;
+
+  for (int s=0; s<static_cast<int>(stages.size()); ++s) {
+    if (i == -1 || stages[s].second > stages[i].second) {
+      i = s;
+    }
+  }
+
+  return i;
+}
+
+
+LaunchTimeline::Scope::Scope(QString binary)
+{
+  std::scoped_lock lock(g_state.mutex);
+
+  g_state.current = Launch();
+  g_state.current->time = QDateTime::currentDateTime();
+  g_state.current->binary = std::move(binary);
+  g_state.start = Clock::now();
+}
+
+LaunchTimeline::Scope::~Scope()
+{
+  // does nothing if started() was called
+  std::scoped_lock lock(g_state.mutex);
+  g_state.current.reset();
+}
+
+void LaunchTimeline::Scope::started(unsigned long pid)
+{
+  Launch l;
+
+  {
+    std::scoped_lock lock(g_state.mutex);
+
+    if (!g_state.current) {
+      return;
+    }
+
+    l = std::move(*g_state.current);
+    g_state.current.reset();
+
+    l.total = Clock::now() - g_state.start;
+
+    g_state.history.push_back(l);
+    while (g_state.history.size() > MaxLaunches) {
+      g_state.history.pop_front();
+    }
+
+    g_state.waitingPID = pid;
+    g_state.waitingStart = g_state.start;
+  }
+
+  log::debug("{}", toString(l));
+
+  for (auto&& [name, d] : l.stages) {
+    Metrics::duration("launch." + name, d);
+  }
+
+  Metrics::duration("launch", l.total);
+
+  notifyChanged();
+}
+
+
+LaunchTimeline::Stage::Stage(QString name)
+  : m_name(std::move(name)), m_start(Clock::now()), m_running(true)
+{
+}
+
+LaunchTimeline::Stage::~Stage()
+{
+  stop();
+}
+
+void LaunchTimeline::Stage::stop()
+{
+  if (!m_running) {
+    return;
+  }
+
+  m_running = false;
+
+  std::scoped_lock lock(g_state.mutex);
+
+  if (g_state.current) {
+    g_state.current->stages.push_back({m_name, Clock::now() - m_start});
+  }
+}
+
+
+void LaunchTimeline::processStarted(unsigned long pid)
+{
+  std::chrono::nanoseconds d;
+  QString binary;
+
+  {
+    std::scoped_lock lock(g_state.mutex);
+
+    if (g_state.waitingPID == 0 || g_state.waitingPID == pid) {
+      return;
+    }
+
+    d = Clock::now() - g_state.waitingStart;
+    g_state.waitingPID = 0;
+
+    if (!g_state.history.empty()) {
+      g_state.history.back().firstProcess = d;
+      binary = g_state.history.back().binary;
+    }
+  }
+
+  log::debug(
+    "launch of '{}': first process {} started after {} ms",
+    binary, pid, ms(d));
+
+  Metrics::duration("launch.first process", d);
+
+  notifyChanged();
+}
+
+std::vector<LaunchTimeline::Launch> LaunchTimeline::history()
+{
+  std::scoped_lock lock(g_state.mutex);
+  return {g_state.history.begin(), g_state.history.end()};
+}
+
+void LaunchTimeline::setChangedCallback(std::function<void ()> f)
+{
+  std::scoped_lock lock(g_state.mutex);
+  g_state.changed = std::move(f);
+}
+
+QString LaunchTimeline::toString(const Launch& l)
+{
+  QStringList sl;
+
+  sl.push_back(QObject::tr("Launch of %1 at %2 took %3 ms")
+    .arg(l.binary)
+    .arg(l.time.toString(Qt::DefaultLocaleShortDate))
+    .arg(ms(l.total)));
+
+  const int longest = l.longest();
+
+  for (int i=0; i<static_cast<int>(l.stages.size()); ++i) {
+    const auto& [name, d] = l.stages[i];
+
+    QString s = QObject::tr("  %1: %2 ms").arg(name).arg(ms(d));
+    if (i == longest) {
+      s += QObject::tr(" (longest)");
+    }
+
+    sl.push_back(s);
+  }
+
+  if (l.firstProcess) {
+    sl.push_back(QObject::tr("  first process started after %1 ms")
+      .arg(ms(*l.firstProcess)));
+  }
+
+  return sl.join("\n");
+}
@@ -0,0 +1,108 @@
+#ifndef MODORGANIZER_LAUNCHTIMELINE_INCLUDED
+#define MODORGANIZER_LAUNCHTIMELINE_INCLUDED
+
+#include <QDateTime>
+#include <QString>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// durations of the stages of starting a program from MO, from saving the
+// lists to the process being created, followed by the time until the program
+// started its first child process, which is usually when a launcher starts
+// the game
+//
+// a launch is timed by a Scope in ProcessRunner and the stages by Stage
+// objects wherever the work is done, Stage does nothing when no launch is
+// being timed; once the process is created, the stages are logged and
+// recorded in Metrics, and the launch is added to history()
+//
+// processStarted() can be called from any thread, everything else must be
+// called on the ui thread
+//
+class LaunchTimeline
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Launch
+  {
+    QDateTime time;
+    QString binary;
+
+    // stages in the order they ran, time that wasn't in any stage is not
+    // included
+    std::vector<std::pair<QString, std::chrono::nanoseconds>> stages;
+
+    // until the process was created
+    std::chrono::nanoseconds total{0};
+
+    // from the start of the launch until the program started another process,
+    // empty if it hasn't yet or never did
+    std::optional<std::chrono::nanoseconds> firstProcess;
+
+    // longest stage, -1 if there are none
+    int longest() const;
+  };
+
+  // times a launch for its lifetime, the launch is only recorded if started()
+  // is called; launches can't overlap
+  //
+  class Scope
+  {
+  public:
+    Scope(QString binary);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    // the process was created, records the launch and waits for the process
+    // to start another one
+    //
+    void started(unsigned long pid);
+  };
+
+  // times a stage of the launch being timed for its lifetime
+  //
+  class Stage
+  {
+  public:
+    Stage(QString name);
+    ~Stage();
+
+    Stage(const Stage&) = delete;
+    Stage& operator=(const Stage&) = delete;
+
+    // ends the stage, does nothing if it already ended
+    //
+    void stop();
+
+  private:
+    QString m_name;
+    Clock::time_point m_start;
+    bool m_running;
+  };
+
+  // a process was added to the job of a program that's being waited on; the
+  // first one that isn't the program itself ends the launch that's waiting
+  //
+  static void processStarted(unsigned long pid);
+
+  // the last launches, the most recent last
+  //
+  static std::vector<Launch> history();
+
+  // called on the ui thread when a launch is added to the history or when its
+  // first process is known
+  //
+  static void setChangedCallback(std::function<void ()> f);
+
+  // one line per stage, with the longest one marked
+  //
+  static QString toString(const Launch& l);
+};
+
+#endif // MODORGANIZER_LAUNCHTIMELINE_INCLUDED
@@ -27,13 +27,18 @@ using namespace MOBase;
 static LogModel* g_instance = nullptr;
 const std::size_t MaxLines = 1000;
 
+// delay before pending entries are added to the model
+const std::chrono::milliseconds FlushDelay(100);
+
 static std::unique_ptr<env::Console> m_console;
 static bool m_stdout = false;
 static std::mutex m_stdoutMutex;
 
 
 LogModel::LogModel()
+  : m_first(0), m_count(0), m_flushQueued(false)
 {
+  m_entries.resize(MaxLines);
 }
 
 void LogModel::create()
@@ -48,53 +53,109 @@ LogModel& LogModel::instance()
 
 void LogModel::add(MOBase::log::Entry e)
 {
-  QMetaObject::invokeMethod(
-    this, [this, e]{ onEntryAdded(std::move(e)); }, Qt::QueuedConnection);
-}
+  bool queue = false;
 
-QString LogModel::formattedMessage(const QModelIndex& index) const
-{
-  if (!index.isValid()) {
-    return "";
+  {
+    std::scoped_lock lock(m_pendingMutex);
+
+    if (m_pending.size() >= MaxLines) {
+      // only the last entries are kept anyway
+      m_pending.pop_front();
+    }
+
+    m_pending.emplace_back(std::move(e));
+
+    if (!m_flushQueued) {
+      m_flushQueued = true;
+      queue = true;
+    }
+  }
+
+  if (queue) {
+    queueFlush();
   }
-  return QString::fromStdString(m_entries[index.row()].formattedMessage);
 }
 
-void LogModel::clear()
+void LogModel::queueFlush()
 {
-  beginResetModel();
-  m_entries.clear();
-  endResetModel();
+  QMetaObject::invokeMethod(this, [this]{
+    QTimer::singleShot(FlushDelay, this, [this]{ flush(); });
+  }, Qt::QueuedConnection);
 }
 
-const std::deque<MOBase::log::Entry>& LogModel::entries() const
+void LogModel::flush()
 {
-  return m_entries;
+  std::deque<MOBase::log::Entry> pending;
+
+  {
+    std::scoped_lock lock(m_pendingMutex);
+    pending.swap(m_pending);
+    m_flushQueued = false;
+  }
+
+  if (pending.empty()) {
+    return;
+  }
+
+  // entries that fall off the front of the buffer
+  const std::size_t overflow =
+    std::min(m_count, (m_count + pending.size()) > MaxLines ?
+      (m_count + pending.size() - MaxLines) : 0);
+
+  if (overflow > 0) {
+    beginRemoveRows(QModelIndex(), 0, static_cast<int>(overflow - 1));
+    m_first = (m_first + overflow) % MaxLines;
+    m_count -= overflow;
+    endRemoveRows();
+  }
+
+  const int row = static_cast<int>(m_count);
+  beginInsertRows(QModelIndex(), row, row + static_cast<int>(pending.size()) - 1);
+
+  for (auto&& e : pending) {
+    m_entries[(m_first + m_count) % MaxLines] = std::move(e);
+    ++m_count;
+  }
+
+  endInsertRows();
 }
 
-void LogModel::onEntryAdded(MOBase::log::Entry e)
+QString LogModel::formattedMessage(const QModelIndex& index) const
 {
-  bool full = false;
-  if (m_entries.size() > MaxLines) {
-    m_entries.pop_front();
-    full = true;
+  if (!index.isValid() || static_cast<std::size_t>(index.row()) >= m_count) {
+    return "";
   }
 
-  const int row = static_cast<int>(m_entries.size());
+  return QString::fromStdString(entry(index.row()).formattedMessage);
+}
 
-  if (!full) {
-    beginInsertRows(QModelIndex(), row, row + 1);
+void LogModel::clear()
+{
+  {
+    std::scoped_lock lock(m_pendingMutex);
+    m_pending.clear();
   }
 
-  m_entries.emplace_back(std::move(e));
+  beginResetModel();
 
-  if (!full) {
-    endInsertRows();
-  } else {
-    emit dataChanged(
-      createIndex(row, 0),
-      createIndex(row + 1, columnCount({})));
+  for (std::size_t i=0; i<m_count; ++i) {
+    m_entries[(m_first + i) % MaxLines] = {};
   }
+
+  m_first = 0;
+  m_count = 0;
+
+  endResetModel();
+}
+
+std::size_t LogModel::size() const
+{
+  return m_count;
+}
+
+const MOBase::log::Entry& LogModel::entry(std::size_t row) const
+{
+  return m_entries[(m_first + row) % MaxLines];
 }
 
 QModelIndex LogModel::index(int row, int column, const QModelIndex&) const
@@ -112,7 +173,7 @@ int LogModel::rowCount(const QModelIndex& parent) const
   if (parent.isValid())
     return 0;
   else
-    return static_cast<int>(m_entries.size());
+    return static_cast<int>(m_count);
 }
 
 int LogModel::columnCount(const QModelIndex&) const
@@ -125,11 +186,11 @@ QVariant LogModel::data(const QModelIndex& index, int role) const
   using namespace std::chrono;
 
   const auto row = static_cast<std::size_t>(index.row());
-  if (row >= m_entries.size()) {
+  if (row >= m_count) {
     return {};
   }
 
-  const auto& e = m_entries[row];
+  const auto& e = entry(row);
 
   if (role == Qt::DisplayRole) {
     if (index.column() == 0) {
@@ -193,7 +254,6 @@ LogList::LogList(QWidget* parent)
     [&](auto&& pos){ onContextMenu(pos); });
 
   connect(model(), &LogModel::rowsInserted, this, [&]{ onNewEntry(); });
-  connect(model(), &LogModel::dataChanged, this, [&]{ onNewEntry(); });
 
   m_timer.setSingleShot(true);
   connect(&m_timer, &QTimer::timeout, [&]{ scrollToBottom(); });
@@ -213,10 +273,11 @@ void LogList::setCore(OrganizerCore& core)
 
 void LogList::copyToClipboard()
 {
+  const auto& m = LogModel::instance();
   std::string s;
 
-  for (const auto& e : LogModel::instance().entries()) {
-    s += e.formattedMessage + "\n";
+  for (std::size_t i=0; i<m.size(); ++i) {
+    s += m.entry(i).formattedMessage + "\n";
   }
 
   if (!s.empty()) {
@@ -357,7 +418,7 @@ void initLogging()
   log::createDefault(conf);
 
   log::getDefault().setCallback(
-    [](log::Entry e){ LogModel::instance().add(e); });
+    [](log::Entry e){ LogModel::instance().add(std::move(e)); });
 
   qInstallMessageHandler(qtLogCallback);
 }
@@ -26,9 +26,17 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <log.h>
 #include <QTreeView>
 #include <deque>
+#include <mutex>
+#include <vector>
 
 class OrganizerCore;
 
+// keeps the last entries of the log in a ring buffer
+//
+// entries can be added from any thread, they're queued and added to the
+// model in batches at most every 100ms so a flood of debug logging doesn't
+// update the view for every line
+//
 class LogModel : public QAbstractItemModel
 {
   Q_OBJECT
@@ -37,10 +45,18 @@ public:
   static void create();
   static LogModel& instance();
 
+  // queues the entry, can be called from any thread
+  //
   void add(MOBase::log::Entry e);
   void clear();
 
-  const std::deque<MOBase::log::Entry>& entries() const;
+  // number of entries in the model, not counting queued ones
+  //
+  std::size_t size() const;
+
+  // entry at the given row, oldest first
+  //
+  const MOBase::log::Entry& entry(std::size_t row) const;
 
   QString formattedMessage(const QModelIndex& index) const;
 
@@ -55,10 +71,26 @@ protected:
     int section, Qt::Orientation ori, int role=Qt::DisplayRole) const override;
 
 private:
-  std::deque<MOBase::log::Entry> m_entries;
+  // ring buffer, m_first is the index of the oldest entry and there are
+  // m_count entries
+  std::vector<MOBase::log::Entry> m_entries;
+  std::size_t m_first;
+  std::size_t m_count;
+
+  // entries waiting to be added, and whether a flush has been scheduled
+  std::deque<MOBase::log::Entry> m_pending;
+  bool m_flushQueued;
+  std::mutex m_pendingMutex;
 
   LogModel();
-  void onEntryAdded(MOBase::log::Entry e);
+
+  // schedules a flush on the ui thread
+  //
+  void queueFlush();
+
+  // adds the pending entries to the model, called on the ui thread
+  //
+  void flush();
 };
 
 
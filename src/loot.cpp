@@ -5,6 +5,7 @@
 #include "json.h"
 #include <log.h>
 #include <report.h>
+#include <QEventLoop>
 
 using namespace MOBase;
 using namespace json;
@@ -207,6 +208,154 @@ private:
 
 
 
+// splits the json report from lootcli as it's being read, without building
+// a document for the whole thing
+//
+// the report is an object; every member except "plugins" is given to
+// onValue() once it's complete and every element of "plugins" is given to
+// onPlugin() as soon as its closing brace is read, so only one plugin is ever
+// in memory
+//
+// this only tracks strings and nesting, the slices it gives out are parsed by
+// QJsonDocument, which reports any error
+//
+class ReportReader
+{
+public:
+  std::function<void (const QByteArray& key, const QByteArray& value)> onValue;
+  std::function<void (const QByteArray& plugin)> onPlugin;
+
+  void feed(const char* p, std::size_t n)
+  {
+    for (std::size_t i=0; i<n; ++i) {
+      feed(p[i]);
+    }
+  }
+
+  // whether the root object has been closed
+  //
+  bool finished() const
+  {
+    return m_started && m_depth == 0;
+  }
+
+private:
+  int m_depth = 0;
+  bool m_started = false;
+  bool m_inString = false;
+  bool m_escape = false;
+
+  // the root object is at depth 1, this is set between the colon and the
+  // comma or closing brace of a member
+  bool m_inValue = false;
+  bool m_readingKey = false;
+  QByteArray m_key;
+
+  // set while inside the "plugins" array, and then inside one of its elements
+  bool m_inPlugins = false;
+  bool m_inElement = false;
+
+  QByteArray m_buffer;
+
+  void feed(char c)
+  {
+    if (m_inString) {
+      if (capturing()) {
+        m_buffer.append(c);
+      }
+
+      if (m_escape) {
+        m_escape = false;
+      } else if (c == '\\') {
+        m_escape = true;
+      } else if (c == '"') {
+        m_inString = false;
+        m_readingKey = false;
+      } else if (m_readingKey) {
+        m_key.append(c);
+      }
+
+      return;
+    }
+
+    if (m_depth == 0) {
+      if (c == '{' && !m_started) {
+        m_depth = 1;
+        m_started = true;
+      }
+
+      return;
+    }
+
+    if (m_depth == 1 && !m_inValue) {
+      // between the members of the root object
+      if (c == '"') {
+        m_inString = true;
+        m_readingKey = true;
+        m_key.clear();
+      } else if (c == ':') {
+        m_inValue = true;
+        m_inPlugins = (m_key == "plugins");
+        m_buffer.clear();
+      } else if (c == '}') {
+        m_depth = 0;
+      }
+
+      return;
+    }
+
+    if (m_depth == 1 && (c == ',' || c == '}')) {
+      // end of a member
+      if (!m_inPlugins && onValue) {
+        onValue(m_key, m_buffer.trimmed());
+      }
+
+      m_inValue = false;
+      m_inPlugins = false;
+      m_buffer.clear();
+
+      if (c == '}') {
+        m_depth = 0;
+      }
+
+      return;
+    }
+
+    if (m_inPlugins && m_depth == 2 && c == '{') {
+      m_inElement = true;
+      m_buffer.clear();
+    }
+
+    if (capturing()) {
+      m_buffer.append(c);
+    }
+
+    if (c == '"') {
+      m_inString = true;
+    } else if (c == '{' || c == '[') {
+      ++m_depth;
+    } else if (c == '}' || c == ']') {
+      --m_depth;
+
+      if (m_inElement && m_depth == 2) {
+        if (onPlugin) {
+          onPlugin(m_buffer);
+        }
+
+        m_inElement = false;
+        m_buffer.clear();
+      }
+    }
+  }
+
+  bool capturing() const
+  {
+    return (m_inValue && !m_inPlugins) || m_inElement;
+  }
+};
+
+
+
 log::Levels levelFromLoot(lootcli::LogLevels level)
 {
   using LC = lootcli::LogLevels;
@@ -656,14 +805,14 @@ void Loot::processStdout(const std::string &lootOut)
     const std::string_view line(m_outputBuffer.c_str() + start, newline - start);
     const auto m = lootcli::parseMessage(line);
 
+    start = newline + 1;
+
     if (m.type == lootcli::MessageType::None) {
       log::error("unrecognised loot output: '{}'", line);
       continue;
     }
 
     processMessage(m);
-
-    start = newline + 1;
   }
 
   m_outputBuffer.erase(0, start);
@@ -738,43 +887,86 @@ void Loot::processOutputFile(Report& r) const
     return;
   }
 
-  QJsonParseError e;
-  const QJsonDocument doc = QJsonDocument::fromJson(outFile.readAll(), &e);
-  if (doc.isNull()) {
-    emit log(
-      MOBase::log::Error,
-      QString("invalid json, %1 (error %2)")
-        .arg(e.errorString()).arg(e.error));
+  // plugins are handed out in batches as they're parsed
+  const std::size_t batchSize = 100;
+  std::vector<Plugin> batch;
+  bool failed = false;
 
-    return;
-  }
+  auto parse = [&](const QByteArray& what, const QByteArray& json) {
+    QJsonParseError e;
 
-  requireObject(doc, "root");
+    // wrapped in an array because the value can be of any type
+    const QJsonDocument doc = QJsonDocument::fromJson("[" + json + "]", &e);
 
-  const QJsonObject object = doc.object();
+    if (doc.isNull()) {
+      emit log(
+        MOBase::log::Error,
+        QString("invalid json in '%1', %2 (error %3)")
+          .arg(QString::fromUtf8(what)).arg(e.errorString()).arg(e.error));
 
-  r.messages = reportMessages(getOpt<QJsonArray>(object, "messages"));
-  r.plugins = reportPlugins(getOpt<QJsonArray>(object, "plugins"));
-  r.stats = reportStats(getWarn<QJsonObject>(object, "stats"));
-}
+      failed = true;
+      return QJsonValue();
+    }
 
-std::vector<Loot::Plugin> Loot::reportPlugins(const QJsonArray& plugins) const
-{
-  std::vector<Loot::Plugin> v;
+    return doc.array().at(0);
+  };
+
+  bool hasStats = false;
+
+  ReportReader reader;
+
+  reader.onValue = [&](const QByteArray& key, const QByteArray& value) {
+    if (key == "messages") {
+      r.messages = reportMessages(
+        convertWarn<QJsonArray>(parse(key, value), "messages"));
+    } else if (key == "stats") {
+      r.stats = reportStats(convertWarn<QJsonObject>(parse(key, value), "stats"));
+      hasStats = true;
+    }
+  };
 
-  for (auto pluginValue : plugins) {
-    const auto o = convertWarn<QJsonObject>(pluginValue, "plugin");
+  reader.onPlugin = [&](const QByteArray& json) {
+    const auto o = convertWarn<QJsonObject>(parse("plugin", json), "plugin");
     if (o.isEmpty()) {
-      continue;
+      return;
     }
 
     auto p = reportPlugin(o);
-    if (!p.name.isEmpty()) {
-      v.emplace_back(std::move(p));
+    if (p.name.isEmpty()) {
+      return;
+    }
+
+    r.plugins.push_back(p);
+    batch.emplace_back(std::move(p));
+
+    if (batch.size() >= batchSize) {
+      emit pluginsReported(std::move(batch));
+      batch = {};
     }
+  };
+
+  std::vector<char> buffer(64 * 1024);
+
+  while (!failed && !reader.finished()) {
+    const auto n = outFile.read(buffer.data(), buffer.size());
+    if (n <= 0) {
+      break;
+    }
+
+    reader.feed(buffer.data(), static_cast<std::size_t>(n));
   }
 
-  return v;
+  if (!batch.empty()) {
+    emit pluginsReported(std::move(batch));
+  }
+
+  if (!failed && !reader.finished()) {
+    emit log(MOBase::log::Error, QString("invalid json, unexpected end of file"));
+  }
+
+  if (!hasStats) {
+    log::warn("property '{}' is missing", "stats");
+  }
 }
 
 Loot::Plugin Loot::reportPlugin(const QJsonObject& plugin) const
@@ -950,3 +1142,45 @@ bool runLoot(QWidget* parent, OrganizerCore& core, bool didUpdateMasterList)
     return false;
   }
 }
+
+bool runLootHeadless(OrganizerCore& core, bool didUpdateMasterList)
+{
+  core.savePluginList();
+
+  try {
+    Loot loot(core);
+    QEventLoop events;
+
+    // finished is emitted from the loot thread
+    QObject::connect(
+      &loot, &Loot::finished, &events, &QEventLoop::quit, Qt::QueuedConnection);
+
+    QObject::connect(&loot, &Loot::log, [](log::Levels lv, const QString& s) {
+      if (lv >= log::Levels::Warning) {
+        log::log(lv, "{}", s);
+      }
+    });
+
+    if (!loot.start(nullptr, didUpdateMasterList)) {
+      return false;
+    }
+
+    events.exec();
+
+    for (auto&& e : loot.errors()) {
+      log::error("loot: {}", e);
+    }
+
+    for (auto&& w : loot.warnings()) {
+      log::warn("loot: {}", w);
+    }
+
+    return loot.result();
+  } catch (const UsvfsConnectorException &e) {
+    log::debug("{}", e.what());
+    return false;
+  } catch (const std::exception &e) {
+    log::error("failed to run loot: {}", e.what());
+    return false;
+  }
+}
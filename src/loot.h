@@ -101,6 +101,11 @@ signals:
   void output(const QString& s);
   void progress(const lootcli::Progress p);
   void log(MOBase::log::Levels level, const QString& s) const;
+
+  // emitted from the loot thread while the report is being parsed, the
+  // plugins are also in report() once it's finished
+  void pluginsReported(std::vector<Loot::Plugin> plugins) const;
+
   void finished();
 
 private:
@@ -128,7 +133,6 @@ private:
   void deleteReportFile();
 
   Message reportMessage(const QJsonObject& message) const;
-  std::vector<Plugin> reportPlugins(const QJsonArray& plugins) const;
   Loot::Plugin reportPlugin(const QJsonObject& plugin) const;
   Loot::Stats reportStats(const QJsonObject& stats) const;
 
@@ -139,6 +143,14 @@ private:
 };
 
 
+Q_DECLARE_METATYPE(std::vector<Loot::Plugin>);
+
+
 bool runLoot(QWidget* parent, OrganizerCore& core, bool didUpdateMasterList);
 
+// same as runLoot(), but without the dialog: processes events until loot is
+// done and logs its errors and warnings instead of showing the report
+//
+bool runLootHeadless(OrganizerCore& core, bool didUpdateMasterList);
+
 #endif // MODORGANIZER_LOOT_H
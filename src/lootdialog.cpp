@@ -66,7 +66,7 @@ bool MarkdownPage::acceptNavigationRequest(const QUrl &url, NavigationType, bool
 
 LootDialog::LootDialog(QWidget* parent, OrganizerCore& core, Loot& loot) :
   QDialog(parent, Qt::WindowMaximizeButtonHint), ui(new Ui::LootDialog), m_core(core), m_loot(loot),
-  m_finished(false), m_cancelling(false)
+  m_finished(false), m_cancelling(false), m_pluginsCleared(false)
 {
   createUI();
 
@@ -82,6 +82,10 @@ LootDialog::LootDialog(QWidget* parent, OrganizerCore& core, Loot& loot) :
     &m_loot, &Loot::log, this,
     [&](auto&& lv, auto&& s){ log(lv, s); }, Qt::QueuedConnection);
 
+  QObject::connect(
+    &m_loot, &Loot::pluginsReported, this,
+    [&](auto&& v){ addPlugins(v); }, Qt::QueuedConnection);
+
   QObject::connect(
     &m_loot, &Loot::finished, this,
     [&]{ onFinished(); }, Qt::QueuedConnection);
@@ -269,15 +273,26 @@ void LootDialog::log(log::Levels lv, const QString& s)
   }
 }
 
+void LootDialog::addPlugins(const std::vector<Loot::Plugin>& plugins)
+{
+  if (!m_pluginsCleared) {
+    m_core.pluginList()->clearAdditionalInformation();
+    m_pluginsCleared = true;
+  }
+
+  for (auto&& p : plugins) {
+    m_core.pluginList()->addLootReport(p.name, p);
+  }
+}
+
 void LootDialog::showReport()
 {
   const auto& lootReport = m_loot.report();
 
-  if (m_loot.result()) {
+  if (m_loot.result() && !m_pluginsCleared) {
+    // no plugins were reported, but what was there before is still stale
     m_core.pluginList()->clearAdditionalInformation();
-    for (auto&& p : lootReport.plugins) {
-      m_core.pluginList()->addLootReport(p.name, p);
-    }
+    m_pluginsCleared = true;
   }
 
   m_report.setText(lootReport.toMarkdown());
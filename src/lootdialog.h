@@ -1,6 +1,7 @@
 #ifndef MODORGANIZER_LOOTDIALOG_H
 #define MODORGANIZER_LOOTDIALOG_H
 
+#include "loot.h"
 #include <lootcli/lootcli.h>
 #include <log.h>
 #include <expanderwidget.h>
@@ -8,7 +9,6 @@
 namespace Ui { class LootDialog; }
 
 class OrganizerCore;
-class Loot;
 
 
 class MarkdownDocument : public QObject
@@ -66,12 +66,18 @@ private:
   Loot& m_loot;
   bool m_finished;
   bool m_cancelling;
+
+  // whether the plugin list was cleared of previous loot reports, done when
+  // the first plugins are reported
+  bool m_pluginsCleared;
+
   MarkdownDocument m_report;
 
   void createUI();
   void closeEvent(QCloseEvent* e) override;
   void addLineOutput(const QString& line);
   void onFinished();
+  void addPlugins(const std::vector<Loot::Plugin>& plugins);
   void log(MOBase::log::Levels lv, const QString& s);
   void showReport();
 };
@@ -1,10 +1,13 @@
 #include "multiprocess.h"
+#include "metrics.h"
 #include "loglist.h"
 #include "moapplication.h"
 #include "organizercore.h"
 #include "commandline.h"
 #include "env.h"
 #include "instancemanager.h"
+#include "startuptrace.h"
+#include "browsercache.h"
 #include "thread_utils.h"
 #include "shared/util.h"
 #include <report.h>
@@ -28,18 +31,31 @@ int run(int argc, char *argv[])
 {
   MOShared::SetThisThreadName("main");
   setExceptionHandlers();
+  StartupTrace::begin();
 
   cl::CommandLine cl;
   if (auto r=cl.process(GetCommandLineW())) {
     return *r;
   }
 
+  // links and shortcuts are handed to the running instance before logging
+  // and the application are set up, so it reacts right away; if there's no
+  // running instance, this goes on normally
+  if (auto m=cl.earlyForward()) {
+    if (MOMultiProcess::forwardEarly(*m)) {
+      return 0;
+    }
+  }
+
+  StartupTrace::setExitWhenFinished(cl.startupProfile());
+
   initLogging();
 
   // must be after logging
-  TimeThis tt("main() multiprocess");
+  Metrics::Timer tt("main() multiprocess");
 
   QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+  BrowserCache::registerScheme();
   MOApplication app(argc, argv);
 
 
@@ -112,6 +128,7 @@ int run(int argc, char *argv[])
           // don't reprocess command line
           cl.clear();
 
+          StartupTrace::begin();
           continue;
         } else if (r != 0) {
           // something failed, quit
@@ -137,6 +154,7 @@ int run(int argc, char *argv[])
         // don't reprocess command line
         cl.clear();
 
+        StartupTrace::begin();
         continue;
       }
 
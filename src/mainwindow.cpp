@@ -18,6 +18,9 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "mainwindow.h"
+#include "metrics.h"
+#include "launchtimeline.h"
+#include "archiveextraction.h"
 #include "ui_mainwindow.h"
 
 #include "executableinfo.h"
@@ -57,6 +60,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "browserdialog.h"
 #include "aboutdialog.h"
 #include "settingsdialog.h"
+#include "refreshtrace.h"
 #include <safewritefile.h>
 #include "nxmaccessmanager.h"
 #include "shared/appconfig.h"
@@ -66,6 +70,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "datatab.h"
 #include "downloadstab.h"
 #include "savestab.h"
+#include "updatescheduler.h"
 #include "instancemanagerdialog.h"
 #include <utility.h>
 #include <dataarchives.h>
@@ -84,6 +89,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "shared/directoryentry.h"
 #include "shared/fileentry.h"
 #include "shared/filesorigin.h"
+#include "shared/util.h"
 
 #include <QAbstractItemDelegate>
 #include <QAction>
@@ -275,7 +281,7 @@ MainWindow::MainWindow(Settings &settings
 
   ui->setupUi(this);
   languageChange(settings.interface().language());
-  ui->statusBar->setup(ui, settings);
+  ui->statusBar->setup(ui, m_OrganizerCore);
 
   {
     auto& ni = NexusInterface::instance();
@@ -336,6 +342,8 @@ MainWindow::MainWindow(Settings &settings
 
   connect(m_DataTab.get(), &DataTab::executablesChanged, [&]{ refreshExecutablesList(); });
 
+  LaunchTimeline::setChangedCallback([&]{ updateStartButtonTooltip(); });
+
   connect(
     m_DataTab.get(), &DataTab::originModified,
     [&](int id){ originModified(id); });
@@ -351,6 +359,8 @@ MainWindow::MainWindow(Settings &settings
   // saves tab
   m_SavesTab.reset(new SavesTab(this, m_OrganizerCore, ui));
 
+  m_UpdateScheduler.reset(new UpdateScheduler(m_OrganizerCore, this));
+
   // Hide stuff we do not need:
   IPluginGame const* game = m_OrganizerCore.managedGame();
   if (!game->feature<GamePlugins>()) {
@@ -455,6 +465,10 @@ MainWindow::MainWindow(Settings &settings
   connect(&m_UpdateProblemsTimer, &QTimer::timeout, this, &MainWindow::checkForProblemsAsync);
   connect(this, &MainWindow::checkForProblemsDone, this, &MainWindow::updateProblemsButton, Qt::ConnectionType::QueuedConnection);
 
+  connect(
+    &m_ExecutableIconsTimer, &QTimer::timeout,
+    [&]{ updateExecutableIcons(); });
+
   m_SaveMetaTimer.setSingleShot(false);
   connect(&m_SaveMetaTimer, SIGNAL(timeout()), this, SLOT(saveModMetas()));
   m_SaveMetaTimer.start(5000);
@@ -520,7 +534,10 @@ void MainWindow::setupModList()
 {
   ui->modList->setup(m_OrganizerCore, m_CategoryFactory, this, ui);
 
-  connect(&ui->modList->actions(), &ModListViewActions::overwriteCleared, [=]() { scheduleCheckForProblems(); });
+  connect(&ui->modList->actions(), &ModListViewActions::overwriteCleared, [=]() {
+    m_PluginContainer.invalidateProblems(PluginContainer::DiagnoseEvent::Refreshed);
+    scheduleCheckForProblems();
+  });
   connect(&ui->modList->actions(), &ModListViewActions::originModified, this, &MainWindow::originModified);
   connect(m_OrganizerCore.modList(), &ModList::modPrioritiesChanged, [&]() { m_ArchiveListWriter.write(); });
 }
@@ -597,6 +614,7 @@ MainWindow::~MainWindow()
   try {
     cleanup();
 
+    LaunchTimeline::setChangedCallback({});
     m_OrganizerCore.setUserInterface(nullptr);
 
     if (m_IntegratedBrowser) {
@@ -735,11 +753,12 @@ void MainWindow::updatePinnedExecutables()
     if (!exe.hide() && exe.isShownOnToolbar()) {
       hasLinks = true;
 
-      QAction *exeAction = new QAction(
-        iconForExecutable(exe.binaryInfo().filePath()), exe.title());
+      const auto path = exe.binaryInfo().filePath();
+      QAction *exeAction = new QAction(executableIcon(path), exe.title());
 
       exeAction->setObjectName(QString("custom__") + exe.title());
-      exeAction->setStatusTip(exe.binaryInfo().filePath());
+      exeAction->setStatusTip(path);
+      exeAction->setData(path);
 
       if (!connect(exeAction, SIGNAL(triggered()), this, SLOT(startExeAction()))) {
         log::debug("failed to connect trigger?");
@@ -994,14 +1013,15 @@ void MainWindow::checkForProblemsImpl()
   // another thread might already have checked while this one was waiting on the lock
   if (m_ProblemsCheckRequired) {
     m_ProblemsCheckRequired = false;
-    TimeThis tt("MainWindow::checkForProblemsImpl()");
+    Metrics::Timer tt("MainWindow::checkForProblemsImpl()");
     size_t numProblems = 0;
     for (QObject *pluginObj : m_PluginContainer.plugins<QObject>()) {
       IPlugin *plugin = qobject_cast<IPlugin*>(pluginObj);
       if (plugin == nullptr || m_PluginContainer.isEnabled(plugin)) {
         IPluginDiagnose *diagnose = qobject_cast<IPluginDiagnose*>(pluginObj);
-        if (diagnose != nullptr)
-          numProblems += diagnose->activeProblems().size();
+        if (diagnose != nullptr) {
+          numProblems += m_PluginContainer.problems(diagnose).size();
+        }
       }
     }
     m_NumberOfProblems = numProblems;
@@ -1337,7 +1357,7 @@ void MainWindow::cleanup()
   }
 
   m_SaveMetaTimer.stop();
-  m_MetaSave.waitForFinished();
+  m_MetaSave.wait();
 }
 
 bool MainWindow::eventFilter(QObject *object, QEvent *event)
@@ -1657,11 +1677,14 @@ void MainWindow::refreshExecutablesList()
 
   auto add = [&](const QString& title, const QFileInfo& binary) {
     QIcon icon;
+    QString path;
+
     if (!binary.fileName().isEmpty()) {
-      icon = iconForExecutable(binary.filePath());
+      path = binary.filePath();
+      icon = executableIcon(path);
     }
 
-    ui->executablesListBox->addItem(icon, title);
+    ui->executablesListBox->addItem(icon, title, path);
 
     const auto i = ui->executablesListBox->count() - 1;
 
@@ -1693,6 +1716,67 @@ void MainWindow::refreshExecutablesList()
   ui->executablesListBox->setEnabled(true);
 }
 
+QIcon MainWindow::executableIcon(const QString& path)
+{
+  const auto v = m_ExecutableIcons.icon(path);
+  if (!v.isNull()) {
+    return v.value<QPixmap>();
+  }
+
+  m_ExecutableIconsPending.insert(path);
+
+  if (!m_ExecutableIconsTimer.isActive()) {
+    m_ExecutableIconsTimer.start(std::chrono::milliseconds(100));
+  }
+
+  return m_ExecutableIcons.genericFileIcon();
+}
+
+void MainWindow::updateExecutableIcons()
+{
+  std::map<QString, QIcon> done;
+
+  auto itor = m_ExecutableIconsPending.begin();
+
+  while (itor != m_ExecutableIconsPending.end()) {
+    const auto v = m_ExecutableIcons.icon(*itor);
+
+    if (v.isNull()) {
+      ++itor;
+    } else {
+      done.emplace(*itor, v.value<QPixmap>());
+      itor = m_ExecutableIconsPending.erase(itor);
+    }
+  }
+
+  if (m_ExecutableIconsPending.empty()) {
+    m_ExecutableIconsTimer.stop();
+  }
+
+  if (done.empty()) {
+    return;
+  }
+
+  // the toolbar actions are also in the run menu
+  for (auto* a : ui->toolBar->actions()) {
+    if (a->objectName().startsWith("custom__")) {
+      auto itor = done.find(a->data().toString());
+      if (itor != done.end()) {
+        a->setIcon(itor->second);
+      }
+    }
+  }
+
+  auto* list = ui->executablesListBox;
+
+  for (int i=0; i<list->count(); ++i) {
+    auto itor = done.find(list->itemData(i).toString());
+    if (itor != done.end()) {
+      list->setItemIcon(i, itor->second);
+    }
+  }
+}
+
 static bool BySortValue(const std::pair<UINT32, QTreeWidgetItem*> &LHS, const std::pair<UINT32, QTreeWidgetItem*> &RHS)
 {
   return LHS.first < RHS.first;
@@ -1736,7 +1820,7 @@ void MainWindow::updateBSAList(const QStringList &defaultArchives, const QString
   };
 
   for (FileEntryPtr current : files) {
-    QFileInfo fileInfo(ToQString(current->getName().c_str()));
+    QFileInfo fileInfo(ToQString(current->getName()));
 
     if (fileInfo.suffix().toLower() == "bsa" || fileInfo.suffix().toLower() == "ba2") {
       int index = activeArchives.indexOf(fileInfo.fileName());
@@ -1791,7 +1875,7 @@ void MainWindow::updateBSAList(const QStringList &defaultArchives, const QString
     const FilesOrigin& origin = m_OrganizerCore.directoryStructure()->getOriginByID(originID);
 
     QString modName;
-    const unsigned int modIndex = ModInfo::getIndex(ToQString(origin.getName()));
+    const unsigned int modIndex = ModInfo::getIndex(origin);
 
     if (modIndex == UINT_MAX) {
       modName = UnmanagedModName();
@@ -1860,8 +1944,8 @@ void MainWindow::checkBSAList()
 
 void MainWindow::saveModMetas()
 {
-  if (m_MetaSave.isFinished()) {
-    m_MetaSave = QtConcurrent::run([this]() {
+  if (m_MetaSave.finished()) {
+    m_MetaSave.run([this]() {
       for (unsigned int i = 0; i < ModInfo::getNumMods(); ++i) {
         ModInfo::Ptr modInfo = ModInfo::getByIndex(i);
         modInfo->saveMeta();
@@ -2058,6 +2142,40 @@ void MainWindow::on_startButton_clicked()
     .run();
 }
 
+void MainWindow::updateStartButtonTooltip()
+{
+  // launches shown after the last one, with their total only
+  const int MaxPrevious = 5;
+
+  const auto history = LaunchTimeline::history();
+
+  QString s = tr("Run program");
+
+  if (!history.empty()) {
+    s += "\n\n" + LaunchTimeline::toString(history.back());
+  }
+
+  if (history.size() > 1) {
+    s += "\n\n" + tr("Previous launches:");
+
+    const int first = std::max(0, static_cast<int>(history.size()) - 1 - MaxPrevious);
+
+    for (int i=static_cast<int>(history.size()) - 2; i>=first; --i) {
+      const auto& l = history[i];
+      const auto longest = l.longest();
+
+      s += "\n  " + tr("%1: %2 ms").arg(l.binary).arg(
+        std::chrono::duration_cast<std::chrono::milliseconds>(l.total).count());
+
+      if (longest >= 0) {
+        s += " " + tr("(longest: %1)").arg(l.stages[longest].first);
+      }
+    }
+  }
+
+  ui->startButton->setToolTip(s);
+}
+
 bool MainWindow::modifyExecutablesDialog(int selection)
 {
   bool result = false;
@@ -2191,20 +2309,49 @@ void MainWindow::on_actionModify_Executables_triggered()
 void MainWindow::refresherProgress(const DirectoryRefreshProgress* p)
 {
   if (p->finished()) {
-    setEnabled(true);
+    setStructureWidgetsEnabled(true);
     ui->statusBar->setProgress(100);
   } else {
-    setEnabled(false);
+    setStructureWidgetsEnabled(false);
     ui->statusBar->setProgress(p->percentDone());
   }
 }
 
+void MainWindow::setStructureWidgetsEnabled(bool enabled)
+{
+  // the mod list only needs the mods, which have been read before the
+  // structure is refreshed, so it stays usable; mods that are enabled or
+  // disabled are applied to the new structure once it's ready, see
+  // OrganizerCore::finishDirectoryRefresh()
+  //
+  // everything that needs the structure, or that would add or remove mods,
+  // such as dropping archives on the list, is disabled until the refresh is
+  // done
+  ui->menuBar->setEnabled(enabled);
+  ui->toolBar->setEnabled(enabled);
+  ui->profileBox->setEnabled(enabled);
+  ui->restoreModsButton->setEnabled(enabled);
+  ui->saveModsButton->setEnabled(enabled);
+  ui->startGroup->setEnabled(enabled);
+  ui->tabWidget->setEnabled(enabled);
+
+  ui->modList->setContextMenuPolicy(
+    enabled ? Qt::CustomContextMenu : Qt::NoContextMenu);
+  ui->modList->viewport()->setAcceptDrops(enabled);
+}
+
 void MainWindow::onDirectoryStructureChanged()
 {
   // some problem-reports may rely on the virtual directory tree so they need to be updated
   // now
+  m_PluginContainer.invalidateProblems(PluginContainer::DiagnoseEvent::Refreshed);
   scheduleCheckForProblems();
   m_DataTab->updateTree();
+
+  // the saves are only listed when their tab is shown; once startup is done,
+  // they're listed in the background so the tab opens with them, this only
+  // happens once
+  m_SavesTab->warm();
 }
 
 void MainWindow::modInstalled(const QString &modName)
@@ -2315,17 +2462,20 @@ void MainWindow::refreshProfile_activated()
 void MainWindow::saveArchiveList()
 {
   if (m_OrganizerCore.isArchivesInit()) {
-    SafeWriteFile archiveFile(m_OrganizerCore.currentProfile()->getArchivesFileName());
+    std::vector<QString> archives;
+
     for (int i = 0; i < ui->bsaList->topLevelItemCount(); ++i) {
       QTreeWidgetItem * tlItem = ui->bsaList->topLevelItem(i);
       for (int j = 0; j < tlItem->childCount(); ++j) {
         QTreeWidgetItem * item = tlItem->child(j);
         if (item->checkState(0) == Qt::Checked) {
-          archiveFile->write(item->text(0).toUtf8().append("\r\n"));
+          archives.push_back(item->text(0));
         }
       }
     }
-    archiveFile.commitIfDifferent(m_ArchiveListHash);
+
+    // only written if it changed, in the background
+    m_OrganizerCore.setEnabledArchives(std::move(archives));
   } else {
     log::debug("archive list not initialised");
   }
@@ -2511,6 +2661,7 @@ void MainWindow::on_actionSettings_triggered()
   instManager->setDownloadDirectory(settings.paths().downloads());
 
   // Schedule a problem check since diagnose plugins may have been enabled / disabled.
+  m_PluginContainer.invalidateProblems(PluginContainer::DiagnoseEvent::SettingsChanged);
   scheduleCheckForProblems();
 
   fixCategories();
@@ -2531,6 +2682,11 @@ void MainWindow::on_actionSettings_triggered()
     }
   }
 
+  dlManager->setLimits(
+    settings.network().maxDownloads(),
+    static_cast<qint64>(settings.network().maxDownloadSpeed()) * 1024,
+    static_cast<qint64>(settings.network().maxDownloadSpeedPerDownload()) * 1024);
+
   if ((settings.paths().mods() != oldModDirectory)
       || (settings.interface().displayForeign() != oldDisplayForeign)) {
     m_OrganizerCore.profileRefresh();
@@ -2565,6 +2721,7 @@ void MainWindow::on_actionSettings_triggered()
   m_DownloadsTab->update();
 
   m_OrganizerCore.setLogLevel(settings.diagnostics().logLevel());
+  RefreshTrace::setEnabled(settings.diagnostics().refreshInstrumentation());
 
   if (settings.diagnostics().maxCoreDumps() != oldMaxDumps) {
     m_OrganizerCore.cycleDiagnostics();
@@ -2778,10 +2935,18 @@ void MainWindow::nxmEndorsementsAvailable(QVariant userData, QVariant resultData
     if (gamePlugin != nullptr && gamePlugin->gameShortName().compare("SkyrimSE", Qt::CaseInsensitive) == 0)
       searchedMO2NexusGame = true;
     auto iter = sorted.equal_range(gamePlugin->gameNexusName());
+
+    // all the mods of the game are resolved at once
+    std::vector<std::pair<QString, int>> ids;
     for (auto result = iter.first; result != iter.second; ++result) {
-      std::vector<ModInfo::Ptr> modsList = ModInfo::getByModID(result->first, result->second.first);
+      ids.push_back({result->first, result->second.first});
+    }
+
+    const auto mods = ModInfo::getByModIDs(ids);
+    std::size_t i = 0;
 
-      for (auto mod : modsList) {
+    for (auto result = iter.first; result != iter.second; ++result, ++i) {
+      for (auto mod : mods[i]) {
         if (result->second.second == "Endorsed")
           mod->setIsEndorsed(true);
         else if (result->second.second == "Abstained")
@@ -2853,7 +3018,9 @@ void MainWindow::finishUpdateInfo()
     if (mod->canBeUpdated()) {
       organizedGames.insert(std::make_pair<QString, int>(mod->gameName().toLower(), mod->nexusId()));
     }
-    m_OrganizerCore.modList()->notifyChange(ModInfo::getIndex(mod->name()));
+
+    const int row = ModInfo::getIndex(mod->name());
+    m_OrganizerCore.modList()->notifyChange(row, row, {ModList::COL_VERSION});
   }
 
   if (!finalMods.empty() && organizedGames.empty())
@@ -2938,7 +3105,9 @@ void MainWindow::nxmUpdatesAvailable(QString gameName, int modID, QVariant userD
     if (foundUpdate) {
       // Just get the standard data updates for endorsements and descriptions
       mod->setLastNexusUpdate(QDateTime::currentDateTimeUtc());
-      m_OrganizerCore.modList()->notifyChange(ModInfo::getIndex(mod->name()));
+
+      const int row = ModInfo::getIndex(mod->name());
+      m_OrganizerCore.modList()->notifyChange(row, row, {ModList::COL_VERSION});
     } else {
       // Scrape mod data here so we can use the mod version if no file update was located
       requiresInfo = true;
@@ -2990,7 +3159,10 @@ void MainWindow::nxmModInfoAvailable(QString gameName, int modID, QVariant userD
     mod->saveMeta();
 
     if (foundUpdate) {
-      m_OrganizerCore.modList()->notifyChange(ModInfo::getIndex(mod->name()));
+      // the endorsement is shown in the flags
+      const int row = ModInfo::getIndex(mod->name());
+      m_OrganizerCore.modList()->notifyChange(
+        row, row, {ModList::COL_FLAGS, ModList::COL_VERSION});
     }
   }
 }
@@ -3045,25 +3217,48 @@ void MainWindow::nxmTrackedModsAvailable(QVariant userData, QVariant resultData,
     gameNames[game->gameNexusName()] = game->gameShortName();
   }
 
+  // the list can have thousands of entries, it's converted on a task and the
+  // mods are updated on the ui thread
+  TaskExecutor::instance().post(TaskPriority::Normal, [this, gameNames, resultData] {
+    TrackedMods tracked;
+
+    for (const auto& item : resultData.toList()) {
+      const auto results = item.toMap();
+
+      tracked.insert({
+        gameNames.value(results["domain_name"].toString()).toLower(),
+        results["mod_id"].toInt()});
+    }
+
+    QMetaObject::invokeMethod(this, [this, tracked=std::move(tracked)] {
+      updateTrackedMods(tracked);
+    }, Qt::QueuedConnection);
+  });
+}
+
+void MainWindow::updateTrackedMods(const TrackedMods& tracked)
+{
+  std::size_t changed = 0;
+
   for (unsigned int i = 0; i < ModInfo::getNumMods(); i++) {
     auto modInfo = ModInfo::getByIndex(i);
     if (modInfo->nexusId() <= 0)
       continue;
 
-    bool found = false;
-    auto resultsList = resultData.toList();
-    for (auto item : resultsList) {
-      auto results = item.toMap();
-      if ((gameNames[results["domain_name"].toString()].compare(modInfo->gameName(), Qt::CaseInsensitive) == 0) &&
-          (results["mod_id"].toInt() == modInfo->nexusId())) {
-        found = true;
-        break;
-      }
+    const bool found = tracked.contains(
+      {modInfo->gameName().toLower(), modInfo->nexusId()});
+
+    // only the mods that changed are written
+    if (found == (modInfo->trackedState() == TrackedState::TRACKED_TRUE)) {
+      continue;
     }
 
     modInfo->setIsTracked(found);
     modInfo->saveMeta();
+    ++changed;
   }
+
+  log::debug("{} tracked mods, {} changed", tracked.size(), changed);
 }
 
 void MainWindow::nxmDownloadURLs(QString, int, int, QVariant, QVariant resultData, int)
@@ -3122,60 +3317,8 @@ void MainWindow::nxmRequestFailed(QString gameName, int modID, int, QVariant, in
   }
 }
 
-BSA::EErrorCode MainWindow::extractBSA(BSA::Archive &archive, BSA::Folder::Ptr folder, const QString &destination,
-                           QProgressDialog &progress)
-{
-  QDir().mkdir(destination);
-  BSA::EErrorCode result = BSA::ERROR_NONE;
-  QString errorFile;
-
-  for (unsigned int i = 0; i < folder->getNumFiles(); ++i) {
-    BSA::File::Ptr file = folder->getFile(i);
-    BSA::EErrorCode res = archive.extract(file, qUtf8Printable(destination));
-    if (res != BSA::ERROR_NONE) {
-      reportError(tr("failed to read %1: %2").arg(file->getName().c_str()).arg(res));
-      result = res;
-    }
-    progress.setLabelText(file->getName().c_str());
-    progress.setValue(progress.value() + 1);
-    QCoreApplication::processEvents();
-    if (progress.wasCanceled()) {
-      result = BSA::ERROR_CANCELED;
-    }
-  }
-
-  if (result != BSA::ERROR_NONE) {
-    if (QMessageBox::critical(this, tr("Error"), tr("failed to extract %1 (errorcode %2)").arg(errorFile).arg(result),
-                              QMessageBox::Ok | QMessageBox::Cancel) == QMessageBox::Cancel) {
-      return result;
-    }
-  }
-
-  for (unsigned int i = 0; i < folder->getNumSubFolders(); ++i) {
-    BSA::Folder::Ptr subFolder = folder->getSubFolder(i);
-    BSA::EErrorCode res = extractBSA(archive, subFolder,
-                                     destination.mid(0).append("/").append(subFolder->getName().c_str()), progress);
-    if (res != BSA::ERROR_NONE) {
-      return res;
-    }
-  }
-  return BSA::ERROR_NONE;
-}
-
-
-bool MainWindow::extractProgress(QProgressDialog &progress, int percentage, std::string fileName)
-{
-  progress.setLabelText(fileName.c_str());
-  progress.setValue(percentage);
-  QCoreApplication::processEvents();
-  return !progress.wasCanceled();
-}
-
-
 void MainWindow::extractBSATriggered(QTreeWidgetItem* item)
 {
-  using namespace boost::placeholders;
-
   QString origin;
 
   QString targetFolder = FileDialogMemory::getExistingDirectory("extractBSA", this, tr("Extract BSA"));
@@ -3191,29 +3334,84 @@ void MainWindow::extractBSATriggered(QTreeWidgetItem* item)
       archives = QStringList({ item->text(0) });
     }
 
+    QStringList paths;
     for (auto archiveName : archives) {
-      BSA::Archive archive;
-      QString archivePath = QString("%1\\%2").arg(origin).arg(archiveName);
-      BSA::EErrorCode result = archive.read(archivePath.toLocal8Bit().constData(), true);
-      if ((result != BSA::ERROR_NONE) && (result != BSA::ERROR_INVALIDHASHES)) {
-        reportError(tr("failed to read %1: %2").arg(archivePath).arg(result));
-        return;
-      }
-
-      QProgressDialog progress(this);
-      progress.setMaximum(100);
-      progress.setValue(0);
-      progress.show();
-      archive.extractAll(QDir::toNativeSeparators(targetFolder).toLocal8Bit().constData(),
-        boost::bind(&MainWindow::extractProgress, this, boost::ref(progress), _1, _2));
-      if (result == BSA::ERROR_INVALIDHASHES) {
-        reportError(tr("This archive contains invalid hashes. Some files may be broken."));
-      }
-      archive.close();
+      paths.append(QString("%1\\%2").arg(origin).arg(archiveName));
     }
+
+    extractArchives(paths, targetFolder);
   }
 }
 
+void MainWindow::extractArchives(const QStringList& paths, const QString& targetFolder)
+{
+  // the files are extracted in the background, the dialog is only polled
+  auto extraction = ArchiveExtraction::start(paths, targetFolder);
+
+  auto* progress = new QProgressDialog(this);
+  progress->setAttribute(Qt::WA_DeleteOnClose);
+  progress->setWindowTitle(tr("Extract BSA"));
+  progress->setAutoClose(false);
+  progress->setAutoReset(false);
+  progress->setMaximum(100);
+  progress->setValue(0);
+
+  connect(progress, &QProgressDialog::canceled, [extraction]{
+    extraction->cancel();
+  });
+
+  // stops the extraction if the dialog is destroyed with the main window
+  connect(progress, &QObject::destroyed, [extraction]{
+    extraction->cancel();
+  });
+
+  auto* timer = new QTimer(progress);
+
+  connect(timer, &QTimer::timeout, [=]{
+    const auto done = extraction->filesDone();
+    const auto total = extraction->filesTotal();
+
+    progress->setLabelText(tr("Extracting %1 (%2/%3)")
+      .arg(QFileInfo(extraction->currentArchive()).fileName())
+      .arg(done).arg(total));
+
+    if (total > 0) {
+      progress->setValue(static_cast<int>(done * 100 / total));
+    }
+
+    if (!extraction->finished()) {
+      return;
+    }
+
+    timer->stop();
+
+    const auto errors = extraction->errors();
+    const auto invalidHashes = extraction->invalidHashes();
+    const bool cancelled = extraction->cancelled();
+
+    progress->close();
+
+    if (cancelled) {
+      return;
+    }
+
+    if (!errors.isEmpty()) {
+      reportError(errors.join("\n"));
+    }
+
+    for (const auto& path : invalidHashes) {
+      reportError(
+        tr("%1 contains invalid hashes. Some files may be broken.")
+        .arg(QFileInfo(path).fileName()));
+    }
+  });
+
+  // progress is only shown a few times per second, however fast the files
+  // are extracted
+  timer->start(std::chrono::milliseconds(100));
+  progress->show();
+}
+
 void MainWindow::on_bsaList_customContextMenuRequested(const QPoint& pos)
 {
   QMenu menu;
@@ -3238,6 +3436,8 @@ void MainWindow::on_actionNotifications_triggered()
   ProblemsDialog problems(m_PluginContainer, this);
   problems.exec();
 
+  // guided fixes can change anything
+  m_PluginContainer.invalidateProblems(PluginContainer::DiagnoseEvent::All);
   scheduleCheckForProblems();
 }
 
@@ -3251,10 +3451,10 @@ void MainWindow::setCategoryListVisible(bool visible)
 {
   if (visible) {
     ui->categoriesGroup->show();
-    ui->displayCategoriesBtn->setText(ToQString(L"\u00ab"));
+    ui->displayCategoriesBtn->setText(QString::fromWCharArray(L"\u00ab"));
   } else {
     ui->categoriesGroup->hide();
-    ui->displayCategoriesBtn->setText(ToQString(L"\u00bb"));
+    ui->displayCategoriesBtn->setText(QString::fromWCharArray(L"\u00bb"));
   }
 }
 
@@ -3338,6 +3538,7 @@ bool MainWindow::createBackup(const QString &filePath, const QDateTime &time)
 void MainWindow::on_saveButton_clicked()
 {
   m_OrganizerCore.savePluginList();
+  m_OrganizerCore.pluginList()->flushWrites();
   QDateTime now = QDateTime::currentDateTime();
   if (createBackup(m_OrganizerCore.currentProfile()->getPluginsFileName(), now)
       && createBackup(m_OrganizerCore.currentProfile()->getLoadOrderFileName(), now)
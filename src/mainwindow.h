@@ -23,6 +23,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "bsafolder.h"
 #include "delayedfilewriter.h"
 #include "errorcodes.h"
+#include "iconfetcher.h"
 #include "imoinfo.h"
 #include "iuserinterface.h"
 #include "modinfo.h"
@@ -32,6 +33,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "plugincontainer.h" //class PluginContainer;
 #include "iplugingame.h" //namespace MOBase { class IPluginGame; }
 #include "shared/fileregisterfwd.h"
+#include "taskexecutor.h"
 #include <log.h>
 
 class Executable;
@@ -41,10 +43,10 @@ class FilterList;
 class DataTab;
 class DownloadsTab;
 class SavesTab;
+class UpdateScheduler;
 class BrowserDialog;
 
 class PluginListSortProxy;
-namespace BSA { class Archive; }
 
 namespace MOBase { class IPluginModPage; }
 namespace MOBase { class IPluginTool; }
@@ -197,13 +199,28 @@ private:
   bool refreshProfiles(bool selectProfile = true);
   void refreshExecutablesList();
 
+  // shows the durations of the last launches in the tooltip of the run
+  // button, see LaunchTimeline
+  void updateStartButtonTooltip();
+
+  // icon of the given executable if it's already known, a placeholder
+  // otherwise; updateExecutableIcons() replaces placeholders once the icons
+  // have been fetched
+  //
+  QIcon executableIcon(const QString& path);
+  void updateExecutableIcons();
+
+  // short game names, lowercase, and nexus ids of tracked mods
+  using TrackedMods = QSet<QPair<QString, int>>;
+
+  // updates the tracked state of the mods from nxmTrackedModsAvailable()
+  void updateTrackedMods(const TrackedMods& tracked);
+
   bool modifyExecutablesDialog(int selection);
 
   // remove invalid category-references from mods
   void fixCategories();
 
-  bool extractProgress(QProgressDialog &extractProgress, int percentage, std::string fileName);
-
   // Performs checks, sets the m_NumberOfProblems and signals checkForProblemsDone().
   void checkForProblemsImpl();
 
@@ -247,6 +264,9 @@ private:
   std::unique_ptr<DownloadsTab> m_DownloadsTab;
   std::unique_ptr<SavesTab> m_SavesTab;
 
+  // checks mods for updates in the background, replies come here
+  std::unique_ptr<UpdateScheduler> m_UpdateScheduler;
+
   int m_OldProfileIndex;
 
   std::vector<QString> m_ModNameList; // the mod-list to go with the directory structure
@@ -263,7 +283,15 @@ private:
   QTimer m_SaveMetaTimer;
   QTimer m_UpdateProblemsTimer;
 
-  QFuture<void> m_MetaSave;
+  // icons of the executables in the toolbar and the list, fetched in the
+  // background because a binary can be on a drive that doesn't respond;
+  // m_ExecutableIconsPending has the paths that got a placeholder
+  IconFetcher m_ExecutableIcons{
+    "executables.cache", GetSystemMetrics(SM_CXICON), 1};
+  std::set<QString> m_ExecutableIconsPending;
+  QTimer m_ExecutableIconsTimer;
+
+  MOShared::TaskGroup m_MetaSave{MOShared::TaskPriority::Low};
 
   QTime m_StartTime;
 
@@ -275,7 +303,6 @@ private:
 
   std::unique_ptr<BrowserDialog> m_IntegratedBrowser;
 
-  QByteArray m_ArchiveListHash;
 
   MOBase::DelayedFileWriter m_ArchiveListWriter;
 
@@ -307,6 +334,11 @@ private slots:
   void tutorialTriggered();
   void extractBSATriggered(QTreeWidgetItem* item);
 
+  // extracts the given archives into the folder in the background, with a
+  // progress dialog that can cancel it
+  //
+  void extractArchives(const QStringList& paths, const QString& targetFolder);
+
   void refreshProfile_activated();
 
   void linkToolbar();
@@ -317,8 +349,6 @@ private slots:
 
   void windowTutorialFinished(const QString &windowName);
 
-  BSA::EErrorCode extractBSA(BSA::Archive &archive, BSA::Folder::Ptr folder, const QString &destination, QProgressDialog &extractProgress);
-
   // nexus related
   void updateAvailable();
 
@@ -370,6 +400,11 @@ private slots:
   // Queue a problem check to allow collapsing of multiple requests in short amount of time.
   void scheduleCheckForProblems();
 
+  // enables or disables the widgets that depend on the directory structure
+  // while it's being refreshed
+  //
+  void setStructureWidgetsEnabled(bool enabled);
+
   // Perform the actual problem check in another thread.
   QFuture<void> checkForProblemsAsync();
 
@@ -0,0 +1,279 @@
+#include "memoryaccounting.h"
+#include "shared/appconfig.h"
+#include <log.h>
+#include <utility.h>
+#include <QApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QTimer>
+#include <algorithm>
+#include <map>
+#include <windows.h>
+
+using namespace MOBase;
+
+// how often the budget and the low memory notification are checked
+static constexpr std::chrono::seconds CheckInterval(10);
+
+struct MemoryAccounting::Data
+{
+  struct Entry
+  {
+    QString name;
+    std::function<MOShared::MemoryUsage ()> usage;
+    std::function<void (const QString&)> dump;
+    Trimmer trimmer;
+  };
+
+  std::size_t nextID = 0;
+  std::map<std::size_t, Entry> sources;
+
+  // 0 for no limit
+  std::size_t budget = 0;
+
+  // created by the first setBudget(), owned by the application
+  QTimer* timer = nullptr;
+
+  // signalled by the system when memory is low, and whether it was already
+  // handled, so the caches are only trimmed once every time memory gets low
+  HANDLE lowMemory = nullptr;
+  bool wasLow = false;
+
+  ~Data()
+  {
+    if (lowMemory) {
+      ::CloseHandle(lowMemory);
+    }
+  }
+};
+
+
+MemoryAccounting::Source::Source(
+  QString name, std::function<MOShared::MemoryUsage ()> usage,
+  std::function<void (const QString& path)> dump, Trimmer trimmer)
+    : m_id(data().nextID++)
+{
+  data().sources.emplace(m_id, Data::Entry{
+    std::move(name), std::move(usage), std::move(dump), std::move(trimmer)});
+}
+
+MemoryAccounting::Source::~Source()
+{
+  data().sources.erase(m_id);
+}
+
+
+std::vector<MemoryAccounting::Usage> MemoryAccounting::collect()
+{
+  std::vector<Usage> v;
+
+  for (auto&& [id, e] : data().sources) {
+    auto itor = std::find_if(v.begin(), v.end(), [&](auto&& u) {
+      return (u.name == e.name);
+    });
+
+    if (itor == v.end()) {
+      v.push_back({e.name, e.usage()});
+    } else {
+      itor->usage += e.usage();
+    }
+  }
+
+  std::stable_sort(v.begin(), v.end(), [](auto&& a, auto&& b) {
+    return (a.usage.bytes > b.usage.bytes);
+  });
+
+  return v;
+}
+
+bool MemoryAccounting::write()
+{
+  const auto path = memoryFilename();
+  QFile f(path);
+
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    log::error(
+      "can't write memory usage to '{}', {}", f.fileName(), f.errorString());
+    return false;
+  }
+
+  std::size_t total = 0;
+
+  for (const auto& u : collect()) {
+    f.write(QString("%1\t%2\t%3\r\n")
+      .arg(u.name)
+      .arg(u.usage.count)
+      .arg(u.usage.bytes)
+      .toUtf8());
+
+    total += u.usage.bytes;
+  }
+
+  f.write(QString("total\t\t%1\r\n").arg(total).toUtf8());
+  f.close();
+
+  // details go next to the file, named after the consumer
+  const QFileInfo fi(path);
+
+  for (auto&& [id, e] : data().sources) {
+    if (!e.dump) {
+      continue;
+    }
+
+    QString name = e.name;
+    name.replace(QRegExp("[^a-zA-Z0-9]+"), "_");
+
+    e.dump(
+      fi.absolutePath() + "/" + fi.completeBaseName() + "_" + name + ".txt");
+  }
+
+  log::debug("memory usage written to '{}'", path);
+
+  return true;
+}
+
+QString MemoryAccounting::memoryFilename()
+{
+  return
+    qApp->property("dataPath").toString() + "/" +
+    QString::fromStdWString(AppConfig::logPath()) + "/memory.txt";
+}
+
+std::size_t MemoryAccounting::bytes(const QString& s)
+{
+  if (s.capacity() == 0) {
+    return 0;
+  }
+
+  // the header of the shared data and the characters with the terminator
+  return 3 * sizeof(void*) + (s.capacity() + 1) * sizeof(QChar);
+}
+
+void MemoryAccounting::setBudget(std::size_t bytes)
+{
+  auto& d = data();
+  d.budget = bytes;
+
+  if (!d.timer) {
+    d.lowMemory = ::CreateMemoryResourceNotification(
+      LowMemoryResourceNotification);
+
+    if (!d.lowMemory) {
+      const auto e = ::GetLastError();
+      log::error("can't watch for low memory, {}", formatSystemMessage(e));
+    }
+
+    d.timer = new QTimer(qApp);
+    QObject::connect(d.timer, &QTimer::timeout, []{ check(); });
+    d.timer->start(CheckInterval);
+  }
+
+  if (bytes == 0) {
+    log::debug("no memory budget for caches");
+  } else {
+    log::debug("memory budget for caches is {}", localizedByteSize(bytes));
+  }
+}
+
+void MemoryAccounting::trim(const QString& reason)
+{
+  std::size_t before = 0;
+  std::size_t after = 0;
+
+  for (auto&& [id, e] : data().sources) {
+    if (!e.trimmer.trim) {
+      continue;
+    }
+
+    before += e.usage().bytes;
+    e.trimmer.trim();
+    after += e.usage().bytes;
+  }
+
+  log::debug(
+    "trimmed caches because {}, freed {}",
+    reason, localizedByteSize(before - std::min(before, after)));
+}
+
+void MemoryAccounting::check()
+{
+  auto& d = data();
+
+  if (d.lowMemory) {
+    BOOL low = FALSE;
+
+    if (::QueryMemoryResourceNotification(d.lowMemory, &low) && low) {
+      if (!d.wasLow) {
+        d.wasLow = true;
+        trim("the system is low on memory");
+      }
+
+      return;
+    }
+
+    d.wasLow = false;
+  }
+
+  if (d.budget == 0) {
+    return;
+  }
+
+  struct Candidate
+  {
+    Data::Entry* e;
+    std::size_t bytes;
+    Clock::time_point used;
+  };
+
+  std::vector<Candidate> v;
+  std::size_t total = 0;
+
+  for (auto&& [id, e] : d.sources) {
+    if (!e.trimmer.trim) {
+      continue;
+    }
+
+    const auto bytes = e.usage().bytes;
+    if (bytes == 0) {
+      continue;
+    }
+
+    const auto used = (e.trimmer.lastUsed ? e.trimmer.lastUsed() : Clock::time_point());
+    v.push_back({&e, bytes, used});
+    total += bytes;
+  }
+
+  if (total <= d.budget) {
+    return;
+  }
+
+  const auto before = total;
+
+  std::stable_sort(v.begin(), v.end(), [](auto&& a, auto&& b) {
+    return (a.used < b.used);
+  });
+
+  for (auto& c : v) {
+    if (total <= d.budget) {
+      break;
+    }
+
+    c.e->trimmer.trim();
+
+    const auto bytes = c.e->usage().bytes;
+    total -= (c.bytes - std::min(c.bytes, bytes));
+
+    log::debug("trimmed '{}', now {}", c.e->name, localizedByteSize(bytes));
+  }
+
+  log::debug(
+    "caches were using {}, over the budget of {}, now {}",
+    localizedByteSize(before), localizedByteSize(d.budget),
+    localizedByteSize(total));
+}
+
+MemoryAccounting::Data& MemoryAccounting::data()
+{
+  static Data d;
+  return d;
+}
@@ -0,0 +1,120 @@
+#ifndef MODORGANIZER_MEMORYACCOUNTING_INCLUDED
+#define MODORGANIZER_MEMORYACCOUNTING_INCLUDED
+
+#include "shared/memoryusage.h"
+#include <QString>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+// estimates of the memory used by the biggest consumers in MO: the directory
+// structure, the caches of the mods, the file tree of the data tab and its
+// icons
+//
+// objects register a Source for each consumer they own for as long as they
+// live; collect() asks all the sources for their current usage, it's shown in
+// the diagnostics settings and written to the logs folder by write()
+//
+// consumers that only hold things they can get back, like caches, can also be
+// trimmed: once setBudget() has been called, the usage of these consumers is
+// checked regularly and the least recently used ones are trimmed until they
+// fit in the budget again; they're all trimmed when the system says memory is
+// low and when a hooked program starts, so MO doesn't compete with the game
+//
+// this must only be used from the ui thread
+//
+class MemoryAccounting
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // how a consumer frees memory, see the class comment
+  //
+  struct Trimmer
+  {
+    // frees what the consumer can get back later; empty for consumers that
+    // can't be trimmed
+    std::function<void ()> trim;
+
+    // when the consumer was last used, the least recently used consumers are
+    // trimmed first; consumers that don't say are trimmed before the others
+    std::function<Clock::time_point ()> lastUsed;
+  };
+
+  // the usage of a consumer, sources with the same name are summed
+  //
+  struct Usage
+  {
+    // like "structure: files"
+    QString name;
+    MOShared::MemoryUsage usage;
+  };
+
+  // registers a consumer until the source is destroyed
+  //
+  class Source
+  {
+  public:
+    // `dump`, if given, writes details for the consumer to the given file,
+    // like DirectoryEntry::dumpMemory(); it's called by write()
+    //
+    // `trimmer` is for consumers that can be trimmed
+    //
+    Source(
+      QString name, std::function<MOShared::MemoryUsage ()> usage,
+      std::function<void (const QString& path)> dump={},
+      Trimmer trimmer={});
+
+    ~Source();
+
+    // noncopyable
+    Source(const Source&) = delete;
+    Source& operator=(const Source&) = delete;
+
+  private:
+    std::size_t m_id;
+  };
+
+  // the current usage of all the consumers, sorted by the number of bytes,
+  // largest first
+  //
+  static std::vector<Usage> collect();
+
+  // writes collect() to memoryFilename() as tab-separated lines with the
+  // name, the count and the bytes of each consumer, along with the details
+  // of each consumer that can be dumped in files next to it; returns false
+  // on failure, which has been logged
+  //
+  static bool write();
+
+  // path of the file written by write()
+  //
+  static QString memoryFilename();
+
+  // bytes allocated by the given string, zero when it's empty; strings
+  // shared between objects must only be counted by one of them
+  //
+  static std::size_t bytes(const QString& s);
+
+  // sets the number of bytes the consumers that can be trimmed may use
+  // together, 0 for no limit; the first call also starts checking the budget
+  // and the low memory notification of the system regularly
+  //
+  static void setBudget(std::size_t bytes);
+
+  // trims all the consumers that can be trimmed, `reason` is logged along
+  // with the memory that was freed
+  //
+  static void trim(const QString& reason);
+
+private:
+  struct Data;
+  static Data& data();
+
+  // trims everything when memory is low, or the least recently used
+  // consumers until they fit in the budget
+  //
+  static void check();
+};
+
+#endif // MODORGANIZER_MEMORYACCOUNTING_INCLUDED
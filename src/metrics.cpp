@@ -0,0 +1,178 @@
+#include "metrics.h"
+#include "shared/util.h"
+#include <log.h>
+#include <QApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <mutex>
+#include <vector>
+
+using namespace MOBase;
+
+// number of session files kept in the logs directory
+static constexpr int MaxSessions = 10;
+
+struct Metrics::Data
+{
+  std::mutex mutex;
+  QFile file;
+  Clock::time_point start = Clock::now();
+
+  int mods = -1;
+  std::size_t files = 0;
+
+  QString version;
+  QString build;
+
+  // lines recorded before open() was first called; lines are dropped if
+  // the file couldn't be opened
+  std::vector<QByteArray> pending;
+  bool opened = false;
+
+  Data()
+    : version(MOShared::createVersionInfo().displayString(3))
+  {
+#if defined(HGID)
+    build = HGID;
+#elif defined(GITID)
+    build = GITID;
+#else
+    build = "unknown";
+#endif
+  }
+};
+
+
+Metrics::Timer::Timer(QString name)
+  : m_log(name), m_name(std::move(name)), m_start(Clock::now()),
+    m_running(true)
+{
+}
+
+Metrics::Timer::~Timer()
+{
+  stop();
+}
+
+void Metrics::Timer::stop()
+{
+  if (!m_running) {
+    return;
+  }
+
+  m_running = false;
+  m_log.stop();
+
+  Metrics::duration(m_name, Clock::now() - m_start);
+}
+
+
+void Metrics::open(const QString& logsDir)
+{
+  removeOldFiles(logsDir, "metrics_*.jsonl", MaxSessions - 1, QDir::Name);
+
+  const auto path =
+    logsDir + "/metrics_" +
+    QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss") + ".jsonl";
+
+  auto& d = data();
+  std::scoped_lock lock(d.mutex);
+
+  d.opened = true;
+  d.file.close();
+  d.file.setFileName(path);
+
+  if (!d.file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    log::error(
+      "can't open metrics file '{}', {}", d.file.fileName(), d.file.errorString());
+    return;
+  }
+
+  for (const auto& line : d.pending) {
+    d.file.write(line);
+  }
+
+  d.pending.clear();
+  d.file.flush();
+
+  log::debug("metrics are written to '{}'", path);
+}
+
+void Metrics::setInstanceSize(int mods, std::size_t files)
+{
+  auto& d = data();
+  std::scoped_lock lock(d.mutex);
+
+  d.mods = mods;
+  d.files = files;
+}
+
+void Metrics::duration(const QString& name, std::chrono::nanoseconds d)
+{
+  using namespace std::chrono;
+
+  QJsonObject o;
+  o["ms"] = duration_cast<microseconds>(d).count() / 1000.0;
+
+  record(name, std::move(o));
+}
+
+void Metrics::value(const QString& name, double v, const QString& unit)
+{
+  QJsonObject o;
+  o["value"] = v;
+  o["unit"] = unit;
+
+  record(name, std::move(o));
+}
+
+QString Metrics::filename()
+{
+  auto& d = data();
+  std::scoped_lock lock(d.mutex);
+
+  return d.file.fileName();
+}
+
+void Metrics::record(const QString& name, QJsonObject o)
+{
+  using namespace std::chrono;
+
+  auto& d = data();
+
+  o["name"] = name;
+  o["thread"] = static_cast<qint64>(::GetCurrentThreadId());
+  o["ui"] = (qApp && QThread::currentThread() == qApp->thread());
+
+  std::scoped_lock lock(d.mutex);
+
+  o["time"] = static_cast<qint64>(
+    duration_cast<milliseconds>(Clock::now() - d.start).count());
+
+  if (d.mods >= 0) {
+    o["mods"] = d.mods;
+    o["files"] = static_cast<qint64>(d.files);
+  }
+
+  o["version"] = d.version;
+  o["build"] = d.build;
+
+  auto line = QJsonDocument(o).toJson(QJsonDocument::Compact) + "\n";
+
+  if (d.file.isOpen()) {
+    d.file.write(line);
+    d.file.flush();
+  } else if (!d.opened) {
+    d.pending.push_back(std::move(line));
+  }
+}
+
+Metrics::Data& Metrics::data()
+{
+  static Data d;
+  return d;
+}
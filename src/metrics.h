@@ -0,0 +1,75 @@
+#ifndef MODORGANIZER_METRICS_INCLUDED
+#define MODORGANIZER_METRICS_INCLUDED
+
+#include <utility.h>
+#include <QString>
+#include <chrono>
+
+class QJsonObject;
+
+// performance counters of the current session, written as json lines to a
+// file in the logs directory so timings can be compared across sessions and
+// builds
+//
+// each line is an object with the name of the counter, its duration in
+// milliseconds or its value, the thread it was recorded on, the time since
+// MO was started, the size of the instance and the build; the files of the
+// last sessions are kept, see open()
+//
+// counters recorded before open() are kept in memory and written once the
+// file is open; this can be used from any thread
+//
+class Metrics
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // times its lifetime and records it as a duration; it's also logged like
+  // TimeThis, which it replaces
+  //
+  class Timer
+  {
+  public:
+    Timer(QString name);
+    ~Timer();
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    // records the duration, does nothing if it was already stopped
+    //
+    void stop();
+
+  private:
+    MOBase::TimeThis m_log;
+    QString m_name;
+    Clock::time_point m_start;
+    bool m_running;
+  };
+
+  // starts a new session in the given directory; the files of the oldest
+  // sessions are removed so only the last few are kept, this is called
+  // again when MO restarts
+  //
+  static void open(const QString& logsDir);
+
+  // number of mods and files in the structure, added to every counter
+  // recorded after this; updated after each refresh
+  //
+  static void setInstanceSize(int mods, std::size_t files);
+
+  static void duration(const QString& name, std::chrono::nanoseconds d);
+  static void value(const QString& name, double v, const QString& unit);
+
+  // path of the file of the current session, empty if open() wasn't called
+  //
+  static QString filename();
+
+private:
+  struct Data;
+  static Data& data();
+
+  static void record(const QString& name, QJsonObject o);
+};
+
+#endif // MODORGANIZER_METRICS_INCLUDED
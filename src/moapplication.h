@@ -20,6 +20,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MOAPPLICATION_H
 #define MOAPPLICATION_H
 
+#include "taskexecutor.h"
 #include <QApplication>
 #include <QFileSystemWatcher>
 
@@ -84,10 +85,19 @@ private:
   std::unique_ptr<PluginContainer> m_plugins;
   std::unique_ptr<OrganizerCore> m_core;
 
+  // logs the environment and runs the sanity checks that don't need the
+  // instance, started by setup(); the problems they find are shown by
+  // OrganizerCore in the problems dialog
+  std::unique_ptr<MOShared::TaskGroup> m_checks;
+
   void externalMessage(const QString& message);
   std::unique_ptr<Instance> getCurrentInstance(bool forceSelect);
   std::optional<int> setupInstanceLoop(Instance& currentInstance, PluginContainer& pc);
   void purgeOldFiles();
+
+  // starts m_checks
+  //
+  void startEnvironmentChecks();
 };
 
 
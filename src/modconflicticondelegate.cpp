@@ -3,6 +3,7 @@
 #include "modlistview.h"
 #include <log.h>
 #include <QList>
+#include <QHash>
 
 using namespace MOBase;
 
@@ -13,6 +14,25 @@ ModConflictIconDelegate::ModConflictIconDelegate(ModListView* view, int logicalI
 
 QList<QString> ModConflictIconDelegate::getIconsForFlags(
   std::vector<ModInfo::EConflictFlag> flags, bool compact)
+{
+  // there are only a few combinations of flags in practice
+  static QHash<QByteArray, QList<QString>> cache;
+
+  const QByteArray key = iconSetKey(flags, compact);
+
+  auto itor = cache.constFind(key);
+  if (itor != cache.constEnd()) {
+    return *itor;
+  }
+
+  auto icons = createIconsForFlags(std::move(flags), compact);
+  cache.insert(key, icons);
+
+  return icons;
+}
+
+QList<QString> ModConflictIconDelegate::createIconsForFlags(
+  std::vector<ModInfo::EConflictFlag> flags, bool compact)
 {
   QList<QString> result;
 
@@ -19,6 +19,9 @@ public:
 protected:
 
   static QList<QString> getIconsForFlags(std::vector<ModInfo::EConflictFlag> flags, bool compact);
+
+  // builds the icons for getIconsForFlags(), which caches them
+  static QList<QString> createIconsForFlags(std::vector<ModInfo::EConflictFlag> flags, bool compact);
   static QString getFlagIcon(ModInfo::EConflictFlag flag);
 
   QList<QString> getIcons(const QModelIndex &index) const override;
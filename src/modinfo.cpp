@@ -18,6 +18,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "modinfo.h"
+#include "metrics.h"
 
 #include "modinfobackup.h"
 #include "modinforegular.h"
@@ -31,11 +32,13 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "modlist.h"
 #include "overwriteinfodialog.h"
 #include "versioninfo.h"
-#include "thread_utils.h"
+#include "taskexecutor.h"
+#include "deletionqueue.h"
 
 #include <iplugingame.h>
 #include <versioninfo.h>
 #include "shared/appconfig.h"
+#include "shared/filesorigin.h"
 #include <scriptextender.h>
 #include <unmanagedmods.h>
 #include <log.h>
@@ -44,6 +47,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QApplication>
 #include <QDirIterator>
 #include <QMutexLocker>
+#include <atomic>
+#include <unordered_map>
 
 using namespace MOBase;
 using namespace MOShared;
@@ -52,13 +57,116 @@ using namespace MOShared;
 const std::set<unsigned int> ModInfo::s_EmptySet;
 std::vector<ModInfo::Ptr> ModInfo::s_Collection;
 ModInfo::Ptr ModInfo::s_Overwrite;
-std::map<QString, unsigned int, MOBase::FileNameComparator> ModInfo::s_ModsByName;
-std::map<std::pair<QString, int>, std::vector<unsigned int>> ModInfo::s_ModsByModID;
+QHash<QString, unsigned int> ModInfo::s_ModsByName;
+QHash<QPair<QString, int>, std::vector<ModInfo::Ptr>> ModInfo::s_ModsByModID;
 int ModInfo::s_NextID;
+int ModInfo::s_Generation = 0;
 QMutex ModInfo::s_Mutex(QMutex::Recursive);
 
 QString ModInfo::s_HiddenExt(".mohidden");
 
+namespace
+{
+
+// the last published snapshot and a counter that changes with it, so readers
+// only load the pointer itself when there's a new one
+std::shared_ptr<const ModInfo::Snapshot> g_Published;
+std::atomic<int> g_PublishedVersion(0);
+
+// set while updateFromDisc() creates the mods, it publishes once at the end
+bool g_DeferPublish = false;
+
+} // namespace
+
+
+const ModInfo::Ptr& ModInfo::Snapshot::at(unsigned int index) const
+{
+  if (index == ULONG_MAX) {
+    if (m_Overwrite) {
+      return m_Overwrite;
+    }
+
+    index = this->index("Overwrite");
+  }
+
+  if (index >= m_Mods.size()) {
+    throw MyException(tr("invalid mod index: %1").arg(index));
+  }
+
+  return m_Mods[index];
+}
+
+unsigned int ModInfo::Snapshot::index(const QString& name) const
+{
+  auto iter = m_ByName.constFind(nameKey(name));
+  if (iter == m_ByName.constEnd()) {
+    return UINT_MAX;
+  }
+
+  return iter.value();
+}
+
+const std::vector<ModInfo::Ptr>& ModInfo::Snapshot::byModID(
+  const QString& game, int modID) const
+{
+  static const std::vector<ModInfo::Ptr> empty;
+
+  auto iter = m_ByModID.constFind({nameKey(game), modID});
+  if (iter == m_ByModID.constEnd()) {
+    return empty;
+  }
+
+  return iter.value();
+}
+
+
+const ModInfo::Snapshot& ModInfo::snapshot()
+{
+  static const Snapshot empty;
+
+  thread_local std::shared_ptr<const Snapshot> current;
+  thread_local int version = -1;
+
+  const int latest = g_PublishedVersion.load(std::memory_order_acquire);
+
+  if (version != latest) {
+    current = std::atomic_load(&g_Published);
+    version = latest;
+  }
+
+  return (current ? *current : empty);
+}
+
+void ModInfo::publish()
+{
+  if (g_DeferPublish) {
+    return;
+  }
+
+  // the indexes are implicitly shared, only the collection itself is copied
+  auto s = std::make_shared<Snapshot>();
+  s->m_Mods = s_Collection;
+  s->m_ByName = s_ModsByName;
+  s->m_ByModID = s_ModsByModID;
+  s->m_Overwrite = s_Overwrite;
+  s->m_Generation = s_Generation;
+
+  std::atomic_store(&g_Published, std::shared_ptr<const Snapshot>(std::move(s)));
+  g_PublishedVersion.fetch_add(1, std::memory_order_release);
+}
+
+void ModInfo::clear()
+{
+  QMutexLocker locker(&s_Mutex);
+
+  s_Collection.clear();
+  s_ModsByName.clear();
+  s_ModsByModID.clear();
+  ++s_Generation;
+
+  publish();
+}
+
 
 bool ModInfo::ByName(const ModInfo::Ptr &LHS, const ModInfo::Ptr &RHS)
 {
@@ -83,20 +191,22 @@ bool ModInfo::isRegularName(const QString& name)
 }
 
 
-ModInfo::Ptr ModInfo::createFrom(const QDir &dir, OrganizerCore& core)
+ModInfo::Ptr ModInfo::createFrom(const QDir &dir, OrganizerCore& core, const QVariantMap* meta)
 {
   QMutexLocker locker(&s_Mutex);
   ModInfo::Ptr result;
 
   if (isBackupName(dir.dirName())) {
-    result = ModInfo::Ptr(new ModInfoBackup(dir, core));
+    result = ModInfo::Ptr(new ModInfoBackup(dir, core, meta));
   } else if (isSeparatorName(dir.dirName())) {
-    result = Ptr(new ModInfoSeparator(dir, core));
+    result = Ptr(new ModInfoSeparator(dir, core, meta));
   } else {
-    result = ModInfo::Ptr(new ModInfoRegular(dir, core));
+    result = ModInfo::Ptr(new ModInfoRegular(dir, core, meta));
   }
   result->m_Index = s_Collection.size();
   s_Collection.push_back(result);
+  ++s_Generation;
+  publish();
   return result;
 }
 
@@ -109,6 +219,8 @@ ModInfo::Ptr ModInfo::createFromPlugin(const QString &modName,
   ModInfo::Ptr result = ModInfo::Ptr(new ModInfoForeign(modName, espName, bsaNames, modType, core));
   result->m_Index = s_Collection.size();
   s_Collection.push_back(result);
+  ++s_Generation;
+  publish();
   return result;
 }
 
@@ -118,47 +230,38 @@ ModInfo::Ptr ModInfo::createFromOverwrite(OrganizerCore& core)
   ModInfo::Ptr overwrite = ModInfo::Ptr(new ModInfoOverwrite(core));
   overwrite->m_Index = s_Collection.size();
   s_Collection.push_back(overwrite);
+  ++s_Generation;
+  publish();
   return overwrite;
 }
 
 unsigned int ModInfo::getNumMods()
 {
-  QMutexLocker locker(&s_Mutex);
-  return static_cast<unsigned int>(s_Collection.size());
+  return snapshot().size();
 }
 
 
 ModInfo::Ptr ModInfo::getByIndex(unsigned int index)
 {
-  QMutexLocker locker(&s_Mutex);
-
-  if (index >= s_Collection.size() && index != ULONG_MAX) {
-    throw MyException(tr("invalid mod index: %1").arg(index));
-  }
-  if (index == ULONG_MAX) return s_Collection[ModInfo::getIndex("Overwrite")];
-  return s_Collection[index];
+  return snapshot().at(index);
 }
 
 
 std::vector<ModInfo::Ptr> ModInfo::getByModID(QString game, int modID)
 {
-  QMutexLocker locker(&s_Mutex);
+  return snapshot().byModID(game, modID);
+}
 
-  std::vector<unsigned int> match;
-  for (auto iter : s_ModsByModID) {
-    if (iter.first.second == modID) {
-      if (iter.first.first.compare(game, Qt::CaseInsensitive) == 0) {
-        match.insert(match.end(), iter.second.begin(), iter.second.end());
-      }
-    }
-  }
-  if (match.empty()) {
-    return std::vector<ModInfo::Ptr>();
-  }
+std::vector<std::vector<ModInfo::Ptr>> ModInfo::getByModIDs(
+  const std::vector<std::pair<QString, int>>& ids)
+{
+  std::vector<std::vector<ModInfo::Ptr>> result;
+  result.reserve(ids.size());
 
-  std::vector<ModInfo::Ptr> result;
-  for (auto iter : match) {
-    result.push_back(getByIndex(iter));
+  const auto& mods = snapshot();
+
+  for (auto&& [game, modID] : ids) {
+    result.push_back(mods.byModID(game, modID));
   }
 
   return result;
@@ -167,9 +270,14 @@ std::vector<ModInfo::Ptr> ModInfo::getByModID(QString game, int modID)
 
 ModInfo::Ptr ModInfo::getByName(const QString &name)
 {
-  QMutexLocker locker(&s_Mutex);
+  const auto& mods = snapshot();
 
-  return s_Collection[ModInfo::getIndex(name)];
+  const auto index = mods.index(name);
+  if (index == UINT_MAX) {
+    return {};
+  }
+
+  return mods.at(index);
 }
 
 
@@ -183,22 +291,25 @@ bool ModInfo::removeMod(unsigned int index)
 
   ModInfo::Ptr modInfo = s_Collection[index];
 
-  // remove the actual mod (this is the most likely to fail so we do this first)
+  // remove the actual mod (this is the most likely to fail so we do this first);
+  // it's only renamed here and recycled in the background, unless it can't be
+  // moved
   if (modInfo->isRegular()) {
-    if (!shellDelete(QStringList(modInfo->absolutePath()), true)) {
+    const QStringList path(modInfo->absolutePath());
+
+    if (!DeletionQueue::add(path, true).isEmpty() && !shellDelete(path, true)) {
       reportError(tr("remove: failed to delete mod '%1' directory").arg(modInfo->name()));
       return false;
     }
   }
 
   // update the indices
-  s_ModsByName.erase(s_ModsByName.find(modInfo->name()));
+  s_ModsByName.remove(nameKey(modInfo->name()));
 
-  auto iter = s_ModsByModID.find(std::pair<QString, int>(modInfo->gameName(), modInfo->nexusId()));
+  auto iter = s_ModsByModID.find({nameKey(modInfo->gameName()), modInfo->nexusId()});
   if (iter != s_ModsByModID.end()) {
-    std::vector<unsigned int> indices = iter->second;
-    indices.erase(std::remove(indices.begin(), indices.end(), index), indices.end());
-    s_ModsByModID[std::pair<QString, int>(modInfo->gameName(), modInfo->nexusId())] = indices;
+    auto& mods = iter.value();
+    mods.erase(std::remove(mods.begin(), mods.end(), modInfo), mods.end());
   }
 
   // finally, remove the mod from the collection
@@ -212,20 +323,30 @@ bool ModInfo::removeMod(unsigned int index)
 
 unsigned int ModInfo::getIndex(const QString &name)
 {
-  QMutexLocker locker(&s_Mutex);
+  return snapshot().index(name);
+}
 
-  std::map<QString, unsigned int>::iterator iter = s_ModsByName.find(name);
-  if (iter == s_ModsByName.end()) {
-    return UINT_MAX;
+unsigned int ModInfo::getIndex(const FilesOrigin& origin)
+{
+  const auto& mods = snapshot();
+
+  unsigned int index = UINT_MAX;
+  if (origin.modIndex(mods.generation(), index)) {
+    return index;
   }
 
-  return iter->second;
+  index = mods.index(ToQString(origin.getName()));
+  origin.setModIndex(mods.generation(), index);
+
+  return index;
 }
 
 unsigned int ModInfo::findMod(const boost::function<bool (ModInfo::Ptr)> &filter)
 {
-  for (unsigned int i = 0U; i < s_Collection.size(); ++i) {
-    if (filter(s_Collection[i])) {
+  const auto& mods = snapshot().mods();
+
+  for (unsigned int i = 0U; i < mods.size(); ++i) {
+    if (filter(mods[i])) {
       return i;
     }
   }
@@ -235,11 +356,27 @@ unsigned int ModInfo::findMod(const boost::function<bool (ModInfo::Ptr)> &filter
 
 void ModInfo::updateFromDisc(
   const QString& modsDirectory, OrganizerCore& core,
-  bool displayForeign, std::size_t refreshThreadCount)
+  bool displayForeign)
 {
-  TimeThis tt("ModInfo::updateFromDisc()");
+  Metrics::Timer tt("ModInfo::updateFromDisc()");
 
   QMutexLocker lock(&s_Mutex);
+
+  // readers keep seeing the previous snapshot until everything is loaded
+  g_DeferPublish = true;
+  Guard g([&]{ g_DeferPublish = false; });
+
+  // mods that didn't change on disk since they were read are kept as they
+  // are, the others are created again
+  std::map<QString, ModInfo::Ptr> previous;
+  for (auto& mod : s_Collection) {
+    if (dynamic_cast<ModInfoRegular*>(mod.data()) != nullptr) {
+      // pending changes must be on disk before meta.ini is read again
+      mod->saveMeta();
+      previous.emplace(mod->absolutePath(), mod);
+    }
+  }
+
   s_Collection.clear();
   s_NextID = 0;
   s_Overwrite = nullptr;
@@ -247,10 +384,59 @@ void ModInfo::updateFromDisc(
   { // list all directories in the mod directory and make a mod out of each
     QDir mods(QDir::fromNativeSeparators(modsDirectory));
     mods.setFilter(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    QStringList paths;
     QDirIterator modIter(mods);
     while (modIter.hasNext()) {
-      createFrom(QDir(modIter.next()), core);
+      paths.append(modIter.next());
     }
+
+    // checking the mods and parsing the meta.ini files is most of the time
+    // spent here, so it's done in parallel; the mods themselves are created
+    // on this thread
+    std::vector<ModInfo::Ptr> reused(paths.size());
+    std::vector<QVariantMap> metas(paths.size());
+    std::vector<ModInfoRegular::DiskTimes> times(paths.size());
+
+    {
+      TaskGroup reads(TaskPriority::Normal);
+
+      for (int i = 0; i < paths.size(); ++i) {
+        reads.run([&, i] {
+          times[i] = ModInfoRegular::readDiskTimes(paths[i]);
+
+          auto itor = previous.find(QDir(paths[i]).absolutePath());
+          if (itor != previous.end()) {
+            auto* mod = static_cast<ModInfoRegular*>(itor->second.data());
+            if (mod->isUpToDate(times[i])) {
+              reused[i] = itor->second;
+              return;
+            }
+          }
+
+          metas[i] = ModInfoRegular::readMetaFile(paths[i]);
+        });
+      }
+
+      reads.wait();
+    }
+
+    for (int i = 0; i < paths.size(); ++i) {
+      if (reused[i]) {
+        reused[i]->m_Index = s_Collection.size();
+        s_Collection.push_back(reused[i]);
+        continue;
+      }
+
+      auto mod = createFrom(QDir(paths[i]), core, &metas[i]);
+      if (auto* regular = dynamic_cast<ModInfoRegular*>(mod.data())) {
+        regular->setDiskTimes(times[i]);
+      }
+    }
+
+    log::debug(
+      "{} mods, {} unchanged",
+      paths.size(), std::count_if(reused.begin(), reused.end(), [](auto&& m){ return !m.isNull(); }));
   }
 
   auto* game = core.managedGame();
@@ -271,8 +457,17 @@ void ModInfo::updateFromDisc(
 
   std::sort(s_Collection.begin(), s_Collection.end(), ModInfo::ByName);
 
-  parallelMap(std::begin(s_Collection), std::end(s_Collection), &ModInfo::prefetch, refreshThreadCount);
+  {
+    TaskGroup prefetch(TaskPriority::Normal);
+
+    for (auto& mod : s_Collection) {
+      prefetch.run([mod] { mod->prefetch(); });
+    }
 
+    prefetch.wait();
+  }
+
+  g_DeferPublish = false;
   updateIndices();
 
 }
@@ -280,6 +475,8 @@ void ModInfo::updateFromDisc(
 
 void ModInfo::updateIndices()
 {
+  ++s_Generation;
+
   s_ModsByName.clear();
   s_ModsByModID.clear();
 
@@ -288,9 +485,16 @@ void ModInfo::updateIndices()
     QString game = s_Collection[i]->gameName();
     int modID = s_Collection[i]->nexusId();
     s_Collection[i]->m_Index = i;
-    s_ModsByName[modName] = i;
-    s_ModsByModID[std::pair<QString, int>(game, modID)].push_back(i);
+    s_ModsByName[nameKey(modName)] = i;
+    s_ModsByModID[{nameKey(game), modID}].push_back(s_Collection[i]);
   }
+
+  publish();
+}
+
+QString ModInfo::nameKey(const QString& name)
+{
+  return name.toCaseFolded();
 }
 
 
@@ -307,7 +511,10 @@ bool ModInfo::checkAllForUpdate(PluginContainer *pluginContainer, QObject *recei
   QDateTime earliest = QDateTime::currentDateTimeUtc();
   QDateTime latest = QDateTime::fromMSecsSinceEpoch(0);
   std::set<QString> games;
-  for (auto mod : s_Collection) {
+
+  const auto& mods = snapshot().mods();
+
+  for (auto& mod : mods) {
     if (mod->canBeUpdated()) {
       if (mod->getLastNexusUpdate() < earliest)
         earliest = mod->getLastNexusUpdate();
@@ -337,7 +544,7 @@ bool ModInfo::checkAllForUpdate(PluginContainer *pluginContainer, QObject *recei
 
   if (latest < QDateTime::currentDateTimeUtc().addMonths(-1)) {
     std::set<std::pair<QString, int>> organizedGames;
-    for (auto mod : s_Collection) {
+    for (auto& mod : mods) {
       if (mod->canBeUpdated() && mod->getLastNexusUpdate() < QDateTime::currentDateTimeUtc().addMonths(-1)) {
         organizedGames.insert(std::make_pair<QString, int>(mod->gameName().toLower(), mod->nexusId()));
       }
@@ -373,33 +580,42 @@ bool ModInfo::checkAllForUpdate(PluginContainer *pluginContainer, QObject *recei
 
 std::set<QSharedPointer<ModInfo>> ModInfo::filteredMods(QString gameName, QVariantList updateData, bool addOldMods, bool markUpdated)
 {
+  // the mods of this game by nexus id, so each update record is a single
+  // lookup instead of a walk through every mod
+  std::vector<QSharedPointer<ModInfo>> gameMods;
+  std::unordered_map<int, std::vector<QSharedPointer<ModInfo>>> modsByID;
+
+  for (auto& mod : snapshot().mods()) {
+    if (mod->gameName().compare(gameName, Qt::CaseInsensitive) == 0) {
+      gameMods.push_back(mod);
+      modsByID[mod->nexusId()].push_back(mod);
+    }
+  }
+
   std::set<QSharedPointer<ModInfo>> finalMods;
-  for (QVariant result : updateData) {
-    QVariantMap update = result.toMap();
-    std::copy_if(s_Collection.begin(), s_Collection.end(), std::inserter(finalMods, finalMods.end()), [=](QSharedPointer<ModInfo> info) -> bool {
-      if (info->nexusId() == update["mod_id"].toInt() && info->gameName().compare(gameName, Qt::CaseInsensitive) == 0)
-        if (info->getLastNexusUpdate().addSecs(-3600) < QDateTime::fromSecsSinceEpoch(update["latest_file_update"].toInt(), Qt::UTC))
-          return true;
-      return false;
-    });
+  for (const QVariant& result : updateData) {
+    const QVariantMap update = result.toMap();
+
+    auto itor = modsByID.find(update["mod_id"].toInt());
+    if (itor == modsByID.end())
+      continue;
+
+    const QDateTime lastUpdate = QDateTime::fromSecsSinceEpoch(update["latest_file_update"].toInt(), Qt::UTC);
+    for (auto info : itor->second)
+      if (info->getLastNexusUpdate().addSecs(-3600) < lastUpdate)
+        finalMods.insert(info);
   }
 
   if (addOldMods)
-    for (auto mod : s_Collection)
-      if (mod->getLastNexusUpdate() < QDateTime::currentDateTimeUtc().addMonths(-1) && mod->gameName().compare(gameName, Qt::CaseInsensitive) == 0)
+    for (auto mod : gameMods)
+      if (mod->getLastNexusUpdate() < QDateTime::currentDateTimeUtc().addMonths(-1))
         finalMods.insert(mod);
 
   if (markUpdated) {
-    std::set<QSharedPointer<ModInfo>> updates;
-    std::copy_if(s_Collection.begin(), s_Collection.end(), std::inserter(updates, updates.end()), [=](QSharedPointer<ModInfo> info) -> bool {
-      if (info->gameName().compare(gameName, Qt::CaseInsensitive) == 0 && info->canBeUpdated())
-        return true;
-      return false;
-    });
-    std::set<QSharedPointer<ModInfo>> diff;
-    std::set_difference(updates.begin(), updates.end(), finalMods.begin(), finalMods.end(), std::inserter(diff, diff.end()));
-    for (auto skipped : diff) {
-      skipped->setLastNexusUpdate(QDateTime::currentDateTimeUtc());
+    for (auto mod : gameMods) {
+      if (mod->canBeUpdated() && finalMods.find(mod) == finalMods.end()) {
+        mod->setLastNexusUpdate(QDateTime::currentDateTimeUtc());
+      }
     }
   }
   return finalMods;
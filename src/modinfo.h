@@ -23,12 +23,14 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "imodinterface.h"
 #include "ifiletree.h"
 #include "versioninfo.h"
+#include "shared/memoryusage.h"
 
 class OrganizerCore;
 class PluginContainer;
 class QDir;
 class QDateTime;
 
+#include <QHash>
 #include <QMutex>
 #include <QSharedPointer>
 #include <QString>
@@ -38,11 +40,12 @@ class QDateTime;
 #include <boost/function.hpp>
 
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
 namespace MOBase { class IPluginGame; }
-namespace MOShared { class DirectoryEntry; }
+namespace MOShared { class DirectoryEntry; class FilesOrigin; }
 
 /**
  * @brief Represents meta information about a single mod.
@@ -104,6 +107,58 @@ public: // Type definitions:
   };
 
 
+  /**
+   * @brief An immutable copy of the collection and its indexes.
+   *
+   * A new snapshot is published every time mods are added, removed or
+   * renamed; readers get it with snapshot(), without taking a lock.
+   */
+  class Snapshot
+  {
+  public:
+    /**
+     * @return the number of mods.
+     */
+    unsigned int size() const { return static_cast<unsigned int>(m_Mods.size()); }
+
+    /**
+     * @brief Retrieve a mod based on its index, without copying the pointer.
+     *
+     * @param index The index to look up, see ModInfo::getByIndex().
+     */
+    const ModInfo::Ptr& at(unsigned int index) const;
+
+    /**
+     * @return The index of the mod with the given name, or UINT_MAX.
+     */
+    unsigned int index(const QString& name) const;
+
+    /**
+     * @return The mods with the given nexus id; empty if there are none.
+     */
+    const std::vector<ModInfo::Ptr>& byModID(const QString& game, int modID) const;
+
+    /**
+     * @return All the mods, by index.
+     */
+    const std::vector<ModInfo::Ptr>& mods() const { return m_Mods; }
+
+    /**
+     * @return see ModInfo::generation()
+     */
+    int generation() const { return m_Generation; }
+
+  private:
+    friend class ModInfo;
+
+    std::vector<ModInfo::Ptr> m_Mods;
+    QHash<QString, unsigned int> m_ByName;
+    QHash<QPair<QString, int>, std::vector<ModInfo::Ptr>> m_ByModID;
+    ModInfo::Ptr m_Overwrite;
+    int m_Generation = 0;
+  };
+
+
 public: // Static functions:
 
   /**
@@ -111,9 +166,28 @@ public: // Static functions:
    */
   static void updateFromDisc(
     const QString &modDirectory, OrganizerCore& core,
-    bool displayForeign, std::size_t refreshThreadCount);
+    bool displayForeign);
+
+  static void clear();
+
+  /**
+   * @brief The collection as it was last published, read without locks.
+   *
+   * Every thread keeps the last snapshot it has seen and only picks up a new
+   * one once the collection has changed, so this is a single atomic load
+   * most of the time; the getters below all go through it.
+   *
+   * @note The reference is valid on the calling thread until the collection
+   *     changes and one of these functions is called again on that thread;
+   *     keep a ModInfo::Ptr to a mod to hold on to it for longer.
+   */
+  static const Snapshot& snapshot();
 
-  static void clear() { s_Collection.clear(); s_ModsByName.clear(); s_ModsByModID.clear(); }
+  /**
+   * @brief changes every time mods are added, removed or renamed, used by
+   *        profiles to know whether their mod list has to be parsed again
+   */
+  static int generation() { return s_Generation; }
 
   /**
    * @brief Retrieve the number of mods.
@@ -143,6 +217,18 @@ public: // Static functions:
    */
   static std::vector<ModInfo::Ptr> getByModID(QString game, int modID);
 
+  /**
+   * @brief Retrieve ModInfo objects for many mod ids at once, under a single
+   *        lock of the collection.
+   *
+   * @param ids Pairs of game name and mod id to look up.
+   *
+   * @return the mods for each pair, in the same order as the ids; the mods
+   *     of an id that's not known are empty
+   */
+  static std::vector<std::vector<ModInfo::Ptr>> getByModIDs(
+    const std::vector<std::pair<QString, int>>& ids);
+
   /**
    * @brief Retrieve a ModInfo object based on its name.
    *
@@ -176,6 +262,16 @@ public: // Static functions:
    */
   static unsigned int getIndex(const QString &name);
 
+  /**
+   * @brief Retrieve the index of the mod providing the files of an origin.
+   *
+   * The index is remembered by the origin until mods are added, removed or
+   * renamed, so this is cheaper than looking up the name of the origin.
+   *
+   * @return The index of the mod. If the mod doesn't exist, UINT_MAX is returned.
+   */
+  static unsigned int getIndex(const MOShared::FilesOrigin& origin);
+
   /**
    * @brief Retrieve the overwrite mod.
    */
@@ -588,6 +684,30 @@ public: // Methods after this do not come from IModInterface:
    */
   virtual void clearCaches() {}
 
+  /**
+   * @brief Estimate of the memory used by the cached sets of the mods this mod
+   *     is in conflict with, the count is the number of entries in the sets.
+   */
+  virtual MOShared::MemoryUsage conflictSetsMemory() const { return {}; }
+
+  /**
+   * @brief Estimate of the memory used by the cached file tree of this mod, the
+   *     count is the number of trees.
+   */
+  virtual MOShared::MemoryUsage fileTreeMemory() const { return {}; }
+
+  /**
+   * @brief Frees the cached sets of the mods this mod is in conflict with,
+   *     they're built again when needed; see MemoryAccounting.
+   */
+  virtual void releaseConflictSets() {}
+
+  /**
+   * @brief Frees the cached file tree of this mod, it's read again from the
+   *     disk when needed; see MemoryAccounting.
+   */
+  virtual void releaseFileTree() {}
+
   /**
    * @brief Retrieve the internal name of the mod. This is usually the same as the regular name,
    *     but with special mod types it might be used to distinguish between mods that have the same
@@ -750,6 +870,18 @@ public: // Methods after this do not come from IModInterface:
    */
   virtual bool isValid() const = 0;
 
+  /**
+   * @brief Prefetch content for this mod.
+   *
+   * This method can be used to prefetch content from the mod, e.g., for isValid()
+   * or getContents(). It is called from background threads, for all the mods
+   * when they are created and for the rows about to be shown in the mod list.
+   *
+   * @return true if anything had to be read, false if everything was already
+   *     cached.
+   */
+  virtual bool prefetch() = 0;
+
   /**
    * @brief Updates the mod to flag it as converted in order to ignore the alternate game
    *     warning.
@@ -925,14 +1057,6 @@ protected:
    */
   ModInfo(OrganizerCore& core);
 
-  /**
-   * @brief Prefetch content for this mod.
-   *
-   * This method can be used to prefetch content from the mod, e.g., for isValid()
-   * or getContents(). This method will only be called when first creating the mod
-   * using multiple threads for all the mods.
-   */
-  virtual void prefetch() = 0;
   static bool ByName(const ModInfo::Ptr &LHS, const ModInfo::Ptr &RHS);
 
 protected:
@@ -960,10 +1084,13 @@ protected:
    * @brief Create a new mod from the specified directory and add it to the collection.
    *
    * @param dir Directory to create from.
+   * @param meta The values in the mod's meta.ini if they were already read,
+   *   see ModInfoRegular::readMetaFile(); it's read if this is null.
    *
    * @return pointer to the info-structure of the newly created/added mod.
    */
-  static ModInfo::Ptr createFrom(const QDir& dir, OrganizerCore& core);
+  static ModInfo::Ptr createFrom(
+    const QDir& dir, OrganizerCore& core, const QVariantMap* meta = nullptr);
 
   /**
    * @brief Create a new "foreign-managed" mod from a tuple of plugin and archives.
@@ -979,19 +1106,37 @@ protected:
 
   static ModInfo::Ptr createFromOverwrite(OrganizerCore& core);
 
-  // update the m_Index attribute of all mods and the various mapping
+  // update the m_Index attribute of all mods and the various mapping, and
+  // publishes a new snapshot
   //
   static void updateIndices();
 
+  // publishes a copy of the collection for readers, must be called with
+  // s_Mutex held after every change
+  //
+  static void publish();
+
 protected:
 
+  // held by the functions that change the collection below, readers use the
+  // published snapshot instead
   static QMutex s_Mutex;
   static std::vector<ModInfo::Ptr> s_Collection;
   static ModInfo::Ptr s_Overwrite;
-  static std::map<QString, unsigned int, MOBase::FileNameComparator> s_ModsByName;
-  static std::map<std::pair<QString, int>, std::vector<unsigned int>> s_ModsByModID;
+  // both indexes are keyed by case-folded names, see nameKey(), so lookups
+  // are a single hash instead of case-insensitive compares; the mods of a
+  // mod id are stored directly, so they don't have to be looked up again in
+  // the collection
+  static QHash<QString, unsigned int> s_ModsByName;
+  static QHash<QPair<QString, int>, std::vector<ModInfo::Ptr>> s_ModsByModID;
+
+  // key for a mod or game name in the indexes
+  static QString nameKey(const QString& name);
   static int s_NextID;
 
+  // see generation()
+  static int s_Generation;
+
 };
 
 
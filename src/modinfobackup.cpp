@@ -15,7 +15,7 @@ QString ModInfoBackup::getDescription() const
 }
 
 
-ModInfoBackup::ModInfoBackup(const QDir& path, OrganizerCore& core)
-  : ModInfoRegular(path, core)
+ModInfoBackup::ModInfoBackup(const QDir& path, OrganizerCore& core, const QVariantMap* meta)
+  : ModInfoRegular(path, core, meta)
 {
 }
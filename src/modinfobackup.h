@@ -42,7 +42,7 @@ public:
 
 private:
 
-  ModInfoBackup(const QDir& path, OrganizerCore& core);
+  ModInfoBackup(const QDir& path, OrganizerCore& core, const QVariantMap* meta = nullptr);
 
 };
 
@@ -28,9 +28,12 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "modinfodialogconflicts.h"
 #include "modinfodialogcategories.h"
 #include "modinfodialognexus.h"
+#include "nexusinterface.h"
+#include "browsercache.h"
 #include "modinfodialogfiletree.h"
 #include "shared/directoryentry.h"
 #include "shared/filesorigin.h"
+#include <QTimer>
 #include <filesystem>
 
 using namespace MOBase;
@@ -40,6 +43,43 @@ namespace fs = std::filesystem;
 const int max_scan_for_context_menu = 50;
 
 
+// returns all the files in the given directory and its subdirectories, or
+// nothing if the group was cancelled; this runs on a background task
+//
+std::vector<QString> scanModFiles(const QString& rootPath, const TaskGroup& g)
+{
+  std::vector<QString> files;
+
+  const fs::path fsPath(rootPath.toStdWString());
+  std::error_code ec;
+
+  fs::recursive_directory_iterator itor(fsPath, ec), end;
+  if (ec) {
+    log::error("failed to scan '{}': {}", rootPath, ec.message());
+    return files;
+  }
+
+  while (itor != end) {
+    if (g.cancelled()) {
+      return {};
+    }
+
+    // skip directories
+    if (itor->is_regular_file(ec)) {
+      files.push_back(QString::fromStdWString(itor->path().native()));
+    }
+
+    itor.increment(ec);
+    if (ec) {
+      log::error("failed to scan '{}': {}", rootPath, ec.message());
+      break;
+    }
+  }
+
+  return files;
+}
+
+
 bool canPreviewFile(
   const PluginContainer& pluginContainer,
   bool isArchive, const QString& filename)
@@ -111,16 +151,14 @@ bool canUnhideFile(bool isArchive, const QString& filename)
   return true;
 }
 
-FileRenamer::RenameResults hideFile(FileRenamer& renamer, const QString &oldName)
+FileRenamer::Rename hideFile(const QString &oldName)
 {
-  const QString newName = oldName + ModInfo::s_HiddenExt;
-  return renamer.rename(oldName, newName);
+  return {oldName, oldName + ModInfo::s_HiddenExt};
 }
 
-FileRenamer::RenameResults unhideFile(FileRenamer& renamer, const QString &oldName)
+FileRenamer::Rename unhideFile(const QString &oldName)
 {
-  QString newName = oldName.left(oldName.length() - ModInfo::s_HiddenExt.length());
-  return renamer.rename(oldName, newName);
+  return {oldName, oldName.left(oldName.length() - ModInfo::s_HiddenExt.length())};
 }
 
 
@@ -183,7 +221,8 @@ ModInfoDialog::ModInfoDialog(
     m_plugin(plugin),
     m_modListView(modListView),
     m_initialTab(ModInfoTabIDs::None),
-    m_arrangingTabs(false)
+    m_arrangingTabs(false),
+    m_generation(0)
 {
   ui->setupUi(this);
 
@@ -210,7 +249,11 @@ ModInfoDialog::ModInfoDialog(
   connect(ui->nextMod, &QPushButton::clicked, [&]{ onNextMod(); });
 }
 
-ModInfoDialog::~ModInfoDialog() = default;
+ModInfoDialog::~ModInfoDialog()
+{
+  // waits for the scan
+  cancelPendingTabs();
+}
 
 template <class T>
 std::unique_ptr<ModInfoDialogTab> createTab(ModInfoDialog& d, ModInfoTabIDs id)
@@ -254,6 +297,10 @@ void ModInfoDialog::createTabs()
       tabInfo.tab.get(), &ModInfoDialogTab::originModified,
       [this](int originID){ onOriginModified(originID); });
 
+    connect(
+      tabInfo.tab.get(), &ModInfoDialogTab::originPatched,
+      [this](int originID){ onOriginPatched(originID); });
+
     connect(
       tabInfo.tab.get(), &ModInfoDialogTab::modOpen,
       [&](const QString& name){ setMod(name); update(); });
@@ -279,6 +326,7 @@ int ModInfoDialog::exec()
   const auto requestedTab = m_initialTab;
 
   update(true);
+  QTimer::singleShot(0, this, [&]{ prefetchAdjacent(); });
 
   if (noCustomTabRequested) {
     m_core.settings().widgets().restoreIndex(ui->tabWidget);
@@ -525,6 +573,10 @@ void ModInfoDialog::updateTabs(bool becauseOriginChanged)
 {
   auto* origin = getOrigin();
 
+  // a scan for the previous mod is not needed anymore
+  cancelPendingTabs();
+  const auto generation = ++m_generation;
+
   // list of tabs that should be updated
   std::vector<TabInfo*> interestedTabs;
 
@@ -558,35 +610,126 @@ void ModInfoDialog::updateTabs(bool becauseOriginChanged)
     tabInfo->tab->clear();
   }
 
-  // feed all the files from the filesystem
-  feedFiles(interestedTabs);
-
-  // call update() on all tabs
   for (auto* tabInfo : interestedTabs) {
-    tabInfo->tab->update();
+    if (tabInfo->tab->usesOriginFiles()) {
+      // waits for the scan
+      m_pendingTabs.push_back(tabInfo);
+    } else {
+      // tabs like notes and categories don't use files, they don't have to
+      // wait
+      tabInfo->tab->update();
+    }
   }
 
   // update the text colours
   setTabsColors();
-}
 
-void ModInfoDialog::feedFiles(std::vector<TabInfo*>& interestedTabs)
-{
+  if (m_pendingTabs.empty()) {
+    return;
+  }
+
   const auto rootPath = m_mod->absolutePath();
   if (rootPath.isEmpty()) {
+    onScanned(generation, {});
     return;
   }
 
-  const fs::path fsPath(rootPath.toStdWString());
+  // the directory is scanned once for all the tabs, on a background task so
+  // the dialog stays responsive when moving quickly between mods
+  m_scan.reset(new TaskGroup(TaskPriority::High));
 
-  for (const auto& entry : fs::recursive_directory_iterator(fsPath)) {
-    if (!entry.is_regular_file()) {
-      // skip directories
-      continue;
+  // the group waits for its tasks when it's destroyed, so it outlives the
+  // task
+  auto* group = m_scan.get();
+
+  group->run([this, group, generation, rootPath] {
+    auto files = scanModFiles(rootPath, *group);
+    if (group->cancelled()) {
+      return;
     }
 
-    const auto filePath = QString::fromStdWString(entry.path().native());
+    QMetaObject::invokeMethod(this, [this, generation, files=std::move(files)]() mutable {
+      onScanned(generation, std::move(files));
+    }, Qt::QueuedConnection);
+  });
+}
+
+void ModInfoDialog::onScanned(std::size_t generation, std::vector<QString> files)
+{
+  if (generation != m_generation) {
+    // files of another mod
+    return;
+  }
+
+  // the task has finished, this also tells updatePendingTab() that the files
+  // have been fed
+  m_scan.reset();
+
+  feedFiles(m_pendingTabs, files);
+
+  // the current tab is updated first, the others are updated from the event
+  // loop so the dialog can be used in the meantime
+  if (auto* tabInfo=currentTab()) {
+    updatePendingTab(tabInfo);
+  }
+
+  if (!m_pendingTabs.empty()) {
+    QTimer::singleShot(0, this, [this, generation]{
+      updateNextPendingTab(generation);
+    });
+  }
+}
 
+void ModInfoDialog::updatePendingTab(TabInfo* tabInfo)
+{
+  if (m_scan) {
+    // files haven't been fed yet, will be updated when the scan is done
+    return;
+  }
+
+  auto itor = std::find(m_pendingTabs.begin(), m_pendingTabs.end(), tabInfo);
+  if (itor == m_pendingTabs.end()) {
+    return;
+  }
+
+  m_pendingTabs.erase(itor);
+
+  tabInfo->tab->update();
+  setTabsColors();
+}
+
+void ModInfoDialog::updateNextPendingTab(std::size_t generation)
+{
+  if (generation != m_generation || m_pendingTabs.empty()) {
+    return;
+  }
+
+  updatePendingTab(m_pendingTabs.front());
+
+  if (!m_pendingTabs.empty()) {
+    QTimer::singleShot(0, this, [this, generation]{
+      updateNextPendingTab(generation);
+    });
+  }
+}
+
+void ModInfoDialog::cancelPendingTabs()
+{
+  if (m_scan) {
+    m_scan->cancel();
+    m_scan.reset();
+  }
+
+  m_pendingTabs.clear();
+}
+
+void ModInfoDialog::feedFiles(
+  const std::vector<TabInfo*>& interestedTabs,
+  const std::vector<QString>& files)
+{
+  const auto rootPath = m_mod->absolutePath();
+
+  for (const auto& filePath : files) {
     // for each tab
     for (auto* tabInfo : interestedTabs) {
       if (tabInfo->tab->feedFile(rootPath, filePath)) {
@@ -704,6 +847,14 @@ void ModInfoDialog::onOriginModified(int originID)
   updateTabs(true);
 }
 
+void ModInfoDialog::onOriginPatched(int)
+{
+  // the structure is up to date, but the flags of the mod depend on its files
+  m_mod->diskContentModified();
+
+  updateTabs(true);
+}
+
 void ModInfoDialog::onDeleteShortcut()
 {
   // forward the request to the current tab
@@ -754,6 +905,8 @@ void ModInfoDialog::onTabSelectionChanged()
 
   // this will call firstActivation() on the tab if needed
   if (auto* tabInfo=currentTab()) {
+    // a tab waiting for its update is updated as soon as it's selected
+    updatePendingTab(tabInfo);
     tabInfo->tab->activated();
   }
 }
@@ -799,6 +952,7 @@ void ModInfoDialog::onNextMod()
 
   setMod(mod);
   update();
+  QTimer::singleShot(0, this, [&]{ prefetchAdjacent(); });
 
   emit modChanged(*index);
 }
@@ -813,6 +967,34 @@ void ModInfoDialog::onPreviousMod()
 
   setMod(mod);
   update();
+  QTimer::singleShot(0, this, [&]{ prefetchAdjacent(); });
 
   emit modChanged(*index);
 }
+
+void ModInfoDialog::prefetchAdjacent()
+{
+  const auto index = ModInfo::getIndex(m_mod->name());
+  QString html;
+
+  for (auto adjacent : {m_modListView->nextMod(index), m_modListView->prevMod(index)}) {
+    if (!adjacent) {
+      continue;
+    }
+
+    auto mod = ModInfo::getByIndex(*adjacent);
+    if (!mod || mod->nexusId() <= 0) {
+      continue;
+    }
+
+    // the html is cached by the nexus interface, the tab gets it from there
+    // when the mod is shown
+    const QString description = mod->getNexusDescription();
+    if (!description.isEmpty()) {
+      html += NexusInterface::instance().descriptionAsHTML(
+        mod->gameName(), mod->nexusId(), description);
+    }
+  }
+
+  BrowserCache::prefetch(html);
+}
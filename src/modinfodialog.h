@@ -25,6 +25,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "tutorabledialog.h"
 #include "filerenamer.h"
 #include "modinfodialogfwd.h"
+#include "taskexecutor.h"
 
 namespace Ui { class ModInfoDialog; }
 namespace MOShared { class FilesOrigin; }
@@ -137,6 +138,18 @@ private:
   // are not fired incorrectly
   bool m_arrangingTabs;
 
+  // scans the directory of the mod in the background, see updateTabs()
+  std::unique_ptr<MOShared::TaskGroup> m_scan;
+
+  // incremented every time the tabs are updated, results of older scans and
+  // pending updates are ignored
+  std::size_t m_generation;
+
+  // tabs that are waiting for update(); they're given the files once the
+  // scan is finished, the current tab is updated first and the others one at
+  // a time from the event loop
+  std::vector<TabInfo*> m_pendingTabs;
+
 
   // creates all the tabs and connects events
   //
@@ -188,15 +201,35 @@ private:
   //
   void reAddTabs(const std::vector<bool>& visibility, ModInfoTabIDs sel);
 
-  // called by update(); clears tabs, feeds files and calls update() on all
-  // tabs, then setTabsColors()
+  // called by update(); clears tabs and updates the ones that don't use
+  // files right away, then scans the directory of the mod in the background
+  // for the others, see onScanned()
   //
   void updateTabs(bool becauseOriginChanged=false);
 
-  // goes through all files on the filesystem for the current mod and calls
-  // feedFile() on every tab until one accepts it
+  // called when the scan started by updateTabs() has finished; feeds the
+  // files to the pending tabs, updates the current tab and queues the others
+  //
+  void onScanned(std::size_t generation, std::vector<QString> files);
+
+  // calls update() on the given tab if it's pending
+  //
+  void updatePendingTab(TabInfo* tabInfo);
+
+  // updates the first pending tab and queues the next one
   //
-  void feedFiles(std::vector<TabInfo*>& interestedTabs);
+  void updateNextPendingTab(std::size_t generation);
+
+  // cancels the scan and forgets the pending tabs
+  //
+  void cancelPendingTabs();
+
+  // calls feedFile() on every tab for all the given files until one accepts
+  // it
+  //
+  void feedFiles(
+    const std::vector<TabInfo*>& interestedTabs,
+    const std::vector<QString>& files);
 
   // goes through all tabs and sets the tab text colour depending on whether
   // they have data or not
@@ -242,6 +275,12 @@ private:
   //
   void onNextMod();
 
+  // loads the images of the nexus descriptions of the mods before and after
+  // the current one in the background, so the nexus tab shows them right away
+  // when the user moves to them
+  //
+  void prefetchAdjacent();
+
   // called when the selects a tab; handles first activation
   //
   void onTabSelectionChanged();
@@ -255,6 +294,11 @@ private:
   // updates all the tabs that use origin files
   //
   void onOriginModified(int originID);
+
+  // called when a tab has modified the origin and updated the structure;
+  // updates the tabs without walking the origin again
+  //
+  void onOriginPatched(int originID);
 };
 
 #endif // MODINFODIALOG_H
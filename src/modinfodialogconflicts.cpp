@@ -8,10 +8,51 @@
 #include "shared/directoryentry.h"
 #include "shared/filesorigin.h"
 #include "shared/fileentry.h"
+#include "taskexecutor.h"
 
 using namespace MOShared;
 using namespace MOBase;
 
+// number of files handled by a task when building the lists
+const std::size_t ConflictChunkSize = 4096;
+
+std::size_t conflictChunkCount(std::size_t count)
+{
+  return (count + ConflictChunkSize - 1) / ConflictChunkSize;
+}
+
+// calls f(chunk, begin, end) for each chunk of `count` files, in parallel
+// when there is more than one; the directory structure is only read, and it
+// can't change while this waits on the ui thread
+//
+template <class F>
+void forEachConflictChunk(std::size_t count, F&& f)
+{
+  const std::size_t chunks = conflictChunkCount(count);
+
+  auto run = [&](std::size_t chunk) {
+    const std::size_t begin = chunk * ConflictChunkSize;
+    const std::size_t end = std::min(begin + ConflictChunkSize, count);
+    f(chunk, begin, end);
+  };
+
+  if (chunks <= 1) {
+    if (chunks == 1) {
+      run(0);
+    }
+
+    return;
+  }
+
+  TaskGroup g(TaskPriority::High);
+
+  for (std::size_t i=0; i<chunks; ++i) {
+    g.run([&, i]{ run(i); });
+  }
+
+  g.wait();
+}
+
 // if there are more than 50 selected items in the conflict tree, don't bother
 // checking whether menu items apply to them, just show all of them
 const std::size_t max_small_selection = 50;
@@ -113,9 +154,6 @@ bool ConflictsTab::canHandleUnmanaged() const
 
 void ConflictsTab::changeItemsVisibility(QTreeView* tree, bool visible)
 {
-  bool changed = false;
-  bool stop = false;
-
   const auto n = smallSelectionSize(tree);
 
   // logging
@@ -154,59 +192,46 @@ void ConflictsTab::changeItemsVisibility(QTreeView* tree, bool visible)
     return;
   }
 
-  forEachInSelection(tree, [&](const ConflictItem* item) {
-    if (stop) {
-      return false;
-    }
-
-    auto result = FileRenamer::RESULT_CANCEL;
+  std::vector<FileRenamer::Rename> renames;
 
+  forEachInSelection(tree, [&](const ConflictItem* item) {
     if (visible) {
       if (!item->canUnhide()) {
         log::debug("cannot unhide {}, skipping", item->relativeName());
         return true;
       }
 
-      result = unhideFile(renamer, item->fileName());
-
+      renames.push_back(unhideFile(item->fileName()));
     } else {
       if (!item->canHide()) {
         log::debug("cannot hide {}, skipping", item->relativeName());
         return true;
       }
 
-      result = hideFile(renamer, item->fileName());
-    }
-
-    switch (result) {
-      case FileRenamer::RESULT_OK: {
-        // will trigger a refresh at the end
-        changed = true;
-        break;
-      }
-
-      case FileRenamer::RESULT_SKIP: {
-        // nop
-        break;
-      }
-
-      case FileRenamer::RESULT_CANCEL: {
-        // stop right now, but make sure to refresh if needed
-        stop = true;
-        break;
-      }
+      renames.push_back(hideFile(item->fileName()));
     }
 
     return true;
   });
 
+  const auto results = renamer.rename(renames);
+
   log::debug("{} conflict files done", (visible ? "unhiding" : "hiding"));
 
-  if (changed) {
-    log::debug("triggering refresh");
+  const bool changed = std::any_of(results.begin(), results.end(), [](auto r) {
+    return (r == FileRenamer::RESULT_OK);
+  });
 
-    if (origin()) {
-      emitOriginModified();
+  if (changed) {
+    if (auto* o=origin()) {
+      // the structure is patched in one go instead of walking the origin
+      if (FileRenamer::patchStructure(
+        *core().directoryStructure(), *o, renames, results)) {
+        emitOriginPatched();
+      } else {
+        log::debug("triggering refresh");
+        emitOriginModified();
+      }
     }
 
     update();
@@ -632,77 +657,122 @@ bool GeneralConflictsTab::update()
   clear();
 
   if (m_tab->origin() != nullptr) {
-    const auto rootPath = m_tab->mod().absolutePath();
+    ConflictItem::Context cx;
+    cx.core = &m_core;
+    cx.origin = m_tab->origin();
+    cx.rootPath = m_tab->mod().absolutePath();
 
-    for (const auto& file : m_tab->origin()->getFiles()) {
-      // careful: these two strings are moved into createXItem() below
-      QString relativeName = QDir::fromNativeSeparators(ToQString(file->getRelativePath()));
-      QString fileName = rootPath + relativeName;
+    m_overwriteModel->setContext(cx);
+    m_overwrittenModel->setContext(cx);
+    m_noConflictModel->setContext(cx);
 
-      bool archive = false;
-      const int fileOrigin = file->getOrigin(archive);
+    const auto* overwriteCx = m_overwriteModel->context();
+    const auto* overwrittenCx = m_overwrittenModel->context();
+    const auto* noConflictCx = m_noConflictModel->context();
 
-      ++m_counts.numTotalFiles;
+    // files are classified in parallel, the items only remember the index of
+    // their file, their strings are built when they're shown
+    struct Chunk
+    {
+      GeneralConflictNumbers counts;
+      std::vector<ConflictItem> overwrite, overwritten, noConflict;
+    };
 
-      const auto& alternatives = file->getAlternatives();
+    const auto files = m_tab->origin()->getFiles();
+    const auto currId = m_tab->origin()->getID();
 
-      if (fileOrigin == m_tab->origin()->getID()) {
-        // current mod is primary origin, the winner
-        (archive) ? ++m_counts.numTotalArchive : ++m_counts.numTotalLoose;
+    std::vector<Chunk> chunks(conflictChunkCount(files.size()));
 
-        if (!alternatives.empty()) {
-          m_overwriteModel->add(createOverwriteItem(
-              file->getIndex(), archive,
-              std::move(fileName), std::move(relativeName), alternatives));
+    forEachConflictChunk(files.size(), [&](auto chunk, auto begin, auto end) {
+      Chunk& c = chunks[chunk];
 
-          ++m_counts.numOverwrite;
-          if (archive) {
-            ++m_counts.numOverwriteArchive;
-          }
-          else {
-            ++m_counts.numOverwriteLoose;
+      for (std::size_t i=begin; i<end; ++i) {
+        const auto& file = files[i];
+
+        bool archive = false;
+        const int fileOrigin = file->getOrigin(archive);
+
+        ++c.counts.numTotalFiles;
+
+        const auto& alternatives = file->getAlternatives();
+
+        if (fileOrigin == currId) {
+          // current mod is primary origin, the winner
+          (archive) ? ++c.counts.numTotalArchive : ++c.counts.numTotalLoose;
+
+          if (!alternatives.empty()) {
+            c.overwrite.emplace_back(
+              overwriteCx, ConflictItem::Kind::Overwrite,
+              file->getIndex(), fileOrigin, true, archive);
+
+            ++c.counts.numOverwrite;
+            if (archive) {
+              ++c.counts.numOverwriteArchive;
+            }
+            else {
+              ++c.counts.numOverwriteLoose;
+            }
+          } else {
+            // otherwise, put the file in the noconflict tree
+            c.noConflict.emplace_back(
+              noConflictCx, ConflictItem::Kind::NoConflict,
+              file->getIndex(), fileOrigin, false, archive);
+
+            ++c.counts.numNonConflicting;
+            if (archive) {
+              ++c.counts.numNonConflictingArchive;
+            }
+            else {
+              ++c.counts.numNonConflictingLoose;
+            }
           }
         } else {
-          // otherwise, put the file in the noconflict tree
-            m_noConflictModel->add(createNoConflictItem(
-            file->getIndex(), archive,
-              std::move(fileName), std::move(relativeName)));
-
-          ++m_counts.numNonConflicting;
-          if (archive) {
-            ++m_counts.numNonConflictingArchive;
+          auto currModAlt = std::find_if(alternatives.begin(), alternatives.end(),
+            [&currId](auto const& alt) {
+              return currId == alt.originID();
+            });
+
+          if (currModAlt == alternatives.end()) {
+            log::error(
+              "Mod {} not found in the list of origins for file {}",
+              m_tab->origin()->getName(),
+              cx.rootPath + QDir::fromNativeSeparators(ToQString(file->getRelativePath())));
+
+            continue;
+          }
+
+          bool currModFileArchive = currModAlt->isFromArchive();
+
+          c.overwritten.emplace_back(
+            overwrittenCx, ConflictItem::Kind::Overwritten,
+            file->getIndex(), fileOrigin, true, archive);
+
+          ++c.counts.numOverwritten;
+          if (currModFileArchive) {
+            ++c.counts.numOverwrittenArchive;
+            ++c.counts.numTotalArchive;
           }
           else {
-            ++m_counts.numNonConflictingLoose;
+            ++c.counts.numOverwrittenLoose;
+            ++c.counts.numTotalLoose;
           }
         }
-      } else {
-        auto currId = m_tab->origin()->getID();
-        auto currModAlt = std::find_if(alternatives.begin(), alternatives.end(),
-          [&currId](auto const& alt) {
-            return currId == alt.originID();
-          });
-
-        if (currModAlt == alternatives.end()) {
-          log::error("Mod {} not found in the list of origins for file {}", m_tab->origin()->getName(), fileName);
-          continue;
-        }
+      }
+    });
 
-        bool currModFileArchive = currModAlt->isFromArchive();
+    for (auto& c : chunks) {
+      m_counts.add(c.counts);
 
-        m_overwrittenModel->add(createOverwrittenItem(
-          file->getIndex(), fileOrigin, archive,
-          std::move(fileName), std::move(relativeName)));
+      for (auto& item : c.overwrite) {
+        m_overwriteModel->add(std::move(item));
+      }
 
-        ++m_counts.numOverwritten;
-        if (currModFileArchive) {
-          ++m_counts.numOverwrittenArchive;
-          ++m_counts.numTotalArchive;
-        }
-        else {
-          ++m_counts.numOverwrittenLoose;
-          ++m_counts.numTotalLoose;
-        }
+      for (auto& item : c.overwritten) {
+        m_overwrittenModel->add(std::move(item));
+      }
+
+      for (auto& item : c.noConflict) {
+        m_noConflictModel->add(std::move(item));
       }
     }
 
@@ -716,49 +786,21 @@ bool GeneralConflictsTab::update()
   return (m_counts.numOverwrite > 0 || m_counts.numOverwritten > 0);
 }
 
-ConflictItem GeneralConflictsTab::createOverwriteItem(
-  FileIndex index, bool archive, QString fileName, QString relativeName,
-  const MOShared::AlternativesVector& alternatives)
-{
-  const auto& ds = *m_core.directoryStructure();
-  std::wstring altString;
-
-  for (const auto& alt : alternatives) {
-    if (!altString.empty()) {
-      altString += L", ";
-    }
-
-    altString += ds.getOriginByID(alt.originID()).getName();
-  }
-
-  auto origin = ToQString(ds.getOriginByID(alternatives.back().originID()).getName());
-
-  return ConflictItem(
-    ToQString(altString), std::move(relativeName), QString(), index,
-    std::move(fileName), true, std::move(origin), archive);
-}
-
-ConflictItem GeneralConflictsTab::createNoConflictItem(
-  FileIndex index, bool archive, QString fileName, QString relativeName)
-{
-  return ConflictItem(
-    QString(), std::move(relativeName), QString(), index,
-    std::move(fileName), false, QString(), archive);
-}
-
-ConflictItem GeneralConflictsTab::createOverwrittenItem(
-  FileIndex index, int fileOrigin, bool archive,
-  QString fileName, QString relativeName)
+void GeneralConflictsTab::GeneralConflictNumbers::add(
+  const GeneralConflictNumbers& o)
 {
-  const auto& ds = *m_core.directoryStructure();
-  const FilesOrigin& realOrigin = ds.getOriginByID(fileOrigin);
-
-  QString after = ToQString(realOrigin.getName());
-  QString altOrigin = after;
-
-  return ConflictItem(
-    QString(), std::move(relativeName), std::move(after),
-    index, std::move(fileName), true, std::move(altOrigin), archive);
+  numTotalFiles += o.numTotalFiles;
+  numTotalLoose += o.numTotalLoose;
+  numTotalArchive += o.numTotalArchive;
+  numNonConflicting += o.numNonConflicting;
+  numNonConflictingLoose += o.numNonConflictingLoose;
+  numNonConflictingArchive += o.numNonConflictingArchive;
+  numOverwrite += o.numOverwrite;
+  numOverwriteLoose += o.numOverwriteLoose;
+  numOverwriteArchive += o.numOverwriteArchive;
+  numOverwritten += o.numOverwritten;
+  numOverwrittenLoose += o.numOverwrittenLoose;
+  numOverwrittenArchive += o.numOverwrittenArchive;
 }
 
 QString percent(int a, int b) {
@@ -950,26 +992,32 @@ void AdvancedConflictsTab::update()
   clear();
 
   if (m_tab->origin() != nullptr) {
-    const auto rootPath = m_tab->mod().absolutePath();
+    ConflictItem::Context cx;
+    cx.core = &m_core;
+    cx.origin = m_tab->origin();
+    cx.rootPath = m_tab->mod().absolutePath();
+    cx.showAllAlts = ui->conflictsAdvancedShowAll->isChecked();
 
-    const auto& files = m_tab->origin()->getFiles();
-    m_model->reserve(files.size());
+    m_model->setContext(std::move(cx));
+
+    const bool showNoConflict = ui->conflictsAdvancedShowNoConflict->isChecked();
 
-    for (const auto& file : files) {
-      // careful: these two strings are moved into createItem() below
-      QString relativeName = QDir::fromNativeSeparators(ToQString(file->getRelativePath()));
-      QString fileName = rootPath + relativeName;
+    const auto files = m_tab->origin()->getFiles();
+    std::vector<std::vector<ConflictItem>> chunks(conflictChunkCount(files.size()));
 
-      bool archive = false;
-      const int fileOrigin = file->getOrigin(archive);
-      const auto& alternatives = file->getAlternatives();
+    forEachConflictChunk(files.size(), [&](auto chunk, auto begin, auto end) {
+      for (std::size_t i=begin; i<end; ++i) {
+        if (auto item=createItem(*files[i], showNoConflict)) {
+          chunks[chunk].push_back(std::move(*item));
+        }
+      }
+    });
 
-      auto item = createItem(
-        file->getIndex(), fileOrigin, archive,
-        std::move(fileName), std::move(relativeName), alternatives);
+    m_model->reserve(files.size());
 
-      if (item) {
-        m_model->add(std::move(*item));
+    for (auto& c : chunks) {
+      for (auto& item : c) {
+        m_model->add(std::move(item));
       }
     }
 
@@ -978,134 +1026,51 @@ void AdvancedConflictsTab::update()
 }
 
 std::optional<ConflictItem> AdvancedConflictsTab::createItem(
-  FileIndex index, int fileOrigin, bool archive,
-  QString fileName, QString relativeName,
-  const MOShared::AlternativesVector& alternatives)
+  const FileEntry& file, bool showNoConflict) const
 {
-  const auto& ds = *m_core.directoryStructure();
+  bool archive = false;
+  const int fileOrigin = file.getOrigin(archive);
+  const auto& alternatives = file.getAlternatives();
 
-  std::wstring before, after;
-
-  auto currOrigin = m_tab->origin();
+  const auto* currOrigin = m_tab->origin();
   bool isCurrOrigArchive = archive;
 
-  if (!alternatives.empty()) {
-    const bool showAllAlts = ui->conflictsAdvancedShowAll->isChecked();
-
-    if (currOrigin->getID() == fileOrigin) {
-      // current origin is the active winner, all alternatives go in 'before'
+  if (!alternatives.empty() && currOrigin->getID() != fileOrigin) {
+    // current mod is one of the alternatives, find its position
 
-      if (showAllAlts) {
-        for (const auto& alt : alternatives)
-        {
-          const auto& altOrigin = ds.getOriginByID(alt.originID());
-          if (!before.empty()) {
-            before += L", ";
-          }
+    auto currOrgId = currOrigin->getID();
 
-          before += altOrigin.getName();
-        }
-      }
-      else {
-        // only add nearest, which is the last element of alternatives
-        const auto& altOrigin = ds.getOriginByID(alternatives.back().originID());
+    auto currModIter = std::find_if(alternatives.begin(), alternatives.end(),
+      [&currOrgId](auto const& alt) {
+        return currOrgId == alt.originID();
+    });
 
-        before += altOrigin.getName();
-      }
+    if (currModIter == alternatives.end()) {
+      log::error(
+        "Mod {} not found in the list of origins for file {}",
+        currOrigin->getName(),
+        m_model->context()->rootPath +
+          QDir::fromNativeSeparators(ToQString(file.getRelativePath())));
 
+      return {};
     }
-    else {
-      // current mod is one of the alternatives, find its position
 
-      auto currOrgId = currOrigin->getID();
-
-      auto currModIter = std::find_if(alternatives.begin(), alternatives.end(),
-        [&currOrgId](auto const& alt) {
-          return currOrgId == alt.originID();
-      });
-
-      if (currModIter == alternatives.end()) {
-        log::error("Mod {} not found in the list of origins for file {}", currOrigin->getName(), fileName);
-        return {};
-      }
-
-      isCurrOrigArchive = currModIter->isFromArchive();
-
-      if (showAllAlts) {
-        // fills 'before' and 'after' with all the alternatives that come
-        // before and after the current mod, trusting the alternatives vector to be
-        // already sorted correctly
-
-        for (auto iter = alternatives.begin(); iter != alternatives.end(); iter++) {
-
-          const auto& altOrigin = ds.getOriginByID(iter->originID());
-
-          if (iter < currModIter) {
-            // mod comes before current
-
-            if (!before.empty()) {
-              before += L", ";
-            }
-
-            before += altOrigin.getName();
-          }
-          else if (iter > currModIter) {
-            // mod comes after current
-
-            if (!after.empty()) {
-              after += L", ";
-            }
-
-            after += altOrigin.getName();
-          }
-        }
-
-        // also add the active winner origin (the one outside alternatives) to 'after'
-        if (!after.empty()) {
-          after += L", ";
-        }
-        after += ds.getOriginByID(fileOrigin).getName();
-
-
-      }
-      else {
-        // only show nearest origins
-
-        // before
-        if (currModIter > alternatives.begin()) {
-          auto previousOrigId = (currModIter-1)->originID();
-          before += ds.getOriginByID(previousOrigId).getName();
-        }
-
-        // after
-        if (currModIter < (alternatives.end() - 1)) {
-          auto followingOrigId = (currModIter + 1)->originID();
-          after += ds.getOriginByID(followingOrigId).getName();
-        }
-        else {
-          // current mod is last of alternatives, so closest to the active winner
-
-          after += ds.getOriginByID(fileOrigin).getName();
-        }
-
-      }
-    }
+    isCurrOrigArchive = currModIter->isFromArchive();
   }
 
-  const bool hasAlts = !before.empty() || !after.empty();
+  // the before and after columns are filled when there are alternatives,
+  // see ConflictItem::resolveAdvanced()
+  const bool hasAlts = !alternatives.empty();
 
   if (!hasAlts) {
     // if both before and after are empty, it means this file has no conflicts
     // at all, only display it if the user wants it
-    if (!ui->conflictsAdvancedShowNoConflict->isChecked()) {
+    if (!showNoConflict) {
       return {};
     }
   }
 
-  auto beforeQS = QString::fromStdWString(before);
-  auto afterQS = QString::fromStdWString(after);
-
   return ConflictItem(
-    std::move(beforeQS), std::move(relativeName), std::move(afterQS),
-    index, std::move(fileName), hasAlts, QString(), isCurrOrigArchive);
+    m_model->context(), ConflictItem::Kind::Advanced,
+    file.getIndex(), fileOrigin, hasAlts, isCurrOrigArchive);
 }
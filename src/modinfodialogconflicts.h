@@ -69,23 +69,13 @@ private:
     void clear() {
       *this = {};
     };
+
+    // adds the numbers of a chunk of files counted separately
+    void add(const GeneralConflictNumbers& o);
   };
 
   GeneralConflictNumbers m_counts;
 
-  ConflictItem createOverwriteItem(
-    MOShared::FileIndex index, bool archive,
-    QString fileName, QString relativeName,
-    const MOShared::AlternativesVector& alternatives);
-
-  ConflictItem createNoConflictItem(
-    MOShared::FileIndex index, bool archive,
-    QString fileName, QString relativeName);
-
-  ConflictItem createOverwrittenItem(
-    MOShared::FileIndex index, int fileOrigin, bool archive,
-    QString fileName, QString relativeName);
-
   void updateUICounters();
 
   void onOverwriteActivated(const QModelIndex& index);
@@ -117,10 +107,11 @@ private:
   FilterWidget m_filter;
   ConflictListModel* m_model;
 
+  // returns an empty item if the file shouldn't be in the list; this is
+  // called concurrently for different files
+  //
   std::optional<ConflictItem> createItem(
-    MOShared::FileIndex index, int fileOrigin, bool archive,
-    QString fileName, QString relativeName,
-    const MOShared::AlternativesVector& alternatives);
+    const MOShared::FileEntry& file, bool showNoConflict) const;
 };
 
 
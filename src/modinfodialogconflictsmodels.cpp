@@ -1,49 +1,245 @@
 #include "modinfodialogconflictsmodels.h"
 #include "modinfodialog.h"
+#include "organizercore.h"
+#include "taskexecutor.h"
+#include "shared/directoryentry.h"
+#include "shared/filesorigin.h"
 #include <utility.h>
 
+using namespace MOShared;
 using MOBase::naturalCompare;
+using MOBase::ToQString;
+
+// number of items that get their strings built by a task before sorting
+static const std::size_t ResolveChunkSize = 2048;
+
 
 ConflictItem::ConflictItem(
-    QString before, QString relativeName, QString after,
-    MOShared::FileIndex index,  QString fileName,
-      bool hasAltOrigins, QString altOrigin,  bool archive) :
-      m_before(std::move(before)),
-      m_relativeName(std::move(relativeName)),
-      m_after(std::move(after)),
-      m_index(index),
-      m_fileName(std::move(fileName)),
-      m_hasAltOrigins(hasAltOrigins),
-      m_altOrigin(std::move(altOrigin)),
-      m_isArchive(archive)
+  const Context* cx, Kind kind, FileIndex index, int fileOrigin,
+  bool hasAltOrigins, bool archive) :
+    m_context(cx), m_kind(kind), m_index(index), m_fileOrigin(fileOrigin),
+    m_hasAltOrigins(hasAltOrigins), m_isArchive(archive),
+    m_namesResolved(false), m_originsResolved(false)
 {
 }
 
 const QString& ConflictItem::before() const
 {
+  resolveOrigins();
   return m_before;
 }
 
 const QString& ConflictItem::relativeName() const
 {
+  resolveNames();
   return m_relativeName;
 }
 
 const QString& ConflictItem::after() const
 {
+  resolveOrigins();
   return m_after;
 }
 
 const QString& ConflictItem::fileName() const
 {
+  resolveNames();
   return m_fileName;
 }
 
 const QString& ConflictItem::altOrigin() const
 {
+  resolveOrigins();
   return m_altOrigin;
 }
 
+void ConflictItem::resolveNames() const
+{
+  if (m_namesResolved) {
+    return;
+  }
+
+  m_namesResolved = true;
+
+  const auto file = m_context->core->directoryStructure()->getFileByIndex(m_index);
+  if (!file) {
+    return;
+  }
+
+  m_relativeName = QDir::fromNativeSeparators(ToQString(file->getRelativePath()));
+  m_fileName = m_context->rootPath + m_relativeName;
+}
+
+void ConflictItem::resolveOrigins() const
+{
+  if (m_originsResolved) {
+    return;
+  }
+
+  m_originsResolved = true;
+
+  const auto& ds = *m_context->core->directoryStructure();
+
+  const auto file = ds.getFileByIndex(m_index);
+  if (!file) {
+    return;
+  }
+
+  const auto alternatives = file->getAlternatives();
+
+  switch (m_kind)
+  {
+    case Kind::Overwrite:
+    {
+      if (alternatives.empty()) {
+        break;
+      }
+
+      std::wstring altString;
+
+      for (const auto& alt : alternatives) {
+        if (!altString.empty()) {
+          altString += L", ";
+        }
+
+        altString += ds.getOriginByID(alt.originID()).getName();
+      }
+
+      m_before = ToQString(altString);
+      m_altOrigin = ToQString(ds.getOriginByID(alternatives.back().originID()).getName());
+
+      break;
+    }
+
+    case Kind::NoConflict:
+    {
+      break;
+    }
+
+    case Kind::Overwritten:
+    {
+      m_after = ToQString(ds.getOriginByID(m_fileOrigin).getName());
+      m_altOrigin = m_after;
+      break;
+    }
+
+    case Kind::Advanced:
+    {
+      resolveAdvanced(ds, alternatives);
+      break;
+    }
+  }
+}
+
+void ConflictItem::resolveAdvanced(
+  const DirectoryEntry& ds, AlternativesView alternatives) const
+{
+  if (alternatives.empty()) {
+    return;
+  }
+
+  std::wstring before, after;
+
+  const auto* currOrigin = m_context->origin;
+  const bool showAllAlts = m_context->showAllAlts;
+
+  if (currOrigin->getID() == m_fileOrigin) {
+    // current origin is the active winner, all alternatives go in 'before'
+
+    if (showAllAlts) {
+      for (const auto& alt : alternatives)
+      {
+        const auto& altOrigin = ds.getOriginByID(alt.originID());
+        if (!before.empty()) {
+          before += L", ";
+        }
+
+        before += altOrigin.getName();
+      }
+    }
+    else {
+      // only add nearest, which is the last element of alternatives
+      const auto& altOrigin = ds.getOriginByID(alternatives.back().originID());
+
+      before += altOrigin.getName();
+    }
+  }
+  else {
+    // current mod is one of the alternatives, find its position; items where
+    // it's missing are not added to the list
+
+    auto currOrgId = currOrigin->getID();
+
+    auto currModIter = std::find_if(alternatives.begin(), alternatives.end(),
+      [&currOrgId](auto const& alt) {
+        return currOrgId == alt.originID();
+    });
+
+    if (currModIter == alternatives.end()) {
+      return;
+    }
+
+    if (showAllAlts) {
+      // fills 'before' and 'after' with all the alternatives that come
+      // before and after the current mod, trusting the alternatives vector to be
+      // already sorted correctly
+
+      for (auto iter = alternatives.begin(); iter != alternatives.end(); iter++) {
+
+        const auto& altOrigin = ds.getOriginByID(iter->originID());
+
+        if (iter < currModIter) {
+          // mod comes before current
+
+          if (!before.empty()) {
+            before += L", ";
+          }
+
+          before += altOrigin.getName();
+        }
+        else if (iter > currModIter) {
+          // mod comes after current
+
+          if (!after.empty()) {
+            after += L", ";
+          }
+
+          after += altOrigin.getName();
+        }
+      }
+
+      // also add the active winner origin (the one outside alternatives) to 'after'
+      if (!after.empty()) {
+        after += L", ";
+      }
+      after += ds.getOriginByID(m_fileOrigin).getName();
+    }
+    else {
+      // only show nearest origins
+
+      // before
+      if (currModIter > alternatives.begin()) {
+        auto previousOrigId = (currModIter-1)->originID();
+        before += ds.getOriginByID(previousOrigId).getName();
+      }
+
+      // after
+      if (currModIter < (alternatives.end() - 1)) {
+        auto followingOrigId = (currModIter + 1)->originID();
+        after += ds.getOriginByID(followingOrigId).getName();
+      }
+      else {
+        // current mod is last of alternatives, so closest to the active winner
+
+        after += ds.getOriginByID(m_fileOrigin).getName();
+      }
+    }
+  }
+
+  m_before = QString::fromStdWString(before);
+  m_after = QString::fromStdWString(after);
+}
+
 bool ConflictItem::hasAlts() const
 {
   return m_hasAltOrigins;
@@ -109,6 +305,17 @@ void ConflictListModel::reserve(std::size_t s)
   m_items.reserve(s);
 }
 
+void ConflictListModel::setContext(ConflictItem::Context cx)
+{
+  Q_ASSERT(m_items.empty());
+  m_context = std::move(cx);
+}
+
+const ConflictItem::Context* ConflictListModel::context() const
+{
+  return &m_context;
+}
+
 QModelIndex ConflictListModel::index(int row, int col, const QModelIndex&) const
 {
   return createIndex(row, col);
@@ -283,6 +490,28 @@ void ConflictListModel::doSort()
 
   const auto& col = m_columns[c];
 
+  // builds the strings of the sorted column for all the items in parallel
+  // instead of one by one in the comparisons
+  const std::size_t chunks =
+    (m_items.size() + ResolveChunkSize - 1) / ResolveChunkSize;
+
+  if (chunks > 1) {
+    TaskGroup g(TaskPriority::High);
+
+    for (std::size_t i=0; i<chunks; ++i) {
+      g.run([&, i] {
+        const std::size_t begin = i * ResolveChunkSize;
+        const std::size_t end = std::min(begin + ResolveChunkSize, m_items.size());
+
+        for (std::size_t j=begin; j<end; ++j) {
+          (m_items[j].*col.getText)();
+        }
+      });
+    }
+
+    g.wait();
+  }
+
   // avoids branching on sort order while sorting
   auto sortAsc = [&](const auto& a, const auto& b) {
     return (naturalCompare((a.*col.getText)(), (b.*col.getText)()) < 0);
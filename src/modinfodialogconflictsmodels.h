@@ -1,14 +1,42 @@
 #include "shared/fileentry.h"
 
 class PluginContainer;
-
+class OrganizerCore;
+
+// a file in one of the conflict lists
+//
+// items only remember the index of their file, the strings are built the
+// first time they're needed, such as when the row is shown or when the
+// list is sorted; this can be done concurrently for different items
+//
 class ConflictItem
 {
 public:
+  // which list the item is in, decides what goes in the before and after
+  // columns
+  enum class Kind
+  {
+    Overwrite,
+    NoConflict,
+    Overwritten,
+    Advanced
+  };
+
+  // shared by all the items of a list, see ConflictListModel::setContext()
+  struct Context
+  {
+    OrganizerCore* core = nullptr;
+    const MOShared::FilesOrigin* origin = nullptr;
+    QString rootPath;
+
+    // whether the advanced list shows all the alternatives or only the
+    // nearest ones
+    bool showAllAlts = false;
+  };
+
   ConflictItem(
-    QString before, QString relativeName, QString after,
-    MOShared::FileIndex index,  QString fileName,
-    bool hasAltOrigins, QString altOrigin,  bool archive);
+    const Context* cx, Kind kind, MOShared::FileIndex index, int fileOrigin,
+    bool hasAltOrigins, bool archive);
 
   const QString& before() const;
   const QString& relativeName() const;
@@ -30,14 +58,35 @@ public:
   bool canExplore() const;
 
 private:
-  QString m_before;
-  QString m_relativeName;
-  QString m_after;
+  const Context* m_context;
+  Kind m_kind;
   MOShared::FileIndex m_index;
-  QString m_fileName;
+  int m_fileOrigin;
   bool m_hasAltOrigins;
-  QString m_altOrigin;
   bool m_isArchive;
+
+  // whether the names and the origin strings have been built
+  mutable bool m_namesResolved;
+  mutable bool m_originsResolved;
+
+  mutable QString m_before;
+  mutable QString m_relativeName;
+  mutable QString m_after;
+  mutable QString m_fileName;
+  mutable QString m_altOrigin;
+
+  // builds the relative name and file name
+  //
+  void resolveNames() const;
+
+  // builds the before, after and alt origin strings
+  //
+  void resolveOrigins() const;
+
+  // the origin strings of the advanced list
+  //
+  void resolveAdvanced(
+    const MOShared::DirectoryEntry& ds, MOShared::AlternativesView alternatives) const;
 };
 
 
@@ -57,6 +106,12 @@ public:
   void clear();
   void reserve(std::size_t s);
 
+  // sets the context used by the items of this list, must be called on an
+  // empty list
+  //
+  void setContext(ConflictItem::Context cx);
+  const ConflictItem::Context* context() const;
+
   QModelIndex index(int row, int col, const QModelIndex& ={}) const override;
   QModelIndex parent(const QModelIndex&) const override;
   int rowCount(const QModelIndex& parent={}) const override;
@@ -74,6 +129,7 @@ public:
 private:
   QTreeView* m_tree;
   std::vector<Column> m_columns;
+  ConflictItem::Context m_context;
   std::vector<ConflictItem> m_items;
   int m_sortColumn;
   Qt::SortOrder m_sortOrder;
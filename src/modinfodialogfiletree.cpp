@@ -316,9 +316,6 @@ void FileTreeTab::changeVisibility(bool visible)
 {
   const auto selection = ui->filetree->selectionModel()->selectedRows();
 
-  bool changed = false;
-  bool stop = false;
-
   log::debug(
     "{} {} filetree files",
     (visible ? "unhiding" : "hiding"), selection.size());
@@ -332,53 +329,43 @@ void FileTreeTab::changeVisibility(bool visible)
 
   FileRenamer renamer(parentWidget(), flags);
 
-  for (const auto& index : selection) {
-    if (stop) {
-      break;
-    }
+  std::vector<FileRenamer::Rename> renames;
 
+  for (const auto& index : selection) {
     const QString path = m_fs->filePath(index);
-    auto result = FileRenamer::RESULT_CANCEL;
 
     if (visible) {
       if (!canUnhideFile(false, path)) {
         log::debug("cannot unhide {}, skipping", path);
         continue;
       }
-      result = unhideFile(renamer, path);
+      renames.push_back(unhideFile(path));
     } else {
       if (!canHideFile(false, path)) {
         log::debug("cannot hide {}, skipping", path);
         continue;
       }
-      result = hideFile(renamer, path);
-    }
-
-    switch (result) {
-      case FileRenamer::RESULT_OK: {
-        // will trigger a refresh at the end
-        changed = true;
-        break;
-      }
-
-      case FileRenamer::RESULT_SKIP: {
-        // nop
-        break;
-      }
-
-      case FileRenamer::RESULT_CANCEL: {
-        // stop right now, but make sure to refresh if needed
-        stop = true;
-        break;
-      }
+      renames.push_back(hideFile(path));
     }
   }
 
+  const auto results = renamer.rename(renames);
+
   log::debug("{} filetree files done", (visible ? "unhiding" : "hiding"));
 
+  const bool changed = std::any_of(results.begin(), results.end(), [](auto r) {
+    return (r == FileRenamer::RESULT_OK);
+  });
+
   if (changed) {
-    if (origin()) {
-      emitOriginModified();
+    if (auto* o=origin()) {
+      // directories can't be patched, the origin is walked again for them
+      if (FileRenamer::patchStructure(
+        *core().directoryStructure(), *o, renames, results)) {
+        emitOriginPatched();
+      } else {
+        emitOriginModified();
+      }
     }
   }
 }
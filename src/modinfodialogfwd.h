@@ -30,8 +30,10 @@ bool canExploreFile(bool isArchive, const QString& filename);
 bool canHideFile(bool isArchive, const QString& filename);
 bool canUnhideFile(bool isArchive, const QString& filename);
 
-FileRenamer::RenameResults hideFile(FileRenamer& renamer, const QString &oldName);
-FileRenamer::RenameResults unhideFile(FileRenamer& renamer, const QString& oldName);
+// the rename that hides or unhides the given file, see FileRenamer::rename()
+//
+FileRenamer::Rename hideFile(const QString &oldName);
+FileRenamer::Rename unhideFile(const QString& oldName);
 FileRenamer::RenameResults restoreHiddenFilesRecursive(FileRenamer& renamer, const QString &targetDir);
 
 
@@ -3,10 +3,19 @@
 #include "settings.h"
 #include "utility.h"
 #include <log.h>
+#include <QCryptographicHash>
+#include <QSaveFile>
 
 using namespace MOBase;
 using namespace ImagesTabHelpers;
 
+// number of thumbnails kept in memory, this is several pages even with a
+// tall dialog
+static const std::size_t MaxThumbnails = 300;
+
+// text key of the cached thumbnails that has the size of the original
+static const QString OriginalSizeKey = "MO-OriginalSize";
+
 QSize resizeWithAspectRatio(const QSize& original, const QSize& available)
 {
   const auto ratio = std::min({
@@ -39,9 +48,12 @@ QString dimensionString(const QSize& s)
 
 ImagesTab::ImagesTab(ModInfoDialogTabContext cx) :
   ModInfoDialogTab(std::move(cx)), m_image(new ScalableImage),
-  m_ddsAvailable(false), m_ddsEnabled(false)
+  m_ddsAvailable(false), m_ddsEnabled(false),
+  m_thumbnails(MaxThumbnails), m_warning(":/MO/gui/warning"),
+  m_generation(0), m_lastScroll(0), m_scrollDirection(1)
 {
   getSupportedFormats();
+  resetTasks();
 
   auto* ly = new QVBoxLayout(ui->imagesImage);
   ly->setContentsMargins({0, 0, 0, 0});
@@ -96,7 +108,15 @@ ImagesTab::ImagesTab(ModInfoDialogTabContext cx) :
 
 void ImagesTab::clear()
 {
+  // results of pending requests are for the old files
+  ++m_generation;
+  resetTasks();
+  m_requested.clear();
+  m_thumbnails.clear();
+
   m_files.clear();
+  m_lastScroll = 0;
+  m_scrollDirection = 1;
   ui->imagesScrollerVBar->setValue(0);
   select(BadIndex);
   setHasData(false);
@@ -410,6 +430,8 @@ void ImagesTab::paintThumbnailsArea(QPaintEvent* e)
 
     paintThumbnail(cx);
   }
+
+  prefetch(first, visible, cx.geo);
 }
 
 void ImagesTab::paintThumbnail(const PaintContext& cx)
@@ -443,18 +465,31 @@ void ImagesTab::paintThumbnailBorder(const PaintContext& cx)
 
 void ImagesTab::paintThumbnailImage(const PaintContext& cx)
 {
+  const auto imageRect = cx.geo.imageRect(cx.thumbIndex);
+
   if (cx.file->failed()) {
+    const auto r = centeredRect(
+      imageRect, cx.geo.scaledImageSize(m_warning.size()));
+
+    cx.painter.drawImage(r, m_warning);
+    return;
+  }
+
+  const auto* image = thumbnail(*cx.file, cx.geo);
+  if (!image) {
+    // still loading
     return;
   }
 
-  cx.file->loadIfNeeded(cx.geo);
+  // the thumbnail may have been made for a different size if the widget was
+  // resized, it's stretched until the new one is loaded
+  const auto size = (cx.file->size().isValid() ?
+    cx.geo.scaledImageSize(cx.file->size()) : image->size());
 
-  const auto imageRect = cx.geo.imageRect(cx.thumbIndex);
-  const auto scaledThumbRect = centeredRect(
-    imageRect, cx.file->thumbnail().size());
+  const auto scaledThumbRect = centeredRect(imageRect, size);
 
   cx.painter.fillRect(scaledThumbRect, m_theme.backgroundColor);
-  cx.painter.drawImage(scaledThumbRect, cx.file->thumbnail());
+  cx.painter.drawImage(scaledThumbRect, *image);
 }
 
 void ImagesTab::paintThumbnailText(const PaintContext& cx)
@@ -479,6 +514,120 @@ void ImagesTab::paintThumbnailText(const PaintContext& cx)
   cx.painter.drawText(tr, flags, text);
 }
 
+const QImage* ImagesTab::thumbnail(File& f, const Geometry& geo)
+{
+  const auto* image = m_thumbnails.get(f.path());
+
+  if (image && f.size().isValid()) {
+    if (image->size() == geo.scaledImageSize(f.size())) {
+      return image;
+    }
+  }
+
+  request(f, geo, false);
+  return image;
+}
+
+void ImagesTab::request(File& f, const Geometry& geo, bool prefetching)
+{
+  const auto available = geo.imageRect(0).size();
+
+  auto itor = m_requested.find(f.path());
+  if (itor != m_requested.end() && itor->second == available) {
+    // already loading
+    return;
+  }
+
+  m_requested[f.path()] = available;
+
+  // files are not added or removed until the tab is cleared, which changes
+  // the generation, so the index stays valid for the result
+  const auto index = static_cast<std::size_t>(&f - m_files.allFiles().data());
+  const auto generation = m_generation;
+
+  ThumbnailRequest r = {f.path(), available, thumbnailCacheDir()};
+  auto& tasks = (prefetching ? *m_prefetchTasks : *m_visibleTasks);
+
+  tasks.run([this, generation, index, r=std::move(r)] {
+    auto result = loadThumbnail(r);
+
+    QMetaObject::invokeMethod(this, [=, result=std::move(result)]() mutable {
+      onThumbnailLoaded(generation, index, std::move(result));
+    }, Qt::QueuedConnection);
+  });
+}
+
+void ImagesTab::prefetch(
+  std::size_t first, std::size_t visible, const Geometry& geo)
+{
+  std::size_t begin = 0, end = 0;
+
+  if (m_scrollDirection > 0) {
+    begin = first + visible;
+    end = begin + visible;
+  } else {
+    begin = (first > visible ? first - visible : 0);
+    end = first;
+  }
+
+  for (std::size_t i=begin; i<end; ++i) {
+    auto* f = m_files.get(i);
+    if (!f) {
+      break;
+    }
+
+    if (f->failed() || m_thumbnails.get(f->path())) {
+      // a thumbnail for a different size will be requested when it's
+      // painted
+      continue;
+    }
+
+    request(*f, geo, true);
+  }
+}
+
+void ImagesTab::onThumbnailLoaded(
+  std::size_t generation, std::size_t index, ThumbnailResult r)
+{
+  if (generation != m_generation || index >= m_files.allFiles().size()) {
+    // the tab was cleared
+    return;
+  }
+
+  auto itor = m_requested.find(r.path);
+  if (itor != m_requested.end() && itor->second == r.available) {
+    m_requested.erase(itor);
+  }
+
+  m_files.allFiles()[index].setLoaded(r.original, r.failed);
+
+  if (!r.failed) {
+    m_thumbnails.add(r.path, std::move(r.thumbnail));
+  }
+
+  ui->imagesThumbnails->update();
+}
+
+void ImagesTab::resetTasks()
+{
+  // this waits for the tasks that are running, the others are skipped
+  if (m_visibleTasks) {
+    m_visibleTasks->cancel();
+  }
+
+  if (m_prefetchTasks) {
+    m_prefetchTasks->cancel();
+  }
+
+  m_visibleTasks.reset(new MOShared::TaskGroup(MOShared::TaskPriority::Normal));
+  m_prefetchTasks.reset(new MOShared::TaskGroup(MOShared::TaskPriority::Low));
+}
+
+QString ImagesTab::thumbnailCacheDir() const
+{
+  return Settings::instance().paths().cache() + "/thumbnails/" + mod().name();
+}
+
 void ImagesTab::scrollAreaResized(const QSize&)
 {
   updateScrollbar();
@@ -549,6 +698,13 @@ bool ImagesTab::thumbnailAreaKeyPressEvent(QKeyEvent* e)
 
 void ImagesTab::onScrolled()
 {
+  const auto v = ui->imagesScrollerVBar->value();
+
+  if (v != m_lastScroll) {
+    m_scrollDirection = (v > m_lastScroll ? 1 : -1);
+    m_lastScroll = v;
+  }
+
   ui->imagesThumbnails->update();
 }
 
@@ -563,7 +719,7 @@ void ImagesTab::showTooltip(QHelpEvent* e)
 
   const auto s = QString("%1 (%2)")
     .arg(QDir::toNativeSeparators(f->path()))
-    .arg(dimensionString(f->original().size()));
+    .arg(dimensionString(f->size()));
 
   QToolTip::showText(e->globalPos(), s, ui->imagesThumbnails);
 }
@@ -928,7 +1084,10 @@ void File::ensureOriginalLoaded()
       m_path, reader.errorString(), static_cast<int>(reader.error()));
 
     m_failed = true;
+    return;
   }
+
+  m_size = m_original.size();
 }
 
 const QString& File::path() const
@@ -950,54 +1109,160 @@ const QImage& File::original() const
   return m_original;
 }
 
-const QImage& File::thumbnail() const
+bool File::failed() const
+{
+  return m_failed;
+}
+
+QSize File::size() const
 {
-  return m_thumbnail;
+  return m_size;
 }
 
-bool File::failed() const
+void File::setLoaded(QSize size, bool failed)
 {
-  return m_failed;
+  if (size.isValid()) {
+    m_size = size;
+  }
+
+  m_failed = failed;
 }
 
-void File::loadIfNeeded(const Geometry& geo)
+
+ThumbnailCache::ThumbnailCache(std::size_t capacity)
+  : m_capacity(capacity)
+{
+}
+
+const QImage* ThumbnailCache::get(const QString& path)
 {
-  if (needsLoad(geo)) {
-    load(geo);
+  auto itor = m_map.find(path);
+  if (itor == m_map.end()) {
+    return nullptr;
   }
+
+  // most recently used
+  m_list.splice(m_list.begin(), m_list, itor->second);
+
+  return &itor->second->second;
 }
 
-bool File::needsLoad(const Geometry& geo) const
+void ThumbnailCache::add(const QString& path, QImage image)
 {
-  if (m_failed) {
-    return false;
+  auto itor = m_map.find(path);
+
+  if (itor != m_map.end()) {
+    itor->second->second = std::move(image);
+    m_list.splice(m_list.begin(), m_list, itor->second);
+    return;
   }
 
-  if (m_original.isNull() || m_thumbnail.isNull()) {
-    return true;
+  m_list.emplace_front(path, std::move(image));
+  m_map.emplace(path, m_list.begin());
+
+  while (m_list.size() > m_capacity) {
+    m_map.erase(m_list.back().first);
+    m_list.pop_back();
   }
+}
 
-  const auto scaledSize = geo.scaledImageSize(m_original.size());
-  return (m_thumbnail.size() != scaledSize);
+void ThumbnailCache::clear()
+{
+  m_map.clear();
+  m_list.clear();
 }
 
-void File::load(const Geometry& geo)
+
+// path of the cached thumbnail for the given request; the modification time
+// of the file and the size are part of the name, so thumbnails of files that
+// changed or for a different size are never used
+//
+QString thumbnailCachePath(const ThumbnailRequest& r)
 {
-  m_failed = false;
-  ensureOriginalLoaded();
+  const auto time = QFileInfo(r.path).lastModified().toMSecsSinceEpoch();
 
-  if (m_failed) {
-    QImage warning(":/MO/gui/warning");
-    const auto scaledSize = geo.scaledImageSize(warning.size());
+  const auto key = QString("%1|%2|%3x%4")
+    .arg(r.path.toLower()).arg(time)
+    .arg(r.available.width()).arg(r.available.height());
 
-    m_thumbnail = warning.scaled(
-      scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-  } else {
-    const auto scaledSize = geo.scaledImageSize(m_original.size());
+  const auto hash = QCryptographicHash::hash(
+    key.toUtf8(), QCryptographicHash::Sha1).toHex();
 
-    m_thumbnail = m_original.scaled(
-      scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+  return r.cacheDir + "/" + QString::fromLatin1(hash) + ".png";
+}
+
+QSize parseSize(const QString& s)
+{
+  const auto cs = s.split('x');
+  if (cs.size() != 2) {
+    return {};
+  }
+
+  return {cs[0].toInt(), cs[1].toInt()};
+}
+
+ThumbnailResult loadThumbnail(const ThumbnailRequest& r)
+{
+  ThumbnailResult out;
+  out.path = r.path;
+  out.available = r.available;
+
+  const auto cachePath = thumbnailCachePath(r);
+
+  {
+    QImage image;
+
+    if (image.load(cachePath, "PNG")) {
+      const auto size = parseSize(image.text(OriginalSizeKey));
+
+      if (size.isValid()) {
+        out.original = size;
+        out.thumbnail = std::move(image);
+        return out;
+      }
+    }
   }
+
+  QImageReader reader(r.path);
+
+  // decoding at the reduced size is much faster for formats that support it,
+  // like jpeg; QImageReader scales the image itself for the others
+  out.original = reader.size();
+  if (out.original.isValid()) {
+    reader.setScaledSize(resizeWithAspectRatio(out.original, r.available));
+  }
+
+  if (!reader.read(&out.thumbnail)) {
+    log::error(
+      "failed to load '{}'\n{} (error {})",
+      r.path, reader.errorString(), static_cast<int>(reader.error()));
+
+    out.failed = true;
+    return out;
+  }
+
+  if (!out.original.isValid()) {
+    // the size isn't known until the image has been read
+    out.original = out.thumbnail.size();
+
+    out.thumbnail = out.thumbnail.scaled(
+      resizeWithAspectRatio(out.original, r.available),
+      Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+  }
+
+  out.thumbnail.setText(
+    OriginalSizeKey,
+    QString("%1x%2").arg(out.original.width()).arg(out.original.height()));
+
+  QDir().mkpath(r.cacheDir);
+
+  QSaveFile file(cachePath);
+  if (!file.open(QIODevice::WriteOnly) ||
+      !out.thumbnail.save(&file, "PNG") || !file.commit()) {
+    log::debug("failed to cache thumbnail of '{}' in '{}'", r.path, cachePath);
+  }
+
+  return out;
 }
 
 
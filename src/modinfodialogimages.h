@@ -6,6 +6,8 @@
 #include <QScrollBar>
 #include "plugincontainer.h"
 #include "organizercore.h"
+#include "taskexecutor.h"
+#include <list>
 
 using namespace MOBase;
 
@@ -234,6 +236,68 @@ private:
 };
 
 
+// a thumbnail request handled by a background task, see ImagesTab::request()
+//
+struct ThumbnailRequest
+{
+  QString path;
+
+  // size of the image rect, the thumbnail fits in it
+  QSize available;
+
+  // directory of the on-disk cache for the mod
+  QString cacheDir;
+};
+
+
+// a thumbnail decoded by a background task
+//
+struct ThumbnailResult
+{
+  QString path;
+  QSize available;
+
+  // size of the image on disk
+  QSize original;
+
+  QImage thumbnail;
+  bool failed = false;
+};
+
+
+// decodes a thumbnail at its reduced size, or gets it from the on-disk
+// cache; this is called on background threads
+//
+ThumbnailResult loadThumbnail(const ThumbnailRequest& r);
+
+
+// the most recently used thumbnails, by path; the oldest ones are dropped
+// when there are more than `capacity` thumbnails
+//
+class ThumbnailCache
+{
+public:
+  explicit ThumbnailCache(std::size_t capacity);
+
+  // returns null if the thumbnail is not in the cache, this makes it the
+  // most recently used
+  //
+  const QImage* get(const QString& path);
+
+  void add(const QString& path, QImage image);
+  void clear();
+
+private:
+  using List = std::list<std::pair<QString, QImage>>;
+
+  const std::size_t m_capacity;
+
+  // most recently used first
+  List m_list;
+  std::map<QString, List::iterator> m_map;
+};
+
+
 class File
 {
 public:
@@ -244,19 +308,23 @@ public:
   const QString& path() const;
   const QString& filename() const;
   const QImage& original() const;
-  const QImage& thumbnail() const;
   bool failed() const;
 
-  void loadIfNeeded(const Geometry& geo);
+  // size of the image on disk, empty until either the original or a
+  // thumbnail has been loaded
+  //
+  QSize size() const;
+
+  // called when a thumbnail has been loaded
+  //
+  void setLoaded(QSize size, bool failed);
 
 private:
   QString m_path;
   mutable QString m_filename;
-  QImage m_original, m_thumbnail;
+  QImage m_original;
+  QSize m_size;
   bool m_failed;
-
-  bool needsLoad(const Geometry& geo) const;
-  void load(const Geometry& geo);
 };
 
 
@@ -341,6 +409,8 @@ private:
   using Metrics = ImagesTabHelpers::Metrics;
   using PaintContext = ImagesTabHelpers::PaintContext;
   using Geometry = ImagesTabHelpers::Geometry;
+  using ThumbnailCache = ImagesTabHelpers::ThumbnailCache;
+  using ThumbnailResult = ImagesTabHelpers::ThumbnailResult;
 
   ScalableImage* m_image;
   std::vector<QString> m_supportedFormats;
@@ -350,6 +420,29 @@ private:
   Theme m_theme;
   Metrics m_metrics;
 
+  // thumbnails that have been loaded; they're not kept in the files so
+  // mods with many images don't keep all of them in memory
+  ThumbnailCache m_thumbnails;
+
+  // shown instead of images that failed to load
+  QImage m_warning;
+
+  // thumbnails being loaded, by path, with the size they were requested for
+  std::map<QString, QSize> m_requested;
+
+  // tasks loading the visible thumbnails and the ones prefetched for the
+  // next page; they're recreated when the tab is cleared
+  std::unique_ptr<MOShared::TaskGroup> m_visibleTasks, m_prefetchTasks;
+
+  // incremented when the tab is cleared, results of older requests are
+  // ignored
+  std::size_t m_generation;
+
+  // last value of the scrollbar and the direction it last moved, 1 for down
+  // and -1 for up, used for prefetching
+  int m_lastScroll;
+  int m_scrollDirection;
+
   void getSupportedFormats();
   void enableDDS(bool b);
 
@@ -381,6 +474,31 @@ private:
   void paintThumbnailImage(const PaintContext& cx);
   void paintThumbnailText(const PaintContext& cx);
 
+  // returns the thumbnail for the given file if it's available; if it's not,
+  // or if it's for a different size, it's requested in the background and
+  // this returns whatever is available in the meantime
+  //
+  const QImage* thumbnail(File& f, const Geometry& geo);
+
+  // queues a background task to load the thumbnail of the given file, unless
+  // it's already been requested
+  //
+  void request(File& f, const Geometry& geo, bool prefetching);
+
+  // requests the thumbnails of the page after the visible one, in the
+  // direction of the last scroll
+  //
+  void prefetch(std::size_t first, std::size_t visible, const Geometry& geo);
+
+  // called on the ui thread when a background task has finished, `index` is
+  // the index of the file in Files::allFiles()
+  //
+  void onThumbnailLoaded(
+    std::size_t generation, std::size_t index, ThumbnailResult r);
+
+  void resetTasks();
+  QString thumbnailCacheDir() const;
+
   void checkFiltering();
   void switchToAll();
   void switchToFiltered();
@@ -3,7 +3,8 @@
 #include "settings.h"
 #include "organizercore.h"
 #include "iplugingame.h"
-#include "bbcode.h"
+#include "nexusinterface.h"
+#include "browsercache.h"
 #include <versioninfo.h>
 #include <utility.h>
 #include <log.h>
@@ -287,8 +288,9 @@ void NexusTab::onModChanged()
       page for it in the "Custom URL" box below.</p>
       </div>)"));
   } else {
-    descriptionAsHTML = descriptionAsHTML.arg(
-      BBCode::convertToHTML(nexusDescription));
+    descriptionAsHTML = descriptionAsHTML.arg(BrowserCache::rewriteImages(
+      NexusInterface::instance().descriptionAsHTML(
+        mod().gameName(), mod().nexusId(), nexusDescription)));
   }
 
   ui->browser->page()->setHtml(descriptionAsHTML);
@@ -349,6 +351,7 @@ void NexusTab::onRefreshBrowser()
   const auto modID = mod().nexusId();
 
   if (isValidModID(modID)) {
+    NexusInterface::instance().forgetCachedMod(mod().gameName(), modID);
     mod().setLastNexusQuery(QDateTime::fromSecsSinceEpoch(0));
     updateWebpage();
   } else {
@@ -130,6 +130,13 @@ void ModInfoDialogTab::emitOriginModified()
   }
 }
 
+void ModInfoDialogTab::emitOriginPatched()
+{
+  if (m_origin) {
+    emit originPatched(m_origin->getID());
+  }
+}
+
 void ModInfoDialogTab::emitModOpen(QString name)
 {
   emit modOpen(name);
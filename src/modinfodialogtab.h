@@ -42,6 +42,11 @@ struct ModInfoDialogTabContext
 // when the dialog is opened or when next/previous is clicked, the sequence is:
 // setMod(), clear(), feedFile() an update()
 //
+// the files are listed on a background thread, so feedFile() and update() are
+// called later from the event loop for tabs that return true in
+// usesOriginFiles(); the selected tab is updated first, the others right
+// after, unless the mod changes in the meantime
+//
 // when the dialog is closed, canClose() is called on all tabs
 //
 // when a tab is selected for the first time for the current mod,
@@ -60,7 +65,9 @@ struct ModInfoDialogTabContext
 //
 // when tabs modify the origin and call emitOriginModified() (such as the
 // conflicts tabs), all tabs that return true in usesOriginFiles() will go
-// through the full update sequence as above
+// through the full update sequence as above; tabs that already updated the
+// structure themselves call emitOriginPatched() instead, which updates the
+// tabs without walking the origin again
 //
 // tabs can call emitModOpen() to request showing a different mod
 //
@@ -216,6 +223,11 @@ signals:
   //
   void originModified(int originID);
 
+  // emitted when a tab modified the files in a mod and already updated the
+  // origin in the structure
+  //
+  void originPatched(int originID);
+
   // emitted when a tab wants to open a mod by name
   //
   void modOpen(QString name);
@@ -241,6 +253,10 @@ protected:
   //
   void emitOriginModified();
 
+  // emits originPatched
+  //
+  void emitOriginPatched();
+
   // emits modOpen
   //
   void emitModOpen(QString name);
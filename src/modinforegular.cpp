@@ -7,6 +7,8 @@
 #include "settings.h"
 #include "organizercore.h"
 #include "plugincontainer.h"
+#include "modintegrity.h"
+#include "shared/ioaccounting.h"
 #include <iplugingame.h>
 
 #include <QApplication>
@@ -27,7 +29,7 @@ namespace {
   }
 }
 
-ModInfoRegular::ModInfoRegular(const QDir &path, OrganizerCore& core)
+ModInfoRegular::ModInfoRegular(const QDir &path, OrganizerCore& core, const QVariantMap* meta)
   : ModInfoWithConflictInfo(core)
   , m_Name(path.dirName())
   , m_Path(path.absolutePath())
@@ -43,7 +45,11 @@ ModInfoRegular::ModInfoRegular(const QDir &path, OrganizerCore& core)
 {
   m_CreationTime = QFileInfo(path.absolutePath()).birthTime();
   // read out the meta-file for information
-  readMeta();
+  if (meta) {
+    applyMeta(*meta);
+  } else {
+    readMeta();
+  }
   if (m_GameName.compare(core.managedGame()->gameShortName(), Qt::CaseInsensitive) != 0)
     if (!core.managedGame()->primarySources().contains(m_GameName, Qt::CaseInsensitive))
       m_IsAlternate = true;
@@ -86,21 +92,63 @@ bool ModInfoRegular::isEmpty() const
 
 void ModInfoRegular::readMeta()
 {
-  QSettings metaFile(m_Path + "/meta.ini", QSettings::IniFormat);
-  m_Comments         = metaFile.value("comments", "").toString();
-  m_Notes            = metaFile.value("notes", "").toString();
-  QString tempGameName = metaFile.value("gameName", m_GameName).toString();
+  applyMeta(readMetaFile(m_Path));
+}
+
+QVariantMap ModInfoRegular::readMetaFile(const QString& modPath)
+{
+  QVariantMap values;
+
+  IoAccounting::open(IoAccounting::Subsystem::ModMeta);
+
+  QSettings metaFile(modPath + "/meta.ini", QSettings::IniFormat);
+  for (const QString& key : metaFile.allKeys()) {
+    values[key] = value(key);
+  }
+
+  return values;
+}
+
+ModInfoRegular::DiskTimes ModInfoRegular::readDiskTimes(const QString& modPath)
+{
+  IoAccounting::stat(IoAccounting::Subsystem::ModMeta, 2);
+
+  return {
+    QFileInfo(modPath).lastModified(),
+    QFileInfo(modPath + "/meta.ini").lastModified()};
+}
+
+void ModInfoRegular::setDiskTimes(const DiskTimes& times)
+{
+  m_DiskTimes = times;
+}
+
+bool ModInfoRegular::isUpToDate(const DiskTimes& times) const
+{
+  return !m_DiskTimes.first.isNull() && (m_DiskTimes == times);
+}
+
+void ModInfoRegular::applyMeta(const QVariantMap& meta)
+{
+  auto value = [&](const QString& key, const QVariant& def = {}) {
+    auto itor = meta.find(key);
+    return (itor == meta.end()) ? def : *itor;
+  };
+
+  m_Comments         = value("comments", "").toString();
+  m_Notes            = value("notes", "").toString();
+  QString tempGameName = value("gameName", m_GameName).toString();
   if (tempGameName.size()) m_GameName = tempGameName;
-  m_NexusID          = metaFile.value("modid", -1).toInt();
-  m_Version.parse(metaFile.value("version", "").toString());
-  m_NewestVersion    = metaFile.value("newestVersion", "").toString();
-  m_IgnoredVersion   = metaFile.value("ignoredVersion", "").toString();
-  m_InstallationFile = metaFile.value("installationFile", "").toString();
-  m_NexusDescription = metaFile.value("nexusDescription", "").toString();
-  m_NexusFileStatus  = metaFile.value("nexusFileStatus", "1").toInt();
-  m_Repository       = metaFile.value("repository", "Nexus").toString();
-  m_Converted        = metaFile.value("converted", false).toBool();
-  m_Validated        = metaFile.value("validated", false).toBool();
+  m_NexusID          = value("modid", -1).toInt();
+  m_Version.parse(value("version", "").toString());
+  m_NewestVersion    = value("newestVersion", "").toString();
+  m_IgnoredVersion   = value("ignoredVersion", "").toString();
+  m_InstallationFile = value("installationFile", "").toString();
+  m_NexusDescription = value("nexusDescription", "").toString();
+  m_NexusFileStatus  = value("nexusFileStatus", "1").toInt();
+  m_Repository       = value("repository", "Nexus").toString();
+  m_Converted        = value("converted", false).toBool();
+  m_Validated        = value("validated", false).toBool();
 
   // this handles changes to how the URL works after 2.2.0
   //
@@ -149,10 +197,10 @@ void ModInfoRegular::readMeta()
   //        from a user manually entering a url, and so is handled as such)
 
   // always read the url
-  m_CustomURL = metaFile.value("url").toString();
+  m_CustomURL = value("url").toString();
 
-  if (metaFile.contains("hasCustomURL")) {
-    m_HasCustomURL = metaFile.value("hasCustomURL").toBool();
+  if (meta.contains("hasCustomURL")) {
+    m_HasCustomURL = value("hasCustomURL").toBool();
   } else {
     if (m_NexusID > 0) {
       // the mod id is valid, disable the custom url
@@ -165,26 +213,26 @@ void ModInfoRegular::readMeta()
     }
   }
 
-  m_LastNexusQuery   = QDateTime::fromString(metaFile.value("lastNexusQuery", "").toString(), Qt::ISODate);
-  m_LastNexusUpdate  = QDateTime::fromString(metaFile.value("lastNexusUpdate", "").toString(), Qt::ISODate);
-  m_NexusLastModified = QDateTime::fromString(metaFile.value("nexusLastModified", QDateTime::currentDateTimeUtc()).toString(), Qt::ISODate);
-  m_Color            = metaFile.value("color",QColor()).value<QColor>();
-  m_TrackedState = metaFile.value("tracked", false).toBool() ? TrackedState::TRACKED_TRUE : TrackedState::TRACKED_FALSE;
-  if (metaFile.contains("endorsed")) {
-    if (metaFile.value("endorsed").canConvert<int>()) {
+  m_LastNexusQuery   = QDateTime::fromString(value("lastNexusQuery", "").toString(), Qt::ISODate);
+  m_LastNexusUpdate  = QDateTime::fromString(value("lastNexusUpdate", "").toString(), Qt::ISODate);
+  m_NexusLastModified = QDateTime::fromString(value("nexusLastModified", QDateTime::currentDateTimeUtc()).toString(), Qt::ISODate);
+  m_Color            = value("color",QColor()).value<QColor>();
+  m_TrackedState = value("tracked", false).toBool() ? TrackedState::TRACKED_TRUE : TrackedState::TRACKED_FALSE;
+  if (meta.contains("endorsed")) {
+    if (value("endorsed").canConvert<int>()) {
       using ut = std::underlying_type_t<EndorsedState>;
-      switch (metaFile.value("endorsed").toInt()) {
+      switch (value("endorsed").toInt()) {
         case static_cast<ut>(EndorsedState::ENDORSED_FALSE): m_EndorsedState = EndorsedState::ENDORSED_FALSE; break;
         case static_cast<ut>(EndorsedState::ENDORSED_TRUE):  m_EndorsedState = EndorsedState::ENDORSED_TRUE;  break;
         case static_cast<ut>(EndorsedState::ENDORSED_NEVER): m_EndorsedState = EndorsedState::ENDORSED_NEVER; break;
         default: m_EndorsedState = EndorsedState::ENDORSED_UNKNOWN; break;
       }
     } else {
-      m_EndorsedState = metaFile.value("endorsed", false).toBool() ? EndorsedState::ENDORSED_TRUE : EndorsedState::ENDORSED_FALSE;
+      m_EndorsedState = value("endorsed", false).toBool() ? EndorsedState::ENDORSED_TRUE : EndorsedState::ENDORSED_FALSE;
     }
   }
 
-  QString categoriesString = metaFile.value("category", "").toString();
+  QString categoriesString = value("category", "").toString();
 
   QStringList categories = categoriesString.split(',', QString::SkipEmptyParts);
   for (QStringList::iterator iter = categories.begin(); iter != categories.end(); ++iter) {
@@ -202,23 +250,25 @@ void ModInfoRegular::readMeta()
     }
   }
 
-  int numFiles = metaFile.beginReadArray("installedFiles");
-  for (int i = 0; i < numFiles; ++i) {
-    metaFile.setArrayIndex(i);
-    m_InstalledFileIDs.insert(std::make_pair(metaFile.value("modid").toInt(), metaFile.value("fileid").toInt()));
+  // arrays are stored as "name/size" and "name/index/key", with an index
+  // starting at 1
+  int numFiles = value("installedFiles/size", 0).toInt();
+  for (int i = 1; i <= numFiles; ++i) {
+    const QString prefix = QString("installedFiles/%1/").arg(i);
+    m_InstalledFileIDs.insert(std::make_pair(value(prefix + "modid").toInt(), value(prefix + "fileid").toInt()));
   }
-  metaFile.endArray();
 
-  // Plugin settings:
-  metaFile.beginGroup("Plugins");
-  for (auto pluginName: metaFile.childGroups()) {
-    metaFile.beginGroup(pluginName);
-    for (auto settingKey : metaFile.childKeys()) {
-      m_PluginSettings[pluginName][settingKey] = metaFile.value(settingKey);
+  // Plugin settings, stored as "Plugins/plugin/setting":
+  for (auto itor = meta.begin(); itor != meta.end(); ++itor) {
+    if (!itor.key().startsWith("Plugins/")) {
+      continue;
+    }
+
+    const QStringList parts = itor.key().split('/');
+    if (parts.size() == 3) {
+      m_PluginSettings[parts[1]][parts[2]] = itor.value();
     }
-    metaFile.endGroup();
   }
-  metaFile.endGroup();
 
   m_MetaInfoChanged = false;
 }
@@ -284,6 +334,11 @@ void ModInfoRegular::saveMeta()
 
       if (metaFile.status() == QSettings::NoError) {
         m_MetaInfoChanged = false;
+
+        // this write doesn't make the mod out of date
+        if (!m_DiskTimes.first.isNull()) {
+          m_DiskTimes = readDiskTimes(m_Path);
+        }
       } else {
         log::error(
           "failed to write {}/meta.ini: error {}",
@@ -463,17 +518,19 @@ bool ModInfoRegular::setName(const QString &name)
     }
   }
 
-  std::map<QString, unsigned int>::iterator nameIter = s_ModsByName.find(m_Name);
+  ModIntegrity::renamed(m_Name, name);
+
+  auto nameIter = s_ModsByName.find(nameKey(m_Name));
   if (nameIter != s_ModsByName.end()) {
     QMutexLocker locker(&s_Mutex);
 
-    unsigned int index = nameIter->second;
+    unsigned int index = nameIter.value();
     s_ModsByName.erase(nameIter);
 
     m_Name = name;
     m_Path = newPath;
 
-    s_ModsByName[m_Name] = index;
+    s_ModsByName[nameKey(m_Name)] = index;
 
     std::sort(s_Collection.begin(), s_Collection.end(), ModInfo::ByName);
     updateIndices();
@@ -561,15 +618,22 @@ void ModInfoRegular::addNexusCategory(int categoryID)
 void ModInfoRegular::setIsEndorsed(bool endorsed)
 {
   if (m_EndorsedState != EndorsedState::ENDORSED_NEVER) {
-    m_EndorsedState = endorsed ? EndorsedState::ENDORSED_TRUE : EndorsedState::ENDORSED_FALSE;
-    m_MetaInfoChanged = true;
+    const auto s = endorsed ? EndorsedState::ENDORSED_TRUE : EndorsedState::ENDORSED_FALSE;
+
+    // endorsements are synced for all mods, most don't change
+    if (s != m_EndorsedState) {
+      m_EndorsedState = s;
+      m_MetaInfoChanged = true;
+    }
   }
 }
 
 void ModInfoRegular::setNeverEndorse()
 {
-  m_EndorsedState = EndorsedState::ENDORSED_NEVER;
-  m_MetaInfoChanged = true;
+  if (m_EndorsedState != EndorsedState::ENDORSED_NEVER) {
+    m_EndorsedState = EndorsedState::ENDORSED_NEVER;
+    m_MetaInfoChanged = true;
+  }
 }
 
 void ModInfoRegular::setIsTracked(bool tracked)
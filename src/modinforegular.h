@@ -378,6 +378,34 @@ public:
 
   void readMeta() override;
 
+  /**
+   * @brief reads all the values in the meta.ini of the mod in the given
+   *   directory, empty if it doesn't exist; this can be called from any thread
+   */
+  static QVariantMap readMetaFile(const QString& modPath);
+
+  // modification times of a mod directory and of its meta.ini
+  using DiskTimes = std::pair<QDateTime, QDateTime>;
+
+  /**
+   * @brief returns the modification times of the given mod directory and of
+   *   its meta.ini; this can be called from any thread
+   */
+  static DiskTimes readDiskTimes(const QString& modPath);
+
+  /**
+   * @brief remembers the modification times the mod was read with, see
+   *   isUpToDate()
+   */
+  void setDiskTimes(const DiskTimes& times);
+
+  /**
+   * @brief whether the mod was read with the given modification times, in
+   *   which case it doesn't need to be created again on refresh; false if the
+   *   times were never set
+   */
+  bool isUpToDate(const DiskTimes& times) const;
+
   virtual void setHasCustomURL(bool b) override;
   virtual bool hasCustomURL() const override;
   virtual void setCustomURL(QString const &) override;
@@ -412,12 +440,18 @@ protected:
 
   virtual std::set<int> doGetContents() const override;
 
-  ModInfoRegular(const QDir& path, OrganizerCore& core);
+  // `meta` has the values from readMetaFile() if they were already read,
+  // meta.ini is read if it's null
+  ModInfoRegular(const QDir& path, OrganizerCore& core, const QVariantMap* meta = nullptr);
 
 private:
 
+  // sets the meta information from the values in meta.ini
+  void applyMeta(const QVariantMap& meta);
+
   QString m_Name;
   QString m_Path;
+  DiskTimes m_DiskTimes;
   QString m_InstallationFile;
   QString m_Comments;
   QString m_Notes;
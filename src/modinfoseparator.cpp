@@ -30,7 +30,7 @@ QString ModInfoSeparator::name() const
 }
 
 
-ModInfoSeparator::ModInfoSeparator(const QDir& path, OrganizerCore& core)
-  : ModInfoRegular(path, core)
+ModInfoSeparator::ModInfoSeparator(const QDir& path, OrganizerCore& core, const QVariantMap* meta)
+  : ModInfoRegular(path, core, meta)
 {
 }
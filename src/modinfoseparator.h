@@ -54,7 +54,7 @@ protected:
 
 private:
 
-  ModInfoSeparator(const QDir& path, OrganizerCore& core);
+  ModInfoSeparator(const QDir& path, OrganizerCore& core, const QVariantMap* meta = nullptr);
 };
 
 #endif
@@ -3,7 +3,7 @@
 #include "shared/directoryentry.h"
 #include "shared/filesorigin.h"
 #include "shared/fileentry.h"
-#include <filesystem>
+#include "shared/fileregister.h"
 
 #include "organizercore.h"
 #include "iplugingame.h"
@@ -12,18 +12,67 @@
 
 using namespace MOBase;
 using namespace MOShared;
-namespace fs = std::filesystem;
+
+using Clock = std::chrono::steady_clock;
+
+// see conflictSetsLastUsed() and fileTreesLastUsed(), file trees are used
+// from any thread
+static std::atomic<Clock::rep> g_ConflictSetsUsed(0);
+static std::atomic<Clock::rep> g_FileTreesUsed(0);
 
 ModInfoWithConflictInfo::ModInfoWithConflictInfo(OrganizerCore& core) :
   ModInfo(core),
-  m_FileTree([this]() { return QDirFileTree::makeTree(absolutePath()); }),
+  m_FileTree([this]() {
+    std::shared_ptr<const IFileTree> tree = QDirFileTree::makeTree(absolutePath());
+    m_LastFileTree = tree;
+    return tree;
+  }),
   m_Valid([this]() { return doIsValid(); }),
   m_Contents([this]() { return doGetContents(); }),
-  m_HasLooseOverwrite(false), m_HasHiddenFiles(false) {}
+  m_Prefetched(false),
+  m_ConflictGeneration(0), m_ConflictsValid(false), m_ConflictSetsValid(false)
+{
+}
 
 void ModInfoWithConflictInfo::clearCaches()
 {
-  m_LastConflictCheck = QTime();
+  m_ConflictsValid = false;
+  m_ConflictSetsValid = false;
+}
+
+MemoryUsage ModInfoWithConflictInfo::conflictSetsMemory() const
+{
+  MemoryUsage u;
+
+  for (const auto* s : {
+    &m_OverwriteList, &m_OverwrittenList,
+    &m_ArchiveOverwriteList, &m_ArchiveOverwrittenList,
+    &m_ArchiveLooseOverwriteList, &m_ArchiveLooseOverwrittenList})
+  {
+    u.count += s->size();
+    u.bytes += treeBytes(*s);
+  }
+
+  return u;
+}
+
+MemoryUsage ModInfoWithConflictInfo::fileTreeMemory() const
+{
+  const auto tree = m_LastFileTree.lock();
+  if (!tree || !m_Prefetched) {
+    return {};
+  }
+
+  MemoryUsage u{1, 0};
+
+  for (auto&& e : *tree) {
+    // the entry, the control block of its pointer and its name
+    u.bytes +=
+      sizeof(FileTreeEntry) + 2 * sizeof(void*) +
+      (e->name().capacity() + 1) * sizeof(QChar);
+  }
+
+  return u;
 }
 
 std::vector<ModInfo::EFlag> ModInfoWithConflictInfo::getFlags() const
@@ -84,234 +133,202 @@ std::vector<ModInfo::EConflictFlag> ModInfoWithConflictInfo::getConflictFlags()
 
 void ModInfoWithConflictInfo::doConflictCheck() const
 {
-  m_OverwriteList.clear();
-  m_OverwrittenList.clear();
-  m_ArchiveOverwriteList.clear();
-  m_ArchiveOverwrittenList.clear();
-  m_ArchiveLooseOverwriteList.clear();
-  m_ArchiveLooseOverwrittenList.clear();
-
-  bool providesAnything = false;
-  bool hasHiddenFiles = false;
-
-  int dataID = 0;
-  if (m_Core.directoryStructure()->originExists(L"data")) {
-    dataID = m_Core.directoryStructure()->getOriginByName(L"data").getID();
+  const auto* ds = m_Core.directoryStructure();
+  const auto& graph = ds->getFileRegister()->conflicts();
+
+  m_ConflictGeneration = graph.generation();
+  m_Conflicts = {};
+
+  const std::wstring name = ToWString(this->name());
+  if (ds->originExists(name)) {
+    m_Conflicts = graph.counts(ds->getOriginByName(name).getID());
+  }
+
+  m_ConflictsValid = true;
+  m_ConflictSetsValid = false;
+}
+
+const ConflictGraph::Counts& ModInfoWithConflictInfo::conflicts() const
+{
+  const auto& graph = m_Core.directoryStructure()->getFileRegister()->conflicts();
+
+  if (!m_ConflictsValid || m_ConflictGeneration != graph.generation()) {
+    doConflictCheck();
+  }
+
+  return m_Conflicts;
+}
+
+void ModInfoWithConflictInfo::updateConflictSets() const
+{
+  g_ConflictSetsUsed = Clock::now().time_since_epoch().count();
+
+  conflicts();
+
+  if (m_ConflictSetsValid) {
+    return;
   }
 
-  std::wstring name = ToWString(this->name());
-  const std::wstring hideExt = ToWString(ModInfo::s_HiddenExt);
-
-  m_CurrentConflictState = CONFLICT_NONE;
-  m_ArchiveConflictState = CONFLICT_NONE;
-  m_ArchiveConflictLooseState = CONFLICT_NONE;
-
-  if (m_Core.directoryStructure()->originExists(name)) {
-    FilesOrigin &origin = m_Core.directoryStructure()->getOriginByName(name);
-    std::vector<FileEntryPtr> files = origin.getFiles();
-    std::set<const DirectoryEntry*> checkedDirs;
-
-    // for all files in this origin
-    for (FileEntryPtr file : files) {
-
-      // skip hiidden file check if already found one
-      if (!hasHiddenFiles) {
-        const fs::path nameAsPath(file->getName());
-
-        if (nameAsPath.extension().wstring().compare(hideExt) == 0) {
-          hasHiddenFiles = true;
-        }
-        else {
-          const DirectoryEntry* parent = file->getParent();
-
-          // iterate on all parent direEntries to check for .mohiddden
-          while (parent != nullptr) {
-            auto insertResult = checkedDirs.insert(parent);
-
-            if (insertResult.second == false) {
-              // if already present break as we can assume to have checked the parents as well
-              break;
-            }
-            else {
-              const fs::path dirPath(parent->getName());
-              if (dirPath.extension().wstring().compare(hideExt) == 0) {
-                hasHiddenFiles = true;
-                break;
-              }
-              parent = parent->getParent();
-            }
-          }
-        }
-      }
-
-      auto alternatives = file->getAlternatives();
-      if ((alternatives.size() == 0) || (alternatives.back().originID() == dataID)) {
-        // no alternatives -> no conflict
-        providesAnything = true;
-      } else {
-        // Get the archive data for the current mod
-        DataArchiveOrigin archiveData;
-        if (file->getOrigin() == origin.getID())
-          archiveData = file->getArchive();
-        else {
-          for (const auto& alt : alternatives) {
-            if (alt.originID() == origin.getID()) {
-              archiveData = alt.archive();
-              break;
-            }
-          }
-        }
-
-        // If this is not the origin then determine the correct overwrite
-        if (file->getOrigin() != origin.getID()) {
-          FilesOrigin &altOrigin = m_Core.directoryStructure()->getOriginByID(file->getOrigin());
-          unsigned int altIndex = ModInfo::getIndex(ToQString(altOrigin.getName()));
-          if (!file->isFromArchive()) {
-            if (!archiveData.isValid())
-              m_OverwrittenList.insert(altIndex);
-            else
-              m_ArchiveLooseOverwrittenList.insert(altIndex);
-          }
-          else {
-            m_ArchiveOverwrittenList.insert(altIndex);
-          }
-        } else {
-          providesAnything = true;
-        }
-
-        // Sort out the alternatives
-        for (const auto& altInfo : alternatives) {
-          if ((altInfo.originID() != dataID) && (altInfo.originID() != origin.getID())) {
-            FilesOrigin &altOrigin = m_Core.directoryStructure()->getOriginByID(altInfo.originID());
-            QString altOriginName = ToQString(altOrigin.getName());
-            unsigned int altIndex = ModInfo::getIndex(altOriginName);
-            if (!altInfo.isFromArchive()) {
-              if (!archiveData.isValid()) {
-                if (origin.getPriority() > altOrigin.getPriority()) {
-                  m_OverwriteList.insert(altIndex);
-                } else {
-                  m_OverwrittenList.insert(altIndex);
-                }
-              } else {
-                m_ArchiveLooseOverwrittenList.insert(altIndex);
-              }
-            } else {
-              if (!archiveData.isValid()) {
-                m_ArchiveLooseOverwriteList.insert(altIndex);
-              } else {
-                if (archiveData.order() > altInfo.archive().order()) {
-                  m_ArchiveOverwriteList.insert(altIndex);
-                } else if (archiveData.order() < altInfo.archive().order()) {
-                  m_ArchiveOverwrittenList.insert(altIndex);
-                }
-              }
-            }
-          }
-        }
-      }
+  const auto* ds = m_Core.directoryStructure();
+  const auto& graph = ds->getFileRegister()->conflicts();
+  const std::wstring name = ToWString(this->name());
+
+  auto fill = [&](std::set<unsigned int>& set, ConflictGraph::Kinds kind) {
+    set.clear();
+
+    if (m_Conflicts.neighbours[kind] == 0 || !ds->originExists(name)) {
+      return;
     }
-    m_LastConflictCheck = QTime::currentTime();
-
-    if (files.size() != 0) {
-      if (!providesAnything)
-        m_CurrentConflictState = CONFLICT_REDUNDANT;
-      else if (!m_OverwriteList.empty() && !m_OverwrittenList.empty())
-        m_CurrentConflictState = CONFLICT_MIXED;
-      else if (!m_OverwriteList.empty())
-        m_CurrentConflictState = CONFLICT_OVERWRITE;
-      else if (!m_OverwrittenList.empty())
-        m_CurrentConflictState = CONFLICT_OVERWRITTEN;
-
-      if (!m_ArchiveOverwriteList.empty() && !m_ArchiveOverwrittenList.empty())
-        m_ArchiveConflictState = CONFLICT_MIXED;
-      else if (!m_ArchiveOverwriteList.empty())
-        m_ArchiveConflictState = CONFLICT_OVERWRITE;
-      else if (!m_ArchiveOverwrittenList.empty())
-        m_ArchiveConflictState = CONFLICT_OVERWRITTEN;
-
-      if (!m_ArchiveLooseOverwrittenList.empty() && !m_ArchiveLooseOverwriteList.empty())
-        m_ArchiveConflictLooseState = CONFLICT_MIXED;
-      else if (!m_ArchiveLooseOverwrittenList.empty())
-        m_ArchiveConflictLooseState = CONFLICT_OVERWRITTEN;
-      else if (!m_ArchiveLooseOverwriteList.empty())
-        m_ArchiveConflictLooseState = CONFLICT_OVERWRITE;
-
-      m_HasHiddenFiles = hasHiddenFiles;
+
+    const auto id = ds->getOriginByName(name).getID();
+
+    for (const OriginID other : graph.neighbours(id, kind)) {
+      const FilesOrigin& altOrigin = ds->getOriginByID(other);
+      set.insert(ModInfo::getIndex(altOrigin));
     }
-  }
+  };
+
+  fill(m_OverwriteList, ConflictGraph::Overwrite);
+  fill(m_OverwrittenList, ConflictGraph::Overwritten);
+  fill(m_ArchiveOverwriteList, ConflictGraph::ArchiveOverwrite);
+  fill(m_ArchiveOverwrittenList, ConflictGraph::ArchiveOverwritten);
+  fill(m_ArchiveLooseOverwriteList, ConflictGraph::ArchiveLooseOverwrite);
+  fill(m_ArchiveLooseOverwrittenList, ConflictGraph::ArchiveLooseOverwritten);
+
+  m_ConflictSetsValid = true;
+}
+
+const std::set<unsigned int>& ModInfoWithConflictInfo::getModOverwrite() const
+{
+  updateConflictSets();
+  return m_OverwriteList;
+}
+
+const std::set<unsigned int>& ModInfoWithConflictInfo::getModOverwritten() const
+{
+  updateConflictSets();
+  return m_OverwrittenList;
+}
+
+const std::set<unsigned int>& ModInfoWithConflictInfo::getModArchiveOverwrite() const
+{
+  updateConflictSets();
+  return m_ArchiveOverwriteList;
+}
+
+const std::set<unsigned int>& ModInfoWithConflictInfo::getModArchiveOverwritten() const
+{
+  updateConflictSets();
+  return m_ArchiveOverwrittenList;
+}
+
+const std::set<unsigned int>& ModInfoWithConflictInfo::getModArchiveLooseOverwrite() const
+{
+  updateConflictSets();
+  return m_ArchiveLooseOverwriteList;
+}
+
+const std::set<unsigned int>& ModInfoWithConflictInfo::getModArchiveLooseOverwritten() const
+{
+  updateConflictSets();
+  return m_ArchiveLooseOverwrittenList;
 }
 
 ModInfoWithConflictInfo::EConflictType ModInfoWithConflictInfo::isConflicted() const
 {
-  // this is costy so cache the result
-  QTime now = QTime::currentTime();
-  if (m_LastConflictCheck.isNull() || (m_LastConflictCheck.secsTo(now) > 10)) {
-    doConflictCheck();
+  const auto& c = conflicts();
+
+  const bool overwrite = (c.neighbours[ConflictGraph::Overwrite] > 0);
+  const bool overwritten = (c.neighbours[ConflictGraph::Overwritten] > 0);
+
+  if (c.files == 0) {
+    return CONFLICT_NONE;
+  } else if (c.provided == 0) {
+    return CONFLICT_REDUNDANT;
+  } else if (overwrite && overwritten) {
+    return CONFLICT_MIXED;
+  } else if (overwrite) {
+    return CONFLICT_OVERWRITE;
+  } else if (overwritten) {
+    return CONFLICT_OVERWRITTEN;
   }
 
-  return m_CurrentConflictState;
+  return CONFLICT_NONE;
 }
 
 ModInfoWithConflictInfo::EConflictType ModInfoWithConflictInfo::isArchiveConflicted() const
 {
-  QTime now = QTime::currentTime();
-  if (m_LastConflictCheck.isNull() || (m_LastConflictCheck.secsTo(now) > 10)) {
-    doConflictCheck();
+  const auto& c = conflicts();
+
+  const bool overwrite = (c.neighbours[ConflictGraph::ArchiveOverwrite] > 0);
+  const bool overwritten = (c.neighbours[ConflictGraph::ArchiveOverwritten] > 0);
+
+  if (overwrite && overwritten) {
+    return CONFLICT_MIXED;
+  } else if (overwrite) {
+    return CONFLICT_OVERWRITE;
+  } else if (overwritten) {
+    return CONFLICT_OVERWRITTEN;
   }
 
-  return m_ArchiveConflictState;
+  return CONFLICT_NONE;
 }
 
 ModInfoWithConflictInfo::EConflictType ModInfoWithConflictInfo::isLooseArchiveConflicted() const
 {
-  QTime now = QTime::currentTime();
-  if (m_LastConflictCheck.isNull() || (m_LastConflictCheck.secsTo(now) > 10)) {
-    doConflictCheck();
+  const auto& c = conflicts();
+
+  const bool overwrite = (c.neighbours[ConflictGraph::ArchiveLooseOverwrite] > 0);
+  const bool overwritten = (c.neighbours[ConflictGraph::ArchiveLooseOverwritten] > 0);
+
+  if (overwrite && overwritten) {
+    return CONFLICT_MIXED;
+  } else if (overwritten) {
+    return CONFLICT_OVERWRITTEN;
+  } else if (overwrite) {
+    return CONFLICT_OVERWRITE;
   }
 
-  return m_ArchiveConflictLooseState;
+  return CONFLICT_NONE;
 }
 
 
 bool ModInfoWithConflictInfo::isRedundant() const
 {
-  std::wstring name = ToWString(this->name());
-  if (m_Core.directoryStructure()->originExists(name)) {
-    FilesOrigin &origin = m_Core.directoryStructure()->getOriginByName(name);
-    std::vector<FileEntryPtr> files = origin.getFiles();
-    bool ignore = false;
-    for (auto iter = files.begin(); iter != files.end(); ++iter) {
-      if ((*iter)->getOrigin(ignore) == origin.getID()) {
-        return false;
-      }
-    }
-    return true;
-  } else {
-    return false;
-  }
+  // counted by the conflict graph when the structure is refreshed, same as
+  // CONFLICT_REDUNDANT in isConflicted()
+  const auto& c = conflicts();
+  return (c.files > 0 && c.provided == 0);
 }
 
 
 bool ModInfoWithConflictInfo::hasHiddenFiles() const
 {
-  QTime now = QTime::currentTime();
-  if (m_LastConflictCheck.isNull() || (m_LastConflictCheck.secsTo(now) > 10)) {
-    doConflictCheck();
-  }
-
-  return m_HasHiddenFiles;
+  return (conflicts().hidden > 0);
 }
 
 void ModInfoWithConflictInfo::diskContentModified() {
   m_FileTree.invalidate();
   m_Valid.invalidate();
   m_Contents.invalidate();
+  m_Prefetched = false;
 }
 
-void ModInfoWithConflictInfo::prefetch() {
+bool ModInfoWithConflictInfo::prefetch() {
+  if (m_Prefetched.exchange(true)) {
+    return false;
+  }
+
   // Populating the tree to 1-depth (IFileTree is lazy, so size() forces the
   // tree to populate the first level):
   fileTree()->size();
+
+  // both are memoized and locked, so computing them here means the gui
+  // thread only reads the cached values when painting
+  isValid();
+  getContents();
+
+  return true;
 }
 
 bool ModInfoWithConflictInfo::doIsValid() const {
@@ -326,9 +343,41 @@ bool ModInfoWithConflictInfo::doIsValid() const {
 }
 
 std::shared_ptr<const IFileTree> ModInfoWithConflictInfo::fileTree() const {
+  g_FileTreesUsed = Clock::now().time_since_epoch().count();
   return m_FileTree.value();
 }
 
+void ModInfoWithConflictInfo::releaseConflictSets()
+{
+  // swapped with empty sets so the nodes are freed
+  for (auto* s : {
+    &m_OverwriteList, &m_OverwrittenList,
+    &m_ArchiveOverwriteList, &m_ArchiveOverwrittenList,
+    &m_ArchiveLooseOverwriteList, &m_ArchiveLooseOverwrittenList})
+  {
+    std::set<unsigned int>().swap(*s);
+  }
+
+  m_ConflictSetsValid = false;
+}
+
+void ModInfoWithConflictInfo::releaseFileTree()
+{
+  // the validity and the contents stay cached, so this doesn't prefetch the
+  // mod again; the tree is read from the disk the next time it's needed
+  m_FileTree.invalidate();
+}
+
+Clock::time_point ModInfoWithConflictInfo::conflictSetsLastUsed()
+{
+  return Clock::time_point(Clock::duration(g_ConflictSetsUsed.load()));
+}
+
+Clock::time_point ModInfoWithConflictInfo::fileTreesLastUsed()
+{
+  return Clock::time_point(Clock::duration(g_FileTreesUsed.load()));
+}
+
 bool ModInfoWithConflictInfo::isValid() const {
   return m_Valid.value();
 }
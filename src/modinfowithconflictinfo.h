@@ -5,9 +5,11 @@
 
 #include "memoizedlock.h"
 #include "modinfo.h"
+#include "shared/conflictgraph.h"
 
+#include <atomic>
+#include <chrono>
 #include <set>
-#include <QTime>
 
 class ModInfoWithConflictInfo : public ModInfo
 {
@@ -54,13 +56,36 @@ public:
    */
   void clearCaches() override;
 
-  const std::set<unsigned int>& getModOverwrite() const override { return m_OverwriteList; }
-  const std::set<unsigned int>& getModOverwritten() const override { return m_OverwrittenList; }
-  const std::set<unsigned int>& getModArchiveOverwrite() const override { return m_ArchiveOverwriteList; }
-  const std::set<unsigned int>& getModArchiveOverwritten() const override { return m_ArchiveOverwrittenList; }
-  const std::set<unsigned int>& getModArchiveLooseOverwrite() const override { return m_ArchiveLooseOverwriteList; }
-  const std::set<unsigned int>& getModArchiveLooseOverwritten() const override { return m_ArchiveLooseOverwrittenList; }
+  MOShared::MemoryUsage conflictSetsMemory() const override;
 
+  /**
+   * @brief only the first level of the tree is counted, it's populated by
+   *     prefetch(); deeper levels are populated on demand and counting them
+   *     would populate them
+   */
+  MOShared::MemoryUsage fileTreeMemory() const override;
+
+  void releaseConflictSets() override;
+  void releaseFileTree() override;
+
+  /**
+   * @brief when the conflict sets or the file tree of any mod were last used,
+   *     the least recently used caches are released first
+   */
+  static std::chrono::steady_clock::time_point conflictSetsLastUsed();
+  static std::chrono::steady_clock::time_point fileTreesLastUsed();
+
+  const std::set<unsigned int>& getModOverwrite() const override;
+  const std::set<unsigned int>& getModOverwritten() const override;
+  const std::set<unsigned int>& getModArchiveOverwrite() const override;
+  const std::set<unsigned int>& getModArchiveOverwritten() const override;
+  const std::set<unsigned int>& getModArchiveLooseOverwrite() const override;
+  const std::set<unsigned int>& getModArchiveLooseOverwritten() const override;
+
+  /**
+   * @brief reads the conflicts of this mod from the conflict graph of the
+   *        current directory structure
+   */
   void doConflictCheck() const override;
 
 public slots:
@@ -117,35 +142,59 @@ private:
   EConflictType isLooseArchiveConflicted() const;
 
   /**
-   * @return true if this mod is completely replaced by others
+   * @return true if this mod has files and they are all replaced by others
    */
   bool isRedundant() const;
 
+  /**
+   * @return true if files of this mod are hidden, as counted by the conflict
+   *         graph
+   */
   bool hasHiddenFiles() const;
 
+  /**
+   * @return the conflict state of this mod, read again from the graph if it
+   *         changed since the last call
+   */
+  const MOShared::ConflictGraph::Counts& conflicts() const;
+
+  /**
+   * @brief fills the sets of conflicting mods from the graph if they're out
+   *        of date, they're only built when asked for
+   */
+  void updateConflictSets() const;
+
 protected:
 
   /**
    * @brief Prefetch content for this mod.
    *
-   * This method can be used to prefetch content from the mod, e.g., for isValid()
-   * or getContents(). This method will only be called when first creating the mod
-   * using multiple threads for all the mods.
+   * Reads the first level of the file tree and computes isValid() and
+   * getContents(), which is everything that needs the disk to paint the mod.
    */
-  virtual void prefetch() override;
+  virtual bool prefetch() override;
 
 private:
 
   MOBase::MemoizedLocked<std::shared_ptr<const MOBase::IFileTree>> m_FileTree;
+
+  // the tree last created by m_FileTree, expired once it was invalidated and
+  // released by everything that used it
+  mutable std::weak_ptr<const MOBase::IFileTree> m_LastFileTree;
   MOBase::MemoizedLocked<bool> m_Valid;
   MOBase::MemoizedLocked<std::set<int>> m_Contents;
 
-  mutable EConflictType m_CurrentConflictState;
-  mutable EConflictType m_ArchiveConflictState;
-  mutable EConflictType m_ArchiveConflictLooseState;
-  mutable bool m_HasLooseOverwrite;
-  mutable bool m_HasHiddenFiles;
-  mutable QTime m_LastConflictCheck;
+  // whether prefetch() has run since the content on disk last changed
+  std::atomic<bool> m_Prefetched;
+
+  // conflict state of this mod and the generation of the graph it was read
+  // from, see conflicts()
+  mutable MOShared::ConflictGraph::Counts m_Conflicts;
+  mutable std::uint64_t m_ConflictGeneration;
+  mutable bool m_ConflictsValid;
+
+  // whether the sets below match m_Conflicts
+  mutable bool m_ConflictSetsValid;
 
   mutable std::set<unsigned int> m_OverwriteList;   // indices of mods overritten by this mod
   mutable std::set<unsigned int> m_OverwrittenList; // indices of mods overwriting this mod
@@ -0,0 +1,374 @@
+#include "modintegrity.h"
+#include "taskexecutor.h"
+#include <log.h>
+#include <safewritefile.h>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+using namespace MOBase;
+using namespace MOShared;
+
+static constexpr quint32 ManifestMagic = 0x494d4f4d;  // "MOMI"
+static constexpr quint32 ManifestVersion = 1;
+
+// files are hashed this much at a time, QCryptographicHash takes an int
+static constexpr qint64 HashBlockSize = 16 * 1024 * 1024;
+
+static QString g_directory;
+
+
+struct ModIntegrity::Entry
+{
+  // relative to the mod, with forward slashes
+  QString path;
+
+  quint64 size = 0;
+
+  // milliseconds since epoch
+  qint64 time = 0;
+
+  QByteArray hash;
+};
+
+struct ModIntegrity::Manifest
+{
+  std::vector<Entry> entries;
+};
+
+
+void ModIntegrity::setDirectory(const QString& dir)
+{
+  g_directory = dir;
+}
+
+QString ModIntegrity::manifestPath(const QString& name)
+{
+  return g_directory + "/" + name + ".integrity";
+}
+
+bool ModIntegrity::record(const Mod& mod)
+{
+  Manifest m;
+  m.entries = scan(mod.path);
+
+  std::atomic<bool> failed = false;
+
+  {
+    TaskGroup g(TaskPriority::Low);
+
+    for (auto& e : m.entries) {
+      g.run([&] {
+        e.hash = hash(mod.path + "/" + e.path, nullptr);
+
+        if (e.hash.isEmpty()) {
+          failed = true;
+        }
+      });
+    }
+
+    g.wait();
+  }
+
+  if (failed) {
+    log::error("failed to hash some files of {}, not recording them", mod.name);
+    return false;
+  }
+
+  if (!write(mod.name, m)) {
+    return false;
+  }
+
+  log::debug("recorded {} files for {}", m.entries.size(), mod.name);
+  return true;
+}
+
+void ModIntegrity::recordLater(const Mod& mod)
+{
+  TaskExecutor::instance().post(TaskPriority::Low, [mod] {
+    record(mod);
+  });
+}
+
+std::vector<ModIntegrity::Result> ModIntegrity::verify(
+  const std::vector<Mod>& mods, const std::atomic<bool>& cancel,
+  ProgressF progress)
+{
+  std::vector<Result> results(mods.size());
+  std::vector<Manifest> manifests(mods.size());
+
+  // files that have to be hashed again, by mod and by index in the manifest
+  struct Job
+  {
+    std::size_t mod;
+    std::size_t entry;
+    qint64 time;
+    bool hashed;
+    bool changed;
+  };
+
+  std::vector<Job> jobs;
+  std::uint64_t totalBytes = 0;
+
+  for (std::size_t i=0; i<mods.size(); ++i) {
+    Result& r = results[i];
+    Manifest& m = manifests[i];
+
+    r.mod = mods[i].name;
+    r.hasManifest = read(mods[i].name, m);
+
+    if (!r.hasManifest) {
+      continue;
+    }
+
+    r.files = m.entries.size();
+
+    std::map<QString, const Entry*> onDisk;
+    const auto disk = scan(mods[i].path);
+
+    for (auto& e : disk) {
+      onDisk.emplace(e.path.toLower(), &e);
+    }
+
+    for (std::size_t ei=0; ei<m.entries.size(); ++ei) {
+      const Entry& e = m.entries[ei];
+      auto itor = onDisk.find(e.path.toLower());
+
+      if (itor == onDisk.end()) {
+        r.missing.append(e.path);
+        continue;
+      }
+
+      const Entry& d = *itor->second;
+      onDisk.erase(itor);
+
+      if (d.size != e.size) {
+        r.changed.append(e.path);
+      } else if (d.time != e.time) {
+        jobs.push_back({i, ei, d.time, false, false});
+        totalBytes += e.size;
+      }
+    }
+
+    for (auto&& [key, d] : onDisk) {
+      r.added.append(d->path);
+    }
+  }
+
+  std::atomic<std::uint64_t> doneBytes = 0;
+
+  {
+    TaskGroup g(TaskPriority::Normal);
+
+    for (auto& j : jobs) {
+      g.run([&] {
+        if (cancel) {
+          return;
+        }
+
+        const Entry& e = manifests[j.mod].entries[j.entry];
+        const auto h = hash(mods[j.mod].path + "/" + e.path, &cancel);
+
+        j.hashed = !h.isEmpty();
+        j.changed = (j.hashed && h != e.hash);
+        doneBytes += e.size;
+
+        if (progress) {
+          progress(doneBytes, totalBytes);
+        }
+      });
+    }
+
+    g.wait();
+  }
+
+  // the jobs are done, the results and manifests only have one writer now
+  std::vector<bool> touched(mods.size(), false);
+
+  for (const auto& j : jobs) {
+    if (!j.hashed) {
+      // cancelled or unreadable, errors have been logged
+      continue;
+    }
+
+    Result& r = results[j.mod];
+    Entry& e = manifests[j.mod].entries[j.entry];
+
+    ++r.hashed;
+
+    if (j.changed) {
+      r.changed.append(e.path);
+    } else {
+      // same content, only the time moved
+      e.time = j.time;
+      touched[j.mod] = true;
+    }
+  }
+
+  for (std::size_t i=0; i<mods.size(); ++i) {
+    if (touched[i]) {
+      write(mods[i].name, manifests[i]);
+    }
+  }
+
+  return results;
+}
+
+void ModIntegrity::renamed(const QString& from, const QString& to)
+{
+  const auto oldPath = manifestPath(from);
+
+  if (!QFile::exists(oldPath)) {
+    return;
+  }
+
+  const auto newPath = manifestPath(to);
+  QFile::remove(newPath);
+
+  if (!QFile::rename(oldPath, newPath)) {
+    log::error("failed to rename integrity manifest {} to {}", oldPath, newPath);
+  }
+}
+
+bool ModIntegrity::read(const QString& name, Manifest& m)
+{
+  const auto path = manifestPath(name);
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    // mods installed before manifests existed don't have one
+    return false;
+  }
+
+  QDataStream s(&file);
+  s.setVersion(QDataStream::Qt_5_12);
+
+  quint32 magic = 0, version = 0, count = 0;
+  s >> magic >> version >> count;
+
+  if (magic != ManifestMagic || version != ManifestVersion) {
+    log::debug("ignoring integrity manifest {}, wrong version", path);
+    return false;
+  }
+
+  m.entries.resize(count);
+
+  for (auto& e : m.entries) {
+    s >> e.path >> e.size >> e.time >> e.hash;
+  }
+
+  if (s.status() != QDataStream::Ok) {
+    log::error("integrity manifest {} is corrupted, ignoring it", path);
+    m.entries.clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool ModIntegrity::write(const QString& name, const Manifest& m)
+{
+  const auto path = manifestPath(name);
+
+  QByteArray data;
+
+  {
+    QDataStream s(&data, QIODevice::WriteOnly);
+    s.setVersion(QDataStream::Qt_5_12);
+
+    s << ManifestMagic << ManifestVersion << static_cast<quint32>(m.entries.size());
+
+    for (const auto& e : m.entries) {
+      s << e.path << e.size << e.time << e.hash;
+    }
+  }
+
+  QDir().mkpath(QFileInfo(path).absolutePath());
+
+  try
+  {
+    SafeWriteFile file(path);
+    file->resize(0);
+    file->write(data);
+    file.commit();
+    return true;
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to save integrity manifest {}: {}", path, e.what());
+    return false;
+  }
+}
+
+std::vector<ModIntegrity::Entry> ModIntegrity::scan(const QString& path)
+{
+  std::vector<Entry> v;
+
+  const QDir root(path);
+  QDirIterator it(
+    path, QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+
+  while (it.hasNext()) {
+    it.next();
+
+    const QFileInfo fi = it.fileInfo();
+    const QString rel = root.relativeFilePath(fi.filePath());
+
+    if (rel.compare("meta.ini", Qt::CaseInsensitive) == 0) {
+      continue;
+    }
+
+    Entry e;
+    e.path = rel;
+    e.size = static_cast<quint64>(fi.size());
+    e.time = fi.lastModified().toMSecsSinceEpoch();
+
+    v.push_back(std::move(e));
+  }
+
+  return v;
+}
+
+QByteArray ModIntegrity::hash(const QString& path, const std::atomic<bool>* cancel)
+{
+  QFile file(path);
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    log::error("can't open {} to hash it: {}", path, file.errorString());
+    return {};
+  }
+
+  QCryptographicHash h(QCryptographicHash::Md5);
+  const qint64 size = file.size();
+
+  // empty files can't be mapped
+  if (size > 0) {
+    if (uchar* p = file.map(0, size)) {
+      for (qint64 offset=0; offset<size; offset+=HashBlockSize) {
+        if (cancel && *cancel) {
+          return {};
+        }
+
+        const auto n = std::min(HashBlockSize, size - offset);
+        h.addData(reinterpret_cast<const char*>(p + offset), static_cast<int>(n));
+      }
+
+      file.unmap(p);
+    } else {
+      // mapping can fail for files on some network shares
+      if (!h.addData(&file)) {
+        log::error("can't read {} to hash it: {}", path, file.errorString());
+        return {};
+      }
+    }
+  }
+
+  return h.result();
+}
@@ -0,0 +1,104 @@
+#ifndef MODORGANIZER_MODINTEGRITY_INCLUDED
+#define MODORGANIZER_MODINTEGRITY_INCLUDED
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// checks whether the files of mods still match what was installed
+//
+// when a mod is installed, the size, modification time and hash of each of
+// its files are recorded in a manifest, one per mod, in the integrity
+// directory of the instance; verify() compares the files on disk against the
+// manifests
+//
+// files whose size and modification time haven't changed since they were
+// recorded are not read again, so only files that were touched are hashed;
+// the others are hashed in parallel on the task executor, with the files
+// mapped in memory
+//
+// meta.ini is ignored, it's rewritten all the time
+//
+class ModIntegrity
+{
+public:
+  struct Mod
+  {
+    QString name;
+    QString path;
+  };
+
+  struct Result
+  {
+    QString mod;
+
+    // false if the mod has no manifest, none of the other fields are set
+    bool hasManifest = false;
+
+    // files in the manifest and files that had to be hashed again
+    std::size_t files = 0;
+    std::size_t hashed = 0;
+
+    // relative paths of the files that are gone, whose content changed or
+    // that are not in the manifest
+    QStringList missing;
+    QStringList changed;
+    QStringList added;
+
+    bool ok() const
+    {
+      return missing.isEmpty() && changed.isEmpty();
+    }
+  };
+
+  // called with the number of bytes hashed so far and the total
+  using ProgressF = std::function<void (std::uint64_t done, std::uint64_t total)>;
+
+  // the directory the manifests are stored in, must be set before anything
+  // else is called
+  //
+  static void setDirectory(const QString& dir);
+
+  // hashes every file of the mod and replaces its manifest; blocks until
+  // it's done, returns false on errors, which are logged
+  //
+  static bool record(const Mod& mod);
+
+  // record() on the task executor, with a low priority
+  //
+  static void recordLater(const Mod& mod);
+
+  // verifies the given mods; the manifests of the files that were hashed
+  // again and didn't change are updated with their new modification time so
+  // they're skipped next time
+  //
+  // `cancel` is checked between files, results are incomplete if it's set;
+  // `progress` is called from the executor threads
+  //
+  static std::vector<Result> verify(
+    const std::vector<Mod>& mods, const std::atomic<bool>& cancel,
+    ProgressF progress={});
+
+  // moves the manifest of a mod that was renamed
+  //
+  static void renamed(const QString& from, const QString& to);
+
+private:
+  struct Entry;
+  struct Manifest;
+
+  static QString manifestPath(const QString& name);
+
+  static bool read(const QString& name, Manifest& m);
+  static bool write(const QString& name, const Manifest& m);
+
+  // lists the files of the mod, without meta.ini
+  static std::vector<Entry> scan(const QString& path);
+
+  // md5 of the file, empty on errors
+  static QByteArray hash(const QString& path, const std::atomic<bool>* cancel);
+};
+
+#endif // MODORGANIZER_MODINTEGRITY_INCLUDED
@@ -70,6 +70,9 @@ ModList::ModList(PluginContainer *pluginContainer, OrganizerCore *organizer)
   , m_InNotifyChange(false)
   , m_FontMetrics(QFont())
   , m_PluginContainer(pluginContainer)
+  , m_DataCache(this, {
+      Qt::DisplayRole, Qt::CheckStateRole, Qt::TextAlignmentRole, Qt::FontRole,
+      Qt::DecorationRole, Qt::ForegroundRole, Qt::BackgroundRole})
 {
   m_LastCheck.start();
 }
@@ -85,6 +88,7 @@ ModList::~ModList()
 void ModList::setProfile(Profile *profile)
 {
   m_Profile = profile;
+  m_DataCache.invalidate();
 }
 
 int ModList::rowCount(const QModelIndex &parent) const
@@ -169,13 +173,22 @@ QString ModList::getConflictFlagText(ModInfo::EConflictFlag flag, ModInfo::Ptr m
 }
 
 QVariant ModList::data(const QModelIndex &modelIndex, int role) const
+{
+  // the roles needed to paint a row are cached, they're invalidated when the
+  // rows change
+  return m_DataCache.get(modelIndex, role, [&]{ return modData(modelIndex, role); });
+}
+
+QVariant ModList::modData(const QModelIndex &modelIndex, int role) const
 {
   if (m_Profile == nullptr) return QVariant();
   if (!modelIndex.isValid()) return QVariant();
   unsigned int modIndex = modelIndex.row();
   int column = modelIndex.column();
 
-  ModInfo::Ptr modInfo = ModInfo::getByIndex(modIndex);
+  // this is called for every painted cell, the mod is read from the snapshot
+  // without copying the pointer
+  const ModInfo::Ptr& modInfo = ModInfo::snapshot().at(modIndex);
   if ((role == Qt::DisplayRole) ||
       (role == Qt::EditRole)) {
     if ((column == COL_FLAGS)
@@ -772,13 +785,13 @@ void ModList::modInfoChanged(ModInfo::Ptr info)
   if (info->name() == m_ChangeInfo.name) {
     IModList::ModStates newState = state(info->name());
     if (m_ChangeInfo.state != newState) {
-      m_ModStateChanged({ {info->name(), newState} });
+      sendModStateChanged({ {info->name(), newState} });
     }
 
     int row = ModInfo::getIndex(info->name());
     info->diskContentModified();
     emit aboutToChangeData();
-    emit dataChanged(index(row, 0), index(row, columnCount()));
+    emit dataChanged(index(row, 0), index(row, columnCount() - 1));
     emit postDataChanged();
   } else {
     log::error("modInfoChanged not called after modInfoAboutToChange");
@@ -987,11 +1000,26 @@ boost::signals2::connection ModList::onModStateChanged(const std::function<void(
 
 void ModList::notifyModInstalled(MOBase::IModInterface* mod) const
 {
+  if (m_Pending.batches > 0) {
+    m_Pending.installed.push_back(mod->name());
+    return;
+  }
+
   m_ModInstalled(mod);
 }
 
 void ModList::notifyModRemoved(QString const& modName) const
 {
+  if (m_Pending.batches > 0) {
+    // the mod is gone, plugins can't do anything with its other notifications
+    auto& v = m_Pending.installed;
+    v.erase(std::remove(v.begin(), v.end(), modName), v.end());
+    m_Pending.states.erase(modName);
+
+    m_Pending.removed.push_back(modName);
+    return;
+  }
+
   m_ModRemoved(modName);
 }
 
@@ -1002,9 +1030,62 @@ void ModList::notifyModStateChanged(QList<unsigned int> modIndices) const
     ModInfo::Ptr modInfo = ModInfo::getByIndex(modIndex);
     mods.emplace(modInfo->name(), state(modIndex));
   }
+  sendModStateChanged(std::move(mods));
+}
+
+void ModList::sendModStateChanged(
+  std::map<QString, IModList::ModStates> mods) const
+{
+  if (mods.empty()) {
+    return;
+  }
+
+  if (m_Pending.batches > 0) {
+    // later states replace earlier ones
+    for (auto&& [name, state] : mods) {
+      m_Pending.states[name] = state;
+    }
+
+    return;
+  }
+
   m_ModStateChanged(mods);
 }
 
+void ModList::flushNotifications() const
+{
+  auto p = std::move(m_Pending);
+  m_Pending = {};
+
+  for (const auto& name : p.removed) {
+    m_ModRemoved(name);
+  }
+
+  for (const auto& name : p.installed) {
+    if (auto* mod=getMod(name)) {
+      m_ModInstalled(mod);
+    }
+  }
+
+  if (!p.states.empty()) {
+    m_ModStateChanged(p.states);
+  }
+}
+
+
+ModList::NotificationBatch::NotificationBatch(ModList& list)
+  : m_list(list)
+{
+  ++m_list.m_Pending.batches;
+}
+
+ModList::NotificationBatch::~NotificationBatch()
+{
+  if (--m_list.m_Pending.batches == 0) {
+    m_list.flushNotifications();
+  }
+}
+
 boost::signals2::connection ModList::onModMoved(const std::function<void (const QString &, int, int)> &func)
 {
   return m_ModMoved.connect(func);
@@ -1190,6 +1271,7 @@ bool ModList::removeRows(int row, int count, const QModelIndex &parent)
   }
 
   bool success = false;
+  NotificationBatch batch(*this);
 
   if (count == 1) {
     ModInfo::Ptr modInfo = ModInfo::getByIndex(row);
@@ -1222,6 +1304,12 @@ bool ModList::removeRows(int row, int count, const QModelIndex &parent)
 
 
 void ModList::notifyChange(int rowStart, int rowEnd)
+{
+  notifyChange(rowStart, rowEnd, {});
+}
+
+void ModList::notifyChange(
+  int rowStart, int rowEnd, std::initializer_list<EColumn> columns)
 {
   // this function can emit dataChanged(), which can eventually recurse back
   // here; for example:
@@ -1256,7 +1344,26 @@ void ModList::notifyChange(int rowStart, int rowEnd)
     if (rowEnd == -1) {
       rowEnd = rowStart;
     }
-    emit dataChanged(this->index(rowStart, 0), this->index(rowEnd, this->columnCount() - 1));
+
+    if (columns.size() == 0) {
+      emit dataChanged(this->index(rowStart, 0), this->index(rowEnd, this->columnCount() - 1));
+      return;
+    }
+
+    // one signal per run of contiguous columns
+    std::vector<int> sorted(columns.begin(), columns.end());
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    for (std::size_t i=0; i<sorted.size();) {
+      std::size_t j = i + 1;
+      while (j < sorted.size() && sorted[j] == sorted[j - 1] + 1) {
+        ++j;
+      }
+
+      emit dataChanged(this->index(rowStart, sorted[i]), this->index(rowEnd, sorted[j - 1]));
+      i = j;
+    }
   }
 }
 
@@ -43,7 +43,9 @@ void ModListByPriorityProxy::setSortOrder(Qt::SortOrder order)
 {
   if (m_sortOrder != order) {
     m_sortOrder = order;
-    onModelLayoutChanged();
+
+    // every row moves, this is not worth doing with moves
+    rebuildLayout();
   }
 }
 
@@ -55,20 +57,15 @@ void ModListByPriorityProxy::buildMapping()
   }
 }
 
-void ModListByPriorityProxy::buildTree()
+ModListByPriorityProxy::Layout ModListByPriorityProxy::targetLayout()
 {
-  if (!sourceModel()) return;
+  Layout layout;
+  layout.push_back({&m_Root, {}});
 
-  // reset the root
-  m_Root = { };
+  // entry of the separator the next mods go in
+  std::size_t current = 0;
 
-  // clear all children
-  for (auto& [index, item] : m_IndexToItem) {
-    item->children.clear();
-  }
-
-  TreeItem* root = &m_Root;
-  TreeItem* overwrite;
+  TreeItem* overwrite = nullptr;
   std::vector<TreeItem*> backups;
 
   auto fn = [&](const auto& p) {
@@ -77,39 +74,144 @@ void ModListByPriorityProxy::buildTree()
     TreeItem* item = m_IndexToItem[index].get();
 
     if (modInfo->isSeparator()) {
-      item->parent = &m_Root;
-      m_Root.children.push_back(item);
-      root = item;
+      layout[0].second.push_back(item);
+      layout.push_back({item, {}});
+      current = layout.size() - 1;
     }
     else if (modInfo->isOverwrite()) {
       // do not push here, because the overwrite is usually not at the right position
-      item->parent = &m_Root;
       overwrite = item;
     }
     else if (modInfo->isBackup()) {
       // do not push here, because backups are usually not at the right position
-      item->parent = &m_Root;
       backups.push_back(item);
     }
     else {
-      item->parent = root;
-      root->children.push_back(item);
+      layout[current].second.push_back(item);
     }
   };
 
+  auto& root = layout[0].second;
   auto& ibp = m_profile->getAllIndexesByPriority();
+
   if (m_sortOrder == Qt::AscendingOrder) {
     std::for_each(ibp.begin(), ibp.end(), fn);
-    m_Root.children.insert(m_Root.children.begin(),
-      std::make_move_iterator(backups.begin()), std::make_move_iterator(backups.end()));
-    m_Root.children.push_back(std::move(overwrite));
+    root.insert(root.begin(), backups.begin(), backups.end());
+
+    if (overwrite) {
+      root.push_back(overwrite);
+    }
   }
   else {
     std::for_each(ibp.rbegin(), ibp.rend(), fn);
-    m_Root.children.insert(m_Root.children.begin(), std::move(overwrite));
-    m_Root.children.insert(m_Root.children.end(),
-      std::make_move_iterator(backups.begin()), std::make_move_iterator(backups.end()));
+
+    if (overwrite) {
+      root.insert(root.begin(), overwrite);
+    }
+
+    root.insert(root.end(), backups.begin(), backups.end());
+  }
+
+  return layout;
+}
+
+void ModListByPriorityProxy::buildTree()
+{
+  if (!sourceModel()) return;
+
+  // reset the root
+  m_Root = { };
+
+  // clear all children
+  for (auto& [index, item] : m_IndexToItem) {
+    item->children.clear();
+  }
+
+  for (auto&& [parent, children] : targetLayout()) {
+    for (auto* child : children) {
+      child->parent = parent;
+    }
+
+    parent->children = std::move(children);
+  }
+}
+
+std::optional<std::vector<ModListByPriorityProxy::Move>>
+ModListByPriorityProxy::movesTo(const Layout& layout) const
+{
+  // the moves are done on a copy of the tree first, so the rows of each
+  // move are the ones after the previous moves
+  std::map<TreeItem*, std::vector<TreeItem*>> children;
+  std::map<TreeItem*, TreeItem*> parents;
+
+  children[const_cast<TreeItem*>(&m_Root)] = m_Root.children;
+
+  for (auto& [index, item] : m_IndexToItem) {
+    parents[item.get()] = item->parent;
+
+    if (!item->children.empty()) {
+      children[item.get()] = item->children;
+    }
+  }
+
+  std::vector<Move> moves;
+
+  // the children of each node are put in place one after the other; an item
+  // that's not where it should be is pulled from wherever it is, which is
+  // always after the rows already in place
+  for (auto&& [parent, target] : layout) {
+    auto& current = children[parent];
+
+    for (std::size_t i = 0; i < target.size(); ++i) {
+      TreeItem* item = target[i];
+
+      if (i < current.size() && current[i] == item) {
+        continue;
+      }
+
+      if (moves.size() >= MaxMoves) {
+        return {};
+      }
+
+      TreeItem* from = parents[item];
+      auto& fromChildren = children[from];
+      const auto fromRow = static_cast<int>(
+        std::find(fromChildren.begin(), fromChildren.end(), item) - fromChildren.begin());
+
+      if (fromRow >= static_cast<int>(fromChildren.size())) {
+        // not in the tree, the mapping is out of date
+        return {};
+      }
+
+      moves.push_back({item, from, fromRow, parent, static_cast<int>(i)});
+
+      fromChildren.erase(fromChildren.begin() + fromRow);
+      current.insert(current.begin() + i, item);
+      parents[item] = parent;
+    }
+  }
+
+  return moves;
+}
+
+void ModListByPriorityProxy::applyMove(const Move& m)
+{
+  beginMoveRows(indexOf(m.from), m.fromRow, m.fromRow, indexOf(m.to), m.toRow);
+
+  m.from->children.erase(m.from->children.begin() + m.fromRow);
+  m.to->children.insert(m.to->children.begin() + m.toRow, m.item);
+  m.item->parent = m.to;
+
+  endMoveRows();
+}
+
+QModelIndex ModListByPriorityProxy::indexOf(TreeItem* item) const
+{
+  if (item == &m_Root) {
+    return QModelIndex();
   }
+
+  return createIndex(item->parent->childIndex(item), 0, item);
 }
 
 void ModListByPriorityProxy::onModelRowsRemoved(const QModelIndex& parent, int first, int last)
@@ -118,6 +220,32 @@ void ModListByPriorityProxy::onModelRowsRemoved(const QModelIndex& parent, int f
 }
 
 void ModListByPriorityProxy::onModelLayoutChanged(const QList<QPersistentModelIndex>&, LayoutChangeHint hint)
+{
+  if (!sourceModel()) return;
+
+  if (m_IndexToItem.size() != ModInfo::getNumMods()) {
+    // mods were added or removed
+    onModelReset();
+    return;
+  }
+
+  // priorities changed, typically for a few mods that were dragged; moving
+  // their rows keeps the rest of the tree, the expanded separators and the
+  // scroll position as they are
+  const auto layout = targetLayout();
+
+  if (auto moves = movesTo(layout)) {
+    for (const auto& m : *moves) {
+      applyMove(m);
+    }
+
+    return;
+  }
+
+  rebuildLayout();
+}
+
+void ModListByPriorityProxy::rebuildLayout()
 {
   emit layoutAboutToBeChanged();
   auto persistent = persistentIndexList();
@@ -131,7 +259,7 @@ void ModListByPriorityProxy::onModelLayoutChanged(const QList<QPersistentModelIn
   }
   changePersistentIndexList(persistent, toPersistent);
 
-  emit layoutChanged({}, hint);
+  emit layoutChanged();
 }
 
 void ModListByPriorityProxy::onModelReset()
@@ -149,12 +277,13 @@ void ModListByPriorityProxy::onModelDataChanged(const QModelIndex& topLeft, cons
     return;
   }
 
+  // the roles are forwarded so the sort proxy above can tell what changed
   if (topLeft == bottomRight) {
-    emit dataChanged(proxyTopLeft, proxyTopLeft);
+    emit dataChanged(proxyTopLeft, proxyTopLeft, roles);
   }
   else {
     QModelIndex proxyBottomRight = mapFromSource(bottomRight);
-    emit dataChanged(proxyTopLeft, proxyBottomRight);
+    emit dataChanged(proxyTopLeft, proxyBottomRight, roles);
   }
 }
 
@@ -71,6 +71,51 @@ private:
   //
   void buildTree();
 
+  // rebuilds the tree in a layout change, all the rows are laid out again
+  //
+  void rebuildLayout();
+
+  struct TreeItem;
+
+  // children of the root and of each separator, root first
+  //
+  using Layout = std::vector<std::pair<TreeItem*, std::vector<TreeItem*>>>;
+
+  // a row moved from one node to another, rows are the ones before the move
+  //
+  struct Move
+  {
+    TreeItem* item;
+    TreeItem* from;
+    int fromRow;
+    TreeItem* to;
+    int toRow;
+  };
+
+  // the tree for the current priorities and sort order, requires the
+  // mapping
+  //
+  Layout targetLayout();
+
+  // the moves that turn the current tree into the given layout, in order;
+  // empty if there are more than MaxMoves, in which case the layout must be
+  // rebuilt instead
+  //
+  std::optional<std::vector<Move>> movesTo(const Layout& layout) const;
+
+  // moves a row with beginMoveRows()/endMoveRows()
+  //
+  void applyMove(const Move& m);
+
+  // index of the given node, invalid for the root
+  //
+  QModelIndex indexOf(TreeItem* item) const;
+
+  // more moves than this in one layout change are slower than rebuilding the
+  // layout, such as when many mods are sorted at once; the sort proxy on top
+  // of this one handles each move separately
+  static constexpr std::size_t MaxMoves = 20;
+
   struct TreeItem {
     ModInfo::Ptr mod;
     unsigned int index;
@@ -73,6 +73,7 @@ void ModListGlobalContextMenu::populate(OrganizerCore& core, ModListView* view,
   addAction(disableTxt, [=] { view->actions().setAllMatchingModsEnabled(false); });
 
   addAction(tr("Check for updates"), [=]() { view->actions().checkModsForUpdates(); });
+  addAction(tr("Verify mods"), [=]() { view->actions().verifyMods(); });
   addAction(tr("Refresh"), &core, &OrganizerCore::profileRefresh);
   addAction(tr("Export to csv..."), [=]() { view->actions().exportModListCSV(); });
 }
@@ -425,6 +426,7 @@ void ModListContextMenu::addRegularActions(ModInfo::Ptr mod)
   addAction(tr("Reinstall Mod"), [=]() { m_actions.reinstallMod(m_index); });
   addAction(tr("Remove Mod..."), [=]() { m_actions.removeMods(m_selected); });
   addAction(tr("Create Backup"), [=]() { m_actions.createBackup(m_index); });
+  addAction(tr("Verify files"), [=]() { m_actions.verifyMods(m_selected); });
 
   if (std::find(flags.begin(), flags.end(), ModInfo::FLAG_HIDDEN_FILES) != flags.end()) {
     addAction(tr("Restore hidden files"), [=]() { m_actions.restoreHiddenFiles(m_selected); });
@@ -16,10 +16,10 @@ ModListProxy::~ModListProxy()
 
 void ModListProxy::connectSignals()
 {
-  m_Connections.push_back(m_Proxied->onModInstalled(callSignalIfPluginActive(m_OrganizerProxy, m_ModInstalled)));
-  m_Connections.push_back(m_Proxied->onModMoved(callSignalIfPluginActive(m_OrganizerProxy, m_ModMoved)));
-  m_Connections.push_back(m_Proxied->onModRemoved(callSignalIfPluginActive(m_OrganizerProxy, m_ModRemoved)));
-  m_Connections.push_back(m_Proxied->onModStateChanged(callSignalIfPluginActive(m_OrganizerProxy, m_ModStateChanged)));
+  m_Connections.push_back(m_Proxied->onModInstalled(callTimedSignalIfPluginActive(m_OrganizerProxy, m_ModInstalled, "onModInstalled")));
+  m_Connections.push_back(m_Proxied->onModMoved(callTimedSignalIfPluginActive(m_OrganizerProxy, m_ModMoved, "onModMoved")));
+  m_Connections.push_back(m_Proxied->onModRemoved(callTimedSignalIfPluginActive(m_OrganizerProxy, m_ModRemoved, "onModRemoved")));
+  m_Connections.push_back(m_Proxied->onModStateChanged(callTimedSignalIfPluginActive(m_OrganizerProxy, m_ModStateChanged, "onModStateChanged")));
 }
 
 void ModListProxy::disconnectSignals()
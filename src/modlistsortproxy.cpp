@@ -34,6 +34,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMimeData>
 #include <QDebug>
 #include <QTreeView>
+#include <QTextDocumentFragment>
+#include <algorithm>
 
 using namespace MOBase;
 
@@ -41,6 +43,7 @@ ModListSortProxy::ModListSortProxy(Profile* profile, OrganizerCore * organizer)
   : QSortFilterProxyModel(organizer)
   , m_Organizer(organizer)
   , m_Profile(profile)
+  , m_CandidatesValid(false)
   , m_FilterActive(false)
   , m_FilterMode(FilterAnd)
   , m_FilterSeparators(SeparatorFilter)
@@ -52,6 +55,180 @@ ModListSortProxy::ModListSortProxy(Profile* profile, OrganizerCore * organizer)
 void ModListSortProxy::setProfile(Profile *profile)
 {
   m_Profile = profile;
+  invalidateKeys();
+}
+
+std::uint64_t ModListSortProxy::specialBit(int category)
+{
+  const int i = category - CategoryFactory::Checked;
+  if (i < 0 || i >= 64) {
+    return 0;
+  }
+
+  return std::uint64_t(1) << i;
+}
+
+const ModListSortProxy::ModKeys& ModListSortProxy::keys(
+  unsigned int modIndex, const ModInfo::Ptr& info) const
+{
+  if (modIndex >= m_Keys.size()) {
+    m_Keys.resize(std::max<std::size_t>(modIndex + 1, ModInfo::getNumMods()));
+  }
+
+  auto& k = m_Keys[modIndex];
+
+  // categories may have been edited since
+  if (!k.valid ||
+      k.categoriesRevision != CategoryFactory::instance().revision()) {
+    k = createKeys(info);
+    k.index = modIndex;
+
+    m_Index.set(modIndex, {k.name, k.notes, k.categoryNames});
+    m_CandidatesValid = false;
+  }
+
+  return k;
+}
+
+ModListSortProxy::ModKeys ModListSortProxy::createKeys(const ModInfo::Ptr& info) const
+{
+  ModKeys k;
+
+  k.name = info->name().toLower();
+  k.notes = info->comments().toLower();
+
+  // the notes are html
+  const QString notes = info->notes();
+  if (!notes.isEmpty()) {
+    k.notes += "\n" + QTextDocumentFragment::fromHtml(notes).toPlainText().toLower();
+  }
+
+  for (auto&& c : info->categories()) {
+    k.categoryNames.push_back(c.toLower());
+  }
+
+  k.nexusId = info->nexusId();
+
+  const auto flags = info->getFlags();
+  const auto conflictFlags = info->getConflictFlags();
+
+  auto has = [&](ModInfo::EFlag f) {
+    return std::find(flags.begin(), flags.end(), f) != flags.end();
+  };
+
+  auto set = [&](int category, bool b) {
+    if (b) {
+      k.special |= specialBit(category);
+    }
+  };
+
+  set(CategoryFactory::UpdateAvailable, info->updateAvailable() || info->downgradeAvailable());
+  set(CategoryFactory::HasCategory, !info->getCategories().empty());
+  set(CategoryFactory::Conflict, hasConflictFlag(conflictFlags));
+  set(CategoryFactory::HasHiddenFiles, has(ModInfo::FLAG_HIDDEN_FILES));
+  set(CategoryFactory::Endorsed, info->endorsedState() == EndorsedState::ENDORSED_TRUE);
+  set(CategoryFactory::Backup, has(ModInfo::FLAG_BACKUP));
+  set(CategoryFactory::Managed, !has(ModInfo::FLAG_FOREIGN));
+  set(CategoryFactory::HasGameData, !has(ModInfo::FLAG_INVALID));
+  set(CategoryFactory::HasNexusID, k.nexusId > 0);
+  set(CategoryFactory::Tracked, info->trackedState() == TrackedState::TRACKED_TRUE);
+
+  k.neverHasNexusID =
+    has(ModInfo::FLAG_FOREIGN) ||
+    has(ModInfo::FLAG_BACKUP) ||
+    has(ModInfo::FLAG_OVERWRITE);
+
+  k.alwaysEnabled = info->alwaysEnabled();
+  k.contents = info->getContents();
+
+  const auto& factory = CategoryFactory::instance();
+  k.categories = factory.withParents(info->getCategories());
+  k.categoriesRevision = factory.revision();
+
+  k.flagCount = flags.size();
+  k.flags = flagsId(flags);
+  k.conflictFlagCount = conflictFlags.size();
+  k.conflictFlags = conflictFlagsId(conflictFlags);
+
+  m_Organizer->modDataContents().forEachContentIn(k.contents, [&k](auto const& content) {
+    k.contentsValue += 2U << static_cast<unsigned int>(content.id());
+  });
+
+  k.primaryCategory = info->primaryCategory();
+  if (k.primaryCategory >= 0) {
+    try {
+      CategoryFactory &categories = CategoryFactory::instance();
+      k.primaryCategoryName = categories.getCategoryName(
+        categories.getCategoryIndex(k.primaryCategory));
+    } catch (const std::exception &e) {
+      log::error("failed to get category name: {}", e.what());
+    }
+  }
+
+  k.isBackup = info->isBackup();
+  k.isOverwrite = info->isOverwrite();
+
+  k.valid = true;
+
+  return k;
+}
+
+void ModListSortProxy::invalidateKeys()
+{
+  m_Keys.clear();
+  m_Index.clear();
+  m_CandidatesValid = false;
+}
+
+void ModListSortProxy::invalidateKeys(int first, int last)
+{
+  first = std::max(first, 0);
+  last = std::min(last, static_cast<int>(m_Keys.size()) - 1);
+
+  for (int i=first; i<=last; ++i) {
+    m_Keys[i].valid = false;
+  }
+
+  // the index is updated when the keys are created again
+  m_CandidatesValid = false;
+}
+
+void ModListSortProxy::updateCandidates() const
+{
+  if (m_CandidatesValid) {
+    return;
+  }
+
+  const unsigned int count = ModInfo::getNumMods();
+  for (unsigned int i=0; i<count; ++i) {
+    keys(i, ModInfo::getByIndex(i));
+  }
+
+  ModSearchIndex::Fields fields = 0;
+
+  if (m_EnabledColumns[ModList::COL_NAME]) {
+    fields |= ModSearchIndex::Name;
+  }
+
+  if (m_EnabledColumns[ModList::COL_NOTES]) {
+    fields |= ModSearchIndex::Notes;
+  }
+
+  if (m_EnabledColumns[ModList::COL_CATEGORY]) {
+    fields |= ModSearchIndex::Categories;
+  }
+
+  m_FilterCandidates.clear();
+
+  for (const auto& ANDKeywords : m_FilterSegments) {
+    auto& candidates = m_FilterCandidates.emplace_back();
+
+    for (const auto& keyword : ANDKeywords) {
+      candidates.push_back(m_Index.candidates(keyword, fields));
+    }
+  }
+
+  m_CandidatesValid = true;
 }
 
 void ModListSortProxy::updateFilterActive()
@@ -69,6 +246,11 @@ void ModListSortProxy::setCriteria(const std::vector<Criteria>& criteria)
     criteria[0].id == CategoryFactory::UpdateAvailable);
 
   if (changed || isForUpdates) {
+    if (isForUpdates) {
+      // update states are not signalled by the mod list
+      invalidateKeys();
+    }
+
     m_Criteria = criteria;
     updateFilterActive();
     invalidateFilter();
@@ -118,68 +300,51 @@ bool ModListSortProxy::lessThan(const QModelIndex &left,
     return false;
   }
 
-  ModInfo::Ptr leftMod = ModInfo::getByIndex(leftIndex);
-  ModInfo::Ptr rightMod = ModInfo::getByIndex(rightIndex);
+  // this is called for every comparison, the mods are read from the snapshot
+  // without copying the pointers
+  const auto& mods = ModInfo::snapshot();
+  const ModInfo::Ptr& leftMod = mods.at(leftIndex);
+  const ModInfo::Ptr& rightMod = mods.at(rightIndex);
+
+  const ModKeys& lk = keys(leftIndex, leftMod);
+  const ModKeys& rk = keys(rightIndex, rightMod);
 
   bool lt = left.data(ModList::PriorityRole).toInt() < right.data(ModList::PriorityRole).toInt();
 
   switch (left.column()) {
     case ModList::COL_FLAGS: {
-      std::vector<ModInfo::EFlag> leftFlags = leftMod->getFlags();
-      std::vector<ModInfo::EFlag> rightFlags = rightMod->getFlags();
-      if (leftFlags.size() != rightFlags.size()) {
-        lt = leftFlags.size() < rightFlags.size();
+      if (lk.flagCount != rk.flagCount) {
+        lt = lk.flagCount < rk.flagCount;
       } else {
-        lt = flagsId(leftFlags) < flagsId(rightFlags);
+        lt = lk.flags < rk.flags;
       }
     } break;
     case ModList::COL_CONFLICTFLAGS: {
-      std::vector<ModInfo::EConflictFlag> leftFlags = leftMod->getConflictFlags();
-      std::vector<ModInfo::EConflictFlag> rightFlags = rightMod->getConflictFlags();
-      if (leftFlags.size() != rightFlags.size()) {
-        lt = leftFlags.size() < rightFlags.size();
+      if (lk.conflictFlagCount != rk.conflictFlagCount) {
+        lt = lk.conflictFlagCount < rk.conflictFlagCount;
       }
       else {
-        lt = conflictFlagsId(leftFlags) < conflictFlagsId(rightFlags);
+        lt = lk.conflictFlags < rk.conflictFlags;
       }
     } break;
     case ModList::COL_CONTENT: {
-      const auto& lContents = leftMod->getContents();
-      const auto& rContents = rightMod->getContents();
-      unsigned int lValue = 0;
-      unsigned int rValue = 0;
-      m_Organizer->modDataContents().forEachContentIn(lContents, [&lValue](auto const& content) {
-        lValue += 2U << static_cast<unsigned int>(content.id());
-      });
-      m_Organizer->modDataContents().forEachContentIn(rContents, [&rValue](auto const& content) {
-        rValue += 2U << static_cast<unsigned int>(content.id());
-      });
-      lt = lValue < rValue;
+      lt = lk.contentsValue < rk.contentsValue;
     } break;
     case ModList::COL_NAME: {
-      int comp = QString::compare(leftMod->name(), rightMod->name(), Qt::CaseInsensitive);
+      int comp = lk.name.compare(rk.name);
       if (comp != 0)
         lt = comp < 0;
     } break;
     case ModList::COL_CATEGORY: {
-      if (leftMod->primaryCategory() != rightMod->primaryCategory()) {
-        if (leftMod->primaryCategory() < 0) lt = false;
-        else if (rightMod->primaryCategory() < 0) lt = true;
-        else {
-          try {
-            CategoryFactory &categories = CategoryFactory::instance();
-            QString leftCatName = categories.getCategoryName(categories.getCategoryIndex(leftMod->primaryCategory()));
-            QString rightCatName = categories.getCategoryName(categories.getCategoryIndex(rightMod->primaryCategory()));
-            lt = leftCatName < rightCatName;
-          } catch (const std::exception &e) {
-            log::error("failed to compare categories: {}", e.what());
-          }
-        }
+      if (lk.primaryCategory != rk.primaryCategory) {
+        if (lk.primaryCategory < 0) lt = false;
+        else if (rk.primaryCategory < 0) lt = true;
+        else lt = lk.primaryCategoryName < rk.primaryCategoryName;
       }
     } break;
     case ModList::COL_MODID: {
-      if (leftMod->nexusId() != rightMod->nexusId())
-        lt = leftMod->nexusId() < rightMod->nexusId();
+      if (lk.nexusId != rk.nexusId)
+        lt = lk.nexusId < rk.nexusId;
     } break;
     case ModList::COL_VERSION: {
       if (leftMod->version() != rightMod->version())
@@ -196,7 +361,7 @@ bool ModListSortProxy::lessThan(const QModelIndex &left,
         lt = leftMod->gameName() < rightMod->gameName();
       }
       else {
-        int comp = QString::compare(leftMod->name(), rightMod->name(), Qt::CaseInsensitive);
+        int comp = lk.name.compare(rk.name);
         if (comp != 0)
           lt = comp < 0;
        }
@@ -215,11 +380,11 @@ bool ModListSortProxy::lessThan(const QModelIndex &left,
       }
     } break;
     case ModList::COL_PRIORITY: {
-      if (leftMod->isBackup() != rightMod->isBackup()) {
-        lt = leftMod->isBackup();
+      if (lk.isBackup != rk.isBackup) {
+        lt = lk.isBackup;
       }
-      else if (leftMod->isOverwrite() != rightMod->isOverwrite()) {
-        lt = rightMod->isOverwrite();
+      else if (lk.isOverwrite != rk.isOverwrite) {
+        lt = rk.isOverwrite;
       }
     } break;
     default: {
@@ -232,6 +397,21 @@ bool ModListSortProxy::lessThan(const QModelIndex &left,
 void ModListSortProxy::updateFilter(const QString& filter)
 {
   m_Filter = filter;
+
+  m_FilterSegments.clear();
+
+  QString filterCopy = filter;
+  filterCopy.replace("||", ";").replace("OR", ";").replace("|", ";");
+
+  //split in ORSegments that internally use AND logic, the keywords are
+  //lowercased once here instead of comparing case-insensitively for each mod
+  for (auto& ORSegment : filterCopy.split(";", QString::SkipEmptyParts)) {
+    m_FilterSegments.push_back(
+      ORSegment.toLower().split(" ", QString::SkipEmptyParts));
+  }
+
+  m_CandidatesValid = false;
+
   updateFilterActive();
   invalidateFilter();
   emit filterInvalidated();
@@ -256,10 +436,11 @@ bool ModListSortProxy::hasConflictFlag(const std::vector<ModInfo::EConflictFlag>
   return false;
 }
 
-bool ModListSortProxy::filterMatchesModAnd(ModInfo::Ptr info, bool enabled) const
+bool ModListSortProxy::filterMatchesModAnd(
+  const ModInfo::Ptr& info, const ModKeys& k, bool enabled) const
 {
   for (auto&& c : m_Criteria) {
-    if (!criteriaMatchMod(info, enabled, c)) {
+    if (!criteriaMatchMod(info, k, enabled, c)) {
       return false;
     }
   }
@@ -267,10 +448,11 @@ bool ModListSortProxy::filterMatchesModAnd(ModInfo::Ptr info, bool enabled) cons
   return true;
 }
 
-bool ModListSortProxy::filterMatchesModOr(ModInfo::Ptr info, bool enabled) const
+bool ModListSortProxy::filterMatchesModOr(
+  const ModInfo::Ptr& info, const ModKeys& k, bool enabled) const
 {
   for (auto&& c : m_Criteria) {
-    if (criteriaMatchMod(info, enabled, c)) {
+    if (criteriaMatchMod(info, k, enabled, c)) {
       return true;
     }
   }
@@ -283,13 +465,13 @@ bool ModListSortProxy::filterMatchesModOr(ModInfo::Ptr info, bool enabled) const
   return true;
 }
 
-bool ModListSortProxy::optionsMatchMod(ModInfo::Ptr info, bool) const
+bool ModListSortProxy::optionsMatchMod(const ModInfo::Ptr& info, bool) const
 {
   return true;
 }
 
 bool ModListSortProxy::criteriaMatchMod(
-  ModInfo::Ptr info, bool enabled, const Criteria& c) const
+  const ModInfo::Ptr& info, const ModKeys& k, bool enabled, const Criteria& c) const
 {
   bool b = false;
 
@@ -298,13 +480,13 @@ bool ModListSortProxy::criteriaMatchMod(
     case TypeSpecial:  // fall-through
     case TypeCategory:
     {
-      b = categoryMatchesMod(info, enabled, c.id);
+      b = categoryMatchesMod(info, k, enabled, c.id);
       break;
     }
 
     case TypeContent:
     {
-      b = contentMatchesMod(info, enabled, c.id);
+      b = (k.contents.count(c.id) > 0);
       break;
     }
 
@@ -323,103 +505,136 @@ bool ModListSortProxy::criteriaMatchMod(
 }
 
 bool ModListSortProxy::categoryMatchesMod(
-  ModInfo::Ptr info, bool enabled, int category) const
+  const ModInfo::Ptr& info, const ModKeys& k, bool enabled, int category) const
 {
-  bool b = false;
-
   switch (category)
   {
     case CategoryFactory::Checked:
     {
-      b = (enabled || info->alwaysEnabled());
-      break;
+      return (enabled || k.alwaysEnabled);
     }
 
-    case CategoryFactory::UpdateAvailable:
+    case CategoryFactory::HasNexusID:
     {
-      b = (info->updateAvailable() || info->downgradeAvailable());
-      break;
-    }
+      // never show these
+      if (k.neverHasNexusID) {
+        return false;
+      }
 
-    case CategoryFactory::HasCategory:
-    {
-      b = !info->getCategories().empty();
       break;
     }
+  }
 
-    case CategoryFactory::Conflict:
-    {
-      b = (hasConflictFlag(info->getConflictFlags()));
-      break;
-    }
+  if (const auto bit = specialBit(category)) {
+    return ((k.special & bit) != 0);
+  }
 
-    case CategoryFactory::HasHiddenFiles:
-    {
-      b = (info->hasFlag(ModInfo::FLAG_HIDDEN_FILES));
-      break;
-    }
+  return std::binary_search(k.categories.begin(), k.categories.end(), category);
+}
 
-    case CategoryFactory::Endorsed:
-    {
-      b = (info->endorsedState() == EndorsedState::ENDORSED_TRUE);
-      break;
-    }
+bool ModListSortProxy::textMatchesMod(const ModKeys& k) const
+{
+  if (k.index != UINT_MAX) {
+    updateCandidates();
+  }
 
-    case CategoryFactory::Backup:
-    {
-      b = (info->hasFlag(ModInfo::FLAG_BACKUP));
-      break;
-    }
+  //split in ORSegments that internally use AND logic
+  for (std::size_t s=0; s<m_FilterSegments.size(); ++s) {
+    const auto& ANDKeywords = m_FilterSegments[s];
+    bool segmentGood = true;
 
-    case CategoryFactory::Managed:
-    {
-      b = (!info->hasFlag(ModInfo::FLAG_FOREIGN));
-      break;
-    }
+    //check each word in the segment for match, each word needs to be matched but it doesn't matter where.
+    for (int w=0; w<ANDKeywords.size(); ++w) {
+      const auto& currentKeyword = ANDKeywords[w];
+      bool foundKeyword = false;
 
-    case CategoryFactory::HasGameData:
-    {
-      b = !info->hasFlag(ModInfo::FLAG_INVALID);
-      break;
-    }
+      // mods that are not candidates can't have the keyword in their text,
+      // only in their nexus id
+      bool inText = true;
 
-    case CategoryFactory::HasNexusID:
-    {
-      // never show these
-      if (
-        info->hasFlag(ModInfo::FLAG_FOREIGN) ||
-        info->hasFlag(ModInfo::FLAG_BACKUP) ||
-        info->hasFlag(ModInfo::FLAG_OVERWRITE))
-      {
-        return false;
+      if (k.index != UINT_MAX) {
+        const auto& candidates = m_FilterCandidates[s][w];
+
+        inText = !candidates || std::binary_search(
+          candidates->begin(), candidates->end(), k.index);
       }
 
-      b = (info->nexusId() > 0);
-      break;
-    }
+      //search keyword in name
+      if (inText &&
+        m_EnabledColumns[ModList::COL_NAME] &&
+        k.name.contains(currentKeyword)) {
+        foundKeyword = true;
+      }
 
-    case CategoryFactory::Tracked:
-    {
-      b = (info->trackedState() == TrackedState::TRACKED_TRUE);
-      break;
+      // Search by notes
+      if (!foundKeyword && inText &&
+        m_EnabledColumns[ModList::COL_NOTES] &&
+        k.notes.contains(currentKeyword)) {
+        foundKeyword = true;
+      }
+
+      // Search by categories
+      if (!foundKeyword && inText &&
+        m_EnabledColumns[ModList::COL_CATEGORY]) {
+        for (auto& category : k.categoryNames) {
+          if (category.contains(currentKeyword)) {
+            foundKeyword = true;
+            break;
+          }
+        }
+      }
+
+      // Search by Nexus ID
+      if (!foundKeyword &&
+        m_EnabledColumns[ModList::COL_MODID]) {
+        bool ok;
+        int filterID = currentKeyword.toInt(&ok);
+        if (ok) {
+          int modID = k.nexusId;
+          while (modID > 0) {
+            if (modID == filterID) {
+              foundKeyword = true;
+              break;
+            }
+            modID = (int)(modID / 10);
+          }
+        }
+      }
+
+      if (!foundKeyword) {
+        //currentKeword is missing from everything, AND fails and we need to check next ORsegment
+        segmentGood = false;
+        break;
+      }
     }
 
-    default:
-    {
-      b = (info->categorySet(category));
-      break;
+    if (segmentGood) {
+      //the last AND loop didn't break so the ORSegments is true so mod matches filter
+      return true;
     }
   }
 
-  return b;
+  return false;
 }
 
-bool ModListSortProxy::contentMatchesMod(ModInfo::Ptr info, bool enabled, int content) const
+bool ModListSortProxy::filterMatchesMod(const ModInfo::Ptr& info, bool enabled) const
 {
-  return info->hasContent(content);
+  // don't check if there are no filters selected
+  if (!m_FilterActive) {
+    return true;
+  }
+
+  const unsigned int index = ModInfo::getIndex(info->name());
+  if (index == UINT_MAX) {
+    const ModKeys k = createKeys(info);
+    return filterMatchesMod(info, k, enabled);
+  }
+
+  return filterMatchesMod(info, keys(index, info), enabled);
 }
 
-bool ModListSortProxy::filterMatchesMod(ModInfo::Ptr info, bool enabled) const
+bool ModListSortProxy::filterMatchesMod(
+  const ModInfo::Ptr& info, const ModKeys& k, bool enabled) const
 {
   // don't check if there are no filters selected
   if (!m_FilterActive) {
@@ -452,98 +667,23 @@ bool ModListSortProxy::filterMatchesMod(ModInfo::Ptr info, bool enabled) const
   }
 
 
-  if (!m_Filter.isEmpty()) {
-    bool display = false;
-    QString filterCopy = QString(m_Filter);
-    filterCopy.replace("||", ";").replace("OR", ";").replace("|", ";");
-    QStringList ORList = filterCopy.split(";", QString::SkipEmptyParts);
-
-    bool segmentGood = true;
-
-    //split in ORSegments that internally use AND logic
-    for (auto& ORSegment : ORList) {
-      QStringList ANDKeywords = ORSegment.split(" ", QString::SkipEmptyParts);
-      segmentGood = true;
-      bool foundKeyword = false;
-
-      //check each word in the segment for match, each word needs to be matched but it doesn't matter where.
-      for (auto& currentKeyword : ANDKeywords) {
-        foundKeyword = false;
-
-        //search keyword in name
-        if (m_EnabledColumns[ModList::COL_NAME] &&
-          info->name().contains(currentKeyword, Qt::CaseInsensitive)) {
-          foundKeyword = true;
-        }
-
-        // Search by notes
-        if (!foundKeyword &&
-          m_EnabledColumns[ModList::COL_NOTES] &&
-          info->comments().contains(currentKeyword, Qt::CaseInsensitive)) {
-          foundKeyword = true;
-        }
-
-        // Search by categories
-        if (!foundKeyword &&
-          m_EnabledColumns[ModList::COL_CATEGORY]) {
-          for (auto category : info->categories()) {
-            if (category.contains(currentKeyword, Qt::CaseInsensitive)) {
-              foundKeyword = true;
-              break;
-            }
-          }
-        }
-
-        // Search by Nexus ID
-        if (!foundKeyword &&
-          m_EnabledColumns[ModList::COL_MODID]) {
-          bool ok;
-          int filterID = currentKeyword.toInt(&ok);
-          if (ok) {
-            int modID = info->nexusId();
-            while (modID > 0) {
-              if (modID == filterID) {
-                foundKeyword = true;
-                break;
-              }
-              modID = (int)(modID / 10);
-            }
-          }
-        }
-
-        if (!foundKeyword) {
-          //currentKeword is missing from everything, AND fails and we need to check next ORsegment
-          segmentGood = false;
-          break;
-        }
-
-      }//for ANDKeywords loop
-
-      if (segmentGood) {
-        //the last AND loop didn't break so the ORSegments is true so mod matches filter
-        display = true;
-        break;
-      }
-
-    }//for ORList loop
-
-    if (!display) {
-      return false;
-    }
-  }//if (!m_CurrentFilter.isEmpty())
+  if (!m_Filter.isEmpty() && !textMatchesMod(k)) {
+    return false;
+  }
 
 
   if (m_FilterMode == FilterAnd) {
-    return filterMatchesModAnd(info, enabled);
+    return filterMatchesModAnd(info, k, enabled);
   }
   else {
-    return filterMatchesModOr(info, enabled);
+    return filterMatchesModOr(info, k, enabled);
   }
 }
 
 void ModListSortProxy::setColumnVisible(int column, bool visible)
 {
   m_EnabledColumns[column] = visible;
+  m_CandidatesValid = false;
 }
 
 void ModListSortProxy::setOptions(
@@ -585,8 +725,11 @@ bool ModListSortProxy::filterAcceptsRow(int source_row, const QModelIndex &paren
 
   if (sourceModel()->hasChildren(idx)) {
     // we need to check the separator itself first
-    if (index < ModInfo::getNumMods() && ModInfo::getByIndex(index)->isSeparator()) {
-      if (filterMatchesMod(ModInfo::getByIndex(index), false)) {
+    const auto& mods = ModInfo::snapshot();
+
+    if (index < mods.size() && mods.at(index)->isSeparator()) {
+      const auto& info = mods.at(index);
+      if (filterMatchesMod(info, keys(index, info), false)) {
         return true;
       }
     }
@@ -599,7 +742,14 @@ bool ModListSortProxy::filterAcceptsRow(int source_row, const QModelIndex &paren
     return false;
   } else {
     bool modEnabled = idx.sibling(source_row, 0).data(Qt::CheckStateRole).toInt() == Qt::Checked;
-    return filterMatchesMod(ModInfo::getByIndex(index), modEnabled);
+    const auto& mods = ModInfo::snapshot();
+    const auto& info = mods.at(index);
+
+    if (index >= mods.size()) {
+      return filterMatchesMod(info, modEnabled);
+    }
+
+    return filterMatchesMod(info, keys(index, info), modEnabled);
   }
 }
 
@@ -673,7 +823,33 @@ void ModListSortProxy::setSourceModel(QAbstractItemModel *sourceModel)
   if (sourceModel) {
     connect(sourceModel, SIGNAL(aboutToChangeData()), this, SLOT(aboutToChangeData()), Qt::UniqueConnection);
     connect(sourceModel, SIGNAL(postDataChanged()), this, SLOT(postDataChanged()), Qt::UniqueConnection);
+
+    // rows of the mod list are mod indexes, which is what the keys are
+    // indexed by
+    connect(sourceModel, &QAbstractItemModel::dataChanged, this, &ModListSortProxy::onModsChanged, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &ModListSortProxy::onModsReset, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::modelReset, this, &ModListSortProxy::onModsReset, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &ModListSortProxy::onModsReset, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &ModListSortProxy::onModsReset, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::rowsMoved, this, &ModListSortProxy::onModsReset, Qt::UniqueConnection);
+  }
+
+  invalidateKeys();
+}
+
+void ModListSortProxy::onModsChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+  if (!topLeft.isValid() || !bottomRight.isValid() || topLeft.parent().isValid()) {
+    invalidateKeys();
+    return;
   }
+
+  invalidateKeys(topLeft.row(), bottomRight.row());
+}
+
+void ModListSortProxy::onModsReset()
+{
+  invalidateKeys();
 }
 
 void ModListSortProxy::aboutToChangeData()
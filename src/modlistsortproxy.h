@@ -22,7 +22,13 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QSortFilterProxyModel>
 #include <bitset>
+#include <climits>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <vector>
 #include "modlist.h"
+#include "modsearchindex.h"
 
 class Profile;
 class OrganizerCore;
@@ -88,7 +94,7 @@ public:
    * @param enabled true if the mod is currently active
    * @return true if current active filters match for the specified mod
    */
-  bool filterMatchesMod(ModInfo::Ptr info, bool enabled) const;
+  bool filterMatchesMod(const ModInfo::Ptr& info, bool enabled) const;
 
   /**
    * @return true if a filter is currently active
@@ -133,12 +139,82 @@ protected:
 
 private:
 
+  // everything the filter and sorting need from a mod, computed once and
+  // reused until the row changes in the mod list
+  //
+  struct ModKeys
+  {
+    bool valid = false;
+
+    // index of the mod, UINT_MAX for mods that are not in m_Keys
+    unsigned int index = UINT_MAX;
+
+    // case-folded text searched by the filter box; notes are the comments
+    // followed by the plain text of the notes
+    QString name;
+    QString notes;
+    QStringList categoryNames;
+    int nexusId = 0;
+
+    // one bit per special category the mod is in, see specialBit(); Checked
+    // depends on the profile and is never set
+    std::uint64_t special = 0;
+
+    // whether the mod is never shown by the HasNexusID criteria, regardless
+    // of inverse
+    bool neverHasNexusID = false;
+
+    bool alwaysEnabled = false;
+    std::set<int> contents;
+
+    // categories of the mod and all their parents, sorted, so a category
+    // criteria is a binary search instead of walking the parents of every
+    // category of the mod; see CategoryFactory::withParents()
+    std::vector<int> categories;
+    int categoriesRevision = -1;
+
+    // sort keys
+    std::size_t flagCount = 0;
+    unsigned long flags = 0;
+    std::size_t conflictFlagCount = 0;
+    unsigned long conflictFlags = 0;
+    unsigned int contentsValue = 0;
+    int primaryCategory = -1;
+    QString primaryCategoryName;
+    bool isBackup = false;
+    bool isOverwrite = false;
+  };
+
+  // keys for the given mod, computed if they're not valid
+  //
+  const ModKeys& keys(unsigned int modIndex, const ModInfo::Ptr& info) const;
+  ModKeys createKeys(const ModInfo::Ptr& info) const;
+
+  // forgets the keys of the given mods, or all of them
+  //
+  void invalidateKeys();
+  void invalidateKeys(int first, int last);
+
+  // makes sure every mod is in the search index and looks up the keywords of
+  // the filter in it, if anything changed since the last time
+  //
+  void updateCandidates() const;
+
+  // bit for the given special category in ModKeys::special, 0 if the
+  // category is not a special one
+  //
+  static std::uint64_t specialBit(int category);
+
+  bool categoryMatchesMod(const ModInfo::Ptr& info, const ModKeys& k, bool enabled, int category) const;
+  bool textMatchesMod(const ModKeys& k) const;
+
   unsigned long flagsId(const std::vector<ModInfo::EFlag> &flags) const;
   unsigned long conflictFlagsId(const std::vector<ModInfo::EConflictFlag>& flags) const;
   bool hasConflictFlag(const std::vector<ModInfo::EConflictFlag> &flags) const;
   void updateFilterActive();
-  bool filterMatchesModAnd(ModInfo::Ptr info, bool enabled) const;
-  bool filterMatchesModOr(ModInfo::Ptr info, bool enabled) const;
+  bool filterMatchesMod(const ModInfo::Ptr& info, const ModKeys& k, bool enabled) const;
+  bool filterMatchesModAnd(const ModInfo::Ptr& info, const ModKeys& k, bool enabled) const;
+  bool filterMatchesModOr(const ModInfo::Ptr& info, const ModKeys& k, bool enabled) const;
 
   // check if the source model is the by-priority proxy
   //
@@ -149,12 +225,33 @@ private slots:
   void aboutToChangeData();
   void postDataChanged();
 
+  // forget the keys of mods that changed in the mod list
+  //
+  void onModsChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+  void onModsReset();
+
 private:
   OrganizerCore* m_Organizer;
 
   Profile* m_Profile;
   std::vector<Criteria> m_Criteria;
   QString m_Filter;
+
+  // m_Filter split in segments that are or'ed together, each with keywords
+  // that are and'ed; case-folded
+  std::vector<QStringList> m_FilterSegments;
+
+  mutable std::vector<ModKeys> m_Keys;
+
+  // text of the mods in m_Keys, updated with the keys
+  mutable ModSearchIndex m_Index;
+
+  // for each keyword of m_FilterSegments, the mods that can contain it in the
+  // searched columns, sorted; nothing for keywords that can't be looked up,
+  // which are searched in every mod
+  mutable std::vector<std::vector<std::optional<std::vector<unsigned int>>>> m_FilterCandidates;
+  mutable bool m_CandidatesValid;
+
   std::bitset<ModList::COL_LASTCOLUMN + 1> m_EnabledColumns;
 
   bool m_FilterActive;
@@ -163,10 +260,8 @@ private:
 
   std::vector<Criteria> m_PreChangeCriteria;
 
-  bool optionsMatchMod(ModInfo::Ptr info, bool enabled) const;
-  bool criteriaMatchMod(ModInfo::Ptr info, bool enabled, const Criteria& c) const;
-  bool categoryMatchesMod(ModInfo::Ptr info, bool enabled, int category) const;
-  bool contentMatchesMod(ModInfo::Ptr info, bool enabled, int content) const;
+  bool optionsMatchMod(const ModInfo::Ptr& info, bool enabled) const;
+  bool criteriaMatchMod(const ModInfo::Ptr& info, const ModKeys& k, bool enabled, const Criteria& c) const;
 };
 
 #endif // MODLISTSORTPROXY_H
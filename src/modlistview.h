@@ -1,7 +1,9 @@
 #ifndef MODLISTVIEW_H
 #define MODLISTVIEW_H
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -305,6 +307,12 @@ private: // private functions
   //
   void updateGroupByProxy();
 
+  // queues the lazy data of the mods in and around the viewport on the
+  // background executor, the rows are refreshed as their data is ready so
+  // painting doesn't have to read the disk
+  //
+  void prefetchVisibleMods();
+
 public: // member variables
 
   OrganizerCore* m_core;
@@ -335,6 +343,13 @@ public: // member variables
   // auto-collapsing
   QBasicTimer m_openTimer;
 
+  // starts prefetchVisibleMods() once scrolling or filtering settles
+  QTimer m_prefetchTimer;
+
+  // incremented every time rows are queued for prefetching, tasks queued
+  // for an older generation are skipped since their rows are likely gone
+  std::shared_ptr<std::atomic<int>> m_prefetchGeneration;
+
 };
 
 #endif // MODLISTVIEW_H
@@ -4,7 +4,11 @@
 #include <QGroupBox>
 #include <QInputDialog>
 #include <QLabel>
+#include <QMessageBox>
+#include <QProgressDialog>
 #include <QRegExp>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <log.h>
 #include <report.h>
@@ -293,6 +297,137 @@ void ModListViewActions::checkModsForUpdates(const QModelIndexList& indices) con
   checkModsForUpdates(ids);
 }
 
+void ModListViewActions::verifyMods() const
+{
+  std::vector<ModIntegrity::Mod> mods;
+
+  for (unsigned int i = 0; i < ModInfo::getNumMods(); ++i) {
+    auto info = ModInfo::getByIndex(i);
+    if (info->isRegular() && !info->isBackup()) {
+      mods.push_back({info->name(), info->absolutePath()});
+    }
+  }
+
+  verifyMods(mods);
+}
+
+void ModListViewActions::verifyMods(const QModelIndexList& indices) const
+{
+  std::vector<ModIntegrity::Mod> mods;
+
+  for (auto& idx : indices) {
+    auto info = ModInfo::getByIndex(idx.data(ModList::IndexRole).toInt());
+    if (info->isRegular() && !info->isBackup()) {
+      mods.push_back({info->name(), info->absolutePath()});
+    }
+  }
+
+  verifyMods(mods);
+}
+
+void ModListViewActions::verifyMods(const std::vector<ModIntegrity::Mod>& mods) const
+{
+  if (mods.empty()) {
+    return;
+  }
+
+  std::atomic<bool> cancel = false;
+  std::atomic<int> percent = 0;
+
+  QProgressDialog progress(tr("Verifying mods..."), tr("Cancel"), 0, 100, m_parent);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(500);
+  progress.setAutoReset(false);
+
+  // the dialog is updated from here, the progress comes from the executor
+  QTimer timer;
+  connect(&timer, &QTimer::timeout, [&] { progress.setValue(percent); });
+  connect(&progress, &QProgressDialog::canceled, [&] { cancel = true; });
+  timer.start(100);
+
+  QEventLoop loop;
+  QFutureWatcher<std::vector<ModIntegrity::Result>> watcher;
+  connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+
+  watcher.setFuture(QtConcurrent::run([&] {
+    return ModIntegrity::verify(mods, cancel, [&](auto done, auto total) {
+      percent = static_cast<int>(total > 0 ? 100 * done / total : 100);
+    });
+  }));
+
+  if (!watcher.isFinished()) {
+    loop.exec();
+  }
+
+  timer.stop();
+  progress.reset();
+
+  if (cancel) {
+    return;
+  }
+
+  const auto results = watcher.result();
+
+  int ok = 0, noManifest = 0, broken = 0;
+  QString details;
+
+  for (const auto& r : results) {
+    if (!r.hasManifest) {
+      ++noManifest;
+      continue;
+    }
+
+    if (r.ok()) {
+      ++ok;
+    } else {
+      ++broken;
+    }
+
+    if (r.ok() && r.added.isEmpty()) {
+      continue;
+    }
+
+    details += r.mod + "\n";
+
+    for (const auto& f : r.missing) {
+      details += "  " + tr("missing: %1").arg(f) + "\n";
+    }
+
+    for (const auto& f : r.changed) {
+      details += "  " + tr("changed: %1").arg(f) + "\n";
+    }
+
+    for (const auto& f : r.added) {
+      details += "  " + tr("not installed: %1").arg(f) + "\n";
+    }
+  }
+
+  QString text;
+  if (broken == 0) {
+    text = tr("The files of %n mod(s) match what was installed.", "", ok);
+  } else {
+    text = tr("%n mod(s) have missing or changed files.", "", broken);
+  }
+
+  QString info;
+  if (noManifest > 0) {
+    info = tr(
+      "%n mod(s) were installed before their files were recorded and can't "
+      "be verified.", "", noManifest);
+  }
+
+  QMessageBox dlg(m_parent);
+
+  dlg.setWindowTitle(tr("Verify mods"));
+  dlg.setText(text);
+  dlg.setInformativeText(info);
+  dlg.setDetailedText(details);
+  dlg.setIcon(broken == 0 ? QMessageBox::Information : QMessageBox::Warning);
+  dlg.setStandardButtons(QMessageBox::Ok);
+
+  dlg.exec();
+}
+
 void ModListViewActions::exportModListCSV() const
 {
   QDialog selection(m_parent);
@@ -413,9 +548,9 @@ void ModListViewActions::exportModListCSV() const
         else if ((selectedRowID == 2) && !m_view->isModVisible(iter.second)) {
           continue;
         }
-        std::vector<ModInfo::EFlag> flags = info->getFlags();
-        if ((std::find(flags.begin(), flags.end(), ModInfo::FLAG_OVERWRITE) == flags.end()) &&
-          (std::find(flags.begin(), flags.end(), ModInfo::FLAG_BACKUP) == flags.end())) {
+        // getFlags() would compute all the flags of the mod, including
+        // conflicts, for each row
+        if (!info->isOverwrite() && !info->isBackup()) {
           if (mod_Priority->isChecked())
             builder.setRowField("#Mod_Priority", QString("%1").arg(iter.first, 4, 10, QChar('0')));
           if (mod_Status->isChecked())
@@ -441,6 +576,8 @@ void ModListViewActions::exportModListCSV() const
         }
       }
 
+      builder.flush();
+
       SaveTextAsDialog saveDialog(m_parent);
       saveDialog.setText(buffer.data());
       saveDialog.exec();
@@ -480,7 +617,7 @@ void ModListViewActions::displayModInformation(ModInfo::Ptr modInfo, unsigned in
     QDialog* dialog = m_parent->findChild<QDialog*>("__overwriteDialog");
     try {
       if (dialog == nullptr) {
-        dialog = new OverwriteInfoDialog(modInfo, m_parent);
+        dialog = new OverwriteInfoDialog(modInfo, m_core, m_parent);
         dialog->setObjectName("__overwriteDialog");
       }
       else {
@@ -524,6 +661,10 @@ void ModListViewActions::displayModInformation(ModInfo::Ptr modInfo, unsigned in
 
   if (m_core.currentProfile()->modEnabled(modIndex) && !modInfo->isForeign()) {
     FilesOrigin& origin = m_core.directoryStructure()->getOriginByName(ToWString(modInfo->name()));
+    auto& conflicts = m_core.directoryStructure()->getFileRegister()->conflicts();
+
+    // the dialog may have renamed or hidden files, the mod is added again
+    conflicts.exclude({origin.getID()});
     origin.enable(false);
 
     if (m_core.directoryStructure()->originExists(ToWString(modInfo->name()))) {
@@ -538,6 +679,7 @@ void ModListViewActions::displayModInformation(ModInfo::Ptr modInfo, unsigned in
         , modInfo->archives());
       DirectoryRefresher::cleanStructure(m_core.directoryStructure());
       m_core.directoryStructure()->getFileRegister()->sortOrigins();
+      conflicts.include({origin.getID()});
       m_core.refreshLists();
     }
   }
@@ -699,8 +841,12 @@ void ModListViewActions::removeMods(const QModelIndexList& indices) const
         QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes) {
         // use mod names instead of indexes because those become invalid during the removal
         DownloadManager::startDisableDirWatcher();
-        for (QString name : modNames) {
-          m_core.modList()->removeRowForce(ModInfo::getIndex(name), QModelIndex());
+        {
+          ModList::NotificationBatch batch(*m_core.modList());
+
+          for (QString name : modNames) {
+            m_core.modList()->removeRowForce(ModInfo::getIndex(name), QModelIndex());
+          }
         }
         DownloadManager::endDisableDirWatcher();
       }
@@ -722,7 +868,10 @@ void ModListViewActions::ignoreMissingData(const QModelIndexList& indices) const
     int row_idx = idx.data(ModList::IndexRole).toInt();
     ModInfo::Ptr info = ModInfo::getByIndex(row_idx);
     info->markValidated(true);
-    m_core.modList()->notifyChange(row_idx);
+
+    // invalid mods are greyed out and flagged
+    m_core.modList()->notifyChange(
+      row_idx, row_idx, {ModList::COL_NAME, ModList::COL_FLAGS});
   }
 }
 
@@ -732,7 +881,7 @@ void ModListViewActions::setIgnoreUpdate(const QModelIndexList& indices, bool ig
     int modIdx = idx.data(ModList::IndexRole).toInt();
     ModInfo::Ptr info = ModInfo::getByIndex(modIdx);
     info->ignoreUpdate(ignore);
-    m_core.modList()->notifyChange(modIdx);
+    m_core.modList()->notifyChange(modIdx, modIdx, {ModList::COL_VERSION});
   }
 }
 
@@ -771,7 +920,7 @@ void ModListViewActions::markConverted(const QModelIndexList& indices) const
     int modIdx = idx.data(ModList::IndexRole).toInt();
     ModInfo::Ptr info = ModInfo::getByIndex(modIdx);
     info->markConverted(true);
-    m_core.modList()->notifyChange(modIdx);
+    m_core.modList()->notifyChange(modIdx, modIdx, {ModList::COL_FLAGS});
   }
 }
 
@@ -1081,7 +1230,8 @@ void ModListViewActions::setCategories(const QModelIndexList& selected, const QM
   }
 
   for (auto& idx : selected) {
-    m_core.modList()->notifyChange(idx.data(ModList::IndexRole).toInt());
+    const int row = idx.data(ModList::IndexRole).toInt();
+    m_core.modList()->notifyChange(row, row, {ModList::COL_CATEGORY});
   }
 
   // reset the selection manually - still needed
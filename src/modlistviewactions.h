@@ -6,6 +6,7 @@
 
 #include "modinfo.h"
 #include "modinfodialogfwd.h"
+#include "modintegrity.h"
 
 class CategoryFactory;
 class FilterList;
@@ -61,6 +62,12 @@ public:
   //
   void exportModListCSV() const;
 
+  // check whether the files of all the mods or the given mods still match
+  // what was installed, see ModIntegrity
+  //
+  void verifyMods() const;
+  void verifyMods(const QModelIndexList& indices) const;
+
   // display mod information
   //
   void displayModInformation(const QString& modName, ModInfoTabIDs tabID = ModInfoTabIDs::None) const;
@@ -162,6 +169,10 @@ private:
   //
   void checkModsForUpdates(std::multimap<QString, int> const& IDs) const;
 
+  // verifies the given mods with a progress dialog and shows the results
+  //
+  void verifyMods(const std::vector<ModIntegrity::Mod>& mods) const;
+
 private:
 
   OrganizerCore& m_core;
@@ -0,0 +1,152 @@
+#include "modsearchindex.h"
+#include <algorithm>
+
+template <class F>
+void ModSearchIndex::forEachTrigram(const QString& s, F&& f)
+{
+  for (int i=0; i + MinimumLength <= s.size(); ++i) {
+    f((Trigram(s[i].unicode()) << 32) |
+      (Trigram(s[i + 1].unicode()) << 16) |
+      Trigram(s[i + 2].unicode()));
+  }
+}
+
+void ModSearchIndex::set(unsigned int mod, const Texts& texts)
+{
+  remove(mod);
+
+  // fields of every trigram in the mod
+  std::unordered_map<Trigram, Fields> fields;
+
+  auto add = [&](const QString& s, Field field) {
+    forEachTrigram(s, [&](Trigram t) {
+      fields[t] |= field;
+    });
+  };
+
+  add(texts.name, Name);
+  add(texts.notes, Notes);
+
+  for (const auto& c : texts.categories) {
+    add(c, Categories);
+  }
+
+  if (mod >= m_trigrams.size()) {
+    m_trigrams.resize(mod + 1);
+  }
+
+  auto& trigrams = m_trigrams[mod];
+  trigrams.reserve(fields.size());
+
+  for (auto&& [t, f] : fields) {
+    auto& postings = m_postings[t];
+
+    // mods are usually added in order, this is then at the end
+    auto itor = std::lower_bound(
+      postings.begin(), postings.end(), mod,
+      [](auto&& p, unsigned int m) { return p.mod < m; });
+
+    postings.insert(itor, {mod, f});
+    trigrams.push_back(t);
+  }
+}
+
+void ModSearchIndex::remove(unsigned int mod)
+{
+  if (mod >= m_trigrams.size()) {
+    return;
+  }
+
+  for (const Trigram t : m_trigrams[mod]) {
+    auto pitor = m_postings.find(t);
+    if (pitor == m_postings.end()) {
+      continue;
+    }
+
+    auto& postings = pitor->second;
+
+    auto itor = std::lower_bound(
+      postings.begin(), postings.end(), mod,
+      [](auto&& p, unsigned int m) { return p.mod < m; });
+
+    if (itor != postings.end() && itor->mod == mod) {
+      postings.erase(itor);
+    }
+
+    if (postings.empty()) {
+      m_postings.erase(pitor);
+    }
+  }
+
+  m_trigrams[mod].clear();
+}
+
+void ModSearchIndex::clear()
+{
+  m_postings.clear();
+  m_trigrams.clear();
+}
+
+std::optional<std::vector<unsigned int>> ModSearchIndex::candidates(
+  const QString& keyword, Fields fields) const
+{
+  if (keyword.size() < MinimumLength) {
+    return {};
+  }
+
+  // all the posting lists of the keyword, smallest first so the
+  // intersection is small from the start
+  std::vector<const std::vector<Posting>*> lists;
+  bool missing = false;
+
+  forEachTrigram(keyword, [&](Trigram t) {
+    auto itor = m_postings.find(t);
+
+    if (itor == m_postings.end()) {
+      missing = true;
+    } else {
+      lists.push_back(&itor->second);
+    }
+  });
+
+  if (missing) {
+    return std::vector<unsigned int>();
+  }
+
+  std::sort(lists.begin(), lists.end(), [](auto* a, auto* b) {
+    return a->size() < b->size();
+  });
+
+  std::vector<unsigned int> mods;
+
+  for (const auto& p : *lists[0]) {
+    if (p.fields & fields) {
+      mods.push_back(p.mod);
+    }
+  }
+
+  for (std::size_t i=1; i<lists.size() && !mods.empty(); ++i) {
+    std::vector<unsigned int> kept;
+    kept.reserve(mods.size());
+
+    auto itor = lists[i]->begin();
+    const auto end = lists[i]->end();
+
+    for (const unsigned int m : mods) {
+      itor = std::lower_bound(
+        itor, end, m, [](auto&& p, unsigned int id) { return p.mod < id; });
+
+      if (itor == end) {
+        break;
+      }
+
+      if (itor->mod == m && (itor->fields & fields)) {
+        kept.push_back(m);
+      }
+    }
+
+    mods = std::move(kept);
+  }
+
+  return mods;
+}
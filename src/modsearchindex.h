@@ -0,0 +1,83 @@
+#ifndef MODORGANIZER_MODSEARCHINDEX_INCLUDED
+#define MODORGANIZER_MODSEARCHINDEX_INCLUDED
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// an inverted index over the text of the mods that the filter box of the mod
+// list searches, so a search over thousands of mods only looks at the mods
+// that can match instead of running a substring search on all of them
+//
+// the filter matches keywords anywhere in the text, not only at the start of
+// words, so the index is on trigrams: every sequence of three characters of
+// every field maps to the mods that have it; a mod can only contain a keyword
+// if it has all of its trigrams, which gives a few candidates that are then
+// checked for the keyword itself
+//
+// text must already be case-folded; this is not thread-safe
+//
+class ModSearchIndex
+{
+public:
+  // fields a trigram was found in
+  enum Field : std::uint8_t
+  {
+    Name       = 0x01,
+    Notes      = 0x02,
+    Categories = 0x04
+  };
+
+  using Fields = std::uint8_t;
+
+  struct Texts
+  {
+    QString name;
+    QString notes;
+    QStringList categories;
+  };
+
+  // keywords shorter than this have no trigram and can't be looked up
+  static constexpr int MinimumLength = 3;
+
+  // replaces the text of the given mod
+  //
+  void set(unsigned int mod, const Texts& texts);
+
+  // forgets the given mod, or all of them
+  //
+  void remove(unsigned int mod);
+  void clear();
+
+  // mods that may contain the keyword in one of the given fields, sorted;
+  // nothing if the keyword is too short to be looked up, in which case any
+  // mod may contain it
+  //
+  std::optional<std::vector<unsigned int>> candidates(
+    const QString& keyword, Fields fields) const;
+
+private:
+  using Trigram = std::uint64_t;
+
+  struct Posting
+  {
+    unsigned int mod;
+    Fields fields;
+  };
+
+  // mods that have a trigram, sorted by mod
+  std::unordered_map<Trigram, std::vector<Posting>> m_postings;
+
+  // trigrams of each mod, to remove it
+  std::vector<std::vector<Trigram>> m_trigrams;
+
+  // calls f() with every trigram of the given text
+  //
+  template <class F>
+  static void forEachTrigram(const QString& s, F&& f);
+};
+
+#endif // MODORGANIZER_MODSEARCHINDEX_INCLUDED
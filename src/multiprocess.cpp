@@ -73,6 +73,46 @@ void MOMultiProcess::sendMessage(const QString &message)
   socket.waitForDisconnected();
 }
 
+bool MOMultiProcess::forwardEarly(const QString& message)
+{
+  // this is the name QLocalServer uses for its pipe on windows
+  const auto pipe = L"\\\\.\\pipe\\" + QString(s_Key).toStdWString();
+
+  HANDLE h = INVALID_HANDLE_VALUE;
+
+  for (int i=0; i<2; ++i) {
+    h = CreateFileW(
+      pipe.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+      OPEN_EXISTING, 0, nullptr);
+
+    if (h != INVALID_HANDLE_VALUE) {
+      break;
+    }
+
+    // all the instances of the pipe are busy, the server creates another one
+    // when it accepts a connection
+    if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeW(pipe.c_str(), 500)) {
+      return false;
+    }
+  }
+
+  if (h == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  // the data stays in the pipe after the handle is closed until the primary
+  // reads it, see receiveMessage()
+  const QByteArray utf8 = message.toUtf8();
+  DWORD written = 0;
+
+  const BOOL ok = WriteFile(
+    h, utf8.constData(), static_cast<DWORD>(utf8.size()), &written, nullptr);
+
+  CloseHandle(h);
+
+  return (ok && written == static_cast<DWORD>(utf8.size()));
+}
+
 void MOMultiProcess::receiveMessage()
 {
   QLocalSocket *socket = m_Server.nextPendingConnection();
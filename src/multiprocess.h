@@ -44,6 +44,16 @@ public:
    **/
   void sendMessage(const QString &message);
 
+  // sends a message to the primary process without creating the shared
+  // memory or any Qt object, so it can be called before the application is
+  // set up; this writes directly to the pipe of the primary's local server
+  //
+  // returns false if no primary is listening or if the message couldn't be
+  // sent, in which case the normal startup should go on and forward it with
+  // sendMessage(), which reports errors
+  //
+  static bool forwardEarly(const QString& message);
+
 signals:
 
   /**
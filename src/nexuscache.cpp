@@ -0,0 +1,118 @@
+#include "nexuscache.h"
+#include <log.h>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+
+using namespace MOBase;
+
+// "MONC" and the format version, the cache is ignored when either doesn't
+// match
+static const quint32 CacheMagic = 0x4d4f4e43;
+static const quint32 CacheVersion = 1;
+
+static const QString CacheFileName = "nexus.cache";
+
+
+void NexusCache::setDirectory(const QString& directory)
+{
+  m_Path = QDir::fromNativeSeparators(directory) + "/" + CacheFileName;
+  m_Entries.clear();
+  m_Changed = false;
+
+  QFile file(m_Path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_9);
+
+  quint32 magic = 0, version = 0, count = 0;
+  in >> magic >> version >> count;
+
+  if (magic != CacheMagic || version != CacheVersion) {
+    log::debug("ignoring nexus cache {}, wrong version", m_Path);
+    return;
+  }
+
+  for (quint32 i = 0; i < count; ++i) {
+    QString key;
+    Entry e;
+    in >> key >> e.time >> e.value;
+
+    if (in.status() != QDataStream::Ok) {
+      log::warn("nexus cache {} is corrupted, ignoring", m_Path);
+      m_Entries.clear();
+      return;
+    }
+
+    m_Entries.emplace(std::move(key), std::move(e));
+  }
+
+  log::debug("loaded {} cached nexus results", m_Entries.size());
+}
+
+std::optional<QVariant> NexusCache::get(
+  const QString& key, std::optional<std::chrono::seconds> maxAge) const
+{
+  auto itor = m_Entries.find(key);
+  if (itor == m_Entries.end()) {
+    return {};
+  }
+
+  if (maxAge) {
+    const qint64 age = QDateTime::currentMSecsSinceEpoch() - itor->second.time;
+    if (age < 0 || age > std::chrono::milliseconds(*maxAge).count()) {
+      return {};
+    }
+  }
+
+  return itor->second.value;
+}
+
+void NexusCache::set(const QString& key, QVariant value)
+{
+  auto& e = m_Entries[key];
+  e.time = QDateTime::currentMSecsSinceEpoch();
+  e.value = std::move(value);
+  m_Changed = true;
+}
+
+void NexusCache::remove(const QString& key)
+{
+  if (m_Entries.erase(key) > 0) {
+    m_Changed = true;
+  }
+}
+
+void NexusCache::clear()
+{
+  if (!m_Entries.empty()) {
+    m_Entries.clear();
+    m_Changed = true;
+  }
+}
+
+void NexusCache::save()
+{
+  if (!m_Changed || m_Path.isEmpty()) {
+    return;
+  }
+
+  QByteArray content;
+
+  {
+    QDataStream out(&content, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_9);
+
+    out << CacheMagic << CacheVersion << static_cast<quint32>(m_Entries.size());
+    for (const auto& [key, e] : m_Entries) {
+      out << key << e.time << e.value;
+    }
+  }
+
+  m_Writer.write(m_Path, std::move(content));
+  m_Changed = false;
+}
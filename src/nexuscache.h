@@ -0,0 +1,62 @@
+#ifndef MODORGANIZER_NEXUSCACHE_INCLUDED
+#define MODORGANIZER_NEXUSCACHE_INCLUDED
+
+#include "backgroundfilewriter.h"
+#include <QString>
+#include <QVariant>
+#include <chrono>
+#include <map>
+#include <optional>
+
+// parsed results of Nexus API requests, by request key, see
+// NexusInterface::coalesceKey()
+//
+// entries remember when they were stored, callers decide how old is too old;
+// the cache is saved in a binary file in the cache directory and loaded on
+// startup
+//
+class NexusCache
+{
+public:
+  // loads the cache from the given directory, entries that were already
+  // set are forgotten
+  //
+  void setDirectory(const QString& directory);
+
+  // returns the result stored for the given key if it's not older than
+  // `maxAge`; an empty `maxAge` accepts any age
+  //
+  std::optional<QVariant> get(
+    const QString& key, std::optional<std::chrono::seconds> maxAge) const;
+
+  // stores the result for the given key
+  //
+  void set(const QString& key, QVariant value);
+
+  // forgets the result for the given key
+  //
+  void remove(const QString& key);
+
+  // forgets everything
+  //
+  void clear();
+
+  // writes the cache in the background if it changed
+  //
+  void save();
+
+private:
+  struct Entry
+  {
+    // milliseconds since epoch, utc
+    qint64 time = 0;
+    QVariant value;
+  };
+
+  QString m_Path;
+  std::map<QString, Entry> m_Entries;
+  bool m_Changed = false;
+  BackgroundFileWriter m_Writer;
+};
+
+#endif // MODORGANIZER_NEXUSCACHE_INCLUDED
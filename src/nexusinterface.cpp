@@ -18,6 +18,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "nexusinterface.h"
+#include "browsercache.h"
 
 #include "iplugingame.h"
 #include "nxmaccessmanager.h"
@@ -30,10 +31,12 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <moassert.h>
 
 #include <QApplication>
+#include <QCryptographicHash>
 #include <QNetworkCookieJar>
 #include <QJsonDocument>
 #include <QRegularExpression>
 
+#include <algorithm>
 #include <regex>
 
 
@@ -239,7 +242,7 @@ APILimits NexusInterface::parseLimits(
 static NexusInterface* g_instance = nullptr;
 
 NexusInterface::NexusInterface(Settings* s)
-  : m_PluginContainer(nullptr)
+  : m_PluginContainer(nullptr), m_Settings(s)
 {
   MO_ASSERT(!g_instance);
   g_instance = this;
@@ -252,11 +255,18 @@ NexusInterface::NexusInterface(Settings* s)
 
   m_DiskCache = new QNetworkDiskCache(this);
 
+  // results are saved a bit after they come in so a burst of requests only
+  // writes the file once
+  m_CacheSaveTimer.setSingleShot(true);
+  m_CacheSaveTimer.setInterval(10 * 1000);
+  connect(&m_CacheSaveTimer, &QTimer::timeout, [&]{ m_Cache.save(); });
+
   connect(m_AccessManager, SIGNAL(requestNXMDownload(QString)), this, SLOT(downloadRequestedNXM(QString)));
 }
 
 NexusInterface::~NexusInterface()
 {
+  m_Cache.save();
   cleanup();
 
   MO_ASSERT(g_instance == this);
@@ -278,6 +288,8 @@ void NexusInterface::setCacheDirectory(const QString &directory)
 {
   m_DiskCache->setCacheDirectory(directory);
   m_AccessManager->setCache(m_DiskCache);
+  m_Cache.setDirectory(directory);
+  BrowserCache::setDirectory(directory);
 }
 
 void NexusInterface::loginCompleted()
@@ -429,7 +441,7 @@ int NexusInterface::requestDescription(QString gameName, int modID, QObject *rec
                                        const QString &subModule, MOBase::IPluginGame const *game)
 {
   NXMRequestInfo requestInfo(modID, NXMRequestInfo::TYPE_DESCRIPTION, userData, subModule, game);
-  m_RequestQueue.enqueue(requestInfo);
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmDescriptionAvailable(QString, int, QVariant, QVariant, int)),
     receiver, SLOT(nxmDescriptionAvailable(QString, int, QVariant, QVariant, int)), Qt::UniqueConnection);
@@ -450,7 +462,8 @@ int NexusInterface::requestModInfo(QString gameName, int modID, QObject *receive
   }
 
   NXMRequestInfo requestInfo(modID, NXMRequestInfo::TYPE_MODINFO, userData, subModule, game);
-  m_RequestQueue.enqueue(requestInfo);
+  requestInfo.m_Priority = NXMRequestInfo::PRIORITY_BULK;
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmModInfoAvailable(QString, int, QVariant, QVariant, int)),
     receiver, SLOT(nxmModInfoAvailable(QString, int, QVariant, QVariant, int)), Qt::UniqueConnection);
@@ -471,7 +484,8 @@ int NexusInterface::requestUpdateInfo(QString gameName, NexusInterface::UpdatePe
   }
 
   NXMRequestInfo requestInfo(period, NXMRequestInfo::TYPE_CHECKUPDATES, userData, subModule, game);
-  m_RequestQueue.enqueue(requestInfo);
+  requestInfo.m_Priority = NXMRequestInfo::PRIORITY_BULK;
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmUpdateInfoAvailable(QString, QVariant, QVariant, int)),
     receiver, SLOT(nxmUpdateInfoAvailable(QString, QVariant, QVariant, int)), Qt::UniqueConnection);
@@ -498,7 +512,8 @@ int NexusInterface::requestUpdates(const int &modID, QObject *receiver, QVariant
   }
 
   NXMRequestInfo requestInfo(modID, NXMRequestInfo::TYPE_GETUPDATES, userData, subModule, game);
-  m_RequestQueue.enqueue(requestInfo);
+  requestInfo.m_Priority = NXMRequestInfo::PRIORITY_BULK;
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmUpdatesAvailable(QString, int, QVariant, QVariant, int)),
     receiver, SLOT(nxmUpdatesAvailable(QString, int, QVariant, QVariant, int)), Qt::UniqueConnection);
@@ -534,7 +549,7 @@ int NexusInterface::requestFiles(QString gameName, int modID, QObject *receiver,
                                  const QString &subModule, MOBase::IPluginGame const *game)
 {
   NXMRequestInfo requestInfo(modID, NXMRequestInfo::TYPE_FILES, userData, subModule, game);
-  m_RequestQueue.enqueue(requestInfo);
+  enqueue(requestInfo);
   connect(this, SIGNAL(nxmFilesAvailable(QString, int, QVariant, QVariant, int)),
     receiver, SLOT(nxmFilesAvailable(QString, int, QVariant, QVariant, int)), Qt::UniqueConnection);
 
@@ -555,7 +570,7 @@ int NexusInterface::requestFileInfo(QString gameName, int modID, int fileID, QOb
   }
 
   NXMRequestInfo requestInfo(modID, fileID, NXMRequestInfo::TYPE_FILEINFO, userData, subModule, gamePlugin);
-  m_RequestQueue.enqueue(requestInfo);
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmFileInfoAvailable(QString, int, int, QVariant, QVariant, int)),
     receiver, SLOT(nxmFileInfoAvailable(QString, int, int, QVariant, QVariant, int)), Qt::UniqueConnection);
@@ -572,7 +587,7 @@ int NexusInterface::requestDownloadURL(QString gameName, int modID, int fileID,
                                        const QString &subModule, MOBase::IPluginGame const *game)
 {
   NXMRequestInfo requestInfo(modID, fileID, NXMRequestInfo::TYPE_DOWNLOADURL, userData, subModule, game);
-  m_RequestQueue.enqueue(requestInfo);
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmDownloadURLsAvailable(QString,int,int,QVariant,QVariant,int)),
           receiver, SLOT(nxmDownloadURLsAvailable(QString,int,int,QVariant,QVariant,int)), Qt::UniqueConnection);
@@ -587,7 +602,7 @@ int NexusInterface::requestDownloadURL(QString gameName, int modID, int fileID,
 int NexusInterface::requestEndorsementInfo(QObject *receiver, QVariant userData, const QString &subModule)
 {
   NXMRequestInfo requestInfo(NXMRequestInfo::TYPE_ENDORSEMENTS, userData, subModule);
-  m_RequestQueue.enqueue(requestInfo);
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmEndorsementsAvailable(QVariant, QVariant, int)),
     receiver, SLOT(nxmEndorsementsAvailable(QVariant, QVariant, int)), Qt::UniqueConnection);
@@ -609,7 +624,7 @@ int NexusInterface::requestToggleEndorsement(QString gameName, int modID, QStrin
 
   NXMRequestInfo requestInfo(modID, modVersion, NXMRequestInfo::TYPE_TOGGLEENDORSEMENT, userData, subModule, game);
   requestInfo.m_Endorse = endorse;
-  m_RequestQueue.enqueue(requestInfo);
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmEndorsementToggled(QString, int, QVariant, QVariant, int)),
     receiver, SLOT(nxmEndorsementToggled(QString, int, QVariant, QVariant, int)), Qt::UniqueConnection);
@@ -624,7 +639,7 @@ int NexusInterface::requestToggleEndorsement(QString gameName, int modID, QStrin
 int NexusInterface::requestTrackingInfo(QObject *receiver, QVariant userData, const QString &subModule)
 {
   NXMRequestInfo requestInfo(NXMRequestInfo::TYPE_TRACKEDMODS, userData, subModule);
-  m_RequestQueue.enqueue(requestInfo);
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmTrackedModsAvailable(QVariant, QVariant, int)),
     receiver, SLOT(nxmTrackedModsAvailable(QVariant, QVariant, int)), Qt::UniqueConnection);
@@ -646,7 +661,7 @@ int NexusInterface::requestToggleTracking(QString gameName, int modID, bool trac
 
   NXMRequestInfo requestInfo(modID, NXMRequestInfo::TYPE_TOGGLETRACKING, userData, subModule, game);
   requestInfo.m_Track = track;
-  m_RequestQueue.enqueue(requestInfo);
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmTrackingToggled(QString, int, QVariant, bool, int)),
     receiver, SLOT(nxmTrackingToggled(QString, int, QVariant, bool, int)), Qt::UniqueConnection);
@@ -659,13 +674,18 @@ int NexusInterface::requestToggleTracking(QString gameName, int modID, bool trac
 }
 
 int NexusInterface::requestInfoFromMd5(QString gameName, QByteArray &hash, QObject *receiver, QVariant userData,
-                                       const QString &subModule, MOBase::IPluginGame const *game)
+                                       const QString &subModule, MOBase::IPluginGame const *game, bool bulk)
 {
   NXMRequestInfo requestInfo(hash, NXMRequestInfo::TYPE_FILEINFO_MD5, userData, subModule, game);
   requestInfo.m_Hash = hash;
+
+  if (bulk) {
+    requestInfo.m_Priority = NXMRequestInfo::PRIORITY_BULK;
+  }
+
   requestInfo.m_AllowedErrors[QNetworkReply::NetworkError::ContentNotFoundError].append(404);
   requestInfo.m_IgnoreGenericErrorHandler = true;
-  m_RequestQueue.enqueue(requestInfo);
+  enqueue(requestInfo);
 
   connect(this, SIGNAL(nxmFileInfoFromMd5Available(QString, QVariant, QVariant, int)),
       receiver, SLOT(nxmFileInfoFromMd5Available(QString, QVariant, QVariant, int)), Qt::UniqueConnection);
@@ -700,12 +720,227 @@ void NexusInterface::clearCache()
 {
   m_DiskCache->clear();
   m_AccessManager->clearCookies();
+  m_Cache.clear();
+  m_Cache.save();
+  BrowserCache::clear();
+}
+
+void NexusInterface::forgetCachedMod(QString gameName, int modID)
+{
+  const auto* game = getGame(gameName);
+  if (game == nullptr) {
+    return;
+  }
+
+  const QString nexusName = game->gameNexusName().toLower();
+
+  m_Cache.remove(QString("mod/%1/%2").arg(nexusName).arg(modID));
+  m_Cache.remove(QString("files/%1/%2").arg(nexusName).arg(modID));
+  m_CacheSaveTimer.start();
+}
+
+QString NexusInterface::descriptionAsHTML(
+  const QString& gameName, int modID, const QString& description)
+{
+  const auto* game = getGame(gameName);
+  const QString nexusName = (game ? game->gameNexusName() : gameName).toLower();
+
+  const QString key = QString("html/%1/%2").arg(nexusName).arg(modID);
+
+  const QByteArray hash = QCryptographicHash::hash(
+    description.toUtf8(), QCryptographicHash::Md5);
+
+  // value is the hash of the description and its html
+  if (auto cached = m_Cache.get(key, std::nullopt)) {
+    const auto list = cached->toList();
+    if (list.size() == 2 && list[0].toByteArray() == hash) {
+      return list[1].toString();
+    }
+  }
+
+  const QString html = BBCode::convertToHTML(description);
+
+  m_Cache.set(key, QVariantList{hash, html});
+  m_CacheSaveTimer.start();
+
+  return html;
+}
+
+QString NexusInterface::coalesceKey(const NXMRequestInfo& info)
+{
+  if (info.m_Reroute) {
+    return {};
+  }
+
+  const QString game = info.m_GameName.toLower();
+
+  // requests that hit the same url share a key even if they're reported
+  // through different signals
+  switch (info.m_Type) {
+    case NXMRequestInfo::TYPE_DESCRIPTION:
+    case NXMRequestInfo::TYPE_MODINFO:
+      return QString("mod/%1/%2").arg(game).arg(info.m_ModID);
+
+    case NXMRequestInfo::TYPE_FILES:
+    case NXMRequestInfo::TYPE_GETUPDATES:
+      return QString("files/%1/%2").arg(game).arg(info.m_ModID);
+
+    case NXMRequestInfo::TYPE_FILEINFO:
+      return QString("file/%1/%2/%3").arg(game).arg(info.m_ModID).arg(info.m_FileID);
+
+    case NXMRequestInfo::TYPE_CHECKUPDATES:
+      return QString("updated/%1/%2").arg(game).arg(static_cast<int>(info.m_UpdatePeriod));
+
+    case NXMRequestInfo::TYPE_ENDORSEMENTS:
+      return "endorsements";
+
+    case NXMRequestInfo::TYPE_TRACKEDMODS:
+      return "tracked";
+
+    case NXMRequestInfo::TYPE_FILEINFO_MD5:
+      return QString("md5/%1/%2").arg(game).arg(QString(info.m_Hash.toHex()));
+
+    // download links depend on the user data and toggles change things, these
+    // are always sent
+    case NXMRequestInfo::TYPE_DOWNLOADURL:
+    case NXMRequestInfo::TYPE_TOGGLEENDORSEMENT:
+    case NXMRequestInfo::TYPE_TOGGLETRACKING:
+    default:
+      return {};
+  }
+}
+
+std::optional<std::chrono::seconds> NexusInterface::cacheTTL(NXMRequestInfo::Type type)
+{
+  using namespace std::chrono_literals;
+
+  switch (type) {
+    case NXMRequestInfo::TYPE_DESCRIPTION:
+    case NXMRequestInfo::TYPE_MODINFO:
+    case NXMRequestInfo::TYPE_FILES:
+    case NXMRequestInfo::TYPE_GETUPDATES:
+    case NXMRequestInfo::TYPE_FILEINFO:
+      return 1h;
+
+    case NXMRequestInfo::TYPE_CHECKUPDATES:
+      return 15min;
+
+    case NXMRequestInfo::TYPE_FILEINFO_MD5:
+      return 24h;
+
+    // user data that's changed by toggles, or not something that can be
+    // answered twice
+    default:
+      return {};
+  }
+}
+
+void NexusInterface::enqueue(const NXMRequestInfo& info)
+{
+  const QString key = coalesceKey(info);
+
+  if (!key.isEmpty()) {
+    if (const auto ttl = cacheTTL(info.m_Type)) {
+      // offline, anything is better than nothing
+      const bool offline = m_Settings && m_Settings->network().offlineMode();
+
+      if (auto cached = m_Cache.get(key, offline ? std::nullopt : ttl)) {
+        // the caller needs the request id before the result comes in
+        QTimer::singleShot(0, this, [this, info, result=std::move(*cached)] {
+          emitResult(info, result);
+        });
+
+        return;
+      }
+    }
+
+    auto merge = [&](NXMRequestInfo& other) {
+      if (coalesceKey(other) != key ||
+          other.m_AllowedErrors != info.m_AllowedErrors ||
+          other.m_IgnoreGenericErrorHandler != info.m_IgnoreGenericErrorHandler) {
+        return false;
+      }
+
+      other.m_Followers.push_back({info.m_Type, info.m_ID, info.m_UserData});
+      return true;
+    };
+
+    // a request that's already in flight or waiting gets the reply for this
+    // one too
+    for (auto& active : m_ActiveRequest) {
+      if (merge(active)) {
+        return;
+      }
+    }
+
+    for (auto& queued : m_RequestQueue) {
+      if (merge(queued)) {
+        return;
+      }
+    }
+
+    for (int i = 0; i < m_BulkQueue.size(); ++i) {
+      if (merge(m_BulkQueue[i])) {
+        if (info.m_Priority == NXMRequestInfo::PRIORITY_INTERACTIVE) {
+          // someone is waiting for this one now
+          NXMRequestInfo promoted = m_BulkQueue.takeAt(i);
+          promoted.m_Priority = NXMRequestInfo::PRIORITY_INTERACTIVE;
+          m_RequestQueue.enqueue(promoted);
+        }
+
+        return;
+      }
+    }
+  }
+
+  queueFor(info).enqueue(info);
+}
+
+QQueue<NexusInterface::NXMRequestInfo>& NexusInterface::queueFor(const NXMRequestInfo& info)
+{
+  if (info.m_Priority == NXMRequestInfo::PRIORITY_BULK) {
+    return m_BulkQueue;
+  } else {
+    return m_RequestQueue;
+  }
+}
+
+bool NexusInterface::canStartBulk() const
+{
+  if (m_BulkQueue.isEmpty()) {
+    return false;
+  }
+
+  int active = 0;
+  for (const auto& r : m_ActiveRequest) {
+    if (r.m_Priority == NXMRequestInfo::PRIORITY_BULK) {
+      ++active;
+    }
+  }
+
+  // some room is always left for interactive requests
+  return (active < std::max(1, maxActiveRequests() / 2));
+}
+
+int NexusInterface::maxActiveRequests() const
+{
+  if (m_User.limits().maxHourlyRequests <= 0) {
+    // limits are unknown until the first reply
+    return MAX_ACTIVE_DOWNLOADS;
+  }
+
+  // every reply updates the limits, so fewer requests are kept in flight as
+  // the remaining requests get close to the throttling threshold to avoid
+  // going over it
+  const int margin = m_User.remainingRequests() - APIUserAccount::ThrottleThreshold;
+
+  return std::clamp(margin / 10, 1, static_cast<int>(MAX_ACTIVE_DOWNLOADS));
 }
 
 void NexusInterface::nextRequest()
 {
-  if ((m_ActiveRequest.size() >= MAX_ACTIVE_DOWNLOADS)
-      || m_RequestQueue.isEmpty()) {
+  if ((static_cast<int>(m_ActiveRequest.size()) >= maxActiveRequests())
+      || (m_RequestQueue.isEmpty() && m_BulkQueue.isEmpty())) {
     return;
   }
 
@@ -722,6 +957,7 @@ void NexusInterface::nextRequest()
 
   if (m_User.exhausted()) {
     m_RequestQueue.clear();
+    m_BulkQueue.clear();
     QTime time = QTime::currentTime();
     QTime targetTime;
     targetTime.setHMS((time.hour() + 1) % 23, 5, 0);
@@ -735,7 +971,23 @@ void NexusInterface::nextRequest()
     return;
   }
 
-  NXMRequestInfo info = m_RequestQueue.dequeue();
+  if (!m_BulkQueue.isEmpty() && m_User.limits().maxHourlyRequests > 0 &&
+      m_User.remainingRequests() < BULK_RESERVE) {
+    // the rest of the requests are kept for what the user does
+    log::warn(
+      "only {} api requests left, canceling {} queued background requests",
+      m_User.remainingRequests(), m_BulkQueue.size());
+
+    m_BulkQueue.clear();
+  }
+
+  if (m_RequestQueue.isEmpty() && !canStartBulk()) {
+    return;
+  }
+
+  NXMRequestInfo info = m_RequestQueue.isEmpty() ?
+    m_BulkQueue.dequeue() : m_RequestQueue.dequeue();
+
   info.m_Timeout = new QTimer(this);
   info.m_Timeout->setInterval(60000);
 
@@ -873,14 +1125,24 @@ void NexusInterface::requestFinished(std::list<NXMRequestInfo>::iterator iter)
     } else {
       log::warn("request failed: {}", reply->errorString());
     }
-    emit nxmRequestFailed(iter->m_GameName, iter->m_ModID, iter->m_FileID, iter->m_UserData, iter->m_ID, reply->error(), reply->errorString());
+
+    // when the server can't be reached, an old result is still useful
+    if (statusCode == 0 && cacheTTL(iter->m_Type)) {
+      if (auto cached = m_Cache.get(coalesceKey(*iter), std::nullopt)) {
+        log::debug("using cached result for {}", reply->url().toString());
+        emitResult(*iter, *cached);
+        return;
+      }
+    }
+
+    emitFailed(*iter, reply->error(), reply->errorString());
   } else {
     int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     if (statusCode == 301) {
       // redirect request, return request to queue
       iter->m_URL = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toString();
       iter->m_Reroute = true;
-      m_RequestQueue.enqueue(*iter);
+      queueFor(*iter).enqueue(*iter);
       //nextRequest();
       return;
     }
@@ -891,68 +1153,105 @@ void NexusInterface::requestFinished(std::list<NXMRequestInfo>::iterator iter)
         nexusError = tr("empty response");
       }
       log::debug("nexus error: {}", nexusError);
-      emit nxmRequestFailed(iter->m_GameName, iter->m_ModID, iter->m_FileID, iter->m_UserData, iter->m_ID, reply->error(), nexusError);
+      emitFailed(*iter, reply->error(), nexusError);
     } else {
       QJsonDocument responseDoc = QJsonDocument::fromJson(data);
       if (!responseDoc.isNull()) {
-        QVariant result = responseDoc.toVariant();
-        switch (iter->m_Type) {
-          case NXMRequestInfo::TYPE_DESCRIPTION: {
-            emit nxmDescriptionAvailable(iter->m_GameName, iter->m_ModID, iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_MODINFO: {
-            emit nxmModInfoAvailable(iter->m_GameName, iter->m_ModID, iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_CHECKUPDATES: {
-            emit nxmUpdateInfoAvailable(iter->m_GameName, iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_FILES: {
-            emit nxmFilesAvailable(iter->m_GameName, iter->m_ModID, iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_GETUPDATES: {
-            emit nxmUpdatesAvailable(iter->m_GameName, iter->m_ModID, iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_FILEINFO: {
-            emit nxmFileInfoAvailable(iter->m_GameName, iter->m_ModID, iter->m_FileID, iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_DOWNLOADURL: {
-            emit nxmDownloadURLsAvailable(iter->m_GameName, iter->m_ModID, iter->m_FileID, iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_ENDORSEMENTS: {
-            emit nxmEndorsementsAvailable(iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_TOGGLEENDORSEMENT: {
-            emit nxmEndorsementToggled(iter->m_GameName, iter->m_ModID, iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_TOGGLETRACKING: {
-            auto results = result.toMap();
-            auto message = results["message"].toString();
-            if (message.contains(QRegularExpression("User [0-9]+ is already Tracking Mod: [0-9]+")) ||
-                message.contains(QRegularExpression("User [0-9]+ is now Tracking Mod: [0-9]+"))) {
-              emit nxmTrackingToggled(iter->m_GameName, iter->m_ModID, iter->m_UserData, true, iter->m_ID);
-            } else if (message.contains(QRegularExpression("User [0-9]+ is no longer tracking [0-9]+")) ||
-                       message.contains(QRegularExpression("Users is not tracking mod. Unable to untrack."))) {
-              emit nxmTrackingToggled(iter->m_GameName, iter->m_ModID, iter->m_UserData, false, iter->m_ID);
-            }
-          } break;
-          case NXMRequestInfo::TYPE_TRACKEDMODS: {
-            emit nxmTrackedModsAvailable(iter->m_UserData, result, iter->m_ID);
-          } break;
-          case NXMRequestInfo::TYPE_FILEINFO_MD5: {
-            emit nxmFileInfoFromMd5Available(iter->m_GameName, iter->m_UserData, result, iter->m_ID);
-          } break;
+        const QVariant result = responseDoc.toVariant();
+        emitResult(*iter, result);
+
+        const QString key = coalesceKey(*iter);
+        if (!key.isEmpty() && cacheTTL(iter->m_Type)) {
+          m_Cache.set(key, result);
+          m_CacheSaveTimer.start();
+        } else if (iter->m_Type == NXMRequestInfo::TYPE_TOGGLEENDORSEMENT) {
+          // the mod info has the endorsement state
+          m_Cache.remove(QString("mod/%1/%2").arg(iter->m_GameName.toLower()).arg(iter->m_ModID));
+          m_CacheSaveTimer.start();
         }
 
         m_User.limits(parseLimits(reply));
         emit requestsChanged(getAPIStats(), m_User);
       } else {
-        emit nxmRequestFailed(iter->m_GameName, iter->m_ModID, iter->m_FileID, iter->m_UserData, iter->m_ID, reply->error(), tr("invalid response"));
+        emitFailed(*iter, reply->error(), tr("invalid response"));
       }
     }
   }
 }
 
 
+void NexusInterface::emitResult(const NXMRequestInfo& info, const QVariant& result)
+{
+  emitResult(info, info.m_Type, info.m_ID, info.m_UserData, result);
+
+  for (const auto& f : info.m_Followers) {
+    emitResult(info, f.m_Type, f.m_ID, f.m_UserData, result);
+  }
+}
+
+void NexusInterface::emitResult(
+  const NXMRequestInfo& info, NXMRequestInfo::Type type, int id,
+  const QVariant& userData, const QVariant& result)
+{
+  switch (type) {
+    case NXMRequestInfo::TYPE_DESCRIPTION: {
+      emit nxmDescriptionAvailable(info.m_GameName, info.m_ModID, userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_MODINFO: {
+      emit nxmModInfoAvailable(info.m_GameName, info.m_ModID, userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_CHECKUPDATES: {
+      emit nxmUpdateInfoAvailable(info.m_GameName, userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_FILES: {
+      emit nxmFilesAvailable(info.m_GameName, info.m_ModID, userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_GETUPDATES: {
+      emit nxmUpdatesAvailable(info.m_GameName, info.m_ModID, userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_FILEINFO: {
+      emit nxmFileInfoAvailable(info.m_GameName, info.m_ModID, info.m_FileID, userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_DOWNLOADURL: {
+      emit nxmDownloadURLsAvailable(info.m_GameName, info.m_ModID, info.m_FileID, userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_ENDORSEMENTS: {
+      emit nxmEndorsementsAvailable(userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_TOGGLEENDORSEMENT: {
+      emit nxmEndorsementToggled(info.m_GameName, info.m_ModID, userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_TOGGLETRACKING: {
+      auto results = result.toMap();
+      auto message = results["message"].toString();
+      if (message.contains(QRegularExpression("User [0-9]+ is already Tracking Mod: [0-9]+")) ||
+          message.contains(QRegularExpression("User [0-9]+ is now Tracking Mod: [0-9]+"))) {
+        emit nxmTrackingToggled(info.m_GameName, info.m_ModID, userData, true, id);
+      } else if (message.contains(QRegularExpression("User [0-9]+ is no longer tracking [0-9]+")) ||
+                 message.contains(QRegularExpression("Users is not tracking mod. Unable to untrack."))) {
+        emit nxmTrackingToggled(info.m_GameName, info.m_ModID, userData, false, id);
+      }
+    } break;
+    case NXMRequestInfo::TYPE_TRACKEDMODS: {
+      emit nxmTrackedModsAvailable(userData, result, id);
+    } break;
+    case NXMRequestInfo::TYPE_FILEINFO_MD5: {
+      emit nxmFileInfoFromMd5Available(info.m_GameName, userData, result, id);
+    } break;
+  }
+}
+
+void NexusInterface::emitFailed(
+  const NXMRequestInfo& info, QNetworkReply::NetworkError error, const QString& errorString)
+{
+  emit nxmRequestFailed(info.m_GameName, info.m_ModID, info.m_FileID, info.m_UserData, info.m_ID, error, errorString);
+
+  for (const auto& f : info.m_Followers) {
+    emit nxmRequestFailed(info.m_GameName, info.m_ModID, info.m_FileID, f.m_UserData, f.m_ID, error, errorString);
+  }
+}
+
+
 void NexusInterface::requestFinished()
 {
   QNetworkReply *reply = static_cast<QNetworkReply*>(sender());
@@ -1008,7 +1307,12 @@ APIUserAccount NexusInterface::getAPIUserAccount() const
 APIStats NexusInterface::getAPIStats() const
 {
   APIStats stats;
-  stats.requestsQueued = m_RequestQueue.size();
+
+  if (m_AccessManager) {
+    stats = m_AccessManager->connectionStats();
+  }
+
+  stats.requestsQueued = m_RequestQueue.size() + m_BulkQueue.size();
 
   return stats;
 }
@@ -21,6 +21,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #define NEXUSINTERFACE_H
 
 #include "apiuseraccount.h"
+#include "nexuscache.h"
 #include "plugincontainer.h"
 
 #include <utility.h>
@@ -33,8 +34,11 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVariant>
 #include <QTimer>
 
+#include <chrono>
 #include <list>
+#include <optional>
 #include <set>
+#include <vector>
 
 namespace MOBase { class IPluginGame; }
 
@@ -173,6 +177,20 @@ public:
    */
   void clearCache();
 
+  /**
+   * @brief forget the cached info and files for a mod, so the next requests
+   *        for them go to the server
+   */
+  void forgetCachedMod(QString gameName, int modID);
+
+  /**
+   * @brief the description of a mod converted from bbcode to html; the result
+   *        is kept in the cache for the mod along with a hash of the
+   *        description, so it's only converted again when it changes
+   */
+  QString descriptionAsHTML(
+    const QString& gameName, int modID, const QString& description);
+
   /**
    * @brief request description for a mod
    *
@@ -384,10 +402,19 @@ public:
   }
 
   /**
-   *
+   * @brief same as requestInfoFromMd5(), but the request is sent after the
+   *        interactive ones, for lookups of many files at once
+   */
+  int requestInfoFromMd5Bulk(QString gameName, QByteArray &hash, QObject *receiver, QVariant userData, const QString &subModule)
+  {
+    return requestInfoFromMd5(gameName, hash, receiver, userData, subModule, getGame(gameName), true);
+  }
+
+  /**
+   * @param bulk whether the request is queued with the bulk requests
    */
   int requestInfoFromMd5(QString gameName, QByteArray &hash, QObject *receiver, QVariant userData, const QString &subModule,
-                         MOBase::IPluginGame const *game);
+                         MOBase::IPluginGame const *game, bool bulk = false);
 
   /**
    * @param directory the directory to store cache files
@@ -506,6 +533,25 @@ private:
       TYPE_TRACKEDMODS,
       TYPE_FILEINFO_MD5,
     } m_Type;
+
+    // a request for the same data that was merged into this one, it gets the
+    // same reply; see NexusInterface::enqueue()
+    struct Follower
+    {
+      Type m_Type;
+      int m_ID;
+      QVariant m_UserData;
+    };
+
+    std::vector<Follower> m_Followers;
+
+    // interactive requests are sent before bulk ones, which only get part of
+    // the requests in flight; see NexusInterface::nextRequest()
+    enum Priority {
+      PRIORITY_INTERACTIVE,
+      PRIORITY_BULK
+    } m_Priority = PRIORITY_INTERACTIVE;
+
     UpdatePeriod m_UpdatePeriod;
     QVariant m_UserData;
     QTimer *m_Timeout;
@@ -534,9 +580,42 @@ private:
 
   static const int MAX_ACTIVE_DOWNLOADS = 6;
 
+  // bulk requests are canceled when fewer than this many requests are left
+  static const int BULK_RESERVE = 2 * APIUserAccount::ThrottleThreshold;
+
 private:
   void nextRequest();
   void requestFinished(std::list<NXMRequestInfo>::iterator iter);
+
+  // queues the request, or merges it into an active or queued request for
+  // the same data
+  void enqueue(const NXMRequestInfo& info);
+
+  // identifies the data a request is for, empty if it can't be merged
+  static QString coalesceKey(const NXMRequestInfo& info);
+
+  // how long results for the given request type are taken from m_Cache
+  // instead of asking again, empty if they're never cached
+  static std::optional<std::chrono::seconds> cacheTTL(NXMRequestInfo::Type type);
+
+  // the lane for the request's priority
+  QQueue<NXMRequestInfo>& queueFor(const NXMRequestInfo& info);
+
+  // whether a bulk request is waiting and can be sent now
+  bool canStartBulk() const;
+
+  // number of requests that can be in flight, lower when few requests are left
+  // in the api limits
+  int maxActiveRequests() const;
+
+  // emits the result or failure for the request and all its followers
+  void emitResult(const NXMRequestInfo& info, const QVariant& result);
+  void emitResult(
+    const NXMRequestInfo& info, NXMRequestInfo::Type type, int id,
+    const QVariant& userData, const QVariant& result);
+  void emitFailed(
+    const NXMRequestInfo& info, QNetworkReply::NetworkError error,
+    const QString& errorString);
   MOBase::IPluginGame *getGame(QString gameName) const;
   QString getOldModsURL(QString gameName) const;
 
@@ -545,9 +624,15 @@ private:
   NXMAccessManager *m_AccessManager;
   std::list<NXMRequestInfo> m_ActiveRequest;
   QQueue<NXMRequestInfo> m_RequestQueue;
+  QQueue<NXMRequestInfo> m_BulkQueue;
   MOBase::VersionInfo m_MOVersion;
   PluginContainer *m_PluginContainer;
   APIUserAccount m_User;
+  Settings* m_Settings;
+
+  // parsed results, see enqueue()
+  NexusCache m_Cache;
+  QTimer m_CacheSaveTimer;
 };
 
 #endif // NEXUSINTERFACE_H
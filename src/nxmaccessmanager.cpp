@@ -31,6 +31,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QPushButton>
 #include <QNetworkProxy>
 #include <QNetworkRequest>
+#include <QSslConfiguration>
 #include <QNetworkCookie>
 #include <QNetworkCookieJar>
 #include <QCoreApplication>
@@ -810,7 +811,15 @@ QNetworkReply *NXMAccessManager::createRequest(
     QIODevice *device)
 {
   if (request.url().scheme() != "nxm") {
-    return QNetworkAccessManager::createRequest(operation, request, device);
+    if (request.url().host() != QUrl(NexusBaseUrl).host()) {
+      return QNetworkAccessManager::createRequest(operation, request, device);
+    }
+
+    auto* reply = QNetworkAccessManager::createRequest(
+      operation, prepareApiRequest(request), device);
+
+    trackApiReply(reply);
+    return reply;
   }
   if (operation == GetOperation) {
     emit requestNXMDownload(request.url().toString());
@@ -825,6 +834,45 @@ QNetworkReply *NXMAccessManager::createRequest(
   }
 }
 
+QNetworkRequest NXMAccessManager::prepareApiRequest(
+  const QNetworkRequest& request) const
+{
+  QNetworkRequest r(request);
+
+  // all the api requests are multiplexed on one connection instead of paying
+  // for a handshake on each of the parallel connections http/1 would open
+  r.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+  // new connections resume the tls session of an earlier one when possible
+  QSslConfiguration ssl = r.sslConfiguration();
+  ssl.setSslOption(QSsl::SslOptionDisableSessionSharing, false);
+  ssl.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+  r.setSslConfiguration(ssl);
+
+  return r;
+}
+
+void NXMAccessManager::trackApiReply(QNetworkReply* reply)
+{
+  ++m_ConnectionStats.requestsSent;
+
+  // only emitted when a new connection was made, not when one was reused
+  connect(reply, &QNetworkReply::encrypted, this, [this]{
+    ++m_ConnectionStats.handshakes;
+  });
+
+  connect(reply, &QNetworkReply::finished, this, [this, reply]{
+    if (reply->attribute(QNetworkRequest::HTTP2WasUsedAttribute).toBool()) {
+      ++m_ConnectionStats.http2Requests;
+    }
+  });
+}
+
+const APIStats& NXMAccessManager::connectionStats() const
+{
+  return m_ConnectionStats;
+}
+
 void NXMAccessManager::showCookies() const
 {
   QUrl url(NexusBaseUrl + "/");
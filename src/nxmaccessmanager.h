@@ -235,6 +235,11 @@ public:
 
   void refuseValidation();
 
+  // counters for requests to the API, only requestsSent, http2Requests
+  // and handshakes are filled
+  //
+  const APIStats& connectionStats() const;
+
 signals:
 
   /**
@@ -273,6 +278,7 @@ private:
   QString m_MOVersion;
   NexusKeyValidator m_validator;
   States m_validationState;
+  APIStats m_ConnectionStats;
 
   void startValidationCheck(const QString& key);
 
@@ -284,6 +290,11 @@ private:
 
   void startProgress();
   void stopProgress();
+
+  // allows HTTP/2 and TLS session reuse for requests to the API and hooks the
+  // reply to the counters
+  QNetworkRequest prepareApiRequest(const QNetworkRequest& request) const;
+  void trackApiReply(QNetworkReply* reply);
 };
 
 #endif // NXMACCESSMANAGER_H
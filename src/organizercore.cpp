@@ -1,4 +1,6 @@
 #include "organizercore.h"
+#include "metrics.h"
+#include "pluginstats.h"
 #include "delayedfilewriter.h"
 #include "guessedvalue.h"
 #include "imodinterface.h"
@@ -27,15 +29,29 @@
 #include <questionboxmemory.h>
 #include "instancemanager.h"
 #include <scriptextender.h>
+#include <gameplugins.h>
 #include "previewdialog.h"
 #include "env.h"
 #include "envmodule.h"
 #include "envfs.h"
 #include "directoryrefresher.h"
+#include "refreshtrace.h"
+#include "startuptrace.h"
+#include "sanitychecks.h"
+#include "taskexecutor.h"
+#include "filesearchindex.h"
+#include "modintegrity.h"
+#include "modinfowithconflictinfo.h"
+#include "launchtimeline.h"
 #include "shared/directoryentry.h"
+#include "shared/directorysnapshot.h"
+#include "shared/archiveindex.h"
 #include "shared/filesorigin.h"
+#include "shared/originconnection.h"
 #include "shared/fileentry.h"
+#include "shared/ioaccounting.h"
 #include "shared/util.h"
+#include "glob_matching.h"
 
 #include <QApplication>
 #include <QCoreApplication>
@@ -60,6 +76,7 @@
 #include <stddef.h>
 #include <string.h> // for memset, wcsrchr
 
+#include <algorithm>
 #include <exception>
 #include <functional>
 #include <boost/algorithm/string/predicate.hpp>
@@ -95,26 +112,71 @@ OrganizerCore::OrganizerCore(Settings &settings)
   , m_Updater(&NexusInterface::instance())
   , m_ModList(m_PluginContainer, this)
   , m_PluginList(*this)
-  , m_DirectoryRefresher(new DirectoryRefresher(settings.refreshThreadCount()))
+  , m_DirectoryRefresher(new DirectoryRefresher)
   , m_DirectoryStructure(new DirectoryEntry(L"data", nullptr, 0))
   , m_DownloadManager(&NexusInterface::instance(), this)
+  , m_StructureDeleter(new TaskGroup(TaskPriority::Low))
   , m_DirectoryUpdate(false)
+  , m_DeferredPluginListForce(false)
+  , m_PendingRefresh(PendingRefresh::None)
+  , m_PendingRefreshSave(true)
   , m_ArchivesInit(false)
+  , m_SearchIndexCurrent(false)
+  , m_SearchIndexGeneration(std::make_shared<std::atomic<int>>(0))
+  , m_InstallBatch(false)
+  , m_InstallBatchPending(0)
   , m_PluginListsWriter(std::bind(&OrganizerCore::savePluginList, this))
 {
-  env::setHandleCloserThreadCount(settings.refreshThreadCount());
+  MOShared::TaskExecutor::setThreadCount(settings.refreshThreadCount());
   m_DownloadManager.setOutputDirectory(m_Settings.paths().downloads(), false);
 
+  m_DownloadManager.setLimits(
+    m_Settings.network().maxDownloads(),
+    static_cast<qint64>(m_Settings.network().maxDownloadSpeed()) * 1024,
+    static_cast<qint64>(m_Settings.network().maxDownloadSpeedPerDownload()) * 1024);
+
   NexusInterface::instance().setCacheDirectory(m_Settings.paths().cache());
 
   m_InstallationManager.setModsDirectory(m_Settings.paths().mods());
   m_InstallationManager.setDownloadDirectory(m_Settings.paths().downloads());
 
+  // archives are indexed once for all the instances, portable or not
+  ArchiveIndex::setCacheFile(QDir::toNativeSeparators(
+    InstanceManager::singleton().globalInstancesRootPath() +
+    "/archives.cache").toStdWString());
+
+  ModIntegrity::setDirectory(m_Settings.paths().base() + "/integrity");
+
   connect(&m_DownloadManager, SIGNAL(downloadSpeed(QString, int)), this,
           SLOT(downloadSpeed(QString, int)));
+
+  m_PendingInstallsTimer.setSingleShot(true);
+  m_PendingInstallsTimer.setInterval(500);
+
+  connect(
+    &m_PendingInstallsTimer, &QTimer::timeout,
+    [&]{ installPendingDownloads(); });
+
+  connect(
+    &m_DownloadManager, &DownloadManager::readyToInstall,
+    [&](const QString& fileName) {
+      m_PendingInstalls.append(fileName);
+
+      // not right away, the download is still changing state
+      m_PendingInstallsTimer.start();
+    });
   connect(m_DirectoryRefresher.get(), SIGNAL(refreshed()), this,
           SLOT(directory_refreshed()));
 
+  m_ChangeJournal.setListener([this](auto&& root, auto&& paths) {
+    m_StructureWatcher.post(root, std::move(paths));
+  });
+
+  m_StructureWatcher.setSuppression(&m_DirWatcherSuppression);
+  connect(
+    &m_StructureWatcher, &DirectoryWatcher::changed,
+    this, &OrganizerCore::onWatchedFilesChanged);
+
   connect(&m_ModList, SIGNAL(removeOrigin(QString)), this,
           SLOT(removeOrigin(QString)));
   connect(&m_ModList, &ModList::modStatesChanged, [=] { currentProfile()->writeModlist(); });
@@ -154,17 +216,127 @@ OrganizerCore::OrganizerCore(Settings &settings)
   connect(&settings.plugins(), &PluginSettings::pluginSettingChanged, [this](auto const& ...args) {
     m_PluginSettingChanged(args...);
   });
+
+  // the environment checks run in the background and can find problems after
+  // the ui is up, see MOApplication::startEnvironmentChecks()
+  sanity::setProblemsChanged([this] {
+    QMetaObject::invokeMethod(this, [this]{ invalidate(); }, Qt::QueuedConnection);
+  });
+
+  registerMemorySources();
+}
+
+void OrganizerCore::registerMemorySources()
+{
+  auto add = [&](
+    QString name, std::function<MemoryUsage ()> usage,
+    std::function<void (const QString&)> dump={},
+    MemoryAccounting::Trimmer trimmer={})
+  {
+    m_MemorySources.push_back(std::make_unique<MemoryAccounting::Source>(
+      std::move(name), std::move(usage), std::move(dump), std::move(trimmer)));
+  };
+
+  // the structure is replaced by refreshes, so it's read from the member
+  // every time
+  auto structure = [this](auto&& f) {
+    return (m_DirectoryStructure ? f(*m_DirectoryStructure) : MemoryUsage{});
+  };
+
+  add("structure: directories",
+    [structure]{
+      return structure([](DirectoryEntry& d) { return d.memoryUsage(); });
+    },
+    [this](const QString& path) {
+      if (m_DirectoryStructure) {
+        m_DirectoryStructure->dumpMemory(path.toStdWString());
+      }
+    });
+
+  add("structure: files", [structure]{
+    return structure([](DirectoryEntry& d) {
+      return d.getFileRegister()->filesMemory();
+    });
+  });
+
+  add("structure: origins", [structure]{
+    return structure([](DirectoryEntry& d) {
+      MemoryUsage u;
+
+      d.getOriginConnection()->forEachOrigin([&](const FilesOrigin& o) {
+        ++u.count;
+        u.bytes += o.memoryBytes();
+      });
+
+      return u;
+    });
+  });
+
+  add("structure: names", [structure]{
+    return structure([](DirectoryEntry& d) {
+      return MemoryUsage{0, d.getFileRegister()->namesBytes()};
+    });
+  });
+
+  add("structure: conflicts", [structure]{
+    return structure([](DirectoryEntry& d) {
+      return d.getFileRegister()->conflicts().memoryUsage();
+    });
+  });
+
+  add("search index", [this]{
+    return (m_SearchIndex ? m_SearchIndex->memoryUsage() : MemoryUsage{});
+  });
+
+  auto mods = [](auto&& f) {
+    MemoryUsage u;
+
+    for (unsigned int i=0; i<ModInfo::getNumMods(); ++i) {
+      u += f(*ModInfo::getByIndex(i));
+    }
+
+    return u;
+  };
+
+  // both are built again by the mods when they're needed
+  auto release = [](auto&& f) {
+    for (auto& mod : ModInfo::snapshot().mods()) {
+      f(*mod);
+    }
+  };
+
+  add("mods: conflict sets",
+    [mods]{
+      return mods([](const ModInfo& m) { return m.conflictSetsMemory(); });
+    },
+    {},
+    {
+      [release]{ release([](ModInfo& m) { m.releaseConflictSets(); }); },
+      []{ return ModInfoWithConflictInfo::conflictSetsLastUsed(); }
+    });
+
+  add("mods: file trees",
+    [mods]{
+      return mods([](const ModInfo& m) { return m.fileTreeMemory(); });
+    },
+    {},
+    {
+      [release]{ release([](ModInfo& m) { m.releaseFileTree(); }); },
+      []{ return ModInfoWithConflictInfo::fileTreesLastUsed(); }
+    });
 }
 
 OrganizerCore::~OrganizerCore()
 {
+  sanity::setProblemsChanged({});
+
   m_RefresherThread.exit();
   m_RefresherThread.wait();
 
-  if (m_StructureDeleter.joinable()) {
-    m_StructureDeleter.join();
-  }
+  // structures that are still being deleted
+  m_StructureDeleter->wait();
 
+  saveStructureSnapshot();
   saveCurrentProfile();
 
   // profile has to be cleaned up before the modinfo-buffer is cleared
@@ -174,7 +346,9 @@ OrganizerCore::~OrganizerCore()
   m_ModList.setProfile(nullptr);
   //  NexusInterface::instance()->cleanup();
 
-  delete m_DirectoryStructure;
+  if (!retireStructure()) {
+    delete m_DirectoryStructure;
+  }
 }
 
 void OrganizerCore::storeSettings()
@@ -220,8 +394,7 @@ void OrganizerCore::updateExecutablesList()
 void OrganizerCore::updateModInfoFromDisc() {
   ModInfo::updateFromDisc(
     m_Settings.paths().mods(), *this,
-    m_Settings.interface().displayForeign(),
-    m_Settings.refreshThreadCount());
+    m_Settings.interface().displayForeign());
 }
 
 void OrganizerCore::setUserInterface(IUserInterface* ui)
@@ -362,6 +535,12 @@ void OrganizerCore::downloadRequested(QNetworkReply *reply, QString gameName, in
 
 void OrganizerCore::removeOrigin(const QString &name)
 {
+  if (structureShared()) {
+    // views hold the structure, a new one without the origin is built
+    refreshDirectoryStructure();
+    return;
+  }
+
   FilesOrigin &origin = m_DirectoryStructure->getOriginByName(ToWString(name));
   origin.enable(false);
   refreshLists();
@@ -463,6 +642,34 @@ void OrganizerCore::prepareVFS()
   m_USVFS.updateMapping(fileMapping(m_CurrentProfile->name(), QString()));
 }
 
+void OrganizerCore::prewarmVFS()
+{
+  if (!m_Settings.prewarmVFS() || !m_CurrentProfile || m_DirectoryUpdate) {
+    return;
+  }
+
+  // clearing the mapping would pull the files from under running programs
+  const auto running = getRunningUSVFSProcesses();
+  for (auto&& h : running) {
+    ::CloseHandle(h);
+  }
+
+  if (!running.empty()) {
+    log::debug("not prewarming vfs, {} programs are running", running.size());
+    return;
+  }
+
+  try
+  {
+    m_USVFS.updateMapping(fileMapping(m_CurrentProfile->name(), QString()), false);
+  }
+  catch(const std::exception& e)
+  {
+    // the mapping will be created when a program is started
+    log::debug("failed to prewarm vfs, {}", e.what());
+  }
+}
+
 void OrganizerCore::updateVFSParams(
   log::Levels logLevel, env::CoreDumpTypes coreDumpType,
   const QString& crashDumpsPath,
@@ -570,6 +777,7 @@ void OrganizerCore::setCurrentProfile(const QString &profileName)
   auto oldProfile = std::move(m_CurrentProfile);
 
   m_CurrentProfile = std::make_unique<Profile>(QDir(profileDir), managedGame());
+  m_EnabledArchives.reset();
 
   m_ModList.setProfile(m_CurrentProfile.get());
 
@@ -583,11 +791,23 @@ void OrganizerCore::setCurrentProfile(const QString &profileName)
 
   connect(m_CurrentProfile.get(), qOverload<uint>(&Profile::modStatusChanged), [this](auto&& index) { modStatusChanged(index); });
   connect(m_CurrentProfile.get(), qOverload<QList<uint>>(&Profile::modStatusChanged), [this](auto&& indexes) { modStatusChanged(indexes); });
+
+  if (!m_DirectoryStructure->isPopulated()) {
+    // on startup, the snapshot written on the last exit is restored and the
+    // refresh below only has to walk the origins that changed since
+    restoreStructureSnapshot();
+  }
+
   refreshDirectoryStructure();
 
   m_CurrentProfile->debugDump();
 
   emit profileChanged(oldProfile.get(), m_CurrentProfile.get());
+  if (m_PluginContainer) {
+    m_PluginContainer->invalidateProblems(
+      PluginContainer::DiagnoseEvent::ProfileChanged);
+  }
+
   m_ProfileChanged(oldProfile.get(), m_CurrentProfile.get());
 }
 
@@ -766,7 +986,7 @@ ModInfo::Ptr OrganizerCore::installDownload(int index, int priority)
     if (result) {
       MessageDialog::showMessage(tr("Installation successful"),
                                  qApp->activeWindow());
-      refresh();
+      refreshAfterInstall();
 
       int modIndex = ModInfo::getIndex(modName);
       ModInfo::Ptr modInfo = nullptr;
@@ -789,6 +1009,7 @@ ModInfo::Ptr OrganizerCore::installDownload(int index, int priority)
         }
 
         m_ModList.notifyModInstalled(modInfo.get());
+        ModIntegrity::recordLater({modInfo->name(), modInfo->absolutePath()});
         m_InstallationManager.notifyInstallationEnd(result, modInfo);
       } else {
         reportError(tr("mod not found: %1").arg(qUtf8Printable(modName)));
@@ -818,6 +1039,101 @@ ModInfo::Ptr OrganizerCore::installDownload(int index, int priority)
   return nullptr;
 }
 
+void OrganizerCore::installDownloads(const std::vector<int>& downloadIndexes)
+{
+  if (m_InstallBatch || m_InstallationManager.isRunning()) {
+    QMessageBox::information(
+      qApp->activeWindow(), tr("Installation cancelled"),
+      tr("Another installation is currently in progress."), QMessageBox::Ok);
+    return;
+  }
+
+  // indexes change when installed downloads are hidden, remember the files
+  QStringList fileNames;
+  for (int index : downloadIndexes) {
+    fileNames.append(m_DownloadManager.getFileName(index));
+  }
+
+  log::debug("installing {} downloads", fileNames.size());
+
+  m_InstallBatch = true;
+  m_InstallBatchPending = 0;
+
+  Guard g([&] {
+    m_InstallBatch = false;
+
+    if (m_InstallBatchPending > 0) {
+      m_InstallBatchPending = 0;
+
+      // queued if a refresh is running
+      refreshDirectoryStructure();
+    }
+  });
+
+  for (const QString& fileName : fileNames) {
+    const int index = m_DownloadManager.indexByName(fileName);
+    if (index == -1) {
+      log::warn("download {} is gone, not installing it", fileName);
+      continue;
+    }
+
+    installDownload(index);
+
+    if (m_InstallationManager.wasCancelled()) {
+      log::debug("installation cancelled, stopping the batch");
+      break;
+    }
+  }
+}
+
+void OrganizerCore::installPendingDownloads()
+{
+  if (m_PendingInstalls.isEmpty()) {
+    return;
+  }
+
+  if (m_InstallBatch || m_InstallationManager.isRunning()) {
+    // this can also be called from the event loop of an installer dialog
+    m_PendingInstallsTimer.start();
+    return;
+  }
+
+  const QString fileName = m_PendingInstalls.takeFirst();
+  const int index = m_DownloadManager.indexByName(fileName);
+
+  if (index == -1) {
+    log::warn("download {} is gone, not installing it", fileName);
+  } else {
+    log::debug("installing finished download {}", fileName);
+    installDownload(index);
+  }
+
+  if (!m_PendingInstalls.isEmpty()) {
+    m_PendingInstallsTimer.start();
+  }
+}
+
+void OrganizerCore::refreshAfterInstall()
+{
+  if (!m_InstallBatch) {
+    refresh();
+    return;
+  }
+
+  // the mod list is needed to find the new mod, the directory structure can
+  // wait
+  m_CurrentProfile->writeModlistNow(true);
+  updateModInfoFromDisc();
+  m_CurrentProfile->refreshModStatus();
+  m_ModList.notifyChange(-1);
+
+  if (++m_InstallBatchPending >= INSTALL_BATCH_REFRESH_INTERVAL
+      && !m_DirectoryUpdate) {
+    m_InstallBatchPending = 0;
+    refreshDirectoryStructure();
+  }
+}
+
 ModInfo::Ptr OrganizerCore::installArchive(
   const QString& archivePath, int priority, bool reinstallation,
   ModInfo::Ptr currentMod, const QString& initModName)
@@ -845,7 +1161,7 @@ ModInfo::Ptr OrganizerCore::installArchive(
   if (result) {
     MessageDialog::showMessage(tr("Installation successful"),
       qApp->activeWindow());
-    refresh();
+    refreshAfterInstall();
 
     int modIndex = ModInfo::getIndex(modName);
     if (modIndex != UINT_MAX) {
@@ -871,6 +1187,7 @@ ModInfo::Ptr OrganizerCore::installArchive(
           modInfo, modIndex, ModInfoTabIDs::IniFiles);
       }
       m_ModList.notifyModInstalled(modInfo.get());
+      ModIntegrity::recordLater({modInfo->name(), modInfo->absolutePath()});
       m_DownloadManager.markInstalled(archivePath);
       m_InstallationManager.notifyInstallationEnd(result, modInfo);
       emit modInstalled(modName);
@@ -931,26 +1248,136 @@ QStringList OrganizerCore::findFiles(
   if (!path.isEmpty() && path != ".")
     dir = dir->findSubDirectoryRecursive(ToWString(path));
   if (dir != nullptr) {
-    std::vector<FileEntryPtr> files = dir->getFiles();
-    for (FileEntryPtr &file: files) {
-      QString fullPath = ToQString(file->getFullPath());
-      if (filter(ToQString(file->getName()))) {
-        result.append(fullPath);
+    // the full path is only built for files that pass the filter, in a
+    // buffer that's reused; same for the name given to the filter, which may
+    // keep it, in which case the buffer is detached by the next name
+    std::wstring fullPath;
+    QString name;
+
+    dir->forEachFile([&](const FileEntry& file) {
+      AssignQString(name, file.getName());
+
+      if (filter(name)) {
+        fullPath.clear();
+        if (file.appendFullPath(fullPath)) {
+          result.append(ToQString(fullPath));
+        }
+      }
+      return true;
+    });
+  }
+  return result;
+}
+
+// the texts of the given filters if they're all like "*text*", with at least
+// one character and no other wildcard
+//
+static std::optional<QStringList> substringFilters(const QStringList& globs)
+{
+  QStringList texts;
+
+  for (auto&& g : globs) {
+    if (g.size() < 3 || !g.startsWith('*') || !g.endsWith('*')) {
+      return {};
+    }
+
+    const QString text = g.mid(1, g.size() - 2);
+
+    for (const QChar c : text) {
+      if (c == '*' || c == '?' || c == '[' || c == ']') {
+        return {};
+      }
+    }
+
+    texts.append(text);
+  }
+
+  return texts;
+}
+
+QStringList OrganizerCore::findFiles(
+  const QStringList &paths, const QStringList &globFilters) const
+{
+  GlobMatcher matcher(globFilters);
+
+  QStringList result;
+  if (matcher.empty()) {
+    return result;
+  }
+
+  std::wstring fullPath;
+
+  // filters like "*text*" only need the names that contain the text, which
+  // the search index has, unless files were added since it was built
+  if (m_SearchIndex && m_SearchIndexCurrent) {
+    if (const auto texts = substringFilters(globFilters)) {
+      std::set<FileIndex> seen;
+
+      for (auto&& path : paths) {
+        for (auto&& text : *texts) {
+          // files that are gone since the index was built are skipped
+          for (auto&& rel : m_SearchIndex->findNames(path, text)) {
+            const FileEntryPtr file =
+              m_DirectoryStructure->searchFile(rel.toStdWString(), nullptr);
+
+            if (!file || !seen.insert(file->getIndex()).second) {
+              continue;
+            }
+
+            fullPath.clear();
+            if (file->appendFullPath(fullPath)) {
+              result.append(ToQString(fullPath));
+            }
+          }
+        }
       }
+
+      return result;
+    }
+  }
+
+  for (auto&& path : paths) {
+    DirectoryEntry *dir = m_DirectoryStructure;
+    if (!path.isEmpty() && path != ".")
+      dir = dir->findSubDirectoryRecursive(ToWString(path));
+
+    if (dir == nullptr) {
+      continue;
     }
+
+    dir->forEachFile([&](const FileEntry& file) {
+      if (matcher.match(file.getName())) {
+        fullPath.clear();
+        if (file.appendFullPath(fullPath)) {
+          result.append(ToQString(fullPath));
+        }
+      }
+
+      return true;
+    });
   }
+
   return result;
 }
 
 QStringList OrganizerCore::getFileOrigins(const QString &fileName) const
 {
+  // the origins of plugins are known by the plugin list, save game plugins
+  // ask for every plugin of a save
+  if (!fileName.contains('/') && !fileName.contains('\\')) {
+    QStringList origins = m_PluginList.providingOrigins(fileName);
+    if (!origins.isEmpty()) {
+      return origins;
+    }
+  }
+
   QStringList result;
   const FileEntryPtr file = m_DirectoryStructure->searchFile(ToWString(fileName), nullptr);
 
   if (file.get() != nullptr) {
     result.append(ToQString(
         m_DirectoryStructure->getOriginByID(file->getOrigin()).getName()));
-    foreach (const auto& i, file->getAlternatives()) {
+    for (const auto& i : file->getAlternatives()) {
       result.append(
           ToQString(m_DirectoryStructure->getOriginByID(i.originID()).getName()));
     }
@@ -968,24 +1395,27 @@ QList<MOBase::IOrganizer::FileInfo> OrganizerCore::findFileInfos(
   if (!path.isEmpty() && path != ".")
     dir = dir->findSubDirectoryRecursive(ToWString(path));
   if (dir != nullptr) {
-    std::vector<FileEntryPtr> files = dir->getFiles();
-    for (FileEntryPtr file : files) {
+    // the filter needs the whole info, but the files are walked in place
+    // instead of copying the list first
+    dir->forEachFile([&](const FileEntry& file) {
       IOrganizer::FileInfo info;
-      info.filePath    = ToQString(file->getFullPath());
+      info.filePath    = ToQString(file.getFullPath());
       bool fromArchive = false;
       info.origins.append(ToQString(
-          m_DirectoryStructure->getOriginByID(file->getOrigin(fromArchive))
+          m_DirectoryStructure->getOriginByID(file.getOrigin(fromArchive))
               .getName()));
-      info.archive = fromArchive ? ToQString(file->getArchive().name()) : "";
-      for (const auto& idx : file->getAlternatives()) {
+      info.archive = fromArchive ? ToQString(file.getArchive().name()) : "";
+      for (const auto& idx : file.getAlternatives()) {
         info.origins.append(
             ToQString(m_DirectoryStructure->getOriginByID(idx.originID()).getName()));
       }
 
       if (filter(info)) {
-        result.append(info);
+        result.append(std::move(info));
       }
-    }
+
+      return true;
+    });
   }
   return result;
 }
@@ -1042,21 +1472,15 @@ bool OrganizerCore::previewFileWithAlternatives(
     return false;
   }
 
-  // set up preview dialog
-  PreviewDialog preview(fileName, parent);
+  // set up preview dialog, previews are generated when they're shown
+  PreviewDialog preview(fileName, m_PluginContainer->previewGenerator(), parent);
 
   auto addFunc = [&](int originId) {
     FilesOrigin &origin = directoryStructure()->getOriginByID(originId);
     QString filePath = QDir::fromNativeSeparators(ToQString(origin.getPath())) + "/" + fileName;
     if (QFile::exists(filePath)) {
       // it's very possible the file doesn't exist, because it's inside an archive. we don't support that
-      QWidget *wid = m_PluginContainer->previewGenerator().genPreview(filePath);
-      if (wid == nullptr) {
-        reportError(tr("failed to generate preview for %1").arg(filePath));
-      }
-      else {
-        preview.addVariant(ToQString(origin.getName()), wid);
-      }
+      preview.addVariant(ToQString(origin.getName()), filePath);
     }
   };
 
@@ -1119,15 +1543,15 @@ bool OrganizerCore::previewFile(
     return false;
   }
 
-  PreviewDialog preview(path, parent);
-
-  QWidget *wid = m_PluginContainer->previewGenerator().genPreview(path);
-  if (wid == nullptr) {
+  if (!m_PluginContainer->previewGenerator().previewSupported(
+    QFileInfo(path).suffix().toLower())) {
     reportError(tr("Failed to generate preview for %1").arg(path));
     return false;
   }
 
-  preview.addVariant(originName, wid);
+  PreviewDialog preview(path, m_PluginContainer->previewGenerator(), parent);
+
+  preview.addVariant(originName, path);
   preview.exec();
 
   return true;
@@ -1187,6 +1611,32 @@ boost::signals2::connection OrganizerCore::onPluginDisabled(std::function<void(c
 
 void OrganizerCore::refresh(bool saveChanges)
 {
+  if (m_DirectoryUpdate) {
+    // the mods can't be read again while the structure is being built, the
+    // whole refresh is done once the current one has finished
+    if (m_PendingRefresh == PendingRefresh::Full) {
+      m_PendingRefreshSave = m_PendingRefreshSave && saveChanges;
+    } else {
+      log::debug("refresh already in progress, queuing a full refresh");
+      m_PendingRefresh = PendingRefresh::Full;
+      m_PendingRefreshSave = saveChanges;
+    }
+
+    return;
+  }
+
+  // this is the queued refresh, if any
+  if (m_PendingRefresh != PendingRefresh::None) {
+    m_PendingRefresh = PendingRefresh::None;
+    m_PendingRefreshSave = true;
+
+    for (auto&& f : m_PendingRefreshCallbacks) {
+      m_RefreshCallbacks.push_back(std::move(f));
+    }
+
+    m_PendingRefreshCallbacks.clear();
+  }
+
   // don't lose changes!
   if (saveChanges) {
     m_CurrentProfile->writeModlistNow(true);
@@ -1202,14 +1652,14 @@ void OrganizerCore::refresh(bool saveChanges)
 
 void OrganizerCore::refreshESPList(bool force)
 {
-  TimeThis tt("OrganizerCore::refreshESPList()");
+  Metrics::Timer tt("OrganizerCore::refreshESPList()");
+  RefreshTrace::Scope scope("OrganizerCore::refreshESPList()");
 
   if (m_DirectoryUpdate) {
     // don't mess up the esp list if we're currently updating the directory
-    // structure
-    m_PostRefreshTasks.append([=]() {
-      this->refreshESPList(force);
-    });
+    // structure, it's refreshed once when it's done
+    m_Deferred |= Deferred::PluginList;
+    m_DeferredPluginListForce = m_DeferredPluginListForce || force;
     return;
   }
   m_CurrentProfile->writeModlist();
@@ -1225,7 +1675,13 @@ void OrganizerCore::refreshESPList(bool force)
 
 void OrganizerCore::refreshBSAList()
 {
-  TimeThis tt("OrganizerCore::refreshBSAList()");
+  refreshBSAList(enabledArchives());
+}
+
+void OrganizerCore::refreshBSAList(const std::vector<QString>& enabled)
+{
+  Metrics::Timer tt("OrganizerCore::refreshBSAList()");
+  RefreshTrace::Scope scope("OrganizerCore::refreshBSAList()");
 
   DataArchives *archives = m_GamePlugin->feature<DataArchives>();
 
@@ -1243,8 +1699,7 @@ void OrganizerCore::refreshBSAList()
 
     m_ActiveArchives.clear();
 
-    auto iter        = enabledArchives();
-    m_ActiveArchives = toStringList(iter.begin(), iter.end());
+    m_ActiveArchives = toStringList(enabled.begin(), enabled.end());
     if (m_ActiveArchives.isEmpty()) {
       m_ActiveArchives = m_DefaultArchives;
     }
@@ -1261,8 +1716,32 @@ void OrganizerCore::refreshBSAList()
 void OrganizerCore::refreshLists()
 {
   if ((m_CurrentProfile != nullptr) && m_DirectoryStructure->isPopulated()) {
-    refreshESPList(true);
-    refreshBSAList();
+    // the plugin list and the models have to be updated on this thread, but
+    // the archive list of the profile doesn't depend on them
+    std::vector<QString> enabled;
+
+    {
+      TaskGroup g(TaskPriority::High);
+
+      if (!settings().archiveParsing()) {
+        // nop
+      } else if (m_EnabledArchives) {
+        enabled = *m_EnabledArchives;
+      } else {
+        g.run([&, path=m_CurrentProfile->getArchivesFileName()] {
+          enabled = readEnabledArchives(path);
+        });
+      }
+
+      refreshESPList(true);
+      g.wait();
+
+      if (settings().archiveParsing() && !m_EnabledArchives) {
+        m_EnabledArchives = enabled;
+      }
+    }
+
+    refreshBSAList(enabled);
   } // no point in refreshing lists if no files have been added to the directory
     // tree
 }
@@ -1274,61 +1753,49 @@ void OrganizerCore::updateModActiveState(int index, bool active)
   updateModsActiveState(modsToUpdate, active);
 }
 
-void OrganizerCore::updateModsActiveState(const QList<unsigned int> &modIndices, bool active)
+int OrganizerCore::setModsPluginsActive(
+  const QList<unsigned int> &modIndices, bool active)
 {
-  int enabled = 0;
+  int changed = 0;
+
+  m_PluginList.blockSignals(true);
+
   for (auto index : modIndices) {
     ModInfo::Ptr modInfo = ModInfo::getByIndex(index);
     QDir dir(modInfo->absolutePath());
-    for (const QString &esm :
-      dir.entryList(QStringList() << "*.esm", QDir::Files)) {
-      const FileEntryPtr file = m_DirectoryStructure->findFile(ToWString(esm));
-      if (file.get() == nullptr) {
-        log::warn("failed to activate {}", esm);
-        continue;
-      }
 
-      if (active != m_PluginList.isEnabled(esm)
-        && file->getAlternatives().empty()) {
-        m_PluginList.blockSignals(true);
-        m_PluginList.enableESP(esm, active);
-        m_PluginList.blockSignals(false);
-      }
-    }
+    // one listing for all plugin types
+    const auto plugins = dir.entryList(
+      QStringList() << "*.esm" << "*.esl" << "*.esp", QDir::Files);
 
-    for (const QString &esl :
-      dir.entryList(QStringList() << "*.esl", QDir::Files)) {
-      const FileEntryPtr file = m_DirectoryStructure->findFile(ToWString(esl));
+    for (const QString &plugin : plugins) {
+      const FileEntryPtr file = m_DirectoryStructure->findFile(ToWString(plugin));
       if (file.get() == nullptr) {
-        log::warn("failed to activate {}", esl);
+        log::warn("failed to activate {}", plugin);
         continue;
       }
 
-      if (active != m_PluginList.isEnabled(esl)
+      if (active != m_PluginList.isEnabled(plugin)
         && file->getAlternatives().empty()) {
-        m_PluginList.blockSignals(true);
-        m_PluginList.enableESP(esl, active);
-        m_PluginList.blockSignals(false);
-        ++enabled;
-      }
-    }
-    QStringList esps = dir.entryList(QStringList() << "*.esp", QDir::Files);
-    for (const QString &esp : esps) {
-      const FileEntryPtr file = m_DirectoryStructure->findFile(ToWString(esp));
-      if (file.get() == nullptr) {
-        log::warn("failed to activate {}", esp);
-        continue;
-      }
+        m_PluginList.enableESP(plugin, active);
 
-      if (active != m_PluginList.isEnabled(esp)
-        && file->getAlternatives().empty()) {
-        m_PluginList.blockSignals(true);
-        m_PluginList.enableESP(esp, active);
-        m_PluginList.blockSignals(false);
-        ++enabled;
+        // masters are not counted
+        if (!plugin.endsWith(".esm", Qt::CaseInsensitive)) {
+          ++changed;
+        }
       }
     }
   }
+
+  m_PluginList.blockSignals(false);
+
+  return changed;
+}
+
+void OrganizerCore::updateModsActiveState(const QList<unsigned int> &modIndices, bool active)
+{
+  const int enabled = setModsPluginsActive(modIndices, active);
+
   if (active && (enabled > 1)) {
     MessageDialog::showMessage(
       tr("Multiple esps/esls activated, please check that they don't conflict."),
@@ -1339,56 +1806,6 @@ void OrganizerCore::updateModsActiveState(const QList<unsigned int> &modIndices,
   m_PluginListsWriter.writeImmediately(false);
 }
 
-void OrganizerCore::updateModInDirectoryStructure(unsigned int index,
-                                                  ModInfo::Ptr modInfo)
-{
-  QMap<unsigned int, ModInfo::Ptr> allModInfo;
-  allModInfo[index] = modInfo;
-  updateModsInDirectoryStructure(allModInfo);
-}
-
-void OrganizerCore::updateModsInDirectoryStructure(QMap<unsigned int, ModInfo::Ptr> modInfo)
-{
-  std::vector<DirectoryRefresher::EntryInfo> entries;
-
-  for (auto idx : modInfo.keys()) {
-    entries.push_back({
-      modInfo[idx]->name(), modInfo[idx]->absolutePath(),
-      modInfo[idx]->stealFiles(), {}, m_CurrentProfile->getModPriority(idx)});
-  }
-
-  m_DirectoryRefresher->addMultipleModsFilesToStructure(
-    m_DirectoryStructure, entries);
-
-  DirectoryRefresher::cleanStructure(m_DirectoryStructure);
-  // need to refresh plugin list now so we can activate esps
-  refreshESPList(true);
-  // activate all esps of the specified mod so the bsas get activated along with
-  // it
-  m_PluginList.blockSignals(true);
-  updateModsActiveState(modInfo.keys(), true);
-  m_PluginList.blockSignals(false);
-  // now we need to refresh the bsa list and save it so there is no confusion
-  // about what archives are available and active
-  refreshBSAList();
-  if (m_UserInterface != nullptr) {
-    m_UserInterface->archivesWriter().writeImmediately(false);
-  }
-
-  std::vector<QString> archives = enabledArchives();
-  m_DirectoryRefresher->setMods(
-    m_CurrentProfile->getActiveMods(),
-    std::set<QString>(archives.begin(), archives.end()));
-
-  // finally also add files from bsas to the directory structure
-  for (auto idx : modInfo.keys()) {
-    m_DirectoryRefresher->addModBSAToStructure(
-      m_DirectoryStructure, modInfo[idx]->name(),
-      m_CurrentProfile->getModPriority(idx), modInfo[idx]->absolutePath(),
-      modInfo[idx]->archives());
-  }
-}
-
 void OrganizerCore::loggedInAction(QWidget* parent, std::function<void ()> f)
 {
   if (NexusInterface::instance().getAccessManager()->validated()) {
@@ -1472,28 +1889,100 @@ IOrganizer const* OrganizerCore::managedGameOrganizer() const
 
 std::vector<QString> OrganizerCore::enabledArchives()
 {
-  std::vector<QString> result;
-  if (settings().archiveParsing()) {
-    QFile archiveFile(m_CurrentProfile->getArchivesFileName());
-    if (archiveFile.open(QIODevice::ReadOnly)) {
-      while (!archiveFile.atEnd()) {
-        result.push_back(QString::fromUtf8(archiveFile.readLine()).trimmed());
-      }
-      archiveFile.close();
+  if (!settings().archiveParsing()) {
+    return {};
+  }
+
+  if (!m_EnabledArchives) {
+    m_EnabledArchives = readEnabledArchives(
+      m_CurrentProfile->getArchivesFileName());
+  }
+
+  return *m_EnabledArchives;
+}
+
+void OrganizerCore::setEnabledArchives(std::vector<QString> archives)
+{
+  if (m_CurrentProfile == nullptr) {
+    return;
+  }
+
+  if (m_EnabledArchives && *m_EnabledArchives == archives) {
+    return;
+  }
+
+  QByteArray content;
+  for (const auto& a : archives) {
+    content.append(a.toUtf8()).append("\r\n");
+  }
+
+  m_ArchivesFileWriter.write(
+    m_CurrentProfile->getArchivesFileName(), std::move(content));
+
+  m_EnabledArchives = std::move(archives);
+}
+
+void OrganizerCore::flushArchives()
+{
+  m_ArchivesFileWriter.flush();
+}
+
+std::vector<QString> OrganizerCore::readEnabledArchives(const QString& path)
+{
+  std::vector<QString> result;
+  QFile archiveFile(path);
+  if (archiveFile.open(QIODevice::ReadOnly)) {
+    while (!archiveFile.atEnd()) {
+      result.push_back(QString::fromUtf8(archiveFile.readLine()).trimmed());
     }
+    archiveFile.close();
   }
   return result;
 }
 
-void OrganizerCore::refreshDirectoryStructure()
+void OrganizerCore::refreshDirectoryStructure(bool invalidateVFS)
 {
+  if (invalidateVFS) {
+    m_USVFS.invalidateMapping();
+  }
+
   if (m_DirectoryUpdate) {
-    log::debug("can't refresh, already in progress");
+    // merged with any other request made until the current one is done
+    if (m_PendingRefresh == PendingRefresh::None) {
+      log::debug("refresh already in progress, queuing another one");
+      m_PendingRefresh = PendingRefresh::Structure;
+    }
+
     return;
   }
 
+  // this is the queued refresh, if any; a queued full refresh still has to
+  // read the mods, so it's left alone
+  if (m_PendingRefresh == PendingRefresh::Structure) {
+    m_PendingRefresh = PendingRefresh::None;
+
+    for (auto&& f : m_PendingRefreshCallbacks) {
+      m_RefreshCallbacks.push_back(std::move(f));
+    }
+
+    m_PendingRefreshCallbacks.clear();
+  }
+
   log::debug("refreshing structure");
-  m_DirectoryUpdate = true;
+  RefreshTrace::begin();
+  StartupTrace::refreshStarted();
+  IoAccounting::beginRefresh();
+
+  m_RefreshStart = std::chrono::steady_clock::now();
+  m_RefreshTimings = {};
+
+  // what changed since the last refresh; the journal is restarted before
+  // walking anything so changes made during the walk are seen next time
+  const auto changes = m_ChangeJournal.stop();
+  m_ChangeJournal.watch(
+    QDir::toNativeSeparators(m_Settings.paths().mods()).toStdWString(), true);
+  m_ChangeJournal.watch(
+    QDir::toNativeSeparators(m_Settings.paths().overwrite()).toStdWString(), false);
 
   m_CurrentProfile->writeModlistNow(true);
   const auto activeModList = m_CurrentProfile->getActiveMods();
@@ -1502,14 +1991,194 @@ void OrganizerCore::refreshDirectoryStructure()
   m_DirectoryRefresher->setMods(
       activeModList, std::set<QString>(archives.begin(), archives.end()));
 
+  // only the origins that changed on disk are walked again if possible, which
+  // is much faster than a full refresh for large setups
+  //
+  // views must keep seeing the structure as it was when they were created, so
+  // it's only updated in place when nothing holds it; otherwise, a new one is
+  // built in the background and swapped in, like a full refresh
+  const auto incrementalStart = std::chrono::steady_clock::now();
+  const bool shared = structureShared();
+
+  if (shared) {
+    log::debug("structure is held by views, building a new one");
+  }
+
+  if (!shared && m_DirectoryRefresher->refreshIncremental(
+    m_DirectoryStructure, changes ? &*changes : nullptr)) {
+    m_RefreshTimings.incremental = true;
+    m_RefreshTimings.phases.push_back({
+      "incremental", std::chrono::steady_clock::now() - incrementalStart});
+
+    finishDirectoryRefresh();
+    return;
+  }
+
+  m_DirectoryUpdate = true;
+
   // runs refresh() in a thread
   QTimer::singleShot(0, m_DirectoryRefresher.get(), SLOT(refresh()));
 }
 
+void OrganizerCore::saveStructureSnapshot()
+{
+  if (!m_CurrentProfile || m_DirectoryUpdate) {
+    // a refresh is in progress, the structure is about to be replaced
+    return;
+  }
+
+  if (!m_DirectoryStructure->isPopulated()) {
+    return;
+  }
+
+  DirectorySnapshot::write(
+    *m_DirectoryStructure,
+    m_CurrentProfile->getStructureSnapshotFileName().toStdWString());
+}
+
+void OrganizerCore::restoreStructureSnapshot()
+{
+  auto root = DirectorySnapshot::read(
+    m_CurrentProfile->getStructureSnapshotFileName().toStdWString());
+
+  if (!root) {
+    return;
+  }
+
+  if (!retireStructure()) {
+    delete m_DirectoryStructure;
+  }
+
+  m_DirectoryStructure = root.release();
+}
+
+bool OrganizerCore::retireStructure()
+{
+  auto pin = std::move(m_StructurePin);
+
+  if (!pin || pin->root() != m_DirectoryStructure) {
+    return false;
+  }
+
+  if (pin.use_count() == 1) {
+    // no views, the pin is destroyed without deleting the structure
+    return false;
+  }
+
+  // views are only created on this thread, but they can be released on
+  // others; if the last one was released after the check above, the structure
+  // is deleted when `pin` goes out of scope
+  pin->retire();
+
+  return true;
+}
+
+bool OrganizerCore::structureShared() const
+{
+  // views may be released on other threads, so this can return true for a
+  // view that's just been released, which only costs a full refresh
+  return
+    m_StructurePin &&
+    m_StructurePin->root() == m_DirectoryStructure &&
+    m_StructurePin.use_count() > 1;
+}
+
+std::vector<OrganizerCore::FileSearchMatch> OrganizerCore::searchFiles(
+  const QString& text, std::size_t max, bool* truncated) const
+{
+  if (truncated) {
+    *truncated = false;
+  }
+
+  if (!m_SearchIndex || !m_DirectoryStructure) {
+    return {};
+  }
+
+  std::vector<FileSearchMatch> matches;
+
+  // the index may be older than the structure, files that are gone are
+  // skipped
+  for (const auto& path : m_SearchIndex->find(text, max, truncated)) {
+    const FileEntryPtr file =
+      m_DirectoryStructure->searchFile(path.toStdWString(), nullptr);
+
+    if (!file) {
+      continue;
+    }
+
+    FileSearchMatch m;
+    m.path = QString::fromStdWString(file->getRelativePath());
+
+    if (m.path.startsWith('\\')) {
+      m.path.remove(0, 1);
+    }
+
+    m.origin = ToQString(
+      m_DirectoryStructure->getOriginByID(file->getOrigin()).getName());
+
+    for (const auto& alt : file->getAlternatives()) {
+      m.alternatives.append(ToQString(
+        m_DirectoryStructure->getOriginByID(alt.originID()).getName()));
+    }
+
+    matches.push_back(std::move(m));
+  }
+
+  return matches;
+}
+
+void OrganizerCore::updateSearchIndex()
+{
+  m_SearchIndexCurrent = false;
+
+  auto view = structureView();
+  if (!view.valid()) {
+    return;
+  }
+
+  const int generation = ++*m_SearchIndexGeneration;
+  auto current = m_SearchIndexGeneration;
+
+  TaskExecutor::instance().post(TaskPriority::Low, [this, view, current, generation] {
+    auto index = FileSearchIndex::build(
+      view, [&]{ return (*current != generation); });
+
+    if (!index) {
+      return;
+    }
+
+    QMetaObject::invokeMethod(this, [this, index, current, generation] {
+      // files were added in the meantime, another index is being built
+      if (*current != generation) {
+        return;
+      }
+
+      m_SearchIndex = index;
+      m_SearchIndexCurrent = true;
+
+      emit fileSearchIndexChanged();
+    }, Qt::QueuedConnection);
+  });
+}
+
+StructureView OrganizerCore::structureView() const
+{
+  if (!m_DirectoryStructure) {
+    return {};
+  }
+
+  if (!m_StructurePin || m_StructurePin->root() != m_DirectoryStructure) {
+    m_StructurePin = std::make_shared<StructureView::Pin>(m_DirectoryStructure);
+  }
+
+  return StructureView(m_StructurePin);
+}
+
 void OrganizerCore::directory_refreshed()
 {
   log::debug("directory refreshed, finishing up");
-  TimeThis tt("OrganizerCore::directory_refreshed()");
+  Metrics::Timer tt("OrganizerCore::directory_refreshed()");
+  RefreshTrace::Scope scope("OrganizerCore::directory_refreshed()");
 
   DirectoryEntry *newStructure = m_DirectoryRefresher->stealDirectoryStructure();
   Q_ASSERT(newStructure != m_DirectoryStructure);
@@ -1520,44 +2189,232 @@ void OrganizerCore::directory_refreshed()
     return;
   }
 
+  // views on the old structure keep it alive and delete it themselves
+  const bool pinned = retireStructure();
+
   std::swap(m_DirectoryStructure, newStructure);
 
-  if (m_StructureDeleter.joinable()) {
-    m_StructureDeleter.join();
+  if (!pinned) {
+    // queued behind any structure that's still being deleted
+    m_StructureDeleter->run([newStructure]{
+      log::debug("structure deleter start");
+      delete newStructure;
+      log::debug("structure deleter done");
+    });
   }
 
-  m_StructureDeleter = MOShared::startSafeThread([=]{
-    log::debug("structure deleter thread start");
-    delete newStructure;
-    log::debug("structure deleter thread done");
-  });
-
   m_DirectoryUpdate = false;
 
+  const auto& phases = m_DirectoryRefresher->phases();
+  m_RefreshTimings.phases.assign(phases.begin(), phases.end());
+
+  finishDirectoryRefresh();
+}
+
+void OrganizerCore::finishDirectoryRefresh()
+{
+  const auto listsStart = std::chrono::steady_clock::now();
+
   log::debug("clearing caches");
   for (int i = 0; i < m_ModList.rowCount(); ++i) {
     ModInfo::Ptr modInfo = ModInfo::getByIndex(i);
     modInfo->clearCaches();
   }
 
-  if (!m_PostRefreshTasks.empty()) {
-    log::debug("running {} post refresh tasks", m_PostRefreshTasks.size());
+  const auto deferred = m_Deferred;
+  const bool force = m_DeferredPluginListForce;
 
-    for (auto task : m_PostRefreshTasks) {
-      task();
+  m_Deferred = Deferred::None;
+  m_DeferredPluginListForce = false;
+
+  if (m_CurrentProfile != nullptr) {
+    if (m_DirectoryStructure->isPopulated()) {
+      // this also takes care of any deferred refresh of the plugin list,
+      // always forced
+      log::debug("refreshing lists");
+      refreshLists();
+    } else if (deferred.testFlag(Deferred::PluginList)) {
+      refreshESPList(force);
     }
 
-    m_PostRefreshTasks.clear();
-  }
+    if (deferred.testFlag(Deferred::SavePluginList)) {
+      log::debug("saving plugin list");
+      savePluginList();
+    }
 
-  if (m_CurrentProfile != nullptr) {
-    log::debug("refreshing lists");
-    refreshLists();
+    if (deferred.testFlag(Deferred::ModPriorities)) {
+      log::debug("applying mod priorities changed during the refresh");
+
+      QModelIndexList all;
+      for (int i=0; i<m_ModList.rowCount(); ++i) {
+        all.append(m_ModList.index(i, 0));
+      }
+
+      modPrioritiesChanged(all);
+    }
+
+    if (deferred.testFlag(Deferred::ModStatus)) {
+      applyDeferredModStatus();
+    }
   }
 
+  m_DeferredModStatus.clear();
+
   emit directoryStructureReady();
 
+  updateSearchIndex();
+
+  const auto now = std::chrono::steady_clock::now();
+  m_RefreshTimings.phases.push_back({"lists", now - listsStart});
+  m_RefreshTimings.total = now - m_RefreshStart;
+  m_RefreshTimings.time = QDateTime::currentDateTime();
+
+  Metrics::setInstanceSize(
+    static_cast<int>(ModInfo::getNumMods()),
+    m_DirectoryStructure->getFileRegister()->highestCount());
+
+  for (auto&& [name, d] : m_RefreshTimings.phases) {
+    Metrics::duration("refresh." + name, d);
+  }
+
+  // incremental refreshes have a single refresh.incremental phase
+  Metrics::duration("refresh", m_RefreshTimings.total);
+
+  m_LastRefreshTimings = std::move(m_RefreshTimings);
+  m_RefreshTimings = {};
+
+  RefreshTrace::finish();
+  IoAccounting::endRefresh();
+
+  if (const auto io=IoAccounting::lastRefresh()) {
+    for (std::size_t i=0; i<io->size(); ++i) {
+      const auto& c = (*io)[i];
+      if (c.empty()) {
+        continue;
+      }
+
+      log::debug(
+        "refresh io, {}: {} opens, {} stats, {} enumerations, {} bytes",
+        IoAccounting::name(static_cast<IoAccounting::Subsystem>(i)),
+        c.opens, c.stats, c.enumerations, c.bytesRead);
+    }
+  }
+
   log::debug("refresh done");
+
+  // does nothing after the first refresh
+  StartupTrace::finish();
+
+  // after anything connected to directoryStructureReady had a chance to run
+  QTimer::singleShot(0, this, [this]{ prewarmVFS(); });
+
+  auto callbacks = std::move(m_RefreshCallbacks);
+  m_RefreshCallbacks.clear();
+
+  for (auto&& f : callbacks) {
+    f();
+  }
+
+  if (m_PendingRefresh != PendingRefresh::None) {
+    // started from the event loop so this refresh is completely done first
+    QTimer::singleShot(0, this, [this]{ startPendingRefresh(); });
+  }
+}
+
+void OrganizerCore::applyDeferredModStatus()
+{
+  // a mod that was toggled back is already right in the new structure
+  QList<unsigned int> changed;
+
+  for (auto idx : m_DeferredModStatus) {
+    if (idx >= m_CurrentProfile->numMods()) {
+      continue;
+    }
+
+    const auto name = ToWString(ModInfo::getByIndex(idx)->name());
+
+    const bool inStructure =
+      m_DirectoryStructure->originExists(name) &&
+      !m_DirectoryStructure->getOriginByName(name).isDisabled();
+
+    if (inStructure != m_CurrentProfile->modEnabled(idx)) {
+      changed.append(idx);
+    }
+  }
+
+  if (!changed.isEmpty()) {
+    log::debug(
+      "applying {} mod states changed during the refresh", changed.size());
+
+    modStatusChanged(changed);
+  }
+}
+
+void OrganizerCore::startPendingRefresh()
+{
+  if (m_DirectoryUpdate) {
+    // started by something else in the meantime, this will be called again
+    // once it's done
+    return;
+  }
+
+  switch (m_PendingRefresh)
+  {
+    case PendingRefresh::Full:
+      log::debug("starting queued full refresh");
+      refresh(m_PendingRefreshSave);
+      break;
+
+    case PendingRefresh::Structure:
+      log::debug("starting queued refresh");
+      refreshDirectoryStructure();
+      break;
+
+    case PendingRefresh::None:
+    default:
+      // already started by a new request
+      break;
+  }
+}
+
+void OrganizerCore::whenRefreshed(std::function<void ()> f)
+{
+  if (m_PendingRefresh != PendingRefresh::None) {
+    m_PendingRefreshCallbacks.push_back(std::move(f));
+  } else if (m_DirectoryUpdate) {
+    m_RefreshCallbacks.push_back(std::move(f));
+  } else {
+    f();
+  }
+}
+
+bool OrganizerCore::refreshing() const
+{
+  return m_DirectoryUpdate || (m_PendingRefresh != PendingRefresh::None);
+}
+
+void OrganizerCore::waitForRefresh()
+{
+  if (!refreshing()) {
+    return;
+  }
+
+  QEventLoop loop;
+  bool done = false;
+
+  whenRefreshed([&] {
+    done = true;
+    loop.quit();
+  });
+
+  if (!done) {
+    loop.exec();
+  }
+}
+
+const OrganizerCore::RefreshTimings& OrganizerCore::lastRefreshTimings() const
+{
+  return m_LastRefreshTimings;
 }
 
 void OrganizerCore::profileRefresh()
@@ -1567,6 +2424,30 @@ void OrganizerCore::profileRefresh()
 
 void OrganizerCore::modPrioritiesChanged(const QModelIndexList& indices)
 {
+  if (m_DirectoryUpdate) {
+    // the structure is about to be replaced, the priorities are applied to
+    // the new one
+    m_Deferred |= Deferred::ModPriorities;
+    currentProfile()->writeModlist();
+    return;
+  }
+
+  auto& conflicts = directoryStructure()->getFileRegister()->conflicts();
+
+  // only the conflicts of the moved mods change, the other mods keep their
+  // relative priorities
+  std::vector<OriginID> moved;
+  for (auto& idx : indices) {
+    ModInfo::Ptr modInfo = ModInfo::getByIndex(idx.data(ModList::IndexRole).toInt());
+    const auto name = MOBase::ToWString(modInfo->internalName());
+
+    if (directoryStructure()->originExists(name)) {
+      moved.push_back(directoryStructure()->getOriginByName(name).getID());
+    }
+  }
+
+  conflicts.exclude(moved);
+
   for (unsigned int i = 0; i < currentProfile()->numMods(); ++i) {
     int priority = currentProfile()->getModPriority(i);
     if (currentProfile()->modEnabled(i)) {
@@ -1577,75 +2458,34 @@ void OrganizerCore::modPrioritiesChanged(const QModelIndexList& indices)
   }
   refreshBSAList();
   currentProfile()->writeModlist();
-  directoryStructure()->getFileRegister()->sortOrigins();
 
-  for (auto& idx : indices) {
-    ModInfo::Ptr modInfo = ModInfo::getByIndex(idx.data(ModList::IndexRole).toInt());
-    // clear caches on all mods conflicting with the moved mod
-    for (int i : modInfo->getModOverwrite()) {
-      ModInfo::getByIndex(i)->clearCaches();
-    }
-    for (int i : modInfo->getModOverwritten()) {
-      ModInfo::getByIndex(i)->clearCaches();
-    }
-    for (int i : modInfo->getModArchiveOverwrite()) {
-      ModInfo::getByIndex(i)->clearCaches();
-    }
-    for (int i : modInfo->getModArchiveOverwritten()) {
-      ModInfo::getByIndex(i)->clearCaches();
-    }
-    for (int i : modInfo->getModArchiveLooseOverwrite()) {
-      ModInfo::getByIndex(i)->clearCaches();
-    }
-    for (int i : modInfo->getModArchiveLooseOverwritten()) {
-      ModInfo::getByIndex(i)->clearCaches();
-    }
-    // update conflict check on the moved mod
-    modInfo->doConflictCheck();
-  }
+  // the other mods only shifted, so only the files of the moved mods can have
+  // a different order
+  directoryStructure()->getFileRegister()->sortOrigins(moved);
+
+  conflicts.include(moved);
 }
 
 void OrganizerCore::modStatusChanged(unsigned int index)
 {
-  try {
-    ModInfo::Ptr modInfo = ModInfo::getByIndex(index);
-    if (m_CurrentProfile->modEnabled(index)) {
-      updateModInDirectoryStructure(index, modInfo);
-    } else {
-      updateModActiveState(index, false);
-      if (m_DirectoryStructure->originExists(ToWString(modInfo->name()))) {
-        FilesOrigin &origin
-            = m_DirectoryStructure->getOriginByName(ToWString(modInfo->name()));
-        origin.enable(false);
-      }
-      if (m_UserInterface != nullptr) {
-        m_UserInterface->archivesWriter().write();
-      }
-    }
-    modInfo->clearCaches();
-
-    for (unsigned int i = 0; i < m_CurrentProfile->numMods(); ++i) {
-      ModInfo::Ptr modInfo = ModInfo::getByIndex(i);
-      int priority = m_CurrentProfile->getModPriority(i);
-      if (m_DirectoryStructure->originExists(ToWString(modInfo->name()))) {
-        // priorities in the directory structure are one higher because data is
-        // 0
-        m_DirectoryStructure->getOriginByName(ToWString(modInfo->name()))
-            .setPriority(priority + 1);
-      }
-    }
-    m_DirectoryStructure->getFileRegister()->sortOrigins();
-
-    refreshLists();
+  modStatusChanged(QList<unsigned int>{ index });
+}
 
-    m_ModList.notifyModStateChanged({ index });
+void OrganizerCore::modStatusChanged(QList<unsigned int> index) {
+  // this applies all the changes at once, however many mods changed: the
+  // files of the enabled mods are added to the structure in parallel, and the
+  // plugin and archive lists are refreshed and written only once
+  Metrics::Timer tt("OrganizerCore::modStatusChanged()");
 
-  } catch (const std::exception &e) {
-    reportError(tr("failed to update mod list: %1").arg(e.what()));
+  if (m_DirectoryUpdate) {
+    // the structure is about to be replaced, the changes are applied to the
+    // new one
+    m_Deferred |= Deferred::ModStatus;
+    m_DeferredModStatus.insert(index.begin(), index.end());
+    m_ModList.notifyModStateChanged(index);
+    return;
   }
-}
 
-void OrganizerCore::modStatusChanged(QList<unsigned int> index) {
   try {
     QMap<unsigned int, ModInfo::Ptr> modsToEnable;
     QMap<unsigned int, ModInfo::Ptr> modsToDisable;
@@ -1656,24 +2496,41 @@ void OrganizerCore::modStatusChanged(QList<unsigned int> index) {
         modsToDisable[idx] = ModInfo::getByIndex(idx);
       }
     }
-    if (!modsToEnable.isEmpty()) {
-      updateModsInDirectoryStructure(modsToEnable);
-      for (auto modInfo : modsToEnable.values()) {
-        modInfo->clearCaches();
-      }
-    }
+
+    int pluginsChanged = 0;
+
     if (!modsToDisable.isEmpty()) {
-      updateModsActiveState(modsToDisable.keys(), false);
+      // while the files of the mods can still be found
+      setModsPluginsActive(modsToDisable.keys(), false);
+
+      std::vector<OriginID> disabled;
+
       for (auto idx : modsToDisable.keys()) {
         if (m_DirectoryStructure->originExists(ToWString(modsToDisable[idx]->name()))) {
           FilesOrigin &origin
             = m_DirectoryStructure->getOriginByName(ToWString(modsToDisable[idx]->name()));
+          disabled.push_back(origin.getID());
           origin.enable(false);
         }
       }
-      if (m_UserInterface != nullptr) {
-        m_UserInterface->archivesWriter().write();
+
+      m_DirectoryStructure->getFileRegister()->conflicts().exclude(disabled);
+    }
+
+    if (!modsToEnable.isEmpty()) {
+      std::vector<DirectoryRefresher::EntryInfo> entries;
+
+      for (auto idx : modsToEnable.keys()) {
+        entries.push_back({
+          modsToEnable[idx]->name(), modsToEnable[idx]->absolutePath(),
+          modsToEnable[idx]->stealFiles(), {}, m_CurrentProfile->getModPriority(idx)});
       }
+
+      m_DirectoryRefresher->addMultipleModsFilesToStructure(
+        m_DirectoryStructure, entries);
+
+      DirectoryRefresher::cleanStructure(m_DirectoryStructure);
+      updateSearchIndex();
     }
 
     for (unsigned int i = 0; i < m_CurrentProfile->numMods(); ++i) {
@@ -1688,7 +2545,64 @@ void OrganizerCore::modStatusChanged(QList<unsigned int> index) {
     }
     m_DirectoryStructure->getFileRegister()->sortOrigins();
 
-    refreshLists();
+    std::vector<OriginID> enabled;
+    for (auto modInfo : modsToEnable.values()) {
+      if (m_DirectoryStructure->originExists(ToWString(modInfo->name()))) {
+        enabled.push_back(
+          m_DirectoryStructure->getOriginByName(ToWString(modInfo->name())).getID());
+      }
+    }
+    m_DirectoryStructure->getFileRegister()->conflicts().include(enabled);
+
+    if ((m_CurrentProfile != nullptr) && m_DirectoryStructure->isPopulated()) {
+      // the plugins of the enabled mods have to be in the list before they
+      // can be activated
+      refreshESPList(true);
+
+      if (!modsToEnable.isEmpty()) {
+        pluginsChanged = setModsPluginsActive(modsToEnable.keys(), true);
+      }
+
+      m_PluginList.refreshLoadOrder();
+      m_PluginListsWriter.writeImmediately(false);
+
+      // the archives of the enabled mods get activated along with their
+      // plugins
+      refreshBSAList();
+
+      if (m_UserInterface != nullptr) {
+        m_UserInterface->archivesWriter().writeImmediately(false);
+      }
+    }
+
+    if (!modsToEnable.isEmpty()) {
+      // finally also add files from bsas to the directory structure
+      std::vector<QString> archives = enabledArchives();
+      m_DirectoryRefresher->setMods(
+        m_CurrentProfile->getActiveMods(),
+        std::set<QString>(archives.begin(), archives.end()));
+
+      for (auto idx : modsToEnable.keys()) {
+        m_DirectoryRefresher->addModBSAToStructure(
+          m_DirectoryStructure, modsToEnable[idx]->name(),
+          m_CurrentProfile->getModPriority(idx), modsToEnable[idx]->absolutePath(),
+          modsToEnable[idx]->archives());
+      }
+    }
+
+    for (auto modInfo : modsToEnable.values()) {
+      modInfo->clearCaches();
+    }
+
+    for (auto modInfo : modsToDisable.values()) {
+      modInfo->clearCaches();
+    }
+
+    if (pluginsChanged > 1) {
+      MessageDialog::showMessage(
+        tr("Multiple esps/esls activated, please check that they don't conflict."),
+        qApp->activeWindow());
+    }
 
     m_ModList.notifyModStateChanged(index);
   } catch (const std::exception &e) {
@@ -1765,10 +2679,91 @@ void OrganizerCore::syncOverwrite()
   SyncOverwriteDialog syncDialog(modInfo->absolutePath(), m_DirectoryStructure,
                                  qApp->activeWindow());
   if (syncDialog.exec() == QDialog::Accepted) {
-    syncDialog.apply(QDir::fromNativeSeparators(m_Settings.paths().mods()));
+    // the structure is patched below unless views hold it, in which case it's
+    // refreshed instead
+    const bool patch = !m_DirectoryUpdate && !structureShared();
+
+    startDisableDirWatcher();
+    const auto origins = syncDialog.apply(
+      QDir::fromNativeSeparators(m_Settings.paths().mods()), patch);
+    endDisableDirWatcher();
+
     modInfo->diskContentModified();
-    refreshDirectoryStructure();
+
+    for (const auto& name : origins) {
+      const unsigned int index = ModInfo::getIndex(name);
+      if (index != UINT_MAX) {
+        ModInfo::getByIndex(index)->diskContentModified();
+      }
+    }
+
+    if (!patch) {
+      // the structure is about to be replaced, or must be left alone
+      refreshDirectoryStructure();
+      return;
+    }
+
+    // the moved files have been removed from the overwrite origin, there's
+    // no need to walk anything again
+    DirectoryRefresher::cleanStructure(m_DirectoryStructure);
+    m_USVFS.invalidateMapping();
+    refreshLists();
+
+    emit directoryStructureReady();
+  }
+}
+
+void OrganizerCore::startDisableDirWatcher()
+{
+  m_DirWatcherSuppression.start();
+}
+
+void OrganizerCore::endDisableDirWatcher()
+{
+  m_DirWatcherSuppression.end();
+}
+
+void OrganizerCore::onWatchedFilesChanged(
+  const QString& root, const QStringList& paths)
+{
+  if (!m_CurrentProfile) {
+    return;
+  }
+
+  // meta.ini files are written by MO all the time and don't change the
+  // structure
+  const bool onlyMeta = !paths.isEmpty() && std::all_of(
+    paths.begin(), paths.end(), [](const QString& p) {
+      return p.count('\\') <= 1 && p.endsWith("meta.ini");
+    });
+
+  if (onlyMeta) {
+    return;
+  }
+
+  // programs running in the vfs write to overwrite all the time, the
+  // structure is refreshed when they exit
+  if (m_UILocker.locked()) {
+    return;
+  }
+
+  const auto running = getRunningUSVFSProcesses();
+  for (auto&& h : running) {
+    ::CloseHandle(h);
+  }
+
+  if (!running.empty()) {
+    return;
   }
+
+  if (paths.isEmpty()) {
+    log::debug("changes were lost in '{}', refreshing", root);
+  } else {
+    log::debug(
+      "{} change(s) in '{}' made outside of MO, refreshing", paths.size(), root);
+  }
+
+  refreshDirectoryStructure();
 }
 
 QString OrganizerCore::oldMO1HookDll() const
@@ -1794,11 +2789,37 @@ std::vector<unsigned int> OrganizerCore::activeProblems() const
     log::warn("hook.dll found in game folder: {}", hookdll);
     problems.push_back(PROBLEM_MO1SCRIPTEXTENDERWORKAROUND);
   }
+
+  const auto sanityProblems = sanity::problems();
+  for (std::size_t i=0; i<sanityProblems.size(); ++i) {
+    problems.push_back(PROBLEM_SANITYCHECKS + static_cast<unsigned int>(i));
+  }
+
   return problems;
 }
 
+std::optional<sanity::Problem> OrganizerCore::sanityProblem(unsigned int key)
+{
+  if (key < PROBLEM_SANITYCHECKS) {
+    return {};
+  }
+
+  const auto problems = sanity::problems();
+  const auto i = static_cast<std::size_t>(key - PROBLEM_SANITYCHECKS);
+
+  if (i >= problems.size()) {
+    return {};
+  }
+
+  return problems[i];
+}
+
 QString OrganizerCore::shortDescription(unsigned int key) const
 {
+  if (auto p=sanityProblem(key)) {
+    return p->shortDescription;
+  }
+
   switch (key) {
     case PROBLEM_MO1SCRIPTEXTENDERWORKAROUND: {
       return tr("MO1 \"Script Extender\" load mechanism has left hook.dll in your game folder");
@@ -1811,6 +2832,10 @@ QString OrganizerCore::shortDescription(unsigned int key) const
 
 QString OrganizerCore::fullDescription(unsigned int key) const
 {
+  if (auto p=sanityProblem(key)) {
+    return p->fullDescription;
+  }
+
   switch (key) {
     case PROBLEM_MO1SCRIPTEXTENDERWORKAROUND: {
       return tr("<a href=\"%1\">hook.dll</a> has been found in your game folder (right click to copy the full path). "
@@ -1857,13 +2882,43 @@ void OrganizerCore::savePluginList()
 {
   if (m_DirectoryUpdate) {
     // delay save till after directory update
-    m_PostRefreshTasks.append([this]() {
-      this->savePluginList();
-    });
+    m_Deferred |= Deferred::SavePluginList;
     return;
   }
   m_PluginList.saveTo(m_CurrentProfile->getLockedOrderFileName());
   m_PluginList.saveLoadOrder(*m_DirectoryStructure);
+
+  updateArchiveOrders();
+}
+
+void OrganizerCore::updateArchiveOrders()
+{
+  if (!m_DirectoryStructure->isPopulated()) {
+    return;
+  }
+
+  GamePlugins* gamePlugins = managedGame()->feature<GamePlugins>();
+  if (!gamePlugins) {
+    return;
+  }
+
+  std::vector<std::wstring> loadOrder;
+  for (auto&& s : gamePlugins->getLoadOrder()) {
+    loadOrder.push_back(s.toStdWString());
+  }
+
+  auto& reg = *m_DirectoryStructure->getFileRegister();
+
+  if (structureShared()) {
+    if (reg.archiveOrdersChanged(loadOrder)) {
+      // views hold the structure, a new one is built with the new orders
+      refreshDirectoryStructure();
+    }
+
+    return;
+  }
+
+  reg.setArchiveOrders(loadOrder);
 }
 
 void OrganizerCore::saveCurrentProfile()
@@ -1872,10 +2927,26 @@ void OrganizerCore::saveCurrentProfile()
     return;
   }
 
-  m_CurrentProfile->writeModlist();
-  m_CurrentProfile->createTweakedIniFile();
-  saveCurrentLists();
-  storeSettings();
+  // these are stages of a launch when called from beforeRun()
+  {
+    LaunchTimeline::Stage s("mod list");
+    m_CurrentProfile->writeModlist();
+  }
+
+  {
+    LaunchTimeline::Stage s("tweaked ini");
+    m_CurrentProfile->createTweakedIniFile();
+  }
+
+  {
+    LaunchTimeline::Stage s("save lists");
+    saveCurrentLists();
+  }
+
+  {
+    LaunchTimeline::Stage s("settings");
+    storeSettings();
+  }
 }
 
 ProcessRunner OrganizerCore::processRunner()
@@ -1890,29 +2961,56 @@ bool OrganizerCore::beforeRun(
 {
   saveCurrentProfile();
 
-  // need to wait until directory structure is ready
-  if (m_DirectoryUpdate) {
-    QEventLoop loop;
-    connect(this, &OrganizerCore::directoryStructureReady, &loop, &QEventLoop::quit,
-      Qt::ConnectionType::QueuedConnection);
-    loop.exec();
+  {
+    // need to wait until directory structure is ready, including a refresh
+    // that was queued
+    LaunchTimeline::Stage s("wait for refresh");
+    waitForRefresh();
   }
 
-  // need to make sure all data is saved before we start the application
-  if (m_CurrentProfile != nullptr) {
-    m_CurrentProfile->writeModlistNow(true);
+  {
+    // need to make sure all data is saved before we start the application
+    LaunchTimeline::Stage s("flush writes");
+
+    if (m_CurrentProfile != nullptr) {
+      m_CurrentProfile->writeModlistNow(true);
+    }
+
+    m_PluginListsWriter.writeImmediately(true);
+    m_PluginList.flushWrites();
+
+    if (m_UserInterface != nullptr) {
+      m_UserInterface->archivesWriter().writeImmediately(true);
+    }
+
+    flushArchives();
   }
 
-  // TODO: should also pass arguments
-  if (!m_AboutToRun(binary.absoluteFilePath())) {
-    log::debug("start of \"{}\" cancelled by plugin", binary.absoluteFilePath());
-    return false;
+  {
+    // TODO: should also pass arguments
+    LaunchTimeline::Stage s("plugins");
+
+    if (!m_AboutToRun(binary.absoluteFilePath())) {
+      log::debug("start of \"{}\" cancelled by plugin", binary.absoluteFilePath());
+      return false;
+    }
   }
 
   try
   {
-    m_USVFS.updateMapping(fileMapping(profileName, customOverwrite));
-    m_USVFS.updateForcedLibraries(forcedLibraries);
+    LaunchTimeline::Stage mappingStage("file mapping");
+    const auto mapping = fileMapping(profileName, customOverwrite);
+    mappingStage.stop();
+
+    {
+      LaunchTimeline::Stage s("usvfs mapping");
+      m_USVFS.updateMapping(mapping);
+    }
+
+    {
+      LaunchTimeline::Stage s("forced libraries");
+      m_USVFS.updateForcedLibraries(forcedLibraries);
+    }
   }
   catch (const UsvfsConnectorException &e)
   {
@@ -1942,7 +3040,8 @@ void OrganizerCore::afterRun(const QFileInfo& binary, DWORD exitCode)
     QFile::remove(m_CurrentProfile->getLoadOrderFileName());
   }
 
-  refreshDirectoryStructure();
+  // everything the program changed went through usvfs
+  refreshDirectoryStructure(false);
 
   refreshESPList(true);
   savePluginList();
@@ -1962,16 +3061,20 @@ std::vector<Mapping> OrganizerCore::fileMapping(const QString &profileName,
                                                 const QString &customOverwrite)
 {
   // need to wait until directory structure is ready
-  if (m_DirectoryUpdate) {
-    QEventLoop loop;
-    connect(this, &OrganizerCore::directoryStructureReady, &loop, &QEventLoop::quit,
-      Qt::ConnectionType::QueuedConnection);
-    loop.exec();
-  }
+  waitForRefresh();
 
   IPluginGame *game  = qApp->property("managed_game").value<IPluginGame *>();
-  Profile profile(QDir(m_Settings.paths().profiles() + "/" + profileName),
-                  game);
+
+  // the current profile has just been saved, only other profiles have to be
+  // read from disk
+  std::unique_ptr<Profile> other;
+  Profile* profile = m_CurrentProfile.get();
+
+  if (!profile || profile->name() != profileName) {
+    other = std::make_unique<Profile>(
+      QDir(m_Settings.paths().profiles() + "/" + profileName), game);
+    profile = other.get();
+  }
 
   MappingType result;
 
@@ -1980,7 +3083,7 @@ std::vector<Mapping> OrganizerCore::fileMapping(const QString &profileName,
 
   bool overwriteActive = false;
 
-  for (const auto& mod : profile.getActiveMods()) {
+  for (const auto& mod : profile->getActiveMods()) {
     if (std::get<0>(mod).compare("overwrite", Qt::CaseInsensitive) == 0) {
       continue;
     }
@@ -2026,7 +3129,14 @@ std::vector<Mapping> OrganizerCore::fileMapping(const QString &profileName,
        m_PluginContainer->plugins<MOBase::IPluginFileMapper>()) {
     IPlugin *plugin = dynamic_cast<IPlugin *>(mapper);
     if (m_PluginContainer->isEnabled(plugin)) {
-      MappingType pluginMap = mapper->mappings();
+      MappingType pluginMap;
+
+      {
+        // this is done every time a program is started
+        PluginCallTimer t(plugin, "mappings");
+        pluginMap = mapper->mappings();
+      }
+
       result.reserve(result.size() + pluginMap.size());
       result.insert(result.end(), pluginMap.begin(), pluginMap.end());
     }
@@ -2036,11 +3146,25 @@ std::vector<Mapping> OrganizerCore::fileMapping(const QString &profileName,
 }
 
 
-std::vector<Mapping> OrganizerCore::fileMapping(
-    const QString &dataPath, const QString &relPath, const DirectoryEntry *base,
-    const DirectoryEntry *directoryEntry, int createDestination)
+// returned by addFileMappings() when a directory has no loose files outside
+// of the data directory, or when they come from more than one origin
+static const int NoOrigin = -1;
+static const int MixedOrigins = -2;
+
+static int addFileMappings(
+  const QString &dataPath, const QString &relPath, const DirectoryEntry *base,
+  const DirectoryEntry *directoryEntry, int createDestination,
+  std::vector<Mapping>& out)
 {
-  std::vector<Mapping> result;
+  int single = NoOrigin;
+
+  auto merge = [&](int origin) {
+    if (single == NoOrigin) {
+      single = origin;
+    } else if (origin != NoOrigin && origin != single) {
+      single = MixedOrigins;
+    }
+  };
 
   for (FileEntryPtr current : directoryEntry->getFiles()) {
     bool isArchive = false;
@@ -2049,14 +3173,15 @@ std::vector<Mapping> OrganizerCore::fileMapping(
       continue;
     }
 
-    QString originPath
-        = QString::fromStdWString(base->getOriginByID(origin).getPath());
-    QString fileName = QString::fromStdWString(current->getName());
-//    QString fileName = ToQString(current->getName());
+    merge(origin);
+
+    // views into the structure, only the paths of the mapping are allocated
+    const QString originPath = ToQStringRaw(base->getOriginByID(origin).getPath());
+    const QString fileName = ToQStringRaw(current->getName());
     QString source   = originPath + relPath + fileName;
     QString target   = dataPath + relPath + fileName;
     if (source != target) {
-      result.push_back({source, target, false, false});
+      out.push_back({source, target, false, false});
     }
   }
 
@@ -2064,19 +3189,42 @@ std::vector<Mapping> OrganizerCore::fileMapping(
   for (const auto& d : directoryEntry->getSubDirectories()) {
     int origin = d->anyOrigin();
 
-    QString originPath
-        = QString::fromStdWString(base->getOriginByID(origin).getPath());
-    QString dirName = QString::fromStdWString(d->getName());
+    const QString originPath = ToQStringRaw(base->getOriginByID(origin).getPath());
+    const QString dirName = ToQStringRaw(d->getName());
     QString source  = originPath + relPath + dirName;
     QString target  = dataPath + relPath + dirName;
 
     bool writeDestination
         = (base == directoryEntry) && (origin == createDestination);
 
-    result.push_back({source, target, true, writeDestination});
-    std::vector<Mapping> subRes = fileMapping(
-        dataPath, relPath + dirName + "\\", base, d, createDestination);
-    result.insert(result.end(), subRes.begin(), subRes.end());
+    out.push_back({source, target, true, writeDestination});
+
+    const auto subtree = out.size();
+    const int subOrigin = addFileMappings(
+      dataPath, relPath + dirName + "\\", base, d, createDestination, out);
+
+    // directories are linked recursively, so the links for the subtree are
+    // redundant when all of its files come from the same origin as the
+    // directory itself
+    if (subOrigin == NoOrigin || subOrigin == origin) {
+      out.resize(subtree);
+    }
+
+    merge(subOrigin);
   }
+
+  return single;
+}
+
+std::vector<Mapping> OrganizerCore::fileMapping(
+    const QString &dataPath, const QString &relPath, const DirectoryEntry *base,
+    const DirectoryEntry *directoryEntry, int createDestination)
+{
+  // everything is appended to the same vector, subtrees that end up being
+  // covered by their directory link are truncated away
+  std::vector<Mapping> result;
+  addFileMappings(
+    dataPath, relPath, base, directoryEntry, createDestination, result);
+
   return result;
 }
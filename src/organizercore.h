@@ -1,491 +1,816 @@
-#ifndef ORGANIZERCORE_H
-#define ORGANIZERCORE_H
-
-#include "selfupdater.h"
-#include "settings.h"
-#include "modlist.h"
-#include "modinfo.h"
-#include "pluginlist.h"
-#include "installationmanager.h"
-#include "downloadmanager.h"
-#include "executableslist.h"
-#include "usvfsconnector.h"
-#include "moshortcut.h"
-#include "processrunner.h"
-#include "uilocker.h"
-#include "envdump.h"
-#include <imoinfo.h>
-#include <iplugindiagnose.h>
-#include <versioninfo.h>
-#include <delayedfilewriter.h>
-#include <boost/signals2.hpp>
-#include "executableinfo.h"
-#include "moddatacontent.h"
-#include <log.h>
-
-#include <QDir>
-#include <QFileInfo>
-#include <QList>
-#include <QObject>
-#include <QSettings>
-#include <QString>
-#include <QStringList>
-#include <QThread>
-#include <QVariant>
-
-class ModListSortProxy;
-class PluginListSortProxy;
-class Profile;
-class IUserInterface;
-class PluginContainer;
-class DirectoryRefresher;
-
-namespace MOBase
-{
-  template <typename T> class GuessedValue;
-  class IModInterface;
-  class IPluginGame;
-}
-
-namespace MOShared
-{
-  class DirectoryEntry;
-}
-
-
-class OrganizerCore : public QObject, public MOBase::IPluginDiagnose
-{
-
-  Q_OBJECT
-  Q_INTERFACES(MOBase::IPluginDiagnose)
-
-private:
-
-  friend class OrganizerProxy;
-
-  struct SignalCombinerAnd
-  {
-    using result_type = bool;
-
-    template<typename InputIterator>
-    bool operator()(InputIterator first, InputIterator last) const
-    {
-      while (first != last) {
-        if (!(*first)) {
-          return false;
-        }
-        ++first;
-      }
-      return true;
-    }
-  };
-
-private:
-
-  using SignalAboutToRunApplication = boost::signals2::signal<bool(const QString&), SignalCombinerAnd>;
-  using SignalFinishedRunApplication = boost::signals2::signal<void(const QString&, unsigned int)>;
-  using SignalUserInterfaceInitialized = boost::signals2::signal<void(QMainWindow*)>;
-  using SignalProfileCreated = boost::signals2::signal<void(MOBase::IProfile*)>;
-  using SignalProfileRenamed = boost::signals2::signal<void(MOBase::IProfile*, QString const&, QString const&)>;
-  using SignalProfileRemoved = boost::signals2::signal<void(QString const&)>;
-  using SignalProfileChanged = boost::signals2::signal<void(MOBase::IProfile *, MOBase::IProfile *)>;
-  using SignalPluginSettingChanged = boost::signals2::signal<void(QString const&, const QString& key, const QVariant&, const QVariant&)>;
-  using SignalPluginEnabled = boost::signals2::signal<void(const MOBase::IPlugin*)>;
-
-public:
-
-  /**
-   * Small holder for the game content returned by the ModDataContent feature (the
-   * list of all possible contents, not the per-mod content).
-   */
-  struct ModDataContentHolder {
-
-    using Content = ModDataContent::Content;
-
-    /**
-     * @return true if the hold list of contents is empty, false otherwise.
-     */
-    bool empty() const { return m_Contents.empty(); }
-
-    /**
-     * @param id ID of the content to retrieve.
-     *
-     * @return the content with the given ID, or a null pointer if it is not found.
-     */
-    const Content* findById(int id) const {
-      auto it = std::find_if(std::begin(m_Contents), std::end(m_Contents), [&id](auto const& content) { return content.id() == id; });
-      return it == std::end(m_Contents) ? nullptr : &(*it);
-    }
-
-    /**
-     * Apply the given function to each content whose ID is in the given set.
-     *
-     * @param ids The set of content IDs.
-     * @param fn The function to apply.
-     * @param includeFilter true to also apply the function to filter-only contents, false otherwise.
-     */
-    template <class Fn>
-    void forEachContentIn(std::set<int> const& ids, Fn const& fn, bool includeFilter = false) const {
-      for (const auto& content : m_Contents) {
-        if ((includeFilter || !content.isOnlyForFilter())
-          && ids.find(content.id()) != ids.end()) {
-          fn(content);
-        }
-      }
-    }
-
-    /**
-     * @brief Apply fnIn to each content whose ID is in the given set, and fnOut to each content not in the
-     *   given set, excluding filter-only content (from both cases) unless includeFilter is true.
-     *
-     * @param ids The set of content IDs.
-     * @param fnIn Function to apply to content whose IDs are in ids.
-     * @param fnOut Function to apply to content whose IDs are not in ids.
-     * @param includeFilter true to also apply the function to filter-only contents, false otherwise.
-     */
-    template <class FnIn, class FnOut>
-    void forEachContentInOrOut(std::set<int> const& ids, FnIn const& fnIn, FnOut const& fnOut, bool includeFilter = false) const {
-      for (const auto& content : m_Contents) {
-        if ((includeFilter || !content.isOnlyForFilter())) {
-          if (ids.find(content.id()) != ids.end()) {
-            fnIn(content);
-          }
-          else {
-            fnOut(content);
-          }
-        }
-      }
-    }
-
-    /**
-     * Apply the given function to each content.
-     *
-     * @param fn The function to apply.
-     * @param includeFilter true to also apply the function to filter-only contents, false otherwise.
-     */
-    template <class Fn>
-    void forEachContent(Fn const& fn, bool includeFilter = false) const {
-      for (const auto& content : m_Contents) {
-        if (includeFilter || !content.isOnlyForFilter()) {
-          fn(content);
-        }
-      }
-    }
-
-
-    ModDataContentHolder& operator=(ModDataContentHolder const&) = delete;
-    ModDataContentHolder& operator=(ModDataContentHolder&&) = default;
-
-  private:
-
-    std::vector<Content> m_Contents;
-
-    /**
-     * @brief Construct a ModDataContentHolder without any contents (e.g., if the feature is
-     *     missing).
-     */
-    ModDataContentHolder() { }
-
-    /**
-     * @brief Construct a ModDataContentHold holding the given list of contents.
-     */
-    ModDataContentHolder(std::vector<ModDataContent::Content> contents) :
-      m_Contents(std::move(contents)) { }
-
-    friend class OrganizerCore;
-  };
-
-public:
-  OrganizerCore(Settings &settings);
-
-  ~OrganizerCore();
-
-  void setUserInterface(IUserInterface* ui);
-  void connectPlugins(PluginContainer *container);
-
-  void setManagedGame(MOBase::IPluginGame *game);
-
-  void updateExecutablesList();
-  void updateModInfoFromDisc();
-
-  void checkForUpdates();
-  void startMOUpdate();
-
-  Settings &settings();
-  SelfUpdater *updater() { return &m_Updater; }
-  InstallationManager *installationManager();
-  MOShared::DirectoryEntry *directoryStructure() { return m_DirectoryStructure; }
-  DirectoryRefresher *directoryRefresher() { return m_DirectoryRefresher.get(); }
-  ExecutablesList *executablesList() { return &m_ExecutablesList; }
-  void setExecutablesList(const ExecutablesList &executablesList) {
-    m_ExecutablesList = executablesList;
-  }
-
-  Profile *currentProfile() const { return m_CurrentProfile.get(); }
-  void setCurrentProfile(const QString &profileName);
-
-  std::vector<QString> enabledArchives();
-
-  MOBase::VersionInfo getVersion() const { return m_Updater.getVersion(); }
-
-  // return the plugin container
-  //
-  PluginContainer& pluginContainer() const;
-
-  MOBase::IPluginGame const *managedGame() const;
-
-  /**
-   * @brief Retrieve the organizer proxy of the currently managed game.
-   *
-   */
-  MOBase::IOrganizer const* managedGameOrganizer() const;
-
-
-  /**
-   * @return the list of contents for the currently managed game, or an empty vector
-   *     if the game plugin does not implement the ModDataContent feature.
-   */
-  const ModDataContentHolder& modDataContents() const { return m_Contents; }
-
-  bool isArchivesInit() const { return m_ArchivesInit; }
-
-  bool saveCurrentLists();
-
-  ProcessRunner processRunner();
-
-  bool beforeRun(
-    const QFileInfo& binary, const QString& profileName,
-    const QString& customOverwrite,
-    const QList<MOBase::ExecutableForcedLoadSetting>& forcedLibraries);
-
-  void afterRun(const QFileInfo& binary, DWORD exitCode);
-
-  ProcessRunner::Results waitForAllUSVFSProcesses(
-    UILocker::Reasons reason=UILocker::PreventExit);
-
-  void refreshESPList(bool force = false);
-  void refreshBSAList();
-
-  void refreshDirectoryStructure();
-  void updateModInDirectoryStructure(unsigned int index, ModInfo::Ptr modInfo);
-  void updateModsInDirectoryStructure(QMap<unsigned int, ModInfo::Ptr> modInfos);
-
-  void doAfterLogin(const std::function<void()> &function) { m_PostLoginTasks.append(function); }
-  void loggedInAction(QWidget* parent, std::function<void ()> f);
-
-  bool previewFileWithAlternatives(QWidget* parent, QString filename, int selectedOrigin=-1);
-  bool previewFile(QWidget* parent, const QString& originName, const QString& path);
-
-  void loginSuccessfulUpdate(bool necessary);
-  void loginFailedUpdate(const QString &message);
-
-  static bool createAndMakeWritable(const QString &path);
-  bool checkPathSymlinks();
-  bool bootstrap();
-  void createDefaultProfile();
-
-  MOBase::DelayedFileWriter &pluginsWriter() { return m_PluginListsWriter; }
-
-  void prepareVFS();
-
-  void updateVFSParams(
-    MOBase::log::Levels logLevel, env::CoreDumpTypes coreDumpType,
-    const QString& coreDumpsPath, std::chrono::seconds spawnDelay,
-    QString executableBlacklist);
-
-  void setLogLevel(MOBase::log::Levels level);
-
-  bool cycleDiagnostics();
-
-  static env::CoreDumpTypes getGlobalCoreDumpType();
-  static void setGlobalCoreDumpType(env::CoreDumpTypes type);
-  static std::wstring getGlobalCoreDumpPath();
-
-public:
-  MOBase::IModRepositoryBridge *createNexusBridge() const;
-  QString profileName() const;
-  QString profilePath() const;
-  QString downloadsPath() const;
-  QString overwritePath() const;
-  QString basePath() const;
-  QString modsPath() const;
-  MOBase::VersionInfo appVersion() const;
-  MOBase::IPluginGame *getGame(const QString &gameName) const;
-  MOBase::IModInterface *createMod(MOBase::GuessedValue<QString> &name);
-  void modDataChanged(MOBase::IModInterface *mod);
-  QVariant pluginSetting(const QString &pluginName, const QString &key) const;
-  void setPluginSetting(const QString &pluginName, const QString &key, const QVariant &value);
-  QVariant persistent(const QString &pluginName, const QString &key, const QVariant &def) const;
-  void setPersistent(const QString &pluginName, const QString &key, const QVariant &value, bool sync);
-  static QString pluginDataPath();
-  virtual MOBase::IModInterface *installMod(const QString &fileName, int priority, bool reinstallation, ModInfo::Ptr currentMod, const QString &initModName);
-  QString resolvePath(const QString &fileName) const;
-  QStringList listDirectories(const QString &directoryName) const;
-  QStringList findFiles(const QString &path, const std::function<bool (const QString &)> &filter) const;
-  QStringList getFileOrigins(const QString &fileName) const;
-  QList<MOBase::IOrganizer::FileInfo> findFileInfos(const QString &path, const std::function<bool (const MOBase::IOrganizer::FileInfo &)> &filter) const;
-  DownloadManager *downloadManager();
-  PluginList *pluginList();
-  ModList *modList();
-  void refresh(bool saveChanges = true);
-
-  boost::signals2::connection onAboutToRun(const std::function<bool(const QString&)>& func);
-  boost::signals2::connection onFinishedRun(const std::function<void(const QString&, unsigned int)>& func);
-  boost::signals2::connection onUserInterfaceInitialized(std::function<void(QMainWindow*)> const& func);
-  boost::signals2::connection onProfileCreated(std::function<void(MOBase::IProfile*)> const& func);
-  boost::signals2::connection onProfileRenamed(std::function<void(MOBase::IProfile*, QString const&, QString const&)> const& func);
-  boost::signals2::connection onProfileRemoved(std::function<void(QString const&)> const& func);
-  boost::signals2::connection onProfileChanged(std::function<void(MOBase::IProfile*, MOBase::IProfile*)> const& func);
-  boost::signals2::connection onPluginSettingChanged(std::function<void(QString const&, const QString& key, const QVariant&, const QVariant&)> const& func);
-  boost::signals2::connection onPluginEnabled(std::function<void(const MOBase::IPlugin*)> const& func);
-  boost::signals2::connection onPluginDisabled(std::function<void(const MOBase::IPlugin*)> const& func);
-
-public: // IPluginDiagnose interface
-
-  virtual std::vector<unsigned int> activeProblems() const;
-  virtual QString shortDescription(unsigned int key) const;
-  virtual QString fullDescription(unsigned int key) const;
-  virtual bool hasGuidedFix(unsigned int key) const;
-  virtual void startGuidedFix(unsigned int key) const;
-
-public slots:
-
-  void profileRefresh();
-
-  void syncOverwrite();
-
-  void savePluginList();
-
-  void refreshLists();
-
-  ModInfo::Ptr installDownload(int downloadIndex, int priority = -1);
-  ModInfo::Ptr installArchive(const QString& archivePath, int priority = -1, bool reinstallation = false,
-    ModInfo::Ptr currentMod = nullptr, const QString& modName = QString());
-
-  void modPrioritiesChanged(QModelIndexList const& indexes);
-  void modStatusChanged(unsigned int index);
-  void modStatusChanged(QList<unsigned int> index);
-  void requestDownload(const QUrl &url, QNetworkReply *reply);
-  void downloadRequestedNXM(const QString &url);
-
-  void userInterfaceInitialized();
-
-  void profileCreated(MOBase::IProfile* profile);
-  void profileRenamed(MOBase::IProfile* profile, QString const& oldName, QString const& newName);
-  void profileRemoved(QString const& profileName);
-
-  bool nexusApi(bool retry = false);
-
-signals:
-
-  // emitted after a mod has been installed
-  //
-  void modInstalled(const QString &modName);
-
-  // emitted when the managed game changes
-  //
-  void managedGameChanged(MOBase::IPluginGame const *gamePlugin);
-
-  // emitted when the profile is changed, before notifying plugins
-  //
-  // the new profile can be stored but the old one is temporary and
-  // should not be
-  //
-  void profileChanged(Profile* oldProfile, Profile* newProfile);
-
-  // Notify that the directory structure is ready to be used on the main thread
-  // Use queued connections
-  void directoryStructureReady();
-
-private:
-
-  void saveCurrentProfile();
-  void storeSettings();
-
-  void updateModActiveState(int index, bool active);
-  void updateModsActiveState(const QList<unsigned int> &modIndices, bool active);
-
-  bool createDirectory(const QString &path);
-
-  QString oldMO1HookDll() const;
-
-  /**
-   * @brief return a descriptor of the mappings real file->virtual file
-   */
-  std::vector<Mapping> fileMapping(const QString &profile,
-                                   const QString &customOverwrite);
-
-  std::vector<Mapping>
-  fileMapping(const QString &dataPath, const QString &relPath,
-              const MOShared::DirectoryEntry *base,
-              const MOShared::DirectoryEntry *directoryEntry,
-              int createDestination);
-
-private slots:
-
-  void directory_refreshed();
-  void downloadRequested(QNetworkReply *reply, QString gameName, int modID, const QString &fileName);
-  void removeOrigin(const QString &name);
-  void downloadSpeed(const QString &serverName, int bytesPerSecond);
-  void loginSuccessful(bool necessary);
-  void loginFailed(const QString &message);
-
-private:
-  static const unsigned int PROBLEM_MO1SCRIPTEXTENDERWORKAROUND = 1;
-
-private:
-  IUserInterface* m_UserInterface;
-  PluginContainer *m_PluginContainer;
-  QString m_GameName;
-  MOBase::IPluginGame *m_GamePlugin;
-  ModDataContentHolder m_Contents;
-
-  std::unique_ptr<Profile> m_CurrentProfile;
-
-  Settings& m_Settings;
-
-  SelfUpdater m_Updater;
-
-  SignalAboutToRunApplication m_AboutToRun;
-  SignalFinishedRunApplication m_FinishedRun;
-  SignalUserInterfaceInitialized m_UserInterfaceInitialized;
-  SignalProfileCreated m_ProfileCreated;
-  SignalProfileRenamed m_ProfileRenamed;
-  SignalProfileRemoved m_ProfileRemoved;
-  SignalProfileChanged m_ProfileChanged;
-  SignalPluginSettingChanged m_PluginSettingChanged;
-  SignalPluginEnabled m_PluginEnabled;
-  SignalPluginEnabled m_PluginDisabled;
-
-  ModList m_ModList;
-  PluginList m_PluginList;
-
-
-  QList<std::function<void()>> m_PostLoginTasks;
-  QList<std::function<void()>> m_PostRefreshTasks;
-
-  ExecutablesList m_ExecutablesList;
-  QStringList m_PendingDownloads;
-  QStringList m_DefaultArchives;
-  QStringList m_ActiveArchives;
-
-  std::unique_ptr<DirectoryRefresher> m_DirectoryRefresher;
-  MOShared::DirectoryEntry *m_DirectoryStructure;
-
-  DownloadManager m_DownloadManager;
-  InstallationManager m_InstallationManager;
-
-  QThread m_RefresherThread;
-
-  std::thread m_StructureDeleter;
-
-  bool m_DirectoryUpdate;
-  bool m_ArchivesInit;
-
-  MOBase::DelayedFileWriter m_PluginListsWriter;
-  UsvfsConnector m_USVFS;
-
-  UILocker m_UILocker;
-};
-
-#endif // ORGANIZERCORE_H
+#ifndef ORGANIZERCORE_H
+#define ORGANIZERCORE_H
+
+#include "selfupdater.h"
+#include "settings.h"
+#include "modlist.h"
+#include "modinfo.h"
+#include "pluginlist.h"
+#include "installationmanager.h"
+#include "downloadmanager.h"
+#include "executableslist.h"
+#include "usvfsconnector.h"
+#include "changejournal.h"
+#include "directorywatcher.h"
+#include "moshortcut.h"
+#include "processrunner.h"
+#include "uilocker.h"
+#include "envdump.h"
+#include "sanitychecks.h"
+#include "structureview.h"
+#include "taskexecutor.h"
+#include "memoryaccounting.h"
+#include "backgroundfilewriter.h"
+#include <imoinfo.h>
+#include <iplugindiagnose.h>
+#include <versioninfo.h>
+#include <delayedfilewriter.h>
+#include <boost/signals2.hpp>
+#include "executableinfo.h"
+#include "moddatacontent.h"
+#include <log.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QList>
+#include <QObject>
+#include <QSettings>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QVariant>
+#include <chrono>
+
+class ModListSortProxy;
+class PluginListSortProxy;
+class Profile;
+class IUserInterface;
+class PluginContainer;
+class DirectoryRefresher;
+class FileSearchIndex;
+
+namespace MOBase
+{
+  template <typename T> class GuessedValue;
+  class IModInterface;
+  class IPluginGame;
+}
+
+namespace MOShared
+{
+  class DirectoryEntry;
+}
+
+
+class OrganizerCore : public QObject, public MOBase::IPluginDiagnose
+{
+
+  Q_OBJECT
+  Q_INTERFACES(MOBase::IPluginDiagnose)
+
+private:
+
+  friend class OrganizerProxy;
+
+  struct SignalCombinerAnd
+  {
+    using result_type = bool;
+
+    template<typename InputIterator>
+    bool operator()(InputIterator first, InputIterator last) const
+    {
+      while (first != last) {
+        if (!(*first)) {
+          return false;
+        }
+        ++first;
+      }
+      return true;
+    }
+  };
+
+private:
+
+  using SignalAboutToRunApplication = boost::signals2::signal<bool(const QString&), SignalCombinerAnd>;
+  using SignalFinishedRunApplication = boost::signals2::signal<void(const QString&, unsigned int)>;
+  using SignalUserInterfaceInitialized = boost::signals2::signal<void(QMainWindow*)>;
+  using SignalProfileCreated = boost::signals2::signal<void(MOBase::IProfile*)>;
+  using SignalProfileRenamed = boost::signals2::signal<void(MOBase::IProfile*, QString const&, QString const&)>;
+  using SignalProfileRemoved = boost::signals2::signal<void(QString const&)>;
+  using SignalProfileChanged = boost::signals2::signal<void(MOBase::IProfile *, MOBase::IProfile *)>;
+  using SignalPluginSettingChanged = boost::signals2::signal<void(QString const&, const QString& key, const QVariant&, const QVariant&)>;
+  using SignalPluginEnabled = boost::signals2::signal<void(const MOBase::IPlugin*)>;
+
+public:
+
+  /**
+   * Small holder for the game content returned by the ModDataContent feature (the
+   * list of all possible contents, not the per-mod content).
+   */
+  struct ModDataContentHolder {
+
+    using Content = ModDataContent::Content;
+
+    /**
+     * @return true if the hold list of contents is empty, false otherwise.
+     */
+    bool empty() const { return m_Contents.empty(); }
+
+    /**
+     * @param id ID of the content to retrieve.
+     *
+     * @return the content with the given ID, or a null pointer if it is not found.
+     */
+    const Content* findById(int id) const {
+      auto it = std::find_if(std::begin(m_Contents), std::end(m_Contents), [&id](auto const& content) { return content.id() == id; });
+      return it == std::end(m_Contents) ? nullptr : &(*it);
+    }
+
+    /**
+     * Apply the given function to each content whose ID is in the given set.
+     *
+     * @param ids The set of content IDs.
+     * @param fn The function to apply.
+     * @param includeFilter true to also apply the function to filter-only contents, false otherwise.
+     */
+    template <class Fn>
+    void forEachContentIn(std::set<int> const& ids, Fn const& fn, bool includeFilter = false) const {
+      for (const auto& content : m_Contents) {
+        if ((includeFilter || !content.isOnlyForFilter())
+          && ids.find(content.id()) != ids.end()) {
+          fn(content);
+        }
+      }
+    }
+
+    /**
+     * @brief Apply fnIn to each content whose ID is in the given set, and fnOut to each content not in the
+     *   given set, excluding filter-only content (from both cases) unless includeFilter is true.
+     *
+     * @param ids The set of content IDs.
+     * @param fnIn Function to apply to content whose IDs are in ids.
+     * @param fnOut Function to apply to content whose IDs are not in ids.
+     * @param includeFilter true to also apply the function to filter-only contents, false otherwise.
+     */
+    template <class FnIn, class FnOut>
+    void forEachContentInOrOut(std::set<int> const& ids, FnIn const& fnIn, FnOut const& fnOut, bool includeFilter = false) const {
+      for (const auto& content : m_Contents) {
+        if ((includeFilter || !content.isOnlyForFilter())) {
+          if (ids.find(content.id()) != ids.end()) {
+            fnIn(content);
+          }
+          else {
+            fnOut(content);
+          }
+        }
+      }
+    }
+
+    /**
+     * Apply the given function to each content.
+     *
+     * @param fn The function to apply.
+     * @param includeFilter true to also apply the function to filter-only contents, false otherwise.
+     */
+    template <class Fn>
+    void forEachContent(Fn const& fn, bool includeFilter = false) const {
+      for (const auto& content : m_Contents) {
+        if (includeFilter || !content.isOnlyForFilter()) {
+          fn(content);
+        }
+      }
+    }
+
+
+    ModDataContentHolder& operator=(ModDataContentHolder const&) = delete;
+    ModDataContentHolder& operator=(ModDataContentHolder&&) = default;
+
+  private:
+
+    std::vector<Content> m_Contents;
+
+    /**
+     * @brief Construct a ModDataContentHolder without any contents (e.g., if the feature is
+     *     missing).
+     */
+    ModDataContentHolder() { }
+
+    /**
+     * @brief Construct a ModDataContentHold holding the given list of contents.
+     */
+    ModDataContentHolder(std::vector<ModDataContent::Content> contents) :
+      m_Contents(std::move(contents)) { }
+
+    friend class OrganizerCore;
+  };
+
+public:
+  OrganizerCore(Settings &settings);
+
+  ~OrganizerCore();
+
+  void setUserInterface(IUserInterface* ui);
+  void connectPlugins(PluginContainer *container);
+
+  void setManagedGame(MOBase::IPluginGame *game);
+
+  void updateExecutablesList();
+  void updateModInfoFromDisc();
+
+  void checkForUpdates();
+  void startMOUpdate();
+
+  Settings &settings();
+  SelfUpdater *updater() { return &m_Updater; }
+  InstallationManager *installationManager();
+  MOShared::DirectoryEntry *directoryStructure() { return m_DirectoryStructure; }
+
+  // a view of the current directory structure that keeps it alive when it's
+  // replaced by a refresh, see StructureView; empty if there's no structure
+  //
+  StructureView structureView() const;
+
+  // whether views still hold the current structure, in which case it must not
+  // be changed in place: a new structure is built and published instead, see
+  // refreshDirectoryStructure()
+  //
+  bool structureShared() const;
+
+  struct FileSearchMatch
+  {
+    // relative path, as it is in the structure
+    QString path;
+
+    // origin providing the file and the ones it overwrites
+    QString origin;
+    QStringList alternatives;
+  };
+
+  // files whose relative path contains the given text, from the search index
+  // and looked up in the current structure, see FileSearchIndex::find(); at
+  // most `max`, `truncated` is set when there were more
+  //
+  // this is empty until the index has been built after the first refresh
+  //
+  std::vector<FileSearchMatch> searchFiles(
+    const QString& text, std::size_t max, bool* truncated=nullptr) const;
+
+  DirectoryRefresher *directoryRefresher() { return m_DirectoryRefresher.get(); }
+  ExecutablesList *executablesList() { return &m_ExecutablesList; }
+  void setExecutablesList(const ExecutablesList &executablesList) {
+    m_ExecutablesList = executablesList;
+  }
+
+  Profile *currentProfile() const { return m_CurrentProfile.get(); }
+  void setCurrentProfile(const QString &profileName);
+
+  // archives enabled in the current profile; archives.txt is only read the
+  // first time, the list is then kept up to date by setEnabledArchives()
+  //
+  std::vector<QString> enabledArchives();
+
+  // remembers the archives checked in the archive list and writes them to the
+  // profile's archives.txt in the background if they changed, see
+  // flushArchives()
+  //
+  void setEnabledArchives(std::vector<QString> archives);
+
+  // blocks until archives.txt has been written
+  //
+  void flushArchives();
+
+  // reads the given archives.txt, can be called from any thread
+  //
+  static std::vector<QString> readEnabledArchives(const QString& path);
+
+  // mappings of the loose files of the given structure into the data
+  // directory, directories that only have files from one origin are mapped
+  // as a whole
+  //
+  static std::vector<Mapping>
+  fileMapping(const QString &dataPath, const QString &relPath,
+              const MOShared::DirectoryEntry *base,
+              const MOShared::DirectoryEntry *directoryEntry,
+              int createDestination);
+
+  MOBase::VersionInfo getVersion() const { return m_Updater.getVersion(); }
+
+  // return the plugin container
+  //
+  PluginContainer& pluginContainer() const;
+
+  MOBase::IPluginGame const *managedGame() const;
+
+  /**
+   * @brief Retrieve the organizer proxy of the currently managed game.
+   *
+   */
+  MOBase::IOrganizer const* managedGameOrganizer() const;
+
+
+  /**
+   * @return the list of contents for the currently managed game, or an empty vector
+   *     if the game plugin does not implement the ModDataContent feature.
+   */
+  const ModDataContentHolder& modDataContents() const { return m_Contents; }
+
+  bool isArchivesInit() const { return m_ArchivesInit; }
+
+  bool saveCurrentLists();
+
+  ProcessRunner processRunner();
+
+  bool beforeRun(
+    const QFileInfo& binary, const QString& profileName,
+    const QString& customOverwrite,
+    const QList<MOBase::ExecutableForcedLoadSetting>& forcedLibraries);
+
+  void afterRun(const QFileInfo& binary, DWORD exitCode);
+
+  ProcessRunner::Results waitForAllUSVFSProcesses(
+    UILocker::Reasons reason=UILocker::PreventExit);
+
+  void refreshESPList(bool force = false);
+  void refreshBSAList();
+
+  // `invalidateVFS` is false when the disk can only have changed through
+  // usvfs, which keeps track of it, so the installed mapping can be reused
+  //
+  // queued if a refresh is already running, see refresh()
+  //
+  void refreshDirectoryStructure(bool invalidateVFS=true);
+
+  void doAfterLogin(const std::function<void()> &function) { m_PostLoginTasks.append(function); }
+  void loggedInAction(QWidget* parent, std::function<void ()> f);
+
+  bool previewFileWithAlternatives(QWidget* parent, QString filename, int selectedOrigin=-1);
+  bool previewFile(QWidget* parent, const QString& originName, const QString& path);
+
+  void loginSuccessfulUpdate(bool necessary);
+  void loginFailedUpdate(const QString &message);
+
+  static bool createAndMakeWritable(const QString &path);
+  bool checkPathSymlinks();
+  bool bootstrap();
+  void createDefaultProfile();
+
+  MOBase::DelayedFileWriter &pluginsWriter() { return m_PluginListsWriter; }
+
+  void prepareVFS();
+
+  // installs the mapping of the current profile without showing progress,
+  // called after refreshes when enabled, see Settings::prewarmVFS()
+  //
+  void prewarmVFS();
+
+  void updateVFSParams(
+    MOBase::log::Levels logLevel, env::CoreDumpTypes coreDumpType,
+    const QString& coreDumpsPath, std::chrono::seconds spawnDelay,
+    QString executableBlacklist);
+
+  void setLogLevel(MOBase::log::Levels level);
+
+  bool cycleDiagnostics();
+
+  static env::CoreDumpTypes getGlobalCoreDumpType();
+  static void setGlobalCoreDumpType(env::CoreDumpTypes type);
+  static std::wstring getGlobalCoreDumpPath();
+
+public:
+  MOBase::IModRepositoryBridge *createNexusBridge() const;
+  QString profileName() const;
+  QString profilePath() const;
+  QString downloadsPath() const;
+  QString overwritePath() const;
+  QString basePath() const;
+  QString modsPath() const;
+  MOBase::VersionInfo appVersion() const;
+  MOBase::IPluginGame *getGame(const QString &gameName) const;
+  MOBase::IModInterface *createMod(MOBase::GuessedValue<QString> &name);
+  void modDataChanged(MOBase::IModInterface *mod);
+  QVariant pluginSetting(const QString &pluginName, const QString &key) const;
+  void setPluginSetting(const QString &pluginName, const QString &key, const QVariant &value);
+  QVariant persistent(const QString &pluginName, const QString &key, const QVariant &def) const;
+  void setPersistent(const QString &pluginName, const QString &key, const QVariant &value, bool sync);
+  static QString pluginDataPath();
+  virtual MOBase::IModInterface *installMod(const QString &fileName, int priority, bool reinstallation, ModInfo::Ptr currentMod, const QString &initModName);
+  QString resolvePath(const QString &fileName) const;
+  QStringList listDirectories(const QString &directoryName) const;
+  QStringList findFiles(const QString &path, const std::function<bool (const QString &)> &filter) const;
+
+  // full paths of the files in any of the given directories that match any
+  // of the glob patterns, see MOShared::GlobMatcher; names are matched as
+  // they are stored in the structure and only matching files are converted
+  //
+  QStringList findFiles(const QStringList &paths, const QStringList &globFilters) const;
+  QStringList getFileOrigins(const QString &fileName) const;
+  QList<MOBase::IOrganizer::FileInfo> findFileInfos(const QString &path, const std::function<bool (const MOBase::IOrganizer::FileInfo &)> &filter) const;
+  DownloadManager *downloadManager();
+  PluginList *pluginList();
+  ModList *modList();
+  // reads the mods again and refreshes the directory structure; if a refresh
+  // is already running, this is queued and started once it's done, requests
+  // made in the meantime are merged into that single queued refresh
+  //
+  void refresh(bool saveChanges = true);
+
+  // calls `f` once the refresh that is running, or the one that's queued, has
+  // finished; `f` is called right away if there are none
+  //
+  // the progress of the refresh is reported by DirectoryRefresher::progress()
+  //
+  void whenRefreshed(std::function<void ()> f);
+
+  // whether a refresh is running or queued
+  //
+  bool refreshing() const;
+
+  // processes events until the running and queued refreshes are done
+  //
+  void waitForRefresh();
+
+  // durations of a refresh, they're always collected, unlike RefreshTrace
+  //
+  struct RefreshTimings
+  {
+    // when the refresh finished, null if no refresh finished yet
+    QDateTime time;
+
+    // whether the structure was updated in place, see
+    // DirectoryRefresher::refreshIncremental()
+    bool incremental = false;
+
+    // the phases of the structure refresh, followed by the refresh of the
+    // lists
+    std::vector<std::pair<QString, std::chrono::nanoseconds>> phases;
+
+    std::chrono::nanoseconds total{0};
+  };
+
+  // timings of the last refresh that finished
+  //
+  const RefreshTimings& lastRefreshTimings() const;
+
+  boost::signals2::connection onAboutToRun(const std::function<bool(const QString&)>& func);
+  boost::signals2::connection onFinishedRun(const std::function<void(const QString&, unsigned int)>& func);
+  boost::signals2::connection onUserInterfaceInitialized(std::function<void(QMainWindow*)> const& func);
+  boost::signals2::connection onProfileCreated(std::function<void(MOBase::IProfile*)> const& func);
+  boost::signals2::connection onProfileRenamed(std::function<void(MOBase::IProfile*, QString const&, QString const&)> const& func);
+  boost::signals2::connection onProfileRemoved(std::function<void(QString const&)> const& func);
+  boost::signals2::connection onProfileChanged(std::function<void(MOBase::IProfile*, MOBase::IProfile*)> const& func);
+  boost::signals2::connection onPluginSettingChanged(std::function<void(QString const&, const QString& key, const QVariant&, const QVariant&)> const& func);
+  boost::signals2::connection onPluginEnabled(std::function<void(const MOBase::IPlugin*)> const& func);
+  boost::signals2::connection onPluginDisabled(std::function<void(const MOBase::IPlugin*)> const& func);
+
+public: // IPluginDiagnose interface
+
+  virtual std::vector<unsigned int> activeProblems() const;
+  virtual QString shortDescription(unsigned int key) const;
+  virtual QString fullDescription(unsigned int key) const;
+  virtual bool hasGuidedFix(unsigned int key) const;
+  virtual void startGuidedFix(unsigned int key) const;
+
+public slots:
+
+  void profileRefresh();
+
+  void syncOverwrite();
+
+  // changes made to the mods or overwrite directories between the two calls
+  // don't trigger a refresh, the caller is expected to refresh what's needed;
+  // calls can be nested
+  //
+  void startDisableDirWatcher();
+  void endDisableDirWatcher();
+
+  void savePluginList();
+
+  // refreshes the plugin and archive lists; the profile's archive list is
+  // read in the background while the plugin list is refreshed
+  //
+  void refreshLists();
+
+  ModInfo::Ptr installDownload(int downloadIndex, int priority = -1);
+
+  // installs the given downloads one after the other; the directory
+  // structure, plugins and archives are refreshed every few mods and once at
+  // the end instead of after every mod
+  //
+  void installDownloads(const std::vector<int>& downloadIndexes);
+
+  ModInfo::Ptr installArchive(const QString& archivePath, int priority = -1, bool reinstallation = false,
+    ModInfo::Ptr currentMod = nullptr, const QString& modName = QString());
+
+  void modPrioritiesChanged(QModelIndexList const& indexes);
+  void modStatusChanged(unsigned int index);
+  void modStatusChanged(QList<unsigned int> index);
+  void requestDownload(const QUrl &url, QNetworkReply *reply);
+  void downloadRequestedNXM(const QString &url);
+
+  void userInterfaceInitialized();
+
+  void profileCreated(MOBase::IProfile* profile);
+  void profileRenamed(MOBase::IProfile* profile, QString const& oldName, QString const& newName);
+  void profileRemoved(QString const& profileName);
+
+  bool nexusApi(bool retry = false);
+
+signals:
+
+  // emitted after a mod has been installed
+  //
+  void modInstalled(const QString &modName);
+
+  // emitted when the managed game changes
+  //
+  void managedGameChanged(MOBase::IPluginGame const *gamePlugin);
+
+  // emitted when the profile is changed, before notifying plugins
+  //
+  // the new profile can be stored but the old one is temporary and
+  // should not be
+  //
+  void profileChanged(Profile* oldProfile, Profile* newProfile);
+
+  // Notify that the directory structure is ready to be used on the main thread
+  // Use queued connections
+  void directoryStructureReady();
+
+  // emitted when the search index has been built again, see searchFiles()
+  void fileSearchIndexChanged();
+
+private:
+
+  void saveCurrentProfile();
+  void storeSettings();
+
+  void updateModActiveState(int index, bool active);
+  void updateModsActiveState(const QList<unsigned int> &modIndices, bool active);
+
+  // enables or disables the plugins of the given mods without refreshing the
+  // load order or writing the lists, returns the number of esps and esls that
+  // changed; used by updateModsActiveState() and modStatusChanged()
+  //
+  int setModsPluginsActive(const QList<unsigned int> &modIndices, bool active);
+
+  bool createDirectory(const QString &path);
+
+  QString oldMO1HookDll() const;
+
+  // the problem found by the sanity checks for the given key, empty if the key
+  // is not one of them
+  //
+  static std::optional<sanity::Problem> sanityProblem(unsigned int key);
+
+  /**
+   * @brief return a descriptor of the mappings real file->virtual file
+   */
+  std::vector<Mapping> fileMapping(const QString &profile,
+                                   const QString &customOverwrite);
+
+  // clears the conflict caches, runs the post refresh tasks and refreshes the
+  // lists once the directory structure has been updated
+  //
+  void finishDirectoryRefresh();
+
+  // builds the search index again in the background from a view of the
+  // structure; the previous index is still used by searchFiles() until then,
+  // but not by findFiles(), which must see the files that were added
+  //
+  void updateSearchIndex();
+
+  // writes the current directory structure to the profile's snapshot file so
+  // it can be restored on the next startup
+  //
+  void saveStructureSnapshot();
+
+  // replaces the current directory structure by the one in the profile's
+  // snapshot file, if any; the restored structure can be outdated and must be
+  // refreshed
+  //
+  void restoreStructureSnapshot();
+
+  // refreshBSAList() with the archives from enabledArchives()
+  //
+  void refreshBSAList(const std::vector<QString>& enabled);
+
+  // recomputes the order of the archives in the structure from the current
+  // load order and sorts the files they provide, see
+  // FileRegister::setArchiveOrders(); called when the plugin list is saved
+  //
+  void updateArchiveOrders();
+
+  // applies the mods enabled or disabled during the refresh to the new
+  // structure, see m_DeferredModStatus
+  //
+  void applyDeferredModStatus();
+
+  // starts the refresh that was queued while another was running, if it
+  // wasn't already started by a new request
+  //
+  void startPendingRefresh();
+
+  // registers the structure and the caches of the mods with MemoryAccounting
+  //
+  void registerMemorySources();
+
+  // called before m_DirectoryStructure is replaced or destroyed; if views
+  // still use it, they take ownership of it and this returns true, in which
+  // case it must not be deleted
+  //
+  bool retireStructure();
+
+private slots:
+
+  void directory_refreshed();
+  void downloadRequested(QNetworkReply *reply, QString gameName, int modID, const QString &fileName);
+  void removeOrigin(const QString &name);
+  void downloadSpeed(const QString &serverName, int bytesPerSecond);
+  void loginSuccessful(bool necessary);
+  void loginFailed(const QString &message);
+
+  // changes made outside of MO in the mods or overwrite directories, reported
+  // by m_StructureWatcher
+  void onWatchedFilesChanged(const QString& root, const QStringList& paths);
+
+private:
+  static const unsigned int PROBLEM_MO1SCRIPTEXTENDERWORKAROUND = 1;
+
+  // problems found by the sanity checks start at this key, in the order
+  // returned by sanity::problems()
+  static const unsigned int PROBLEM_SANITYCHECKS = 1000;
+
+  // number of mods installed in a batch between two refreshes of the
+  // directory structure
+  static const int INSTALL_BATCH_REFRESH_INTERVAL = 25;
+
+  // refreshes what's needed after a mod was installed; in a batch, only the
+  // mod list is refreshed most of the time
+  //
+  void refreshAfterInstall();
+
+  // installs the next download in m_PendingInstalls, or tries again later if
+  // an installation is running
+  //
+  void installPendingDownloads();
+
+private:
+  IUserInterface* m_UserInterface;
+  PluginContainer *m_PluginContainer;
+  QString m_GameName;
+  MOBase::IPluginGame *m_GamePlugin;
+  ModDataContentHolder m_Contents;
+
+  std::unique_ptr<Profile> m_CurrentProfile;
+
+  Settings& m_Settings;
+
+  SelfUpdater m_Updater;
+
+  SignalAboutToRunApplication m_AboutToRun;
+  SignalFinishedRunApplication m_FinishedRun;
+  SignalUserInterfaceInitialized m_UserInterfaceInitialized;
+  SignalProfileCreated m_ProfileCreated;
+  SignalProfileRenamed m_ProfileRenamed;
+  SignalProfileRemoved m_ProfileRemoved;
+  SignalProfileChanged m_ProfileChanged;
+  SignalPluginSettingChanged m_PluginSettingChanged;
+  SignalPluginEnabled m_PluginEnabled;
+  SignalPluginEnabled m_PluginDisabled;
+
+  ModList m_ModList;
+  PluginList m_PluginList;
+
+
+  QList<std::function<void()>> m_PostLoginTasks;
+  // work on the lists requested while the structure is being refreshed;
+  // requests are merged here and done once in finishDirectoryRefresh(), after
+  // the lists have been refreshed for the new structure
+  enum class Deferred
+  {
+    None           = 0x00,
+
+    // refreshESPList(), done by refreshLists() if the structure is populated
+    PluginList     = 0x01,
+
+    // savePluginList()
+    SavePluginList = 0x02,
+
+    // modPrioritiesChanged(), done for all the mods
+    ModPriorities  = 0x04,
+
+    // modStatusChanged() for m_DeferredModStatus
+    ModStatus      = 0x08
+  };
+
+  Q_DECLARE_FLAGS(DeferredWork, Deferred);
+
+  DeferredWork m_Deferred;
+
+  // `force` for a deferred refreshESPList(), true if any request forced it
+  bool m_DeferredPluginListForce;
+
+  // mods that were enabled or disabled while the structure was refreshed;
+  // the mod list stays usable during a refresh, but the new structure is
+  // built from the mods as they were when it started
+  std::set<unsigned int> m_DeferredModStatus;
+
+  // a refresh requested while another was running, started once it's done,
+  // see refresh()
+  enum class PendingRefresh
+  {
+    None = 0,
+
+    // only the directory structure
+    Structure,
+
+    // also reads the mods again
+    Full
+  };
+
+  PendingRefresh m_PendingRefresh;
+
+  // saveChanges for a pending full refresh, false if any of the merged
+  // requests asked to not save changes
+  bool m_PendingRefreshSave;
+
+  // callbacks from whenRefreshed() for the running refresh and for the queued
+  // one
+  std::vector<std::function<void ()>> m_RefreshCallbacks;
+  std::vector<std::function<void ()>> m_PendingRefreshCallbacks;
+
+  ExecutablesList m_ExecutablesList;
+  QStringList m_PendingDownloads;
+  QStringList m_DefaultArchives;
+  QStringList m_ActiveArchives;
+
+  std::unique_ptr<DirectoryRefresher> m_DirectoryRefresher;
+  MOShared::DirectoryEntry *m_DirectoryStructure;
+
+  // shared by the views of m_DirectoryStructure, see structureView()
+  mutable std::shared_ptr<StructureView::Pin> m_StructurePin;
+
+  DownloadManager m_DownloadManager;
+  InstallationManager m_InstallationManager;
+
+  QThread m_RefresherThread;
+
+  // deletes replaced structures in the background, one after the other; a
+  // refresh never waits for the previous structure to be deleted
+  std::unique_ptr<MOShared::TaskGroup> m_StructureDeleter;
+
+  bool m_DirectoryUpdate;
+  bool m_ArchivesInit;
+
+  // archives enabled in the current profile, empty until archives.txt is
+  // read; see enabledArchives()
+  std::optional<std::vector<QString>> m_EnabledArchives;
+
+  // writes archives.txt for setEnabledArchives()
+  BackgroundFileWriter m_ArchivesFileWriter;
+
+  // see updateSearchIndex(); the generation is shared with the task building
+  // the index, which gives up when it changes
+  std::shared_ptr<const FileSearchIndex> m_SearchIndex;
+  bool m_SearchIndexCurrent;
+  std::shared_ptr<std::atomic<int>> m_SearchIndexGeneration;
+
+  // consumers reported by MemoryAccounting, see registerMemorySources()
+  std::vector<std::unique_ptr<MemoryAccounting::Source>> m_MemorySources;
+
+  // timings of the refresh that's running and of the last one that finished
+  std::chrono::steady_clock::time_point m_RefreshStart;
+  RefreshTimings m_RefreshTimings;
+  RefreshTimings m_LastRefreshTimings;
+
+  // whether installDownloads() is running and the number of mods it
+  // installed since the directory structure was last refreshed
+  bool m_InstallBatch;
+  int m_InstallBatchPending;
+
+  // downloads that were marked to be installed when finished and are ready,
+  // by file name, installed one at a time by installPendingDownloads()
+  QStringList m_PendingInstalls;
+  QTimer m_PendingInstallsTimer;
+
+  MOBase::DelayedFileWriter m_PluginListsWriter;
+  UsvfsConnector m_USVFS;
+
+  // the changes seen by m_ChangeJournal are also given to the watcher, which
+  // refreshes the structure when files are changed outside of MO; both must
+  // outlive the journal, which calls into the watcher from its threads
+  WatcherSuppression m_DirWatcherSuppression;
+  DirectoryWatcher m_StructureWatcher;
+
+  // watches the mods and overwrite directories between refreshes so only
+  // the mods that changed are walked again, see refreshDirectoryStructure()
+  ChangeJournal m_ChangeJournal;
+
+  UILocker m_UILocker;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(OrganizerCore::DeferredWork);
+
+#endif // ORGANIZERCORE_H
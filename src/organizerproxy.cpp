@@ -33,17 +33,17 @@ OrganizerProxy::~OrganizerProxy()
 
 void OrganizerProxy::connectSignals()
 {
-  m_Connections.push_back(m_Proxied->onAboutToRun(callSignalIfPluginActive(this, m_AboutToRun, true)));
-  m_Connections.push_back(m_Proxied->onFinishedRun(callSignalIfPluginActive(this, m_FinishedRun)));
-  m_Connections.push_back(m_Proxied->onProfileCreated(callSignalIfPluginActive(this, m_ProfileCreated)));
-  m_Connections.push_back(m_Proxied->onProfileRenamed(callSignalIfPluginActive(this, m_ProfileRenamed)));
-  m_Connections.push_back(m_Proxied->onProfileRemoved(callSignalIfPluginActive(this, m_ProfileRemoved)));
-  m_Connections.push_back(m_Proxied->onProfileChanged(callSignalIfPluginActive(this, m_ProfileChanged)));
-
-  m_Connections.push_back(m_Proxied->onUserInterfaceInitialized(callSignalAlways(m_UserInterfaceInitialized)));
-  m_Connections.push_back(m_Proxied->onPluginSettingChanged(callSignalAlways(m_PluginSettingChanged)));
-  m_Connections.push_back(m_Proxied->onPluginEnabled(callSignalAlways(m_PluginEnabled)));
-  m_Connections.push_back(m_Proxied->onPluginDisabled(callSignalAlways(m_PluginDisabled)));
+  m_Connections.push_back(m_Proxied->onAboutToRun(callTimedSignalIfPluginActive(this, m_AboutToRun, "onAboutToRun", true)));
+  m_Connections.push_back(m_Proxied->onFinishedRun(callTimedSignalIfPluginActive(this, m_FinishedRun, "onFinishedRun")));
+  m_Connections.push_back(m_Proxied->onProfileCreated(callTimedSignalIfPluginActive(this, m_ProfileCreated, "onProfileCreated")));
+  m_Connections.push_back(m_Proxied->onProfileRenamed(callTimedSignalIfPluginActive(this, m_ProfileRenamed, "onProfileRenamed")));
+  m_Connections.push_back(m_Proxied->onProfileRemoved(callTimedSignalIfPluginActive(this, m_ProfileRemoved, "onProfileRemoved")));
+  m_Connections.push_back(m_Proxied->onProfileChanged(callTimedSignalIfPluginActive(this, m_ProfileChanged, "onProfileChanged")));
+
+  m_Connections.push_back(m_Proxied->onUserInterfaceInitialized(callTimedSignalAlways(this, m_UserInterfaceInitialized, "onUserInterfaceInitialized")));
+  m_Connections.push_back(m_Proxied->onPluginSettingChanged(callTimedSignalAlways(this, m_PluginSettingChanged, "onPluginSettingChanged")));
+  m_Connections.push_back(m_Proxied->onPluginEnabled(callTimedSignalAlways(this, m_PluginEnabled, "onPluginEnabled")));
+  m_Connections.push_back(m_Proxied->onPluginDisabled(callTimedSignalAlways(this, m_PluginDisabled, "onPluginDisabled")));
 
   // Connect the child proxies.
   m_DownloadManagerProxy->connectSignals();
@@ -196,8 +196,11 @@ bool OrganizerProxy::waitForApplication(HANDLE handle, bool refresh, LPDWORD exi
     waitFlags |= ProcessRunner::TriggerRefresh | ProcessRunner::WaitForRefresh;
   }
 
+  // plugins waiting on tools typically run many of them in a row, which
+  // doesn't need to disable the whole ui every time
   const auto r = runner
     .setWaitForCompletion(waitFlags, UILocker::OutputRequired)
+    .setLockMode(UILocker::LightLock)
     .attachToProcess(handle);
 
   if (exitCode) {
@@ -248,18 +251,7 @@ QStringList OrganizerProxy::findFiles(const QString &path, const std::function<b
 
 QStringList OrganizerProxy::findFiles(const QString& path, const QStringList& globFilters) const
 {
-  QList<GlobPattern<QChar>> patterns;
-  for (auto& gfilter : globFilters) {
-    patterns.append(GlobPattern(gfilter));
-  }
-  return findFiles(path, [&patterns](const QString& filename) {
-    for (auto& p : patterns) {
-      if (p.match(filename)) {
-        return true;
-      }
-    }
-    return false;
-  });
+  return m_Proxied->findFiles(QStringList{path}, globFilters);
 }
 
 QStringList OrganizerProxy::getFileOrigins(const QString &fileName) const
@@ -301,12 +293,12 @@ MOBase::IPluginGame const *OrganizerProxy::managedGame() const
 
 bool OrganizerProxy::onAboutToRun(const std::function<bool(const QString&)>& func)
 {
-  return m_Proxied->onAboutToRun(MOShared::callIfPluginActive(this, func, true)).connected();
+  return m_Proxied->onAboutToRun(MOShared::callTimedIfPluginActive(this, func, "onAboutToRun", true)).connected();
 }
 
 bool OrganizerProxy::onFinishedRun(const std::function<void(const QString&, unsigned int)>& func)
 {
-  return m_Proxied->onFinishedRun(MOShared::callIfPluginActive(this, func)).connected();
+  return m_Proxied->onFinishedRun(MOShared::callTimedIfPluginActive(this, func, "onFinishedRun")).connected();
 }
 
 bool OrganizerProxy::onProfileCreated(std::function<void(IProfile*)> const& func)
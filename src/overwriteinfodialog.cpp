@@ -22,26 +22,786 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "report.h"
 #include "utility.h"
 #include "organizercore.h"
+#include "taskexecutor.h"
+#include "shared/directoryentry.h"
+#include "shared/fileentry.h"
+#include "shared/filesorigin.h"
+#include <QDir>
+#include <QFileIconProvider>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QMenu>
+#include <QMimeData>
 #include <QShortcut>
+#include <QUrl>
 #include <Shlwapi.h>
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
 
 using namespace MOBase;
+using namespace MOShared;
 
-OverwriteInfoDialog::OverwriteInfoDialog(ModInfo::Ptr modInfo, QWidget *parent)
-  : QDialog(parent), ui(new Ui::OverwriteInfoDialog), m_FileSystemModel(nullptr),
-    m_DeleteAction(nullptr), m_RenameAction(nullptr), m_OpenAction(nullptr)
+// number of files whose size is retrieved by a single task of the size pass
+static constexpr std::size_t SizesPerTask = 1000;
+
+
+struct OverwriteModel::Node
+{
+  QString name;
+  bool isDir = false;
+  Node* parent = nullptr;
+  int row = 0;
+  std::vector<std::unique_ptr<Node>> children;
+
+  QDateTime lastModified;
+
+  // size of the file, or the sum of the known sizes of all the files in the
+  // directory
+  uint64_t size = 0;
+
+  // number of files whose size isn't known yet, either 0 or 1 for a file
+  std::size_t pending = 0;
+
+  // index in m_Sizes for files, npos for the others
+  std::size_t sizeIndex = static_cast<std::size_t>(-1);
+
+  Node* add(std::unique_ptr<Node> n)
+  {
+    n->parent = this;
+    n->row = static_cast<int>(children.size());
+    children.push_back(std::move(n));
+
+    return children.back().get();
+  }
+
+  void renumber(std::size_t from=0)
+  {
+    for (std::size_t i=from; i<children.size(); ++i) {
+      children[i]->row = static_cast<int>(i);
+    }
+  }
+};
+
+struct OverwriteModel::Size
+{
+  std::size_t index;
+  uint64_t size;
+  QDateTime lastModified;
+};
+
+
+static QDateTime toDateTime(const FILETIME& ft)
+{
+  ULARGE_INTEGER i;
+  i.LowPart = ft.dwLowDateTime;
+  i.HighPart = ft.dwHighDateTime;
+
+  if (i.QuadPart == 0) {
+    return {};
+  }
+
+  // 100ns intervals since 1601-01-01
+  const auto ms = static_cast<qint64>(i.QuadPart / 10000) - 11644473600000LL;
+  return QDateTime::fromMSecsSinceEpoch(ms, Qt::UTC).toLocalTime();
+}
+
+static bool isFromOrigin(const FileEntry& f, int originID)
+{
+  if (f.getOrigin() == originID) {
+    return true;
+  }
+
+  for (auto&& a : f.getAlternatives()) {
+    if (a.originID() == originID) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static QString fileType(const QString& name, bool isDir)
+{
+  if (isDir) {
+    return OverwriteModel::tr("Folder");
+  }
+
+  const auto dot = name.lastIndexOf('.');
+  if (dot <= 0) {
+    return OverwriteModel::tr("File");
+  }
+
+  return OverwriteModel::tr("%1 File").arg(name.mid(dot + 1).toUpper());
+}
+
+
+OverwriteModel::OverwriteModel(QObject* parent)
+  : QAbstractItemModel(parent), m_Root(new Node), m_Generation(0),
+    m_SortColumn(FileName), m_SortOrder(Qt::AscendingOrder)
+{
+  m_Root->isDir = true;
+
+  QFileIconProvider icons;
+  m_FolderIcon = icons.icon(QFileIconProvider::Folder);
+  m_FileIcon = icons.icon(QFileIconProvider::File);
+}
+
+OverwriteModel::~OverwriteModel()
+{
+  // the tasks reference the model, the group waits for them
+  if (m_SizeTasks) {
+    m_SizeTasks->cancel();
+  }
+}
+
+void OverwriteModel::load(
+  const QString& rootPath, const DirectoryEntry& structure, int originID)
+{
+  beginResetModel();
+
+  if (m_SizeTasks) {
+    m_SizeTasks->cancel();
+    m_SizeTasks.reset();
+  }
+
+  ++m_Generation;
+  m_Sizes.clear();
+
+  m_RootPath = QDir::fromNativeSeparators(rootPath);
+  m_Root.reset(new Node);
+  m_Root->isDir = true;
+
+  if (structure.findOriginByID(originID)) {
+    addDirectory(*m_Root, structure, originID);
+  }
+
+  sortChildren(m_Root.get());
+
+  endResetModel();
+
+  startSizes();
+}
+
+void OverwriteModel::addDirectory(
+  Node& parent, const DirectoryEntry& d, int originID)
+{
+  d.forEachDirectory([&](const DirectoryEntry& sub) {
+    // directories are tagged with all the origins that have something in
+    // them, including empty directories
+    if (sub.hasContentsFromOrigin(originID)) {
+      auto n = std::make_unique<Node>();
+      n->name = QString::fromStdWString(sub.getName());
+      n->isDir = true;
+
+      Node* child = parent.add(std::move(n));
+      addDirectory(*child, sub, originID);
+      parent.pending += child->pending;
+    }
+
+    return true;
+  });
+
+  d.forEachFile([&](const FileEntry& f) {
+    if (!isFromOrigin(f, originID)) {
+      return true;
+    }
+
+    const auto name = f.getName();
+
+    auto n = std::make_unique<Node>();
+    n->name = QString::fromWCharArray(name.data(), static_cast<int>(name.size()));
+    n->lastModified = toDateTime(f.getFileTime());
+    n->pending = 1;
+    n->sizeIndex = m_Sizes.size();
+
+    m_Sizes.push_back(parent.add(std::move(n)));
+    ++parent.pending;
+
+    return true;
+  });
+}
+
+void OverwriteModel::startSizes()
+{
+  if (m_Sizes.empty()) {
+    return;
+  }
+
+  auto paths = std::make_shared<std::vector<std::wstring>>();
+  paths->reserve(m_Sizes.size());
+
+  for (const auto* n : m_Sizes) {
+    paths->push_back(QDir::toNativeSeparators(nodePath(n)).toStdWString());
+  }
+
+  m_SizeTasks = std::make_unique<TaskGroup>(TaskPriority::Normal);
+
+  auto* group = m_SizeTasks.get();
+  const int generation = m_Generation;
+
+  for (std::size_t begin=0; begin<paths->size(); begin+=SizesPerTask) {
+    const std::size_t end = std::min(begin + SizesPerTask, paths->size());
+
+    group->run([this, group, paths, begin, end, generation] {
+      std::vector<Size> sizes;
+      sizes.reserve(end - begin);
+
+      for (std::size_t i=begin; i<end; ++i) {
+        if (group->cancelled()) {
+          return;
+        }
+
+        Size s{i, 0, {}};
+        WIN32_FILE_ATTRIBUTE_DATA fa = {};
+
+        // files that are gone count as empty, they're removed from the model
+        // when the structure is refreshed
+        if (::GetFileAttributesExW((*paths)[i].c_str(), GetFileExInfoStandard, &fa)) {
+          s.size = (static_cast<uint64_t>(fa.nFileSizeHigh) << 32) | fa.nFileSizeLow;
+          s.lastModified = toDateTime(fa.ftLastWriteTime);
+        }
+
+        sizes.push_back(std::move(s));
+      }
+
+      QMetaObject::invokeMethod(this, [this, generation, sizes=std::move(sizes)] {
+        onSizes(generation, sizes);
+      }, Qt::QueuedConnection);
+    });
+  }
+}
+
+void OverwriteModel::onSizes(int generation, const std::vector<Size>& sizes)
+{
+  if (generation != m_Generation) {
+    // from a previous load()
+    return;
+  }
+
+  std::unordered_set<Node*> changed;
+
+  for (const auto& s : sizes) {
+    if (s.index >= m_Sizes.size()) {
+      continue;
+    }
+
+    Node* n = m_Sizes[s.index];
+    if (!n) {
+      // removed
+      continue;
+    }
+
+    m_Sizes[s.index] = nullptr;
+
+    n->size = s.size;
+    n->pending = 0;
+
+    if (s.lastModified.isValid()) {
+      n->lastModified = s.lastModified;
+    }
+
+    changed.insert(n);
+
+    for (Node* p=n->parent; p; p=p->parent) {
+      p->size += s.size;
+      --p->pending;
+      changed.insert(p);
+    }
+  }
+
+  for (const Node* n : changed) {
+    if (n != m_Root.get()) {
+      emit dataChanged(indexFromNode(n, FileSize), indexFromNode(n, LastModified));
+    }
+  }
+}
+
+void OverwriteModel::forgetSizes(Node* n)
+{
+  if (n->sizeIndex < m_Sizes.size()) {
+    m_Sizes[n->sizeIndex] = nullptr;
+  }
+
+  for (auto&& c : n->children) {
+    forgetSizes(c.get());
+  }
+}
+
+const QString& OverwriteModel::rootPath() const
+{
+  return m_RootPath;
+}
+
+QString OverwriteModel::filePath(const QModelIndex& index) const
+{
+  const Node* n = nodeFromIndex(index);
+  return (n ? nodePath(n) : QString());
+}
+
+QString OverwriteModel::fileName(const QModelIndex& index) const
+{
+  const Node* n = nodeFromIndex(index);
+  return (n ? n->name : QString());
+}
+
+bool OverwriteModel::isDir(const QModelIndex& index) const
+{
+  const Node* n = nodeFromIndex(index);
+  return (n && n->isDir);
+}
+
+QString OverwriteModel::relativePath(const QModelIndex& index) const
+{
+  QString path;
+
+  for (const Node* n=nodeFromIndex(index); n && n != m_Root.get(); n=n->parent) {
+    path = path.isEmpty() ? n->name : (n->name + "/" + path);
+  }
+
+  return path;
+}
+
+QModelIndex OverwriteModel::indexOf(const QString& relativePath) const
+{
+  QModelIndex index;
+
+  for (const auto& name : relativePath.split('/', QString::SkipEmptyParts)) {
+    index = child(index, name);
+    if (!index.isValid()) {
+      break;
+    }
+  }
+
+  return index;
+}
+
+QModelIndex OverwriteModel::child(const QModelIndex& parent, const QString& name) const
+{
+  const Node* p = nodeFromIndex(parent);
+  if (!p) {
+    return {};
+  }
+
+  for (const auto& c : p->children) {
+    if (c->name.compare(name, Qt::CaseInsensitive) == 0) {
+      return indexFromNode(c.get());
+    }
+  }
+
+  return {};
+}
+
+bool OverwriteModel::remove(const QModelIndex& index)
+{
+  Node* n = nodeFromIndex(index);
+  if (!index.isValid() || !n) {
+    return false;
+  }
+
+  const QString path = nodePath(n);
+  const bool removed = n->isDir ?
+    QDir(path).removeRecursively() : QFile::remove(path);
+
+  if (!removed && QFileInfo::exists(path)) {
+    log::error("failed to delete {}", path);
+    return false;
+  }
+
+  Node* p = n->parent;
+
+  for (Node* a=p; a; a=a->parent) {
+    a->size -= n->size;
+    a->pending -= n->pending;
+  }
+
+  forgetSizes(n);
+
+  const int row = n->row;
+
+  beginRemoveRows(indexFromNode(p), row, row);
+  p->children.erase(p->children.begin() + row);
+  p->renumber(row);
+  endRemoveRows();
+
+  for (const Node* a=p; a && a != m_Root.get(); a=a->parent) {
+    const auto i = indexFromNode(a, FileSize);
+    emit dataChanged(i, i);
+  }
+
+  return true;
+}
+
+QModelIndex OverwriteModel::mkdir(const QModelIndex& parent, const QString& name)
+{
+  Node* p = nodeFromIndex(parent);
+  if (!p || !p->isDir) {
+    return {};
+  }
+
+  const QString path = nodePath(p) + "/" + name;
+
+  if (!QDir().mkdir(path)) {
+    log::error("failed to create directory {}", path);
+    return {};
+  }
+
+  auto n = std::make_unique<Node>();
+  n->name = name;
+  n->isDir = true;
+  n->parent = p;
+
+  // inserted where it would have been sorted
+  auto itor = std::upper_bound(
+    p->children.begin(), p->children.end(), n, [&](auto&& a, auto&& b) {
+      return lessThan(a.get(), b.get());
+    });
+
+  const auto row = static_cast<int>(itor - p->children.begin());
+
+  beginInsertRows(indexFromNode(p), row, row);
+  p->children.insert(itor, std::move(n));
+  p->renumber(row);
+  endInsertRows();
+
+  return indexFromNode(p->children[row].get());
+}
+
+QModelIndex OverwriteModel::index(int row, int col, const QModelIndex& parent) const
+{
+  const Node* p = nodeFromIndex(parent);
+
+  if (!p || row < 0 || row >= static_cast<int>(p->children.size())) {
+    return {};
+  }
+
+  if (col < 0 || col >= ColumnCount) {
+    return {};
+  }
+
+  return createIndex(row, col, p->children[row].get());
+}
+
+QModelIndex OverwriteModel::parent(const QModelIndex& index) const
+{
+  const Node* n = nodeFromIndex(index);
+  if (!index.isValid() || !n) {
+    return {};
+  }
+
+  return indexFromNode(n->parent);
+}
+
+int OverwriteModel::rowCount(const QModelIndex& parent) const
+{
+  if (parent.column() > 0) {
+    return 0;
+  }
+
+  const Node* n = nodeFromIndex(parent);
+  return (n ? static_cast<int>(n->children.size()) : 0);
+}
+
+int OverwriteModel::columnCount(const QModelIndex&) const
+{
+  return ColumnCount;
+}
+
+bool OverwriteModel::hasChildren(const QModelIndex& parent) const
+{
+  return (rowCount(parent) > 0);
+}
+
+QVariant OverwriteModel::data(const QModelIndex& index, int role) const
+{
+  const Node* n = nodeFromIndex(index);
+  if (!index.isValid() || !n) {
+    return {};
+  }
+
+  switch (role)
+  {
+    case Qt::DisplayRole:
+    {
+      switch (index.column())
+      {
+        case FileName:
+          return n->name;
+
+        case FileSize:
+          // directories are shown once all their files are known
+          if (n->pending > 0) {
+            return {};
+          }
+
+          return localizedByteSize(n->size);
+
+        case FileType:
+          return fileType(n->name, n->isDir);
+
+        case LastModified:
+          return n->lastModified;
+      }
+
+      break;
+    }
+
+    case Qt::EditRole:
+    {
+      if (index.column() == FileName) {
+        return n->name;
+      }
+
+      break;
+    }
+
+    case Qt::DecorationRole:
+    {
+      if (index.column() == FileName) {
+        return (n->isDir ? m_FolderIcon : m_FileIcon);
+      }
+
+      break;
+    }
+
+    case Qt::TextAlignmentRole:
+    {
+      if (index.column() == FileSize) {
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+      }
+
+      break;
+    }
+  }
+
+  return {};
+}
+
+QVariant OverwriteModel::headerData(int section, Qt::Orientation ori, int role) const
+{
+  if (ori != Qt::Horizontal || role != Qt::DisplayRole) {
+    return {};
+  }
+
+  switch (section)
+  {
+    case FileName:
+      return tr("Name");
+
+    case FileSize:
+      return tr("Size");
+
+    case FileType:
+      return tr("Type");
+
+    case LastModified:
+      return tr("Date Modified");
+
+    default:
+      return {};
+  }
+}
+
+Qt::ItemFlags OverwriteModel::flags(const QModelIndex& index) const
+{
+  if (!index.isValid()) {
+    return Qt::NoItemFlags;
+  }
+
+  auto f = Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled;
+
+  if (index.column() == FileName) {
+    f |= Qt::ItemIsEditable;
+  }
+
+  return f;
+}
+
+bool OverwriteModel::setData(const QModelIndex& index, const QVariant& v, int role)
+{
+  Node* n = nodeFromIndex(index);
+
+  if (!index.isValid() || !n || role != Qt::EditRole || index.column() != FileName) {
+    return false;
+  }
+
+  const QString newName = v.toString().trimmed();
+
+  if (newName.isEmpty() || newName == n->name) {
+    return false;
+  }
+
+  if (newName.contains('/') || newName.contains('\\')) {
+    reportError(tr("Invalid name \"%1\"").arg(newName));
+    return false;
+  }
+
+  const auto existing = child(index.parent(), newName);
+
+  if (existing.isValid() && existing.row() != index.row()) {
+    reportError(tr("\"%1\" already exists").arg(newName));
+    return false;
+  }
+
+  const QString oldPath = nodePath(n);
+  const QString newPath = nodePath(n->parent) + "/" + newName;
+
+  if (!QDir().rename(oldPath, newPath)) {
+    log::error("failed to rename {} to {}", oldPath, newPath);
+    reportError(tr("Failed to rename \"%1\" to \"%2\"").arg(n->name).arg(newName));
+    return false;
+  }
+
+  n->name = newName;
+  emit dataChanged(index, index.sibling(index.row(), FileType));
+
+  return true;
+}
+
+void OverwriteModel::sort(int column, Qt::SortOrder order)
+{
+  m_SortColumn = column;
+  m_SortOrder = order;
+
+  emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+  const auto before = persistentIndexList();
+
+  std::vector<const Node*> nodes;
+  nodes.reserve(before.size());
+
+  for (const auto& i : before) {
+    nodes.push_back(i.isValid() ? nodeFromIndex(i) : nullptr);
+  }
+
+  sortChildren(m_Root.get());
+
+  QModelIndexList after;
+  after.reserve(before.size());
+
+  for (int i=0; i<before.size(); ++i) {
+    after.push_back(nodes[i] ? indexFromNode(nodes[i], before[i].column()) : QModelIndex());
+  }
+
+  changePersistentIndexList(before, after);
+
+  emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void OverwriteModel::sortChildren(Node* n)
+{
+  std::stable_sort(n->children.begin(), n->children.end(), [&](auto&& a, auto&& b) {
+    return lessThan(a.get(), b.get());
+  });
+
+  n->renumber();
+
+  for (auto&& c : n->children) {
+    if (c->isDir) {
+      sortChildren(c.get());
+    }
+  }
+}
+
+bool OverwriteModel::lessThan(const Node* a, const Node* b) const
+{
+  // directories always go first
+  if (a->isDir != b->isDir) {
+    return a->isDir;
+  }
+
+  int r = 0;
+
+  switch (m_SortColumn)
+  {
+    case FileSize:
+      r = (a->size < b->size) ? -1 : (a->size > b->size ? 1 : 0);
+      break;
+
+    case FileType:
+      r = naturalCompare(fileType(a->name, a->isDir), fileType(b->name, b->isDir));
+      break;
+
+    case LastModified:
+      r = (a->lastModified < b->lastModified) ? -1 :
+        (b->lastModified < a->lastModified ? 1 : 0);
+      break;
+  }
+
+  if (r == 0) {
+    r = naturalCompare(a->name, b->name);
+  }
+
+  return (m_SortOrder == Qt::AscendingOrder) ? (r < 0) : (r > 0);
+}
+
+QStringList OverwriteModel::mimeTypes() const
+{
+  return {"text/uri-list"};
+}
+
+QMimeData* OverwriteModel::mimeData(const QModelIndexList& indexes) const
+{
+  QList<QUrl> urls;
+
+  for (const auto& i : indexes) {
+    if (i.column() == FileName) {
+      urls.append(QUrl::fromLocalFile(filePath(i)));
+    }
+  }
+
+  auto* data = new QMimeData;
+  data->setUrls(urls);
+
+  return data;
+}
+
+Qt::DropActions OverwriteModel::supportedDragActions() const
+{
+  return Qt::MoveAction | Qt::CopyAction;
+}
+
+OverwriteModel::Node* OverwriteModel::nodeFromIndex(const QModelIndex& index) const
+{
+  if (!index.isValid()) {
+    return m_Root.get();
+  }
+
+  return static_cast<Node*>(index.internalPointer());
+}
+
+QModelIndex OverwriteModel::indexFromNode(const Node* n, int col) const
+{
+  if (!n || n == m_Root.get()) {
+    return {};
+  }
+
+  return createIndex(n->row, col, const_cast<Node*>(n));
+}
+
+QString OverwriteModel::nodePath(const Node* n) const
+{
+  if (!n->parent) {
+    return m_RootPath;
+  }
+
+  return nodePath(n->parent) + "/" + n->name;
+}
+
+
+OverwriteInfoDialog::OverwriteInfoDialog(
+  ModInfo::Ptr modInfo, OrganizerCore& core, QWidget *parent)
+  : QDialog(parent), ui(new Ui::OverwriteInfoDialog), m_Core(core),
+    m_FileSystemModel(nullptr), m_DeleteAction(nullptr),
+    m_RenameAction(nullptr), m_OpenAction(nullptr)
 {
   ui->setupUi(this);
 
   this->setWindowModality(Qt::NonModal);
 
-  m_FileSystemModel = new OverwriteFileSystemModel(this);
-  m_FileSystemModel->setReadOnly(false);
-  setModInfo(modInfo);
+  m_FileSystemModel = new OverwriteModel(this);
   ui->filesView->setModel(m_FileSystemModel);
-  ui->filesView->setRootIndex(m_FileSystemModel->index(modInfo->absolutePath()));
+  setModInfo(modInfo);
   ui->filesView->setColumnWidth(0, 250);
 
   m_DeleteAction = new QAction(tr("&Delete"), ui->filesView);
@@ -55,6 +815,9 @@ OverwriteInfoDialog::OverwriteInfoDialog(ModInfo::Ptr modInfo, QWidget *parent)
   QObject::connect(m_RenameAction, SIGNAL(triggered()), this, SLOT(renameTriggered()));
   QObject::connect(m_OpenAction, SIGNAL(triggered()), this, SLOT(openTriggered()));
   QObject::connect(m_NewFolderAction, SIGNAL(triggered()), this, SLOT(createDirectoryTriggered()));
+
+  // files dragged to mods are moved out of the overwrite
+  connect(&m_Core, &OrganizerCore::directoryStructureReady, this, [this]{ reload(); });
 }
 
 OverwriteInfoDialog::~OverwriteInfoDialog()
@@ -89,47 +852,67 @@ void OverwriteInfoDialog::setModInfo(ModInfo::Ptr modInfo)
 {
   m_ModInfo = modInfo;
   if (QDir(modInfo->absolutePath()).exists()) {
-    m_FileSystemModel->setRootPath(modInfo->absolutePath());
+    reload();
   } else {
     throw MyException(tr("mod not found: %1").arg(qUtf8Printable(modInfo->absolutePath())));
   }
 }
 
-bool OverwriteInfoDialog::recursiveDelete(const QModelIndex &index)
+void OverwriteInfoDialog::reload()
 {
-  for (int childRow = 0; childRow < m_FileSystemModel->rowCount(index); ++childRow) {
-    QModelIndex childIndex = m_FileSystemModel->index(childRow, 0, index);
-    if (m_FileSystemModel->isDir(childIndex)) {
-      if (!recursiveDelete(childIndex)) {
-        log::error("failed to delete {}", m_FileSystemModel->fileName(childIndex));
-        return false;
-      }
-    } else {
-      if (!m_FileSystemModel->remove(childIndex)) {
-        log::error("failed to delete {}", m_FileSystemModel->fileName(childIndex));
-        return false;
+  // expanded directories, restored after the reset
+  QStringList expanded;
+
+  std::function<void (const QModelIndex&)> collect = [&](const QModelIndex& parent) {
+    for (int i=0; i<m_FileSystemModel->rowCount(parent); ++i) {
+      const auto index = m_FileSystemModel->index(i, 0, parent);
+
+      if (ui->filesView->isExpanded(index)) {
+        expanded.push_back(m_FileSystemModel->relativePath(index));
+        collect(index);
       }
     }
+  };
+
+  collect({});
+
+  const DirectoryEntry& structure = *m_Core.directoryStructure();
+  const auto name = m_ModInfo->name().toStdWString();
+
+  const int originID = structure.originExists(name) ?
+    structure.getOriginByName(name).getID() : InvalidOriginID;
+
+  m_FileSystemModel->load(m_ModInfo->absolutePath(), structure, originID);
+
+  for (const auto& path : expanded) {
+    const auto index = m_FileSystemModel->indexOf(path);
+    if (index.isValid()) {
+      ui->filesView->expand(index);
+    }
   }
-  if (!m_FileSystemModel->remove(index)) {
-    log::error("failed to delete {}", m_FileSystemModel->fileName(index));
-    return false;
-  }
-  return true;
 }
 
-
 void OverwriteInfoDialog::deleteFile(const QModelIndex &index)
 {
-
-  bool res = m_FileSystemModel->isDir(index) ? recursiveDelete(index)
-                                             : m_FileSystemModel->remove(index);
-  if (!res) {
+  if (!m_FileSystemModel->remove(index)) {
     QString fileName = m_FileSystemModel->fileName(index);
     reportError(tr("Failed to delete \"%1\"").arg(fileName));
   }
 }
 
+void OverwriteInfoDialog::deleteFiles(const QModelIndexList &indexes)
+{
+  // rows move as files are removed; files in a directory that was removed
+  // before them become invalid
+  std::vector<QPersistentModelIndex> persistent(indexes.begin(), indexes.end());
+
+  for (const auto& index : persistent) {
+    if (index.isValid()) {
+      deleteFile(index);
+    }
+  }
+}
+
 void OverwriteInfoDialog::delete_activated()
 {
 	if (ui->filesView->hasFocus()) {
@@ -154,9 +937,7 @@ void OverwriteInfoDialog::delete_activated()
 				}
 			}
 
-			foreach(QModelIndex index, selection->selectedRows()) {
-				deleteFile(index);
-			}
+			deleteFiles(selection->selectedRows());
 		}
 	}
 }
@@ -178,9 +959,7 @@ void OverwriteInfoDialog::deleteTriggered()
     }
   }
 
-  foreach(QModelIndex index, m_FileSelection) {
-    deleteFile(index);
-  }
+  deleteFiles(m_FileSelection);
 }
 
 
@@ -188,7 +967,7 @@ void OverwriteInfoDialog::renameTriggered()
 {
   QModelIndex selection = m_FileSelection.at(0);
   QModelIndex index = selection.sibling(selection.row(), 0);
-  if (!index.isValid() || m_FileSystemModel->isReadOnly()) {
+  if (!index.isValid()) {
       return;
   }
 
@@ -218,13 +997,12 @@ void OverwriteInfoDialog::createDirectoryTriggered()
   index = index.sibling(index.row(), 0);
 
   QString name = tr("New Folder");
-  QString path = m_FileSystemModel->filePath(index).append("/");
 
-  QModelIndex existingIndex = m_FileSystemModel->index(path + name);
+  QModelIndex existingIndex = m_FileSystemModel->child(index, name);
   int suffix = 1;
   while (existingIndex.isValid()) {
     name = tr("New Folder") + QString::number(suffix++);
-    existingIndex = m_FileSystemModel->index(path + name);
+    existingIndex = m_FileSystemModel->child(index, name);
   }
 
   QModelIndex newIndex = m_FileSystemModel->mkdir(index, name);
@@ -254,7 +1032,7 @@ void OverwriteInfoDialog::on_filesView_customContextMenuRequested(const QPoint &
   bool hasFiles = false;
 
   foreach(QModelIndex idx, m_FileSelection) {
-    if (m_FileSystemModel->fileInfo(idx).isFile()) {
+    if (!m_FileSystemModel->isDir(idx)) {
       hasFiles = true;
       break;
     }
@@ -268,7 +1046,8 @@ void OverwriteInfoDialog::on_filesView_customContextMenuRequested(const QPoint &
     menu.addAction(m_DeleteAction);
   } else {
     m_FileSelection.clear();
-    m_FileSelection.append(m_FileSystemModel->index(m_FileSystemModel->rootPath(), 0));
+    // the root
+    m_FileSelection.append(QModelIndex());
   }
 
   menu.exec(ui->filesView->viewport()->mapToGlobal(pos));
@@ -21,53 +21,147 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #define OVERWRITEINFODIALOG_H
 
 #include "modinfo.h"
+#include <QAbstractItemModel>
+#include <QDateTime>
 #include <QDialog>
-#include <QFileSystemModel>
+#include <QIcon>
+#include <memory>
+#include <vector>
+
+namespace MOShared
+{
+  class DirectoryEntry;
+  class TaskGroup;
+}
+
+class OrganizerCore;
 
 namespace Ui {
 class OverwriteInfoDialog;
 }
 
-class OverwriteFileSystemModel : public QFileSystemModel
+// the files and directories of the overwrite, taken from the directory
+// structure instead of the filesystem so opening the dialog doesn't have to
+// enumerate and stat everything in it
+//
+// the structure doesn't have the size of loose files, they're retrieved by a
+// background pass after load() and summed for each directory as they come
+// in; the size of a directory is shown once all the files in it are known
+//
+// the items can be dragged as urls to other widgets, like the mod list
+//
+class OverwriteModel : public QAbstractItemModel
 {
   Q_OBJECT;
 
 public:
-  OverwriteFileSystemModel(QObject *parent)
-    : QFileSystemModel(parent), m_RegularColumnCount(0) {}
-
-  virtual int columnCount(const QModelIndex &parent) const {
-    m_RegularColumnCount = QFileSystemModel::columnCount(parent);
-    return m_RegularColumnCount;
-  }
-
-  virtual QVariant headerData(int section, Qt::Orientation orientation, int role) const {
-    if ((orientation == Qt::Horizontal) &&
-      (section >= m_RegularColumnCount)) {
-      if (role == Qt::DisplayRole) {
-        return tr("Overwrites");
-      } else {
-        return QVariant();
-      }
-    } else {
-      return QFileSystemModel::headerData(section, orientation, role);
-    }
-  }
-
-  virtual QVariant data(const QModelIndex &index, int role) const {
-    if (index.column() == m_RegularColumnCount + 0) {
-      if (role == Qt::DisplayRole) {
-        return tr("not implemented");
-      } else {
-        return QVariant();
-      }
-    } else {
-      return QFileSystemModel::data(index, role);
-    }
-  }
+  enum Columns
+  {
+    FileName = 0,
+    FileSize,
+    FileType,
+    LastModified,
+
+    ColumnCount
+  };
+
+  OverwriteModel(QObject* parent);
+  ~OverwriteModel();
+
+  // replaces the content with the files and directories of the given origin
+  // in the structure, `rootPath` is the directory of the origin on disk; this
+  // cancels the size pass of the previous load and starts a new one
+  //
+  void load(
+    const QString& rootPath, const MOShared::DirectoryEntry& structure,
+    int originID);
+
+  const QString& rootPath() const;
+
+  // the invalid index is the root
+  //
+  QString filePath(const QModelIndex& index) const;
+  QString fileName(const QModelIndex& index) const;
+  bool isDir(const QModelIndex& index) const;
+
+  // relative path of the given index, with forward slashes; empty for the
+  // root
+  //
+  QString relativePath(const QModelIndex& index) const;
+
+  // index of the given relative path, invalid if it's not in the model
+  //
+  QModelIndex indexOf(const QString& relativePath) const;
+
+  // child of the given directory with the given name, case insensitive
+  //
+  QModelIndex child(const QModelIndex& parent, const QString& name) const;
+
+  // deletes the file or directory from disk and removes it from the model,
+  // returns false on failure, which has been logged
+  //
+  bool remove(const QModelIndex& index);
+
+  // creates a directory in the given directory, returns its index or an
+  // invalid index on failure, which has been logged
+  //
+  QModelIndex mkdir(const QModelIndex& parent, const QString& name);
+
+  QModelIndex index(
+    int row, int col, const QModelIndex& parent={}) const override;
+
+  QModelIndex parent(const QModelIndex& index) const override;
+  int rowCount(const QModelIndex& parent={}) const override;
+  int columnCount(const QModelIndex& parent={}) const override;
+  bool hasChildren(const QModelIndex& parent={}) const override;
+  QVariant data(const QModelIndex& index, int role) const override;
+  QVariant headerData(int section, Qt::Orientation ori, int role) const override;
+  Qt::ItemFlags flags(const QModelIndex& index) const override;
+  void sort(int column, Qt::SortOrder order) override;
+
+  // renames the file or directory on disk
+  //
+  bool setData(const QModelIndex& index, const QVariant& v, int role) override;
+
+  QStringList mimeTypes() const override;
+  QMimeData* mimeData(const QModelIndexList& indexes) const override;
+  Qt::DropActions supportedDragActions() const override;
 
 private:
-  mutable int m_RegularColumnCount;
+  struct Node;
+  struct Size;
+
+  std::unique_ptr<Node> m_Root;
+  QString m_RootPath;
+
+  // files whose size is retrieved by the current pass, by the index given to
+  // the pass; entries are cleared when the files are removed
+  std::vector<Node*> m_Sizes;
+
+  // incremented by each load(), sizes from a previous pass are ignored
+  int m_Generation;
+
+  std::unique_ptr<MOShared::TaskGroup> m_SizeTasks;
+
+  int m_SortColumn;
+  Qt::SortOrder m_SortOrder;
+
+  QIcon m_FolderIcon;
+  QIcon m_FileIcon;
+
+  Node* nodeFromIndex(const QModelIndex& index) const;
+  QModelIndex indexFromNode(const Node* n, int col=0) const;
+  QString nodePath(const Node* n) const;
+
+  void addDirectory(
+    Node& parent, const MOShared::DirectoryEntry& d, int originID);
+
+  void startSizes();
+  void onSizes(int generation, const std::vector<Size>& sizes);
+
+  void forgetSizes(Node* n);
+  void sortChildren(Node* n);
+  bool lessThan(const Node* a, const Node* b) const;
 };
 
 
@@ -77,7 +171,8 @@ class OverwriteInfoDialog : public QDialog
 
 public:
 
-  explicit OverwriteInfoDialog(ModInfo::Ptr modInfo, QWidget *parent = 0);
+  explicit OverwriteInfoDialog(
+    ModInfo::Ptr modInfo, OrganizerCore& core, QWidget *parent = 0);
   ~OverwriteInfoDialog();
 
   ModInfo::Ptr modInfo() const { return m_ModInfo; }
@@ -96,8 +191,12 @@ protected:
 private:
 
   void openFile(const QModelIndex &index);
-  bool recursiveDelete(const QModelIndex &index);
   void deleteFile(const QModelIndex &index);
+  void deleteFiles(const QModelIndexList &indexes);
+
+  // reloads the model from the structure, keeping the expanded directories
+  //
+  void reload();
 
 private slots:
 
@@ -114,7 +213,8 @@ private slots:
 private:
 
   Ui::OverwriteInfoDialog *ui;
-  QFileSystemModel *m_FileSystemModel;
+  OrganizerCore& m_Core;
+  OverwriteModel *m_FileSystemModel;
   QModelIndexList m_FileSelection;
   QAction *m_DeleteAction;
   QAction *m_RenameAction;
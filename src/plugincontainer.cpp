@@ -1,6 +1,10 @@
 #include "plugincontainer.h"
+#include "metrics.h"
+#include "pluginstats.h"
 #include "organizercore.h"
 #include "organizerproxy.h"
+#include "startuptrace.h"
+#include "taskexecutor.h"
 #include "report.h"
 #include <ipluginproxy.h>
 #include "iuserinterface.h"
@@ -413,7 +417,15 @@ bool PluginContainer::initPlugin(IPlugin *plugin, IPluginProxy *pluginProxy, boo
     return true;
   }
 
-  if (!plugin->init(proxy)) {
+  bool initialized = false;
+
+  {
+    // plugins are initialized one after the other on startup
+    PluginCallTimer t(plugin, "init", std::chrono::milliseconds(250));
+    initialized = plugin->init(proxy);
+  }
+
+  if (!initialized) {
     log::warn("plugin failed to initialize");
     return false;
   }
@@ -491,7 +503,10 @@ IPlugin* PluginContainer::registerPlugin(QObject *plugin, const QString& filepat
       bf::at_key<IPluginDiagnose>(m_Plugins).push_back(diagnose);
       bf::at_key<IPluginDiagnose>(m_AccessPlugins)[diagnose] = pluginObj;
       m_DiagnosisConnections.push_back(
-        diagnose->onInvalidated([&] () { emit diagnosisUpdate(); })
+        diagnose->onInvalidated([this, diagnose] () {
+          invalidateProblems(diagnose);
+          emit diagnosisUpdate();
+        })
       );
     }
   }
@@ -806,12 +821,28 @@ QObject* PluginContainer::loadQtPlugin(const QString& filepath)
   if (pluginLoader->instance() == nullptr) {
     m_FailedPlugins.push_back(filepath);
     log::error("failed to load plugin {}: {}", filepath, pluginLoader->errorString());
+
+    if (pluginLoader->metaData().isEmpty()) {
+      // not a Qt plugin at all, as opposed to a plugin that failed because of
+      // a missing dependency, which might work next time
+      PluginManifest::File f;
+      f.isPlugin = false;
+      m_Manifest.set(filepath, std::move(f));
+    }
   }
   else {
     QObject* object = pluginLoader->instance();
     if (IPlugin* plugin = registerPlugin(object, filepath, nullptr); plugin) {
       log::debug("loaded plugin '{}' from '{}' - [{}]",
         plugin->name(), QFileInfo(filepath).fileName(), implementedInterfaces(plugin).join(", "));
+
+      PluginManifest::File f;
+      f.plugins.push_back({
+        plugin->name(), plugin->version().canonicalString(),
+        implementedInterfaces(plugin)});
+
+      m_Manifest.set(filepath, std::move(f));
+
       m_PluginLoaders.push_back(pluginLoader.release());
       return object;
     }
@@ -881,6 +912,9 @@ void PluginContainer::unloadPlugin(MOBase::IPlugin* plugin, QObject* object)
   // Remove from the members.
   if (auto* diagnose = qobject_cast<IPluginDiagnose*>(object)) {
     bf::at_key<IPluginDiagnose>(m_AccessPlugins).erase(diagnose);
+
+    std::scoped_lock lock(m_ProblemsMutex);
+    m_Problems.erase(diagnose);
   }
   if (auto* mapper = qobject_cast<IPluginFileMapper*>(object)) {
     bf::at_key<IPluginFileMapper>(m_AccessPlugins).erase(mapper);
@@ -961,6 +995,11 @@ void PluginContainer::unloadPlugins()
   }
   m_DiagnosisConnections.clear();
 
+  {
+    std::scoped_lock lock(m_ProblemsMutex);
+    m_Problems.clear();
+  }
+
   while (!m_PluginLoaders.empty()) {
     QPluginLoader* loader = m_PluginLoaders.back();
     m_PluginLoaders.pop_back();
@@ -971,9 +1010,48 @@ void PluginContainer::unloadPlugins()
   }
 }
 
+QString PluginContainer::manifestPath() const
+{
+  if (!m_Organizer) {
+    return {};
+  }
+
+  return m_Organizer->settings().paths().cache() + "/plugins.cache";
+}
+
+std::vector<std::unique_ptr<QPluginLoader>> PluginContainer::preloadLibraries(
+  const QStringList& files)
+{
+  StartupTrace::Scope scope("PluginContainer::preloadLibraries()");
+
+  // loaders are created here so they belong to this thread, only load() is
+  // called on the executor
+  std::vector<std::unique_ptr<QPluginLoader>> loaders;
+
+  for (const auto& f : files) {
+    if (QLibrary::isLibrary(f)) {
+      loaders.push_back(std::make_unique<QPluginLoader>(f));
+    }
+  }
+
+  MOShared::TaskGroup g(MOShared::TaskPriority::High);
+
+  for (auto& loader : loaders) {
+    g.run([p=loader.get()] {
+      // errors are reported by loadQtPlugin(), which loads it again
+      p->load();
+    });
+  }
+
+  g.wait();
+
+  return loaders;
+}
+
 void PluginContainer::loadPlugins()
 {
-  TimeThis tt("PluginContainer::loadPlugins()");
+  Metrics::Timer tt("PluginContainer::loadPlugins()");
+  StartupTrace::Scope scope("PluginContainer::loadPlugins()");
 
   unloadPlugins();
 
@@ -984,6 +1062,9 @@ void PluginContainer::loadPlugins()
   QFile loadCheck;
   QString skipPlugin;
 
+  // whether a plugin failed to load last time
+  bool failedLastTime = false;
+
   if (m_Organizer) {
     loadCheck.setFileName(qApp->property("dataPath").toString() + "/plugin_loadcheck.tmp");
 
@@ -995,6 +1076,7 @@ void PluginContainer::loadPlugins()
       }
 
       log::warn("loadcheck file found for plugin '{}'", fileName);
+      failedLastTime = true;
 
       MOBase::TaskDialog dlg;
 
@@ -1040,10 +1122,16 @@ void PluginContainer::loadPlugins()
     loadCheck.open(QIODevice::WriteOnly);
   }
 
+  if (m_Organizer) {
+    m_Manifest.load(manifestPath());
+  }
+
   QString pluginPath = qApp->applicationDirPath() + "/" + ToQString(AppConfig::pluginPath());
   log::debug("looking for plugins in {}", QDir::toNativeSeparators(pluginPath));
   QDirIterator iter(pluginPath, QDir::Files | QDir::NoDotAndDotDot);
 
+  QStringList files;
+
   while (iter.hasNext()) {
     iter.next();
 
@@ -1059,18 +1147,50 @@ void PluginContainer::loadPlugins()
       }
     }
 
+    if (auto f=m_Manifest.find(iter.filePath()); f && !f->isPlugin) {
+      // this library had no plugin metadata last time and hasn't changed,
+      // there's no point in loading it again
+      log::debug("'{}' is not a plugin, skipping", iter.fileName());
+      m_FailedPlugins.push_back(iter.filePath());
+      continue;
+    }
+
+    files.push_back(iter.filePath());
+  }
+
+  // a plugin that crashes while its library is being loaded on another thread
+  // can't be found with the loadcheck file, so everything is loaded on this
+  // thread if something failed last time
+  std::vector<std::unique_ptr<QPluginLoader>> preloaded;
+  if (!failedLastTime) {
+    preloaded = preloadLibraries(files);
+  }
+
+  for (const auto& filepath : files) {
+    const QString filename = QFileInfo(filepath).fileName();
+
     if (loadCheck.isOpen()) {
-      loadCheck.write(iter.fileName().toUtf8());
+      loadCheck.write(filename.toUtf8());
       loadCheck.write("\n");
       loadCheck.flush();
     }
 
-    QString filepath = iter.filePath();
     if (QLibrary::isLibrary(filepath)) {
+      StartupTrace::Scope pluginScope(filename);
       loadQtPlugin(filepath);
     }
   }
 
+  // the plugins that were loaded have their own loader in m_PluginLoaders,
+  // this only unloads the libraries of plugins that failed
+  for (auto& loader : preloaded) {
+    loader->unload();
+  }
+
+  if (m_Organizer) {
+    m_Manifest.save(manifestPath());
+  }
+
   if (skipPlugin.isEmpty()) {
     // remove the load check file on success
     if (loadCheck.isOpen()) {
@@ -1094,10 +1214,124 @@ void PluginContainer::loadPlugins()
 
   if (m_Organizer) {
     bf::at_key<IPluginDiagnose>(m_Plugins).push_back(m_Organizer);
+    m_DiagnosisConnections.push_back(
+      m_Organizer->onInvalidated([this] () {
+        invalidateProblems(m_Organizer);
+        emit diagnosisUpdate();
+      })
+    );
     m_Organizer->connectPlugins(this);
   }
 }
 
+std::vector<unsigned int> PluginContainer::problems(IPluginDiagnose* diagnose) const
+{
+  std::size_t generation = 0;
+
+  {
+    std::scoped_lock lock(m_ProblemsMutex);
+
+    auto itor = m_Problems.find(diagnose);
+    if (itor == m_Problems.end()) {
+      CachedProblems cp;
+      cp.events = invalidatingEvents(diagnose);
+      itor = m_Problems.emplace(diagnose, std::move(cp)).first;
+    }
+
+    if (itor->second.valid) {
+      return itor->second.problems;
+    }
+
+    generation = itor->second.generation;
+  }
+
+  // diagnoses can take a while, they're done without the lock, so the same
+  // plugin might be diagnosed twice if it's requested from two threads
+  std::vector<unsigned int> problems;
+
+  {
+    PluginCallTimer t(plugin(diagnose), "activeProblems");
+    problems = diagnose->activeProblems();
+  }
+
+  {
+    std::scoped_lock lock(m_ProblemsMutex);
+
+    auto itor = m_Problems.find(diagnose);
+    if (itor != m_Problems.end() && itor->second.generation == generation) {
+      itor->second.problems = problems;
+      itor->second.valid = true;
+    }
+  }
+
+  return problems;
+}
+
+void PluginContainer::invalidateProblems(DiagnoseEvents events)
+{
+  std::scoped_lock lock(m_ProblemsMutex);
+
+  for (auto&& [diagnose, cp] : m_Problems) {
+    if (cp.events & events) {
+      cp.valid = false;
+      ++cp.generation;
+    }
+  }
+}
+
+void PluginContainer::invalidateProblems(IPluginDiagnose* diagnose)
+{
+  std::scoped_lock lock(m_ProblemsMutex);
+
+  auto itor = m_Problems.find(diagnose);
+  if (itor != m_Problems.end()) {
+    itor->second.valid = false;
+    ++itor->second.generation;
+  }
+}
+
+PluginContainer::DiagnoseEvents PluginContainer::invalidatingEvents(
+  IPluginDiagnose* diagnose) const
+{
+  // failed plugins only change when plugins are loaded, which clears the cache
+  if (diagnose == this) {
+    return DiagnoseEvent::None;
+  }
+
+  // hook.dll in the game directory and the sanity checks
+  if (m_Organizer && diagnose == m_Organizer) {
+    return DiagnoseEvent::Refreshed | DiagnoseEvent::SettingsChanged;
+  }
+
+  auto* object = dynamic_cast<QObject*>(diagnose);
+  if (!object) {
+    return DiagnoseEvent::All;
+  }
+
+  const QVariant v = object->property("invalidatedBy");
+  if (!v.isValid()) {
+    return DiagnoseEvent::All;
+  }
+
+  DiagnoseEvents events = DiagnoseEvent::None;
+
+  for (const auto& s : v.toStringList()) {
+    if (s == "refresh") {
+      events |= DiagnoseEvent::Refreshed;
+    } else if (s == "profile") {
+      events |= DiagnoseEvent::ProfileChanged;
+    } else if (s == "settings") {
+      events |= DiagnoseEvent::SettingsChanged;
+    } else {
+      log::warn(
+        "diagnose plugin '{}' is invalidated by unknown event '{}'",
+        object->objectName(), s);
+    }
+  }
+
+  return events;
+}
+
 std::vector<unsigned int> PluginContainer::activeProblems() const
 {
   std::vector<unsigned int> problems;
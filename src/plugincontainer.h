@@ -2,6 +2,7 @@
 #define PLUGINCONTAINER_H
 
 #include "previewgenerator.h"
+#include "pluginmanifest.h"
 
 class OrganizerCore;
 class IUserInterface;
@@ -23,6 +24,7 @@ class IUserInterface;
 #endif // Q_MOC_RUN
 #include <vector>
 #include <memory>
+#include <mutex>
 
 
 class OrganizerProxy;
@@ -184,6 +186,24 @@ public:
    */
   static QStringList pluginInterfaces();
 
+  // events after which the problems of diagnose plugins may have changed,
+  // see problems()
+  //
+  enum class DiagnoseEvent
+  {
+    None            = 0x00,
+
+    // the directory structure has been refreshed
+    Refreshed       = 0x01,
+
+    ProfileChanged  = 0x02,
+    SettingsChanged = 0x04,
+
+    All             = Refreshed | ProfileChanged | SettingsChanged
+  };
+
+  Q_DECLARE_FLAGS(DiagnoseEvents, DiagnoseEvent);
+
 public:
 
   PluginContainer(OrganizerCore* organizer);
@@ -349,6 +369,25 @@ public:
    */
   QStringList pluginFileNames() const;
 
+  /**
+   * @brief Retrieve the active problems of the given diagnose plugin.
+   *
+   * The problems are cached until the plugin invalidates them with
+   * IPluginDiagnose::invalidate() or until one of the events it depends on
+   * happens, see invalidateProblems(). Plugins can declare these events with
+   * an "invalidatedBy" property on their object, a list of "refresh",
+   * "profile" and "settings"; plugins without it depend on all of them.
+   *
+   * This can be called from any thread.
+   */
+  std::vector<unsigned int> problems(MOBase::IPluginDiagnose* diagnose) const;
+
+  /**
+   * @brief Drop the cached problems of the plugins that depend on the given
+   *     events, see problems().
+   */
+  void invalidateProblems(DiagnoseEvents events);
+
 public: // IPluginDiagnose interface
 
   virtual std::vector<unsigned int> activeProblems() const;
@@ -380,6 +419,12 @@ private:
   // Unload all the plugins.
   void unloadPlugins();
 
+  // Events the problems of the given plugin depend on, see problems().
+  DiagnoseEvents invalidatingEvents(MOBase::IPluginDiagnose* diagnose) const;
+
+  // Drop the cached problems of the given plugin.
+  void invalidateProblems(MOBase::IPluginDiagnose* diagnose);
+
   // Retrieve the organizer proxy for the given plugin.
   OrganizerProxy* organizerProxy(MOBase::IPlugin* plugin) const;
 
@@ -396,6 +441,15 @@ private:
   // Load the Qt plugin from the given file.
   QObject* loadQtPlugin(const QString& filepath);
 
+  // Path of the manifest in the cache directory, empty without an organizer.
+  QString manifestPath() const;
+
+  // Load the libraries of the given Qt plugins on the task executor, without
+  // instantiating them. Qt shares libraries between loaders, so this makes
+  // loadQtPlugin() faster for these files. The returned loaders hold a
+  // reference on the libraries until they are unloaded.
+  std::vector<std::unique_ptr<QPluginLoader>> preloadLibraries(const QStringList& files);
+
   // See startPlugins for more details. This is simply an intermediate function
   // that can be used when loading plugins after initialization. This uses the
   // user interface in m_UserInterface.
@@ -477,13 +531,32 @@ private:
 
   std::map<QString, MOBase::IPluginGame*> m_SupportedGames;
   std::vector<boost::signals2::connection> m_DiagnosisConnections;
+
+  // Problems of the diagnose plugins, see problems(); the generation is
+  // incremented when the problems are invalidated so a diagnosis that was
+  // running at that time isn't cached.
+  struct CachedProblems
+  {
+    std::vector<unsigned int> problems;
+    DiagnoseEvents events;
+    bool valid = false;
+    std::size_t generation = 0;
+  };
+
+  mutable std::mutex m_ProblemsMutex;
+  mutable std::map<MOBase::IPluginDiagnose*, CachedProblems> m_Problems;
   QStringList m_FailedPlugins;
   std::vector<QPluginLoader*> m_PluginLoaders;
 
   PreviewGenerator m_PreviewGenerator;
 
   QFile m_PluginsCheck;
+
+  // What was found in the plugin files last time, see PluginManifest.
+  PluginManifest m_Manifest;
 };
 
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(PluginContainer::DiagnoseEvents);
+
 #endif // PLUGINCONTAINER_H
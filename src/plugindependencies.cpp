@@ -0,0 +1,111 @@
+#include "plugindependencies.h"
+#include <vector>
+
+static const PluginDependencies::Names EmptyNames;
+
+
+void PluginDependencies::clear()
+{
+  m_Masters.clear();
+  m_Dependents.clear();
+}
+
+void PluginDependencies::set(const QString& plugin, const Names& masters)
+{
+  remove(plugin);
+
+  if (masters.empty()) {
+    return;
+  }
+
+  m_Masters[plugin] = masters;
+
+  for (const auto& m : masters) {
+    m_Dependents[m].insert(plugin);
+  }
+}
+
+void PluginDependencies::remove(const QString& plugin)
+{
+  auto itor = m_Masters.find(plugin);
+  if (itor == m_Masters.end()) {
+    return;
+  }
+
+  for (const auto& m : itor->second) {
+    auto d = m_Dependents.find(m);
+    if (d == m_Dependents.end()) {
+      continue;
+    }
+
+    d->second.erase(plugin);
+    if (d->second.empty()) {
+      m_Dependents.erase(d);
+    }
+  }
+
+  m_Masters.erase(itor);
+}
+
+const PluginDependencies::Names& PluginDependencies::masters(
+  const QString& plugin) const
+{
+  auto itor = m_Masters.find(plugin);
+  if (itor == m_Masters.end()) {
+    return EmptyNames;
+  }
+
+  return itor->second;
+}
+
+const PluginDependencies::Names& PluginDependencies::dependents(
+  const QString& plugin) const
+{
+  auto itor = m_Dependents.find(plugin);
+  if (itor == m_Dependents.end()) {
+    return EmptyNames;
+  }
+
+  return itor->second;
+}
+
+PluginDependencies::Names PluginDependencies::requiredMasters(
+  const QString& plugin) const
+{
+  return closure(m_Masters, plugin);
+}
+
+PluginDependencies::Names PluginDependencies::allDependents(
+  const QString& plugin) const
+{
+  return closure(m_Dependents, plugin);
+}
+
+PluginDependencies::Names PluginDependencies::closure(
+  const std::map<QString, Names, MOBase::FileNameComparator>& edges,
+  const QString& plugin)
+{
+  Names seen;
+  std::vector<QString> todo = {plugin};
+
+  while (!todo.empty()) {
+    const QString current = std::move(todo.back());
+    todo.pop_back();
+
+    auto itor = edges.find(current);
+    if (itor == edges.end()) {
+      continue;
+    }
+
+    for (const auto& next : itor->second) {
+      if (seen.insert(next).second) {
+        todo.push_back(next);
+      }
+    }
+  }
+
+  // a cycle may lead back to the plugin itself
+  seen.erase(plugin);
+
+  return seen;
+}
@@ -0,0 +1,63 @@
+#ifndef MODORGANIZER_PLUGINDEPENDENCIES_INCLUDED
+#define MODORGANIZER_PLUGINDEPENDENCIES_INCLUDED
+
+#include <utility.h>
+#include <QString>
+#include <map>
+#include <set>
+
+// masters of every plugin in the plugin list and, for every plugin, the
+// plugins that have it as a master, so what depends on a plugin doesn't
+// require going through the whole list
+//
+// plugins are identified by name; masters don't have to be known plugins,
+// a missing master still has its dependents
+//
+class PluginDependencies
+{
+public:
+  using Names = std::set<QString, MOBase::FileNameComparator>;
+
+  // forgets everything
+  //
+  void clear();
+
+  // replaces the masters of the given plugin
+  //
+  void set(const QString& plugin, const Names& masters);
+
+  // forgets the masters of the given plugin; the plugins that have it as a
+  // master keep it
+  //
+  void remove(const QString& plugin);
+
+  // masters of the given plugin, as they are in its header
+  //
+  const Names& masters(const QString& plugin) const;
+
+  // plugins that have the given one as a master
+  //
+  const Names& dependents(const QString& plugin) const;
+
+  // masters of the given plugin and all of their own masters, recursively;
+  // this doesn't contain the plugin itself, even with cycles
+  //
+  Names requiredMasters(const QString& plugin) const;
+
+  // plugins that depend on the given one, directly or through other plugins;
+  // this doesn't contain the plugin itself, even with cycles
+  //
+  Names allDependents(const QString& plugin) const;
+
+private:
+  std::map<QString, Names, MOBase::FileNameComparator> m_Masters;
+  std::map<QString, Names, MOBase::FileNameComparator> m_Dependents;
+
+  // walks the given edges from the given plugin
+  //
+  static Names closure(
+    const std::map<QString, Names, MOBase::FileNameComparator>& edges,
+    const QString& plugin);
+};
+
+#endif // MODORGANIZER_PLUGINDEPENDENCIES_INCLUDED
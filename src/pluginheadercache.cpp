@@ -0,0 +1,295 @@
+#include "pluginheadercache.h"
+#include "metrics.h"
+#include "taskexecutor.h"
+#include "shared/ioaccounting.h"
+#include "shared/util.h"
+#include <espfile.h>
+#include <log.h>
+#include <safewritefile.h>
+#include <utility.h>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <set>
+
+using namespace MOBase;
+using MOShared::IoAccounting;
+
+// changed every time the format of the file changes, files with another
+// version are ignored
+static constexpr quint32 CacheMagic = 0x4d4f5048;  // "MOPH"
+static constexpr quint32 CacheVersion = 1;
+
+static constexpr uint64_t UnknownSize = std::numeric_limits<uint64_t>::max();
+
+static bool sameTime(const FILETIME& a, const FILETIME& b)
+{
+  return
+    a.dwLowDateTime == b.dwLowDateTime &&
+    a.dwHighDateTime == b.dwHighDateTime;
+}
+
+
+PluginHeaderCache::PluginHeaderCache()
+  : m_Dirty(false)
+{
+}
+
+void PluginHeaderCache::setFilename(const QString& path)
+{
+  if (m_Filename == path) {
+    return;
+  }
+
+  save();
+
+  m_Filename = path;
+  m_Entries.clear();
+  m_Dirty = false;
+
+  load();
+}
+
+std::vector<std::shared_ptr<const PluginHeaderCache::Header>>
+PluginHeaderCache::get(std::vector<File>& files)
+{
+  Metrics::Timer tt("PluginHeaderCache::get()");
+
+  std::vector<std::shared_ptr<const Header>> headers(files.size());
+  std::vector<QString> keys(files.size());
+  std::vector<char> exists(files.size(), true);
+
+  // the size and time of files that are not known, such as plugins that were
+  // added to the structure without walking their mod, and the parsing of
+  // files that are not in the cache both hit the disk, so they're both done
+  // in parallel
+  {
+    MOShared::TaskGroup g(MOShared::TaskPriority::High);
+
+    for (std::size_t i=0; i<files.size(); ++i) {
+      keys[i] = key(files[i].path);
+
+      auto& f = files[i];
+      const bool known =
+        (f.size != UnknownSize) &&
+        (f.lastModified.dwLowDateTime != 0 || f.lastModified.dwHighDateTime != 0);
+
+      if (known) {
+        if (auto h=find(keys[i], f)) {
+          headers[i] = h;
+          continue;
+        }
+      }
+
+      // the cache is not modified until all the tasks are done, so they can
+      // look it up
+      g.run([&, i, known] {
+        auto& f = files[i];
+
+        if (!known) {
+          if (!stat(f)) {
+            exists[i] = false;
+            return;
+          }
+
+          if (auto h=find(keys[i], f)) {
+            headers[i] = h;
+            return;
+          }
+        }
+
+        headers[i] = parse(f.path);
+      });
+    }
+
+    g.wait();
+  }
+
+  for (std::size_t i=0; i<files.size(); ++i) {
+    if (!exists[i] || !headers[i]) {
+      continue;
+    }
+
+    auto& e = m_Entries[keys[i]];
+
+    if (e.header != headers[i]) {
+      e.size = files[i].size;
+      e.lastModified = files[i].lastModified;
+      e.header = headers[i];
+      m_Dirty = true;
+    }
+  }
+
+  return headers;
+}
+
+void PluginHeaderCache::prune(const std::vector<QString>& keep)
+{
+  std::set<QString> keys;
+  for (const auto& path : keep) {
+    keys.insert(key(path));
+  }
+
+  for (auto itor=m_Entries.begin(); itor!=m_Entries.end();) {
+    if (!keys.contains(itor->first)) {
+      itor = m_Entries.erase(itor);
+      m_Dirty = true;
+    } else {
+      ++itor;
+    }
+  }
+}
+
+void PluginHeaderCache::save()
+{
+  if (!m_Dirty || m_Filename.isEmpty()) {
+    return;
+  }
+
+  QByteArray data;
+
+  {
+    QDataStream s(&data, QIODevice::WriteOnly);
+    s.setVersion(QDataStream::Qt_5_12);
+
+    s << CacheMagic << CacheVersion << static_cast<quint32>(m_Entries.size());
+
+    for (auto&& [path, e] : m_Entries) {
+      const auto& h = *e.header;
+
+      s
+        << path
+        << static_cast<quint64>(e.size)
+        << static_cast<quint32>(e.lastModified.dwLowDateTime)
+        << static_cast<quint32>(e.lastModified.dwHighDateTime)
+        << h.isMaster << h.isLight << h.author << h.description << h.masters;
+    }
+  }
+
+  // the cache directory may not exist yet
+  QDir().mkpath(QFileInfo(m_Filename).absolutePath());
+
+  try
+  {
+    SafeWriteFile file(m_Filename);
+    file->resize(0);
+    file->write(data);
+    file.commit();
+
+    m_Dirty = false;
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to save plugin header cache to {}: {}", m_Filename, e.what());
+  }
+}
+
+void PluginHeaderCache::load()
+{
+  QFile file(m_Filename);
+  if (!file.open(QIODevice::ReadOnly)) {
+    // not necessarily a problem, the file may just not exist (yet)
+    return;
+  }
+
+  QDataStream s(&file);
+  s.setVersion(QDataStream::Qt_5_12);
+
+  quint32 magic = 0, version = 0, count = 0;
+  s >> magic >> version >> count;
+
+  if (magic != CacheMagic || version != CacheVersion) {
+    log::debug("ignoring plugin header cache {}, wrong version", m_Filename);
+    return;
+  }
+
+  for (quint32 i=0; i<count; ++i) {
+    QString path;
+    quint64 size = 0;
+    quint32 low = 0, high = 0;
+    auto h = std::make_shared<Header>();
+
+    s
+      >> path >> size >> low >> high
+      >> h->isMaster >> h->isLight >> h->author >> h->description >> h->masters;
+
+    if (s.status() != QDataStream::Ok) {
+      log::error("plugin header cache {} is corrupted, ignoring it", m_Filename);
+      m_Entries.clear();
+      return;
+    }
+
+    Entry e;
+    e.size = size;
+    e.lastModified.dwLowDateTime = low;
+    e.lastModified.dwHighDateTime = high;
+    e.header = std::move(h);
+
+    m_Entries.emplace(std::move(path), std::move(e));
+  }
+
+  log::debug("loaded {} plugin headers from {}", m_Entries.size(), m_Filename);
+}
+
+std::shared_ptr<const PluginHeaderCache::Header> PluginHeaderCache::find(
+  const QString& key, const File& f) const
+{
+  auto itor = m_Entries.find(key);
+  if (itor == m_Entries.end()) {
+    return {};
+  }
+
+  const auto& e = itor->second;
+  if (e.size != f.size || !sameTime(e.lastModified, f.lastModified)) {
+    return {};
+  }
+
+  return e.header;
+}
+
+QString PluginHeaderCache::key(const QString& path)
+{
+  return QDir::fromNativeSeparators(path).toLower();
+}
+
+bool PluginHeaderCache::stat(File& f)
+{
+  WIN32_FILE_ATTRIBUTE_DATA data = {};
+
+  IoAccounting::stat(IoAccounting::Subsystem::Plugins);
+
+  if (!::GetFileAttributesExW(f.path.toStdWString().c_str(), GetFileExInfoStandard, &data)) {
+    return false;
+  }
+
+  f.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+  f.lastModified = data.ftLastWriteTime;
+
+  return true;
+}
+
+std::shared_ptr<const PluginHeaderCache::Header> PluginHeaderCache::parse(
+  const QString& path)
+{
+  try {
+    IoAccounting::open(IoAccounting::Subsystem::Plugins);
+
+    ESP::File file(ToWString(path));
+    auto h = std::make_shared<Header>();
+
+    h->isMaster = file.isMaster();
+    h->isLight = file.isLight();
+    h->author = QString::fromLatin1(file.author().c_str());
+    h->description = QString::fromLatin1(file.description().c_str());
+
+    for (auto&& m : file.masters()) {
+      h->masters.append(QString::fromStdString(m));
+    }
+
+    return h;
+  } catch (const std::exception &e) {
+    log::error("failed to parse plugin file {}: {}", path, e.what());
+    return {};
+  }
+}
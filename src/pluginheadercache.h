@@ -0,0 +1,104 @@
+#ifndef MODORGANIZER_PLUGINHEADERCACHE_INCLUDED
+#define MODORGANIZER_PLUGINHEADERCACHE_INCLUDED
+
+#include <QString>
+#include <QStringList>
+#include <map>
+#include <memory>
+#include <vector>
+
+// the parts of the header of plugins that are shown in the plugin list,
+// remembered across runs so plugins that haven't changed are never opened
+// again
+//
+// entries are keyed by the full path of the plugin and are only used if the
+// size and modification time of the file are the same as when it was parsed;
+// plugins that are not in the cache are parsed in parallel on the task
+// executor
+//
+// the cache is stored in the cache directory of the instance, it's loaded by
+// setFilename() and written by save() if it changed
+//
+// this is not thread-safe
+//
+class PluginHeaderCache
+{
+public:
+  struct Header
+  {
+    bool isMaster = false;
+
+    // whether the light flag is set in the header, regardless of whether the
+    // game supports light plugins
+    bool isLight = false;
+
+    QString author;
+    QString description;
+    QStringList masters;
+  };
+
+  struct File
+  {
+    QString path;
+
+    // FileEntry::NoFileSize or a zeroed time means they're not known,
+    // they're retrieved from the disk
+    uint64_t size;
+    FILETIME lastModified;
+  };
+
+  PluginHeaderCache();
+
+  // loads the cache from the given file, does nothing if it's the file that's
+  // already loaded; an unsaved cache is written to the previous file first
+  //
+  void setFilename(const QString& path);
+
+  // returns the header of all the given files, in the same order, parsing
+  // the ones that are not in the cache or that have changed; headers are null
+  // for files that can't be parsed, which has already been logged
+  //
+  // the modification time of the files is filled in if it wasn't known
+  //
+  std::vector<std::shared_ptr<const Header>> get(std::vector<File>& files);
+
+  // removes all the files from the cache except the given ones
+  //
+  void prune(const std::vector<QString>& keep);
+
+  // writes the cache to the file given in setFilename() if it changed since
+  // it was loaded or last saved
+  //
+  void save();
+
+private:
+  struct Entry
+  {
+    uint64_t size;
+    FILETIME lastModified;
+    std::shared_ptr<const Header> header;
+  };
+
+  QString m_Filename;
+
+  // keyed by the lowercase full path
+  std::map<QString, Entry> m_Entries;
+  bool m_Dirty;
+
+  void load();
+
+  // returns the cached header for the given file if it hasn't changed
+  //
+  std::shared_ptr<const Header> find(const QString& key, const File& f) const;
+
+  static QString key(const QString& path);
+
+  // fills in the size and time of the given file if they're not known,
+  // returns false if the file doesn't exist
+  //
+  static bool stat(File& f);
+
+  static std::shared_ptr<const Header> parse(const QString& path);
+};
+
+#endif // MODORGANIZER_PLUGINHEADERCACHE_INCLUDED
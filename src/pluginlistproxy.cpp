@@ -15,9 +15,9 @@ PluginListProxy::~PluginListProxy()
 
 void PluginListProxy::connectSignals()
 {
-  m_Connections.push_back(m_Proxied->onRefreshed(callSignalIfPluginActive(m_OrganizerProxy, m_Refreshed)));
-  m_Connections.push_back(m_Proxied->onPluginMoved(callSignalIfPluginActive(m_OrganizerProxy, m_PluginMoved)));
-  m_Connections.push_back(m_Proxied->onPluginStateChanged(callSignalIfPluginActive(m_OrganizerProxy, m_PluginStateChanged)));
+  m_Connections.push_back(m_Proxied->onRefreshed(callTimedSignalIfPluginActive(m_OrganizerProxy, m_Refreshed, "onRefreshed")));
+  m_Connections.push_back(m_Proxied->onPluginMoved(callTimedSignalIfPluginActive(m_OrganizerProxy, m_PluginMoved, "onPluginMoved")));
+  m_Connections.push_back(m_Proxied->onPluginStateChanged(callTimedSignalIfPluginActive(m_OrganizerProxy, m_PluginStateChanged, "onPluginStateChanged")));
 }
 
 void PluginListProxy::disconnectSignals()
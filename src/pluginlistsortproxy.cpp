@@ -33,6 +33,7 @@ PluginListSortProxy::PluginListSortProxy(QObject *parent)
   m_EnabledColumns.set(PluginList::COL_NAME);
   m_EnabledColumns.set(PluginList::COL_PRIORITY);
   m_EnabledColumns.set(PluginList::COL_MODINDEX);
+  m_EnabledColumns.set(PluginList::COL_CONFLICTS);
   this->setDynamicSortFilter(true);
 }
 
@@ -83,6 +84,9 @@ bool PluginListSortProxy::lessThan(const QModelIndex &left,
       QString rightVal = plugins->getIndexPriority(right.row());
       return leftVal < rightVal;
     } break;
+    case PluginList::COL_CONFLICTS: {
+      return plugins->getRecordConflicts(left.row()) < plugins->getRecordConflicts(right.row());
+    } break;
     default: {
       return plugins->getPriority(left.row()) < plugins->getPriority(right.row());
     } break;
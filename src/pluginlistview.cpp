@@ -5,6 +5,7 @@
 
 #include <report.h>
 #include <widgetutility.h>
+#include <log.h>
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
@@ -16,6 +17,7 @@
 #include "modlistviewactions.h"
 #include "genericicondelegate.h"
 #include "modelutils.h"
+#include "messagedialog.h"
 
 using namespace MOBase;
 
@@ -145,6 +147,14 @@ void PluginListView::onSortButtonClicked()
     return;
   }
 
+  if (!m_lastSortState.isEmpty() && m_lastSortState == m_core->pluginList()->sortState()) {
+    // lootcli would load everything again and give the same order
+    log::debug("plugins haven't changed since the last sort, not running loot");
+    MessageDialog::showMessage(
+      tr("The plugins have not changed since the last sort."), topLevelWidget());
+    return;
+  }
+
   m_core->savePluginList();
 
   topLevelWidget()->setEnabled(false);
@@ -161,6 +171,8 @@ void PluginListView::onSortButtonClicked()
 
     m_core->refreshESPList(false);
     m_core->savePluginList();
+
+    m_lastSortState = m_core->pluginList()->sortState();
   }
 }
 
@@ -191,6 +203,10 @@ void PluginListView::setup(OrganizerCore& core, MainWindow* mw, Ui::MainWindow*
   sortByColumn(PluginList::COL_PRIORITY, Qt::AscendingOrder);
   setItemDelegateForColumn(PluginList::COL_FLAGS, new GenericIconDelegate(this));
 
+  // all rows have the same height, the view doesn't have to ask every row
+  // when scrolling
+  setUniformRowHeights(true);
+
   // counter
   connect(core.pluginList(), &PluginList::writePluginsList, [=]{ updatePluginCount(); });
   connect(core.pluginList(), &PluginList::esplist_changed, [=]{ updatePluginCount(); });
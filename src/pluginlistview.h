@@ -81,6 +81,10 @@ private:
   ViewMarkingScrollBar* m_Scrollbar;
 
   bool m_didUpdateMasterList;
+
+  // PluginList::sortState() after the last successful sort, sorting again is
+  // skipped if nothing has changed since
+  QByteArray m_lastSortState;
 };
 
 #endif // PLUGINLISTVIEW_H
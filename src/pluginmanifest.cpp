@@ -0,0 +1,182 @@
+#include "pluginmanifest.h"
+#include <log.h>
+#include <safewritefile.h>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+using namespace MOBase;
+
+// "MOPM" and the format version, the manifest is ignored when either doesn't
+// match
+static const quint32 ManifestMagic = 0x4d4f504d;
+static const quint32 ManifestVersion = 1;
+
+
+void PluginManifest::load(const QString& path)
+{
+  m_files.clear();
+  m_seen.clear();
+  m_changed = false;
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_9);
+
+  quint32 magic = 0, version = 0;
+  in >> magic >> version;
+
+  if (magic != ManifestMagic || version != ManifestVersion) {
+    log::debug("ignoring plugin manifest {}, wrong version", path);
+    return;
+  }
+
+  std::map<QString, File> files;
+
+  quint32 count = 0;
+  in >> count;
+
+  for (quint32 i=0; i<count && in.status() == QDataStream::Ok; ++i) {
+    QString filepath;
+    File f;
+    quint32 pluginCount = 0;
+
+    in >> filepath >> f.size >> f.time >> f.isPlugin >> pluginCount;
+
+    for (quint32 j=0; j<pluginCount && in.status() == QDataStream::Ok; ++j) {
+      Plugin p;
+      in >> p.name >> p.version >> p.interfaces;
+      f.plugins.push_back(std::move(p));
+    }
+
+    files.emplace(std::move(filepath), std::move(f));
+  }
+
+  if (in.status() != QDataStream::Ok) {
+    log::debug("ignoring plugin manifest {}, it's corrupted", path);
+    return;
+  }
+
+  m_files = std::move(files);
+}
+
+void PluginManifest::save(const QString& path)
+{
+  // files that are gone must be dropped even if nothing else changed
+  if (!m_changed && m_seen.size() == m_files.size()) {
+    return;
+  }
+
+  QByteArray content;
+
+  {
+    QDataStream out(&content, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_9);
+
+    out << ManifestMagic << ManifestVersion;
+    out << static_cast<quint32>(m_seen.size());
+
+    for (const auto& [k, f] : m_files) {
+      if (!m_seen.count(k)) {
+        continue;
+      }
+
+      out << k << f.size << f.time << f.isPlugin;
+      out << static_cast<quint32>(f.plugins.size());
+
+      for (const auto& p : f.plugins) {
+        out << p.name << p.version << p.interfaces;
+      }
+    }
+  }
+
+  try
+  {
+    SafeWriteFile file(path);
+    file->resize(0);
+    file->write(content);
+    file.commit();
+
+    m_changed = false;
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to write {}: {}", path, e.what());
+  }
+}
+
+std::optional<PluginManifest::File> PluginManifest::find(const QString& filepath)
+{
+  const auto k = key(filepath);
+
+  auto itor = m_files.find(k);
+  if (itor == m_files.end()) {
+    return {};
+  }
+
+  const QFileInfo fi(filepath);
+
+  if (itor->second.size != fi.size() ||
+      itor->second.time != fi.lastModified().toMSecsSinceEpoch()) {
+    // the file has changed, it will be set() again when it's loaded
+    return {};
+  }
+
+  m_seen.insert(k);
+  return itor->second;
+}
+
+void PluginManifest::set(const QString& filepath, File f)
+{
+  const QFileInfo fi(filepath);
+  const auto k = key(filepath);
+
+  f.size = fi.size();
+  f.time = fi.lastModified().toMSecsSinceEpoch();
+
+  m_seen.insert(k);
+
+  auto itor = m_files.find(k);
+  if (itor != m_files.end() && same(itor->second, f)) {
+    // this is called every time a plugin is loaded, the manifest is only
+    // written when something changed
+    return;
+  }
+
+  m_files[k] = std::move(f);
+  m_changed = true;
+}
+
+bool PluginManifest::same(const File& a, const File& b)
+{
+  if (a.size != b.size || a.time != b.time || a.isPlugin != b.isPlugin) {
+    return false;
+  }
+
+  if (a.plugins.size() != b.plugins.size()) {
+    return false;
+  }
+
+  for (std::size_t i=0; i<a.plugins.size(); ++i) {
+    const auto& pa = a.plugins[i];
+    const auto& pb = b.plugins[i];
+
+    if (pa.name != pb.name || pa.version != pb.version ||
+        pa.interfaces != pb.interfaces) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+QString PluginManifest::key(const QString& filepath)
+{
+  return QDir::cleanPath(QDir::fromNativeSeparators(filepath)).toLower();
+}
@@ -0,0 +1,70 @@
+#ifndef MODORGANIZER_PLUGINMANIFEST_INCLUDED
+#define MODORGANIZER_PLUGINMANIFEST_INCLUDED
+
+#include <QString>
+#include <QStringList>
+#include <map>
+#include <optional>
+#include <set>
+#include <vector>
+
+// remembers what was found in each plugin file the last time it was loaded:
+// the plugins it provides with their name, version and interfaces, or that
+// it's not a Qt plugin at all, in which case PluginContainer doesn't load it
+// again
+//
+// entries are keyed by the path of the file and are only used while its size
+// and modification time haven't changed; the manifest is saved in the cache
+// directory after plugins are loaded, files that were not seen are dropped
+//
+class PluginManifest
+{
+public:
+  struct Plugin
+  {
+    QString name;
+    QString version;
+    QStringList interfaces;
+  };
+
+  struct File
+  {
+    qint64 size = 0;
+    qint64 time = 0;
+
+    // false for libraries that don't have Qt plugin metadata
+    bool isPlugin = true;
+
+    std::vector<Plugin> plugins;
+  };
+
+  // loads the given manifest, replacing the current entries; a manifest that
+  // can't be read is ignored
+  //
+  void load(const QString& path);
+
+  // saves the entries of the files that were given to find() or set() since
+  // load(), does nothing if nothing changed
+  //
+  void save(const QString& path);
+
+  // returns the entry for the given file, or nothing if there's none or if the
+  // file has changed
+  //
+  std::optional<File> find(const QString& filepath);
+
+  // replaces the entry for the given file, the size and time of the file are
+  // filled in
+  //
+  void set(const QString& filepath, File f);
+
+private:
+  std::map<QString, File> m_files;
+  std::set<QString> m_seen;
+  bool m_changed = false;
+
+  static QString key(const QString& filepath);
+  static bool same(const File& a, const File& b);
+};
+
+#endif // MODORGANIZER_PLUGINMANIFEST_INCLUDED
@@ -0,0 +1,374 @@
+#include "pluginrecordindex.h"
+#include "metrics.h"
+#include "taskexecutor.h"
+#include <log.h>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+using namespace MOBase;
+
+// the record header is 24 bytes in every game except Oblivion, which doesn't
+// have the version fields at the end; groups have the same size as records
+static constexpr std::size_t HeaderSize = 24;
+static constexpr std::size_t OblivionHeaderSize = 20;
+
+static quint16 read16(const uchar* p)
+{
+  quint16 v = 0;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static quint32 read32(const uchar* p)
+{
+  quint32 v = 0;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static bool isSignature(const uchar* p, const char* s)
+{
+  return (std::memcmp(p, s, 4) == 0);
+}
+
+// returns the size of the record headers in the given file, or 0 if it
+// doesn't start with a TES4 record; the game is not known here, so both sizes
+// are tried on the TES4 record, which must be followed by a group or the end
+// of the file
+//
+static std::size_t headerSize(const uchar* data, std::size_t size)
+{
+  if (size < OblivionHeaderSize || !isSignature(data, "TES4")) {
+    return 0;
+  }
+
+  const std::size_t dataSize = read32(data + 4);
+
+  for (const std::size_t hs : {HeaderSize, OblivionHeaderSize}) {
+    const std::size_t next = hs + dataSize;
+
+    if (next == size || (next + 4 <= size && isSignature(data + next, "GRUP"))) {
+      return hs;
+    }
+  }
+
+  return 0;
+}
+
+// appends the MAST subrecords of the TES4 record to `masters`; XXXX gives the
+// size of the next subrecord when it doesn't fit in 16 bits
+//
+static bool readMasters(const uchar* p, std::size_t size, QStringList& masters)
+{
+  std::size_t offset = 0;
+  std::size_t nextSize = 0;
+
+  while (offset + 6 <= size) {
+    const uchar* sub = p + offset;
+    std::size_t subSize = read16(sub + 4);
+
+    if (nextSize != 0) {
+      subSize = nextSize;
+      nextSize = 0;
+    }
+
+    if (offset + 6 + subSize > size) {
+      return false;
+    }
+
+    if (isSignature(sub, "XXXX") && subSize == 4) {
+      nextSize = read32(sub + 6);
+    } else if (isSignature(sub, "MAST")) {
+      const auto* s = reinterpret_cast<const char*>(sub + 6);
+      masters.append(QString::fromUtf8(s, static_cast<int>(strnlen(s, subSize))));
+    }
+
+    offset += 6 + subSize;
+  }
+
+  return (offset == size);
+}
+
+// walks the groups and records of the given file, skipping the data of the
+// records; groups are entered instead of skipped, their content is a sequence
+// of records and groups that ends where the group ends
+//
+static bool readRecords(
+  const uchar* data, std::size_t size, std::size_t hs, quint32 masterCount,
+  std::vector<quint32>& overrides)
+{
+  std::size_t offset = hs + read32(data + 4);
+
+  while (offset + hs <= size) {
+    const uchar* p = data + offset;
+
+    if (isSignature(p, "GRUP")) {
+      if (read32(p + 4) < hs) {
+        return false;
+      }
+
+      offset += hs;
+      continue;
+    }
+
+    const quint32 formID = read32(p + 12);
+
+    if ((formID >> 24) < masterCount) {
+      overrides.push_back(formID);
+    }
+
+    offset += hs + read32(p + 4);
+  }
+
+  return (offset == size);
+}
+
+
+PluginRecordIndex::Index PluginRecordIndex::build(
+  const std::vector<Plugin>& plugins, const std::function<bool ()>& cancelled)
+{
+  Metrics::Timer tt("PluginRecordIndex::build()");
+
+  std::vector<std::shared_ptr<const Records>> records(plugins.size());
+
+  {
+    MOShared::TaskGroup g(MOShared::TaskPriority::Low);
+
+    for (std::size_t i=0; i<plugins.size(); ++i) {
+      g.run([&, i] {
+        if (!cancelled()) {
+          records[i] = get(plugins[i].path);
+        }
+      });
+    }
+
+    g.wait();
+  }
+
+  if (cancelled()) {
+    return {};
+  }
+
+  // plugins are numbered by load order, masters that are not enabled are
+  // numbered after them
+  std::map<QString, quint32, FileNameComparator> ids;
+  for (std::size_t i=0; i<plugins.size(); ++i) {
+    ids.emplace(plugins[i].name, static_cast<quint32>(i));
+  }
+
+  // every override as the record and the plugin defining it, sorted so the
+  // plugins defining a record are next to each other, in load order
+  std::vector<std::pair<quint64, quint32>> defs;
+
+  for (std::size_t i=0; i<plugins.size(); ++i) {
+    if (!records[i]) {
+      continue;
+    }
+
+    std::vector<quint64> owners;
+    for (const auto& m : records[i]->masters) {
+      const auto next = static_cast<quint32>(ids.size());
+      owners.push_back(static_cast<quint64>(ids.emplace(m, next).first->second) << 32);
+    }
+
+    for (const quint32 formID : records[i]->overrides) {
+      defs.push_back({
+        owners[formID >> 24] | (formID & 0xffffff), static_cast<quint32>(i)});
+    }
+  }
+
+  std::sort(defs.begin(), defs.end());
+
+  if (cancelled()) {
+    return {};
+  }
+
+  struct Counts
+  {
+    int overriding = 0;
+    int overridden = 0;
+    std::map<quint32, int> overwrites;
+    std::map<quint32, int> overwrittenBy;
+  };
+
+  std::vector<Counts> counts(plugins.size());
+  std::vector<quint32> chain;
+
+  for (std::size_t begin=0; begin<defs.size();) {
+    const quint64 record = defs[begin].first;
+    const auto owner = static_cast<quint32>(record >> 32);
+
+    // plugins defining this record in load order, a record that's in a
+    // plugin more than once is only counted once
+    chain.clear();
+
+    std::size_t end = begin;
+    for (; end<defs.size() && defs[end].first == record; ++end) {
+      if (chain.empty() || chain.back() != defs[end].second) {
+        chain.push_back(defs[end].second);
+      }
+    }
+
+    begin = end;
+
+    // the owner defines the record too if it's enabled; it's normally
+    // loaded before the plugins that have it as a master, but not always
+    if (owner < plugins.size()) {
+      chain.insert(std::lower_bound(chain.begin(), chain.end(), owner), owner);
+    }
+
+    if (chain.size() < 2) {
+      continue;
+    }
+
+    for (std::size_t j=0; j<chain.size(); ++j) {
+      auto& c = counts[chain[j]];
+
+      if (j > 0) {
+        ++c.overriding;
+      }
+
+      if (j + 1 < chain.size()) {
+        ++c.overridden;
+      }
+
+      for (std::size_t k=0; k<j; ++k) {
+        ++c.overwrites[chain[k]];
+      }
+
+      for (std::size_t k=j+1; k<chain.size(); ++k) {
+        ++c.overwrittenBy[chain[k]];
+      }
+    }
+  }
+
+  Index index;
+
+  for (std::size_t i=0; i<plugins.size(); ++i) {
+    const auto& c = counts[i];
+    if (c.overriding == 0 && c.overridden == 0) {
+      continue;
+    }
+
+    auto& out = index[plugins[i].name];
+    out.overriding = c.overriding;
+    out.overridden = c.overridden;
+
+    for (auto&& [id, n] : c.overwrites) {
+      out.overwrites[plugins[id].name] = n;
+    }
+
+    for (auto&& [id, n] : c.overwrittenBy) {
+      out.overwrittenBy[plugins[id].name] = n;
+    }
+  }
+
+  log::debug(
+    "{} plugins have record conflicts, {} overriding records",
+    index.size(), defs.size());
+
+  return index;
+}
+
+void PluginRecordIndex::prune(const std::vector<QString>& keep)
+{
+  std::set<QString> keys;
+  for (const auto& path : keep) {
+    keys.insert(QDir::fromNativeSeparators(path).toLower());
+  }
+
+  std::scoped_lock lock(m_Mutex);
+
+  for (auto itor=m_Entries.begin(); itor!=m_Entries.end();) {
+    if (!keys.contains(itor->first)) {
+      itor = m_Entries.erase(itor);
+    } else {
+      ++itor;
+    }
+  }
+}
+
+std::shared_ptr<const PluginRecordIndex::Records> PluginRecordIndex::get(
+  const QString& path)
+{
+  const QFileInfo fi(path);
+  if (!fi.exists()) {
+    return {};
+  }
+
+  const auto key = QDir::fromNativeSeparators(path).toLower();
+  const auto size = fi.size();
+  const auto lastModified = fi.lastModified();
+
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    auto itor = m_Entries.find(key);
+    if (itor != m_Entries.end()) {
+      const auto& e = itor->second;
+
+      // plugins that couldn't be parsed are remembered too, so they're not
+      // parsed and logged again until they change
+      if (e.size == size && e.lastModified == lastModified) {
+        return e.records;
+      }
+    }
+  }
+
+  auto r = parse(path);
+
+  std::scoped_lock lock(m_Mutex);
+  m_Entries[key] = {size, lastModified, r};
+
+  return r;
+}
+
+std::shared_ptr<const PluginRecordIndex::Records> PluginRecordIndex::parse(
+  const QString& path)
+{
+  QFile file(path);
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    log::error("can't open plugin {}: {}", path, file.errorString());
+    return {};
+  }
+
+  const auto size = static_cast<std::size_t>(file.size());
+  if (size == 0) {
+    log::error("plugin {} is empty", path);
+    return {};
+  }
+
+  // the file is unmapped when it's closed
+  const uchar* data = file.map(0, file.size());
+  if (!data) {
+    log::error("can't map plugin {}: {}", path, file.errorString());
+    return {};
+  }
+
+  const std::size_t hs = headerSize(data, size);
+  if (hs == 0) {
+    log::error("plugin {} doesn't start with a valid TES4 record", path);
+    return {};
+  }
+
+  auto r = std::make_shared<Records>();
+
+  if (!readMasters(data + hs, read32(data + 4), r->masters)) {
+    log::error("plugin {} has an invalid header", path);
+    return {};
+  }
+
+  const auto masterCount = static_cast<quint32>(r->masters.size());
+
+  if (!readRecords(data, size, hs, masterCount, r->overrides)) {
+    // the records before the invalid one are still used
+    log::warn("plugin {} has invalid records, some conflicts may be missing", path);
+  }
+
+  return r;
+}
@@ -0,0 +1,101 @@
+#ifndef MODORGANIZER_PLUGINRECORDINDEX_INCLUDED
+#define MODORGANIZER_PLUGINRECORDINDEX_INCLUDED
+
+#include <utility.h>
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// finds the records that are defined by more than one enabled plugin, which
+// is what the conflicts column and the tooltips of the plugin list show
+//
+// plugins are memory-mapped and only the headers of their groups and records
+// are walked, the data of the records is skipped; a record is identified by
+// the plugin that owns it, given by the master index in the high byte of its
+// form id, and the low bytes of the form id, so only records that override
+// one of the masters of a plugin can conflict
+//
+// the form ids read from a plugin are remembered by full path and only used
+// again if the size and modification time of the file haven't changed; the
+// plugins that are not in memory are parsed in parallel on the task executor
+//
+// this is thread-safe, build() is meant to run on the task executor
+//
+class PluginRecordIndex
+{
+public:
+  struct Plugin
+  {
+    QString name;
+    QString path;
+  };
+
+  struct Conflicts
+  {
+    // number of records of earlier plugins this plugin overrides
+    int overriding = 0;
+
+    // number of records of this plugin that a later plugin overrides
+    int overridden = 0;
+
+    // number of records overridden in each earlier plugin and by each later
+    // plugin, by plugin name
+    std::map<QString, int, MOBase::FileNameComparator> overwrites;
+    std::map<QString, int, MOBase::FileNameComparator> overwrittenBy;
+  };
+
+  // conflicts by plugin name, plugins without conflicts are not in it
+  using Index = std::map<QString, Conflicts, MOBase::FileNameComparator>;
+
+  // finds the conflicts between the given plugins, which must be the enabled
+  // plugins in load order; plugins that can't be parsed are ignored, which has
+  // already been logged
+  //
+  // `cancelled` is checked between steps, an empty index is returned once it
+  // returns true
+  //
+  Index build(
+    const std::vector<Plugin>& plugins, const std::function<bool ()>& cancelled);
+
+  // forgets all the plugins except the given ones
+  //
+  void prune(const std::vector<QString>& keep);
+
+private:
+  struct Records
+  {
+    // masters in the order of the header, the master index of a form id is
+    // an index in this list
+    QStringList masters;
+
+    // form ids of the records that override a master, as they are in the
+    // file
+    std::vector<quint32> overrides;
+  };
+
+  struct Entry
+  {
+    qint64 size;
+    QDateTime lastModified;
+    std::shared_ptr<const Records> records;
+  };
+
+  std::mutex m_Mutex;
+
+  // keyed by the lowercase full path
+  std::map<QString, Entry> m_Entries;
+
+  // returns the records of the given plugin, parsing it if it's not in memory
+  // or if it has changed; null if it can't be parsed
+  //
+  std::shared_ptr<const Records> get(const QString& path);
+
+  static std::shared_ptr<const Records> parse(const QString& path);
+};
+
+#endif // MODORGANIZER_PLUGINRECORDINDEX_INCLUDED
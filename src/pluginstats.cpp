@@ -0,0 +1,97 @@
+#include "pluginstats.h"
+#include <iplugin.h>
+#include <log.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+using namespace MOBase;
+
+struct PluginStats::Data
+{
+  std::mutex mutex;
+
+  // calls by name, by plugin name
+  std::map<QString, std::map<QString, Call>> plugins;
+};
+
+
+void PluginStats::record(
+  const IPlugin* plugin, const char* call, Clock::duration d)
+{
+  const QString pluginName = plugin ? plugin->name() : QString();
+
+  auto& data = PluginStats::data();
+  std::scoped_lock lock(data.mutex);
+
+  auto& c = data.plugins[pluginName][call];
+
+  if (c.count == 0) {
+    c.name = call;
+  }
+
+  ++c.count;
+  c.total += d;
+  c.max = std::max(c.max, d);
+}
+
+std::vector<PluginStats::Call> PluginStats::calls(const IPlugin* plugin)
+{
+  std::vector<Call> v;
+
+  {
+    auto& data = PluginStats::data();
+    std::scoped_lock lock(data.mutex);
+
+    auto itor = data.plugins.find(plugin ? plugin->name() : QString());
+    if (itor == data.plugins.end()) {
+      return {};
+    }
+
+    for (auto&& [name, c] : itor->second) {
+      v.push_back(c);
+    }
+  }
+
+  std::sort(v.begin(), v.end(), [](auto&& a, auto&& b) {
+    return (a.total > b.total);
+  });
+
+  return v;
+}
+
+PluginStats::Data& PluginStats::data()
+{
+  static Data d;
+  return d;
+}
+
+
+PluginCallTimer::PluginCallTimer(
+  const IPlugin* plugin, const char* call, Clock::duration warnAfter)
+    : m_plugin(plugin), m_call(call), m_warnAfter(warnAfter),
+      m_start(Clock::now())
+{
+}
+
+PluginCallTimer::~PluginCallTimer()
+{
+  using namespace std::chrono;
+
+  const auto d = Clock::now() - m_start;
+  PluginStats::record(m_plugin, m_call, d);
+
+  // short calls would flood the metrics, they're only in the stats
+  if (d < milliseconds(5)) {
+    return;
+  }
+
+  const QString name = m_plugin ? m_plugin->name() : QString("?");
+  Metrics::duration(QString("plugin %1: %2").arg(m_call).arg(name), d);
+
+  if (d >= m_warnAfter) {
+    log::warn(
+      "plugin '{}' took {}ms in {}",
+      name, duration_cast<milliseconds>(d).count(), m_call);
+  }
+}
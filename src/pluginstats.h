@@ -0,0 +1,77 @@
+#ifndef MODORGANIZER_PLUGINSTATS_INCLUDED
+#define MODORGANIZER_PLUGINSTATS_INCLUDED
+
+#include "metrics.h"
+#include <QString>
+#include <vector>
+
+namespace MOBase { class IPlugin; }
+
+// time spent by plugins in the calls MO makes into them, such as init(),
+// diagnoses, file mappers, installers and the callbacks they registered;
+// kept by plugin name and by call for the session and shown in the plugins
+// settings page
+//
+// calls are timed with PluginCallTimer, this can be used from any thread
+//
+class PluginStats
+{
+public:
+  using Clock = Metrics::Clock;
+
+  struct Call
+  {
+    QString name;
+    std::size_t count = 0;
+    Clock::duration total = {};
+    Clock::duration max = {};
+  };
+
+  static void record(
+    const MOBase::IPlugin* plugin, const char* call, Clock::duration d);
+
+  // calls made into the given plugin so far, by total time, longest first
+  //
+  static std::vector<Call> calls(const MOBase::IPlugin* plugin);
+
+private:
+  struct Data;
+  static Data& data();
+};
+
+
+// times a call into a plugin and records it in PluginStats; calls taking
+// longer than a few milliseconds are also recorded in the metrics, and the
+// ones taking longer than `warnAfter` are logged
+//
+class PluginCallTimer
+{
+public:
+  using Clock = PluginStats::Clock;
+
+  // for callbacks and other calls made on the paths users wait on, like
+  // startup, refreshes and starting programs
+  static constexpr Clock::duration DefaultWarnAfter =
+    std::chrono::milliseconds(100);
+
+  // for calls that are expected to take a while, like installers that show
+  // dialogs
+  static constexpr Clock::duration NeverWarn = Clock::duration::max();
+
+  PluginCallTimer(
+    const MOBase::IPlugin* plugin, const char* call,
+    Clock::duration warnAfter=DefaultWarnAfter);
+
+  ~PluginCallTimer();
+
+  PluginCallTimer(const PluginCallTimer&) = delete;
+  PluginCallTimer& operator=(const PluginCallTimer&) = delete;
+
+private:
+  const MOBase::IPlugin* m_plugin;
+  const char* m_call;
+  Clock::duration m_warnAfter;
+  Clock::time_point m_start;
+};
+
+#endif // MODORGANIZER_PLUGINSTATS_INCLUDED
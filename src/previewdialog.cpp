@@ -1,33 +1,64 @@
 #include "previewdialog.h"
 #include "ui_previewdialog.h"
+#include "previewgenerator.h"
 #include "settings.h"
+#include <log.h>
+#include <QDir>
 #include <QFileInfo>
+#include <QLabel>
 
-PreviewDialog::PreviewDialog(const QString &fileName, QWidget *parent) :
+using namespace MOBase;
+
+// delay before generating the preview after moving to another variant, so
+// clicking through variants quickly doesn't decode all of them
+static const int GenerateDelay = 150;
+
+// size of the reads when reading ahead
+static const qint64 ReadAheadChunk = 1024 * 1024;
+
+
+PreviewDialog::PreviewDialog(
+  const QString &fileName, const PreviewGenerator& generator, QWidget *parent) :
   QDialog(parent),
-  ui(new Ui::PreviewDialog)
+  ui(new Ui::PreviewDialog),
+  m_generator(generator),
+  m_readAheadIndex(-1),
+  m_direction(1),
+  m_replacing(false)
 {
   ui->setupUi(this);
   ui->nameLabel->setText(QFileInfo(fileName).fileName());
   ui->nextButton->setEnabled(false);
   ui->previousButton->setEnabled(false);
+
+  m_generateTimer.setSingleShot(true);
+  connect(&m_generateTimer, &QTimer::timeout, [&]{ generateCurrent(); });
 }
 
 PreviewDialog::~PreviewDialog()
 {
+  cancelReadAhead();
   delete ui;
 }
 
 int PreviewDialog::exec()
 {
   GeometrySaver gs(Settings::instance(), this);
+
+  // generates the first preview once the dialog has been shown
+  m_generateTimer.start(0);
+
   return QDialog::exec();
 }
 
-void PreviewDialog::addVariant(const QString &modName, QWidget *widget)
+void PreviewDialog::addVariant(const QString &modName, const QString& path)
 {
-  widget->setProperty("modName", modName);
-  ui->variantsStack->addWidget(widget);
+  m_variants.push_back({modName, path});
+
+  auto* placeholder = new QLabel(tr("Loading preview..."));
+  placeholder->setAlignment(Qt::AlignCenter);
+
+  ui->variantsStack->addWidget(placeholder);
   if (ui->variantsStack->count() > 1) {
     ui->nextButton->setEnabled(true);
     ui->previousButton->setEnabled(true);
@@ -41,7 +72,20 @@ int PreviewDialog::numVariants() const
 
 void PreviewDialog::on_variantsStack_currentChanged(int index)
 {
-  ui->modLabel->setText(ui->variantsStack->widget(index)->property("modName").toString());
+  if (m_replacing || index < 0 || index >= static_cast<int>(m_variants.size())) {
+    return;
+  }
+
+  ui->modLabel->setText(m_variants[index].modName);
+
+  if (m_readAheadIndex != index) {
+    // reading a file the user has moved away from
+    cancelReadAhead();
+  }
+
+  if (!m_variants[index].generated) {
+    m_generateTimer.start(GenerateDelay);
+  }
 }
 
 void PreviewDialog::on_closeButton_clicked()
@@ -51,6 +95,8 @@ void PreviewDialog::on_closeButton_clicked()
 
 void PreviewDialog::on_previousButton_clicked()
 {
+  m_direction = -1;
+
   int i = ui->variantsStack->currentIndex() - 1;
   if (i < 0) {
     i = ui->variantsStack->count() - 1;
@@ -60,5 +106,101 @@ void PreviewDialog::on_previousButton_clicked()
 
 void PreviewDialog::on_nextButton_clicked()
 {
+  m_direction = 1;
   ui->variantsStack->setCurrentIndex((ui->variantsStack->currentIndex() + 1) % ui->variantsStack->count());
 }
+
+void PreviewDialog::generateCurrent()
+{
+  const int index = ui->variantsStack->currentIndex();
+  if (index < 0 || index >= static_cast<int>(m_variants.size())) {
+    return;
+  }
+
+  if (m_variants[index].generated) {
+    return;
+  }
+
+  const auto& path = m_variants[index].path;
+
+  QWidget* w = m_generator.genPreview(path);
+
+  if (!w) {
+    log::error("failed to generate preview for {}", path);
+
+    auto* label = new QLabel(tr("Failed to generate preview for %1")
+      .arg(QDir::toNativeSeparators(path)));
+
+    label->setAlignment(Qt::AlignCenter);
+    label->setWordWrap(true);
+
+    w = label;
+  }
+
+  replace(index, w);
+
+  const int count = static_cast<int>(m_variants.size());
+  if (count > 1) {
+    readAhead((index + m_direction + count) % count);
+  }
+}
+
+void PreviewDialog::replace(int index, QWidget* w)
+{
+  m_replacing = true;
+
+  auto* placeholder = ui->variantsStack->widget(index);
+  ui->variantsStack->insertWidget(index, w);
+  ui->variantsStack->removeWidget(placeholder);
+  delete placeholder;
+
+  ui->variantsStack->setCurrentIndex(index);
+
+  m_replacing = false;
+
+  m_variants[index].generated = true;
+}
+
+void PreviewDialog::readAhead(int index)
+{
+  cancelReadAhead();
+
+  if (m_variants[index].generated) {
+    return;
+  }
+
+  m_readAheadIndex = index;
+  m_readAhead.reset(new MOShared::TaskGroup(MOShared::TaskPriority::Low));
+
+  // the group waits for its tasks when it's destroyed, so it outlives the
+  // task
+  auto* group = m_readAhead.get();
+
+  group->run([group, path=m_variants[index].path] {
+    // the data is thrown away, this only gets the file in the system's cache
+    // so the preview plugin doesn't wait for the disk
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+      return;
+    }
+
+    std::vector<char> buffer(ReadAheadChunk);
+
+    while (!group->cancelled()) {
+      if (f.read(buffer.data(), ReadAheadChunk) <= 0) {
+        break;
+      }
+    }
+  });
+}
+
+void PreviewDialog::cancelReadAhead()
+{
+  if (m_readAhead) {
+    // waits for the current chunk
+    m_readAhead->cancel();
+    m_readAhead.reset();
+  }
+
+  m_readAheadIndex = -1;
+}
@@ -1,25 +1,45 @@
 #ifndef PREVIEWDIALOG_H
 #define PREVIEWDIALOG_H
 
+#include "taskexecutor.h"
 #include <QDialog>
+#include <QTimer>
+#include <memory>
+#include <vector>
 
 namespace Ui {
 class PreviewDialog;
 }
 
+class PreviewGenerator;
+
+// shows the previews of the alternatives of a file
+//
+// previews are only generated when their variant is shown, after the dialog
+// has been painted with a placeholder, so moving through a list of large
+// files only decodes the ones that are actually looked at; the file of the
+// next variant is read in the background so its preview is faster to
+// generate, which is cancelled when the user moves elsewhere
+//
 class PreviewDialog : public QDialog
 {
   Q_OBJECT
 
 public:
-  explicit PreviewDialog(const QString &fileName, QWidget *parent = 0);
+  explicit PreviewDialog(
+    const QString &fileName, const PreviewGenerator& generator,
+    QWidget *parent = 0);
+
   ~PreviewDialog();
 
   // also saves and restores geometry
   //
   int exec() override;
 
-  void addVariant(const QString &modName, QWidget *widget);
+  // adds a variant for the given file, the preview is generated when it's
+  // shown
+  //
+  void addVariant(const QString &modName, const QString& path);
   int numVariants() const;
 
 private slots:
@@ -33,8 +53,51 @@ private slots:
   void on_nextButton_clicked();
 
 private:
+  struct Variant
+  {
+    QString modName;
+    QString path;
+
+    // whether the placeholder has been replaced by the preview, or by an
+    // error message
+    bool generated = false;
+  };
 
   Ui::PreviewDialog *ui;
+  const PreviewGenerator& m_generator;
+  std::vector<Variant> m_variants;
+
+  // generates the preview of the current variant once the user has stopped
+  // moving through them
+  QTimer m_generateTimer;
+
+  // reads the file of the next variant and the index of that variant
+  std::unique_ptr<MOShared::TaskGroup> m_readAhead;
+  int m_readAheadIndex;
+
+  // direction of the last move, 1 for next and -1 for previous
+  int m_direction;
+
+  // set while a placeholder is replaced, changing widgets in the stack
+  // changes the current index
+  bool m_replacing;
+
+  // generates the preview of the current variant
+  //
+  void generateCurrent();
+
+  // replaces the placeholder of the given variant
+  //
+  void replace(int index, QWidget* w);
+
+  // reads the file of the given variant in the background, cancels the
+  // previous read
+  //
+  void readAhead(int index);
+
+  // cancels the read of the file of the next variant
+  //
+  void cancelReadAhead();
 };
 
 #endif // PREVIEWDIALOG_H
@@ -46,7 +46,8 @@ void ProblemsDialog::runDiagnosis()
       continue;
     }
 
-    std::vector<unsigned int> activeProblems = diagnose->activeProblems();
+    // these have usually just been checked by MainWindow and are cached
+    std::vector<unsigned int> activeProblems = m_PluginContainer.problems(diagnose);
     foreach (unsigned int key, activeProblems) {
       QTreeWidgetItem *newItem = new QTreeWidgetItem();
       newItem->setText(0, diagnose->shortDescription(key));
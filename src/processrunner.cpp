@@ -4,6 +4,8 @@
 #include "iuserinterface.h"
 #include "envmodule.h"
 #include "env.h"
+#include "memoryaccounting.h"
+#include "launchtimeline.h"
 #include <iplugingame.h>
 #include <log.h>
 
@@ -225,6 +227,54 @@ InterestingProcess getInterestingProcess(HANDLE job)
 
 const std::chrono::milliseconds Infinite(-1);
 
+// completion keys used on the port associated with the job, see
+// waitForJobEvents()
+const ULONG_PTR JobKey = 1;
+const ULONG_PTR WakeKey = 2;
+
+// checks the lock widget, returns empty if it's still locked
+//
+std::optional<ProcessRunner::Results> checkLock(
+  UILocker::Session* ls, DWORD pid)
+{
+  // the session can be null when running shortcuts with locking disabled, in
+  // which case the user cannot force unlock
+  if (!ls) {
+    return {};
+  }
+
+  switch (ls->result())
+  {
+    case UILocker::StillLocked:
+    {
+      return {};
+    }
+
+    case UILocker::ForceUnlocked:
+    {
+      log::debug("waiting for {} force unlocked by user", pid);
+      return ProcessRunner::ForceUnlocked;
+    }
+
+    case UILocker::Cancelled:
+    {
+      log::debug("waiting for {} cancelled by user", pid);
+      return ProcessRunner::Cancelled;
+    }
+
+    case UILocker::NoResult:  // fall-through
+    default:
+    {
+      // shouldn't happen
+      log::debug(
+        "unexpected result {} while waiting for {}",
+        static_cast<int>(ls->result()), pid);
+
+      return ProcessRunner::Error;
+    }
+  }
+}
+
 // waits for completion, times out after `wait` if not Infinite
 //
 std::optional<ProcessRunner::Results> timedWait(
@@ -247,41 +297,9 @@ std::optional<ProcessRunner::Results> timedWait(
       return *r;
     }
 
-    // the process is still running
-
-    // check the lock widget; the session can be null when running shortcuts
-    // with locking disabled, in which case the user cannot force unlock
-    if (ls) {
-      switch (ls->result())
-      {
-        case UILocker::StillLocked:
-        {
-          break;
-        }
-
-        case UILocker::ForceUnlocked:
-        {
-          log::debug("waiting for {} force unlocked by user", pid);
-          return ProcessRunner::ForceUnlocked;
-        }
-
-        case UILocker::Cancelled:
-        {
-          log::debug("waiting for {} cancelled by user", pid);
-          return ProcessRunner::Cancelled;
-        }
-
-        case UILocker::NoResult:  // fall-through
-        default:
-        {
-          // shouldn't happen
-          log::debug(
-            "unexpected result {} while waiting for {}",
-            static_cast<int>(ls->result()), pid);
-
-          return ProcessRunner::Error;
-        }
-      }
+    // the process is still running, check the lock widget
+    if (const auto lr = checkLock(ls, pid)) {
+      return *lr;
     }
 
     if (wait != Infinite) {
@@ -359,11 +377,111 @@ ProcessRunner::Results waitForProcessesThreadImpl(
   return ProcessRunner::ForceUnlocked;
 }
 
+// same as waitForProcessesThreadImpl(), but sleeps on the completion port
+// associated with the job instead of polling: the job posts a message when a
+// process is created or exits, and the port is woken up with WakeKey when
+// the lock widget is used or when the wait is interrupted
+//
+ProcessRunner::Results waitForJobEvents(
+  HANDLE job, HANDLE port, UILocker::Session* ls, std::atomic<bool>& interrupt)
+{
+  DWORD currentPID = 0;
+
+  while (!interrupt) {
+    auto ip = getInterestingProcess(job);
+    if (!ip.handle) {
+      // nothing to wait on
+      return ProcessRunner::Completed;
+    }
+
+    // the process may have exited before the messages that were already
+    // handled, they won't be posted again
+    if (WaitForSingleObject(ip.handle.get(), 0) == WAIT_OBJECT_0) {
+      continue;
+    }
+
+    // update the lock widget; the session can be null when running shortcuts
+    // with locking disabled
+    if (ls) {
+      ls->setInfo(ip.p.pid(), ip.p.name());
+    }
+
+    if (ip.p.pid() != currentPID) {
+      // log any change in the process being waited for
+      currentPID = ip.p.pid();
+
+      log::debug(
+        "waiting for completion on {} ({}), {} interest",
+        ip.p.name(), ip.p.pid(), toString(ip.interest));
+    }
+
+    // waits until the process exits, or until a new process is started if
+    // this one isn't a good one to wait for, in which case it might be more
+    // interesting
+    for (;;) {
+      DWORD message = 0;
+      ULONG_PTR key = 0;
+      LPOVERLAPPED ov = nullptr;
+
+      if (!GetQueuedCompletionStatus(port, &message, &key, &ov, INFINITE)) {
+        const auto e = ::GetLastError();
+        log::error("failed waiting for job events, {}", formatSystemMessage(e));
+        return ProcessRunner::Error;
+      }
+
+      if (key == WakeKey) {
+        if (interrupt) {
+          break;
+        }
+
+        if (const auto lr = checkLock(ls, currentPID)) {
+          return *lr;
+        }
+
+        continue;
+      }
+
+      if (key != JobKey) {
+        continue;
+      }
+
+      // for process messages, the overlapped pointer is the pid
+      const auto pid = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(ov));
+
+      if (message == JOB_OBJECT_MSG_ACTIVE_PROCESS_ZERO) {
+        log::debug("all processes in the job have completed");
+        return ProcessRunner::Completed;
+      }
+
+      if (message == JOB_OBJECT_MSG_EXIT_PROCESS ||
+          message == JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS) {
+        if (pid == currentPID) {
+          log::debug("process {} completed", pid);
+          break;
+        }
+      } else if (message == JOB_OBJECT_MSG_NEW_PROCESS) {
+        LaunchTimeline::processStarted(pid);
+
+        if (ip.interest != Interest::Strong) {
+          break;
+        }
+      }
+    }
+  }
+
+  log::debug("waiting for processes interrupted");
+  return ProcessRunner::ForceUnlocked;
+}
+
 void waitForProcessesThread(
-  ProcessRunner::Results& result, HANDLE job, UILocker::Session* ls,
-  std::atomic<bool>& interrupt)
+  ProcessRunner::Results& result, HANDLE job, HANDLE port,
+  UILocker::Session* ls, std::atomic<bool>& interrupt)
 {
-  result = waitForProcessesThreadImpl(job, ls, interrupt);
+  if (port) {
+    result = waitForJobEvents(job, port, ls, interrupt);
+  } else {
+    result = waitForProcessesThreadImpl(job, ls, interrupt);
+  }
 
   // the session can be null when running shortcuts with locking disabled
   if (ls) {
@@ -392,6 +510,34 @@ ProcessRunner::Results waitForProcesses(
     return ProcessRunner::Error;
   }
 
+  // the port must be associated before the processes are added to the job,
+  // or the messages for them would be lost
+  env::HandlePtr port(CreateIoCompletionPort(
+    INVALID_HANDLE_VALUE, nullptr, 0, 1));
+
+  if (port) {
+    JOBOBJECT_ASSOCIATE_COMPLETION_PORT acp = {};
+    acp.CompletionKey = reinterpret_cast<PVOID>(JobKey);
+    acp.CompletionPort = port.get();
+
+    if (!::SetInformationJobObject(
+      job.get(), JobObjectAssociateCompletionPortInformation,
+      &acp, sizeof(acp))) {
+      const auto e = GetLastError();
+
+      log::warn(
+        "failed to associate completion port with job, polling instead, {}",
+        formatSystemMessage(e));
+
+      port.reset();
+    }
+  } else {
+    const auto e = GetLastError();
+    log::warn(
+      "failed to create completion port, polling instead, {}",
+      formatSystemMessage(e));
+  }
+
   bool oneWorked = false;
 
   for (auto&& h : initialProcesses) {
@@ -418,14 +564,23 @@ ProcessRunner::Results waitForProcesses(
   } else {
     // none of the handles could be added to the job, just monitor the first one
     monitor = initialProcesses[0];
+    port.reset();
   }
 
   auto results = ProcessRunner::Running;
   std::atomic<bool> interrupt(false);
 
+  auto wake = [p=port.get()] {
+    ::PostQueuedCompletionStatus(p, 0, WakeKey, nullptr);
+  };
+
+  if (port && ls) {
+    ls->setResultCallback(wake);
+  }
+
   auto* t = QThread::create(
     waitForProcessesThread,
-    std::ref(results), monitor, ls, std::ref(interrupt));
+    std::ref(results), monitor, port.get(), ls, std::ref(interrupt));
 
   QEventLoop events;
   QObject::connect(t, &QThread::finished, [&]{
@@ -437,11 +592,20 @@ ProcessRunner::Results waitForProcesses(
 
   if (t->isRunning()) {
     interrupt = true;
+
+    if (port) {
+      wake();
+    }
+
     t->wait();
   }
 
   delete t;
 
+  if (port && ls) {
+    ls->setResultCallback({});
+  }
+
   return results;
 }
 
@@ -468,7 +632,8 @@ ProcessRunner::Results waitForProcess(
 
 ProcessRunner::ProcessRunner(OrganizerCore& core, IUserInterface* ui) :
   m_core(core), m_ui(ui), m_lockReason(UILocker::NoReason),
-  m_waitFlags(NoFlags), m_handle(INVALID_HANDLE_VALUE), m_exitCode(-1)
+  m_lockMode(UILocker::FullLock), m_waitFlags(NoFlags),
+  m_handle(INVALID_HANDLE_VALUE), m_exitCode(-1)
 {
   // all processes started in ProcessRunner are hooked by default
   setHooked(true);
@@ -537,6 +702,12 @@ ProcessRunner& ProcessRunner::setHooked(bool b)
   return *this;
 }
 
+ProcessRunner& ProcessRunner::setLockMode(UILocker::Modes mode)
+{
+  m_lockMode = mode;
+  return *this;
+}
+
 ProcessRunner& ProcessRunner::setFromFile(
   QWidget* parent, const QFileInfo& targetInfo)
 {
@@ -597,6 +768,7 @@ ProcessRunner& ProcessRunner::setFromExecutable(const Executable& exe)
   setSteamID(exe.steamAppID());
   setCustomOverwrite(customOverwrite);
   setForcedLibraries(forcedLibraries);
+  setLockMode(exe.lightLock() ? UILocker::LightLock : UILocker::FullLock);
 
   return *this;
 }
@@ -655,6 +827,7 @@ ProcessRunner& ProcessRunner::setFromFileOrExecutable(
       const Executable& exe = m_core.executablesList()->getByBinary(m_sp.binary);
 
       setSteamID(exe.steamAppID());
+      setLockMode(exe.lightLock() ? UILocker::LightLock : UILocker::FullLock);
       setCustomOverwrite(profile->setting("custom_overwrites", exe.title()).toString());
 
       if (profile->forcedLibrariesEnabled(exe.title())) {
@@ -669,6 +842,7 @@ ProcessRunner& ProcessRunner::setFromFileOrExecutable(
       const Executable &exe = m_core.executablesList()->get(executable);
 
       setSteamID(exe.steamAppID());
+      setLockMode(exe.lightLock() ? UILocker::LightLock : UILocker::FullLock);
       setCustomOverwrite(profile->setting("custom_overwrites", exe.title()).toString());
 
       if (profile->forcedLibrariesEnabled(exe.title())) {
@@ -783,6 +957,8 @@ std::optional<ProcessRunner::Results> ProcessRunner::runBinary()
     m_profileName = profile->name();
   }
 
+  LaunchTimeline::Scope timeline(m_sp.binary.fileName());
+
   // saves profile, sets up usvfs, notifies plugins, etc.; can return false if
   // a plugin doesn't want the program to run (such as when checkFNIS fails to
   // run FNIS and the user clicks cancel)
@@ -796,9 +972,13 @@ std::optional<ProcessRunner::Results> ProcessRunner::runBinary()
   const auto* game = m_core.managedGame();
   auto& settings = m_core.settings();
 
-  // start steam if needed
-  if (!checkSteam(parent, m_sp, game->gameDirectory(), m_sp.steamAppID, settings)) {
-    return Error;
+  {
+    // start steam if needed
+    LaunchTimeline::Stage s("steam");
+
+    if (!checkSteam(parent, m_sp, game->gameDirectory(), m_sp.steamAppID, settings)) {
+      return Error;
+    }
   }
 
   // warn if the executable is on the blacklist
@@ -810,10 +990,22 @@ std::optional<ProcessRunner::Results> ProcessRunner::runBinary()
   // ModOrganizer.exe is spawned instead to launch it
   adjustForVirtualized(game, m_sp, settings);
 
-  // run the binary
-  m_handle.reset(startBinary(parent, m_sp));
-  if (m_handle.get() == INVALID_HANDLE_VALUE) {
-    return Error;
+  {
+    // run the binary, this includes the injection of usvfs
+    LaunchTimeline::Stage s("start");
+
+    m_handle.reset(startBinary(parent, m_sp));
+    if (m_handle.get() == INVALID_HANDLE_VALUE) {
+      return Error;
+    }
+  }
+
+  timeline.started(::GetProcessId(m_handle.get()));
+
+  // games are large and are started through the vfs, the caches can be built
+  // again once they're needed
+  if (m_sp.hooked) {
+    MemoryAccounting::trim("a hooked program started");
   }
 
   return {};
@@ -1013,6 +1205,6 @@ ProcessRunner::Results ProcessRunner::waitForAllUSVFSProcessesWithLock(
 
 void ProcessRunner::withLock(std::function<void (UILocker::Session&)> f)
 {
-  auto ls = UILocker::instance().lock(m_lockReason);
+  auto ls = UILocker::instance().lock(m_lockReason, m_lockMode);
   f(*ls);
 }
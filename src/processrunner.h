@@ -87,6 +87,11 @@ public:
     WaitFlags flags=NoFlags, UILocker::Reasons reason=UILocker::LockUI);
   ProcessRunner& setHooked(bool b);
 
+  // how the ui is locked while waiting for the process, FullLock by default;
+  // set from the executable when there is one
+  //
+  ProcessRunner& setLockMode(UILocker::Modes mode);
+
   // - if the target is an executable file, runs it hooked
   // - if the target is a file:
   //     - if forceHook is false, calls ShellExecute() on it
@@ -167,6 +172,7 @@ private:
   ForcedLibraries m_forcedLibraries;
   QString m_profileName;
   UILocker::Reasons m_lockReason;
+  UILocker::Modes m_lockMode;
   WaitFlags m_waitFlags;
   QFileInfo m_shellOpen;
   env::HandlePtr m_handle;
@@ -29,8 +29,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <bsainvalidation.h>
 #include <dataarchives.h>
 #include "shared/util.h"
-#include "registry.h"
 #include "modinfoforeign.h"
+#include "taskexecutor.h"
 #include <questionboxmemory.h>
 
 #include <QApplication>
@@ -43,6 +43,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QtGlobal>                                // for qUtf8Printable
 #include <QBuffer>
 #include <QDirIterator>
+#include <QFileInfo>
+#include <QSet>
 
 #include <Windows.h>
 
@@ -52,8 +54,11 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <string.h>                                // for wcslen
 
 #include <algorithm>                               // for max, min
+#include <cctype>
+#include <cstring>
 #include <exception>                               // for exception
 #include <functional>
+#include <deque>
 #include <set>                                     // for set
 #include <utility>                                 // for find
 #include <stdexcept>
@@ -225,28 +230,35 @@ void Profile::doWriteModlist()
     QString fileName = getModlistFileName();
     SafeWriteFile file(fileName);
 
-    file->write(QString("# This file was automatically generated by Mod Organizer.\r\n").toUtf8());
     if (m_ModStatus.empty()) {
+      file->write(QString("# This file was automatically generated by Mod Organizer.\r\n").toUtf8());
       return;
     }
 
+    // the list is built in memory and written in one go, the file is only
+    // replaced if the content changed
+    QByteArray data;
+    data.reserve(static_cast<int>(m_ModStatus.size()) * 48);
+    data.append("# This file was automatically generated by Mod Organizer.\r\n");
+
     for (auto iter = m_ModIndexByPriority.crbegin(); iter != m_ModIndexByPriority.crend(); iter++) {
       // the priority order was inverted on load so it has to be inverted again
       const auto index = iter->second;
       ModInfo::Ptr modInfo = ModInfo::getByIndex(index);
       if (!modInfo->hasAutomaticPriority()) {
         if (modInfo->isForeign()) {
-          file->write("*");
+          data.append('*');
         } else if (m_ModStatus[index].m_Enabled) {
-          file->write("+");
+          data.append('+');
         } else {
-          file->write("-");
+          data.append('-');
         }
-        file->write(modInfo->name().toUtf8());
-        file->write("\r\n");
+        data.append(modInfo->name().toUtf8());
+        data.append("\r\n");
       }
     }
 
+    file->write(data);
     file.commitIfDifferent(m_LastModlistHash);
   } catch (const std::exception &e) {
     reportError(tr("failed to write mod list: %1").arg(e.what()));
@@ -255,37 +267,192 @@ void Profile::doWriteModlist()
 }
 
 
+// the keys of ini tweaks merged together, sections and keys are kept in the
+// order they first appear; names are compared case-insensitively, like the
+// private profile functions do
+//
+class MergedIni
+{
+public:
+  // adds the given tweak file, its values replace the ones of tweaks added
+  // before; returns false if it can't be read
+  //
+  bool add(const QString& path)
+  {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+      log::warn("can't read ini tweak '{}', {}", path, f.errorString());
+      return false;
+    }
+
+    const QByteArray data = f.readAll();
+    QString s;
+
+    if (data.startsWith("\xff\xfe")) {
+      s = QString::fromUtf16(
+        reinterpret_cast<const char16_t*>(data.constData() + 2),
+        (data.size() - 2) / 2);
+    } else {
+      s = QString::fromLocal8Bit(data);
+    }
+
+    // the private profile functions return the first value of a key that's
+    // duplicated in a file
+    QSet<QString> seen;
+    Section* section = nullptr;
+
+    for (QStringRef line : s.splitRef('\n')) {
+      line = line.trimmed();
+
+      if (line.isEmpty() || line.startsWith(';')) {
+        continue;
+      }
+
+      if (line.startsWith('[')) {
+        const int end = line.indexOf(']');
+        section = &getSection(
+          line.mid(1, end < 0 ? -1 : end - 1).trimmed().toString());
+
+        continue;
+      }
+
+      const int eq = line.indexOf('=');
+      if (!section || eq < 0) {
+        continue;
+      }
+
+      const QString key = line.left(eq).trimmed().toString();
+      QStringRef value = line.mid(eq + 1).trimmed();
+
+      if (value.size() >= 2) {
+        const QChar q = value.front();
+        if ((q == '"' || q == '\'') && value.back() == q) {
+          value = value.mid(1, value.size() - 2);
+        }
+      }
+
+      const QString id = section->name.toLower() + "\n" + key.toLower();
+      if (seen.contains(id)) {
+        continue;
+      }
+
+      seen.insert(id);
+      set(*section, key, value.toString());
+    }
+
+    return true;
+  }
+
+  void set(const QString& section, const QString& key, const QString& value)
+  {
+    set(getSection(section), key, value);
+  }
+
+  QByteArray toByteArray() const
+  {
+    QString s;
+
+    for (const auto& section : m_sections) {
+      if (section.keys.empty()) {
+        continue;
+      }
+
+      s += "[" + section.name + "]\r\n";
+
+      for (const auto& [key, value] : section.keys) {
+        s += key + "=" + value + "\r\n";
+      }
+
+      s += "\r\n";
+    }
+
+    return s.toLocal8Bit();
+  }
+
+private:
+  struct Section
+  {
+    QString name;
+    std::vector<std::pair<QString, QString>> keys;
+    QHash<QString, std::size_t> index;
+  };
+
+  // sections are referenced while others are added
+  std::deque<Section> m_sections;
+  QHash<QString, std::size_t> m_index;
+
+  Section& getSection(const QString& name)
+  {
+    const QString lc = name.toLower();
+
+    auto itor = m_index.constFind(lc);
+    if (itor != m_index.constEnd()) {
+      return m_sections[*itor];
+    }
+
+    m_index.insert(lc, m_sections.size());
+    m_sections.push_back({name, {}, {}});
+
+    return m_sections.back();
+  }
+
+  void set(Section& section, const QString& key, const QString& value)
+  {
+    const QString lc = key.toLower();
+
+    auto itor = section.index.constFind(lc);
+    if (itor != section.index.constEnd()) {
+      section.keys[*itor].second = value;
+      return;
+    }
+
+    section.index.insert(lc, section.keys.size());
+    section.keys.push_back({key, value});
+  }
+};
+
+
 void Profile::createTweakedIniFile()
 {
-  QString tweakedIni = m_Directory.absoluteFilePath("initweaks.ini");
+  const QString tweakedIni = m_Directory.absoluteFilePath("initweaks.ini");
+  const auto tweaks = activeIniTweaks();
 
-  if (QFile::exists(tweakedIni) && !shellDeleteQuiet(tweakedIni)) {
-    const auto e = GetLastError();
-    reportError(
-      tr("failed to update tweaked ini file, wrong settings may be used: %1")
-        .arg(QString::fromStdWString(formatSystemMessage(e))));
+  // the file only depends on the tweaks and their content
+  QByteArray key;
+  for (const auto& path : tweaks) {
+    const QFileInfo fi(path);
+
+    key += path.toUtf8() + '\t' +
+      QByteArray::number(fi.lastModified().toMSecsSinceEpoch()) + '\t' +
+      QByteArray::number(fi.size()) + '\n';
+  }
+
+  if (key == m_TweakedIniKey && QFile::exists(tweakedIni)) {
     return;
   }
 
-  for (const auto& [priority, index] : m_ModIndexByPriority) {
-    if (m_ModStatus[index].m_Enabled) {
-      ModInfo::Ptr modInfo = ModInfo::getByIndex(index);
-      mergeTweaks(modInfo, tweakedIni);
+  MergedIni ini;
+
+  for (const auto& path : tweaks) {
+    if (QFile::exists(path)) {
+      ini.add(path);
     }
   }
 
-  mergeTweak(getProfileTweaks(), tweakedIni);
+  ini.set("Archive", "bInvalidateOlderFiles", "1");
 
-  bool error = false;
-  if (!MOBase::WriteRegistryValue(L"Archive", L"bInvalidateOlderFiles", L"1", ToWString(tweakedIni).c_str())) {
-    error = true;
+  try {
+    SafeWriteFile file(tweakedIni);
+    file->write(ini.toByteArray());
+    file.commit();
+  } catch (const std::exception &e) {
+    m_TweakedIniKey.clear();
+    reportError(tr("failed to create tweaked ini: %1").arg(e.what()));
+    return;
   }
 
-  if (error) {
-    const auto e = ::GetLastError();
-    reportError(tr("failed to create tweaked ini: %1")
-      .arg(QString::fromStdWString(formatSystemMessage(e))));
-  }
+  log::debug("tweaked ini created from {} tweaks", tweaks.size());
+  m_TweakedIniKey = key;
 }
 
 // static
@@ -293,23 +460,48 @@ void Profile::renameModInAllProfiles(const QString& oldName, const QString& newN
 {
   QDir profilesDir(Settings::instance().paths().profiles());
   profilesDir.setFilter(QDir::AllDirs | QDir::NoDotAndDotDot);
+
+  std::vector<QString> lists;
+
   QDirIterator profileIter(profilesDir);
   while (profileIter.hasNext()) {
     profileIter.next();
-    QFile modList(profileIter.filePath() + "/modlist.txt");
-    if (modList.exists())
-      renameModInList(modList, oldName, newName);
+    const QString path = profileIter.filePath() + "/modlist.txt";
+    if (QFile::exists(path))
+      lists.push_back(path);
     else
       log::warn("Profile has no modlist.txt: {}", profileIter.filePath());
   }
+
+  // one task per profile, errors are reported once they're all done
+  std::vector<QString> errors(lists.size());
+
+  {
+    MOShared::TaskGroup group(MOShared::TaskPriority::High);
+
+    for (std::size_t i=0; i<lists.size(); ++i) {
+      group.run([&, i] {
+        errors[i] = renameModInList(lists[i], oldName, newName);
+      });
+    }
+
+    group.wait();
+  }
+
+  for (auto&& e : errors) {
+    if (!e.isEmpty()) {
+      reportError(e);
+    }
+  }
 }
 
 // static
-void Profile::renameModInList(QFile &modList, const QString &oldName, const QString &newName)
+QString Profile::renameModInList(const QString &path, const QString &oldName, const QString &newName)
 {
+  QFile modList(path);
+
   if (!modList.open(QIODevice::ReadOnly)) {
-    reportError(tr("failed to open %1").arg(modList.fileName()));
-    return;
+    return tr("failed to open %1").arg(modList.fileName());
   }
 
   QBuffer outBuffer;
@@ -350,16 +542,24 @@ void Profile::renameModInList(QFile &modList, const QString &oldName, const QStr
   }
   modList.close();
 
-  if (renamed) {
-    modList.open(QIODevice::WriteOnly);
-    modList.write(outBuffer.buffer());
-    modList.close();
+  if (!renamed) {
+    return {};
   }
 
-  if (renamed)
-    log::debug(
-      "Renamed {} \"{}\" mod to \"{}\" in {}",
-      renamed, oldName, newName, modList.fileName());
+  // replaced atomically so a crash can't leave a truncated list behind
+  try {
+    SafeWriteFile file(path);
+    file->write(outBuffer.buffer());
+    file.commit();
+  } catch (const std::exception &e) {
+    return tr("failed to write mod list: %1").arg(e.what());
+  }
+
+  log::debug(
+    "Renamed {} \"{}\" mod to \"{}\" in {}",
+    renamed, oldName, newName, path);
+
+  return {};
 }
 
 void Profile::refreshModStatus()
@@ -398,58 +598,97 @@ void Profile::refreshModStatus()
 
   writeModlistNow(true); // if there are pending changes write them first
 
-  QFile file(getModlistFileName());
+  const QString fileName = getModlistFileName();
+
+  // nothing to do if neither the file nor the mods changed since the last
+  // parse, which happens a lot on startup and when switching profiles
+  const QFileInfo fi(fileName);
+  const int generation = ModInfo::generation();
+
+  if (m_ModlistSnapshot &&
+      m_ModStatus.size() == ModInfo::getNumMods() &&
+      m_ModlistSnapshot->generation == generation &&
+      m_ModlistSnapshot->size == fi.size() &&
+      m_ModlistSnapshot->time == fi.lastModified()) {
+    return;
+  }
+
+  m_ModlistSnapshot.reset();
+
+  QFile file(fileName);
   if (!file.open(QIODevice::ReadOnly)) {
-    throw MyException(tr("\"%1\" is missing or inaccessible").arg(getModlistFileName()));
+    throw MyException(tr("\"%1\" is missing or inaccessible").arg(fileName));
   }
 
+  // the whole file is read at once, lines are only views into it
+  const QByteArray data = file.readAll();
+  file.close();
+
   bool modStatusModified = false;
   m_ModStatus.clear();
   m_ModStatus.resize(ModInfo::getNumMods());
 
-  std::set<QString> namesRead;
+  // mods that were already read, by index
+  std::vector<bool> modsRead(m_ModStatus.size(), false);
+
+  // names that didn't match a mod, so they're only logged once
+  QSet<QString> unknownNames;
 
   bool warnAboutOverwrite = false;
 
   // load mods from file and update enabled state and priority for them
   int index = 0;
-  while (!file.atEnd()) {
-    QByteArray line = file.readLine().trimmed();
+  const char* p = data.constData();
+  const char* const end = p + data.size();
+
+  while (p < end) {
+    const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (!lineEnd) {
+      lineEnd = end;
+    }
+
+    const char* b = p;
+    const char* e = lineEnd;
+    p = lineEnd + 1;
+
+    // trimmed
+    while (b < e && std::isspace(static_cast<unsigned char>(*b))) ++b;
+    while (e > b && std::isspace(static_cast<unsigned char>(*(e - 1)))) --e;
 
     // find the mod name and the enabled status
     bool enabled = true;
-    QString modName;
-    if (line.length() == 0) {
+    if (b == e) {
       // empty line
       continue;
-    } else if (line.at(0) == '#') {
+    } else if (*b == '#') {
       // comment line
       continue;
-    } else if (line.at(0) == '-') {
+    } else if (*b == '-') {
       enabled = false;
-      modName = QString::fromUtf8(line.mid(1).trimmed().constData());
-    } else if (line.at(0) == '+' || line.at(0) == '*') {
-      modName = QString::fromUtf8(line.mid(1).trimmed().constData());
-    } else {
-      modName = QString::fromUtf8(line.trimmed().constData());
+      ++b;
+    } else if (*b == '+' || *b == '*') {
+      ++b;
     }
 
-    if (modName.isEmpty()) {
+    while (b < e && std::isspace(static_cast<unsigned char>(*b))) ++b;
+
+    if (b == e) {
       continue;
     }
 
+    const QString modName = QString::fromUtf8(b, static_cast<int>(e - b));
+
     if (modName.compare("overwrite", Qt::CaseInsensitive) == 0) {
       warnAboutOverwrite = true;
     }
 
-    // check if the name was already read
-    if (namesRead.find(modName) != namesRead.end()) {
-      continue;
-    }
-    namesRead.insert(modName);
-
     unsigned int modIndex = ModInfo::getIndex(modName);
     if (modIndex == UINT_MAX) {
+      if (unknownNames.contains(modName)) {
+        continue;
+      }
+      unknownNames.insert(modName);
+
       log::debug(
         "mod not found: \"{}\" (profile \"{}\")",
         modName, m_Directory.path());
@@ -458,6 +697,14 @@ void Profile::refreshModStatus()
       continue;
     }
 
+    // check if the mod was already read
+    if (modIndex < modsRead.size()) {
+      if (modsRead[modIndex]) {
+        continue;
+      }
+      modsRead[modIndex] = true;
+    }
+
     // find the mod and check that this is a regular mod (and not a backup)
     ModInfo::Ptr info = ModInfo::getByIndex(modIndex);
     if (modIndex < m_ModStatus.size() && !info->hasAutomaticPriority()) {
@@ -476,9 +723,7 @@ void Profile::refreshModStatus()
       modStatusModified = true;
     }
 
-  } // while (!file.atEnd())
-
-  file.close();
+  } // while (p < end)
 
   const int numKnownMods = index;
   int topInsert = 0;
@@ -556,6 +801,8 @@ void Profile::refreshModStatus()
 
   if (modStatusModified) {
     m_ModListWriter.write();
+  } else {
+    m_ModlistSnapshot = ModlistSnapshot{fi.lastModified(), fi.size(), generation};
   }
 }
 
@@ -614,6 +861,7 @@ void Profile::setModEnabled(unsigned int index, bool enabled)
 
   if (enabled != m_ModStatus[index].m_Enabled) {
     m_ModStatus[index].m_Enabled = enabled;
+    m_ModlistSnapshot.reset();
     emit modStatusChanged(index);
   }
 }
@@ -648,6 +896,7 @@ void Profile::setModsEnabled(const QList<unsigned int>& modsToEnable, const QLis
     }
   }
   if (!dirtyMods.isEmpty()) {
+    m_ModlistSnapshot.reset();
     emit modStatusChanged(dirtyMods);
   }
 }
@@ -703,6 +952,7 @@ bool Profile::setModPriority(unsigned int index, int &newPriority)
   m_ModStatus.at(index).m_Priority = std::min(newPriority, lastPriority);
 
   updateIndices();
+  m_ModlistSnapshot.reset();
   m_ModListWriter.write();
 
   return true;
@@ -711,82 +961,102 @@ bool Profile::setModPriority(unsigned int index, int &newPriority)
 Profile *Profile::createPtrFrom(const QString &name, const Profile &reference, MOBase::IPluginGame const *gamePlugin)
 {
   QString profileDirectory = Settings::instance().paths().profiles() + "/" + name;
-  reference.copyFilesTo(profileDirectory);
-  return new Profile(QDir(profileDirectory), gamePlugin);
-}
 
-void Profile::copyFilesTo(QString &target) const
-{
-  copyDir(m_Directory.absolutePath(), target, false);
-}
+  const std::atomic<bool> cancel = false;
+  reference.cloneFilesTo(profileDirectory, cancel);
 
-std::vector<std::wstring> Profile::splitDZString(const wchar_t *buffer) const
-{
-  std::vector<std::wstring> result;
-  const wchar_t *pos = buffer;
-  size_t length = wcslen(pos);
-  while (length != 0U) {
-    result.push_back(pos);
-    pos += length + 1;
-    length = wcslen(pos);
-  }
-  return result;
+  return new Profile(QDir(profileDirectory), gamePlugin);
 }
 
-void Profile::mergeTweak(const QString &tweakName, const QString &tweakedIni) const
+bool Profile::cloneFilesTo(
+  const QString& target, const std::atomic<bool>& cancel,
+  const CloneProgressF& progress) const
 {
-  static const int bufferSize = 32768;
+  const QDir source(m_Directory.absolutePath());
+  const QDir dest(target);
 
-  std::wstring tweakNameW  = ToWString(tweakName);
-  std::wstring tweakedIniW = ToWString(tweakedIni);
-  QScopedArrayPointer<wchar_t> buffer(new wchar_t[bufferSize]);
+  if (!dest.mkpath(".")) {
+    throw MyException(tr("failed to create %1").arg(target));
+  }
 
-  // retrieve a list of sections
-  DWORD size = ::GetPrivateProfileSectionNamesW(
-        buffer.data(), bufferSize, tweakNameW.c_str());
+  // listed first so the progress has a total
+  QStringList files;
 
-  if (size == bufferSize - 2) {
-    // unfortunately there is no good way to find the required size
-    // of the buffer
-    throw MyException(QString("Buffer too small. Please report this as a bug. "
-                        "For now you might want to split up %1").arg(tweakName));
+  {
+    QDirIterator itor(
+      source.absolutePath(),
+      QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+      QDirIterator::Subdirectories);
+
+    while (itor.hasNext()) {
+      itor.next();
+      const QString relative = source.relativeFilePath(itor.filePath());
+
+      if (itor.fileInfo().isDir()) {
+        if (!dest.mkpath(relative)) {
+          throw MyException(tr("failed to create %1").arg(dest.filePath(relative)));
+        }
+      } else {
+        files.append(relative);
+      }
+    }
   }
 
-  std::vector<std::wstring> sections = splitDZString(buffer.data());
+  std::size_t linked = 0;
 
-  // now iterate over all sections and retrieve a list of keys in each
-  for (std::vector<std::wstring>::iterator iter = sections.begin();
-       iter != sections.end(); ++iter) {
-    // retrieve the names of all keys
-    size = ::GetPrivateProfileStringW(iter->c_str(), nullptr, nullptr, buffer.data(),
-                                      bufferSize, tweakNameW.c_str());
-    if (size == bufferSize - 2) {
-      throw MyException(QString("Buffer too small. Please report this as a bug. "
-                          "For now you might want to split up %1").arg(tweakName));
+  for (int i=0; i<files.size(); ++i) {
+    if (cancel) {
+      return false;
     }
 
-    std::vector<std::wstring> keys = splitDZString(buffer.data());
+    const auto& relative = files[i];
+
+    const auto from = QDir::toNativeSeparators(source.filePath(relative)).toStdWString();
+    const auto to = QDir::toNativeSeparators(dest.filePath(relative)).toStdWString();
+
+    const bool save = relative.startsWith("saves/", Qt::CaseInsensitive);
 
-    for (std::vector<std::wstring>::iterator keyIter = keys.begin();
-         keyIter != keys.end(); ++keyIter) {
-       //TODO this treats everything as strings but how could I differentiate the type?
-      ::GetPrivateProfileStringW(iter->c_str(), keyIter->c_str(),
-                                 nullptr, buffer.data(), bufferSize, ToWString(tweakName).c_str());
-      MOBase::WriteRegistryValue(iter->c_str(), keyIter->c_str(),
-                                   buffer.data(), tweakedIniW.c_str());
+    if (save && ::CreateHardLinkW(to.c_str(), from.c_str(), nullptr)) {
+      ++linked;
+    } else if (!::CopyFileW(from.c_str(), to.c_str(), FALSE)) {
+      const auto e = ::GetLastError();
+
+      throw MyException(tr("failed to copy %1 to %2: %3")
+        .arg(QString::fromStdWString(from))
+        .arg(QString::fromStdWString(to))
+        .arg(QString::fromStdWString(formatSystemMessage(e))));
+    }
+
+    if (progress) {
+      progress(static_cast<std::size_t>(i) + 1, files.size());
     }
   }
+
+  log::debug(
+    "cloned profile '{}' to '{}', {} files linked and {} copied",
+    source.absolutePath(), target, linked, files.size() - linked);
+
+  return true;
 }
 
-void Profile::mergeTweaks(ModInfo::Ptr modInfo, const QString &tweakedIni) const
+std::vector<QString> Profile::activeIniTweaks() const
 {
-  std::vector<QString> iniTweaks = modInfo->getIniTweaks();
-  for (std::vector<QString>::iterator iter = iniTweaks.begin();
-       iter != iniTweaks.end(); ++iter) {
-    mergeTweak(*iter, tweakedIni);
+  std::vector<QString> v;
+
+  for (const auto& [priority, index] : m_ModIndexByPriority) {
+    if (m_ModStatus[index].m_Enabled) {
+      ModInfo::Ptr modInfo = ModInfo::getByIndex(index);
+
+      for (auto&& t : modInfo->getIniTweaks()) {
+        v.push_back(std::move(t));
+      }
+    }
   }
-}
 
+  v.push_back(getProfileTweaks());
+
+  return v;
+}
 
 bool Profile::invalidationActive(bool *supported) const
 {
@@ -934,6 +1204,11 @@ QString Profile::getArchivesFileName() const
   return QDir::cleanPath(m_Directory.absoluteFilePath("archives.txt"));
 }
 
+QString Profile::getStructureSnapshotFileName() const
+{
+  return QDir::cleanPath(m_Directory.absoluteFilePath("structure.snapshot"));
+}
+
 QString Profile::getIniFileName() const
 {
   auto iniFiles = m_GamePlugin->iniFiles();
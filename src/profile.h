@@ -27,6 +27,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "executableinfo.h"
 
 #include <QByteArray>
+#include <QDateTime>
 #include <QDir>
 #include <QObject>
 #include <QString>
@@ -35,6 +36,9 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <boost/shared_ptr.hpp>
 
+#include <atomic>
+#include <functional>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -105,7 +109,32 @@ public:
    **/
   static Profile *createPtrFrom(const QString &name, const Profile &reference, MOBase::IPluginGame const *gamePlugin);
 
+  // called with the number of files cloned so far and the total
+  using CloneProgressF = std::function<void (std::size_t done, std::size_t total)>;
 
+  /**
+   * @brief copies the files of this profile into the given directory, which
+   *        becomes a new profile
+   *
+   * local saves are hardlinked when the directory is on the same volume,
+   * games write new files instead of changing existing saves so the profiles
+   * don't affect each other; the mod list, plugins and ini files are copied
+   *
+   * this doesn't change the profile and can run on any thread; `progress` is
+   * called from that thread
+   *
+   * @return false if `cancel` was set before everything was cloned
+   * @throws MyException if a file can't be cloned
+   **/
+  bool cloneFilesTo(
+    const QString& target, const std::atomic<bool>& cancel,
+    const CloneProgressF& progress={}) const;
+
+
+  // renames the mod in the mod list of every profile; the lists are rewritten
+  // in parallel and this returns once they're all done, since the current
+  // profile is typically refreshed right after
+  //
   static void renameModInAllProfiles(const QString& oldName, const QString& newName);
 
   void writeModlist();
@@ -189,6 +218,11 @@ public:
    */
   QString getArchivesFileName() const;
 
+  /**
+   * @return path of the directory structure snapshot for this profile
+   */
+  QString getStructureSnapshotFileName() const;
+
   /**
    * @return the path of the ini file in this profile
    * @todo since the game can contain multiple ini files (i.e. skyrim.ini skyrimprefs.ini)
@@ -373,14 +407,17 @@ private:
 
   void updateIndices();
 
-  void copyFilesTo(QString &target) const;
+  // paths of the ini tweaks of the enabled mods, by priority, followed by the
+  // tweaks of the profile
+  //
+  std::vector<QString> activeIniTweaks() const;
 
-  std::vector<std::wstring> splitDZString(const wchar_t *buffer) const;
-  void mergeTweak(const QString &tweakName, const QString &tweakedIni) const;
-  void mergeTweaks(ModInfo::Ptr modInfo, const QString &tweakedIni) const;
   void touchFile(QString fileName);
 
-  static void renameModInList(QFile &modList, const QString &oldName, const QString &newName);
+  // renames the mod in the given mod list, which is replaced atomically; can be
+  // called from any thread, returns an error message on failure
+  //
+  static QString renameModInList(const QString &path, const QString &oldName, const QString &newName);
 
 private:
 
@@ -400,6 +437,22 @@ private:
   mutable QByteArray m_LastModlistHash;
   MOBase::DelayedFileWriter m_ModListWriter;
 
+  // the modlist.txt that m_ModStatus was last parsed from, along with the
+  // mod collection at that time; refreshModStatus() does nothing when neither
+  // changed
+  struct ModlistSnapshot
+  {
+    QDateTime time;
+    qint64 size = -1;
+    int generation = -1;
+  };
+
+  std::optional<ModlistSnapshot> m_ModlistSnapshot;
+
+  // the tweaks initweaks.ini was last generated from, along with their times
+  // and sizes; createTweakedIniFile() does nothing when it's unchanged
+  QByteArray m_TweakedIniKey;
+
 };
 
 
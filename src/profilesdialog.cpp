@@ -22,6 +22,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "shared/appconfig.h"
 #include "bsainvalidation.h"
+#include "deletionqueue.h"
 #include "iplugingame.h"
 #include "organizercore.h"
 #include "profile.h"
@@ -34,14 +35,20 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QDir>
 #include <QDirIterator>
+#include <QEventLoop>
+#include <QFutureWatcher>
 #include <QInputDialog>
 #include <QLineEdit>
 #include <QListWidgetItem>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <QTimer>
 #include <QWhatsThis>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <Windows.h>
 
+#include <atomic>
 #include <exception>
 
 using namespace MOBase;
@@ -171,8 +178,64 @@ void ProfilesDialog::createProfile(const QString &name, bool useDefaultSettings)
 void ProfilesDialog::createProfile(const QString &name, const Profile &reference)
 {
   try {
+    const QString directory = Settings::instance().paths().profiles() + "/" + name;
+
+    // profiles with many local saves take a while to clone, the files are
+    // cloned on another thread while the dialog shows the progress
+    std::atomic<bool> cancel = false;
+    std::atomic<int> percent = 0;
+
+    QProgressDialog progress(tr("Copying profile..."), tr("Cancel"), 0, 100, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    progress.setAutoReset(false);
+
+    QTimer timer;
+    connect(&timer, &QTimer::timeout, [&] { progress.setValue(percent); });
+    connect(&progress, &QProgressDialog::canceled, [&] { cancel = true; });
+    timer.start(100);
+
+    QEventLoop loop;
+    QFutureWatcher<QString> watcher;
+    connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+
+    // QtConcurrent loses the message of exceptions, so the error is returned
+    bool cloned = false;
+
+    watcher.setFuture(QtConcurrent::run([&]() -> QString {
+      try {
+        cloned = reference.cloneFilesTo(directory, cancel, [&](auto done, auto total) {
+          percent = static_cast<int>(total > 0 ? 100 * done / total : 100);
+        });
+
+        return {};
+      } catch (const std::exception& e) {
+        return QString::fromUtf8(e.what());
+      }
+    }));
+
+    if (!watcher.isFinished()) {
+      loop.exec();
+    }
+
+    timer.stop();
+    progress.reset();
+
+    const QString error = watcher.result();
+
+    if (!error.isEmpty()) {
+      DeletionQueue::add(QStringList(directory), false);
+      throw MyException(error);
+    }
+
+    if (!cloned) {
+      log::debug("copying profile '{}' cancelled", name);
+      DeletionQueue::add(QStringList(directory), false);
+      return;
+    }
+
     QListWidgetItem *newItem = new QListWidgetItem(name, ui->profilesList);
-    auto profile = Profile::Ptr(Profile::createPtrFrom(name, reference, m_Game));
+    auto profile = Profile::Ptr(new Profile(QDir(directory), m_Game));
     newItem->setData(Qt::UserRole, QVariant::fromValue(profile));
     ui->profilesList->addItem(newItem);
     m_FailState = false;
@@ -254,7 +317,8 @@ void ProfilesDialog::on_removeProfileButton_clicked()
     if (item != nullptr) {
       delete item;
     }
-    if (!shellDelete(QStringList(profilePath))) {
+    if (!DeletionQueue::add(QStringList(profilePath), false).isEmpty() &&
+        !shellDelete(QStringList(profilePath))) {
       log::warn("Failed to shell-delete \"{}\" (errorcode {}), trying regular delete", profilePath, ::GetLastError());
       if (!removeDir(profilePath)) {
         log::warn("regular delete failed too");
@@ -4,6 +4,7 @@
 #include <type_traits>
 
 #include "organizerproxy.h"
+#include "pluginstats.h"
 
 namespace MOShared {
 
@@ -29,6 +30,44 @@ namespace MOShared {
     }, defaultReturn);
   }
 
+  // same as callIfPluginActive(), but the calls are timed, see
+  // PluginCallTimer
+  template <class Fn, class T = int>
+  auto callTimedIfPluginActive(
+    OrganizerProxy* proxy, Fn&& callback, const char* event,
+    T defaultReturn = T{})
+  {
+    return callIfPluginActive(proxy,
+      [fn = std::forward<Fn>(callback), proxy, event](auto&&... args) {
+        PluginCallTimer t(proxy->plugin(), event);
+        return fn(std::forward<decltype(args)>(args)...);
+      }, defaultReturn);
+  }
+
+  // same as callSignalIfPluginActive(), but the handlers are timed, see
+  // PluginCallTimer
+  template <class Signal, class T = int>
+  auto callTimedSignalIfPluginActive(
+    OrganizerProxy* proxy, const Signal& signal, const char* event,
+    T defaultReturn = T{})
+  {
+    return callTimedIfPluginActive(proxy, [&signal](auto&&... args) {
+      return signal(std::forward<decltype(args)>(args)...);
+    }, event, defaultReturn);
+  }
+
+  // same as callSignalAlways(), but the handlers are timed, see
+  // PluginCallTimer
+  template <class Signal>
+  auto callTimedSignalAlways(
+    OrganizerProxy* proxy, const Signal& signal, const char* event)
+  {
+    return [&signal, proxy, event](auto&&... args) {
+      PluginCallTimer t(proxy->plugin(), event);
+      return signal(std::forward<decltype(args)>(args)...);
+    };
+  }
+
   template <class Signal, class T = int>
   auto callSignalAlways(const Signal& signal) {
     return [&signal](auto&&... args) {
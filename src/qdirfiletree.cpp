@@ -1,4 +1,5 @@
 #include "qdirfiletree.h"
+#include "envfs.h"
 
 #include <QDirIterator>
 
@@ -14,6 +15,15 @@ public:
   QDirFileTreeImpl(std::shared_ptr<const IFileTree> parent, QDir dir) :
     FileTreeEntry(parent, dir.dirName()), QDirFileTree(), qDir(dir) { }
 
+  /**
+   * A directory of a tree that was already walked, so it doesn't need the disk.
+   */
+  QDirFileTreeImpl(
+    std::shared_ptr<const IFileTree> parent, QDir dir,
+    std::shared_ptr<const env::Directory> root, const env::Directory* directory) :
+      FileTreeEntry(parent, dir.dirName()), QDirFileTree(), qDir(dir),
+      m_Root(std::move(root)), m_Directory(directory) { }
+
 protected:
 
   /**
@@ -26,27 +36,43 @@ protected:
   std::shared_ptr<IFileTree> makeDirectory(std::shared_ptr<const IFileTree> parent, QString name) const override { return nullptr; }
 
   bool doPopulate(std::shared_ptr<const IFileTree> parent, std::vector<std::shared_ptr<FileTreeEntry>>& entries) const override {
-    auto infoList = qDir.entryInfoList(qDir.filter() | QDir::NoDotAndDotDot, QDir::Name | QDir::DirsFirst | QDir::IgnoreCase);
-    for (auto& info : infoList) {
-      if (info.isDir()) {
-        entries.push_back(std::make_shared<QDirFileTreeImpl>(parent, QDir(info.absoluteFilePath())));
-      }
-      else {
-        entries.push_back(createFileEntry(parent, info.fileName()));
-      }
+    if (!m_Directory) {
+      // the whole directory is walked once, which is much faster than listing
+      // each subdirectory with QDir; the subtrees are still only created when
+      // they're accessed
+      auto root = std::make_shared<env::Directory>(env::getFilesAndDirs(
+        QDir::toNativeSeparators(qDir.absolutePath()).toStdWString()));
+
+      m_Directory = root.get();
+      m_Root = std::move(root);
     }
 
-    // Vector is already sorted:
-    return true;
+    for (const auto& d : m_Directory->dirs) {
+      const QString name = QString::fromStdWString(d.name);
+      entries.push_back(std::make_shared<QDirFileTreeImpl>(
+        parent, QDir(qDir.absoluteFilePath(name)), m_Root, &d));
+    }
+
+    for (const auto& f : m_Directory->files) {
+      entries.push_back(createFileEntry(parent, QString::fromStdWString(f.name)));
+    }
+
+    // Let the parent class sort the entries:
+    return false;
   }
 
   std::shared_ptr<IFileTree> QDirFileTree::doClone() const {
-    return std::make_shared<QDirFileTreeImpl>(nullptr, qDir);
+    return std::make_shared<QDirFileTreeImpl>(nullptr, qDir, m_Root, m_Directory);
   }
 
 private:
   QDir qDir;
 
+  // the walked directory and the entry for this tree in it, set on the first
+  // populate
+  mutable std::shared_ptr<const env::Directory> m_Root;
+  mutable const env::Directory* m_Directory = nullptr;
+
 };
 
 /**
@@ -28,8 +28,9 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 /**
  * @brief Class that expose a directory on the drive, using QDir, as a `MOBase::IFileTree`.
  *
- * The tree is lazily populated: each subtree is only populated (from the disk) when needed,
- * as specified by IFileTree.
+ * The tree is lazily populated: each subtree is only populated when needed, as specified
+ * by IFileTree. The directory is walked on the disk once, the first time the root is
+ * populated, and the subtrees are created from that walk.
  *
  * This class does not expose mutable operations, so any mutable operations will
  * fail.
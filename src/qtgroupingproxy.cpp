@@ -23,6 +23,7 @@
 #include <QDebug>
 #include <QIcon>
 #include <QInputDialog>
+#include <algorithm>
 
 using namespace MOBase;
 
@@ -69,9 +70,10 @@ void QtGroupingProxy::setSourceModel(QAbstractItemModel* model)
       SLOT(modelRowsRemoved(const QModelIndex&, int, int)));
     connect(sourceModel(), SIGNAL(rowsAboutToBeRemoved(const QModelIndex&, int, int)),
       SLOT(modelRowsAboutToBeRemoved(QModelIndex, int, int)));
-    connect(sourceModel(), SIGNAL(layoutChanged()), SLOT(buildTree()));
-    connect(sourceModel(), SIGNAL(dataChanged(QModelIndex, QModelIndex)),
-      SLOT(modelDataChanged(QModelIndex, QModelIndex)));
+    connect(sourceModel(), SIGNAL(layoutAboutToBeChanged()), SLOT(modelLayoutAboutToBeChanged()));
+    connect(sourceModel(), SIGNAL(layoutChanged()), SLOT(modelLayoutChanged()));
+    connect(sourceModel(), &QAbstractItemModel::dataChanged,
+      this, &QtGroupingProxy::modelDataChanged);
     connect(sourceModel(), SIGNAL(modelReset()), this, SLOT(resetModel()));
 
     buildTree();
@@ -166,8 +168,15 @@ QtGroupingProxy::buildTree()
   if( !sourceModel() )
     return;
   beginResetModel();
+  buildGroups();
+  endResetModel();
+}
 
+void
+QtGroupingProxy::buildGroups()
+{
   m_groupHash.clear();
+  m_rowGroupKeys.clear();
   //don't clear the data maps since most of it will probably be needed again.
   m_parentCreateList.clear();
 
@@ -211,8 +220,127 @@ QtGroupingProxy::buildTree()
       m_groupMaps.removeAt(*iter);
     }
   }
+}
 
-  endResetModel();
+void
+QtGroupingProxy::beginRelayout()
+{
+  emit layoutAboutToBeChanged();
+
+  m_layoutIndexes = persistentIndexList();
+  m_layoutItems.clear();
+
+  foreach( const QModelIndex &idx, m_layoutIndexes )
+  {
+    LayoutItem item;
+    item.isGroup = isGroup( idx );
+    item.column = idx.column();
+
+    if( item.isGroup )
+    {
+      item.group = m_groupMaps[idx.row()][0].value( Qt::DisplayRole );
+    }
+    else
+    {
+      item.source = mapToSource( idx );
+
+      const QModelIndex parent = idx.parent();
+      if( parent.isValid() && isGroup( parent ) )
+        item.group = m_groupMaps[parent.row()][0].value( Qt::DisplayRole );
+    }
+
+    m_layoutItems << item;
+  }
+
+  m_relayout = true;
+}
+
+void
+QtGroupingProxy::endRelayout()
+{
+  if( !m_relayout )
+  {
+    //the source changed without telling beforehand, nothing can be kept
+    buildTree();
+    return;
+  }
+
+  m_relayout = false;
+  buildGroups();
+
+  QModelIndexList newIndexes;
+
+  foreach( const LayoutItem &item, m_layoutItems )
+  {
+    if( item.isGroup )
+    {
+      const int row = groupRow( item.group );
+      newIndexes << (row == -1 ? QModelIndex() : index( row, item.column ));
+      continue;
+    }
+
+    if( !item.source.isValid() )
+    {
+      newIndexes << QModelIndex();
+      continue;
+    }
+
+    //try to keep the item in the same group first, it may be in others too
+    if( item.group.isValid() && item.source.parent() == m_rootNode )
+    {
+      const int row = groupRow( item.group );
+      if( row != -1 )
+      {
+        const int childRow = m_groupHash.value( row ).indexOf( item.source.row() );
+        if( childRow != -1 )
+        {
+          newIndexes << index( childRow, item.column, index( row, 0 ) );
+          continue;
+        }
+      }
+    }
+
+    newIndexes << mapFromSource( item.source );
+  }
+
+  changePersistentIndexList( m_layoutIndexes, newIndexes );
+
+  m_layoutIndexes.clear();
+  m_layoutItems.clear();
+
+  emit layoutChanged();
+}
+
+void
+QtGroupingProxy::relayout()
+{
+  beginRelayout();
+  endRelayout();
+}
+
+int
+QtGroupingProxy::groupRow( const QVariant &name ) const
+{
+  for( int i = 0; i < m_groupMaps.count(); ++i )
+  {
+    if( m_groupMaps[i][0].value( Qt::DisplayRole ) == name )
+      return i;
+  }
+
+  return -1;
+}
+
+QVariantList
+QtGroupingProxy::groupKeys( const QList<RowData> &groupData )
+{
+  QVariantList keys;
+
+  foreach( const RowData &data, groupData )
+  {
+    keys << data[0][Qt::DisplayRole];
+  }
+
+  return keys;
 }
 
 QList<int>
@@ -221,6 +349,8 @@ QtGroupingProxy::addSourceRow( const QModelIndex &idx )
   QList<int> updatedGroups;
   QList<RowData> groupData = belongsTo( idx );
 
+  m_rowGroupKeys.insert( idx.row(), groupKeys( groupData ) );
+
   //an empty list here means it's supposed to go in root.
   if( groupData.isEmpty() )
   {
@@ -861,7 +991,12 @@ QtGroupingProxy::dropMimeData(const QMimeData *data, Qt::DropAction action, int
 void
 QtGroupingProxy::modelRowsAboutToBeInserted( const QModelIndex &parent, int start, int end )
 {
-  if( parent != m_rootNode )
+  if( parent == m_rootNode )
+  {
+    //the new rows can go in any group, they're placed in endRelayout()
+    beginRelayout();
+  }
+  else
   {
     //an item will be added to an original index, remap and pass it on
     QModelIndex proxyParent = mapFromSource( parent );
@@ -875,10 +1010,7 @@ QtGroupingProxy::modelRowsInserted( const QModelIndex &parent, int start, int en
   if( parent == m_rootNode )
   {
     //top level of the model changed, these new rows need to be put in groups
-    for( int modelRow = start; modelRow <= end ; modelRow++ )
-    {
-      addSourceRow( sourceModel()->index( modelRow, m_groupedColumn, m_rootNode ) );
-    }
+    endRelayout();
   }
   else
   {
@@ -971,6 +1103,12 @@ QtGroupingProxy::modelRowsRemoved( const QModelIndex &parent, int start, int end
       }
     }
 
+    for( int i = end; i >= start; i-- )
+    {
+      if( i < m_rowGroupKeys.count() )
+        m_rowGroupKeys.removeAt( i );
+    }
+
     return;
   }
 
@@ -985,21 +1123,84 @@ QtGroupingProxy::resetModel()
 }
 
 void
-QtGroupingProxy::modelDataChanged( const QModelIndex &topLeft, const QModelIndex &bottomRight )
+QtGroupingProxy::modelLayoutAboutToBeChanged()
 {
-  //TODO: need to look in the groupedColumn and see if it changed and changed grouping accordingly
-  QModelIndex proxyTopLeft = mapFromSource( topLeft );
-  if( !proxyTopLeft.isValid() )
+  beginRelayout();
+}
+
+void
+QtGroupingProxy::modelLayoutChanged()
+{
+  endRelayout();
+}
+
+void
+QtGroupingProxy::modelDataChanged( const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                                   const QVector<int> &roles )
+{
+  if( !topLeft.isValid() || !bottomRight.isValid() )
     return;
 
-  if( topLeft == bottomRight )
+  if( topLeft.parent() != m_rootNode )
   {
-    emit dataChanged( proxyTopLeft, proxyTopLeft );
+    //children of an original item, they have the same parent in the proxy
+    QModelIndex proxyTopLeft = mapFromSource( topLeft );
+    if( !proxyTopLeft.isValid() )
+      return;
+
+    emit dataChanged( proxyTopLeft, mapFromSource( bottomRight ), roles );
+    return;
   }
-  else
+
+  const int first = topLeft.row();
+  const int last = bottomRight.row();
+
+  //rows can only move to other groups when the grouped column changed
+  const bool groupedColumnChanged =
+    ( m_groupedColumn >= topLeft.column() && m_groupedColumn <= bottomRight.column() );
+
+  //rows that are now in other groups have to be moved, which is done for all of them at once
+  for( int row = first; groupedColumnChanged && row <= last; row++ )
+  {
+    const QModelIndex idx = sourceModel()->index( row, m_groupedColumn, m_rootNode );
+    if( groupKeys( belongsTo( idx ) ) != m_rowGroupKeys.value( row ) )
+    {
+      relayout();
+      return;
+    }
+  }
+
+  //rows are kept in order in each group, so changed rows are contiguous in the group
+  const quint32 ungrouped = std::numeric_limits<quint32>::max();
+
+  for( auto iter = m_groupHash.constBegin(); iter != m_groupHash.constEnd(); ++iter )
   {
-    QModelIndex proxyBottomRight = mapFromSource( bottomRight );
-    emit dataChanged( proxyTopLeft, proxyBottomRight );
+    const QList<int> &groupList = iter.value();
+    auto begin = std::lower_bound( groupList.begin(), groupList.end(), first );
+    auto end = std::upper_bound( begin, groupList.end(), last );
+    if( begin == end )
+      continue;
+
+    int from = static_cast<int>( begin - groupList.begin() );
+    int to = static_cast<int>( end - groupList.begin() ) - 1;
+
+    QModelIndex proxyParent;
+    if( iter.key() == ungrouped )
+    {
+      //non-grouped items are below the groups
+      from += m_groupMaps.count();
+      to += m_groupMaps.count();
+    }
+    else
+    {
+      //the group shows data aggregated from its children, in the same columns
+      proxyParent = index( iter.key(), 0 );
+      emit dataChanged( index( iter.key(), topLeft.column() ),
+                        index( iter.key(), bottomRight.column() ), roles );
+    }
+
+    emit dataChanged( index( from, topLeft.column(), proxyParent ),
+                      index( to, bottomRight.column(), proxyParent ), roles );
   }
 }
 
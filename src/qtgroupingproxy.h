@@ -25,6 +25,7 @@
 #include <QStringList>
 #include <QIcon>
 #include <QSet>
+#include <QPersistentModelIndex>
 
 typedef QMap<int, QVariant> ItemData;
 typedef QMap<int, ItemData> RowData;
@@ -84,11 +85,14 @@ protected slots:
   virtual void buildTree();
 
 private slots:
-  void modelDataChanged( const QModelIndex &, const QModelIndex & );
+  void modelDataChanged( const QModelIndex &, const QModelIndex &,
+                         const QVector<int> &roles = QVector<int>() );
   void modelRowsAboutToBeInserted( const QModelIndex &, int ,int );
   void modelRowsInserted( const QModelIndex &, int, int );
   void modelRowsAboutToBeRemoved( const QModelIndex &, int ,int );
   void modelRowsRemoved( const QModelIndex &, int, int );
+  void modelLayoutAboutToBeChanged();
+  void modelLayoutChanged();
   void resetModel();
 
 protected:
@@ -148,6 +152,43 @@ private:
 
   int m_aggregateRole;
 
+  /** The groups each top level source row was put in by belongsTo(), by source row.
+          * This is used to detect when a change in the source moves a row to other groups.
+          */
+  QList<QVariantList> m_rowGroupKeys;
+
+  /** Where a persistent index was before the groups are rebuilt.
+          * Groups are remembered by name since their rows can change, items by their source index
+          * and the name of the group they were in, since a source row can be in multiple groups.
+          */
+  struct LayoutItem
+  {
+    bool isGroup;
+    QVariant group;
+    QPersistentModelIndex source;
+    int column;
+  };
+  QModelIndexList m_layoutIndexes;
+  QList<LayoutItem> m_layoutItems;
+  bool m_relayout = false;
+
+  /** Rebuilds m_groupHash from the source model without resetting the model */
+  void buildGroups();
+
+  /** Regroups the source rows as a layout change instead of a reset.
+          * Persistent indexes are moved to their new positions, so the expanded state of groups
+          * and the selection in the views is kept.
+          * beginRelayout() must be called before the source changes, endRelayout() after.
+          */
+  void beginRelayout();
+  void endRelayout();
+  void relayout();
+
+  /** @returns the row of the group with the given name, -1 if there's none */
+  int groupRow( const QVariant &name ) const;
+
+  /** @returns the names of the groups in the given data returned by belongsTo() */
+  static QVariantList groupKeys( const QList<RowData> &groupData );
 };
 
 #endif //GROUPINGPROXY_H
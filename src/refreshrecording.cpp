@@ -0,0 +1,487 @@
+#include "refreshrecording.h"
+#include "metrics.h"
+#include "organizercore.h"
+#include "directoryrefresher.h"
+#include "modinfo.h"
+#include "profile.h"
+#include "shared/directoryentry.h"
+#include "shared/fileregister.h"
+#include <iplugingame.h>
+#include <gameplugins.h>
+#include <log.h>
+#include <utility.h>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <thread>
+
+using namespace MOBase;
+using namespace MOShared;
+
+// "MORR", little endian
+static const quint32 RecordingMagic = 0x52524F4D;
+
+// must be incremented every time the format changes
+static const quint32 RecordingVersion = 1;
+
+
+template <class F>
+static std::chrono::nanoseconds timed(F&& f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::steady_clock::now() - start;
+}
+
+// calls f(i) for every i in [0, count) on the given number of threads
+//
+template <class F>
+static void parallelFor(int threads, std::size_t count, F&& f)
+{
+  std::atomic<std::size_t> next = 0;
+  std::vector<std::thread> v;
+
+  for (int t=0; t<threads; ++t) {
+    v.emplace_back([&] {
+      for (;;) {
+        const std::size_t i = next++;
+        if (i >= count) {
+          break;
+        }
+
+        f(i);
+      }
+    });
+  }
+
+  for (auto& t : v) {
+    t.join();
+  }
+}
+
+
+static void writeTime(QDataStream& s, const FILETIME& ft)
+{
+  s << static_cast<quint32>(ft.dwLowDateTime)
+    << static_cast<quint32>(ft.dwHighDateTime);
+}
+
+static FILETIME readTime(QDataStream& s)
+{
+  quint32 low = 0, high = 0;
+  s >> low >> high;
+
+  return {low, high};
+}
+
+static void writeString(QDataStream& s, const std::wstring& str)
+{
+  s << QString::fromStdWString(str);
+}
+
+static std::wstring readString(QDataStream& s)
+{
+  QString str;
+  s >> str;
+
+  return str.toStdWString();
+}
+
+static void writeTree(QDataStream& s, const env::Directory& d)
+{
+  writeString(s, d.name);
+
+  s << static_cast<quint32>(d.files.size());
+  for (const auto& f : d.files) {
+    writeString(s, f.name);
+    writeTime(s, f.lastModified);
+    s << static_cast<quint64>(f.size);
+  }
+
+  s << static_cast<quint32>(d.dirs.size());
+  for (const auto& sd : d.dirs) {
+    writeTree(s, sd);
+  }
+}
+
+static void readTree(QDataStream& s, env::Directory& d)
+{
+  d = env::Directory(readString(s));
+
+  quint32 count = 0;
+
+  s >> count;
+  for (quint32 i=0; i<count && s.status() == QDataStream::Ok; ++i) {
+    const auto name = readString(s);
+    const auto time = readTime(s);
+
+    quint64 size = 0;
+    s >> size;
+
+    d.files.emplace_back(name, time, size);
+  }
+
+  s >> count;
+  for (quint32 i=0; i<count && s.status() == QDataStream::Ok; ++i) {
+    d.dirs.emplace_back();
+    readTree(s, d.dirs.back());
+  }
+}
+
+static void writeFolder(QDataStream& s, const ArchiveIndex::Folder& f)
+{
+  writeString(s, f.name);
+
+  s << static_cast<quint32>(f.files.size());
+  for (const auto& file : f.files) {
+    writeString(s, file.name);
+    s << static_cast<quint64>(file.size)
+      << static_cast<quint64>(file.uncompressedSize);
+  }
+
+  s << static_cast<quint32>(f.folders.size());
+  for (const auto& sf : f.folders) {
+    writeFolder(s, sf);
+  }
+}
+
+static void readFolder(QDataStream& s, ArchiveIndex::Folder& f)
+{
+  f.name = readString(s);
+
+  quint32 count = 0;
+
+  s >> count;
+  for (quint32 i=0; i<count && s.status() == QDataStream::Ok; ++i) {
+    ArchiveIndex::File file;
+    file.name = readString(s);
+
+    quint64 size = 0, uncompressed = 0;
+    s >> size >> uncompressed;
+
+    file.size = size;
+    file.uncompressedSize = uncompressed;
+
+    f.files.push_back(std::move(file));
+  }
+
+  s >> count;
+  for (quint32 i=0; i<count && s.status() == QDataStream::Ok; ++i) {
+    f.folders.emplace_back();
+    readFolder(s, f.folders.back());
+  }
+}
+
+
+bool RefreshRecording::record(OrganizerCore& core, const QString& path)
+{
+  Metrics::Timer tt("RefreshRecording::record()");
+
+  const IPluginGame* game = core.managedGame();
+  Profile* profile = core.currentProfile();
+
+  if (!game || !profile) {
+    log::error("can't record a refresh, no instance is loaded");
+    return false;
+  }
+
+  RefreshRecording r;
+
+  r.m_dataPath = QDir::toNativeSeparators(game->dataDirectory().absolutePath());
+  r.m_origins.push_back({
+    "data", r.m_dataPath, 0, env::getFilesAndDirs(r.m_dataPath.toStdWString())});
+
+  std::set<QString> enabledArchives;
+  for (auto&& a : core.enabledArchives()) {
+    enabledArchives.insert(a);
+  }
+
+  std::vector<std::wstring> loadOrder;
+  if (const auto* gamePlugins = game->feature<GamePlugins>()) {
+    for (auto&& p : gamePlugins->getLoadOrder()) {
+      loadOrder.push_back(p.toStdWString());
+    }
+  }
+
+  auto mods = profile->getActiveMods();
+  std::sort(mods.begin(), mods.end(), [](auto&& a, auto&& b) {
+    return (std::get<2>(a) < std::get<2>(b));
+  });
+
+  for (const auto& [name, modPath, priority] : mods) {
+    Origin o;
+    o.name = name;
+    o.path = QDir::toNativeSeparators(modPath);
+    o.priority = priority;
+    o.tree = env::getFilesAndDirs(o.path.toStdWString());
+
+    ModInfo::Ptr info = ModInfo::getByIndex(ModInfo::getIndex(name));
+
+    for (const auto& archivePath : info->archives()) {
+      const auto filename = QFileInfo(archivePath).fileName();
+      if (!enabledArchives.contains(filename)) {
+        continue;
+      }
+
+      const auto index = ArchiveIndex::get(
+        QDir::toNativeSeparators(archivePath).toStdWString());
+
+      if (!index) {
+        continue;
+      }
+
+      o.archives.push_back({
+        filename,
+        DirectoryEntry::archiveOrder(filename.toStdWString(), loadOrder),
+        index->lastModified(), index->root()});
+    }
+
+    r.m_origins.push_back(std::move(o));
+  }
+
+  if (!r.write(path)) {
+    return false;
+  }
+
+  log::info(
+    "recorded the refresh of {} origins in {}",
+    r.m_origins.size(), QDir::toNativeSeparators(path));
+
+  return true;
+}
+
+bool RefreshRecording::write(const QString& path) const
+{
+  QByteArray data;
+
+  {
+    QDataStream s(&data, QIODevice::WriteOnly);
+    s.setVersion(QDataStream::Qt_5_15);
+
+    s << m_dataPath;
+    s << static_cast<quint32>(m_origins.size());
+
+    for (const auto& o : m_origins) {
+      s << o.name << o.path << static_cast<qint32>(o.priority);
+      writeTree(s, o.tree);
+
+      s << static_cast<quint32>(o.archives.size());
+      for (const auto& a : o.archives) {
+        s << a.name << static_cast<qint32>(a.order);
+        writeTime(s, a.lastModified);
+        writeFolder(s, a.root);
+      }
+    }
+  }
+
+  QFile f(path);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    log::error(
+      "failed to open {} for writing, {}",
+      QDir::toNativeSeparators(path), f.errorString());
+
+    return false;
+  }
+
+  // most names are repeated across mods, so this compresses well
+  QDataStream s(&f);
+  s.setVersion(QDataStream::Qt_5_15);
+  s << RecordingMagic << RecordingVersion << qCompress(data);
+
+  if (s.status() != QDataStream::Ok) {
+    log::error(
+      "failed to write recording to {}, {}",
+      QDir::toNativeSeparators(path), f.errorString());
+
+    return false;
+  }
+
+  return true;
+}
+
+std::optional<RefreshRecording> RefreshRecording::read(const QString& path)
+{
+  QFile f(path);
+  if (!f.open(QIODevice::ReadOnly)) {
+    log::error(
+      "failed to open recording {}, {}",
+      QDir::toNativeSeparators(path), f.errorString());
+
+    return {};
+  }
+
+  QByteArray data;
+
+  {
+    QDataStream s(&f);
+    s.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0, version = 0;
+    s >> magic >> version;
+
+    if (magic != RecordingMagic || version != RecordingVersion) {
+      log::error(
+        "{} is not a recording or was written by a different version",
+        QDir::toNativeSeparators(path));
+
+      return {};
+    }
+
+    QByteArray compressed;
+    s >> compressed;
+    data = qUncompress(compressed);
+  }
+
+  RefreshRecording r;
+
+  QDataStream s(data);
+  s.setVersion(QDataStream::Qt_5_15);
+
+  quint32 count = 0;
+  s >> r.m_dataPath >> count;
+
+  for (quint32 i=0; i<count && s.status() == QDataStream::Ok; ++i) {
+    Origin o;
+    qint32 priority = 0;
+
+    s >> o.name >> o.path >> priority;
+    o.priority = priority;
+
+    readTree(s, o.tree);
+
+    quint32 archives = 0;
+    s >> archives;
+
+    for (quint32 j=0; j<archives && s.status() == QDataStream::Ok; ++j) {
+      Archive a;
+      qint32 order = -1;
+
+      s >> a.name >> order;
+      a.order = order;
+      a.lastModified = readTime(s);
+      readFolder(s, a.root);
+
+      o.archives.push_back(std::move(a));
+    }
+
+    r.m_origins.push_back(std::move(o));
+  }
+
+  if (data.isEmpty() || s.status() != QDataStream::Ok) {
+    log::error("recording {} is corrupted", QDir::toNativeSeparators(path));
+    return {};
+  }
+
+  return r;
+}
+
+std::vector<RefreshRecording::Result> RefreshRecording::replay(
+  int threads, int runs) const
+{
+  std::vector<Result> results;
+
+  for (int r=0; r<runs; ++r) {
+    auto v = replayOnce(threads, r);
+    results.insert(results.end(), v.begin(), v.end());
+  }
+
+  return results;
+}
+
+std::vector<RefreshRecording::Result> RefreshRecording::replayOnce(
+  int threads, int run) const
+{
+  std::vector<Result> results;
+
+  auto add = [&](QString phase, std::int64_t count, std::chrono::nanoseconds t) {
+    results.push_back({std::move(phase), run, count, t});
+  };
+
+  auto root = std::make_unique<DirectoryEntry>(L"data", nullptr, 0);
+  auto fr = root->getFileRegister();
+
+  // addFromList() moves from the trees, they're copied before the timer is
+  // started
+  std::vector<env::Directory> trees;
+  for (const auto& o : m_origins) {
+    trees.push_back(o.tree);
+  }
+
+  add("loose", static_cast<std::int64_t>(m_origins.size()), timed([&] {
+    parallelFor(threads, m_origins.size(), [&](std::size_t i) {
+      const auto& o = m_origins[i];
+
+      DirectoryStats stats;
+      root->addFromList(
+        o.name.toStdWString(), o.path.toStdWString(), trees[i],
+        o.priority, stats);
+    });
+  }));
+
+  std::int64_t archives = 0;
+  for (const auto& o : m_origins) {
+    archives += static_cast<std::int64_t>(o.archives.size());
+  }
+
+  add("archives", archives, timed([&] {
+    parallelFor(threads, m_origins.size(), [&](std::size_t i) {
+      const auto& o = m_origins[i];
+
+      for (const auto& a : o.archives) {
+        DirectoryStats stats;
+        root->addFromArchive(
+          o.name.toStdWString(), o.path.toStdWString(), a.name.toStdWString(),
+          a.root, a.lastModified, o.priority, a.order, stats);
+      }
+    });
+  }));
+
+  const auto fileCount = static_cast<std::int64_t>(fr->highestCount());
+
+  add("sortOrigins", fileCount, timed([&] {
+    fr->sortOrigins();
+  }));
+
+  add("clean", fileCount, timed([&] {
+    DirectoryRefresher::cleanStructure(root.get());
+  }));
+
+  add("conflicts", fileCount, timed([&] {
+    DirectoryRefresher::rebuildConflicts(root.get());
+  }));
+
+  std::size_t mappings = 0;
+  add("fileMapping", 0, timed([&] {
+    mappings = OrganizerCore::fileMapping(
+      m_dataPath, "\\", root.get(), root.get(), InvalidOriginID).size();
+  }));
+  results.back().count = static_cast<std::int64_t>(mappings);
+
+  fr.reset();
+
+  add("teardown", fileCount, timed([&] {
+    root.reset();
+  }));
+
+  return results;
+}
+
+QString RefreshRecording::csvHeader()
+{
+  return "phase,run,threads,origins,count,ns";
+}
+
+QString RefreshRecording::toCsv(const Result& r, int threads) const
+{
+  return QString("%1,%2,%3,%4,%5,%6")
+    .arg(r.phase)
+    .arg(r.run)
+    .arg(threads)
+    .arg(m_origins.size())
+    .arg(r.count)
+    .arg(r.time.count());
+}
@@ -0,0 +1,88 @@
+#ifndef MODORGANIZER_REFRESHRECORDING_INCLUDED
+#define MODORGANIZER_REFRESHRECORDING_INCLUDED
+
+#include "envfs.h"
+#include "shared/archiveindex.h"
+#include <QString>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+class OrganizerCore;
+
+// what a refresh of the directory structure reads from the disk for the
+// current profile: the tree of the data directory and of each active mod,
+// with the sizes and times of the files, and the folders and files of their
+// enabled archives; file contents are never recorded
+//
+// recordings are written by the `record-refresh` command and replayed by
+// `replay-refresh`, which builds the structure from the recording without
+// touching the disk, so a slow refresh can be reproduced without the mods
+//
+class RefreshRecording
+{
+public:
+  struct Archive
+  {
+    QString name;
+
+    // position of the plugin that loads it in the load order, -1 if none
+    int order = -1;
+
+    FILETIME lastModified = {};
+    MOShared::ArchiveIndex::Folder root;
+  };
+
+  // the data directory or a mod
+  //
+  struct Origin
+  {
+    QString name;
+    QString path;
+    int priority = 0;
+    env::Directory tree;
+    std::vector<Archive> archives;
+  };
+
+  // one timed phase of a replay
+  //
+  struct Result
+  {
+    // loose, archives, sortOrigins, clean, conflicts, fileMapping or teardown
+    QString phase;
+    int run;
+
+    // number of items handled by the phase, to check that runs are comparable
+    std::int64_t count;
+
+    std::chrono::nanoseconds time;
+  };
+
+  // records the current profile of the given core to the given file; returns
+  // false on failure, which has been logged
+  //
+  static bool record(OrganizerCore& core, const QString& path);
+
+  // reads a recording, returns empty on failure, which has been logged
+  //
+  static std::optional<RefreshRecording> read(const QString& path);
+
+  // builds the structure from the recording `runs` times, adding the loose
+  // files and the archives of the origins on the given number of threads
+  //
+  std::vector<Result> replay(int threads, int runs) const;
+
+  static QString csvHeader();
+  QString toCsv(const Result& r, int threads) const;
+
+private:
+  QString m_dataPath;
+
+  // the data directory first, then the mods by priority
+  std::vector<Origin> m_origins;
+
+  bool write(const QString& path) const;
+  std::vector<Result> replayOnce(int threads, int run) const;
+};
+
+#endif // MODORGANIZER_REFRESHRECORDING_INCLUDED
@@ -0,0 +1,217 @@
+#include "refreshtrace.h"
+#include "shared/appconfig.h"
+#include "shared/fileregisterfwd.h"
+#include <log.h>
+#include <QApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <map>
+
+using namespace MOBase;
+
+struct RefreshTrace::Data
+{
+  std::mutex mutex;
+  bool active = false;
+  Clock::time_point start;
+  Report current;
+  std::optional<Report> last;
+};
+
+
+RefreshTrace::Scope::Scope(QString name, QString category)
+  : m_name(std::move(name)), m_category(std::move(category)),
+    m_active(RefreshTrace::active())
+{
+  if (m_active) {
+    m_start = Clock::now();
+  }
+}
+
+RefreshTrace::Scope::~Scope()
+{
+  if (m_active) {
+    addEvent({
+      std::move(m_name), std::move(m_category), m_start,
+      Clock::now() - m_start, currentThread()});
+  }
+}
+
+
+bool RefreshTrace::enabled()
+{
+  return MOShared::DirectoryStats::enabled();
+}
+
+void RefreshTrace::setEnabled(bool b)
+{
+  MOShared::DirectoryStats::setEnabled(b);
+
+  if (!b) {
+    std::scoped_lock lock(data().mutex);
+    data().active = false;
+    data().current = {};
+  }
+}
+
+void RefreshTrace::begin()
+{
+  if (!enabled()) {
+    return;
+  }
+
+  auto& d = data();
+  std::scoped_lock lock(d.mutex);
+
+  d.active = true;
+  d.start = Clock::now();
+  d.current = {};
+  d.current.time = QDateTime::currentDateTime();
+}
+
+bool RefreshTrace::active()
+{
+  auto& d = data();
+  std::scoped_lock lock(d.mutex);
+  return d.active;
+}
+
+void RefreshTrace::finish()
+{
+  Report r;
+
+  {
+    auto& d = data();
+    std::scoped_lock lock(d.mutex);
+
+    if (!d.active) {
+      return;
+    }
+
+    d.active = false;
+    d.current.total = Clock::now() - d.start;
+
+    r = std::move(d.current);
+    d.current = {};
+
+    d.last = r;
+  }
+
+  log::debug(
+    "refresh trace: {} events, {} mods, {}ms",
+    r.events.size(), r.mods.size(),
+    std::chrono::duration_cast<std::chrono::milliseconds>(r.total).count());
+
+  write(r);
+}
+
+void RefreshTrace::addEvent(Event e)
+{
+  auto& d = data();
+  std::scoped_lock lock(d.mutex);
+
+  if (d.active) {
+    d.current.events.push_back(std::move(e));
+  }
+}
+
+void RefreshTrace::addMod(Mod m)
+{
+  auto& d = data();
+  std::scoped_lock lock(d.mutex);
+
+  if (d.active) {
+    d.current.mods.push_back(std::move(m));
+  }
+}
+
+std::optional<RefreshTrace::Report> RefreshTrace::lastReport()
+{
+  auto& d = data();
+  std::scoped_lock lock(d.mutex);
+  return d.last;
+}
+
+QString RefreshTrace::traceFilename()
+{
+  return
+    qApp->property("dataPath").toString() + "/" +
+    QString::fromStdWString(AppConfig::logPath()) + "/refresh_trace.json";
+}
+
+std::uint32_t RefreshTrace::currentThread()
+{
+  return static_cast<std::uint32_t>(::GetCurrentThreadId());
+}
+
+RefreshTrace::Data& RefreshTrace::data()
+{
+  static Data d;
+  return d;
+}
+
+void RefreshTrace::write(const Report& r)
+{
+  using namespace std::chrono;
+
+  auto us = [](nanoseconds ns) {
+    return static_cast<double>(duration_cast<microseconds>(ns).count());
+  };
+
+  std::map<QString, const Mod*> mods;
+  for (const auto& m : r.mods) {
+    mods.emplace(m.name, &m);
+  }
+
+  // events are relative to the first one so the trace starts at 0
+  Clock::time_point origin = Clock::time_point::max();
+  for (const auto& e : r.events) {
+    origin = std::min(origin, e.start);
+  }
+
+  QJsonArray events;
+
+  for (const auto& e : r.events) {
+    QJsonObject o;
+
+    o["name"] = e.name;
+    o["cat"] = e.category;
+    o["ph"] = "X";
+    o["ts"] = us(e.start - origin);
+    o["dur"] = us(e.duration);
+    o["pid"] = 1;
+    o["tid"] = static_cast<qint64>(e.thread);
+
+    // events for a mod have its totals
+    auto itor = mods.find(e.name);
+    const bool isMod = (e.category == "walk" || e.category == "archives");
+
+    if (isMod && itor != mods.end()) {
+      const Mod& m = *itor->second;
+
+      QJsonObject args;
+      args["files"] = static_cast<qint64>(m.files);
+      args["directories"] = static_cast<qint64>(m.directories);
+      args["lockWaitUs"] = us(m.lockWait);
+      o["args"] = args;
+    }
+
+    events.append(o);
+  }
+
+  QJsonObject root;
+  root["traceEvents"] = events;
+  root["displayTimeUnit"] = "ms";
+
+  QFile f(traceFilename());
+
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    log::error(
+      "can't write refresh trace to '{}', {}", f.fileName(), f.errorString());
+    return;
+  }
+
+  f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+}
@@ -0,0 +1,124 @@
+#ifndef MODORGANIZER_REFRESHTRACE_INCLUDED
+#define MODORGANIZER_REFRESHTRACE_INCLUDED
+
+#include <QDateTime>
+#include <QString>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// collects the timings of a refresh when refresh instrumentation is enabled in
+// the diagnostics settings: the directory structure, each mod's loose files
+// and archives, and the plugin and archive lists that are refreshed after it
+//
+// a trace is started with begin() and ended with finish(), which writes it in
+// the chrome trace-event format to the logs directory (it can be opened in
+// chrome://tracing or ui.perfetto.dev) and keeps it so it can be shown in the
+// diagnostics settings
+//
+// everything here is thread-safe
+//
+class RefreshTrace
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // one timed phase of the refresh
+  //
+  struct Event
+  {
+    QString name;
+    QString category;
+    Clock::time_point start;
+    std::chrono::nanoseconds duration;
+    std::uint32_t thread;
+  };
+
+  // totals for one mod
+  //
+  struct Mod
+  {
+    QString name;
+    std::chrono::nanoseconds walk{0};
+    std::chrono::nanoseconds archives{0};
+    std::chrono::nanoseconds lockWait{0};
+    std::int64_t files = 0;
+    std::int64_t directories = 0;
+  };
+
+  // a finished trace
+  //
+  struct Report
+  {
+    QDateTime time;
+    std::chrono::nanoseconds total{0};
+    std::vector<Event> events;
+    std::vector<Mod> mods;
+  };
+
+  // records the lifetime of this object as an event, does nothing when no
+  // trace is active
+  //
+  class Scope
+  {
+  public:
+    Scope(QString name, QString category="refresh");
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    QString m_name;
+    QString m_category;
+    Clock::time_point m_start;
+    bool m_active;
+  };
+
+  // whether refresh instrumentation is enabled; this also enables the
+  // per-phase timings in MOShared::DirectoryStats
+  //
+  static bool enabled();
+  static void setEnabled(bool b);
+
+  // starts a new trace if instrumentation is enabled, discarding the events
+  // of a trace that was never finished
+  //
+  static void begin();
+
+  // whether begin() was called and finish() wasn't
+  //
+  static bool active();
+
+  // ends the current trace, writes it to traceFilename() and keeps it as the
+  // last report; does nothing if no trace is active
+  //
+  static void finish();
+
+  // adds an event or the totals for a mod to the current trace, ignored if no
+  // trace is active
+  //
+  static void addEvent(Event e);
+  static void addMod(Mod m);
+
+  // the last finished trace, if any
+  //
+  static std::optional<Report> lastReport();
+
+  // path of the file written by finish()
+  //
+  static QString traceFilename();
+
+  // id of the calling thread, used for events
+  //
+  static std::uint32_t currentThread();
+
+private:
+  struct Data;
+  static Data& data();
+
+  static void write(const Report& r);
+};
+
+#endif // MODORGANIZER_REFRESHTRACE_INCLUDED
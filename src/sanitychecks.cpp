@@ -5,12 +5,70 @@
 #include <iplugingame.h>
 #include <log.h>
 #include <utility.h>
+#include <mutex>
 
 namespace sanity
 {
 
 using namespace MOBase;
 
+struct ProblemList
+{
+  std::mutex mutex;
+  std::vector<Problem> list;
+  std::function<void ()> changed;
+};
+
+ProblemList& problemList()
+{
+  static ProblemList p;
+  return p;
+}
+
+// remembers a problem so it's shown in the problems dialog; the problem is
+// also logged by the caller, duplicates are ignored because modules loaded
+// while the checks are running can be checked twice
+//
+void addProblem(QString shortDescription, QString fullDescription)
+{
+  auto& p = problemList();
+  std::scoped_lock lock(p.mutex);
+
+  for (auto&& e : p.list) {
+    if (e.shortDescription == shortDescription &&
+        e.fullDescription == fullDescription) {
+      return;
+    }
+  }
+
+  p.list.push_back({std::move(shortDescription), std::move(fullDescription)});
+
+  if (p.changed) {
+    p.changed();
+  }
+}
+
+std::vector<Problem> problems()
+{
+  auto& p = problemList();
+  std::scoped_lock lock(p.mutex);
+  return p.list;
+}
+
+void clearProblems()
+{
+  auto& p = problemList();
+  std::scoped_lock lock(p.mutex);
+  p.list.clear();
+}
+
+void setProblemsChanged(std::function<void ()> f)
+{
+  auto& p = problemList();
+  std::scoped_lock lock(p.mutex);
+  p.changed = std::move(f);
+}
+
 enum class SecurityZone
 {
   NoZone = -1,
@@ -119,6 +177,15 @@ bool isFileBlocked(const QFileInfo& fi)
     .arg(path)
     .arg(toString(z)));
 
+  addProblem(
+    QObject::tr("A file of Mod Organizer is blocked by Windows"),
+    QObject::tr(
+      "'%1' is blocked (%2). Windows blocks files downloaded from the "
+      "internet, which can prevent Mod Organizer from running properly. "
+      "Unblock it from the properties of the file.")
+      .arg(QDir::toNativeSeparators(path).toHtmlEscaped())
+      .arg(toString(z)));
+
   return true;
 }
 
@@ -207,9 +274,15 @@ int checkMissingFiles()
     const QFileInfo file(dir + "/" + name);
 
     if (!file.exists()) {
-      log::warn("{}", QObject::tr(
+      const auto text = QObject::tr(
         "'%1' seems to be missing, an antivirus may have deleted it")
-        .arg(file.absoluteFilePath()));
+        .arg(file.absoluteFilePath());
+
+      log::warn("{}", text);
+
+      addProblem(
+        QObject::tr("A file of Mod Organizer is missing"),
+        text.toHtmlEscaped());
 
       ++n;
     }
@@ -260,13 +333,25 @@ int checkBadOSDs(const env::Module& m)
     const auto filename = file.fileName().toStdString();
 
     if (std::regex_match(filename, m, p.first)) {
+      const auto name = QString::fromStdString(p.second);
+
       log::warn("{}", QObject::tr(
         "%1 is loaded.\nThis program is known to cause issues with "
         "Mod Organizer, such as freezing or blank windows. Consider "
         "uninstalling it.")
-        .arg(QString::fromStdString(p.second)));
+        .arg(name));
 
       log::warn("{}", file.absoluteFilePath());
+
+      addProblem(
+        QObject::tr("%1 is loaded").arg(name),
+        QObject::tr(
+          "%1 is loaded (%2). This program is known to cause issues with "
+          "Mod Organizer, such as freezing or blank windows. Consider "
+          "uninstalling it.")
+          .arg(name.toHtmlEscaped())
+          .arg(QDir::toNativeSeparators(file.absoluteFilePath()).toHtmlEscaped()));
+
       ++n;
     }
   }
@@ -296,6 +381,15 @@ int checkUsvfsIncompatibilites(const env::Module& m)
 
       log::warn("{}", file.absoluteFilePath());
 
+      addProblem(
+        QObject::tr("%1 is loaded").arg(p.second),
+        QObject::tr(
+          "%1 is loaded (%2). This program is known to cause issues with "
+          "Mod Organizer and its virtual filesystem, such script extenders "
+          "or others programs refusing to run. Consider uninstalling it.")
+          .arg(p.second.toHtmlEscaped())
+          .arg(QDir::toNativeSeparators(file.absoluteFilePath()).toHtmlEscaped()));
+
       ++n;
     }
   }
@@ -373,6 +467,15 @@ int checkProtected(const QDir& d, const QString& what)
 
       log::debug("path '{}' starts with '{}'", path, sd.first);
 
+      addProblem(
+        QObject::tr("A directory is in a special system folder"),
+        QObject::tr(
+          "%1 is %2 (%3); this may cause issues because it's a special "
+          "system folder.")
+          .arg(what.toHtmlEscaped())
+          .arg(sd.second.toHtmlEscaped())
+          .arg(path.toHtmlEscaped()));
+
       return 1;
     }
   }
@@ -1,6 +1,10 @@
 #ifndef MODORGANIZER_SANITYCHECKS_INCLUDED
 #define MODORGANIZER_SANITYCHECKS_INCLUDED
 
+#include <QString>
+#include <functional>
+#include <vector>
+
 namespace env
 {
   class Environment;
@@ -18,6 +22,32 @@ class Settings;
 namespace sanity
 {
 
+// a problem found by one of the checks, shown in the problems dialog by
+// OrganizerCore
+//
+struct Problem
+{
+  QString shortDescription;
+  QString fullDescription;
+};
+
+// the problems found since the last call to clearProblems(); the checks can
+// run on any thread, so this returns a copy
+//
+std::vector<Problem> problems();
+
+// forgets all the problems, called when MO restarts
+//
+void clearProblems();
+
+// `f` is called every time a new problem is found, on the thread that ran the
+// check; pass an empty function to remove it
+//
+void setProblemsChanged(std::function<void ()> f);
+
+// environment checks, these don't depend on the instance and can run on any
+// thread
+//
 void checkEnvironment(const env::Environment& env);
 int checkIncompatibleModule(const env::Module& m);
 int checkPaths(MOBase::IPluginGame& game, const Settings& s);
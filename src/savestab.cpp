@@ -1,15 +1,19 @@
 #include "savestab.h"
+#include "metrics.h"
 #include "ui_mainwindow.h"
 #include "organizercore.h"
+#include "pluginlist.h"
 #include "activatemodsdialog.h"
 #include <iplugingame.h>
 #include <isavegameinfowidget.h>
+#include <QDirIterator>
 
 using namespace MOBase;
 
 SavesTab::SavesTab(QWidget* window, OrganizerCore& core, Ui::MainWindow* mwui)
   : m_window(window), m_core(core), m_CurrentSaveView(nullptr), ui{
-      mwui->tabWidget, mwui->savesTab, mwui->savegameList}
+      mwui->tabWidget, mwui->savesTab, mwui->savegameList},
+    m_refreshAgain(false), m_listed(false)
 {
   m_SavesWatcherTimer.setSingleShot(true);
   m_SavesWatcherTimer.setInterval(500);
@@ -33,6 +37,18 @@ SavesTab::SavesTab(QWidget* window, OrganizerCore& core, Ui::MainWindow* mwui)
     ui.list, &QListWidget::itemEntered,
     [&](auto* item){ saveSelectionChanged(item); });
 
+  // missing assets depend on the plugins that are enabled and the mods that
+  // provide them
+  auto forgetAssets = [&]{ m_missingAssets.clear(); };
+  auto* plugins = m_core.pluginList();
+
+  connect(plugins, &QAbstractItemModel::dataChanged, forgetAssets);
+  connect(plugins, &QAbstractItemModel::modelReset, forgetAssets);
+  connect(plugins, &QAbstractItemModel::layoutChanged, forgetAssets);
+  connect(plugins, &QAbstractItemModel::rowsInserted, forgetAssets);
+  connect(plugins, &QAbstractItemModel::rowsRemoved, forgetAssets);
+  connect(&m_core, &OrganizerCore::directoryStructureReady, forgetAssets);
+
   ui.list->installEventFilter(this);
 }
 
@@ -124,11 +140,16 @@ void SavesTab::hideSaveGameInfo()
 
 void SavesTab::refreshSavesIfOpen()
 {
-  if (ui.mainTabs->currentWidget() == ui.tab) {
+  if (isOpen()) {
     refreshSaveList();
   }
 }
 
+bool SavesTab::isOpen() const
+{
+  return (ui.mainTabs->currentWidget() == ui.tab);
+}
+
 QDir SavesTab::currentSavesDir() const
 {
   QDir savesDir;
@@ -177,29 +198,225 @@ void SavesTab::stopMonitorSaves()
 
 void SavesTab::refreshSaveList()
 {
-  TimeThis tt("MainWindow::refreshSaveList()");
-
   startMonitorSaves(); // re-starts monitoring
 
-  try
-  {
-    QDir savesDir = currentSavesDir();
-    MOBase::log::debug("reading save games from {}", savesDir.absolutePath());
-    m_SaveGames = m_core.managedGame()->listSaves(savesDir);
-    std::sort(m_SaveGames.begin(), m_SaveGames.end(), [](auto const& lhs, auto const& rhs) {
-      return lhs->getCreationTime() > rhs->getCreationTime();
-    });
+  if (!isOpen()) {
+    // the tab refreshes the list when it's shown
+    return;
+  }
+
+  listSaves();
+}
+
+void SavesTab::warm()
+{
+  if (m_listed || m_listing) {
+    return;
+  }
+
+  listSaves();
+}
+
+void SavesTab::listSaves()
+{
+  m_listed = true;
+
+  if (m_listing && !m_listing->finished()) {
+    // onListed() refreshes again
+    m_refreshAgain = true;
+    return;
+  }
+
+  m_refreshAgain = false;
+
+  const QString profile = m_core.currentProfile()->name();
+  const QString dir = currentSavesDir().absolutePath();
+
+  auto& cached = m_cache[profile];
+  if (cached.dir != dir) {
+    cached = {dir, {}, {}};
+  }
+
+  // shows what's known for this profile until the saves have been listed,
+  // which can be stale when the saves were last listed while the tab was
+  // hidden
+  if (isOpen() && (m_shownProfile != profile || m_shownStamps != cached.stamps)) {
+    m_shownProfile = profile;
+    applySaves(QDir(dir), cached.saves, cached.stamps);
+  }
+
+  MOBase::log::debug("reading save games from {}", dir);
+
+  m_listing.reset(new MOShared::TaskGroup(MOShared::TaskPriority::Normal));
+
+  m_listing->run([this, profile, dir, known=cached.stamps, game=m_core.managedGame()] {
+    Metrics::Timer tt("SavesTab::refreshSaveList()");
+
+    auto post = [&](std::optional<FileStamps> stamps, std::optional<SaveList> saves) {
+      QMetaObject::invokeMethod(this, [=]() mutable {
+        onListed(profile, dir, std::move(stamps), std::move(saves));
+      }, Qt::QueuedConnection);
+    };
+
+    auto stamps = stampFiles(dir);
+
+    if (stamps == known) {
+      // nothing changed since the last time
+      post(std::move(stamps), {});
+      return;
+    }
+
+    try
+    {
+      auto saves = game->listSaves(QDir(dir));
+
+      std::sort(saves.begin(), saves.end(), [](auto const& lhs, auto const& rhs) {
+        const auto lt = lhs->getCreationTime();
+        const auto rt = rhs->getCreationTime();
+
+        // the path keeps the order stable, see applySaves()
+        if (lt == rt) {
+          return lhs->getFilepath() < rhs->getFilepath();
+        }
+
+        return lt > rt;
+      });
+
+      post(std::move(stamps), std::move(saves));
+    }
+    catch(std::exception& e)
+    {
+      // listSaves() can throw
+      log::error("{}", e.what());
+      post({}, {});
+    }
+  });
+}
+
+void SavesTab::onListed(
+  const QString& profile, const QString& dir,
+  std::optional<FileStamps> stamps, std::optional<SaveList> saves)
+{
+  // the task is done, this only waits for it to return
+  m_listing.reset();
+
+  if (stamps) {
+    auto& cached = m_cache[profile];
+
+    // the directory is different when the profile was changed while listing
+    if (cached.dir == dir) {
+      cached.stamps = std::move(*stamps);
+
+      if (saves) {
+        cached.saves = std::move(*saves);
 
+        if (profile == m_shownProfile && isOpen()) {
+          applySaves(QDir(dir), cached.saves, cached.stamps);
+        }
+      }
+    }
+  }
+
+  if (m_refreshAgain) {
+    refreshSaveList();
+  }
+}
+
+void SavesTab::applySaves(
+  const QDir& dir, const SaveList& saves, const FileStamps& stamps)
+{
+  std::set<QString> paths;
+  for (const auto& s : saves) {
+    paths.insert(stampKey(s->getFilepath()));
+  }
+
+  // removing saves that are gone or have changed, the ones that are left
+  // haven't changed and so are in the same order as in the new list
+  bool removed = false;
+
+  for (std::size_t i=m_SaveGames.size(); i-- > 0;) {
+    const auto key = stampKey(m_SaveGames[i]->getFilepath());
+
+    const auto oldItor = m_shownStamps.find(key);
+    const auto newItor = stamps.find(key);
+
+    const bool same =
+      paths.count(key) > 0 &&
+      oldItor != m_shownStamps.end() && newItor != stamps.end() &&
+      oldItor->second == newItor->second;
+
+    if (!same) {
+      delete ui.list->takeItem(static_cast<int>(i));
+      m_SaveGames.erase(m_SaveGames.begin() + i);
+      m_missingAssets.erase(key);
+      removed = true;
+    }
+  }
+
+  if (removed) {
+    // the widget may be showing a save that's gone
+    hideSaveGameInfo();
+  }
+
+  // inserting the new saves, the ones that are already in the list are kept
+  // since the info widget may be showing them
+  for (std::size_t i=0; i<saves.size(); ++i) {
+    if (i < m_SaveGames.size()) {
+      const auto current = stampKey(m_SaveGames[i]->getFilepath());
+      if (current == stampKey(saves[i]->getFilepath())) {
+        continue;
+      }
+    }
+
+    m_SaveGames.insert(m_SaveGames.begin() + i, saves[i]);
+
+    ui.list->insertItem(
+      static_cast<int>(i), dir.relativeFilePath(saves[i]->getFilepath()));
+  }
+
+  if (m_SaveGames.size() != saves.size()) {
+    // shouldn't happen, but the list must match m_SaveGames
+    log::error(
+      "save list is out of sync ({} items, {} saves), rebuilding it",
+      m_SaveGames.size(), saves.size());
+
+    hideSaveGameInfo();
     ui.list->clear();
+    m_missingAssets.clear();
+    m_SaveGames = saves;
+
     for (auto& save: m_SaveGames) {
-      ui.list->addItem(savesDir.relativeFilePath(save->getFilepath()));
+      ui.list->addItem(dir.relativeFilePath(save->getFilepath()));
     }
   }
-  catch(std::exception& e)
-  {
-    // listSaves() can throw
-    log::error("{}", e.what());
+
+  m_shownStamps = stamps;
+}
+
+SavesTab::FileStamps SavesTab::stampFiles(const QString& dir)
+{
+  FileStamps stamps;
+
+  QDirIterator itor(
+    dir, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot,
+    QDirIterator::Subdirectories);
+
+  while (itor.hasNext()) {
+    itor.next();
+
+    const auto fi = itor.fileInfo();
+
+    stamps.emplace(
+      stampKey(fi.absoluteFilePath()),
+      FileStamp{fi.size(), fi.lastModified().toMSecsSinceEpoch()});
   }
+
+  return stamps;
+}
+
+QString SavesTab::stampKey(const QString& path)
+{
+  return QDir::cleanPath(QDir::fromNativeSeparators(path)).toLower();
 }
 
 void SavesTab::deleteSavegame()
@@ -255,7 +472,7 @@ void SavesTab::onContextMenu(const QPoint& pos)
     action->setEnabled(false);
     if (selection->selectedIndexes().count() == 1) {
       auto& save = m_SaveGames[selection->selectedIndexes()[0].row()];
-      SaveGameInfo::MissingAssets missing = info->getMissingAssets(*save);
+      const SaveGameInfo::MissingAssets missing = missingAssets(*info, *save);
       if (missing.size() != 0) {
         connect(action, &QAction::triggered, this, [this, missing] { fixMods(missing); });
         action->setEnabled(true);
@@ -271,6 +488,19 @@ void SavesTab::onContextMenu(const QPoint& pos)
   menu.exec(ui.list->viewport()->mapToGlobal(pos));
 }
 
+const SaveGameInfo::MissingAssets& SavesTab::missingAssets(
+  const SaveGameInfo& info, const ISaveGame& save)
+{
+  const auto key = stampKey(save.getFilepath());
+
+  auto itor = m_missingAssets.find(key);
+  if (itor == m_missingAssets.end()) {
+    itor = m_missingAssets.emplace(key, info.getMissingAssets(save)).first;
+  }
+
+  return itor->second;
+}
+
 void SavesTab::fixMods(SaveGameInfo::MissingAssets const &missingAssets)
 {
   ActivateModsDialog dialog(missingAssets, m_window);
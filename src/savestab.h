@@ -2,6 +2,7 @@
 #define MODORGANIZER_SAVESTAB_INCLUDED
 
 #include "savegameinfo.h"
+#include "taskexecutor.h"
 #include <filterwidget.h>
 
 namespace Ui { class MainWindow; }
@@ -16,6 +17,18 @@ class MainWindow;
 class OrganizerCore;
 
 
+// lists the saves of the current profile
+//
+// saves are listed by the game plugin on a background task; the files in the
+// saves directory are stamped with their size and modification time along
+// with the saves, per profile, and the plugin is only asked again when a
+// stamp changes; changes are applied to the list by only adding and removing
+// the affected items
+//
+// the list is only updated while the tab is open, refreshes requested while
+// it's hidden are done when it's shown; warm() can fill the cache in the
+// background beforehand so showing the tab only has to check the stamps
+//
 class SavesTab : public QObject
 {
   Q_OBJECT;
@@ -23,7 +36,15 @@ class SavesTab : public QObject
 public:
   SavesTab(QWidget* window, OrganizerCore& core, Ui::MainWindow* ui);
 
+  // shows the cached saves for the current profile, if any, and lists them
+  // again in the background; only restarts monitoring when the tab is hidden
+  //
   void refreshSaveList();
+
+  // lists the saves of the current profile in the background without
+  // updating the list, once, if the tab hasn't been shown yet
+  //
+  void warm();
   void displaySaveGameInfo(QListWidgetItem *newItem);
 
   QDir currentSavesDir() const;
@@ -43,6 +64,31 @@ private:
     QListWidget* list;
   };
 
+  struct FileStamp
+  {
+    qint64 size = 0;
+    qint64 time = 0;
+
+    bool operator==(const FileStamp& other) const
+    {
+      return (size == other.size && time == other.time);
+    }
+  };
+
+  // lowercase paths of all the files in a saves directory
+  using FileStamps = std::map<QString, FileStamp>;
+
+  using SaveList = std::vector<std::shared_ptr<const MOBase::ISaveGame>>;
+
+  // saves of a profile along with the stamps of the files they were listed
+  // from
+  struct CachedSaves
+  {
+    QString dir;
+    FileStamps stamps;
+    SaveList saves;
+  };
+
   QWidget* m_window;
   OrganizerCore& m_core;
   SavesTabUi ui;
@@ -53,12 +99,64 @@ private:
   QTimer m_SavesWatcherTimer;
   QFileSystemWatcher m_SavesWatcher;
 
+  // stamps of the saves that are in the list
+  FileStamps m_shownStamps;
+
+  // profile of the saves in the list
+  QString m_shownProfile;
+
+  // saves by profile name
+  std::map<QString, CachedSaves> m_cache;
+
+  // set when a refresh is requested while listing, the list is refreshed
+  // again once it's done
+  bool m_refreshAgain;
+
+  // whether the saves have been listed at least once, by a refresh or by
+  // warm()
+  bool m_listed;
+
+  // missing assets of the saves, by stampKey(); cleared when plugins or mods
+  // change
+  std::map<QString, SaveGameInfo::MissingAssets> m_missingAssets;
+
+  // lists the saves
+  std::unique_ptr<MOShared::TaskGroup> m_listing;
+
   void onContextMenu(const QPoint &pos);
   void deleteSavegame();
   void saveSelectionChanged(QListWidgetItem *newItem);
   void fixMods(SaveGameInfo::MissingAssets const &missingAssets);
+
+  // missing assets of the given save, from the cache if they're known
+  //
+  const SaveGameInfo::MissingAssets& missingAssets(
+    const SaveGameInfo& info, const MOBase::ISaveGame& save);
   void refreshSavesIfOpen();
+  bool isOpen() const;
+
+  // lists the saves of the current profile in the background, the list is
+  // updated if the tab is open
+  //
+  void listSaves();
   void openInExplorer();
+
+  // called on the ui thread when the saves have been listed; `saves` is
+  // empty when the stamps haven't changed and `stamps` is empty when
+  // listing failed
+  //
+  void onListed(
+    const QString& profile, const QString& dir,
+    std::optional<FileStamps> stamps, std::optional<SaveList> saves);
+
+  // updates the list with the given saves, only items that have been
+  // removed or changed are replaced
+  //
+  void applySaves(
+    const QDir& dir, const SaveList& saves, const FileStamps& stamps);
+
+  static FileStamps stampFiles(const QString& dir);
+  static QString stampKey(const QString& path);
 };
 
 #endif // MODORGANIZER_SAVESTAB_INCLUDED
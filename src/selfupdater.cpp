@@ -37,6 +37,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
+#include <QJsonObject>
 #include <QLibrary>
 #include <QMessageBox>
 #include <QNetworkAccessManager>
@@ -68,11 +69,17 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 using namespace MOBase;
 using namespace MOShared;
 
+// number of times a download is resumed after a network error
+static constexpr int DownloadAttempts = 3;
+
+// delay in milliseconds before resuming an interrupted download
+static constexpr int ResumeDelay = 2000;
+
 SelfUpdater::SelfUpdater(NexusInterface *nexusInterface)
   : m_Parent(nullptr)
   , m_Interface(nexusInterface)
   , m_Reply(nullptr)
-  , m_Attempts(3)
+  , m_Attempts(DownloadAttempts)
 {
   m_MOVersion = createVersionInfo();
 }
@@ -208,9 +215,20 @@ void SelfUpdater::startUpdate()
     for (const QJsonValue &assetVal : latestRelease["assets"].toArray()) {
       QJsonObject asset = assetVal.toObject();
       if (asset["content_type"].toString() == "application/x-msdownload") {
-        openOutputFile(asset["name"].toString());
-        download(asset["browser_download_url"].toString());
         found = true;
+
+        if (openOutputFile(asset)) {
+          m_DownloadLink = asset["browser_download_url"].toString();
+          m_Attempts = DownloadAttempts;
+
+          if (m_ExpectedSize > 0 && m_UpdateFile.size() == m_ExpectedSize) {
+            // a previous attempt got the whole file
+            finishDownload();
+          } else {
+            download(m_DownloadLink);
+          }
+        }
+
         break;
       }
     }
@@ -245,12 +263,50 @@ void SelfUpdater::closeProgress()
   }
 }
 
-void SelfUpdater::openOutputFile(const QString &fileName)
+bool SelfUpdater::openOutputFile(const QJsonObject &asset)
 {
-  QString outputPath = QDir::fromNativeSeparators(qApp->property("dataPath").toString()) + "/" + fileName;
-  log::debug("downloading to {}", outputPath);
-  m_UpdateFile.setFileName(outputPath);
-  m_UpdateFile.open(QIODevice::WriteOnly);
+  m_InstallerPath =
+    QDir::fromNativeSeparators(qApp->property("dataPath").toString()) + "/" +
+    asset["name"].toString();
+
+  m_ExpectedSize = static_cast<qint64>(asset["size"].toDouble(-1));
+
+  // "sha256:<hex>", not given for older releases
+  m_ExpectedDigest.clear();
+  const QString digest = asset["digest"].toString();
+  if (digest.startsWith("sha256:", Qt::CaseInsensitive)) {
+    m_ExpectedDigest = QByteArray::fromHex(digest.mid(7).toLatin1());
+  }
+
+  m_Hash = std::make_unique<QCryptographicHash>(QCryptographicHash::Sha256);
+  m_UpdateFile.setFileName(m_InstallerPath + ".part");
+
+  log::debug("downloading to {}", m_UpdateFile.fileName());
+
+  if (!m_UpdateFile.open(QIODevice::ReadWrite)) {
+    reportError(tr("Failed to open %1: %2")
+      .arg(m_UpdateFile.fileName())
+      .arg(m_UpdateFile.errorString()));
+
+    return false;
+  }
+
+  const qint64 existing = m_UpdateFile.size();
+
+  if (existing > 0) {
+    if (m_ExpectedSize <= 0 || existing > m_ExpectedSize) {
+      // can't be part of the same file
+      log::debug("discarding partial download of {} bytes", existing);
+      m_UpdateFile.resize(0);
+    } else {
+      log::debug("resuming download after {} bytes", existing);
+      m_Hash->addData(&m_UpdateFile);
+    }
+  }
+
+  m_UpdateFile.seek(m_UpdateFile.size());
+
+  return true;
 }
 
 void SelfUpdater::download(const QString &downloadLink)
@@ -258,7 +314,17 @@ void SelfUpdater::download(const QString &downloadLink)
   QNetworkAccessManager *accessManager = m_Interface->getAccessManager();
   QUrl dlUrl(downloadLink);
   QNetworkRequest request(dlUrl);
+
+  // asks for the rest of the file, the server may ignore it and send all of
+  // it, see downloadReadyRead()
+  m_ResumeOffset = m_UpdateFile.size();
+  if (m_ResumeOffset > 0) {
+    request.setRawHeader(
+      "Range", QString("bytes=%1-").arg(m_ResumeOffset).toLatin1());
+  }
+
   m_Canceled = false;
+  m_ReplyChecked = false;
   m_Reply = accessManager->get(request);
   showProgress();
 
@@ -274,9 +340,12 @@ void SelfUpdater::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
     if (m_Canceled) {
       m_Reply->abort();
     } else {
-      if (bytesTotal != 0) {
+      const qint64 total = (m_ExpectedSize > 0) ?
+        m_ExpectedSize : (bytesTotal > 0 ? bytesTotal + m_ResumeOffset : 0);
+
+      if (total != 0) {
         if (m_Progress != nullptr) {
-          m_Progress->setValue((bytesReceived * 100) / bytesTotal);
+          m_Progress->setValue(((m_ResumeOffset + bytesReceived) * 100) / total);
         }
       }
     }
@@ -286,46 +355,159 @@ void SelfUpdater::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 
 void SelfUpdater::downloadReadyRead()
 {
-  if (m_Reply != nullptr) {
-    m_UpdateFile.write(m_Reply->readAll());
+  if (m_Reply == nullptr) {
+    return;
   }
+
+  if (!m_ReplyChecked) {
+    const int status = m_Reply->attribute(
+      QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    if (status != 200 && status != 206) {
+      // redirections and errors, handled in downloadFinished()
+      m_Reply->readAll();
+      return;
+    }
+
+    m_ReplyChecked = true;
+
+    if (status == 200 && m_UpdateFile.size() > 0) {
+      log::debug("server doesn't support resuming, starting over");
+
+      m_UpdateFile.resize(0);
+      m_UpdateFile.seek(0);
+      m_Hash->reset();
+      m_ResumeOffset = 0;
+    }
+  }
+
+  // hashed as it comes in, verified once the download is complete
+  const QByteArray data = m_Reply->readAll();
+  m_UpdateFile.write(data);
+  m_Hash->addData(data);
 }
 
 
 void SelfUpdater::downloadFinished()
 {
-  int error = QNetworkReply::NoError;
+  if (m_Reply == nullptr) {
+    return;
+  }
 
-  if (m_Reply != nullptr) {
-    if (m_Reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 302) {
-      QUrl url = m_Reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
-      m_UpdateFile.reset();
-      download(url.toString());
-      return;
-    }
-    m_UpdateFile.write(m_Reply->readAll());
+  if (m_Reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 302) {
+    QUrl url = m_Reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+    m_Reply->deleteLater();
+    m_Reply = nullptr;
+    download(url.toString());
+    return;
+  }
+
+  downloadReadyRead();
 
-    error = m_Reply->error();
+  const int error = m_Reply->error();
+  const bool errorPage = m_Reply->header(QNetworkRequest::ContentTypeHeader)
+    .toString().startsWith("text", Qt::CaseInsensitive);
+
+  m_Reply->close();
+  m_Reply->deleteLater();
+  m_Reply = nullptr;
+
+  if (m_Canceled) {
+    // what was downloaded is kept, the next update resumes from there
+    closeProgress();
+    m_UpdateFile.close();
+    return;
+  }
 
-    if (m_Reply->header(QNetworkRequest::ContentTypeHeader).toString().startsWith("text", Qt::CaseInsensitive)) {
-      m_Canceled = true;
+  if (errorPage) {
+    log::error("update download returned a text page instead of the installer");
+    closeProgress();
+    m_UpdateFile.close();
+    m_UpdateFile.remove();
+    return;
+  }
+
+  const bool incomplete =
+    (error != QNetworkReply::NoError) ||
+    (m_ExpectedSize > 0 && m_UpdateFile.size() < m_ExpectedSize);
+
+  if (incomplete) {
+    if (m_Attempts > 0) {
+      --m_Attempts;
+
+      log::warn(
+        "update download interrupted ({}), resuming after {} bytes",
+        error, m_UpdateFile.size());
+
+      QTimer::singleShot(ResumeDelay, this, [this] {
+        if (m_Canceled) {
+          closeProgress();
+          m_UpdateFile.close();
+        } else {
+          download(m_DownloadLink);
+        }
+      });
+
+      return;
     }
 
+    // the partial file is kept for the next update
     closeProgress();
+    m_UpdateFile.close();
+    reportError(tr("Download failed: %1").arg(error));
+    return;
+  }
 
-    m_Reply->close();
-    m_Reply->deleteLater();
-    m_Reply = nullptr;
+  closeProgress();
+  finishDownload();
+}
+
+
+bool SelfUpdater::verifyDownload(QString &error)
+{
+  const qint64 size = m_UpdateFile.size();
+
+  if (size == 0) {
+    error = tr("the file is empty");
+    return false;
   }
 
+  if (m_ExpectedSize > 0 && size != m_ExpectedSize) {
+    error = tr("expected %1 bytes, got %2").arg(m_ExpectedSize).arg(size);
+    return false;
+  }
+
+  if (!m_ExpectedDigest.isEmpty() && m_Hash->result() != m_ExpectedDigest) {
+    error = tr("the file is corrupted, its hash doesn't match the release");
+    return false;
+  }
+
+  return true;
+}
+
+
+void SelfUpdater::finishDownload()
+{
+  QString error;
+  const bool valid = verifyDownload(error);
+
   m_UpdateFile.close();
 
-  if ((m_UpdateFile.size() == 0) ||
-      (error != QNetworkReply::NoError) ||
-      m_Canceled) {
-    if (!m_Canceled) {
-      reportError(tr("Download failed: %1").arg(error));
-    }
+  if (!valid) {
+    log::error("update download failed verification: {}", error);
+    m_UpdateFile.remove();
+    reportError(tr("Download failed: %1").arg(error));
+    return;
+  }
+
+  QFile::remove(m_InstallerPath);
+
+  if (!m_UpdateFile.rename(m_InstallerPath)) {
+    reportError(tr("Failed to rename %1 to %2: %3")
+      .arg(m_UpdateFile.fileName())
+      .arg(m_InstallerPath)
+      .arg(m_UpdateFile.errorString()));
+
     m_UpdateFile.remove();
     return;
   }
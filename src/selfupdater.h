@@ -21,6 +21,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #define SELFUPDATER_H
 
 #include <map>
+#include <memory>
 
 #include <versioninfo.h>
 #include <github.h>
@@ -30,7 +31,9 @@ class NexusInterface;
 class PluginContainer;
 namespace MOBase { class IPluginGame; }
 
+#include <QCryptographicHash>
 #include <QFile>
+#include <QJsonObject>
 #include <QObject>
 #include <QString>
 #include <QVariant>
@@ -116,8 +119,25 @@ signals:
 
 private:
 
-  void openOutputFile(const QString &fileName);
+  // opens the partial file for the given release asset, keeping what was
+  // already downloaded by a previous attempt if it can be resumed; returns
+  // false if the file couldn't be opened
+  //
+  bool openOutputFile(const QJsonObject &asset);
+
+  // requests the rest of the file from the given link, resuming after what's
+  // already in the partial file
+  //
   void download(const QString &downloadLink);
+
+  // whether the downloaded file has the size and the digest announced by the
+  // release, if any
+  //
+  bool verifyDownload(QString &error);
+
+  // moves the complete partial file to its final name and runs it
+  //
+  void finishDownload();
   void installUpdate();
   void report7ZipError(const QString &errorMessage);
   void showProgress();
@@ -139,8 +159,32 @@ private:
   QNetworkReply *m_Reply;
   QProgressDialog *m_Progress { nullptr };
   bool m_Canceled;
+
+  // number of times the download is resumed after a network error
   int m_Attempts;
 
+  // link of the asset being downloaded, used when resuming
+  QString m_DownloadLink;
+
+  // final path of the installer, the data is downloaded to a .part file next
+  // to it
+  QString m_InstallerPath;
+
+  // size and sha256 of the asset as given by the release, if any
+  qint64 m_ExpectedSize { -1 };
+  QByteArray m_ExpectedDigest;
+
+  // hash of everything written to the partial file so far, updated as the
+  // data comes in so the file doesn't have to be read again at the end
+  std::unique_ptr<QCryptographicHash> m_Hash;
+
+  // bytes that were already in the file when the current request started
+  qint64 m_ResumeOffset { 0 };
+
+  // whether the status of the current reply has been checked, done on the
+  // first data received
+  bool m_ReplyChecked { false };
+
   GitHub m_GitHub;
 
   // Map from version to release, in decreasing order (first element is the latest release):
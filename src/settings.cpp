@@ -312,6 +312,16 @@ void Settings::setArchiveParsing(bool b)
   set(m_Settings, "Settings", "archive_parsing_experimental", b);
 }
 
+bool Settings::prewarmVFS() const
+{
+  return get<bool>(m_Settings, "Settings", "prewarm_vfs", false);
+}
+
+void Settings::setPrewarmVFS(bool b)
+{
+  set(m_Settings, "Settings", "prewarm_vfs", b);
+}
+
 std::vector<std::map<QString, QVariant>> Settings::executables() const
 {
   ScopedReadArray sra(m_Settings, "customExecutables");
@@ -546,7 +556,9 @@ void Settings::managedGameChanged(IPluginGame const *gamePlugin)
 
 
 GameSettings::GameSettings(QSettings& settings)
-  : m_Settings(settings), m_GamePlugin(nullptr)
+  : m_Settings(settings), m_GamePlugin(nullptr),
+    m_forceEnableCoreFiles(
+      get<bool>(m_Settings, "Settings", "force_enable_core_files", true))
 {
 }
 
@@ -562,12 +574,13 @@ void GameSettings::setPlugin(const MOBase::IPluginGame* gamePlugin)
 
 bool GameSettings::forceEnableCoreFiles() const
 {
-  return get<bool>(m_Settings, "Settings", "force_enable_core_files", true);
+  return m_forceEnableCoreFiles;
 }
 
 void GameSettings::setForceEnableCoreFiles(bool b)
 {
   set(m_Settings, "Settings", "force_enable_core_files", b);
+  m_forceEnableCoreFiles = b;
 }
 
 std::optional<QString> GameSettings::directory() const
@@ -1170,78 +1183,98 @@ void WidgetSettings::resetQuestionButtons()
 ColorSettings::ColorSettings(QSettings& s)
   : m_Settings(s)
 {
+  m_modlistOverwrittenLoose = get<QColor>(
+    m_Settings, "Settings", "overwrittenLooseFilesColor",
+    QColor(0, 255, 0, 64));
+
+  m_modlistOverwritingLoose = get<QColor>(
+    m_Settings, "Settings", "overwritingLooseFilesColor",
+    QColor(255, 0, 0, 64));
+
+  m_modlistOverwrittenArchive = get<QColor>(
+    m_Settings, "Settings", "overwrittenArchiveFilesColor",
+    QColor(0, 255, 255, 64));
+
+  m_modlistOverwritingArchive = get<QColor>(
+    m_Settings, "Settings", "overwritingArchiveFilesColor",
+    QColor(255, 0, 255, 64));
+
+  m_modlistContainsPlugin = get<QColor>(
+    m_Settings, "Settings", "containsPluginColor",
+    QColor(0, 0, 255, 64));
+
+  m_pluginListContained = get<QColor>(
+    m_Settings, "Settings", "containedColor",
+    QColor(0, 0, 255, 64));
+
+  m_colorSeparatorScrollbar = get<bool>(
+    m_Settings, "Settings", "colorSeparatorScrollbars", true);
 }
 
 QColor ColorSettings::modlistOverwrittenLoose() const
 {
-  return get<QColor>(
-    m_Settings, "Settings", "overwrittenLooseFilesColor",
-    QColor(0, 255, 0, 64));
+  return m_modlistOverwrittenLoose;
 }
 
 void ColorSettings::setModlistOverwrittenLoose(const QColor& c)
 {
   set(m_Settings, "Settings", "overwrittenLooseFilesColor", c);
+  m_modlistOverwrittenLoose = c;
 }
 
 QColor ColorSettings::modlistOverwritingLoose() const
 {
-  return get<QColor>(
-    m_Settings, "Settings", "overwritingLooseFilesColor",
-    QColor(255, 0, 0, 64));
+  return m_modlistOverwritingLoose;
 }
 
 void ColorSettings::setModlistOverwritingLoose(const QColor& c)
 {
   set(m_Settings, "Settings", "overwritingLooseFilesColor", c);
+  m_modlistOverwritingLoose = c;
 }
 
 QColor ColorSettings::modlistOverwrittenArchive() const
 {
-  return get<QColor>(
-    m_Settings, "Settings", "overwrittenArchiveFilesColor",
-    QColor(0, 255, 255, 64));
+  return m_modlistOverwrittenArchive;
 }
 
 void ColorSettings::setModlistOverwrittenArchive(const QColor& c)
 {
   set(m_Settings, "Settings", "overwrittenArchiveFilesColor", c);
+  m_modlistOverwrittenArchive = c;
 }
 
 QColor ColorSettings::modlistOverwritingArchive() const
 {
-  return get<QColor>(
-    m_Settings, "Settings", "overwritingArchiveFilesColor",
-    QColor(255, 0, 255, 64));
+  return m_modlistOverwritingArchive;
 }
 
 void ColorSettings::setModlistOverwritingArchive(const QColor& c)
 {
   set(m_Settings, "Settings", "overwritingArchiveFilesColor", c);
+  m_modlistOverwritingArchive = c;
 }
 
 QColor ColorSettings::modlistContainsPlugin() const
 {
-  return get<QColor>(
-    m_Settings, "Settings", "containsPluginColor",
-    QColor(0, 0, 255, 64));
+  return m_modlistContainsPlugin;
 }
 
 void ColorSettings::setModlistContainsPlugin(const QColor& c)
 {
   set(m_Settings, "Settings", "containsPluginColor", c);
+  m_modlistContainsPlugin = c;
 }
 
 QColor ColorSettings::pluginListContained() const
 {
-  return get<QColor>(
-    m_Settings, "Settings", "containedColor",
-    QColor(0, 0, 255, 64));
+  return m_pluginListContained;
 }
 
 void ColorSettings::setPluginListContained(const QColor& c)
 {
   set(m_Settings, "Settings", "containedColor", c);
+  m_pluginListContained = c;
 }
 
 std::optional<QColor> ColorSettings::previousSeparatorColor() const
@@ -1266,12 +1299,13 @@ void ColorSettings::removePreviousSeparatorColor()
 
 bool ColorSettings::colorSeparatorScrollbar() const
 {
-  return get<bool>(m_Settings, "Settings", "colorSeparatorScrollbars", true);
+  return m_colorSeparatorScrollbar;
 }
 
 void ColorSettings::setColorSeparatorScrollbar(bool b)
 {
   set(m_Settings, "Settings", "colorSeparatorScrollbars", b);
+  m_colorSeparatorScrollbar = b;
 }
 
 QColor ColorSettings::idealTextColor(const QColor& rBackgroundColor)
@@ -1864,6 +1898,36 @@ void NetworkSettings::setCustomBrowserCommand(const QString& s)
   updateCustomBrowser();
 }
 
+int NetworkSettings::maxDownloads() const
+{
+  return get<int>(m_Settings, "Settings", "max_downloads", 4);
+}
+
+void NetworkSettings::setMaxDownloads(int n)
+{
+  set(m_Settings, "Settings", "max_downloads", n);
+}
+
+int NetworkSettings::maxDownloadSpeed() const
+{
+  return get<int>(m_Settings, "Settings", "max_download_speed", 0);
+}
+
+void NetworkSettings::setMaxDownloadSpeed(int kbps)
+{
+  set(m_Settings, "Settings", "max_download_speed", kbps);
+}
+
+int NetworkSettings::maxDownloadSpeedPerDownload() const
+{
+  return get<int>(m_Settings, "Settings", "max_download_speed_per_download", 0);
+}
+
+void NetworkSettings::setMaxDownloadSpeedPerDownload(int kbps)
+{
+  set(m_Settings, "Settings", "max_download_speed_per_download", kbps);
+}
+
 ServerList NetworkSettings::serversFromOldMap() const
 {
   // for 2.2.1 and before
@@ -1892,6 +1956,10 @@ ServerList NetworkSettings::serversFromOldMap() const
 
 void NetworkSettings::dump() const
 {
+  log::debug(
+    "max downloads: {}, max speed: {} KB/s, per download: {} KB/s",
+    maxDownloads(), maxDownloadSpeed(), maxDownloadSpeedPerDownload());
+
   log::debug("servers:");
 
   for (const auto& server : servers()) {
@@ -1953,6 +2021,16 @@ void NexusSettings::setTrackedIntegration(bool b) const
   set(m_Settings, "Settings", "tracked_integration", b);
 }
 
+bool NexusSettings::backgroundUpdateChecks() const
+{
+  return get<bool>(m_Settings, "Settings", "background_update_checks", true);
+}
+
+void NexusSettings::setBackgroundUpdateChecks(bool b) const
+{
+  set(m_Settings, "Settings", "background_update_checks", b);
+}
+
 void NexusSettings::registerAsNXMHandler(bool force)
 {
   const auto nxmPath =
@@ -2103,6 +2181,23 @@ void SteamSettings::setLogin(QString username, QString password)
 InterfaceSettings::InterfaceSettings(QSettings& settings)
   : m_Settings(settings)
 {
+  m_collapsibleSeparatorsAsc = get<bool>(
+    m_Settings, "Settings", "collapsible_separators_asc", true);
+
+  m_collapsibleSeparatorsDsc = get<bool>(
+    m_Settings, "Settings", "collapsible_separators_dsc", true);
+
+  m_collapsibleSeparatorsHighlightTo = get<bool>(
+    m_Settings, "Settings", "collapsible_separators_conflicts_to", true);
+
+  m_collapsibleSeparatorsHighlightFrom = get<bool>(
+    m_Settings, "Settings", "collapsible_separators_conflicts_from", true);
+
+  m_collapsibleSeparatorsPerProfile = get<bool>(
+    m_Settings, "Settings", "collapsible_separators_per_profile", false);
+
+  m_autoCollapseOnHover = get<bool>(
+    m_Settings, "Settings", "auto_collapse_on_hover", false);
 }
 
 bool InterfaceSettings::lockGUI() const
@@ -2127,54 +2222,75 @@ void InterfaceSettings::setStyleName(const QString& name)
 
 bool InterfaceSettings::collapsibleSeparators(Qt::SortOrder order) const
 {
-  return get<bool>(m_Settings, "Settings",
-    order == Qt::AscendingOrder ? "collapsible_separators_asc" : "collapsible_separators_dsc", true);
+  return order == Qt::AscendingOrder ?
+    m_collapsibleSeparatorsAsc : m_collapsibleSeparatorsDsc;
 }
 
 void InterfaceSettings::setCollapsibleSeparators(bool ascending, bool descending)
 {
   set(m_Settings, "Settings", "collapsible_separators_asc", ascending);
   set(m_Settings, "Settings", "collapsible_separators_dsc", descending);
+
+  m_collapsibleSeparatorsAsc = ascending;
+  m_collapsibleSeparatorsDsc = descending;
 }
 
 bool InterfaceSettings::collapsibleSeparatorsHighlightTo() const
 {
-  return get<bool>(m_Settings, "Settings", "collapsible_separators_conflicts_to", true);
+  return m_collapsibleSeparatorsHighlightTo;
 }
 
 void InterfaceSettings::setCollapsibleSeparatorsHighlightTo(bool b)
 {
   set(m_Settings, "Settings", "collapsible_separators_conflicts_to", b);
+  m_collapsibleSeparatorsHighlightTo = b;
 }
 
 bool InterfaceSettings::collapsibleSeparatorsHighlightFrom() const
 {
-  return get<bool>(m_Settings, "Settings", "collapsible_separators_conflicts_from", true);
+  return m_collapsibleSeparatorsHighlightFrom;
 }
 
 void InterfaceSettings::setCollapsibleSeparatorsHighlightFrom(bool b)
 {
   set(m_Settings, "Settings", "collapsible_separators_conflicts_from", b);
+  m_collapsibleSeparatorsHighlightFrom = b;
+}
+
+QString InterfaceSettings::collapsibleSeparatorsIconsKey(int column)
+{
+  return QString("collapsible_separators_icons_%1").arg(column);
 }
 
 bool InterfaceSettings::collapsibleSeparatorsIcons(int column) const
 {
-  return get<bool>(m_Settings, "Settings", QString("collapsible_separators_icons_%1").arg(column), true);
+  auto itor = m_collapsibleSeparatorsIcons.find(column);
+
+  if (itor == m_collapsibleSeparatorsIcons.end()) {
+    const auto b = get<bool>(
+      m_Settings, "Settings", collapsibleSeparatorsIconsKey(column), true);
+
+    itor = m_collapsibleSeparatorsIcons.emplace(column, b).first;
+  }
+
+  return itor->second;
 }
 
 void InterfaceSettings::setCollapsibleSeparatorsIcons(int column, bool show)
 {
-  set(m_Settings, "Settings", QString("collapsible_separators_icons_%1").arg(column), show);
+  set(m_Settings, "Settings", collapsibleSeparatorsIconsKey(column), show);
+  m_collapsibleSeparatorsIcons[column] = show;
 }
 
 bool InterfaceSettings::collapsibleSeparatorsPerProfile() const
 {
-  return get<bool>(m_Settings, "Settings", "collapsible_separators_per_profile", false);
+  return m_collapsibleSeparatorsPerProfile;
 }
 
 void InterfaceSettings::setCollapsibleSeparatorsPerProfile(bool b)
 {
   set(m_Settings, "Settings", "collapsible_separators_per_profile", b);
+  m_collapsibleSeparatorsPerProfile = b;
 }
 
 bool InterfaceSettings::saveFilters() const
@@ -2189,12 +2305,13 @@ void InterfaceSettings::setSaveFilters(bool b)
 
 bool InterfaceSettings::autoCollapseOnHover() const
 {
-  return get<bool>(m_Settings, "Settings", "auto_collapse_on_hover", false);
+  return m_autoCollapseOnHover;
 }
 
 void InterfaceSettings::setAutoCollapseOnHover(bool b)
 {
   set(m_Settings, "Settings", "auto_collapse_on_hover", b);
+  m_autoCollapseOnHover = b;
 }
 
 bool InterfaceSettings::checkUpdateAfterInstallation() const
@@ -2390,6 +2507,46 @@ void DiagnosticsSettings::setSpawnDelay(std::chrono::seconds t)
   set(m_Settings, "Settings", "spawn_delay", t.count());
 }
 
+bool DiagnosticsSettings::refreshInstrumentation() const
+{
+  return get<bool>(m_Settings, "Settings", "refresh_instrumentation", false);
+}
+
+void DiagnosticsSettings::setRefreshInstrumentation(bool b)
+{
+  set(m_Settings, "Settings", "refresh_instrumentation", b);
+}
+
+bool DiagnosticsSettings::performanceStats() const
+{
+  return get<bool>(m_Settings, "Settings", "performance_stats", false);
+}
+
+void DiagnosticsSettings::setPerformanceStats(bool b)
+{
+  set(m_Settings, "Settings", "performance_stats", b);
+}
+
+bool DiagnosticsSettings::stallDetection() const
+{
+  return get<bool>(m_Settings, "Settings", "stall_detection", true);
+}
+
+void DiagnosticsSettings::setStallDetection(bool b)
+{
+  set(m_Settings, "Settings", "stall_detection", b);
+}
+
+int DiagnosticsSettings::memoryBudget() const
+{
+  return get<int>(m_Settings, "Settings", "memory_budget", 0);
+}
+
+void DiagnosticsSettings::setMemoryBudget(int mb)
+{
+  set(m_Settings, "Settings", "memory_budget", mb);
+}
+
 
 void GlobalSettings::updateRegistryKey()
 {
@@ -85,6 +85,9 @@ public:
 private:
   QSettings& m_Settings;
   const MOBase::IPluginGame* m_GamePlugin;
+
+  // read once, checked for every plugin in PluginList::refresh()
+  bool m_forceEnableCoreFiles;
 };
 
 
@@ -279,6 +282,16 @@ public:
 
 private:
   QSettings& m_Settings;
+
+  // these are used when painting the lists, so they're read once and kept
+  // here; the setters update both the ini and these
+  QColor m_modlistOverwrittenLoose;
+  QColor m_modlistOverwritingLoose;
+  QColor m_modlistOverwrittenArchive;
+  QColor m_modlistOverwritingArchive;
+  QColor m_modlistContainsPlugin;
+  QColor m_pluginListContained;
+  bool m_colorSeparatorScrollbar;
 };
 
 
@@ -482,6 +495,23 @@ public:
   QString customBrowserCommand() const;
   void setCustomBrowserCommand(const QString& s);
 
+  // maximum number of downloads transferring at the same time, others are
+  // queued until one is done; 0 for no limit
+  //
+  int maxDownloads() const;
+  void setMaxDownloads(int n);
+
+  // maximum download speed in KB/s for all downloads together; 0 for no
+  // limit
+  //
+  int maxDownloadSpeed() const;
+  void setMaxDownloadSpeed(int kbps);
+
+  // maximum download speed in KB/s for each download; 0 for no limit
+  //
+  int maxDownloadSpeedPerDownload() const;
+  void setMaxDownloadSpeedPerDownload(int kbps);
+
   void dump() const;
 
 private:
@@ -528,6 +558,12 @@ public:
   bool trackedIntegration() const;
   void setTrackedIntegration(bool b) const;
 
+  // returns whether mods are checked for updates in the background, see
+  // UpdateScheduler
+  //
+  bool backgroundUpdateChecks() const;
+  void setBackgroundUpdateChecks(bool b) const;
+
   // registers MO as the handler for nxm links
   //
   // if 'force' is true, the registration dialog will be shown even if the user
@@ -700,6 +736,22 @@ public:
 
 private:
   QSettings& m_Settings;
+
+  // the separator options are checked for every row when the mod list is
+  // painted or sorted, so they're read once and kept here; the setters
+  // update both the ini and these
+  bool m_collapsibleSeparatorsAsc;
+  bool m_collapsibleSeparatorsDsc;
+  bool m_collapsibleSeparatorsHighlightTo;
+  bool m_collapsibleSeparatorsHighlightFrom;
+  bool m_collapsibleSeparatorsPerProfile;
+  bool m_autoCollapseOnHover;
+
+  // by column, filled when a column is first asked for; only used from the
+  // ui thread
+  mutable std::map<int, bool> m_collapsibleSeparatorsIcons;
+
+  static QString collapsibleSeparatorsIconsKey(int column);
 };
 
 
@@ -730,6 +782,30 @@ public:
   std::chrono::seconds spawnDelay() const;
   void setSpawnDelay(std::chrono::seconds t);
 
+  // whether timings are collected during refreshes, see RefreshTrace
+  //
+  bool refreshInstrumentation() const;
+  void setRefreshInstrumentation(bool b);
+
+  // whether the status bar shows the performance of the structure, the
+  // downloads and the background threads, see StatusBar
+  //
+  bool performanceStats() const;
+  void setPerformanceStats(bool b);
+
+  // whether stalls of the interface are logged with the stack of the ui
+  // thread, see StallDetector
+  //
+  bool stallDetection() const;
+  void setStallDetection(bool b);
+
+  // memory in megabytes the caches that can be built again are allowed to use
+  // before the least recently used ones are released, 0 for no limit; see
+  // MemoryAccounting
+  //
+  int memoryBudget() const;
+  void setMemoryBudget(int mb);
+
 private:
   QSettings& m_Settings;
 };
@@ -815,6 +891,12 @@ public:
   bool archiveParsing() const;
   void setArchiveParsing(bool b);
 
+  // whether the vfs mapping of the current profile should be installed after
+  // every refresh so launching a program doesn't have to wait for it
+  //
+  bool prewarmVFS() const;
+  void setPrewarmVFS(bool b);
+
   // whether the user wants to check for updates
   //
   bool checkForUpdates() const;
@@ -27,6 +27,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "settingsdialogmodlist.h"
 #include "settingsdialogtheme.h"
 #include "settingsdialogworkarounds.h"
+#include <QTimer>
 
 using namespace MOBase;
 
@@ -39,14 +40,59 @@ SettingsDialog::SettingsDialog(PluginContainer *pluginContainer, Settings& setti
 {
   ui->setupUi(this);
 
-  m_tabs.push_back(std::unique_ptr<SettingsTab>(new GeneralSettingsTab(settings, *this)));
-  m_tabs.push_back(std::unique_ptr<SettingsTab>(new ThemeSettingsTab(settings, *this)));
-  m_tabs.push_back(std::unique_ptr<SettingsTab>(new ModListSettingsTab(settings, *this)));
-  m_tabs.push_back(std::unique_ptr<SettingsTab>(new PathsSettingsTab(settings, *this)));
-  m_tabs.push_back(std::unique_ptr<SettingsTab>(new DiagnosticsSettingsTab(settings, *this)));
-  m_tabs.push_back(std::unique_ptr<SettingsTab>(new NexusSettingsTab(settings, *this)));
-  m_tabs.push_back(std::unique_ptr<SettingsTab>(new PluginsSettingsTab(settings, m_pluginContainer, *this)));
-  m_tabs.push_back(std::unique_ptr<SettingsTab>(new WorkaroundsSettingsTab(settings, *this)));
+  auto add = [&](QWidget* page, auto create) {
+    m_pages.push_back({page, std::move(create), {}});
+  };
+
+  add(ui->generalTab, [&]{ return std::make_unique<GeneralSettingsTab>(m_settings, *this); });
+  add(ui->tab, [&]{ return std::make_unique<ThemeSettingsTab>(m_settings, *this); });
+  add(ui->uiTab, [&]{ return std::make_unique<ModListSettingsTab>(m_settings, *this); });
+  add(ui->pathsTab, [&]{ return std::make_unique<PathsSettingsTab>(m_settings, *this); });
+  add(ui->diagnosticsTab, [&]{ return std::make_unique<DiagnosticsSettingsTab>(m_settings, *this); });
+  add(ui->nexusTab, [&]{ return std::make_unique<NexusSettingsTab>(m_settings, *this); });
+  add(ui->pluginsTab, [&]{ return std::make_unique<PluginsSettingsTab>(m_settings, m_pluginContainer, *this); });
+  add(ui->workaroundTab, [&]{ return std::make_unique<WorkaroundsSettingsTab>(m_settings, *this); });
+
+  connect(ui->tabWidget, &QTabWidget::currentChanged, [&](int index) {
+    createTab(ui->tabWidget->widget(index));
+  });
+}
+
+void SettingsDialog::createTab(QWidget* page)
+{
+  for (auto& p : m_pages) {
+    if (p.widget == page) {
+      if (!p.tab) {
+        p.tab = p.create();
+      }
+
+      return;
+    }
+  }
+}
+
+bool SettingsDialog::hasTab(QWidget* page) const
+{
+  for (const auto& p : m_pages) {
+    if (p.widget == page) {
+      return static_cast<bool>(p.tab);
+    }
+  }
+
+  return false;
+}
+
+void SettingsDialog::warmTabs()
+{
+  for (auto& p : m_pages) {
+    if (!p.tab) {
+      p.tab = p.create();
+
+      // one per pass of the event loop so the dialog stays responsive
+      QTimer::singleShot(0, this, [&]{ warmTabs(); });
+      return;
+    }
+  }
 }
 
 PluginContainer* SettingsDialog::pluginContainer()
@@ -79,18 +125,29 @@ int SettingsDialog::exec()
 
   m_settings.widgets().restoreIndex(ui->tabWidget);
 
+  // currentChanged isn't emitted when the index was already right
+  createTab(ui->tabWidget->currentWidget());
+
+  // the other tabs are created once the dialog is shown
+  QTimer::singleShot(0, this, [&]{ warmTabs(); });
+
   auto ret = TutorableDialog::exec();
 
   m_settings.widgets().saveIndex(ui->tabWidget);
 
   if (ret == QDialog::Accepted) {
-    for (auto&& tab : m_tabs) {
-      tab->closing();
+    for (auto&& p : m_pages) {
+      if (p.tab) {
+        p.tab->closing();
+      }
     }
 
-    // update settings for each tab
-    for (std::unique_ptr<SettingsTab> const &tab: m_tabs) {
-      tab->update();
+    // update settings for each tab, the ones that were never created haven't
+    // changed anything
+    for (auto&& p : m_pages) {
+      if (p.tab) {
+        p.tab->update();
+      }
     }
   }
 
@@ -118,7 +175,9 @@ void SettingsDialog::accept()
   QString newModPath = ui->modDirEdit->text();
   newModPath = PathSettings::resolve(newModPath, ui->baseDirEdit->text());
 
-  if ((QDir::fromNativeSeparators(newModPath) !=
+  // the edits are empty when the paths tab was never created
+  if (hasTab(ui->pathsTab) &&
+      (QDir::fromNativeSeparators(newModPath) !=
        QDir::fromNativeSeparators(
            Settings::instance().paths().mods(true))) &&
       (QMessageBox::question(
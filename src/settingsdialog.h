@@ -22,6 +22,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "tutorabledialog.h"
 #include "shared/util.h"
+#include <functional>
 
 class PluginContainer;
 class Settings;
@@ -55,6 +56,10 @@ private:
  * dialog used to change settings for Mod Organizer. On top of the
  * settings managed by the "Settings" class, this offers a button to open the
  * CategoriesDialog
+ *
+ * tabs are created the first time their page is shown, the others are
+ * created one by one once the dialog is visible so switching pages stays
+ * quick; only the tabs that were created are updated when it's accepted
  **/
 class SettingsDialog : public MOBase::TutorableDialog
 {
@@ -85,11 +90,32 @@ public slots:
   virtual void accept();
 
 private:
+  // a page of the tab widget and the tab that handles it, if it was created
+  struct Page
+  {
+    QWidget* widget;
+    std::function<std::unique_ptr<SettingsTab> ()> create;
+    std::unique_ptr<SettingsTab> tab;
+  };
+
   Ui::SettingsDialog* ui;
   Settings& m_settings;
-  std::vector<std::unique_ptr<SettingsTab>> m_tabs;
+  std::vector<Page> m_pages;
   ExitFlags m_exit;
   PluginContainer* m_pluginContainer;
+
+  // creates the tab for the given page if it doesn't exist yet
+  //
+  void createTab(QWidget* page);
+
+  // whether the tab for the given page was created
+  //
+  bool hasTab(QWidget* page) const;
+
+  // creates the next tab that doesn't exist yet and schedules itself again
+  // until they all do
+  //
+  void warmTabs();
 };
 
 #endif // SETTINGSDIALOG_H
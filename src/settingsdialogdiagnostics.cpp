@@ -1,8 +1,15 @@
 #include "settingsdialogdiagnostics.h"
 #include "ui_settingsdialog.h"
 #include "shared/appconfig.h"
+#include "shared/ioaccounting.h"
 #include "organizercore.h"
+#include "refreshtrace.h"
+#include "startuptrace.h"
+#include "memoryaccounting.h"
+#include "stalldetector.h"
 #include <log.h>
+#include <utility.h>
+#include <QMessageBox>
 
 using namespace MOBase;
 
@@ -12,8 +19,18 @@ DiagnosticsSettingsTab::DiagnosticsSettingsTab(Settings& s, SettingsDialog& d)
   setLogLevel();
   setLootLogLevel();
   setCrashDumpTypesBox();
+  setRefreshTimings();
+  setStartupTimings();
+  setFileActivity();
+  setMemoryUsage();
+
+  QObject::connect(
+    ui->writeMemoryUsage, &QPushButton::clicked, [&]{ onWriteMemoryUsage(); });
 
   ui->dumpsMaxEdit->setValue(settings().diagnostics().maxCoreDumps());
+  ui->performanceStats->setChecked(settings().diagnostics().performanceStats());
+  ui->stallDetection->setChecked(settings().diagnostics().stallDetection());
+  ui->memoryBudget->setValue(settings().diagnostics().memoryBudget());
 
   QString logsPath = qApp->property("dataPath").toString()
     + "/" + QString::fromStdWString(AppConfig::logPath());
@@ -94,6 +111,178 @@ void DiagnosticsSettingsTab::setCrashDumpTypesBox()
   }
 }
 
+void DiagnosticsSettingsTab::setRefreshTimings()
+{
+  using namespace std::chrono;
+
+  ui->refreshInstrumentation->setChecked(
+    settings().diagnostics().refreshInstrumentation());
+
+  const auto r = RefreshTrace::lastReport();
+  if (!r) {
+    return;
+  }
+
+  auto ms = [](nanoseconds ns) {
+    return duration_cast<microseconds>(ns).count() / 1000.0;
+  };
+
+  // the phases of the refresh, the same one can run more than once
+  std::map<QString, nanoseconds> phases;
+  for (const auto& e : r->events) {
+    if (e.category == "refresh") {
+      phases[e.name] += e.duration;
+    }
+  }
+
+  QStringList sl;
+  for (auto&& [name, d] : phases) {
+    sl.push_back(QObject::tr("%1: %2 ms").arg(name).arg(ms(d)));
+  }
+
+  ui->refreshTimingsLabel->setText(
+    QObject::tr("Last refresh at %1 took %2 ms.")
+      .arg(r->time.toString(Qt::DefaultLocaleLongDate))
+      .arg(ms(r->total)) +
+    "\n" + sl.join("\n"));
+
+  ui->refreshTimings->clear();
+  ui->refreshTimings->setSortingEnabled(false);
+
+  for (const auto& m : r->mods) {
+    auto* item = new QTreeWidgetItem;
+
+    // numbers are set as data so they're sorted correctly
+    item->setText(0, m.name);
+    item->setData(1, Qt::DisplayRole, ms(m.walk));
+    item->setData(2, Qt::DisplayRole, ms(m.archives));
+    item->setData(3, Qt::DisplayRole, ms(m.lockWait));
+    item->setData(4, Qt::DisplayRole, static_cast<qlonglong>(m.files));
+
+    ui->refreshTimings->addTopLevelItem(item);
+  }
+
+  ui->refreshTimings->setSortingEnabled(true);
+  ui->refreshTimings->sortByColumn(1, Qt::DescendingOrder);
+}
+
+void DiagnosticsSettingsTab::setStartupTimings()
+{
+  using namespace std::chrono;
+
+  const auto r = StartupTrace::lastReport();
+  if (!r) {
+    return;
+  }
+
+  auto ms = [](nanoseconds ns) {
+    return duration_cast<microseconds>(ns).count() / 1000.0;
+  };
+
+  const double total = std::max(ms(r->total), 0.001);
+
+  // two levels are enough for a summary, the rest is in the trace file
+  QStringList sl;
+  for (const auto& s : r->spans) {
+    if (s.depth > 1) {
+      continue;
+    }
+
+    const double d = ms(s.duration);
+
+    sl.push_back(QObject::tr("%1%2: %3 ms (%4%)")
+      .arg(QString(s.depth * 4, ' '))
+      .arg(s.name)
+      .arg(d)
+      .arg(static_cast<int>(d * 100 / total)));
+  }
+
+  ui->startupTimingsLabel->setText(
+    QObject::tr("Startup at %1 took %2 ms until the first refresh was done.")
+      .arg(r->time.toString(Qt::DefaultLocaleLongDate))
+      .arg(ms(r->total)) +
+    "\n" + sl.join("\n"));
+}
+
+void DiagnosticsSettingsTab::setFileActivity()
+{
+  using MOShared::IoAccounting;
+
+  const auto io = IoAccounting::lastRefresh();
+  if (!io) {
+    return;
+  }
+
+  QStringList sl;
+
+  for (std::size_t i=0; i<io->size(); ++i) {
+    const auto& c = (*io)[i];
+    if (c.empty()) {
+      continue;
+    }
+
+    sl.push_back(QObject::tr("%1: %2 opens, %3 stats, %4 enumerations, %5 read")
+      .arg(IoAccounting::name(static_cast<IoAccounting::Subsystem>(i)))
+      .arg(c.opens)
+      .arg(c.stats)
+      .arg(c.enumerations)
+      .arg(localizedByteSize(c.bytesRead)));
+  }
+
+  if (sl.empty()) {
+    return;
+  }
+
+  ui->fileActivityLabel->setText(
+    QObject::tr("The last refresh accessed the disk for:") +
+    "\n" + sl.join("\n"));
+}
+
+void DiagnosticsSettingsTab::setMemoryUsage()
+{
+  const auto v = MemoryAccounting::collect();
+
+  std::size_t total = 0;
+  QStringList sl;
+
+  for (const auto& u : v) {
+    if (u.usage.bytes == 0) {
+      continue;
+    }
+
+    total += u.usage.bytes;
+
+    sl.push_back(QObject::tr("%1: %2 (%3)")
+      .arg(u.name)
+      .arg(localizedByteSize(u.usage.bytes))
+      .arg(u.usage.count));
+  }
+
+  if (total == 0) {
+    return;
+  }
+
+  ui->memoryUsageLabel->setText(
+    QObject::tr("About %1 are used by:").arg(localizedByteSize(total)) +
+    "\n" + sl.join("\n"));
+}
+
+void DiagnosticsSettingsTab::onWriteMemoryUsage()
+{
+  if (!MemoryAccounting::write()) {
+    QMessageBox::critical(
+      parentWidget(), QObject::tr("Error"),
+      QObject::tr("Failed to write the memory report, see the log for details."));
+
+    return;
+  }
+
+  // the estimates may have changed since the tab was opened
+  setMemoryUsage();
+
+  shell::Explore(MemoryAccounting::memoryFilename());
+}
+
 void DiagnosticsSettingsTab::update()
 {
   settings().diagnostics().setLogLevel(
@@ -106,4 +295,20 @@ void DiagnosticsSettingsTab::update()
 
   settings().diagnostics().setLootLogLevel(
     static_cast<lootcli::LogLevels>(ui->lootLogLevel->currentData().toInt()));
+
+  settings().diagnostics().setRefreshInstrumentation(
+    ui->refreshInstrumentation->isChecked());
+
+  settings().diagnostics().setPerformanceStats(
+    ui->performanceStats->isChecked());
+
+  settings().diagnostics().setStallDetection(
+    ui->stallDetection->isChecked());
+
+  StallDetector::setEnabled(ui->stallDetection->isChecked());
+
+  settings().diagnostics().setMemoryBudget(ui->memoryBudget->value());
+
+  MemoryAccounting::setBudget(
+    static_cast<std::size_t>(ui->memoryBudget->value()) * 1024 * 1024);
 }
@@ -15,6 +15,11 @@ private:
   void setLogLevel();
   void setLootLogLevel();
   void setCrashDumpTypesBox();
+  void setRefreshTimings();
+  void setStartupTimings();
+  void setFileActivity();
+  void setMemoryUsage();
+  void onWriteMemoryUsage();
 };
 
 #endif // SETTINGSDIALOGDIAGNOSTICS_H
@@ -297,6 +297,7 @@ NexusSettingsTab::NexusSettingsTab(Settings& s, SettingsDialog& d)
 {
   ui->endorsementBox->setChecked(settings().nexus().endorsementIntegration());
   ui->trackedBox->setChecked(settings().nexus().trackedIntegration());
+  ui->backgroundUpdatesBox->setChecked(settings().nexus().backgroundUpdateChecks());
   ui->hideAPICounterBox->setChecked(settings().interface().hideAPICounter());
 
   // display server preferences
@@ -356,6 +357,7 @@ void NexusSettingsTab::update()
 {
   settings().nexus().setEndorsementIntegration(ui->endorsementBox->isChecked());
   settings().nexus().setTrackedIntegration(ui->trackedBox->isChecked());
+  settings().nexus().setBackgroundUpdateChecks(ui->backgroundUpdatesBox->isChecked());
   settings().interface().setHideAPICounter(ui->hideAPICounterBox->isChecked());
 
   auto servers = settings().network().servers();
@@ -6,6 +6,7 @@
 #include "disableproxyplugindialog.h"
 #include "organizercore.h"
 #include "plugincontainer.h"
+#include "pluginstats.h"
 
 using namespace MOBase;
 
@@ -287,6 +288,7 @@ void PluginsSettingsTab::on_pluginsList_currentItemChanged(QTreeWidgetItem *curr
   ui->authorLabel->setText(plugin->author());
   ui->versionLabel->setText(plugin->version().canonicalString());
   ui->descriptionLabel->setText(plugin->description());
+  ui->performanceLabel->setText(performanceText(plugin));
 
   // Checkbox, do not show for children or game plugins, disable
   // if the plugin cannot be enabled.
@@ -352,6 +354,42 @@ void PluginsSettingsTab::on_pluginsList_currentItemChanged(QTreeWidgetItem *curr
   ui->pluginSettingsList->resizeColumnToContents(1);
 }
 
+QString PluginsSettingsTab::performanceText(const IPlugin* plugin) const
+{
+  using namespace std::chrono;
+
+  const auto calls = PluginStats::calls(plugin);
+  if (calls.empty()) {
+    return QObject::tr("No calls");
+  }
+
+  auto ms = [](auto d) {
+    return QString::number(duration_cast<microseconds>(d).count() / 1000.0, 'f', 1);
+  };
+
+  QString s = "<table cellspacing=\"0\" cellpadding=\"1\">";
+
+  s += QString("<tr><th align=\"left\">%1</th><th>%2</th><th>%3</th><th>%4</th></tr>")
+    .arg(QObject::tr("Call"))
+    .arg(QObject::tr("Count"))
+    .arg(QObject::tr("Total (ms)"))
+    .arg(QObject::tr("Max (ms)"));
+
+  for (const auto& c : calls) {
+    s += QString(
+      "<tr><td>%1</td><td align=\"right\">%2</td>"
+      "<td align=\"right\">%3</td><td align=\"right\">%4</td></tr>")
+      .arg(c.name.toHtmlEscaped())
+      .arg(c.count)
+      .arg(ms(c.total))
+      .arg(ms(c.max));
+  }
+
+  s += "</table>";
+
+  return s;
+}
+
 void PluginsSettingsTab::deleteBlacklistItem()
 {
   ui->pluginBlacklist->takeItem(ui->pluginBlacklist->currentIndex().row());
@@ -20,6 +20,9 @@ private:
   void deleteBlacklistItem();
   void storeSettings(QTreeWidgetItem *pluginItem);
 
+  // table of the calls made into the plugin so far, see PluginStats
+  QString performanceText(const MOBase::IPlugin* plugin) const;
+
 private slots:
 
   /**
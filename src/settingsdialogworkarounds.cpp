@@ -12,6 +12,7 @@ WorkaroundsSettingsTab::WorkaroundsSettingsTab(Settings& s, SettingsDialog& d)
   ui->forceEnableBox->setChecked(settings().game().forceEnableCoreFiles());
   ui->lockGUIBox->setChecked(settings().interface().lockGUI());
   ui->enableArchiveParsingBox->setChecked(settings().archiveParsing());
+  ui->prewarmVFSBox->setChecked(settings().prewarmVFS());
 
   // steam
   QString username, password;
@@ -41,6 +42,7 @@ void WorkaroundsSettingsTab::update()
   settings().game().setForceEnableCoreFiles(ui->forceEnableBox->isChecked());
   settings().interface().setLockGUI(ui->lockGUIBox->isChecked());
   settings().setArchiveParsing(ui->enableArchiveParsingBox->isChecked());
+  settings().setPrewarmVFS(ui->prewarmVFSBox->isChecked());
 
   // steam
   if (ui->appIDEdit->text() != settings().game().plugin()->steamAPPId()) {
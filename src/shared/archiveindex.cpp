@@ -0,0 +1,476 @@
+#include "archiveindex.h"
+#include "ioaccounting.h"
+#include "util.h"
+#include <bsatk.h>
+#include <log.h>
+#include <safewritefile.h>
+#include <utility.h>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace MOShared
+{
+
+using namespace MOBase;
+
+// changed every time the format of the file changes, files with another
+// version are ignored
+static constexpr quint32 CacheMagic = 0x4941504d;  // "MOAI"
+static constexpr quint32 CacheVersion = 1;
+
+// archives that no instance has used for this many days are dropped from the
+// cache file
+static constexpr quint32 CacheExpiryDays = 30;
+
+// days since the FILETIME epoch
+//
+static quint32 today()
+{
+  FILETIME ft;
+  ::GetSystemTimeAsFileTime(&ft);
+
+  const uint64_t t =
+    (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+
+  // 100ns intervals
+  return static_cast<quint32>(t / (10'000'000ull * 60 * 60 * 24));
+}
+
+static void writeFolder(QDataStream& s, const ArchiveIndex::Folder& f)
+{
+  s << ToQString(f.name) << static_cast<quint32>(f.files.size());
+
+  for (const auto& file : f.files) {
+    s
+      << ToQString(file.name)
+      << static_cast<quint64>(file.size)
+      << static_cast<quint64>(file.uncompressedSize);
+  }
+
+  s << static_cast<quint32>(f.folders.size());
+
+  for (const auto& sub : f.folders) {
+    writeFolder(s, sub);
+  }
+}
+
+static bool readFolder(QDataStream& s, ArchiveIndex::Folder& f)
+{
+  QString name;
+  quint32 count = 0;
+
+  s >> name >> count;
+  if (s.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  f.name = name.toStdWString();
+  f.files.reserve(count);
+
+  for (quint32 i=0; i<count; ++i) {
+    QString fileName;
+    quint64 size = 0, uncompressedSize = 0;
+
+    s >> fileName >> size >> uncompressedSize;
+    if (s.status() != QDataStream::Ok) {
+      return false;
+    }
+
+    f.files.push_back({fileName.toStdWString(), size, uncompressedSize});
+  }
+
+  s >> count;
+  if (s.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  f.folders.reserve(count);
+
+  for (quint32 i=0; i<count; ++i) {
+    if (!readFolder(s, f.folders.emplace_back())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+struct ArchiveIndex::CacheEntry
+{
+  std::shared_ptr<const ArchiveIndex> index;
+
+  // see today()
+  quint32 lastUsed;
+};
+
+class ArchiveIndex::Cache
+{
+public:
+  using Entries = std::map<std::wstring, CacheEntry>;
+
+  std::shared_ptr<const ArchiveIndex> find(
+    const std::wstring& key, const std::wstring& path)
+  {
+    std::scoped_lock lock(m_mutex);
+    loadIfNeeded();
+
+    auto itor = m_entries.find(key);
+    if (itor == m_entries.end()) {
+      return {};
+    }
+
+    auto& e = itor->second;
+    m_paths[ToLowerCopy(path)] = key;
+
+    // the file is written at most once a day only to remember the archive is
+    // still used
+    const auto t = today();
+    if (e.lastUsed != t) {
+      e.lastUsed = t;
+      m_dirty = true;
+    }
+
+    return e.index;
+  }
+
+  void add(
+    const std::wstring& key, const std::wstring& path,
+    std::shared_ptr<const ArchiveIndex> index)
+  {
+    std::scoped_lock lock(m_mutex);
+
+    m_entries[key] = {std::move(index), today()};
+    m_paths[ToLowerCopy(path)] = key;
+    m_dirty = true;
+  }
+
+  void prune(const std::set<std::wstring>& keepPaths)
+  {
+    std::scoped_lock lock(m_mutex);
+
+    std::set<std::wstring> keys;
+
+    for (auto itor=m_paths.begin(); itor!=m_paths.end();) {
+      if (keepPaths.contains(itor->first)) {
+        keys.insert(itor->second);
+        ++itor;
+      } else {
+        itor = m_paths.erase(itor);
+      }
+    }
+
+    // archives that are not kept are still in the file, they're written
+    // again by save()
+    for (auto itor=m_entries.begin(); itor!=m_entries.end();) {
+      if (keys.contains(itor->first)) {
+        ++itor;
+      } else {
+        itor = m_entries.erase(itor);
+      }
+    }
+  }
+
+  void setFile(std::wstring path)
+  {
+    std::scoped_lock lock(m_mutex);
+
+    if (m_file == path) {
+      return;
+    }
+
+    m_file = std::move(path);
+    m_loaded = false;
+  }
+
+  void save()
+  {
+    Entries entries;
+    QString file;
+
+    {
+      std::scoped_lock lock(m_mutex);
+
+      if (!m_dirty || m_file.empty()) {
+        return;
+      }
+
+      entries = m_entries;
+      file = ToQString(m_file);
+      m_dirty = false;
+    }
+
+    // other instances may have added archives since the file was loaded, and
+    // the archives dropped by prune() must be kept
+    Entries onDisk;
+    read(file, onDisk);
+
+    const auto expired = today() - std::min(today(), CacheExpiryDays);
+
+    for (auto&& [key, e] : onDisk) {
+      if (e.lastUsed >= expired) {
+        entries.emplace(key, std::move(e));
+      }
+    }
+
+    write(file, entries);
+  }
+
+private:
+  Entries m_entries;
+
+  // lowercase path of the archives given to find() and add(), used by prune()
+  std::map<std::wstring, std::wstring> m_paths;
+
+  std::wstring m_file;
+  bool m_loaded = true;
+  bool m_dirty = false;
+  mutable std::mutex m_mutex;
+
+  void loadIfNeeded()
+  {
+    if (m_loaded) {
+      return;
+    }
+
+    m_loaded = true;
+
+    read(ToQString(m_file), m_entries);
+    log::debug("loaded {} archive indices from {}", m_entries.size(), m_file);
+  }
+
+  static void read(const QString& path, Entries& out)
+  {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+      // not necessarily a problem, the file may just not exist (yet)
+      return;
+    }
+
+    QDataStream s(&file);
+    s.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0, version = 0, count = 0;
+    s >> magic >> version >> count;
+
+    if (magic != CacheMagic || version != CacheVersion) {
+      log::debug("ignoring archive cache {}, wrong version", path);
+      return;
+    }
+
+    for (quint32 i=0; i<count; ++i) {
+      QString key;
+      quint32 lastUsed = 0, low = 0, high = 0;
+
+      s >> key >> lastUsed >> low >> high;
+
+      auto index = std::make_shared<ArchiveIndex>();
+      index->m_LastModified.dwLowDateTime = low;
+      index->m_LastModified.dwHighDateTime = high;
+
+      if (s.status() != QDataStream::Ok || !readFolder(s, index->m_Root)) {
+        log::error("archive cache {} is corrupted, ignoring it", path);
+        out.clear();
+        return;
+      }
+
+      index->m_FilesSize = filesSize(index->m_Root);
+
+      out.emplace(key.toStdWString(), CacheEntry{std::move(index), lastUsed});
+    }
+  }
+
+  static void write(const QString& path, const Entries& entries)
+  {
+    QByteArray data;
+
+    {
+      QDataStream s(&data, QIODevice::WriteOnly);
+      s.setVersion(QDataStream::Qt_5_12);
+
+      s << CacheMagic << CacheVersion << static_cast<quint32>(entries.size());
+
+      for (auto&& [key, e] : entries) {
+        s
+          << ToQString(key) << e.lastUsed
+          << static_cast<quint32>(e.index->m_LastModified.dwLowDateTime)
+          << static_cast<quint32>(e.index->m_LastModified.dwHighDateTime);
+
+        writeFolder(s, e.index->m_Root);
+      }
+    }
+
+    // the directory may not exist yet
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    try
+    {
+      // the file is replaced atomically, so instances saving at the same time
+      // can only lose the archives parsed by the other one
+      SafeWriteFile file(path);
+      file->resize(0);
+      file->write(data);
+      file.commit();
+
+      log::debug("saved {} archive indices to {}", entries.size(), path);
+    }
+    catch(std::exception& e)
+    {
+      log::error("failed to save archive cache to {}: {}", path, e.what());
+    }
+  }
+};
+
+
+static void addFolder(ArchiveIndex::Folder& out, const BSA::Folder::Ptr& folder)
+{
+  const auto fileCount = folder->getNumFiles();
+  out.files.reserve(fileCount);
+
+  for (unsigned int i=0; i<fileCount; ++i) {
+    const BSA::File::Ptr file = folder->getFile(i);
+
+    out.files.push_back({
+      ToWString(file->getName(), true),
+      file->getFileSize(), file->getUncompressedFileSize()});
+  }
+
+  const auto dirCount = folder->getNumSubFolders();
+  out.folders.reserve(dirCount);
+
+  for (unsigned int i=0; i<dirCount; ++i) {
+    const BSA::Folder::Ptr sub = folder->getSubFolder(i);
+
+    auto& f = out.folders.emplace_back();
+    f.name = ToWString(sub->getName(), true);
+    addFolder(f, sub);
+  }
+}
+
+
+std::shared_ptr<const ArchiveIndex> ArchiveIndex::get(const std::wstring& path)
+{
+  WIN32_FILE_ATTRIBUTE_DATA data = {};
+
+  IoAccounting::stat(IoAccounting::Subsystem::Archives);
+
+  if (!::GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) {
+    const auto e = GetLastError();
+    log::error("can't get attributes of archive '{}', {}", path, formatSystemMessage(e));
+    return {};
+  }
+
+  const uint64_t size =
+    (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+
+  const auto k = key(path, size, data.ftLastWriteTime);
+
+  if (auto index=cache().find(k, path)) {
+    return index;
+  }
+
+  auto index = read(path, data.ftLastWriteTime);
+  if (index) {
+    cache().add(k, path, index);
+  }
+
+  return index;
+}
+
+void ArchiveIndex::prune(const std::vector<std::wstring>& keep)
+{
+  std::set<std::wstring> keys;
+  for (const auto& path : keep) {
+    keys.insert(ToLowerCopy(path));
+  }
+
+  cache().prune(keys);
+}
+
+void ArchiveIndex::setCacheFile(const std::wstring& path)
+{
+  cache().setFile(path);
+}
+
+void ArchiveIndex::save()
+{
+  cache().save();
+}
+
+uint64_t ArchiveIndex::filesSize(const Folder& f)
+{
+  uint64_t total = 0;
+
+  for (const auto& file : f.files) {
+    total += file.size;
+  }
+
+  for (const auto& sub : f.folders) {
+    total += filesSize(sub);
+  }
+
+  return total;
+}
+
+std::wstring ArchiveIndex::key(
+  const std::wstring& path, uint64_t size, FILETIME lastModified)
+{
+  const auto sep = path.find_last_of(L"\\/");
+  const auto name = (sep == std::wstring::npos) ?
+    std::wstring_view(path) : std::wstring_view(path).substr(sep + 1);
+
+  const uint64_t time =
+    (static_cast<uint64_t>(lastModified.dwHighDateTime) << 32) |
+    lastModified.dwLowDateTime;
+
+  return
+    ToLowerCopy(name) + L"|" + std::to_wstring(size) + L"|" +
+    std::to_wstring(time);
+}
+
+std::shared_ptr<const ArchiveIndex> ArchiveIndex::read(
+  const std::wstring& path, FILETIME lastModified)
+{
+  BSA::Archive archive;
+  BSA::EErrorCode res = BSA::ERROR_NONE;
+
+  IoAccounting::open(IoAccounting::Subsystem::Archives);
+
+  try
+  {
+    // read() can return an error, but it can also throw if the file is not a
+    // valid bsa
+    res = archive.read(ToString(path, false).c_str(), false);
+  }
+  catch(std::exception& e)
+  {
+    log::error("invalid bsa '{}', error {}", path, e.what());
+    return {};
+  }
+
+  if ((res != BSA::ERROR_NONE) && (res != BSA::ERROR_INVALIDHASHES)) {
+    log::error("invalid bsa '{}', error {}", path, res);
+    return {};
+  }
+
+  auto index = std::make_shared<ArchiveIndex>();
+  index->m_LastModified = lastModified;
+  addFolder(index->m_Root, archive.getRoot());
+  index->m_FilesSize = filesSize(index->m_Root);
+
+  return index;
+}
+
+ArchiveIndex::Cache& ArchiveIndex::cache()
+{
+  static Cache c;
+  return c;
+}
+
+} // namespace
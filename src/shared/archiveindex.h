@@ -0,0 +1,103 @@
+#ifndef MO_REGISTER_ARCHIVEINDEX_INCLUDED
+#define MO_REGISTER_ARCHIVEINDEX_INCLUDED
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace MOShared
+{
+
+// the list of folders and files in a bsa or ba2, without their contents
+//
+// indices are cached for the lifetime of the process, keyed by the name,
+// size and modification time of the archive, so an archive that hasn't
+// changed is only parsed once no matter how many times the structure is
+// refreshed; copies of the same archive in several mods share one index
+//
+// the cache can also be kept in a file shared by all the instances, see
+// setCacheFile(), so an archive parsed by one instance is never parsed again
+// by another one, even if each has its own copy of the mod
+//
+class ArchiveIndex
+{
+public:
+  struct File
+  {
+    std::wstring name;
+    uint64_t size;
+    uint64_t uncompressedSize;
+  };
+
+  struct Folder
+  {
+    std::wstring name;
+    std::vector<File> files;
+    std::vector<Folder> folders;
+  };
+
+  // returns the index of the given archive, parsing it if it's not in the
+  // cache or if it changed on disk; returns null if it can't be read, which
+  // has already been logged
+  //
+  // this is thread-safe, archives are parsed without holding any lock
+  //
+  static std::shared_ptr<const ArchiveIndex> get(const std::wstring& path);
+
+  // removes all the archives from the cache except the given ones; this only
+  // frees memory, archives are kept in the cache file
+  //
+  static void prune(const std::vector<std::wstring>& keep);
+
+  // the file where the cache is kept across runs; it's loaded the first time
+  // an archive is needed
+  //
+  static void setCacheFile(const std::wstring& path);
+
+  // writes the cache file if archives were parsed since it was loaded; the
+  // archives added to the file by other instances in the meantime are kept,
+  // archives that haven't been used for a while by any instance are dropped
+  //
+  static void save();
+
+  FILETIME lastModified() const
+  {
+    return m_LastModified;
+  }
+
+  const Folder& root() const
+  {
+    return m_Root;
+  }
+
+  // total size in bytes of the files in the archive, as stored
+  //
+  uint64_t filesSize() const
+  {
+    return m_FilesSize;
+  }
+
+private:
+  struct CacheEntry;
+  class Cache;
+
+  FILETIME m_LastModified;
+  Folder m_Root;
+  uint64_t m_FilesSize = 0;
+
+  static std::shared_ptr<const ArchiveIndex> read(
+    const std::wstring& path, FILETIME lastModified);
+
+  // name, size and modification time of the archive
+  //
+  static uint64_t filesSize(const Folder& f);
+
+  static std::wstring key(
+    const std::wstring& path, uint64_t size, FILETIME lastModified);
+
+  static Cache& cache();
+};
+
+} // namespace
+
+#endif // MO_REGISTER_ARCHIVEINDEX_INCLUDED
@@ -0,0 +1,501 @@
+#include "conflictgraph.h"
+#include "directoryentry.h"
+#include "fileentry.h"
+#include "fileregister.h"
+#include "filesorigin.h"
+#include "originconnection.h"
+#include "../taskexecutor.h"
+#include <log.h>
+#include <map>
+#include <tuple>
+
+namespace MOShared
+{
+
+using namespace MOBase;
+
+// number of files handled by a single task
+static constexpr std::size_t ChunkSize = 4096;
+
+// neighbours are stored in a single map for all the kinds
+//
+static std::uint64_t nodeKey(ConflictGraph::Kinds kind, OriginID to)
+{
+  return (static_cast<std::uint64_t>(kind) << 32) | static_cast<std::uint32_t>(to);
+}
+
+static ConflictGraph::Kinds nodeKind(std::uint64_t key)
+{
+  return static_cast<ConflictGraph::Kinds>(key >> 32);
+}
+
+static OriginID nodeTarget(std::uint64_t key)
+{
+  return static_cast<OriginID>(key & 0xffffffff);
+}
+
+
+// everything the pass needs that doesn't change while it's running, so
+// the tasks don't have to look up origins
+//
+struct ConflictGraph::Context
+{
+  std::wstring hiddenExt;
+  OriginID dataID = InvalidOriginID;
+
+  // indexed by origin id
+  std::vector<int> priorities;
+
+  // origins that are part of the graph before and after the update, indexed
+  // by origin id; origins past the end are not part of it
+  std::vector<bool> before, after;
+};
+
+
+// changes made by one task, merged into the graph once all the tasks are done
+//
+struct ConflictGraph::Delta
+{
+  // indexed by origin id, neighbours are not used
+  std::vector<Counts> counts;
+
+  // number of files for each edge, keyed by the origin, kind and neighbour
+  std::map<std::tuple<OriginID, Kinds, OriginID>, std::int64_t> edges;
+
+  // whether a directory is hidden or is in a hidden directory
+  std::unordered_map<const DirectoryEntry*, bool> hiddenDirs;
+
+  // reused for every file
+  std::vector<FileAlternative> providers;
+
+  explicit Delta(std::size_t originCount)
+    : counts(originCount)
+  {
+  }
+
+  void edge(OriginID from, Kinds kind, OriginID to, int sign)
+  {
+    auto& c = edges[{from, kind, to}];
+    c += sign;
+  }
+};
+
+
+static bool hasExtension(std::wstring_view name, const std::wstring& ext)
+{
+  if (ext.empty() || name.size() <= ext.size()) {
+    return false;
+  }
+
+  return (name.substr(name.size() - ext.size()) == ext);
+}
+
+static bool isHidden(
+  const DirectoryEntry* d, const std::wstring& ext,
+  std::unordered_map<const DirectoryEntry*, bool>& cache)
+{
+  if (!d) {
+    return false;
+  }
+
+  auto itor = cache.find(d);
+  if (itor != cache.end()) {
+    return itor->second;
+  }
+
+  const bool b =
+    hasExtension(d->getName(), ext) || isHidden(d->getParent(), ext, cache);
+
+  cache.emplace(d, b);
+  return b;
+}
+
+// adds what the given file contributes to the graph to the delta, with the
+// given sign, as if only the included origins provided it
+//
+// this is the same check that used to be done for every mod separately: an
+// origin conflicts with the origin that provides the file and with every
+// alternative, except for the data directory
+//
+void ConflictGraph::addFile(
+  const Context& cx, Delta& d, FileEntryPtr file,
+  const std::vector<bool>& included, int sign)
+{
+  using K = ConflictGraph::Kinds;
+
+  auto isExcluded = [&](OriginID id) {
+    const auto i = static_cast<std::size_t>(id);
+    return (id < 0 || i >= included.size() || !included[i]);
+  };
+
+  // alternatives are sorted by ascending priority, the primary origin goes
+  // last; when the primary origin is excluded, the alternative with the
+  // highest priority takes its place, which is what FileEntry::removeOrigin()
+  // does
+  auto& p = d.providers;
+  p.clear();
+
+  for (const auto& alt : file->getAlternatives()) {
+    if (!isExcluded(alt.originID())) {
+      p.push_back(alt);
+    }
+  }
+
+  if (!isExcluded(file->getOrigin())) {
+    p.push_back({file->getOrigin(), file->getArchive()});
+  }
+
+  if (p.empty()) {
+    return;
+  }
+
+  const bool hidden =
+    hasExtension(file->getName(), cx.hiddenExt) ||
+    isHidden(file->getParent(), cx.hiddenExt, d.hiddenDirs);
+
+  const FileAlternative& primary = p.back();
+  const std::size_t altCount = p.size() - 1;
+
+  // no alternatives, or only the data directory, means no conflict
+  const bool conflicted =
+    (altCount > 0 && p[altCount - 1].originID() != cx.dataID);
+
+  auto priority = [&](OriginID id) {
+    return cx.priorities[static_cast<std::size_t>(id)];
+  };
+
+  for (const auto& self : p) {
+    const OriginID id = self.originID();
+    auto& c = d.counts[static_cast<std::size_t>(id)];
+
+    c.files += sign;
+    if (hidden) {
+      c.hidden += sign;
+    }
+
+    if (!conflicted) {
+      c.provided += sign;
+      continue;
+    }
+
+    const bool selfArchive = self.isFromArchive();
+
+    if (id != primary.originID()) {
+      if (!primary.isFromArchive()) {
+        d.edge(
+          id, (selfArchive ? K::ArchiveLooseOverwritten : K::Overwritten),
+          primary.originID(), sign);
+      } else {
+        d.edge(id, K::ArchiveOverwritten, primary.originID(), sign);
+      }
+    } else {
+      c.provided += sign;
+    }
+
+    for (std::size_t i=0; i<altCount; ++i) {
+      const auto& alt = p[i];
+
+      if (alt.originID() == cx.dataID || alt.originID() == id) {
+        continue;
+      }
+
+      if (!alt.isFromArchive()) {
+        if (!selfArchive) {
+          if (priority(id) > priority(alt.originID())) {
+            d.edge(id, K::Overwrite, alt.originID(), sign);
+          } else {
+            d.edge(id, K::Overwritten, alt.originID(), sign);
+          }
+        } else {
+          d.edge(id, K::ArchiveLooseOverwritten, alt.originID(), sign);
+        }
+      } else {
+        if (!selfArchive) {
+          d.edge(id, K::ArchiveLooseOverwrite, alt.originID(), sign);
+        } else if (file->getArchive(self).order() > file->getArchive(alt).order()) {
+          d.edge(id, K::ArchiveOverwrite, alt.originID(), sign);
+        } else if (file->getArchive(self).order() < file->getArchive(alt).order()) {
+          d.edge(id, K::ArchiveOverwritten, alt.originID(), sign);
+        }
+      }
+    }
+  }
+}
+
+
+ConflictGraph::ConflictGraph(FileRegister& files, OriginConnection& origins)
+  : m_Files(files), m_Origins(origins), m_Generation(0)
+{
+}
+
+void ConflictGraph::rebuild(std::wstring hiddenExt)
+{
+  std::vector<bool> all;
+
+  m_Origins.forEachOrigin([&](FilesOrigin& o) {
+    const auto i = static_cast<std::size_t>(o.getID());
+
+    if (i >= all.size()) {
+      all.resize(i + 1, false);
+    }
+
+    all[i] = true;
+  });
+
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_HiddenExt = std::move(hiddenExt);
+    m_Nodes.clear();
+    m_Included.clear();
+  }
+
+  update(nullptr, all);
+}
+
+void ConflictGraph::exclude(const std::vector<OriginID>& origins)
+{
+  auto included = includedOrigins();
+  std::vector<OriginID> changed;
+
+  for (const OriginID id : origins) {
+    const auto i = static_cast<std::size_t>(id);
+
+    if (id >= 0 && i < included.size() && included[i]) {
+      included[i] = false;
+      changed.push_back(id);
+    }
+  }
+
+  if (!changed.empty()) {
+    const auto files = filesOf(changed);
+    update(&files, included);
+  }
+}
+
+void ConflictGraph::include(const std::vector<OriginID>& origins)
+{
+  auto included = includedOrigins();
+  std::vector<OriginID> changed;
+
+  for (const OriginID id : origins) {
+    const auto i = static_cast<std::size_t>(id);
+
+    if (id < 0) {
+      continue;
+    }
+
+    if (i >= included.size()) {
+      included.resize(i + 1, false);
+    }
+
+    if (!included[i]) {
+      included[i] = true;
+      changed.push_back(id);
+    }
+  }
+
+  if (!changed.empty()) {
+    const auto files = filesOf(changed);
+    update(&files, included);
+  }
+}
+
+ConflictGraph::Counts ConflictGraph::counts(OriginID origin) const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  const auto i = static_cast<std::size_t>(origin);
+  if (origin < 0 || i >= m_Nodes.size()) {
+    return {};
+  }
+
+  return m_Nodes[i].counts;
+}
+
+std::vector<OriginID> ConflictGraph::neighbours(OriginID origin, Kinds kind) const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  std::vector<OriginID> v;
+
+  const auto i = static_cast<std::size_t>(origin);
+  if (origin < 0 || i >= m_Nodes.size()) {
+    return v;
+  }
+
+  for (auto&& [key, count] : m_Nodes[i].edges) {
+    if (nodeKind(key) == kind) {
+      v.push_back(nodeTarget(key));
+    }
+  }
+
+  std::sort(v.begin(), v.end());
+  return v;
+}
+
+std::uint64_t ConflictGraph::generation() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return m_Generation;
+}
+
+MemoryUsage ConflictGraph::memoryUsage() const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  MemoryUsage u;
+  u.bytes = vectorBytes(m_Nodes) + m_Included.capacity() / 8;
+
+  for (const auto& n : m_Nodes) {
+    u.count += n.edges.size();
+    u.bytes += hashBytes(n.edges);
+  }
+
+  return u;
+}
+
+std::vector<FileIndex> ConflictGraph::filesOf(
+  const std::vector<OriginID>& origins) const
+{
+  std::vector<FileIndex> v;
+
+  for (const OriginID id : origins) {
+    if (const auto* o=m_Origins.findByID(id)) {
+      o->forEachFileIndex([&](FileIndex i) { v.push_back(i); });
+    }
+  }
+
+  // files shared by the origins are only visited once
+  std::sort(v.begin(), v.end());
+  v.erase(std::unique(v.begin(), v.end()), v.end());
+
+  return v;
+}
+
+std::vector<bool> ConflictGraph::includedOrigins() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return m_Included;
+}
+
+void ConflictGraph::update(
+  const std::vector<FileIndex>* files, const std::vector<bool>& included)
+{
+  Context cx;
+
+  {
+    std::scoped_lock lock(m_Mutex);
+    cx.hiddenExt = m_HiddenExt;
+    cx.before = m_Included;
+  }
+
+  cx.after = included;
+
+  m_Origins.forEachOrigin([&](FilesOrigin& o) {
+    const auto i = static_cast<std::size_t>(o.getID());
+
+    if (i >= cx.priorities.size()) {
+      cx.priorities.resize(i + 1, 0);
+    }
+
+    cx.priorities[i] = o.getPriority();
+
+    if (o.getName() == L"data") {
+      cx.dataID = o.getID();
+    }
+  });
+
+  const std::size_t originCount = cx.priorities.size();
+  const std::size_t count = (files ? files->size() : m_Files.highestCount());
+  const std::size_t chunks = (count + ChunkSize - 1) / ChunkSize;
+
+  std::vector<Delta> deltas(chunks, Delta(originCount));
+
+  auto run = [&](std::size_t chunk) {
+    Delta& d = deltas[chunk];
+
+    const std::size_t begin = chunk * ChunkSize;
+    const std::size_t end = std::min(begin + ChunkSize, count);
+
+    for (std::size_t i=begin; i<end; ++i) {
+      const FileIndex index = (files ? (*files)[i] : static_cast<FileIndex>(i));
+
+      if (auto f=m_Files.getFile(index)) {
+        addFile(cx, d, f, cx.before, -1);
+        addFile(cx, d, f, cx.after, +1);
+      }
+    }
+  };
+
+  if (chunks == 1) {
+    // small updates, like a single mod being moved, are not worth it
+    run(0);
+  } else {
+    TaskGroup g(TaskPriority::High);
+
+    for (std::size_t i=0; i<chunks; ++i) {
+      g.run([&, i]{ run(i); });
+    }
+
+    g.wait();
+  }
+
+  std::scoped_lock lock(m_Mutex);
+
+  if (m_Nodes.size() < originCount) {
+    m_Nodes.resize(originCount);
+  }
+
+  for (const auto& d : deltas) {
+    apply(d);
+  }
+
+  m_Included = included;
+  ++m_Generation;
+}
+
+void ConflictGraph::apply(const Delta& d)
+{
+  for (std::size_t i=0; i<d.counts.size(); ++i) {
+    auto& c = m_Nodes[i].counts;
+
+    c.files += d.counts[i].files;
+    c.provided += d.counts[i].provided;
+    c.hidden += d.counts[i].hidden;
+  }
+
+  for (auto&& [e, delta] : d.edges) {
+    if (delta == 0) {
+      continue;
+    }
+
+    auto&& [from, kind, to] = e;
+    auto& n = m_Nodes[static_cast<std::size_t>(from)];
+
+    const auto key = nodeKey(kind, to);
+    auto itor = n.edges.find(key);
+
+    if (itor == n.edges.end()) {
+      if (delta < 0) {
+        log::error(
+          "conflict graph: removing {} files from missing edge {}->{}",
+          -delta, from, to);
+
+        continue;
+      }
+
+      n.edges.emplace(key, delta);
+      ++n.counts.neighbours[kind];
+      continue;
+    }
+
+    itor->second += delta;
+
+    if (itor->second <= 0) {
+      n.edges.erase(itor);
+      --n.counts.neighbours[kind];
+    }
+  }
+}
+
+} // namespace
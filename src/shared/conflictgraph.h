@@ -0,0 +1,176 @@
+#ifndef MO_REGISTER_CONFLICTGRAPH_INCLUDED
+#define MO_REGISTER_CONFLICTGRAPH_INCLUDED
+
+#include "fileregisterfwd.h"
+#include "memoryusage.h"
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace MOShared
+{
+
+// conflicts between all the origins of a structure, owned by the FileRegister
+//
+// for every pair of origins that provide the same files, the graph has one
+// edge per kind of conflict with the number of files involved; each origin
+// also has the number of neighbours for each kind, so whether an origin has a
+// given kind of conflict is a single lookup
+//
+// rebuild() computes the whole graph in one parallel pass over all the files,
+// it's called once the structure has been refreshed; when origins are
+// enabled, disabled or moved afterwards, only the files of these origins are
+// visited:
+//
+//   - exclude() must be called before the origins are disabled or before
+//     their priority changes, it removes them from the graph as if they didn't
+//     provide any files,
+//
+//   - include() must be called after the origins have been enabled or after
+//     their priority has changed and the origins of the files have been
+//     sorted, it adds them back
+//
+// origins created after rebuild() are not part of the graph until they're
+// included
+//
+// this only works if the relative priorities of the other origins don't
+// change in between
+//
+// everything here is thread-safe, but updates must not be done concurrently
+// with changes to the structure
+//
+class ConflictGraph
+{
+public:
+  enum Kinds
+  {
+    // loose files of this origin overwrite the loose files of another one
+    Overwrite = 0,
+
+    // loose files of this origin are overwritten by another one's
+    Overwritten,
+
+    // archived files of this origin overwrite the archived files of another
+    // one
+    ArchiveOverwrite,
+
+    // archived files of this origin are overwritten by another one's
+    ArchiveOverwritten,
+
+    // loose files of this origin overwrite the archived files of another one
+    ArchiveLooseOverwrite,
+
+    // archived files of this origin are overwritten by another one's loose
+    // files, or loose files are overwritten by another one's archive
+    ArchiveLooseOverwritten,
+
+    KindCount
+  };
+
+  // conflict state of one origin
+  //
+  struct Counts
+  {
+    // number of files in the origin
+    std::int64_t files = 0;
+
+    // number of files for which this origin is used, either because no other
+    // origin has them or because it has the highest priority
+    std::int64_t provided = 0;
+
+    // number of files that are hidden or in a hidden directory
+    std::int64_t hidden = 0;
+
+    // number of origins this one is in conflict with, for each kind
+    std::array<std::int64_t, KindCount> neighbours = {};
+  };
+
+  ConflictGraph(FileRegister& files, OriginConnection& origins);
+
+  // noncopyable
+  ConflictGraph(const ConflictGraph&) = delete;
+  ConflictGraph& operator=(const ConflictGraph&) = delete;
+
+  // recomputes the graph for all the files of the structure; files with the
+  // given extension, or in directories with it, are counted as hidden, which
+  // is remembered for later updates
+  //
+  void rebuild(std::wstring hiddenExt);
+
+  // removes the given origins from the graph, see the class comment; origins
+  // that are not part of the graph are ignored
+  //
+  void exclude(const std::vector<OriginID>& origins);
+
+  // adds the given origins to the graph, see the class comment; origins that
+  // are already part of the graph are ignored
+  //
+  void include(const std::vector<OriginID>& origins);
+
+  // conflict state of the given origin, empty if it has no files
+  //
+  Counts counts(OriginID origin) const;
+
+  // origins the given one is in conflict with, for the given kind
+  //
+  std::vector<OriginID> neighbours(OriginID origin, Kinds kind) const;
+
+  // incremented every time the graph changes, can be used to invalidate
+  // anything that was built from it
+  //
+  std::uint64_t generation() const;
+
+  // estimated memory used by the nodes and their edges; the count is the
+  // number of edges
+  //
+  MemoryUsage memoryUsage() const;
+
+private:
+  struct Delta;
+  struct Context;
+
+  struct Node
+  {
+    Counts counts;
+
+    // number of files for each neighbour and kind, see nodeKey()
+    std::unordered_map<std::uint64_t, std::int64_t> edges;
+  };
+
+  FileRegister& m_Files;
+  OriginConnection& m_Origins;
+  std::wstring m_HiddenExt;
+
+  std::vector<Node> m_Nodes;
+
+  // origins that are part of the graph, indexed by origin id; origins that
+  // were excluded or created after rebuild() are not
+  std::vector<bool> m_Included;
+  std::uint64_t m_Generation;
+  mutable std::mutex m_Mutex;
+
+  // for each of the given files, or all the files if null, subtracts what
+  // the file contributes with the origins that are currently included and
+  // adds what it contributes with the given ones, which then become the
+  // included origins; files are split in chunks processed in parallel
+  //
+  void update(
+    const std::vector<FileIndex>* files, const std::vector<bool>& included);
+
+  std::vector<bool> includedOrigins() const;
+
+  // indices of all the files of the given origins, without duplicates
+  //
+  std::vector<FileIndex> filesOf(const std::vector<OriginID>& origins) const;
+
+  static void addFile(
+    const Context& cx, Delta& d, FileEntryPtr file,
+    const std::vector<bool>& included, int sign);
+
+  void apply(const Delta& d);
+};
+
+} // namespace
+
+#endif // MO_REGISTER_CONFLICTGRAPH_INCLUDED
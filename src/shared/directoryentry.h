@@ -1,321 +1,583 @@
-/*
-Copyright (C) 2012 Sebastian Herbord. All rights reserved.
-
-This file is part of Mod Organizer.
-
-Mod Organizer is free software: you can redistribute it and/or modify
-it under the terms of the GNU General Public License as published by
-the Free Software Foundation, either version 3 of the License, or
-(at your option) any later version.
-
-Mod Organizer is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#ifndef MO_REGISTER_DIRECTORYENTRY_INCLUDED
-#define MO_REGISTER_DIRECTORYENTRY_INCLUDED
-
-#include "fileregister.h"
-#include <bsatk.h>
-
-namespace env
-{
-  class DirectoryWalker;
-  struct Directory;
-  struct File;
-}
-
-namespace std
-{
-  template <>
-  struct hash<MOShared::DirectoryEntryFileKey>
-  {
-    using argument_type = MOShared::DirectoryEntryFileKey;
-    using result_type = std::size_t;
-
-    inline result_type operator()(const argument_type& key) const;
-  };
-}
-
-
-namespace MOShared
-{
-
-struct DirCompareByName
-{
-    bool operator()(const DirectoryEntry* a, const DirectoryEntry* b) const;
-};
-
-
-class DirectoryEntry
-{
-public:
-    using SubDirectories = std::set<DirectoryEntry*, DirCompareByName>;
-
-    DirectoryEntry(
-    std::wstring name, DirectoryEntry* parent, OriginID originID);
-
-  DirectoryEntry(
-    std::wstring name, DirectoryEntry* parent, OriginID originID,
-    boost::shared_ptr<FileRegister> fileRegister,
-    boost::shared_ptr<OriginConnection> originConnection);
-
-  ~DirectoryEntry();
-
-  // noncopyable
-  DirectoryEntry(const DirectoryEntry&) = delete;
-  DirectoryEntry& operator=(const DirectoryEntry&) = delete;
-
-  void clear();
-
-  bool isPopulated() const
-  {
-    return m_Populated;
-  }
-
-  bool isTopLevel() const
-  {
-    return m_TopLevel;
-  }
-
-  bool isEmpty() const
-  {
-    return m_Files.empty() && m_SubDirectories.empty();
-  }
-
-  bool hasFiles() const
-  {
-    return !m_Files.empty();
-  }
-
-  const DirectoryEntry* getParent() const
-  {
-    return m_Parent;
-  }
-
-  // add files to this directory (and subdirectories) from the specified origin.
-  // That origin may exist or not
-  void addFromOrigin(
-    const std::wstring& originName,
-    const std::wstring& directory, int priority, DirectoryStats& stats);
-
-  void addFromOrigin(
-    env::DirectoryWalker& walker, const std::wstring& originName,
-    const std::wstring& directory, int priority, DirectoryStats& stats);
-
-  void addFromAllBSAs(
-    const std::wstring& originName, const std::wstring& directory,
-    int priority, const std::vector<std::wstring>& archives,
-    const std::set<std::wstring>& enabledArchives,
-    const std::vector<std::wstring>& loadOrder,
-    DirectoryStats& stats);
-
-  void addFromBSA(
-    const std::wstring& originName, const std::wstring& directory,
-    const std::wstring& archivePath, int priority, int order,
-    DirectoryStats& stats);
-
-  void addFromList(
-    const std::wstring& originName, const std::wstring& directory,
-    env::Directory& root, int priority, DirectoryStats& stats);
-
-  void propagateOrigin(OriginID origin);
-
-  const std::wstring& getName() const
-  {
-    return m_Name;
-  }
-
-  boost::shared_ptr<FileRegister> getFileRegister()
-  {
-    return m_FileRegister;
-  }
-
-  bool originExists(const std::wstring& name) const;
-  FilesOrigin& getOriginByID(OriginID ID) const;
-  FilesOrigin& getOriginByName(const std::wstring& name) const;
-  const FilesOrigin* findOriginByID(OriginID ID) const;
-
-  OriginID anyOrigin() const;
-
-  std::vector<FileEntryPtr> getFiles() const;
-
-  const SubDirectories& getSubDirectories() const
-  {
-    return m_SubDirectories;
-  }
-
-  template <class F>
-  void forEachDirectory(F&& f) const
-  {
-    for (auto&& d : m_SubDirectories) {
-      if (!f(*d)) {
-        break;
-      }
-    }
-  }
-
-  template <class F>
-  void forEachFile(F&& f) const
-  {
-    for (auto&& p : m_Files) {
-      if (auto file=m_FileRegister->getFile(p.second)) {
-        if (!f(*file)) {
-          break;
-        }
-      }
-    }
-  }
-
-  template <class F>
-  void forEachFileIndex(F&& f) const
-  {
-    for (auto&& p : m_Files) {
-      if (!f(p.second)) {
-        break;
-      }
-    }
-  }
-
-  FileEntryPtr getFileByIndex(FileIndex index) const
-  {
-    return m_FileRegister->getFile(index);
-  }
-
-  DirectoryEntry* findSubDirectory(
-    const std::wstring& name, bool alreadyLowerCase=false) const;
-
-  DirectoryEntry* findSubDirectoryRecursive(const std::wstring& path);
-
-  /** retrieve a file in this directory by name.
-    * @param name name of the file
-    * @return fileentry object for the file or nullptr if no file matches
-    */
-  const FileEntryPtr findFile(const std::wstring& name, bool alreadyLowerCase=false) const;
-  const FileEntryPtr findFile(const DirectoryEntryFileKey& key) const;
-
-  bool hasFile(const std::wstring& name) const;
-  bool containsArchive(std::wstring archiveName);
-
-  // search through this directory and all subdirectories for a file by the
-  // specified name (relative path).
-  //
-  // if directory is not nullptr, the referenced variable will be set to the
-  // path containing the file
-  //
-  const FileEntryPtr searchFile(
-    const std::wstring& path, const DirectoryEntry** directory=nullptr) const;
-
-  void removeFile(FileIndex index);
-
-  // remove the specified file from the tree. This can be a path leading to a
-  // file in a subdirectory
-  bool removeFile(const std::wstring& filePath, OriginID* origin = nullptr);
-
-  /**
-   * @brief remove the specified directory
-   * @param path directory to remove
-   */
-  void removeDir(const std::wstring& path);
-
-  bool remove(const std::wstring& fileName, OriginID* origin);
-
-  bool hasContentsFromOrigin(OriginID originID) const;
-
-  FilesOrigin& createOrigin(
-    const std::wstring& originName,
-    const std::wstring& directory, int priority, DirectoryStats& stats);
-
-  void removeFiles(const std::set<FileIndex>& indices);
-
-  void dump(const std::wstring& file) const;
-
-private:
-  using FilesMap = std::map<std::wstring, FileIndex>;
-  using FilesLookup = std::unordered_map<DirectoryEntryFileKey, FileIndex>;
-  using SubDirectoriesLookup = std::unordered_map<std::wstring, DirectoryEntry*>;
-
-  boost::shared_ptr<FileRegister> m_FileRegister;
-  boost::shared_ptr<OriginConnection> m_OriginConnection;
-
-  std::wstring m_Name;
-  FilesMap m_Files;
-  FilesLookup m_FilesLookup;
-  SubDirectories m_SubDirectories;
-  SubDirectoriesLookup m_SubDirectoriesLookup;
-
-  DirectoryEntry* m_Parent;
-  std::set<OriginID> m_Origins;
-  bool m_Populated;
-  bool m_TopLevel;
-  mutable std::mutex m_SubDirMutex;
-  mutable std::mutex m_FilesMutex;
-  mutable std::mutex m_OriginsMutex;
-
-
-  FileEntryPtr insert(
-    std::wstring_view fileName, FilesOrigin& origin, FILETIME fileTime,
-    std::wstring_view archive, int order, DirectoryStats& stats);
-
-  FileEntryPtr insert(
-    env::File& file, FilesOrigin& origin,
-    std::wstring_view archive, int order, DirectoryStats& stats);
-
-  void addFiles(
-    env::DirectoryWalker& walker, FilesOrigin& origin,
-    const std::wstring& path, DirectoryStats& stats);
-
-  void addFiles(
-    FilesOrigin& origin, BSA::Folder::Ptr archiveFolder, FILETIME fileTime,
-    const std::wstring& archiveName, int order, DirectoryStats& stats);
-
-  void addDir(FilesOrigin& origin, env::Directory& d, DirectoryStats& stats);
-
-  DirectoryEntry* getSubDirectory(
-    std::wstring_view name, bool create, DirectoryStats& stats,
-    OriginID originID = InvalidOriginID);
-
-  DirectoryEntry* getSubDirectory(
-    env::Directory& dir, bool create, DirectoryStats& stats,
-    OriginID originID = InvalidOriginID);
-
-  DirectoryEntry* getSubDirectoryRecursive(
-    const std::wstring& path, bool create, DirectoryStats& stats,
-    OriginID originID = InvalidOriginID);
-
-  void removeDirRecursive();
-
-  void addDirectoryToList(DirectoryEntry* e, std::wstring nameLc);
-  void removeDirectoryFromList(SubDirectories::iterator itor);
-
-  void addFileToList(std::wstring fileNameLower, FileIndex index);
-  void removeFileFromList(FileIndex index);
-  void removeFilesFromList(const std::set<FileIndex>& indices);
-
-  struct Context;
-  static void onDirectoryStart(Context* cx, std::wstring_view path);
-  static void onDirectoryEnd(Context* cx, std::wstring_view path);
-  static void onFile(Context* cx, std::wstring_view path, FILETIME ft);
-
-  void dump(std::FILE* f, const std::wstring& parentPath) const;
-};
-
-} // namespace MOShared
-
-
-namespace std
-{
-  hash<MOShared::DirectoryEntryFileKey>::result_type
-  hash<MOShared::DirectoryEntryFileKey>::operator()(
-    const argument_type& key) const
-  {
-    return key.hash;
-  }
-}
-
-#endif // MO_REGISTER_DIRECTORYENTRY_INCLUDED
+/*
+Copyright (C) 2012 Sebastian Herbord. All rights reserved.
+
+This file is part of Mod Organizer.
+
+Mod Organizer is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Mod Organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MO_REGISTER_DIRECTORYENTRY_INCLUDED
+#define MO_REGISTER_DIRECTORYENTRY_INCLUDED
+
+#include "fileregister.h"
+#include "archiveindex.h"
+
+namespace env
+{
+  class DirectoryWalker;
+  struct Directory;
+  struct File;
+}
+
+namespace std
+{
+  template <>
+  struct hash<MOShared::DirectoryEntryFileKey>
+  {
+    using argument_type = MOShared::DirectoryEntryFileKey;
+    using result_type = std::size_t;
+
+    inline result_type operator()(const argument_type& key) const;
+  };
+}
+
+
+namespace MOShared
+{
+
+struct DirCompareByName
+{
+    bool operator()(const DirectoryEntry* a, const DirectoryEntry* b) const;
+};
+
+
+// a file walked by DirectoryEntry::walkOrigin(), names are stored in the name
+// arena of the structure
+//
+struct WalkedFile
+{
+  std::wstring_view name;
+  std::wstring_view lcname;
+  FILETIME lastModified;
+  uint64_t size;
+};
+
+// a directory tree walked by DirectoryEntry::walkOrigin(), built by a single
+// thread without touching the structure
+//
+struct WalkedDirectory
+{
+  std::wstring name;
+  std::vector<WalkedDirectory> dirs;
+  std::vector<WalkedFile> files;
+};
+
+
+class DirectoryEntry
+{
+public:
+    using SubDirectories = std::set<DirectoryEntry*, DirCompareByName>;
+
+  using WalkedFile = MOShared::WalkedFile;
+  using WalkedDirectory = MOShared::WalkedDirectory;
+
+  // a walked directory and the origin it came from
+  //
+  struct MergeSource
+  {
+    FilesOrigin* origin;
+    const WalkedDirectory* dir;
+  };
+
+  using MergeSources = std::vector<MergeSource>;
+
+  // a directory and the walked directories that must be merged into it
+  //
+  struct MergeTask
+  {
+    DirectoryEntry* target;
+    MergeSources sources;
+  };
+
+    DirectoryEntry(
+    std::wstring name, DirectoryEntry* parent, OriginID originID);
+
+  DirectoryEntry(
+    std::wstring name, DirectoryEntry* parent, OriginID originID,
+    boost::shared_ptr<FileRegister> fileRegister,
+    boost::shared_ptr<OriginConnection> originConnection);
+
+  ~DirectoryEntry();
+
+  // noncopyable
+  DirectoryEntry(const DirectoryEntry&) = delete;
+  DirectoryEntry& operator=(const DirectoryEntry&) = delete;
+
+  void clear();
+
+  bool isPopulated() const
+  {
+    return m_Populated;
+  }
+
+  bool isTopLevel() const
+  {
+    return m_TopLevel;
+  }
+
+  bool isEmpty() const
+  {
+    return m_Files.empty() && m_SubDirectories.empty();
+  }
+
+  bool hasFiles() const
+  {
+    return !m_Files.empty();
+  }
+
+  const DirectoryEntry* getParent() const
+  {
+    return m_Parent;
+  }
+
+  // add files to this directory (and subdirectories) from the specified origin.
+  // That origin may exist or not
+  void addFromOrigin(
+    const std::wstring& originName,
+    const std::wstring& directory, int priority, DirectoryStats& stats);
+
+  void addFromOrigin(
+    env::DirectoryWalker& walker, const std::wstring& originName,
+    const std::wstring& directory, int priority, DirectoryStats& stats);
+
+  void addFromAllBSAs(
+    const std::wstring& originName, const std::wstring& directory,
+    int priority, const std::vector<std::wstring>& archives,
+    const std::set<std::wstring>& enabledArchives,
+    const std::vector<std::wstring>& loadOrder,
+    DirectoryStats& stats);
+
+  void addFromBSA(
+    const std::wstring& originName, const std::wstring& directory,
+    const std::wstring& archivePath, int priority, int order,
+    DirectoryStats& stats);
+
+  // position in the load order of the plugin that loads the given archive,
+  // -1 if none does
+  //
+  static int archiveOrder(
+    const std::wstring& archiveName, const std::vector<std::wstring>& loadOrder);
+
+  // same as addFromBSA(), but with the contents of an archive that has
+  // already been read, such as from a recorded refresh
+  //
+  void addFromArchive(
+    const std::wstring& originName, const std::wstring& directory,
+    const std::wstring& archiveName, const ArchiveIndex::Folder& root,
+    FILETIME lastModified, int priority, int order, DirectoryStats& stats);
+
+  void addFromList(
+    const std::wstring& originName, const std::wstring& directory,
+    env::Directory& root, int priority, DirectoryStats& stats);
+
+  // creates the origin and walks the given directory into a standalone tree
+  // that can be merged into the structure later with merge(); this only locks
+  // the structure to create the origin and when a name page is full, so it
+  // scales with the number of threads walking mods
+  //
+  FilesOrigin& walkOrigin(
+    env::DirectoryWalker& walker, NameArena::Local& names,
+    const std::wstring& originName, const std::wstring& directory,
+    int priority, WalkedDirectory& out, DirectoryStats& stats);
+
+  // adds the files of the given walked directories to this directory, in
+  // order, and creates the subdirectories; returns one task per subdirectory
+  //
+  // tasks are disjoint, they can be merged in parallel with
+  // mergeRecursive() without contending on the same directories
+  //
+  std::vector<MergeTask> merge(
+    const MergeSources& sources, DirectoryStats& stats);
+
+  // merges the given walked directories into this directory and all its
+  // subdirectories
+  //
+  void mergeRecursive(const MergeSources& sources, DirectoryStats& stats);
+
+  void propagateOrigin(OriginID origin);
+
+  const std::wstring& getName() const
+  {
+    return m_Name;
+  }
+
+  // path of this directory relative to the data root, built once when the
+  // directory is created; starts with a backslash and is empty for the root
+  //
+  const std::wstring& getRelativePath() const
+  {
+    return m_RelativePath;
+  }
+
+  boost::shared_ptr<FileRegister> getFileRegister()
+  {
+    return m_FileRegister;
+  }
+
+  boost::shared_ptr<OriginConnection> getOriginConnection()
+  {
+    return m_OriginConnection;
+  }
+
+  bool originExists(const std::wstring& name) const;
+  FilesOrigin& getOriginByID(OriginID ID) const;
+  FilesOrigin& getOriginByName(const std::wstring& name) const;
+  const FilesOrigin* findOriginByID(OriginID ID) const;
+
+  OriginID anyOrigin() const;
+
+  std::vector<FileEntryPtr> getFiles() const;
+
+  const SubDirectories& getSubDirectories() const
+  {
+    return m_SubDirectories;
+  }
+
+  template <class F>
+  void forEachDirectory(F&& f) const
+  {
+    for (auto&& d : m_SubDirectories) {
+      if (!f(*d)) {
+        break;
+      }
+    }
+  }
+
+  template <class F>
+  void forEachFile(F&& f) const
+  {
+    for (auto&& p : m_Files) {
+      if (auto file=m_FileRegister->getFile(p.second)) {
+        if (!f(*file)) {
+          break;
+        }
+      }
+    }
+  }
+
+  template <class F>
+  void forEachFileIndex(F&& f) const
+  {
+    for (auto&& p : m_Files) {
+      if (!f(p.second)) {
+        break;
+      }
+    }
+  }
+
+  FileEntryPtr getFileByIndex(FileIndex index) const
+  {
+    return m_FileRegister->getFile(index);
+  }
+
+  DirectoryEntry* findSubDirectory(
+    const std::wstring& name, bool alreadyLowerCase=false) const;
+
+  DirectoryEntry* findSubDirectoryRecursive(const std::wstring& path);
+
+  /** retrieve a file in this directory by name.
+    * @param name name of the file
+    * @return fileentry object for the file or nullptr if no file matches
+    */
+  const FileEntryPtr findFile(const std::wstring& name, bool alreadyLowerCase=false) const;
+  const FileEntryPtr findFile(const DirectoryEntryFileKey& key) const;
+
+  bool hasFile(const std::wstring& name) const;
+  bool containsArchive(std::wstring archiveName);
+
+  // search through this directory and all subdirectories for a file by the
+  // specified name (relative path).
+  //
+  // if directory is not nullptr, the referenced variable will be set to the
+  // path containing the file
+  //
+  const FileEntryPtr searchFile(
+    const std::wstring& path, const DirectoryEntry** directory=nullptr) const;
+
+  void removeFile(FileIndex index);
+
+  // remove the specified file from the tree. This can be a path leading to a
+  // file in a subdirectory
+  bool removeFile(const std::wstring& filePath, OriginID* origin = nullptr);
+
+  /**
+   * @brief remove the specified directory
+   * @param path directory to remove
+   */
+  void removeDir(const std::wstring& path);
+
+  bool remove(const std::wstring& fileName, OriginID* origin);
+
+  // the file at the given path, relative to this directory, has been renamed
+  // to `newName` on disk in the given origin, such as when hiding it; the
+  // origin is removed from the entry of the old name and added to the entry
+  // of the new name, which is created if needed; returns false if the origin
+  // doesn't have the file
+  //
+  // the origins of the new entry are sorted, but the conflict graph is not
+  // updated, see ConflictGraph
+  //
+  bool renameFile(
+    const std::wstring& filePath, const std::wstring& newName,
+    FilesOrigin& origin);
+
+  bool hasContentsFromOrigin(OriginID originID) const;
+
+  // total size in bytes of the files in this directory and its
+  // subdirectories, as provided by their primary origin; files whose size is
+  // not known, like the ones added by programs while running, are ignored
+  //
+  uint64_t filesSize() const;
+
+  FilesOrigin& createOrigin(
+    const std::wstring& originName,
+    const std::wstring& directory, int priority, DirectoryStats& stats);
+
+  // `indices` must be sorted
+  //
+  void removeFiles(const std::vector<FileIndex>& indices);
+
+  // writes the path and origin of every loose file in this directory and its
+  // subdirectories to the given file, one line per file; directories are
+  // formatted in parallel in batches and written in order, so the memory
+  // used doesn't depend on the size of the structure; returns false on
+  // failure, which has been logged
+  //
+  bool dump(const std::wstring& file) const;
+
+  // estimated memory used by this directory and its subdirectories, without
+  // the rows and the names of their files, which are in the FileRegister;
+  // the count is the number of directories
+  //
+  MemoryUsage memoryUsage() const;
+
+  // writes the estimated memory used by each directory to the given file,
+  // one tab-separated line per directory with its path, the number of files
+  // directly in it, the bytes used by the directory and its files, and the
+  // bytes used along with its subdirectories
+  //
+  void dumpMemory(const std::wstring& file) const;
+
+private:
+  friend class DirectorySnapshot;
+  friend class StructureBenchmark;
+
+  // keys for both maps are lowercase names stored in the FileRegister's name
+  // arena, they're shared between the two maps
+  //
+  // the hash doesn't depend on case, so lookups can use a key made with
+  // anyCase() from a name as given by the caller instead of a lowercase copy
+  //
+  struct FileKey
+  {
+    std::wstring_view value;
+    std::size_t hash;
+
+    // whether value is known to be lowercase, keys that are not are compared
+    // case-insensitively
+    bool lowercase = true;
+
+    FileKey(std::wstring_view v)
+      : value(v), hash(DirectoryEntryFileKey::getHash(v))
+    {
+    }
+
+    FileKey(std::wstring_view v, std::size_t h)
+      : value(v), hash(h)
+    {
+    }
+
+    static FileKey anyCase(std::wstring_view v)
+    {
+      FileKey k(v);
+      k.lowercase = false;
+      return k;
+    }
+
+    bool operator==(const FileKey& o) const
+    {
+      if (lowercase && o.lowercase) {
+        return (value == o.value);
+      }
+
+      return DirectoryEntryFileKey::equalsFolded(value, o.value);
+    }
+  };
+
+  struct FileKeyHash
+  {
+    std::size_t operator()(const FileKey& key) const
+    {
+      return key.hash;
+    }
+  };
+
+  using FilesMap = std::map<std::wstring_view, FileIndex>;
+  using FilesLookup = std::unordered_map<FileKey, FileIndex, FileKeyHash>;
+
+  // the subdirectories are stored by lowercase name, but can also be found
+  // with a FileKey
+  //
+  struct SubDirectoryHash
+  {
+    using is_transparent = void;
+
+    std::size_t operator()(const std::wstring& name) const
+    {
+      return DirectoryEntryFileKey::getHash(name);
+    }
+
+    std::size_t operator()(const FileKey& key) const
+    {
+      return key.hash;
+    }
+  };
+
+  struct SubDirectoryEqual
+  {
+    using is_transparent = void;
+
+    bool operator()(const std::wstring& a, const std::wstring& b) const
+    {
+      return (a == b);
+    }
+
+    bool operator()(const std::wstring& a, const FileKey& b) const
+    {
+      return (FileKey(a, b.hash) == b);
+    }
+
+    bool operator()(const FileKey& a, const std::wstring& b) const
+    {
+      return (a == FileKey(b, a.hash));
+    }
+  };
+
+  using SubDirectoriesLookup = std::unordered_map<
+    std::wstring, DirectoryEntry*, SubDirectoryHash, SubDirectoryEqual>;
+
+  boost::shared_ptr<FileRegister> m_FileRegister;
+  boost::shared_ptr<OriginConnection> m_OriginConnection;
+
+  std::wstring m_Name;
+  std::wstring m_RelativePath;
+  FilesMap m_Files;
+  FilesLookup m_FilesLookup;
+  SubDirectories m_SubDirectories;
+  SubDirectoriesLookup m_SubDirectoriesLookup;
+
+  DirectoryEntry* m_Parent;
+  std::set<OriginID> m_Origins;
+  bool m_Populated;
+  bool m_TopLevel;
+  mutable std::mutex m_SubDirMutex;
+  mutable std::mutex m_FilesMutex;
+  mutable std::mutex m_OriginsMutex;
+
+
+  FileEntryPtr insert(
+    std::wstring_view fileName, FilesOrigin& origin, FILETIME fileTime,
+    const DataArchiveOrigin& archive, uint64_t size, uint64_t compressedSize,
+    DirectoryStats& stats);
+
+  FileEntryPtr insert(
+    env::File& file, FilesOrigin& origin,
+    const DataArchiveOrigin& archive, DirectoryStats& stats);
+
+  // the names are already stored in the name arena; the file is not added to
+  // the origin, merge() adds all the files of a directory at once
+  //
+  FileEntryPtr insert(
+    const WalkedFile& file, FilesOrigin& origin, DirectoryStats& stats);
+
+  void addFiles(
+    env::DirectoryWalker& walker, FilesOrigin& origin,
+    const std::wstring& path, DirectoryStats& stats);
+
+  void addFiles(
+    FilesOrigin& origin, const ArchiveIndex::Folder& archiveFolder,
+    FILETIME fileTime, const DataArchiveOrigin& archive, DirectoryStats& stats);
+
+  void addDir(FilesOrigin& origin, env::Directory& d, DirectoryStats& stats);
+
+  DirectoryEntry* getSubDirectory(
+    std::wstring_view name, bool create, DirectoryStats& stats,
+    OriginID originID = InvalidOriginID);
+
+  DirectoryEntry* getSubDirectory(
+    env::Directory& dir, bool create, DirectoryStats& stats,
+    OriginID originID = InvalidOriginID);
+
+  DirectoryEntry* getSubDirectoryRecursive(
+    const std::wstring& path, bool create, DirectoryStats& stats,
+    OriginID originID = InvalidOriginID);
+
+  void removeDirRecursive();
+
+  void addDirectoryToList(DirectoryEntry* e, std::wstring nameLc);
+  void removeDirectoryFromList(SubDirectories::iterator itor);
+
+  void addFileToList(FileKey key, FileIndex index);
+  void removeFileFromList(FileIndex index);
+  void removeFilesFromList(const std::vector<FileIndex>& indices);
+
+  struct Context;
+  static void onDirectoryStart(
+    Context* cx, std::wstring_view path, FILETIME ft);
+  static void onDirectoryEnd(Context* cx, std::wstring_view path);
+  static void onFile(
+    Context* cx, std::wstring_view path, FILETIME ft, uint64_t size);
+
+  struct WalkContext;
+  static void onWalkDirectoryStart(
+    WalkContext* cx, std::wstring_view path, FILETIME ft);
+  static void onWalkDirectoryEnd(WalkContext* cx, std::wstring_view path);
+  static void onWalkFile(
+    WalkContext* cx, std::wstring_view path, FILETIME ft, uint64_t size);
+
+  // appends the lines of the files directly in this directory, given its
+  // path as utf-8 and the utf-8 names of all the origins by id
+  //
+  void dumpFiles(
+    std::string& out, const std::string& path,
+    const std::vector<std::string>& origins) const;
+
+  struct MemoryLine;
+
+  // bytes used by this directory only, with the rows and the names of its
+  // files if `withFiles` is true
+  //
+  std::size_t ownMemory(bool withFiles) const;
+
+  // appends a line for this directory and its subdirectories, returns the
+  // bytes used by all of them
+  //
+  std::size_t memoryLines(
+    std::vector<MemoryLine>& lines, const std::wstring& path) const;
+};
+
+} // namespace MOShared
+
+
+namespace std
+{
+  hash<MOShared::DirectoryEntryFileKey>::result_type
+  hash<MOShared::DirectoryEntryFileKey>::operator()(
+    const argument_type& key) const
+  {
+    return key.hash;
+  }
+}
+
+#endif // MO_REGISTER_DIRECTORYENTRY_INCLUDED
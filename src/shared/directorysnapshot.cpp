@@ -0,0 +1,507 @@
+#include "directorysnapshot.h"
+#include "directoryentry.h"
+#include "fileentry.h"
+#include "filesorigin.h"
+#include "originconnection.h"
+#include "util.h"
+#include "../metrics.h"
+#include <log.h>
+#include <utility.h>
+#include <QFile>
+
+namespace MOShared
+{
+
+using namespace MOBase;
+
+// "MOSS", little endian
+constexpr std::uint32_t SnapshotMagic = 0x53534F4D;
+
+// must be incremented every time the format changes, older snapshots are
+// ignored
+constexpr std::uint32_t SnapshotVersion = 2;
+
+struct SnapshotError : public std::runtime_error
+{
+  using runtime_error::runtime_error;
+};
+
+
+class DirectorySnapshot::Writer
+{
+public:
+  Writer(std::FILE* f)
+    : m_file(f)
+  {
+    m_buffer.reserve(BufferSize);
+  }
+
+  void u8(std::uint8_t v)
+  {
+    raw(&v, sizeof(v));
+  }
+
+  void u32(std::uint32_t v)
+  {
+    raw(&v, sizeof(v));
+  }
+
+  void i32(std::int32_t v)
+  {
+    raw(&v, sizeof(v));
+  }
+
+  void u64(std::uint64_t v)
+  {
+    raw(&v, sizeof(v));
+  }
+
+  void time(const FILETIME& ft)
+  {
+    u32(ft.dwLowDateTime);
+    u32(ft.dwHighDateTime);
+  }
+
+  void str(std::wstring_view s)
+  {
+    u32(static_cast<std::uint32_t>(s.size()));
+    raw(s.data(), s.size() * sizeof(wchar_t));
+  }
+
+  void origin(const FilesOrigin& o)
+  {
+    i32(o.getID());
+    str(o.getName());
+    str(o.getPath());
+    i32(o.getPriority());
+    u8(o.isDisabled() ? 1 : 0);
+
+    std::scoped_lock lock(o.m_Mutex);
+
+    u32(static_cast<std::uint32_t>(o.m_DirectoryStamps.size()));
+    for (const auto& stamp : o.m_DirectoryStamps) {
+      str(stamp.path);
+      time(stamp.lastModified);
+    }
+
+    u64(o.m_LooseSize);
+  }
+
+  void directory(const DirectoryEntry& d)
+  {
+    u8(d.m_Populated ? 1 : 0);
+
+    {
+      std::scoped_lock lock(d.m_OriginsMutex);
+
+      u32(static_cast<std::uint32_t>(d.m_Origins.size()));
+      for (OriginID id : d.m_Origins) {
+        i32(id);
+      }
+    }
+
+    std::vector<FileEntryPtr> files;
+
+    {
+      std::scoped_lock lock(d.m_FilesMutex);
+
+      files.reserve(d.m_Files.size());
+      for (auto&& p : d.m_Files) {
+        if (auto f=d.m_FileRegister->getFile(p.second)) {
+          files.push_back(f);
+        }
+      }
+    }
+
+    u32(static_cast<std::uint32_t>(files.size()));
+    for (const auto& f : files) {
+      file(*f);
+    }
+
+    std::scoped_lock lock(d.m_SubDirMutex);
+
+    u32(static_cast<std::uint32_t>(d.m_SubDirectories.size()));
+    for (const auto* sd : d.m_SubDirectories) {
+      str(sd->getName());
+      directory(*sd);
+    }
+  }
+
+  void file(const FileEntry& f)
+  {
+    const auto alternatives = f.getAlternatives();
+
+    str(f.getName());
+    i32(f.getOrigin());
+    str(f.getArchive().name());
+    i32(f.getArchive().order());
+    time(f.getFileTime());
+    u64(f.getFileSize());
+    u64(f.getCompressedFileSize());
+
+    u32(static_cast<std::uint32_t>(alternatives.size()));
+    for (const auto& alt : alternatives) {
+      i32(alt.originID());
+      const auto& archive = f.getArchive(alt);
+      str(archive.name());
+      i32(archive.order());
+    }
+  }
+
+  void flush()
+  {
+    if (m_buffer.empty()) {
+      return;
+    }
+
+    if (std::fwrite(m_buffer.data(), m_buffer.size(), 1, m_file) != 1) {
+      const auto e = errno;
+      throw SnapshotError(fmt::format(
+        "failed to write, {} ({})", std::strerror(e), e));
+    }
+
+    m_buffer.clear();
+  }
+
+private:
+  static constexpr std::size_t BufferSize = 4 * 1024 * 1024;
+
+  std::FILE* m_file;
+  std::string m_buffer;
+
+  void raw(const void* p, std::size_t size)
+  {
+    m_buffer.append(static_cast<const char*>(p), size);
+
+    if (m_buffer.size() >= BufferSize) {
+      flush();
+    }
+  }
+};
+
+
+class DirectorySnapshot::Reader
+{
+public:
+  Reader(const uchar* data, qint64 size)
+    : m_p(data), m_end(data + size)
+  {
+  }
+
+  std::uint8_t u8()
+  {
+    std::uint8_t v;
+    raw(&v, sizeof(v));
+    return v;
+  }
+
+  std::uint32_t u32()
+  {
+    std::uint32_t v;
+    raw(&v, sizeof(v));
+    return v;
+  }
+
+  std::int32_t i32()
+  {
+    std::int32_t v;
+    raw(&v, sizeof(v));
+    return v;
+  }
+
+  std::uint64_t u64()
+  {
+    std::uint64_t v;
+    raw(&v, sizeof(v));
+    return v;
+  }
+
+  FILETIME time()
+  {
+    FILETIME ft;
+    ft.dwLowDateTime = u32();
+    ft.dwHighDateTime = u32();
+    return ft;
+  }
+
+  std::wstring str()
+  {
+    const auto length = u32();
+    const auto bytes = static_cast<std::size_t>(length) * sizeof(wchar_t);
+
+    check(bytes);
+
+    std::wstring s(length, L'\0');
+    std::memcpy(s.data(), m_p, bytes);
+    m_p += bytes;
+
+    return s;
+  }
+
+  void origins(DirectoryEntry& root)
+  {
+    const auto count = u32();
+
+    for (std::uint32_t i=0; i<count; ++i) {
+      const OriginID id = i32();
+      const auto name = str();
+      const auto path = str();
+      const int priority = i32();
+      const bool disabled = (u8() != 0);
+
+      DirectoryStats dummy;
+      FilesOrigin& o = root.createOrigin(name, path, priority, dummy);
+
+      // ids are generated sequentially and origins are never removed, so
+      // creating them in the same order gives the same ids
+      if (o.getID() != id) {
+        throw SnapshotError(fmt::format(
+          "origin '{}' has id {}, expected {}", name, o.getID(), id));
+      }
+
+      if (disabled) {
+        o.enable(false);
+      }
+
+      const auto stampCount = u32();
+      std::scoped_lock lock(o.m_Mutex);
+
+      o.m_DirectoryStamps.reserve(stampCount);
+      for (std::uint32_t s=0; s<stampCount; ++s) {
+        auto stampPath = str();
+        const auto ft = time();
+        o.m_DirectoryStamps.push_back({std::move(stampPath), ft});
+      }
+
+      o.m_LooseSize = u64();
+    }
+
+    m_originCount = count;
+  }
+
+  void directory(DirectoryEntry& d)
+  {
+    d.m_Populated = (u8() != 0);
+
+    d.m_Origins.clear();
+    const auto originCount = u32();
+    for (std::uint32_t i=0; i<originCount; ++i) {
+      d.m_Origins.insert(i32());
+    }
+
+    const auto fileCount = u32();
+    for (std::uint32_t i=0; i<fileCount; ++i) {
+      file(d);
+    }
+
+    const auto dirCount = u32();
+    for (std::uint32_t i=0; i<dirCount; ++i) {
+      const auto name = str();
+
+      DirectoryStats dummy;
+      auto* sd = d.getSubDirectory(name, true, dummy, InvalidOriginID);
+
+      directory(*sd);
+    }
+  }
+
+  void file(DirectoryEntry& d)
+  {
+    const auto name = str();
+    const auto lcname = ToLowerCopy(name);
+
+    auto& reg = *d.m_FileRegister;
+
+    const OriginID origin = i32();
+    const auto archiveName = str();
+    const int archiveOrder = i32();
+    const FILETIME ft = time();
+    const auto size = u64();
+    const auto compressedSize = u64();
+
+    AlternativesVector alternatives;
+
+    const auto altCount = u32();
+    alternatives.reserve(altCount);
+
+    for (std::uint32_t i=0; i<altCount; ++i) {
+      const OriginID altOrigin = i32();
+      const auto altArchive = str();
+      const int altOrder = i32();
+
+      alternatives.push_back({
+        checkOrigin(altOrigin), reg.archive(altArchive, altOrder)});
+    }
+
+    DirectoryStats dummy;
+    const auto names = reg.names().store(name, lcname);
+    auto fe = reg.createFile(names.first, &d, dummy);
+    const auto index = fe->getIndex();
+
+    FileTable& table = *fe->m_Table;
+    table.setOrigin(
+      index, checkOrigin(origin), reg.archive(archiveName, archiveOrder).id());
+    table.setFileTime(index, ft);
+    table.setFileSize(index, size, compressedSize);
+    table.setAlternatives(index, alternatives);
+
+    d.addFileToList(DirectoryEntry::FileKey(names.second), index);
+
+    d.getOriginByID(fe->getOrigin()).addFile(index);
+    for (const auto& alt : alternatives) {
+      d.getOriginByID(alt.originID()).addFile(index);
+    }
+  }
+
+  bool atEnd() const
+  {
+    return (m_p == m_end);
+  }
+
+private:
+  const uchar* m_p;
+  const uchar* m_end;
+  std::uint32_t m_originCount = 0;
+
+  void check(std::size_t size) const
+  {
+    if (static_cast<std::size_t>(m_end - m_p) < size) {
+      throw SnapshotError("unexpected end of file");
+    }
+  }
+
+  void raw(void* out, std::size_t size)
+  {
+    check(size);
+    std::memcpy(out, m_p, size);
+    m_p += size;
+  }
+
+  OriginID checkOrigin(OriginID id) const
+  {
+    // getOriginByID() would create a bogus origin for an invalid id
+    if (id < 0 || static_cast<std::uint32_t>(id) >= m_originCount) {
+      throw SnapshotError(fmt::format("invalid origin id {}", id));
+    }
+
+    return id;
+  }
+};
+
+
+bool DirectorySnapshot::write(const DirectoryEntry& root, const std::wstring& path)
+{
+  Metrics::Timer tt("DirectorySnapshot::write()");
+
+  const std::wstring temp = path + L".tmp";
+
+  try
+  {
+    {
+      std::FILE* f = nullptr;
+      auto e = _wfopen_s(&f, temp.c_str(), L"wb");
+
+      if (e != 0 || !f) {
+        throw SnapshotError(fmt::format(
+          "failed to open, {} ({})", std::strerror(e), e));
+      }
+
+      Guard g([&]{ std::fclose(f); });
+
+      Writer w(f);
+
+      w.u32(SnapshotMagic);
+      w.u32(SnapshotVersion);
+
+      std::vector<const FilesOrigin*> origins;
+      root.m_OriginConnection->forEachOrigin([&](const FilesOrigin& o) {
+        origins.push_back(&o);
+      });
+
+      w.u32(static_cast<std::uint32_t>(origins.size()));
+      for (const auto* o : origins) {
+        w.origin(*o);
+      }
+
+      w.directory(root);
+      w.flush();
+    }
+
+    if (!::MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+      const auto e = GetLastError();
+      throw SnapshotError(fmt::format(
+        "failed to rename, {}", formatSystemMessage(e)));
+    }
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to write structure snapshot to '{}': {}", path, e.what());
+    ::DeleteFileW(temp.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+std::unique_ptr<DirectoryEntry> DirectorySnapshot::read(const std::wstring& path)
+{
+  Metrics::Timer tt("DirectorySnapshot::read()");
+
+  QFile file(QString::fromStdWString(path));
+
+  if (!file.exists()) {
+    return {};
+  }
+
+  try
+  {
+    if (!file.open(QIODevice::ReadOnly)) {
+      throw SnapshotError(file.errorString().toStdString());
+    }
+
+    const auto size = file.size();
+    const uchar* data = file.map(0, size);
+
+    if (!data) {
+      throw SnapshotError(file.errorString().toStdString());
+    }
+
+    Guard g([&]{ file.unmap(const_cast<uchar*>(data)); });
+
+    Reader r(data, size);
+
+    if (r.u32() != SnapshotMagic) {
+      throw SnapshotError("not a snapshot");
+    }
+
+    if (const auto v=r.u32(); v != SnapshotVersion) {
+      log::debug(
+        "structure snapshot '{}' has version {}, expected {}, ignoring",
+        path, v, SnapshotVersion);
+
+      return {};
+    }
+
+    auto root = std::make_unique<DirectoryEntry>(L"data", nullptr, 0);
+
+    r.origins(*root);
+    r.directory(*root);
+
+    if (!r.atEnd()) {
+      throw SnapshotError("trailing data");
+    }
+
+    log::debug(
+      "restored {} files from structure snapshot '{}'",
+      root->getFileRegister()->highestCount(), path);
+
+    return root;
+  }
+  catch(std::exception& e)
+  {
+    log::error("failed to read structure snapshot '{}': {}", path, e.what());
+    return {};
+  }
+}
+
+} // namespace
@@ -0,0 +1,38 @@
+#ifndef MO_REGISTER_DIRECTORYSNAPSHOT_INCLUDED
+#define MO_REGISTER_DIRECTORYSNAPSHOT_INCLUDED
+
+#include "fileregisterfwd.h"
+#include <memory>
+
+namespace MOShared
+{
+
+// reads and writes a complete directory structure, including its origins and
+// file register, to a binary file so it can be restored on startup instead of
+// walking every mod again
+//
+// the directory stamps of the origins are part of the snapshot, so a restored
+// structure can be brought up to date with an incremental refresh, which only
+// walks the origins that have changed since the snapshot was written
+//
+class DirectorySnapshot
+{
+public:
+  // writes the structure to the given file, which is replaced atomically;
+  // returns false on failure
+  //
+  static bool write(const DirectoryEntry& root, const std::wstring& path);
+
+  // restores a structure from the given file; returns null if the file
+  // doesn't exist, is corrupted or was written by a different version
+  //
+  static std::unique_ptr<DirectoryEntry> read(const std::wstring& path);
+
+private:
+  class Writer;
+  class Reader;
+};
+
+} // namespace
+
+#endif // MO_REGISTER_DIRECTORYSNAPSHOT_INCLUDED
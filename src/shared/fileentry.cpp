@@ -5,104 +5,106 @@
 namespace MOShared
 {
 
-FileEntry::FileEntry() :
-  m_Index(InvalidFileIndex), m_Name(), m_Origin(-1), m_Parent(nullptr),
-  m_FileSize(NoFileSize), m_CompressedFileSize(NoFileSize)
-{
-}
-
-FileEntry::FileEntry(FileIndex index, std::wstring name, DirectoryEntry *parent) :
-  m_Index(index), m_Name(std::move(name)), m_Origin(-1), m_Archive(L"", -1), m_Parent(parent),
-  m_FileSize(NoFileSize), m_CompressedFileSize(NoFileSize)
-{
-}
-
 void FileEntry::addOrigin(
-  OriginID origin, FILETIME fileTime, std::wstring_view archive, int order)
+  OriginID origin, FILETIME fileTime, const DataArchiveOrigin& archive,
+  uint64_t size, uint64_t compressedSize)
 {
-  std::scoped_lock lock(m_OriginsMutex);
+  std::scoped_lock lock(m_Table->mutex(m_Index));
+
+  DirectoryEntry* parent = getParent();
+  const OriginID current = getOrigin();
 
-  if (m_Parent != nullptr) {
-    m_Parent->propagateOrigin(origin);
+  if (parent != nullptr) {
+    parent->propagateOrigin(origin);
   }
 
-  if (m_Origin == -1) {
+  if (current == -1) {
     // If this file has no previous origin, this mod is now the origin with no
     // alternatives
-    m_Origin = origin;
-    m_FileTime = fileTime;
-    m_Archive = DataArchiveOrigin(std::wstring(archive.begin(), archive.end()), order);
+    m_Table->setOrigin(m_Index, origin, archive.id());
+    m_Table->setFileTime(m_Index, fileTime);
+    m_Table->setFileSize(m_Index, size, compressedSize);
   }
   else if (
-    (m_Parent != nullptr) && (
-    (m_Parent->getOriginByID(origin).getPriority() > m_Parent->getOriginByID(m_Origin).getPriority()) ||
-      (archive.size() == 0 && m_Archive.isValid()))
+    (parent != nullptr) && (
+    (parent->getOriginByID(origin).getPriority() > parent->getOriginByID(current).getPriority()) ||
+      (!archive.isValid() && getArchive().isValid()))
     ) {
     // If this mod has a higher priority than the origin mod OR
     // this mod has a loose file and the origin mod has an archived file,
     // this mod is now the origin and the previous origin is the first alternative
 
+    auto alternatives = m_Table->copyAlternatives(m_Index);
+
     auto itor = std::find_if(
-      m_Alternatives.begin(), m_Alternatives.end(),
-      [&](auto&& i) { return i.originID() == m_Origin; });
+      alternatives.begin(), alternatives.end(),
+      [&](auto&& i) { return i.originID() == current; });
 
-    if (itor == m_Alternatives.end()) {
-      m_Alternatives.push_back({m_Origin, m_Archive});
+    if (itor == alternatives.end()) {
+      alternatives.push_back({current, m_Table->archiveID(m_Index)});
+      m_Table->setAlternatives(m_Index, alternatives);
     }
 
-    m_Origin = origin;
-    m_FileTime = fileTime;
-    m_Archive = DataArchiveOrigin(std::wstring(archive.begin(), archive.end()), order);
+    m_Table->setOrigin(m_Index, origin, archive.id());
+    m_Table->setFileTime(m_Index, fileTime);
+    m_Table->setFileSize(m_Index, size, compressedSize);
   }
   else {
     // This mod is just an alternative
     bool found = false;
 
-    if (m_Origin == origin) {
+    if (current == origin) {
       // already an origin
       return;
     }
 
-    for (auto iter = m_Alternatives.begin(); iter != m_Alternatives.end(); ++iter) {
+    auto alternatives = m_Table->copyAlternatives(m_Index);
+
+    for (auto iter = alternatives.begin(); iter != alternatives.end(); ++iter) {
       if (iter->originID() == origin) {
         // already an origin
         return;
       }
 
-      if ((m_Parent != nullptr) &&
-        (m_Parent->getOriginByID(iter->originID()).getPriority() < m_Parent->getOriginByID(origin).getPriority())) {
-        m_Alternatives.insert(iter, {origin, {std::wstring(archive.begin(), archive.end()), order}});
+      if ((parent != nullptr) &&
+        (parent->getOriginByID(iter->originID()).getPriority() < parent->getOriginByID(origin).getPriority())) {
+        alternatives.insert(iter, {origin, archive});
         found = true;
         break;
       }
     }
 
     if (!found) {
-      m_Alternatives.push_back({origin, {std::wstring(archive.begin(), archive.end()), order}});
+      alternatives.push_back({origin, archive});
     }
+
+    m_Table->setAlternatives(m_Index, alternatives);
   }
 }
 
 bool FileEntry::removeOrigin(OriginID origin)
 {
-  std::scoped_lock lock(m_OriginsMutex);
+  std::scoped_lock lock(m_Table->mutex(m_Index));
 
-  if (m_Origin == origin) {
-    if (!m_Alternatives.empty()) {
+  DirectoryEntry* parent = getParent();
+  auto alternatives = m_Table->copyAlternatives(m_Index);
+
+  if (getOrigin() == origin) {
+    if (!alternatives.empty()) {
       // find alternative with the highest priority
-      auto currentIter = m_Alternatives.begin();
-      for (auto iter = m_Alternatives.begin(); iter != m_Alternatives.end(); ++iter) {
+      auto currentIter = alternatives.begin();
+      for (auto iter = alternatives.begin(); iter != alternatives.end(); ++iter) {
         if (iter->originID() != origin) {
           //Both files are not from archives.
           if (!iter->isFromArchive() && !currentIter->isFromArchive()) {
-            if ((m_Parent->getOriginByID(iter->originID()).getPriority() > m_Parent->getOriginByID(currentIter->originID()).getPriority())) {
+            if ((parent->getOriginByID(iter->originID()).getPriority() > parent->getOriginByID(currentIter->originID()).getPriority())) {
               currentIter = iter;
             }
           }
           else {
             //Both files are from archives
             if (iter->isFromArchive() && currentIter->isFromArchive()) {
-              if (iter->archive().order() > currentIter->archive().order()) {
+              if (getArchive(*iter).order() > getArchive(*currentIter).order()) {
                 currentIter = iter;
               }
             }
@@ -116,23 +118,26 @@ bool FileEntry::removeOrigin(OriginID origin)
         }
       }
 
-      OriginID currentID = currentIter->originID();
-      m_Archive = currentIter->archive();
-      m_Alternatives.erase(currentIter);
+      const FileAlternative current = *currentIter;
+      alternatives.erase(currentIter);
+
+      m_Table->setOrigin(m_Index, current);
+      m_Table->setAlternatives(m_Index, alternatives);
 
-      m_Origin = currentID;
+      // only the size in the primary origin was known
+      m_Table->setFileSize(m_Index, NoFileSize, NoFileSize);
     } else {
-      m_Origin = -1;
-      m_Archive = DataArchiveOrigin(L"", -1);
+      m_Table->setOrigin(m_Index, -1, NoArchiveID);
       return true;
     }
   } else {
     auto newEnd = std::remove_if(
-      m_Alternatives.begin(), m_Alternatives.end(),
+      alternatives.begin(), alternatives.end(),
       [&](auto &i) { return i.originID() == origin; });
 
-    if (newEnd != m_Alternatives.end()) {
-      m_Alternatives.erase(newEnd, m_Alternatives.end());
+    if (newEnd != alternatives.end()) {
+      alternatives.erase(newEnd, alternatives.end());
+      m_Table->setAlternatives(m_Index, alternatives);
     }
   }
   return false;
@@ -140,18 +145,26 @@ bool FileEntry::removeOrigin(OriginID origin)
 
 void FileEntry::sortOrigins()
 {
-  std::scoped_lock lock(m_OriginsMutex);
+  std::scoped_lock lock(m_Table->mutex(m_Index));
+
+  auto alternatives = m_Table->copyAlternatives(m_Index);
+  if (alternatives.empty()) {
+    // nothing to sort
+    return;
+  }
+
+  const DirectoryEntry* parent = getParent();
 
-  m_Alternatives.push_back({m_Origin, m_Archive});
+  alternatives.push_back({getOrigin(), m_Table->archiveID(m_Index)});
 
-  std::sort(m_Alternatives.begin(), m_Alternatives.end(), [&](auto&& LHS, auto&& RHS) {
+  std::sort(alternatives.begin(), alternatives.end(), [&](auto&& LHS, auto&& RHS) {
     if (!LHS.isFromArchive() && !RHS.isFromArchive()) {
-      int l = m_Parent->getOriginByID(LHS.originID()).getPriority();
+      int l = parent->getOriginByID(LHS.originID()).getPriority();
       if (l < 0) {
         l = INT_MAX;
       }
 
-      int r = m_Parent->getOriginByID(RHS.originID()).getPriority();
+      int r = parent->getOriginByID(RHS.originID()).getPriority();
       if (r < 0) {
         r = INT_MAX;
       }
@@ -160,8 +173,8 @@ void FileEntry::sortOrigins()
     }
 
     if (LHS.isFromArchive() && RHS.isFromArchive()) {
-      int l = LHS.archive().order(); if (l < 0) l = INT_MAX;
-      int r = RHS.archive().order(); if (r < 0) r = INT_MAX;
+      int l = getArchive(LHS).order(); if (l < 0) l = INT_MAX;
+      int r = getArchive(RHS).order(); if (r < 0) r = INT_MAX;
 
       return l < r;
     }
@@ -173,27 +186,33 @@ void FileEntry::sortOrigins()
     return true;
     });
 
-  if (!m_Alternatives.empty()) {
-    m_Origin = m_Alternatives.back().originID();
-    m_Archive = m_Alternatives.back().archive();
-    m_Alternatives.pop_back();
-  }
+  m_Table->setOrigin(m_Index, alternatives.back());
+
+  alternatives.pop_back();
+  m_Table->setAlternatives(m_Index, alternatives);
 }
 
 bool FileEntry::isFromArchive(std::wstring archiveName) const
 {
-  std::scoped_lock lock(m_OriginsMutex);
-
   if (archiveName.length() == 0) {
-    return m_Archive.isValid();
+    return getArchive().isValid();
+  }
+
+  return isFromArchive(m_Table->findArchive(archiveName));
+}
+
+bool FileEntry::isFromArchive(ArchiveID id) const
+{
+  if (id == NoArchiveID) {
+    return false;
   }
 
-  if (m_Archive.name().compare(archiveName) == 0) {
+  if (m_Table->archiveID(m_Index) == id) {
     return true;
   }
 
-  for (const auto& alternative : m_Alternatives) {
-    if (alternative.archive().name().compare(archiveName) == 0) {
+  for (const auto& alternative : getAlternatives()) {
+    if (alternative.archiveID() == id) {
       return true;
     }
   }
@@ -203,49 +222,45 @@ bool FileEntry::isFromArchive(std::wstring archiveName) const
 
 std::wstring FileEntry::getFullPath(OriginID originID) const
 {
-  std::scoped_lock lock(m_OriginsMutex);
+  std::wstring result;
+  appendFullPath(result, originID);
+  return result;
+}
 
+bool FileEntry::appendFullPath(std::wstring& out, OriginID originID) const
+{
   if (originID == InvalidOriginID) {
     bool ignore = false;
     originID = getOrigin(ignore);
   }
 
+  const auto* parent = getParent();
+
   // base directory for origin
-  const auto* o = m_Parent->findOriginByID(originID);
+  const auto* o = parent->findOriginByID(originID);
   if (!o) {
-    return {};
+    return false;
   }
 
-  std::wstring result = o->getPath();
+  const auto& base = o->getPath();
+  const auto& rel = parent->getRelativePath();
+  const auto name = getName();
 
-  // all intermediate directories
-  recurseParents(result, m_Parent);
+  out.reserve(out.size() + base.size() + rel.size() + 1 + name.size());
+  out.append(base).append(rel).append(L"\\").append(name);
 
-  return result + L"\\" + m_Name;
+  return true;
 }
 
 std::wstring FileEntry::getRelativePath() const
 {
-  std::wstring result;
+  const auto& rel = getParent()->getRelativePath();
+  const auto name = getName();
 
-  // all intermediate directories
-  recurseParents(result, m_Parent);
-
-  return result + L"\\" + m_Name;
-}
-
-bool FileEntry::recurseParents(std::wstring &path, const DirectoryEntry *parent) const
-{
-  if (parent == nullptr) {
-    return false;
-  } else {
-    // don't append the topmost parent because it is the virtual data-root
-    if (recurseParents(path, parent->getParent())) {
-      path.append(L"\\").append(parent->getName());
-    }
+  std::wstring result;
+  result.reserve(rel.size() + 1 + name.size());
 
-    return true;
-  }
+  return result.append(rel).append(L"\\").append(name);
 }
 
 } // namespace
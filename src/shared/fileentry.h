@@ -2,30 +2,44 @@
 #define MO_REGISTER_FILEENTRY_INCLUDED
 
 #include "fileregisterfwd.h"
+#include "filetable.h"
 
 namespace MOShared
 {
 
+// a view over one row of a FileTable; it's cheap to copy and doesn't own
+// anything, it's only valid as long as the structure is alive
+//
 class FileEntry
 {
 public:
   static constexpr uint64_t NoFileSize =
     std::numeric_limits<uint64_t>::max();
 
-  FileEntry();
-  FileEntry(FileIndex index, std::wstring name, DirectoryEntry *parent);
+  FileEntry()
+    : m_Table(nullptr), m_Index(InvalidFileIndex)
+  {
+  }
 
-  // noncopyable
-  FileEntry(const FileEntry&) = delete;
-  FileEntry& operator=(const FileEntry&) = delete;
+  FileEntry(FileTable* table, FileIndex index)
+    : m_Table(table), m_Index(index)
+  {
+  }
 
   FileIndex getIndex() const
   {
     return m_Index;
   }
 
+  // the archive must have been created by the table, see FileTable::archive()
+  //
+  // the time and sizes are the ones of the file in the given origin, they're
+  // only kept if the origin becomes the primary one; sizes that are not known
+  // are retrieved from the disk when needed
+  //
   void addOrigin(
-    OriginID origin, FILETIME fileTime, std::wstring_view archive, int order);
+    OriginID origin, FILETIME fileTime, const DataArchiveOrigin& archive,
+    uint64_t size=NoFileSize, uint64_t compressedSize=NoFileSize);
 
   // remove the specified origin from the list of origins that contain this
   // file. if no origin is left, the file is effectively deleted and true is
@@ -37,84 +51,135 @@ public:
   // gets the list of alternative origins (origins with lower priority than
   // the primary one). if sortOrigins has been called, it is sorted by priority
   // (ascending)
-  const AlternativesVector &getAlternatives() const
+  //
+  // the view is invalidated when the alternatives of any file change
+  AlternativesView getAlternatives() const
   {
-    return m_Alternatives;
+    return m_Table->alternatives(m_Index);
   }
 
-  const std::wstring &getName() const
+  std::wstring_view getName() const
   {
-    return m_Name;
+    return m_Table->name(m_Index);
   }
 
   OriginID getOrigin() const
   {
-    return m_Origin;
+    return m_Table->origin(m_Index);
   }
 
   OriginID getOrigin(bool &archive) const
   {
-    archive = m_Archive.isValid();
-    return m_Origin;
+    archive = getArchive().isValid();
+    return getOrigin();
   }
 
   const DataArchiveOrigin &getArchive() const
   {
-    return m_Archive;
+    return m_Table->archive(m_Index);
+  }
+
+  // the archive of one of the alternatives of this file
+  //
+  const DataArchiveOrigin &getArchive(const FileAlternative& alt) const
+  {
+    return m_Table->archiveByID(alt.archiveID());
   }
 
   bool isFromArchive(std::wstring archiveName = L"") const;
 
+  // whether the origin or any alternative is from the given archive, see
+  // FileRegister::findArchive()
+  //
+  bool isFromArchive(ArchiveID id) const;
+
   // if originID is -1, uses the main origin; if this file doesn't exist in the
   // given origin, returns an empty string
   //
   std::wstring getFullPath(OriginID originID=InvalidOriginID) const;
 
+  // same as getFullPath(), but appends to the given string, which can be
+  // reused across files; returns false and leaves `out` untouched if this
+  // file doesn't exist in the given origin
+  //
+  bool appendFullPath(std::wstring& out, OriginID originID=InvalidOriginID) const;
+
   std::wstring getRelativePath() const;
 
-  DirectoryEntry *getParent()
+  DirectoryEntry *getParent() const
   {
-    return m_Parent;
+    return m_Table->parent(m_Index);
   }
 
   void setFileTime(FILETIME fileTime) const
   {
-    m_FileTime = fileTime;
+    m_Table->setFileTime(m_Index, fileTime);
   }
 
   FILETIME getFileTime() const
   {
-    return m_FileTime;
+    return m_Table->fileTime(m_Index);
   }
 
   void setFileSize(uint64_t size, uint64_t compressedSize)
   {
-    m_FileSize = size;
-    m_CompressedFileSize = compressedSize;
+    m_Table->setFileSize(m_Index, size, compressedSize);
   }
 
   uint64_t getFileSize() const
   {
-    return m_FileSize;
+    return m_Table->fileSize(m_Index);
   }
 
   uint64_t getCompressedFileSize() const
   {
-    return m_CompressedFileSize;
+    return m_Table->compressedFileSize(m_Index);
   }
 
 private:
+  friend class FileEntryPtr;
+  friend class DirectorySnapshot;
+
+  FileTable* m_Table;
   FileIndex m_Index;
-  std::wstring m_Name;
-  OriginID m_Origin;
-  DataArchiveOrigin m_Archive;
-  AlternativesVector m_Alternatives;
-  DirectoryEntry *m_Parent;
-  mutable FILETIME m_FileTime;
-  uint64_t m_FileSize, m_CompressedFileSize;
-  mutable std::mutex m_OriginsMutex;
-
-  bool recurseParents(std::wstring &path, const DirectoryEntry *parent) const;
+};
+
+
+// returned by lookups, behaves like a pointer to a FileEntry and is null
+// when the file doesn't exist
+//
+class FileEntryPtr
+{
+public:
+  FileEntryPtr() = default;
+
+  FileEntryPtr(FileTable* table, FileIndex index)
+    : m_Entry(table, index)
+  {
+  }
+
+  explicit operator bool() const
+  {
+    return (m_Entry.m_Table != nullptr);
+  }
+
+  FileEntry* get() const
+  {
+    return (m_Entry.m_Table ? &m_Entry : nullptr);
+  }
+
+  FileEntry* operator->() const
+  {
+    return &m_Entry;
+  }
+
+  FileEntry& operator*() const
+  {
+    return m_Entry;
+  }
+
+private:
+  mutable FileEntry m_Entry;
 };
 
 } // namespace
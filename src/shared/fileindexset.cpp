@@ -0,0 +1,127 @@
+#include "fileindexset.h"
+#include <algorithm>
+
+namespace MOShared
+{
+
+// sorts the given indices and removes duplicates
+//
+static void sortUnique(std::vector<FileIndex>& v)
+{
+  std::sort(v.begin(), v.end());
+  v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+
+void FileIndexSet::insert(FileIndex index)
+{
+  if (!m_removed.empty()) {
+    flush();
+  }
+
+  m_added.push_back(index);
+}
+
+void FileIndexSet::insert(const std::vector<FileIndex>& indices)
+{
+  if (!m_removed.empty()) {
+    flush();
+  }
+
+  m_added.insert(m_added.end(), indices.begin(), indices.end());
+}
+
+void FileIndexSet::erase(FileIndex index)
+{
+  if (!m_added.empty()) {
+    flush();
+  }
+
+  m_removed.push_back(index);
+}
+
+void FileIndexSet::clear()
+{
+  m_sorted = {};
+  m_added = {};
+  m_removed = {};
+}
+
+bool FileIndexSet::contains(FileIndex index) const
+{
+  flush();
+  return std::binary_search(m_sorted.begin(), m_sorted.end(), index);
+}
+
+std::size_t FileIndexSet::size() const
+{
+  flush();
+  return m_sorted.size();
+}
+
+bool FileIndexSet::empty() const
+{
+  flush();
+  return m_sorted.empty();
+}
+
+const std::vector<FileIndex>& FileIndexSet::indices() const
+{
+  flush();
+  return m_sorted;
+}
+
+std::vector<FileIndex> FileIndexSet::take()
+{
+  flush();
+
+  std::vector<FileIndex> v = std::move(m_sorted);
+  clear();
+
+  return v;
+}
+
+std::size_t FileIndexSet::allocatedBytes() const
+{
+  return
+    m_sorted.capacity() * sizeof(FileIndex) +
+    m_added.capacity() * sizeof(FileIndex) +
+    m_removed.capacity() * sizeof(FileIndex);
+}
+
+void FileIndexSet::flush() const
+{
+  if (!m_added.empty()) {
+    sortUnique(m_added);
+
+    if (m_sorted.empty() || m_added.front() > m_sorted.back()) {
+      // files are mostly created in order during a refresh, so the new
+      // indices usually all go at the end
+      m_sorted.insert(m_sorted.end(), m_added.begin(), m_added.end());
+    } else {
+      const auto middle = m_sorted.size();
+      m_sorted.insert(m_sorted.end(), m_added.begin(), m_added.end());
+
+      std::inplace_merge(
+        m_sorted.begin(), m_sorted.begin() + middle, m_sorted.end());
+
+      m_sorted.erase(std::unique(m_sorted.begin(), m_sorted.end()), m_sorted.end());
+    }
+
+    m_added = {};
+  }
+
+  if (!m_removed.empty()) {
+    sortUnique(m_removed);
+
+    m_sorted.erase(
+      std::remove_if(m_sorted.begin(), m_sorted.end(), [&](FileIndex i) {
+        return std::binary_search(m_removed.begin(), m_removed.end(), i);
+      }),
+      m_sorted.end());
+
+    m_removed = {};
+  }
+}
+
+} // namespace
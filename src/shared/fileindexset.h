@@ -0,0 +1,58 @@
+#ifndef MO_REGISTER_FILEINDEXSET_INCLUDED
+#define MO_REGISTER_FILEINDEXSET_INCLUDED
+
+#include "fileregisterfwd.h"
+#include <vector>
+
+namespace MOShared
+{
+
+// a set of file indices stored as a sorted vector, used by origins for their
+// files; a std::set needs a node per file, which was most of the memory used
+// by origins with many files
+//
+// insertions and removals are appended to pending lists and only applied to
+// the sorted vector when the set is read, so adding all the files of an
+// origin during a refresh is a sequence of appends followed by a single sort;
+// only one of the lists has pending indices at any time, so an index that's
+// removed and added again is in the set
+//
+// this is not thread-safe, even the const functions can modify the set
+//
+class FileIndexSet
+{
+public:
+  void insert(FileIndex index);
+  void insert(const std::vector<FileIndex>& indices);
+  void erase(FileIndex index);
+  void clear();
+
+  bool contains(FileIndex index) const;
+  std::size_t size() const;
+  bool empty() const;
+
+  // the indices in the set, sorted and unique
+  //
+  const std::vector<FileIndex>& indices() const;
+
+  // clears the set and returns the indices it had, sorted and unique
+  //
+  std::vector<FileIndex> take();
+
+  // bytes allocated by the vectors
+  //
+  std::size_t allocatedBytes() const;
+
+private:
+  mutable std::vector<FileIndex> m_sorted;
+  mutable std::vector<FileIndex> m_added;
+  mutable std::vector<FileIndex> m_removed;
+
+  // applies the pending insertions or removals
+  //
+  void flush() const;
+};
+
+} // namespace
+
+#endif // MO_REGISTER_FILEINDEXSET_INCLUDED
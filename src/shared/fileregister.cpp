@@ -3,7 +3,10 @@
 #include "directoryentry.h"
 #include "originconnection.h"
 #include "filesorigin.h"
+#include "../taskexecutor.h"
 #include <log.h>
+#include <algorithm>
+#include <climits>
 
 namespace MOShared
 {
@@ -11,38 +14,23 @@ namespace MOShared
 using namespace MOBase;
 
 FileRegister::FileRegister(boost::shared_ptr<OriginConnection> originConnection)
-  : m_OriginConnection(originConnection), m_NextIndex(0)
+  : m_OriginConnection(originConnection), m_NextIndex(0),
+    m_Conflicts(*this, *originConnection)
 {
 }
 
 bool FileRegister::indexValid(FileIndex index) const
 {
-  std::scoped_lock lock(m_Mutex);
-
-  if (index < m_Files.size()) {
-    return (m_Files[index].get() != nullptr);
-  }
-
-  return false;
+  return m_Files.exists(index);
 }
 
 FileEntryPtr FileRegister::createFile(
-  std::wstring name, DirectoryEntry *parent, DirectoryStats& stats)
+  std::wstring_view name, DirectoryEntry *parent, DirectoryStats& stats)
 {
   const auto index = generateIndex();
-  auto p = FileEntryPtr(new FileEntry(index, std::move(name), parent));
-
-  {
-    std::scoped_lock lock(m_Mutex);
+  m_Files.create(index, name, parent);
 
-    if (index >= m_Files.size()) {
-      m_Files.resize(index + 1);
-    }
-
-    m_Files[index] = p;
-  }
-
-  return p;
+  return FileEntryPtr(&m_Files, index);
 }
 
 FileIndex FileRegister::generateIndex()
@@ -52,27 +40,19 @@ FileIndex FileRegister::generateIndex()
 
 FileEntryPtr FileRegister::getFile(FileIndex index) const
 {
-  std::scoped_lock lock(m_Mutex);
-
-  if (index < m_Files.size()) {
-    return m_Files[index];
-  } else {
+  if (!m_Files.exists(index)) {
     return {};
   }
+
+  return FileEntryPtr(&m_Files, index);
 }
 
 bool FileRegister::removeFile(FileIndex index)
 {
-  std::scoped_lock lock(m_Mutex);
-
-  if (index < m_Files.size()) {
-    FileEntryPtr p;
-    m_Files[index].swap(p);
-
-    if (p) {
-      unregisterFile(p);
-      return true;
-    }
+  if (m_Files.exists(index)) {
+    m_Files.remove(index);
+    unregisterFile(FileEntry(&m_Files, index));
+    return true;
   }
 
   log::error(QObject::tr("invalid file index for remove: {}").toStdString(), index);
@@ -81,18 +61,13 @@ bool FileRegister::removeFile(FileIndex index)
 
 void FileRegister::removeOrigin(FileIndex index, OriginID originID)
 {
-  std::unique_lock lock(m_Mutex);
+  if (m_Files.exists(index)) {
+    FileEntry file(&m_Files, index);
 
-  if (index < m_Files.size()) {
-    FileEntryPtr& p = m_Files[index];
-
-    if (p) {
-      if (p->removeOrigin(originID)) {
-        m_Files[index] = {};
-        lock.unlock();
-        unregisterFile(p);
-        return;
-      }
+    if (file.removeOrigin(originID)) {
+      m_Files.remove(index);
+      unregisterFile(file);
+      return;
     }
   }
 
@@ -100,31 +75,28 @@ void FileRegister::removeOrigin(FileIndex index, OriginID originID)
 }
 
 void FileRegister::removeOriginMulti(
-  std::set<FileIndex> indices, OriginID originID)
+  std::vector<FileIndex> indices, OriginID originID)
 {
-  std::vector<FileEntryPtr> removedFiles;
+  std::vector<FileEntry> removedFiles;
 
-  {
-    std::scoped_lock lock(m_Mutex);
+  // only the files that were removed are kept in `indices`, which stays
+  // sorted
+  auto kept = indices.begin();
 
-    for (auto iter = indices.begin(); iter != indices.end(); ) {
-      const auto index = *iter;
+  for (const FileIndex index : indices) {
+    if (m_Files.exists(index)) {
+      FileEntry file(&m_Files, index);
 
-      if (index < m_Files.size()) {
-        const auto& p = m_Files[index];
-
-        if (p && p->removeOrigin(originID)) {
-          removedFiles.push_back(p);
-          m_Files[index] = {};
-          ++iter;
-          continue;
-        }
+      if (file.removeOrigin(originID)) {
+        removedFiles.push_back(file);
+        m_Files.remove(index);
+        *kept++ = index;
       }
-
-      iter = indices.erase(iter);
     }
   }
 
+  indices.erase(kept, indices.end());
+
   // optimization: this is only called when disabling an origin and in this case
   // we don't have to remove the file from the origin
 
@@ -140,9 +112,9 @@ void FileRegister::removeOriginMulti(
   // frequently the case
 
   std::set<DirectoryEntry*> parents;
-  for (const FileEntryPtr &file : removedFiles) {
-    if (file->getParent() != nullptr) {
-      parents.insert(file->getParent());
+  for (const FileEntry& file : removedFiles) {
+    if (file.getParent() != nullptr) {
+      parents.insert(file.getParent());
     }
   }
 
@@ -153,31 +125,168 @@ void FileRegister::removeOriginMulti(
 
 void FileRegister::sortOrigins()
 {
-  std::scoped_lock lock(m_Mutex);
+  const FileIndex count = m_NextIndex;
+
+  // the priorities of the origins by id, looked up once instead of for every
+  // comparison; same order as FileEntry::sortOrigins()
+  std::vector<int> priorities;
+
+  m_OriginConnection->forEachOrigin([&](FilesOrigin& o) {
+    const auto i = static_cast<std::size_t>(o.getID());
+
+    if (i >= priorities.size()) {
+      priorities.resize(i + 1, 0);
+    }
+
+    priorities[i] = (o.getPriority() < 0 ? INT_MAX : o.getPriority());
+  });
+
+  // loose files come before archives, each sorted by priority or order; the
+  // highest key wins
+  auto key = [&](const FileAlternative& a) -> std::int64_t {
+    if (a.isFromArchive()) {
+      const int order = m_Files.archiveByID(a.archiveID()).order();
+      return (std::int64_t(1) << 32) | (order < 0 ? INT_MAX : order);
+    }
+
+    const auto i = static_cast<std::size_t>(a.originID());
+    return (i < priorities.size() ? priorities[i] : 0);
+  };
+
+  // the structure isn't shared while this runs, so the rows are sorted in
+  // place without their locks, one chunk of the table per task
+  const FileIndex chunks = (count + FileTable::ChunkSize - 1) / FileTable::ChunkSize;
+
+  if (chunks <= 1) {
+    m_Files.sortOrigins(0, count, key);
+  } else {
+    TaskGroup g(TaskPriority::High);
+
+    for (FileIndex c=0; c<chunks; ++c) {
+      g.run([&, c] {
+        const FileIndex begin = c * FileTable::ChunkSize;
+        const FileIndex end = std::min<FileIndex>(begin + FileTable::ChunkSize, count);
+
+        m_Files.sortOrigins(begin, end, key);
+      });
+    }
+
+    g.wait();
+  }
+
+  m_Files.compactAlternatives(count);
+}
+
+void FileRegister::sortOrigins(const std::vector<OriginID>& origins)
+{
+  // files shared by multiple moved origins are only sorted once
+  std::vector<FileIndex> indices;
+
+  for (const OriginID id : origins) {
+    if (const FilesOrigin* origin = m_OriginConnection->findByID(id)) {
+      origin->forEachFileIndex([&](FileIndex i) { indices.push_back(i); });
+    }
+  }
+
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
 
-  for (auto&& p : m_Files) {
-    if (p) {
-      p->sortOrigins();
+  for (const FileIndex index : indices) {
+    if (m_Files.exists(index)) {
+      FileEntry(&m_Files, index).sortOrigins();
     }
   }
 }
 
-void FileRegister::unregisterFile(FileEntryPtr file)
+bool FileRegister::setArchiveOrders(const std::vector<std::wstring>& loadOrder)
+{
+  const auto changed = m_Files.setArchiveOrders([&](auto&& name) {
+    return DirectoryEntry::archiveOrder(name, loadOrder);
+  });
+
+  if (changed.empty()) {
+    return false;
+  }
+
+  // by archive id
+  std::vector<bool> movedIDs(
+    *std::max_element(changed.begin(), changed.end()) + 1, false);
+
+  for (const auto id : changed) {
+    movedIDs[id] = true;
+  }
+
+  auto moved = [&](ArchiveID id) {
+    return (id < movedIDs.size() && movedIDs[id]);
+  };
+
+  // the archives are only referenced from the rows, so finding their files
+  // is a pass over the origin and alternatives columns
+  std::vector<FileIndex> indices;
+  std::set<OriginID> origins;
+
+  const FileIndex count = m_NextIndex;
+
+  for (FileIndex i=0; i<count; ++i) {
+    if (!m_Files.exists(i)) {
+      continue;
+    }
+
+    bool touched = moved(m_Files.archiveID(i));
+
+    for (const auto& alt : m_Files.alternatives(i)) {
+      if (moved(alt.archiveID())) {
+        touched = true;
+        origins.insert(alt.originID());
+      }
+    }
+
+    if (touched) {
+      indices.push_back(i);
+      origins.insert(m_Files.origin(i));
+    }
+  }
+
+  const std::vector<OriginID> v(origins.begin(), origins.end());
+
+  m_Conflicts.exclude(v);
+
+  for (const FileIndex index : indices) {
+    FileEntry(&m_Files, index).sortOrigins();
+  }
+
+  m_Conflicts.include(v);
+
+  log::debug(
+    "{} archives moved, sorted {} files from {} origins",
+    changed.size(), indices.size(), v.size());
+
+  return true;
+}
+
+bool FileRegister::archiveOrdersChanged(
+  const std::vector<std::wstring>& loadOrder) const
+{
+  return m_Files.archiveOrdersChanged([&](auto&& name) {
+    return DirectoryEntry::archiveOrder(name, loadOrder);
+  });
+}
+
+void FileRegister::unregisterFile(FileEntry file)
 {
   bool ignore;
 
   // unregister from origin
-  OriginID originID = file->getOrigin(ignore);
-  m_OriginConnection->getByID(originID).removeFile(file->getIndex());
-  const auto& alternatives = file->getAlternatives();
+  OriginID originID = file.getOrigin(ignore);
+  m_OriginConnection->getByID(originID).removeFile(file.getIndex());
 
-  for (const auto& alt : alternatives) {
-    m_OriginConnection->getByID(alt.originID()).removeFile(file->getIndex());
+  for (const auto& alt : file.getAlternatives()) {
+    m_OriginConnection->getByID(alt.originID()).removeFile(file.getIndex());
   }
 
   // unregister from directory
-  if (file->getParent() != nullptr) {
-    file->getParent()->removeFile(file->getIndex());
+  if (file.getParent() != nullptr) {
+    file.getParent()->removeFile(file.getIndex());
   }
 }
 
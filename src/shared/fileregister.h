@@ -2,6 +2,11 @@
 #define MO_REGISTER_FILESREGISTER_INCLUDED
 
 #include "fileregisterfwd.h"
+#include "fileentry.h"
+#include "filetable.h"
+#include "conflictgraph.h"
+#include "namearena.h"
+#include "memoryusage.h"
 #include <mutex>
 #include <boost/shared_ptr.hpp>
 
@@ -19,32 +24,116 @@ public:
 
   bool indexValid(FileIndex index) const;
 
+  // the name must be stored in names()
+  //
   FileEntryPtr createFile(
-    std::wstring name, DirectoryEntry *parent, DirectoryStats& stats);
+    std::wstring_view name, DirectoryEntry *parent, DirectoryStats& stats);
 
   FileEntryPtr getFile(FileIndex index) const;
 
   size_t highestCount() const
   {
-    std::scoped_lock lock(m_Mutex);
-    return m_Files.size();
+    return m_NextIndex;
   }
 
   bool removeFile(FileIndex index);
   void removeOrigin(FileIndex index, OriginID originID);
-  void removeOriginMulti(std::set<FileIndex> indices, OriginID originID);
+  // `indices` must be sorted
+  //
+  void removeOriginMulti(std::vector<FileIndex> indices, OriginID originID);
 
+  // sorts the origins of all the files and compacts the alternatives, must
+  // not be called while the structure is being modified; the files are
+  // sorted in place on the task executor without locking them
+  //
   void sortOrigins();
 
-private:
-  using FileMap = std::deque<FileEntryPtr>;
+  // sorts the origins of the files provided by the given origins only, which
+  // is enough when only these origins moved relative to the others; the
+  // alternatives keep their size, so they don't need to be compacted
+  //
+  void sortOrigins(const std::vector<OriginID>& origins);
+
+  // storage for the names of all the files in the structure
+  //
+  NameArena& names()
+  {
+    return m_Names;
+  }
+
+  // number of bytes allocated for the files and their names
+  //
+  std::size_t allocatedBytes() const
+  {
+    return m_Files.allocatedBytes() + m_Names.allocatedBytes();
+  }
+
+  // estimated memory used by the rows and the alternatives of the files,
+  // without their names
+  //
+  MemoryUsage filesMemory() const
+  {
+    return {m_NextIndex.load(), m_Files.allocatedBytes()};
+  }
+
+  // memory used by the names of the files
+  //
+  std::size_t namesBytes() const
+  {
+    return m_Names.allocatedBytes();
+  }
+
+  // archive origin shared by all the files from the given archive, see
+  // FileTable::archive()
+  //
+  const DataArchiveOrigin& archive(std::wstring_view name, int order)
+  {
+    return m_Files.archive(name, order);
+  }
+
+  // id of the archive with the given name, NoArchiveID if no file is from
+  // it; see FileEntry::isFromArchive()
+  //
+  ArchiveID findArchive(std::wstring_view name) const
+  {
+    return m_Files.findArchive(name);
+  }
+
+  // recomputes the order of every archive from the given plugin load order,
+  // see DirectoryEntry::archiveOrder(), and sorts the origins of the files
+  // from the archives that moved; the conflicts of the origins of these
+  // files are updated
+  //
+  // this is all that's needed when plugins are reordered, the alternatives
+  // keep their size so they don't need to be compacted; returns false if no
+  // archive moved
+  //
+  bool setArchiveOrders(const std::vector<std::wstring>& loadOrder);
+
+  // whether setArchiveOrders() would move any archive
+  //
+  bool archiveOrdersChanged(const std::vector<std::wstring>& loadOrder) const;
 
-  mutable std::mutex m_Mutex;
-  FileMap m_Files;
+  // conflicts between the origins, see ConflictGraph
+  //
+  ConflictGraph& conflicts()
+  {
+    return m_Conflicts;
+  }
+
+  const ConflictGraph& conflicts() const
+  {
+    return m_Conflicts;
+  }
+
+private:
+  mutable FileTable m_Files;
   boost::shared_ptr<OriginConnection> m_OriginConnection;
   std::atomic<FileIndex> m_NextIndex;
+  NameArena m_Names;
+  ConflictGraph m_Conflicts;
 
-  void unregisterFile(FileEntryPtr file);
+  void unregisterFile(FileEntry file);
   FileIndex generateIndex();
 };
 
@@ -1,6 +1,11 @@
 #ifndef MO_REGISTER_FILEREGISTERFWD_INCLUDED
 #define MO_REGISTER_FILEREGISTERFWD_INCLUDED
 
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
 class DirectoryRefreshProgress;
 
 namespace MOShared
@@ -18,11 +23,52 @@ struct DirectoryEntryFileKey
     return (value == o.value);
   }
 
-  static std::size_t getHash(const std::wstring& value)
+  // fnv-1a over the lowercase characters of the value, so a name hashes the
+  // same whatever its case and lookups don't need a lowercase copy; also
+  // works for the views used as keys by DirectoryEntry
+  static std::size_t getHash(std::wstring_view value)
   {
-    return std::hash<std::wstring>()(value);
+    std::uint64_t h = 14695981039346656037ull;
+
+    for (const wchar_t c : value) {
+      h ^= static_cast<std::uint64_t>(fold(c));
+      h *= 1099511628211ull;
+    }
+
+    return static_cast<std::size_t>(h);
   }
 
+  // whether both values are the same once lowercased
+  //
+  static bool equalsFolded(std::wstring_view a, std::wstring_view b)
+  {
+    if (a.size() != b.size()) {
+      return false;
+    }
+
+    for (std::size_t i=0; i<a.size(); ++i) {
+      if (a[i] != b[i] && fold(a[i]) != fold(b[i])) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // lowercase of the given character, same as ToLowerCopy(); ascii is handled
+  // here, the rest goes through the table of ToLowerChar()
+  //
+  static wchar_t fold(wchar_t c)
+  {
+    if (c < 0x80) {
+      return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c + 0x20) : c;
+    }
+
+    return foldNonAscii(c);
+  }
+
+  static wchar_t foldNonAscii(wchar_t c);
+
   std::wstring value;
   const std::size_t hash;
 };
@@ -33,67 +79,107 @@ class OriginConnection;
 class FileRegister;
 class FilesOrigin;
 class FileEntry;
+class FileEntryPtr;
+class FileTable;
 struct DirectoryStats;
+struct WalkedDirectory;
 
-using FileEntryPtr = boost::shared_ptr<FileEntry>;
 using FileIndex = unsigned int;
 using OriginID = int;
 
+// index of an archive in the FileTable of a structure
+using ArchiveID = std::uint32_t;
+
 constexpr FileIndex InvalidFileIndex = UINT_MAX;
 constexpr OriginID InvalidOriginID = -1;
 
+// id of DataArchiveOrigin::none(), used by files that are not in an archive
+constexpr ArchiveID NoArchiveID = 0;
+
 // if a file is in an archive, name is the name of the bsa and order
 // is the order of the associated plugin in the plugins list
 // is a file is not in an archive, archiveName is empty and order is usually
 // -1
+//
+// archives are owned by the FileTable, which changes their order when the
+// plugins are reordered, see FileTable::setArchiveOrders(); rows and
+// alternatives only store the id of their archive
 class DataArchiveOrigin
 {
+  friend class FileTable;
+
   std::wstring name_ = L"";
   int order_ = -1;
-  
+  ArchiveID id_ = NoArchiveID;
+
 public:
 
   int order() const { return order_; }
   const std::wstring& name() const { return name_; }
-  
+  ArchiveID id() const { return id_; }
+
   bool isValid() const {
-    return name_.size() > 0;
+    return (id_ != NoArchiveID);
   }
 
-  DataArchiveOrigin(std::wstring name, int order)
-    : name_(std::move(name)), order_(order) {}
+  DataArchiveOrigin(std::wstring name, int order, ArchiveID id)
+    : name_(std::move(name)), order_(order), id_(id) {}
 
   DataArchiveOrigin() = default;
+
+  // shared by all the files that are not in an archive
+  static const DataArchiveOrigin& none()
+  {
+    static const DataArchiveOrigin n;
+    return n;
+  }
 };
 
+// the archive is owned by the FileTable of the structure and is looked up by
+// its id, see FileEntry::getArchive(); alternatives are stored packed in the
+// table and must stay trivially copyable
 class FileAlternative
 {
   OriginID originID_ = -1;
-  DataArchiveOrigin archive_;
+  ArchiveID archiveID_ = NoArchiveID;
 
 public:
 
   OriginID originID() const { return originID_; }
-  const DataArchiveOrigin& archive() const { return archive_; }
+  ArchiveID archiveID() const { return archiveID_; }
 
   bool isFromArchive() const {
-    return archive_.isValid();
+    return (archiveID_ != NoArchiveID);
   }
 
   FileAlternative() = default;
 
-  FileAlternative(OriginID originID, DataArchiveOrigin archive) 
-    : originID_(originID), archive_(std::move(archive)) {}
+  FileAlternative(OriginID originID, ArchiveID archiveID)
+    : originID_(originID), archiveID_(archiveID) {}
+
+  FileAlternative(OriginID originID, const DataArchiveOrigin& archive)
+    : originID_(originID), archiveID_(archive.id()) {}
 };
 
+static_assert(sizeof(FileAlternative) == 8);
+
 using AlternativesVector = std::vector<FileAlternative>;
+using AlternativesView = std::span<const FileAlternative>;
 
 struct DirectoryStats
 {
+  // enables the detailed timings in DirectoryEntry, which read the clock for
+  // every file and directory; see enabled() for the per-phase timings
   static constexpr bool EnableInstrumentation = false;
 
   std::string mod;
 
+  // per-phase timings, only collected when enabled() is true
+  std::chrono::nanoseconds walkTime;
+  std::chrono::nanoseconds archivesTime;
+  std::chrono::nanoseconds lockWaitTimes;
+  int64_t lockWaits;
+
   std::chrono::nanoseconds dirTimes;
   std::chrono::nanoseconds fileTimes;
   std::chrono::nanoseconds sortTimes;
@@ -121,6 +207,11 @@ struct DirectoryStats
 
   DirectoryStats();
 
+  // whether the per-phase timings are collected, this can be changed at
+  // runtime and is set from the diagnostics settings
+  static bool enabled();
+  static void setEnabled(bool b);
+
   DirectoryStats& operator+=(const DirectoryStats& o);
 
   static std::string csvHeader();
@@ -2,10 +2,34 @@
 #include "originconnection.h"
 #include "fileregister.h"
 #include "fileentry.h"
+#include "memoryusage.h"
 
 namespace MOShared
 {
 
+static bool getDirectoryTime(const std::wstring& path, FILETIME& ft)
+{
+  WIN32_FILE_ATTRIBUTE_DATA data = {};
+
+  // long path prefix, some mods go over MAX_PATH
+  const std::wstring fullPath = L"\\\\?\\" + path;
+
+  if (!::GetFileAttributesExW(fullPath.c_str(), GetFileExInfoStandard, &data)) {
+    return false;
+  }
+
+  if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+    return false;
+  }
+
+  ft = data.ftLastWriteTime;
+  return true;
+}
+
+// a generation that's never used, generations start at 0
+static constexpr uint64_t NoModIndex = 0xffffffff00000000ull;
+
+
 std::wstring tail(const std::wstring &source, const size_t count)
 {
   if (count >= source.length()) {
@@ -17,7 +41,8 @@ std::wstring tail(const std::wstring &source, const size_t count)
 
 
 FilesOrigin::FilesOrigin()
-  : m_ID(0), m_Disabled(false), m_Name(), m_Path(), m_Priority(0)
+  : m_ID(0), m_Disabled(false), m_Name(), m_Path(), m_Priority(0),
+    m_LooseSize(0), m_ModIndex(NoModIndex)
 {
 }
 
@@ -27,7 +52,8 @@ FilesOrigin::FilesOrigin(
   boost::shared_ptr<MOShared::OriginConnection> originConnection) :
   m_ID(ID), m_Disabled(false), m_Name(name), m_Path(path),
   m_Priority(priority), m_FileRegister(fileRegister),
-  m_OriginConnection(originConnection)
+  m_OriginConnection(originConnection), m_LooseSize(0),
+  m_ModIndex(NoModIndex)
 {
 }
 
@@ -55,7 +81,10 @@ std::vector<FileEntryPtr> FilesOrigin::getFiles() const
   {
     std::scoped_lock lock(m_Mutex);
 
-    for (FileIndex fileIdx : m_Files) {
+    const auto& indices = m_Files.indices();
+    result.reserve(indices.size());
+
+    for (FileIndex fileIdx : indices) {
       if (FileEntryPtr p = m_FileRegister.lock()->getFile(fileIdx)) {
         result.push_back(p);
       }
@@ -65,6 +94,12 @@ std::vector<FileEntryPtr> FilesOrigin::getFiles() const
   return result;
 }
 
+std::size_t FilesOrigin::fileCount() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return m_Files.size();
+}
+
 FileEntryPtr FilesOrigin::findFile(FileIndex index) const
 {
   return m_FileRegister.lock()->getFile(index);
@@ -81,15 +116,14 @@ void FilesOrigin::enable(bool enabled, DirectoryStats& stats)
   if (!enabled) {
     ++stats.originsNeededEnabled;
 
-    std::set<FileIndex> copy;
+    std::vector<FileIndex> copy;
 
     {
       std::scoped_lock lock(m_Mutex);
-      copy = m_Files;
-      m_Files.clear();
+      copy = m_Files.take();
     }
 
-    m_FileRegister.lock()->removeOriginMulti(copy, m_ID);
+    m_FileRegister.lock()->removeOriginMulti(std::move(copy), m_ID);
   }
 
   m_Disabled = !enabled;
@@ -98,21 +132,27 @@ void FilesOrigin::enable(bool enabled, DirectoryStats& stats)
 void FilesOrigin::removeFile(FileIndex index)
 {
   std::scoped_lock lock(m_Mutex);
-
-  auto iter = m_Files.find(index);
-
-  if (iter != m_Files.end()) {
-    m_Files.erase(iter);
-  }
+  m_Files.erase(index);
 }
 
 bool FilesOrigin::containsArchive(std::wstring archiveName)
 {
+  auto fr = m_FileRegister.lock();
+  if (!fr) {
+    return false;
+  }
+
+  // looked up once, files are compared by id
+  const ArchiveID id = fr->findArchive(archiveName);
+  if (id == NoArchiveID) {
+    return false;
+  }
+
   std::scoped_lock lock(m_Mutex);
 
-  for (FileIndex fileIdx : m_Files) {
-    if (FileEntryPtr p = m_FileRegister.lock()->getFile(fileIdx)) {
-      if (p->isFromArchive(archiveName)) {
+  for (FileIndex fileIdx : m_Files.indices()) {
+    if (FileEntryPtr p = fr->getFile(fileIdx)) {
+      if (p->isFromArchive(id)) {
         return true;
       }
     }
@@ -121,4 +161,105 @@ bool FilesOrigin::containsArchive(std::wstring archiveName)
   return false;
 }
 
+void FilesOrigin::addDirectoryStamp(std::wstring path)
+{
+  // if this fails, the time stays zeroed and directoriesChanged() will
+  // consider the directory modified, which only forces a new walk
+  FILETIME ft = {};
+  getDirectoryTime(path, ft);
+
+  addDirectoryStamp(std::move(path), ft);
+}
+
+void FilesOrigin::addDirectoryStamp(std::wstring path, FILETIME lastModified)
+{
+  std::scoped_lock lock(m_Mutex);
+  m_DirectoryStamps.push_back({std::move(path), lastModified});
+}
+
+void FilesOrigin::clearDirectoryStamps()
+{
+  std::scoped_lock lock(m_Mutex);
+  m_DirectoryStamps.clear();
+}
+
+bool FilesOrigin::hasDirectoryStamps() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return !m_DirectoryStamps.empty();
+}
+
+bool FilesOrigin::directoriesChanged() const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  for (const auto& stamp : m_DirectoryStamps) {
+    FILETIME ft = {};
+
+    if (!getDirectoryTime(stamp.path, ft)) {
+      return true;
+    }
+
+    if (::CompareFileTime(&ft, &stamp.lastModified) != 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void FilesOrigin::setWalkedTree(std::shared_ptr<const WalkedDirectory> tree)
+{
+  std::scoped_lock lock(m_Mutex);
+  m_WalkedTree = std::move(tree);
+}
+
+std::shared_ptr<const WalkedDirectory> FilesOrigin::walkedTree() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return m_WalkedTree;
+}
+
+void FilesOrigin::setLooseSize(uint64_t size)
+{
+  std::scoped_lock lock(m_Mutex);
+  m_LooseSize = size;
+}
+
+uint64_t FilesOrigin::looseSize() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return m_LooseSize;
+}
+
+std::size_t FilesOrigin::memoryBytes() const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  std::size_t n = m_Files.allocatedBytes() + vectorBytes(m_DirectoryStamps);
+  for (const auto& stamp : m_DirectoryStamps) {
+    n += stringBytes(stamp.path);
+  }
+
+  return n;
+}
+
+void FilesOrigin::setModIndex(int generation, unsigned int index) const
+{
+  m_ModIndex =
+    (static_cast<uint64_t>(static_cast<uint32_t>(generation)) << 32) | index;
+}
+
+bool FilesOrigin::modIndex(int generation, unsigned int& index) const
+{
+  const uint64_t v = m_ModIndex;
+
+  if ((v >> 32) != static_cast<uint32_t>(generation)) {
+    return false;
+  }
+
+  index = static_cast<unsigned int>(v & 0xffffffff);
+  return true;
+}
+
 } //  namespace
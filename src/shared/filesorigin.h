@@ -2,6 +2,8 @@
 #define MO_REGISTER_FILESORIGIN_INCLUDED
 
 #include "fileregisterfwd.h"
+#include "fileindexset.h"
+#include <atomic>
 
 namespace MOShared
 {
@@ -50,6 +52,21 @@ public:
   std::vector<FileEntryPtr> getFiles() const;
   FileEntryPtr findFile(FileIndex index) const;
 
+  // calls f(FileIndex) for every file of this origin, in order of index;
+  // the origin is locked while it runs, so `f` must not call into it
+  //
+  template <class F>
+  void forEachFileIndex(F&& f) const
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    for (const FileIndex index : m_Files.indices()) {
+      f(index);
+    }
+  }
+
+  std::size_t fileCount() const;
+
   void enable(bool enabled, DirectoryStats& stats);
   void enable(bool enabled);
 
@@ -64,19 +81,98 @@ public:
     m_Files.insert(index);
   }
 
+  // adds all the given files at once, used when merging a walked directory
+  //
+  void addFiles(const std::vector<FileIndex>& indices)
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Files.insert(indices);
+  }
+
   void removeFile(FileIndex index);
 
   bool containsArchive(std::wstring archiveName);
 
+  // remembers the last modification time of the given directory, which is
+  // either the root of this origin or one of its subdirectories; this is
+  // called while the origin is being walked and is used by
+  // directoriesChanged() to figure out if the origin needs to be walked again
+  //
+  void addDirectoryStamp(std::wstring path);
+
+  // same as above with a time that has already been retrieved, such as by
+  // the directory walker; a zeroed time is always considered modified
+  //
+  void addDirectoryStamp(std::wstring path, FILETIME lastModified);
+  void clearDirectoryStamps();
+
+  // whether addDirectoryStamp() was called since the last walk; origins that
+  // were never walked, like the ones that steal files from other origins,
+  // don't have stamps
+  //
+  bool hasDirectoryStamps() const;
+
+  // returns true if any of the directories recorded with addDirectoryStamp()
+  // has been modified, removed or replaced by a file since it was recorded;
+  // this catches files and directories being added, removed or renamed, but
+  // not files being modified in place
+  //
+  bool directoriesChanged() const;
+
+  // the files found by the last walk of this origin, kept so they can be
+  // merged again without walking the origin when it's enabled again, such as
+  // when switching profiles; empty if the origin was never walked or its
+  // files were added some other way
+  //
+  // the names in the tree are in the name arena of the structure, it must not
+  // outlive it
+  //
+  void setWalkedTree(std::shared_ptr<const WalkedDirectory> tree);
+  std::shared_ptr<const WalkedDirectory> walkedTree() const;
+
+  // total size in bytes of the loose files found by the last walk of this
+  // origin, whether they're overwritten or not; like the directory stamps,
+  // files modified in place are only seen by the next walk
+  //
+  void setLooseSize(uint64_t size);
+  uint64_t looseSize() const;
+
+  // bytes allocated for the list of files and the directory stamps
+  //
+  std::size_t memoryBytes() const;
+
+  // the index of the mod of this origin, remembered by the application along
+  // with the generation of the mod list it was looked up in, see
+  // ModInfo::getIndex(const FilesOrigin&); modIndex() returns false if the
+  // index was remembered for another generation
+  //
+  void setModIndex(int generation, unsigned int index) const;
+  bool modIndex(int generation, unsigned int& index) const;
+
 private:
+  friend class DirectorySnapshot;
+
+  struct DirectoryStamp
+  {
+    std::wstring path;
+    FILETIME lastModified;
+  };
+
   OriginID m_ID;
   bool m_Disabled;
-  std::set<FileIndex> m_Files;
+  FileIndexSet m_Files;
   std::wstring m_Name;
   std::wstring m_Path;
   int m_Priority;
   boost::weak_ptr<FileRegister> m_FileRegister;
   boost::weak_ptr<OriginConnection> m_OriginConnection;
+  std::vector<DirectoryStamp> m_DirectoryStamps;
+  std::shared_ptr<const WalkedDirectory> m_WalkedTree;
+  uint64_t m_LooseSize;
+
+  // generation in the high bits, index in the low bits
+  mutable std::atomic<uint64_t> m_ModIndex;
+
   mutable std::mutex m_Mutex;
 };
 
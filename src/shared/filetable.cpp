@@ -0,0 +1,239 @@
+#include "filetable.h"
+#include "fileentry.h"
+
+namespace MOShared
+{
+
+FileTable::FileTable()
+  : m_Chunks(new std::atomic<Chunk*>[MaxChunks]),
+    m_ArchivesByID(new std::atomic<const DataArchiveOrigin*>[MaxArchives])
+{
+  for (std::size_t i=0; i<MaxChunks; ++i) {
+    m_Chunks[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  for (std::size_t i=0; i<MaxArchives; ++i) {
+    m_ArchivesByID[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  m_ArchivesByID[NoArchiveID].store(
+    &DataArchiveOrigin::none(), std::memory_order_relaxed);
+}
+
+FileTable::~FileTable()
+{
+  for (std::size_t i=0; i<MaxChunks; ++i) {
+    delete m_Chunks[i].load(std::memory_order_relaxed);
+  }
+}
+
+std::size_t FileTable::allocatedBytes() const
+{
+  std::size_t bytes = 0;
+
+  for (std::size_t i=0; i<MaxChunks; ++i) {
+    if (m_Chunks[i].load(std::memory_order_acquire)) {
+      bytes += sizeof(Chunk);
+    }
+  }
+
+  std::scoped_lock lock(m_AlternativesMutex);
+  bytes += m_Alternatives.capacity() * sizeof(FileAlternative);
+
+  return bytes;
+}
+
+std::size_t FileTable::rowBytes()
+{
+  return sizeof(Chunk) / ChunkSize;
+}
+
+void FileTable::create(
+  FileIndex index, std::wstring_view name, DirectoryEntry* parent)
+{
+  const auto ci = index / ChunkSize;
+
+  if (ci >= MaxChunks) {
+    throw std::runtime_error("too many files in the structure");
+  }
+
+  Chunk* c = m_Chunks[ci].load(std::memory_order_acquire);
+
+  if (!c) {
+    std::scoped_lock lock(m_ChunksMutex);
+
+    c = m_Chunks[ci].load(std::memory_order_relaxed);
+
+    if (!c) {
+      // value-initialized, rows that were not created yet don't exist
+      c = new Chunk();
+      m_Chunks[ci].store(c, std::memory_order_release);
+    }
+  }
+
+  const auto s = slot(index);
+
+  c->names[s] = name;
+  c->parents[s] = parent;
+  c->origins[s] = InvalidOriginID;
+  c->archives[s] = NoArchiveID;
+  c->fileTimes[s] = {};
+  c->fileSizes[s] = FileEntry::NoFileSize;
+  c->compressedFileSizes[s] = FileEntry::NoFileSize;
+  c->altOffsets[s] = 0;
+  c->altCounts[s] = 0;
+  c->exists[s] = true;
+}
+
+const DataArchiveOrigin& FileTable::archive(std::wstring_view name, int order)
+{
+  if (name.empty()) {
+    return DataArchiveOrigin::none();
+  }
+
+  std::scoped_lock lock(m_ArchivesMutex);
+
+  auto itor = m_ArchivesLookup.find(name);
+  if (itor != m_ArchivesLookup.end()) {
+    itor->second->order_ = order;
+    return *itor->second;
+  }
+
+  // none() has id 0 and is not in the deque
+  const auto id = static_cast<ArchiveID>(m_Archives.size() + 1);
+
+  if (id >= MaxArchives) {
+    throw std::runtime_error("too many archives in the structure");
+  }
+
+  auto& a = m_Archives.emplace_back(std::wstring(name), order, id);
+  m_ArchivesLookup.emplace(a.name(), &a);
+  m_ArchivesByID[id].store(&a, std::memory_order_release);
+
+  return a;
+}
+
+ArchiveID FileTable::findArchive(std::wstring_view name) const
+{
+  if (name.empty()) {
+    return NoArchiveID;
+  }
+
+  std::scoped_lock lock(m_ArchivesMutex);
+
+  auto itor = m_ArchivesLookup.find(name);
+  if (itor == m_ArchivesLookup.end()) {
+    return NoArchiveID;
+  }
+
+  return itor->second->id();
+}
+
+std::vector<ArchiveID> FileTable::setArchiveOrders(
+  const std::function<int (const std::wstring& name)>& orderOf)
+{
+  std::scoped_lock lock(m_ArchivesMutex);
+
+  std::vector<ArchiveID> changed;
+
+  for (auto& a : m_Archives) {
+    const int order = orderOf(a.name());
+
+    if (order != a.order_) {
+      a.order_ = order;
+      changed.push_back(a.id());
+    }
+  }
+
+  return changed;
+}
+
+bool FileTable::archiveOrdersChanged(
+  const std::function<int (const std::wstring& name)>& orderOf) const
+{
+  std::scoped_lock lock(m_ArchivesMutex);
+
+  for (const auto& a : m_Archives) {
+    if (orderOf(a.name()) != a.order_) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+AlternativesVector FileTable::copyAlternatives(FileIndex index) const
+{
+  std::scoped_lock lock(m_AlternativesMutex);
+
+  const auto v = alternatives(index);
+  return {v.begin(), v.end()};
+}
+
+void FileTable::setAlternatives(FileIndex index, AlternativesView alternatives)
+{
+  std::scoped_lock lock(m_AlternativesMutex);
+
+  auto& c = chunk(index);
+  const auto s = slot(index);
+
+  const auto offset = c.altOffsets[s];
+  const auto count = c.altCounts[s];
+  const auto newCount = static_cast<std::uint32_t>(alternatives.size());
+
+  if (newCount <= count) {
+    // fits in the current range
+  } else if (count > 0 && (offset + count) == m_Alternatives.size()) {
+    // the range is at the end of the array, grow it in place
+    m_Alternatives.resize(offset + newCount);
+  } else {
+    // move the row to the end of the array, the old range is left unused
+    // until compactAlternatives() is called
+    c.altOffsets[s] = static_cast<std::uint32_t>(m_Alternatives.size());
+    m_Alternatives.resize(m_Alternatives.size() + newCount);
+  }
+
+  std::copy(
+    alternatives.begin(), alternatives.end(),
+    m_Alternatives.begin() + c.altOffsets[s]);
+
+  c.altCounts[s] = newCount;
+}
+
+void FileTable::compactAlternatives(FileIndex count)
+{
+  std::scoped_lock lock(m_AlternativesMutex);
+
+  std::size_t total = 0;
+
+  for (FileIndex i=0; i<count; ++i) {
+    if (exists(i)) {
+      total += chunk(i).altCounts[slot(i)];
+    }
+  }
+
+  AlternativesVector packed;
+  packed.reserve(total);
+
+  for (FileIndex i=0; i<count; ++i) {
+    auto* c = findChunk(i);
+    if (!c) {
+      continue;
+    }
+
+    const auto s = slot(i);
+
+    if (!c->exists[s]) {
+      c->altCounts[s] = 0;
+    }
+
+    const auto begin = m_Alternatives.begin() + c->altOffsets[s];
+
+    c->altOffsets[s] = static_cast<std::uint32_t>(packed.size());
+    packed.insert(packed.end(), begin, begin + c->altCounts[s]);
+  }
+
+  m_Alternatives = std::move(packed);
+}
+
+} // namespace
@@ -0,0 +1,303 @@
+#ifndef MO_REGISTER_FILETABLE_INCLUDED
+#define MO_REGISTER_FILETABLE_INCLUDED
+
+#include "fileregisterfwd.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace MOShared
+{
+
+// storage for all the files of a structure, owned by the FileRegister
+//
+// files are addressed by their index and every property is stored in its own
+// array, so passes over all the files only touch the properties they need;
+// FileEntry is a view over one row of the table
+//
+// the arrays are allocated in fixed-size chunks that are never moved or
+// freed until the table is destroyed, so rows can be created concurrently
+// while other rows are being read or modified
+//
+// alternatives are stored in a single packed array, each row has the offset
+// and the number of its alternatives in that array; rows whose alternatives
+// grow while the structure is being built are moved to the end of the array,
+// compactAlternatives() rebuilds it once the structure is complete
+//
+class FileTable
+{
+public:
+  // in rows
+  static constexpr std::size_t ChunkSize = 16 * 1024;
+  static constexpr std::size_t MaxChunks = 8 * 1024;
+
+  FileTable();
+  ~FileTable();
+
+  // noncopyable
+  FileTable(const FileTable&) = delete;
+  FileTable& operator=(const FileTable&) = delete;
+
+  // initializes the given row, allocating its chunk if necessary; this is
+  // thread-safe as long as each index is only created once
+  //
+  void create(FileIndex index, std::wstring_view name, DirectoryEntry* parent);
+
+  // whether the row was created and not removed
+  //
+  bool exists(FileIndex index) const
+  {
+    const auto* c = findChunk(index);
+    return (c && c->exists[slot(index)]);
+  }
+
+  void remove(FileIndex index)
+  {
+    chunk(index).exists[slot(index)] = false;
+  }
+
+  // maximum number of archives in the table, including none()
+  static constexpr std::size_t MaxArchives = 16 * 1024;
+
+  // returns the archive origin with the given name that lives as long as the
+  // table, all files from the same archive share it; the order of an
+  // existing archive is changed to the given one
+  //
+  const DataArchiveOrigin& archive(std::wstring_view name, int order);
+
+  // the archive with the given id, which must have been returned by
+  // archive(name, order); this doesn't lock, ids are published once the
+  // archive is complete
+  //
+  const DataArchiveOrigin& archiveByID(ArchiveID id) const
+  {
+    return *m_ArchivesByID[id].load(std::memory_order_acquire);
+  }
+
+  // id of the archive with the given name, NoArchiveID if there's none
+  //
+  ArchiveID findArchive(std::wstring_view name) const;
+
+  // changes the order of every archive to the one returned by `orderOf` for
+  // its name, returns the ids of the archives that changed; files from these
+  // archives must have their origins sorted again
+  //
+  std::vector<ArchiveID> setArchiveOrders(
+    const std::function<int (const std::wstring& name)>& orderOf);
+
+  // whether setArchiveOrders() would change any archive
+  //
+  bool archiveOrdersChanged(
+    const std::function<int (const std::wstring& name)>& orderOf) const;
+
+  std::wstring_view name(FileIndex index) const
+  {
+    return chunk(index).names[slot(index)];
+  }
+
+  DirectoryEntry* parent(FileIndex index) const
+  {
+    return chunk(index).parents[slot(index)];
+  }
+
+  OriginID origin(FileIndex index) const
+  {
+    return chunk(index).origins[slot(index)];
+  }
+
+  ArchiveID archiveID(FileIndex index) const
+  {
+    return chunk(index).archives[slot(index)];
+  }
+
+  const DataArchiveOrigin& archive(FileIndex index) const
+  {
+    return archiveByID(archiveID(index));
+  }
+
+  void setOrigin(FileIndex index, OriginID id, ArchiveID archive)
+  {
+    auto& c = chunk(index);
+    c.origins[slot(index)] = id;
+    c.archives[slot(index)] = archive;
+  }
+
+  void setOrigin(FileIndex index, const FileAlternative& a)
+  {
+    setOrigin(index, a.originID(), a.archiveID());
+  }
+
+  FILETIME fileTime(FileIndex index) const
+  {
+    return chunk(index).fileTimes[slot(index)];
+  }
+
+  void setFileTime(FileIndex index, FILETIME ft)
+  {
+    chunk(index).fileTimes[slot(index)] = ft;
+  }
+
+  uint64_t fileSize(FileIndex index) const
+  {
+    return chunk(index).fileSizes[slot(index)];
+  }
+
+  uint64_t compressedFileSize(FileIndex index) const
+  {
+    return chunk(index).compressedFileSizes[slot(index)];
+  }
+
+  void setFileSize(FileIndex index, uint64_t size, uint64_t compressedSize)
+  {
+    auto& c = chunk(index);
+    c.fileSizes[slot(index)] = size;
+    c.compressedFileSizes[slot(index)] = compressedSize;
+  }
+
+  // the returned view is invalidated when alternatives are changed for any
+  // file in the table, so this must not be called while the structure is
+  // being modified from other threads
+  //
+  AlternativesView alternatives(FileIndex index) const
+  {
+    const auto& c = chunk(index);
+    const auto s = slot(index);
+
+    return {m_Alternatives.data() + c.altOffsets[s], c.altCounts[s]};
+  }
+
+  // thread-safe version of alternatives(), returns a copy
+  //
+  AlternativesVector copyAlternatives(FileIndex index) const;
+
+  void setAlternatives(FileIndex index, AlternativesView alternatives);
+
+  // rebuilds the packed alternatives array so the alternatives of all the
+  // rows are contiguous and in index order, dropping the gaps left by rows
+  // that were moved; must not be called concurrently with anything else
+  //
+  void compactAlternatives(FileIndex count);
+
+  // sorts the origin and the alternatives of every row in [begin, end)
+  // together by key(const FileAlternative&), the one with the highest key
+  // becomes the origin; rows without alternatives are skipped
+  //
+  // the number of alternatives doesn't change, so they're sorted in place
+  // without taking any lock; disjoint ranges can be sorted concurrently as
+  // long as nothing else modifies the table
+  //
+  template <class KeyF>
+  void sortOrigins(FileIndex begin, FileIndex end, KeyF&& key);
+
+  // mutex that must be locked when modifying the origins of the given row;
+  // rows share a fixed number of mutexes
+  //
+  std::mutex& mutex(FileIndex index) const
+  {
+    return m_RowMutexes[index % RowMutexCount];
+  }
+
+  // number of bytes allocated for the chunks and the alternatives; archive
+  // origins are not counted
+  //
+  std::size_t allocatedBytes() const;
+
+  // number of bytes used by one row in the chunks
+  //
+  static std::size_t rowBytes();
+
+private:
+  struct Chunk
+  {
+    std::wstring_view names[ChunkSize];
+    DirectoryEntry* parents[ChunkSize];
+    OriginID origins[ChunkSize];
+    ArchiveID archives[ChunkSize];
+    FILETIME fileTimes[ChunkSize];
+    uint64_t fileSizes[ChunkSize];
+    uint64_t compressedFileSizes[ChunkSize];
+    std::uint32_t altOffsets[ChunkSize];
+    std::uint32_t altCounts[ChunkSize];
+    bool exists[ChunkSize];
+  };
+
+  static constexpr std::size_t RowMutexCount = 64;
+
+  std::unique_ptr<std::atomic<Chunk*>[]> m_Chunks;
+  std::mutex m_ChunksMutex;
+
+  AlternativesVector m_Alternatives;
+  mutable std::mutex m_AlternativesMutex;
+
+  // by id starting at 1, none() is 0; only grows
+  std::deque<DataArchiveOrigin> m_Archives;
+  std::unique_ptr<std::atomic<const DataArchiveOrigin*>[]> m_ArchivesByID;
+  std::map<std::wstring, DataArchiveOrigin*, std::less<>> m_ArchivesLookup;
+  mutable std::mutex m_ArchivesMutex;
+
+  mutable std::mutex m_RowMutexes[RowMutexCount];
+
+  static std::size_t slot(FileIndex index)
+  {
+    return index % ChunkSize;
+  }
+
+  Chunk* findChunk(FileIndex index) const
+  {
+    const auto c = index / ChunkSize;
+    if (c >= MaxChunks) {
+      return nullptr;
+    }
+
+    return m_Chunks[c].load(std::memory_order_acquire);
+  }
+
+  Chunk& chunk(FileIndex index) const
+  {
+    return *m_Chunks[index / ChunkSize].load(std::memory_order_acquire);
+  }
+};
+
+
+template <class KeyF>
+void FileTable::sortOrigins(FileIndex begin, FileIndex end, KeyF&& key)
+{
+  // reused for every row, files rarely have more than a few origins
+  AlternativesVector all;
+
+  for (FileIndex i=begin; i<end; ++i) {
+    auto* c = findChunk(i);
+    if (!c) {
+      continue;
+    }
+
+    const auto s = slot(i);
+    const auto count = c->altCounts[s];
+
+    if (!c->exists[s] || count == 0) {
+      continue;
+    }
+
+    FileAlternative* alts = m_Alternatives.data() + c->altOffsets[s];
+
+    all.assign(alts, alts + count);
+    all.emplace_back(c->origins[s], c->archives[s]);
+
+    std::sort(all.begin(), all.end(), [&](auto&& a, auto&& b) {
+      return key(a) < key(b);
+    });
+
+    c->origins[s] = all.back().originID();
+    c->archives[s] = all.back().archiveID();
+
+    std::copy(all.begin(), all.end() - 1, alts);
+  }
+}
+
+} // namespace
+
+#endif // MO_REGISTER_FILETABLE_INCLUDED
@@ -0,0 +1,150 @@
+#include "ioaccounting.h"
+#include <mutex>
+
+namespace MOShared
+{
+
+namespace
+{
+
+struct AtomicCounters
+{
+  std::atomic<std::uint64_t> opens = 0;
+  std::atomic<std::uint64_t> stats = 0;
+  std::atomic<std::uint64_t> enumerations = 0;
+  std::atomic<std::uint64_t> bytesRead = 0;
+};
+
+std::array<AtomicCounters, static_cast<std::size_t>(
+  IoAccounting::Subsystem::Count)> g_counters;
+
+// snapshots around refreshes, the counters themselves don't need it
+std::mutex g_refreshMutex;
+std::optional<IoAccounting::Snapshot> g_refreshStart;
+std::optional<IoAccounting::Snapshot> g_lastRefresh;
+
+AtomicCounters& counters(IoAccounting::Subsystem s)
+{
+  return g_counters[static_cast<std::size_t>(s)];
+}
+
+void add(std::atomic<std::uint64_t>& a, std::uint64_t n)
+{
+  a.fetch_add(n, std::memory_order_relaxed);
+}
+
+std::uint64_t get(const std::atomic<std::uint64_t>& a)
+{
+  return a.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+
+bool IoAccounting::Counters::empty() const
+{
+  return (opens == 0 && stats == 0 && enumerations == 0 && bytesRead == 0);
+}
+
+void IoAccounting::open(Subsystem s, std::uint64_t n)
+{
+  add(counters(s).opens, n);
+}
+
+void IoAccounting::stat(Subsystem s, std::uint64_t n)
+{
+  add(counters(s).stats, n);
+}
+
+void IoAccounting::enumerate(Subsystem s, std::uint64_t bytes)
+{
+  auto& c = counters(s);
+  add(c.enumerations, 1);
+  add(c.bytesRead, bytes);
+}
+
+void IoAccounting::read(Subsystem s, std::uint64_t bytes)
+{
+  add(counters(s).bytesRead, bytes);
+}
+
+IoAccounting::Snapshot IoAccounting::snapshot()
+{
+  Snapshot ss;
+
+  for (std::size_t i=0; i<ss.size(); ++i) {
+    const auto& c = g_counters[i];
+
+    ss[i].opens = get(c.opens);
+    ss[i].stats = get(c.stats);
+    ss[i].enumerations = get(c.enumerations);
+    ss[i].bytesRead = get(c.bytesRead);
+  }
+
+  return ss;
+}
+
+void IoAccounting::beginRefresh()
+{
+  std::scoped_lock lock(g_refreshMutex);
+
+  if (!g_refreshStart) {
+    g_refreshStart = snapshot();
+  }
+}
+
+void IoAccounting::endRefresh()
+{
+  std::scoped_lock lock(g_refreshMutex);
+
+  if (!g_refreshStart) {
+    return;
+  }
+
+  Snapshot ss = snapshot();
+
+  for (std::size_t i=0; i<ss.size(); ++i) {
+    const auto& start = (*g_refreshStart)[i];
+
+    ss[i].opens -= start.opens;
+    ss[i].stats -= start.stats;
+    ss[i].enumerations -= start.enumerations;
+    ss[i].bytesRead -= start.bytesRead;
+  }
+
+  g_lastRefresh = ss;
+  g_refreshStart.reset();
+}
+
+std::optional<IoAccounting::Snapshot> IoAccounting::lastRefresh()
+{
+  std::scoped_lock lock(g_refreshMutex);
+  return g_lastRefresh;
+}
+
+const char* IoAccounting::name(Subsystem s)
+{
+  switch (s)
+  {
+    case Subsystem::Walks:
+      return "directory walks";
+
+    case Subsystem::Plugins:
+      return "plugin headers";
+
+    case Subsystem::ModMeta:
+      return "mod meta files";
+
+    case Subsystem::DownloadMeta:
+      return "download meta files";
+
+    case Subsystem::Archives:
+      return "archives";
+
+    case Subsystem::Count:  // fall-through
+    default:
+      return "?";
+  }
+}
+
+} // namespace
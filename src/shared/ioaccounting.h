@@ -0,0 +1,89 @@
+#ifndef MO_REGISTER_IOACCOUNTING_INCLUDED
+#define MO_REGISTER_IOACCOUNTING_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace MOShared
+{
+
+// counts the filesystem activity of MO itself, by subsystem: files and
+// directories opened, files stat'ed, directory enumerations and the bytes
+// read by them
+//
+// counters only ever grow; beginRefresh() and endRefresh() take a snapshot
+// around a refresh so the activity of the last one can be shown in the
+// diagnostics settings, which tells which caches would help the most, like
+// on network shares where every open is a round-trip
+//
+// bytes are only counted where the reader reports them, which is the
+// directory enumerations; the other subsystems read small parts of files
+// through libraries that don't say how much they read
+//
+// everything here is thread-safe, counting is a relaxed atomic increment
+//
+class IoAccounting
+{
+public:
+  enum class Subsystem
+  {
+    // env::DirectoryWalker, used by the directory structure and its caches
+    Walks = 0,
+
+    // headers of the plugins read for the plugin list
+    Plugins,
+
+    // meta.ini files of the mods
+    ModMeta,
+
+    // .meta files of the downloads
+    DownloadMeta,
+
+    // indices of the bsa and ba2 archives
+    Archives,
+
+    Count
+  };
+
+  struct Counters
+  {
+    std::uint64_t opens = 0;
+    std::uint64_t stats = 0;
+    std::uint64_t enumerations = 0;
+    std::uint64_t bytesRead = 0;
+
+    bool empty() const;
+  };
+
+  using Snapshot = std::array<
+    Counters, static_cast<std::size_t>(Subsystem::Count)>;
+
+  static void open(Subsystem s, std::uint64_t n=1);
+  static void stat(Subsystem s, std::uint64_t n=1);
+  static void enumerate(Subsystem s, std::uint64_t bytes);
+  static void read(Subsystem s, std::uint64_t bytes);
+
+  // the counters since the process started
+  //
+  static Snapshot snapshot();
+
+  // remembers the counters at the start of a refresh; the difference is
+  // computed by endRefresh(), nested calls are ignored
+  //
+  static void beginRefresh();
+  static void endRefresh();
+
+  // the activity during the last refresh that ended, if any
+  //
+  static std::optional<Snapshot> lastRefresh();
+
+  // like "directory walks"
+  //
+  static const char* name(Subsystem s);
+};
+
+} // namespace
+
+#endif // MO_REGISTER_IOACCOUNTING_INCLUDED
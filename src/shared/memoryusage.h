@@ -0,0 +1,78 @@
+#ifndef MO_REGISTER_MEMORYUSAGE_INCLUDED
+#define MO_REGISTER_MEMORYUSAGE_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace MOShared
+{
+
+// an estimate of the memory used by a set of objects
+//
+// the estimates only count what the containers allocate for their elements
+// and their nodes; the overhead of the heap itself is ignored, so the working
+// set of the process is typically a bit larger than the sum of the estimates
+//
+struct MemoryUsage
+{
+  // number of objects, like directories or files
+  std::size_t count = 0;
+
+  // estimated number of bytes allocated for them
+  std::size_t bytes = 0;
+
+  MemoryUsage& operator+=(const MemoryUsage& u)
+  {
+    count += u.count;
+    bytes += u.bytes;
+    return *this;
+  }
+};
+
+
+// bytes allocated by the string, zero when it fits in the small buffer
+//
+template <class C>
+std::size_t stringBytes(const std::basic_string<C>& s)
+{
+  const auto* p = reinterpret_cast<const char*>(s.data());
+  const auto* self = reinterpret_cast<const char*>(&s);
+
+  if (p >= self && p < self + sizeof(s)) {
+    return 0;
+  }
+
+  return (s.capacity() + 1) * sizeof(C);
+}
+
+template <class T>
+std::size_t vectorBytes(const std::vector<T>& v)
+{
+  return v.capacity() * sizeof(T);
+}
+
+// bytes allocated for the nodes of a std::map or std::set, which have three
+// pointers and a color
+//
+template <class C>
+std::size_t treeBytes(const C& c)
+{
+  return c.size() * (sizeof(typename C::value_type) + 4 * sizeof(void*));
+}
+
+// bytes allocated for the nodes and the buckets of an unordered container;
+// nodes are in a doubly-linked list and each bucket points to its first and
+// last node
+//
+template <class C>
+std::size_t hashBytes(const C& c)
+{
+  return
+    c.size() * (sizeof(typename C::value_type) + 2 * sizeof(void*)) +
+    c.bucket_count() * 2 * sizeof(void*);
+}
+
+} // namespace
+
+#endif // MO_REGISTER_MEMORYUSAGE_INCLUDED
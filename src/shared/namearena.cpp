@@ -0,0 +1,153 @@
+#include "namearena.h"
+
+namespace MOShared
+{
+
+NameArena::NameArena()
+  : m_current(nullptr), m_left(0), m_allocated(0)
+{
+}
+
+std::pair<std::wstring_view, std::wstring_view> NameArena::store(
+  std::wstring_view name, std::wstring_view lcname)
+{
+  std::scoped_lock lock(m_mutex);
+
+  wchar_t* p = allocate(name.size());
+  std::copy(name.begin(), name.end(), p);
+  const std::wstring_view nameView(p, name.size());
+
+  if (name == lcname) {
+    return {nameView, nameView};
+  }
+
+  p = allocate(lcname.size());
+  std::copy(lcname.begin(), lcname.end(), p);
+
+  return {nameView, std::wstring_view(p, lcname.size())};
+}
+
+std::wstring_view NameArena::store(std::wstring_view s)
+{
+  std::scoped_lock lock(m_mutex);
+
+  wchar_t* p = allocate(s.size());
+  std::copy(s.begin(), s.end(), p);
+
+  return {p, s.size()};
+}
+
+std::size_t NameArena::allocatedBytes() const
+{
+  std::scoped_lock lock(m_mutex);
+  return m_allocated;
+}
+
+wchar_t* NameArena::allocate(std::size_t size)
+{
+  if (size > (PageSize / 4)) {
+    // long strings get their own page so they don't waste the remainder of
+    // the current one
+    m_pages.push_back(std::make_unique<wchar_t[]>(size));
+    m_allocated += size * sizeof(wchar_t);
+    return m_pages.back().get();
+  }
+
+  if (size > m_left) {
+    m_pages.push_back(std::make_unique<wchar_t[]>(PageSize));
+    m_allocated += PageSize * sizeof(wchar_t);
+
+    m_current = m_pages.back().get();
+    m_left = PageSize;
+  }
+
+  wchar_t* p = m_current;
+  m_current += size;
+  m_left -= size;
+
+  return p;
+}
+
+NameArena::Remainder NameArena::takePage()
+{
+  std::scoped_lock lock(m_mutex);
+
+  if (!m_remainders.empty()) {
+    const auto r = m_remainders.back();
+    m_remainders.pop_back();
+    return r;
+  }
+
+  m_pages.push_back(std::make_unique<wchar_t[]>(PageSize));
+  m_allocated += PageSize * sizeof(wchar_t);
+
+  return {m_pages.back().get(), PageSize};
+}
+
+void NameArena::giveBack(wchar_t* p, std::size_t left)
+{
+  // remainders must be able to hold any string a Local allocates itself
+  if (left < (PageSize / 4)) {
+    return;
+  }
+
+  std::scoped_lock lock(m_mutex);
+  m_remainders.push_back({p, left});
+}
+
+
+NameArena::Local::Local(NameArena& arena)
+  : m_arena(arena), m_current(nullptr), m_left(0)
+{
+}
+
+NameArena::Local::~Local()
+{
+  if (m_current) {
+    m_arena.giveBack(m_current, m_left);
+  }
+}
+
+std::pair<std::wstring_view, std::wstring_view> NameArena::Local::store(
+  std::wstring_view name, std::wstring_view lcname)
+{
+  wchar_t* p = allocate(name.size());
+  std::copy(name.begin(), name.end(), p);
+  const std::wstring_view nameView(p, name.size());
+
+  if (name == lcname) {
+    return {nameView, nameView};
+  }
+
+  p = allocate(lcname.size());
+  std::copy(lcname.begin(), lcname.end(), p);
+
+  return {nameView, std::wstring_view(p, lcname.size())};
+}
+
+wchar_t* NameArena::Local::allocate(std::size_t size)
+{
+  if (size > (PageSize / 4)) {
+    // long strings are rare, let the arena handle them
+    std::scoped_lock lock(m_arena.m_mutex);
+    return m_arena.allocate(size);
+  }
+
+  if (size > m_left) {
+    if (m_current) {
+      m_arena.giveBack(m_current, m_left);
+    }
+
+    const auto r = m_arena.takePage();
+    m_current = r.p;
+    m_left = r.left;
+  }
+
+  wchar_t* p = m_current;
+  m_current += size;
+  m_left -= size;
+
+  return p;
+}
+
+} // namespace
@@ -0,0 +1,99 @@
+#ifndef MO_REGISTER_NAMEARENA_INCLUDED
+#define MO_REGISTER_NAMEARENA_INCLUDED
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace MOShared
+{
+
+// bump allocator for the names of the files in a structure, owned by the
+// FileRegister
+//
+// strings stored in the arena are never freed individually, the pages are all
+// released at once when the arena is destroyed along with the structure, so
+// views returned by the arena stay valid for the lifetime of the structure
+//
+class NameArena
+{
+public:
+  // allocates from pages taken from the arena so the arena only has to be
+  // locked when a page is full; used by the refresher threads, each one
+  // having its own
+  //
+  // an instance must only be used by one thread at a time, the unused part of
+  // its page is given back to the arena when it's destroyed
+  //
+  class Local
+  {
+  public:
+    Local(NameArena& arena);
+    ~Local();
+
+    // noncopyable
+    Local(const Local&) = delete;
+    Local& operator=(const Local&) = delete;
+
+    // see NameArena::store()
+    //
+    std::pair<std::wstring_view, std::wstring_view> store(
+      std::wstring_view name, std::wstring_view lcname);
+
+  private:
+    NameArena& m_arena;
+    wchar_t* m_current;
+    std::size_t m_left;
+
+    wchar_t* allocate(std::size_t size);
+  };
+
+
+  NameArena();
+
+  // noncopyable
+  NameArena(const NameArena&) = delete;
+  NameArena& operator=(const NameArena&) = delete;
+
+  // copies both strings into the arena and returns views over the copies; if
+  // both strings are equal, which is common for lowercase file names, they are
+  // only stored once and both views point to the same characters
+  //
+  std::pair<std::wstring_view, std::wstring_view> store(
+    std::wstring_view name, std::wstring_view lcname);
+
+  std::wstring_view store(std::wstring_view s);
+
+  // number of bytes allocated for the pages
+  //
+  std::size_t allocatedBytes() const;
+
+private:
+  // in characters
+  static constexpr std::size_t PageSize = 64 * 1024;
+
+  struct Remainder
+  {
+    wchar_t* p;
+    std::size_t left;
+  };
+
+  std::vector<std::unique_ptr<wchar_t[]>> m_pages;
+  std::vector<Remainder> m_remainders;
+  wchar_t* m_current;
+  std::size_t m_left;
+  std::size_t m_allocated;
+  mutable std::mutex m_mutex;
+
+  wchar_t* allocate(std::size_t size);
+
+  // returns a page for a Local, reusing remainders given back by other ones
+  //
+  Remainder takePage();
+  void giveBack(wchar_t* p, std::size_t left);
+};
+
+} // namespace
+
+#endif // MO_REGISTER_NAMEARENA_INCLUDED
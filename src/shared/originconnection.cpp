@@ -21,7 +21,7 @@ std::pair<FilesOrigin&, bool> OriginConnection::getOrCreate(
 {
   std::unique_lock lock(m_Mutex);
 
-  auto itor = m_OriginsNameMap.find(originName);
+  auto itor = m_OriginsNameMap.find(ToLowerCopy(originName));
 
   if (itor == m_OriginsNameMap.end()) {
     FilesOrigin& origin = createOriginNoLock(
@@ -29,7 +29,7 @@ std::pair<FilesOrigin&, bool> OriginConnection::getOrCreate(
 
     return {origin, true};
   } else {
-    FilesOrigin& origin = m_Origins[itor->second];
+    FilesOrigin& origin = *m_Origins[itor->second];
     lock.unlock();
 
     origin.enable(true, stats);
@@ -51,36 +51,43 @@ FilesOrigin& OriginConnection::createOrigin(
 bool OriginConnection::exists(const std::wstring &name)
 {
   std::scoped_lock lock(m_Mutex);
-  return m_OriginsNameMap.find(name) != m_OriginsNameMap.end();
+  return m_OriginsNameMap.find(ToLowerCopy(name)) != m_OriginsNameMap.end();
 }
 
 FilesOrigin& OriginConnection::getByID(OriginID ID)
 {
   std::scoped_lock lock(m_Mutex);
-  return m_Origins[ID];
+
+  if (auto* origin=findByIDNoLock(ID)) {
+    return *origin;
+  }
+
+  return m_Unknown;
 }
 
 const FilesOrigin* OriginConnection::findByID(OriginID ID) const
 {
   std::scoped_lock lock(m_Mutex);
+  return findByIDNoLock(ID);
+}
 
-  auto itor = m_Origins.find(ID);
-
-  if (itor == m_Origins.end()) {
+FilesOrigin* OriginConnection::findByIDNoLock(OriginID ID) const
+{
+  if (ID < 0 || static_cast<std::size_t>(ID) >= m_Origins.size()) {
     return nullptr;
-  } else {
-    return &itor->second;
   }
+
+  return m_Origins[static_cast<std::size_t>(ID)].get();
 }
 
 FilesOrigin& OriginConnection::getByName(const std::wstring &name)
 {
   std::scoped_lock lock(m_Mutex);
 
-  auto iter = m_OriginsNameMap.find(name);
+  auto iter = m_OriginsNameMap.find(ToLowerCopy(name));
 
   if (iter != m_OriginsNameMap.end()) {
-    return m_Origins[iter->second];
+    return *m_Origins[iter->second];
   } else {
     std::ostringstream stream;
     stream << QObject::tr("invalid origin name: ").toStdString() << ToString(name, true);
@@ -92,12 +99,12 @@ void OriginConnection::changeNameLookup(const std::wstring &oldName, const std::
 {
   std::scoped_lock lock(m_Mutex);
 
-  auto iter = m_OriginsNameMap.find(oldName);
+  auto iter = m_OriginsNameMap.find(ToLowerCopy(oldName));
 
   if (iter != m_OriginsNameMap.end()) {
     OriginID idx = iter->second;
     m_OriginsNameMap.erase(iter);
-    m_OriginsNameMap[newName] = idx;
+    m_OriginsNameMap[ToLowerCopy(newName)] = idx;
   } else {
     log::error(QObject::tr("failed to change name lookup from {} to {}").toStdString(), oldName, newName);
   }
@@ -115,17 +122,17 @@ FilesOrigin& OriginConnection::createOriginNoLock(
 {
   OriginID newID = createID();
 
-  auto itor = m_Origins.emplace(
-    std::piecewise_construct,
-    std::forward_as_tuple(newID),
-    std::forward_as_tuple(
-      newID, originName, directory, priority,
-      fileRegister, originConnection))
-    .first;
+  const auto i = static_cast<std::size_t>(newID);
+  if (i >= m_Origins.size()) {
+    m_Origins.resize(i + 1);
+  }
+
+  m_Origins[i] = std::make_unique<FilesOrigin>(
+    newID, originName, directory, priority, fileRegister, originConnection);
 
-  m_OriginsNameMap.insert({originName, newID});
+  m_OriginsNameMap.insert({ToLowerCopy(originName), newID});
 
-  return itor->second;
+  return *m_Origins[i];
 }
 
 } // namespace
@@ -2,10 +2,17 @@
 #define MO_REGISTER_ORIGINCONNECTION_INCLUDED
 
 #include "fileregisterfwd.h"
+#include "filesorigin.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace MOShared
 {
 
+// the origins of a structure; ids are given in order from 0, so origins are
+// in a vector indexed by id, and names are looked up case-insensitively
+//
 class OriginConnection
 {
 public:
@@ -28,6 +35,9 @@ public:
 
   bool exists(const std::wstring &name);
 
+  // returns an empty origin that's not part of the structure if the id
+  // doesn't exist
+  //
   FilesOrigin &getByID(OriginID ID);
   const FilesOrigin* findByID(OriginID ID) const;
   FilesOrigin &getByName(const std::wstring &name);
@@ -36,13 +46,37 @@ public:
 
   void changeNameLookup(const std::wstring &oldName, const std::wstring &newName);
 
+  // calls f(FilesOrigin&) for all origins, including disabled ones; origins
+  // must not be created from within f
+  //
+  template <class F>
+  void forEachOrigin(F&& f)
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    for (auto&& origin : m_Origins) {
+      if (origin) {
+        f(*origin);
+      }
+    }
+  }
+
 private:
   std::atomic<OriginID> m_NextID;
-  std::map<OriginID, FilesOrigin> m_Origins;
-  std::map<std::wstring, OriginID> m_OriginsNameMap;
+
+  // indexed by id
+  std::vector<std::unique_ptr<FilesOrigin>> m_Origins;
+
+  // keyed by the lowercase name
+  std::unordered_map<std::wstring, OriginID> m_OriginsNameMap;
+
+  // returned by getByID() for ids that don't exist
+  FilesOrigin m_Unknown;
+
   mutable std::mutex m_Mutex;
 
   OriginID createID();
+  FilesOrigin* findByIDNoLock(OriginID ID) const;
 
   FilesOrigin& createOriginNoLock(
     const std::wstring &originName, const std::wstring &directory, int priority,
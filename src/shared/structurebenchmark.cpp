@@ -0,0 +1,402 @@
+#include "structurebenchmark.h"
+#include "directoryentry.h"
+#include "fileentry.h"
+#include "filesorigin.h"
+#include "util.h"
+#include "../envfs.h"
+#include <algorithm>
+
+namespace MOShared
+{
+
+struct StructureBenchmark::Layout
+{
+  // relative paths of the loose files of each mod
+  std::vector<std::vector<std::wstring>> mods;
+
+  // relative paths of the files in the archives, one per mod for the first
+  // mods
+  std::vector<std::vector<std::wstring>> archives;
+
+  // every distinct path of the layout, searched by searchFile()
+  std::vector<std::wstring> paths;
+};
+
+
+template <class F>
+static std::chrono::nanoseconds timed(F&& f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::steady_clock::now() - start;
+}
+
+template <class F>
+static void forEachFileRecursive(const DirectoryEntry& d, F&& f)
+{
+  d.forEachFile([&](const FileEntry& file) {
+    f(file);
+    return true;
+  });
+
+  d.forEachDirectory([&](const DirectoryEntry& sd) {
+    forEachFileRecursive(sd, f);
+    return true;
+  });
+}
+
+// walks the directories of the given path from the root, creating them with
+// makeDir(name), and returns the directory of the file; `name` is set to the
+// file name
+//
+template <class Dir, class MakeDir>
+static Dir& descend(
+  Dir& root, std::wstring_view path, std::wstring_view& name, MakeDir&& makeDir)
+{
+  Dir* d = &root;
+  std::size_t start = 0;
+
+  for (;;) {
+    const auto sep = path.find(L'\\', start);
+    if (sep == std::wstring_view::npos) {
+      break;
+    }
+
+    const auto part = path.substr(start, sep - start);
+
+    auto itor = std::find_if(d->dirs.begin(), d->dirs.end(), [&](auto&& sd) {
+      return (sd.name == part);
+    });
+
+    if (itor == d->dirs.end()) {
+      d->dirs.push_back(makeDir(part));
+      d = &d->dirs.back();
+    } else {
+      d = &*itor;
+    }
+
+    start = sep + 1;
+  }
+
+  name = path.substr(start);
+  return *d;
+}
+
+static std::wstring modName(int i)
+{
+  return L"mod" + std::to_wstring(i);
+}
+
+static std::wstring modPath(int i)
+{
+  return L"C:\\benchmark\\mods\\" + modName(i);
+}
+
+
+StructureBenchmark::StructureBenchmark(Options o)
+  : m_options(o), m_layout(new Layout)
+{
+  createLayout();
+}
+
+StructureBenchmark::~StructureBenchmark() = default;
+
+void StructureBenchmark::createLayout()
+{
+  const int shared = m_options.files * m_options.overlap / 100;
+
+  // spreads the files over 8 directories per level
+  auto dirs = [&](int seed) {
+    std::wstring s;
+
+    for (int level=0; level<m_options.depth; ++level) {
+      s += L"Dir" + std::to_wstring((seed >> (3 * level)) & 7) + L"\\";
+    }
+
+    return s;
+  };
+
+  for (int m=0; m<m_options.mods; ++m) {
+    std::vector<std::wstring> files;
+
+    for (int f=0; f<m_options.files; ++f) {
+      std::wstring path;
+
+      if (f < shared) {
+        path = dirs(f) + L"Shared" + std::to_wstring(f) + L".dds";
+
+        if (m == 0) {
+          m_layout->paths.push_back(path);
+        }
+      } else {
+        path = dirs(f) +
+          L"Mod" + std::to_wstring(m) + L"_" + std::to_wstring(f) + L".nif";
+
+        m_layout->paths.push_back(path);
+      }
+
+      files.push_back(std::move(path));
+    }
+
+    m_layout->mods.push_back(std::move(files));
+  }
+
+  for (int m=0; m<std::min(m_options.archives, m_options.mods); ++m) {
+    std::vector<std::wstring> files;
+
+    for (int f=0; f<m_options.files / 2; ++f) {
+      if (f % 2 == 0) {
+        // overwritten by the loose file of the mod
+        files.push_back(m_layout->mods[m][f]);
+      } else {
+        auto path = dirs(f) +
+          L"Archive" + std::to_wstring(m) + L"_" + std::to_wstring(f) + L".dds";
+
+        m_layout->paths.push_back(path);
+        files.push_back(std::move(path));
+      }
+    }
+
+    m_layout->archives.push_back(std::move(files));
+  }
+}
+
+std::vector<env::Directory> StructureBenchmark::listTrees() const
+{
+  std::vector<env::Directory> trees;
+
+  for (const auto& files : m_layout->mods) {
+    env::Directory root;
+
+    for (const auto& path : files) {
+      std::wstring_view name;
+
+      auto& d = descend(root, path, name, [](std::wstring_view n) {
+        return env::Directory(n);
+      });
+
+      d.files.emplace_back(name, FILETIME{}, 0);
+    }
+
+    trees.push_back(std::move(root));
+  }
+
+  return trees;
+}
+
+std::vector<WalkedDirectory> StructureBenchmark::walkedTrees(
+  NameArena& names) const
+{
+  NameArena::Local local(names);
+  std::vector<WalkedDirectory> trees;
+
+  for (const auto& files : m_layout->mods) {
+    WalkedDirectory root;
+
+    for (const auto& path : files) {
+      std::wstring_view name;
+
+      auto& d = descend(root, path, name, [](std::wstring_view n) {
+        WalkedDirectory wd;
+        wd.name.assign(n.begin(), n.end());
+        return wd;
+      });
+
+      const auto stored = local.store(name, ToLowerCopy(name));
+      d.files.push_back({stored.first, stored.second, FILETIME{}});
+    }
+
+    trees.push_back(std::move(root));
+  }
+
+  return trees;
+}
+
+std::int64_t StructureBenchmark::addArchives(DirectoryEntry& root) const
+{
+  DirectoryStats stats;
+  std::int64_t count = 0;
+
+  for (std::size_t m=0; m<m_layout->archives.size(); ++m) {
+    const auto i = static_cast<int>(m);
+
+    FilesOrigin& origin = root.createOrigin(modName(i), modPath(i), i, stats);
+
+    const auto& archive = root.m_FileRegister->archive(
+      modName(i) + L".bsa", i);
+
+    for (const auto& path : m_layout->archives[m]) {
+      const auto sep = path.find_last_of(L'\\');
+
+      DirectoryEntry* d = &root;
+      if (sep != std::wstring::npos) {
+        d = root.getSubDirectoryRecursive(
+          path.substr(0, sep), true, stats, origin.getID());
+      }
+
+      const auto name = std::wstring_view(path).substr(
+        sep == std::wstring::npos ? 0 : sep + 1);
+
+      d->insert(name, origin, FILETIME{}, archive, stats);
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+std::vector<StructureBenchmark::Result> StructureBenchmark::runOnce(
+  bool walked, int run)
+{
+  std::vector<Result> results;
+
+  auto add = [&](const char* phase, std::int64_t count, std::chrono::nanoseconds t) {
+    results.push_back({walked ? "walked" : "list", phase, run, count, t});
+  };
+
+  auto root = std::make_unique<DirectoryEntry>(L"data", nullptr, 0);
+  auto fr = root->getFileRegister();
+  DirectoryStats stats;
+
+  // the trees are built before the timer is started, only adding them to
+  // the structure is timed
+  std::vector<env::Directory> lists;
+  std::vector<WalkedDirectory> walkedDirs;
+
+  if (walked) {
+    walkedDirs = walkedTrees(fr->names());
+  } else {
+    lists = listTrees();
+  }
+
+  add("insert", 0, timed([&] {
+    if (walked) {
+      DirectoryEntry::MergeSources sources;
+
+      for (int m=0; m<m_options.mods; ++m) {
+        auto& origin = root->createOrigin(modName(m), modPath(m), m, stats);
+        sources.push_back({&origin, &walkedDirs[m]});
+      }
+
+      root->mergeRecursive(sources, stats);
+    } else {
+      for (int m=0; m<m_options.mods; ++m) {
+        root->addFromList(modName(m), modPath(m), lists[m], m, stats);
+      }
+    }
+
+    addArchives(*root);
+  }));
+
+  const auto fileCount = static_cast<std::int64_t>(fr->highestCount());
+  results.back().count = fileCount;
+
+  add("sortOrigins", fileCount, timed([&] {
+    fr->sortOrigins();
+  }));
+
+  add("conflictGraph", m_options.mods, timed([&] {
+    fr->conflicts().rebuild(L".mohidden");
+  }));
+
+  std::int64_t conflicted = 0;
+  add("conflictScan", 0, timed([&] {
+    forEachFileRecursive(*root, [&](const FileEntry& f) {
+      if (!f.getAlternatives().empty()) {
+        ++conflicted;
+      }
+    });
+  }));
+  results.back().count = conflicted;
+
+  std::int64_t found = 0;
+  add("searchFile", 0, timed([&] {
+    for (const auto& p : m_layout->paths) {
+      if (root->searchFile(p)) {
+        ++found;
+      }
+    }
+  }));
+  results.back().count = found;
+
+  std::int64_t paths = 0;
+  add("getFullPath", 0, timed([&] {
+    std::wstring path;
+
+    forEachFileRecursive(*root, [&](const FileEntry& f) {
+      path.clear();
+      if (f.appendFullPath(path)) {
+        ++paths;
+      }
+    });
+  }));
+  results.back().count = paths;
+
+  fr.reset();
+
+  add("teardown", fileCount, timed([&] {
+    root.reset();
+  }));
+
+  return results;
+}
+
+std::vector<StructureBenchmark::Result> StructureBenchmark::run()
+{
+  std::vector<Result> results;
+
+  for (bool walked : {false, true}) {
+    for (int r=0; r<m_options.runs; ++r) {
+      auto v = runOnce(walked, r);
+      results.insert(results.end(), v.begin(), v.end());
+    }
+  }
+
+  // medians, in the order of the phases of the first run of each source
+  std::vector<Result> medians;
+
+  for (const auto& r : results) {
+    if (r.run != 0) {
+      continue;
+    }
+
+    std::vector<std::chrono::nanoseconds> times;
+
+    for (const auto& o : results) {
+      if (o.source == r.source && o.phase == r.phase) {
+        times.push_back(o.time);
+      }
+    }
+
+    std::sort(times.begin(), times.end());
+
+    Result m = r;
+    m.run = -1;
+    m.time = times[times.size() / 2];
+
+    medians.push_back(std::move(m));
+  }
+
+  results.insert(results.end(), medians.begin(), medians.end());
+
+  return results;
+}
+
+std::string StructureBenchmark::csvHeader()
+{
+  return "source,phase,run,mods,files,depth,overlap,archives,count,ns";
+}
+
+std::string StructureBenchmark::toCsv(const Result& r) const
+{
+  const auto num = [](auto i) { return std::to_string(i); };
+
+  return
+    r.source + "," + r.phase + "," +
+    (r.run < 0 ? std::string("median") : num(r.run)) + "," +
+    num(m_options.mods) + "," + num(m_options.files) + "," +
+    num(m_options.depth) + "," + num(m_options.overlap) + "," +
+    num(m_options.archives) + "," + num(r.count) + "," + num(r.time.count());
+}
+
+} // namespace
@@ -0,0 +1,113 @@
+#ifndef MO_REGISTER_STRUCTUREBENCHMARK_INCLUDED
+#define MO_REGISTER_STRUCTUREBENCHMARK_INCLUDED
+
+#include "fileregisterfwd.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace env { struct Directory; }
+
+namespace MOShared
+{
+
+struct WalkedDirectory;
+class NameArena;
+
+// builds directory structures from synthetic mod layouts and times the main
+// operations on them, used by the `benchmark-structure` command
+//
+// nothing touches the disk: the loose files of the mods are added either with
+// DirectoryEntry::addFromList(), like the ui does for single mods, or as
+// walked trees merged with DirectoryEntry::mergeRecursive(), like the
+// refresher does; archives are added file by file with their own
+// DataArchiveOrigin, like addFromBSA()
+//
+// layouts only depend on the options, so the numbers can be compared between
+// builds
+//
+class StructureBenchmark
+{
+public:
+  struct Options
+  {
+    // number of mods and number of loose files in each one
+    int mods = 200;
+    int files = 500;
+
+    // number of directories above each file
+    int depth = 3;
+
+    // percentage of the files of a mod that have the same path in all the
+    // other mods
+    int overlap = 30;
+
+    // number of mods that also have an archive, which has half as many files
+    // as there are loose files, half of them overwritten by loose files
+    int archives = 20;
+
+    // number of times each source is benchmarked
+    int runs = 5;
+  };
+
+  // one timed phase
+  //
+  struct Result
+  {
+    // "list" or "walked"
+    std::string source;
+
+    // insert, sortOrigins, conflictGraph, conflictScan, searchFile,
+    // getFullPath or teardown
+    std::string phase;
+
+    // number of the run, -1 for the median of all the runs
+    int run;
+
+    // number of items handled by the phase, to check that runs are comparable
+    std::int64_t count;
+
+    std::chrono::nanoseconds time;
+  };
+
+  StructureBenchmark(Options o);
+  ~StructureBenchmark();
+
+  // noncopyable
+  StructureBenchmark(const StructureBenchmark&) = delete;
+  StructureBenchmark& operator=(const StructureBenchmark&) = delete;
+
+  // runs all the phases for both sources, followed by the median of each
+  // phase
+  //
+  std::vector<Result> run();
+
+  static std::string csvHeader();
+  std::string toCsv(const Result& r) const;
+
+private:
+  struct Layout;
+
+  Options m_options;
+  std::unique_ptr<Layout> m_layout;
+
+  void createLayout();
+
+  // the trees of all the mods for addFromList(), which moves from them
+  //
+  std::vector<env::Directory> listTrees() const;
+
+  // the trees of all the mods for mergeRecursive(), stored in the given
+  // arena
+  //
+  std::vector<WalkedDirectory> walkedTrees(NameArena& names) const;
+
+  std::vector<Result> runOnce(bool walked, int run);
+
+  std::int64_t addArchives(DirectoryEntry& root) const;
+};
+
+} // namespace
+
+#endif // MO_REGISTER_STRUCTUREBENCHMARK_INCLUDED
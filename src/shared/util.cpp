@@ -1,444 +1,571 @@
-/*
-Copyright (C) 2012 Sebastian Herbord. All rights reserved.
-
-This file is part of Mod Organizer.
-
-Mod Organizer is free software: you can redistribute it and/or modify
-it under the terms of the GNU General Public License as published by
-the Free Software Foundation, either version 3 of the License, or
-(at your option) any later version.
-
-Mod Organizer is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#include "util.h"
-#include "windows_error.h"
-#include "../mainwindow.h"
-#include "../env.h"
-#include <log.h>
-#include <usvfs.h>
-#include <usvfs_version.h>
-
-using namespace MOBase;
-
-namespace MOShared
-{
-
-bool FileExists(const std::string &filename)
-{
-  DWORD dwAttrib = ::GetFileAttributesA(filename.c_str());
-
-  return (dwAttrib != INVALID_FILE_ATTRIBUTES);
-}
-
-bool FileExists(const std::wstring &filename)
-{
-  DWORD dwAttrib = ::GetFileAttributesW(filename.c_str());
-
-  return (dwAttrib != INVALID_FILE_ATTRIBUTES);
-}
-
-bool FileExists(const std::wstring &searchPath, const std::wstring &filename)
-{
-  std::wstringstream stream;
-  stream << searchPath << "\\" << filename;
-  return FileExists(stream.str());
-}
-
-std::string ToString(const std::wstring &source, bool utf8)
-{
-  std::string result;
-  if (source.length() > 0) {
-    UINT codepage = CP_UTF8;
-    if (!utf8) {
-      codepage = AreFileApisANSI() ? GetACP() : GetOEMCP();
-    }
-    int sizeRequired = ::WideCharToMultiByte(codepage, 0, &source[0], -1, nullptr, 0, nullptr, nullptr);
-    if (sizeRequired == 0) {
-      throw windows_error("failed to convert string to multibyte");
-    }
-    // the size returned by WideCharToMultiByte contains zero termination IF -1 is specified for the length.
-    // we don't want that \0 in the string because then the length field would be wrong. Because madness
-    result.resize(sizeRequired - 1, '\0');
-    ::WideCharToMultiByte(codepage, 0, &source[0], (int)source.size(), &result[0], sizeRequired, nullptr, nullptr);
-  }
-
-  return result;
-}
-
-std::wstring ToWString(const std::string &source, bool utf8)
-{
-  std::wstring result;
-  if (source.length() > 0) {
-    UINT codepage = CP_UTF8;
-    if (!utf8) {
-      codepage = AreFileApisANSI() ? GetACP() : GetOEMCP();
-    }
-    int sizeRequired
-        = ::MultiByteToWideChar(codepage, 0, source.c_str(),
-                                static_cast<int>(source.length()), nullptr, 0);
-    if (sizeRequired == 0) {
-      throw windows_error("failed to convert string to wide character");
-    }
-    result.resize(sizeRequired, L'\0');
-    ::MultiByteToWideChar(codepage, 0, source.c_str(),
-                          static_cast<int>(source.length()), &result[0],
-                          sizeRequired);
-  }
-
-  return result;
-}
-
-static std::locale loc("");
-static auto locToLowerW = [] (wchar_t in) -> wchar_t {
-  return std::tolower(in, loc);
-};
-
-static auto locToLower = [] (char in) -> char {
-  return std::tolower(in, loc);
-};
-
-std::string& ToLowerInPlace(std::string& text)
-{
-  CharLowerBuffA(const_cast<CHAR *>(text.c_str()), static_cast<DWORD>(text.size()));
-  return text;
-}
-
-std::string ToLowerCopy(const std::string& text)
-{
-  std::string result(text);
-  CharLowerBuffA(const_cast<CHAR *>(result.c_str()), static_cast<DWORD>(result.size()));
-  return result;
-}
-
-std::wstring& ToLowerInPlace(std::wstring& text)
-{
-  CharLowerBuffW(const_cast<WCHAR *>(text.c_str()), static_cast<DWORD>(text.size()));
-  return text;
-}
-
-std::wstring ToLowerCopy(const std::wstring& text)
-{
-  std::wstring result(text);
-  CharLowerBuffW(const_cast<WCHAR *>(result.c_str()), static_cast<DWORD>(result.size()));
-  return result;
-}
-
-std::wstring ToLowerCopy(std::wstring_view text)
-{
-  std::wstring result(text.begin(), text.end());
-  ToLowerInPlace(result);
-  return result;
-}
-
-bool CaseInsenstiveComparePred(wchar_t lhs, wchar_t rhs)
-{
-  return std::tolower(lhs, loc) == std::tolower(rhs, loc);
-}
-
-bool CaseInsensitiveEqual(const std::wstring &lhs, const std::wstring &rhs)
-{
-  return (lhs.length() == rhs.length())
-      && std::equal(lhs.begin(), lhs.end(),
-                    rhs.begin(),
-                    [] (wchar_t lhs, wchar_t rhs) -> bool {
-                      return std::tolower(lhs, loc) == std::tolower(rhs, loc);
-                    });
-}
-
-VS_FIXEDFILEINFO GetFileVersion(const std::wstring &fileName)
-{
-  DWORD handle = 0UL;
-  DWORD size = ::GetFileVersionInfoSizeW(fileName.c_str(), &handle);
-  if (size == 0) {
-    throw windows_error("failed to determine file version info size");
-  }
-
-  boost::scoped_array<char> buffer(new char[size]);
-  try {
-    handle = 0UL;
-    if (!::GetFileVersionInfoW(fileName.c_str(), handle, size, buffer.get())) {
-      throw windows_error("failed to determine file version info");
-    }
-
-    void *versionInfoPtr = nullptr;
-    UINT versionInfoLength = 0;
-    if (!::VerQueryValue(buffer.get(), L"\\", &versionInfoPtr, &versionInfoLength)) {
-      throw windows_error("failed to determine file version");
-    }
-
-    VS_FIXEDFILEINFO result = *(VS_FIXEDFILEINFO*)versionInfoPtr;
-    return result;
-  } catch (...) {
-    throw;
-  }
-}
-
-std::wstring GetFileVersionString(const std::wstring &fileName)
-{
-  DWORD handle = 0UL;
-  DWORD size = ::GetFileVersionInfoSizeW(fileName.c_str(), &handle);
-  if (size == 0) {
-    throw windows_error("failed to determine file version info size");
-  }
-
-  boost::scoped_array<char> buffer(new char[size]);
-  try {
-    handle = 0UL;
-    if (!::GetFileVersionInfoW(fileName.c_str(), handle, size, buffer.get())) {
-      throw windows_error("failed to determine file version info");
-    }
-
-    LPVOID strBuffer = nullptr;
-    UINT strLength = 0;
-    if (!::VerQueryValue(buffer.get(), L"\\StringFileInfo\\040904B0\\ProductVersion", &strBuffer, &strLength)) {
-      throw windows_error("failed to determine file version");
-    }
-
-    return std::wstring((LPCTSTR)strBuffer);
-  }
-  catch (...) {
-    throw;
-  }
-}
-
-VersionInfo createVersionInfo()
-{
-  VS_FIXEDFILEINFO version = GetFileVersion(env::thisProcessPath().native());
-
-  if (version.dwFileFlags & VS_FF_PRERELEASE)
-  {
-    // Pre-release builds need annotating
-    QString versionString = QString::fromStdWString(
-      GetFileVersionString(env::thisProcessPath().native()));
-
-    // The pre-release flag can be set without the string specifying what type of pre-release
-    bool noLetters = true;
-    for (QChar character : versionString)
-    {
-      if (character.isLetter())
-      {
-        noLetters = false;
-        break;
-      }
-    }
-
-    if (noLetters)
-    {
-      // Default to pre-alpha when release type is unspecified
-      return VersionInfo(version.dwFileVersionMS >> 16,
-                         version.dwFileVersionMS & 0xFFFF,
-                         version.dwFileVersionLS >> 16,
-                         version.dwFileVersionLS & 0xFFFF,
-                         VersionInfo::RELEASE_PREALPHA);
-    }
-    else
-    {
-      // Trust the string to make sense
-      return VersionInfo(versionString);
-    }
-  }
-  else
-  {
-    // Non-pre-release builds just need their version numbers reading
-    return VersionInfo(version.dwFileVersionMS >> 16,
-                       version.dwFileVersionMS & 0xFFFF,
-                       version.dwFileVersionLS >> 16,
-                       version.dwFileVersionLS & 0xFFFF);
-  }
-}
-
-QString getUsvfsDLLVersion()
-{
-  // once 2.2.2 is released, this can be changed to call USVFSVersionString()
-  // directly; until then, using GetProcAddress() allows for mixing up devbuilds
-  // and usvfs dlls
-
-  using USVFSVersionStringType = const char* WINAPI ();
-
-  QString s;
-
-  const auto m = ::LoadLibraryW(L"usvfs_x64.dll");
-
-  if (m) {
-    auto* f = reinterpret_cast<USVFSVersionStringType*>(
-      ::GetProcAddress(m, "USVFSVersionString"));
-
-    if (f) {
-      s = f();
-    }
-
-    ::FreeLibrary(m);
-  }
-
-  if (s.isEmpty()) {
-    s = "?";
-  }
-
-  return s;
-}
-
-QString getUsvfsVersionString()
-{
-  const QString dll = getUsvfsDLLVersion();
-  const QString header = USVFS_VERSION_STRING;
-
-  QString usvfsVersion;
-
-  if (dll == header) {
-    return dll;
-  } else {
-    return "dll is " + dll + ", compiled against " + header;
-  }
-}
-
-void SetThisThreadName(const QString& s)
-{
-  using SetThreadDescriptionType = HRESULT (
-    HANDLE hThread,
-    PCWSTR lpThreadDescription
-  );
-
-  static SetThreadDescriptionType* SetThreadDescription = [] {
-    SetThreadDescriptionType* p = nullptr;
-
-    env::LibraryPtr kernel32(LoadLibraryW(L"kernel32.dll"));
-    if (!kernel32) {
-      return p;
-    }
-
-    p = reinterpret_cast<SetThreadDescriptionType*>(
-      GetProcAddress(kernel32.get(), "SetThreadDescription"));
-
-    return p;
-  }();
-
-  if (SetThreadDescription) {
-    SetThreadDescription(GetCurrentThread(), s.toStdWString().c_str());
-  }
-}
-
-
-char shortcutChar(const QAction* a)
-{
-  const auto text = a->text();
-  char shortcut = 0;
-
-  for (int i=0; i<text.size(); ++i) {
-    const auto c = text[i];
-    if (c == '&') {
-      if (i >= (text.size() - 1)) {
-        log::error("ampersand at the end");
-        return 0;
-      }
-
-      return text[i + 1].toLatin1();
-    }
-  }
-
-  log::error("action {} has no shortcut", text);
-  return 0;
-}
-
-void checkDuplicateShortcuts(const QMenu& m)
-{
-  const auto actions = m.actions();
-
-  for (int i=0; i<actions.size(); ++i) {
-    const auto* action1 = actions[i];
-    if (action1->isSeparator()) {
-      continue;
-    }
-
-    const char shortcut1 = shortcutChar(action1);
-    if (shortcut1 == 0) {
-      continue;
-    }
-
-    for (int j=i+1; j<actions.size(); ++j) {
-      const auto* action2 = actions[j];
-      if (action2->isSeparator()) {
-        continue;
-      }
-
-      const char shortcut2 = shortcutChar(action2);
-
-      if (shortcut1 == shortcut2) {
-        log::error(
-          "duplicate shortcut {} for {} and {}",
-          shortcut1, action1->text(), action2->text());
-
-        break;
-      }
-    }
-  }
-}
-
-} // namespace MOShared
-
-
-static bool g_exiting = false;
-static bool g_canClose = false;
-
-MainWindow* findMainWindow()
-{
-  for (auto* tl : qApp->topLevelWidgets()) {
-    if (auto* mw=dynamic_cast<MainWindow*>(tl)) {
-      return mw;
-    }
-  }
-
-  return nullptr;
-}
-
-bool ExitModOrganizer(ExitFlags e)
-{
-  if (g_exiting) {
-    return true;
-  }
-
-  g_exiting = true;
-  Guard g([&]{ g_exiting = false; });
-
-  if (!e.testFlag(Exit::Force)) {
-    if (auto* mw=findMainWindow()) {
-      if (!mw->canExit()) {
-        return false;
-      }
-    }
-  }
-
-  g_canClose = true;
-
-  const int code = (e.testFlag(Exit::Restart) ? RestartExitCode : 0);
-  qApp->exit(code);
-
-  return true;
-}
-
-bool ModOrganizerCanCloseNow()
-{
-  return g_canClose;
-}
-
-bool ModOrganizerExiting()
-{
-  return g_exiting;
-}
-
-void ResetExitFlag()
-{
-  g_exiting = false;
-}
-
-
-bool isNxmLink(const QString& link)
-{
-  return link.startsWith("nxm://", Qt::CaseInsensitive);
-}
+/*
+Copyright (C) 2012 Sebastian Herbord. All rights reserved.
+
+This file is part of Mod Organizer.
+
+Mod Organizer is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Mod Organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "util.h"
+#include "windows_error.h"
+#include "../mainwindow.h"
+#include "../env.h"
+#include <log.h>
+#include <usvfs.h>
+#include <usvfs_version.h>
+#include <emmintrin.h>
+#include <vector>
+
+using namespace MOBase;
+
+namespace MOShared
+{
+
+bool FileExists(const std::string &filename)
+{
+  DWORD dwAttrib = ::GetFileAttributesA(filename.c_str());
+
+  return (dwAttrib != INVALID_FILE_ATTRIBUTES);
+}
+
+bool FileExists(const std::wstring &filename)
+{
+  DWORD dwAttrib = ::GetFileAttributesW(filename.c_str());
+
+  return (dwAttrib != INVALID_FILE_ATTRIBUTES);
+}
+
+bool FileExists(const std::wstring &searchPath, const std::wstring &filename)
+{
+  std::wstringstream stream;
+  stream << searchPath << "\\" << filename;
+  return FileExists(stream.str());
+}
+
+std::string ToString(const std::wstring &source, bool utf8)
+{
+  std::string result;
+  if (source.length() > 0) {
+    UINT codepage = CP_UTF8;
+    if (!utf8) {
+      codepage = AreFileApisANSI() ? GetACP() : GetOEMCP();
+    }
+    int sizeRequired = ::WideCharToMultiByte(codepage, 0, &source[0], -1, nullptr, 0, nullptr, nullptr);
+    if (sizeRequired == 0) {
+      throw windows_error("failed to convert string to multibyte");
+    }
+    // the size returned by WideCharToMultiByte contains zero termination IF -1 is specified for the length.
+    // we don't want that \0 in the string because then the length field would be wrong. Because madness
+    result.resize(sizeRequired - 1, '\0');
+    ::WideCharToMultiByte(codepage, 0, &source[0], (int)source.size(), &result[0], sizeRequired, nullptr, nullptr);
+  }
+
+  return result;
+}
+
+QString ToQString(std::wstring_view source)
+{
+  return QString::fromWCharArray(source.data(), static_cast<int>(source.size()));
+}
+
+void AssignQString(QString& out, std::wstring_view s)
+{
+  out.resize(static_cast<int>(s.size()));
+
+  // data() detaches if the buffer is shared, such as when a previous value
+  // was kept by the caller
+  std::copy(s.begin(), s.end(), reinterpret_cast<wchar_t*>(out.data()));
+}
+
+std::wstring ToWString(const std::string &source, bool utf8)
+{
+  std::wstring result;
+  if (source.length() > 0) {
+    UINT codepage = CP_UTF8;
+    if (!utf8) {
+      codepage = AreFileApisANSI() ? GetACP() : GetOEMCP();
+    }
+    int sizeRequired
+        = ::MultiByteToWideChar(codepage, 0, source.c_str(),
+                                static_cast<int>(source.length()), nullptr, 0);
+    if (sizeRequired == 0) {
+      throw windows_error("failed to convert string to wide character");
+    }
+    result.resize(sizeRequired, L'\0');
+    ::MultiByteToWideChar(codepage, 0, source.c_str(),
+                          static_cast<int>(source.length()), &result[0],
+                          sizeRequired);
+  }
+
+  return result;
+}
+
+// lowercase of every utf-16 code unit, filled once by CharLowerBuffW() so
+// characters fold the same way they did when each string went through it;
+// like the upcase table of ntfs, this maps code units one to one
+//
+static const wchar_t* lowerTableW()
+{
+  static const std::vector<wchar_t> table = [] {
+    std::vector<wchar_t> t(0x10000);
+
+    for (std::size_t i=0; i<t.size(); ++i) {
+      t[i] = static_cast<wchar_t>(i);
+    }
+
+    CharLowerBuffW(t.data(), static_cast<DWORD>(t.size()));
+    return t;
+  }();
+
+  return table.data();
+}
+
+// same for the characters of the ansi codepage
+//
+static const char* lowerTableA()
+{
+  static const std::vector<char> table = [] {
+    std::vector<char> t(0x100);
+
+    for (std::size_t i=0; i<t.size(); ++i) {
+      t[i] = static_cast<char>(i);
+    }
+
+    CharLowerBuffA(t.data(), static_cast<DWORD>(t.size()));
+    return t;
+  }();
+
+  return table.data();
+}
+
+// lowercases `n` characters from `in` to `out`, which can be the same; eight
+// characters are handled at a time when they're all ascii, the others go
+// through the table
+//
+static void lowerW(const wchar_t* in, wchar_t* out, std::size_t n)
+{
+  const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xff80));
+  const __m128i beforeA = _mm_set1_epi16(L'A' - 1);
+  const __m128i afterZ = _mm_set1_epi16(L'Z' + 1);
+  const __m128i delta = _mm_set1_epi16(0x20);
+
+  std::size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    const __m128i ascii = _mm_cmpeq_epi16(
+      _mm_and_si128(v, nonAscii), _mm_setzero_si128());
+
+    if (_mm_movemask_epi8(ascii) != 0xffff) {
+      for (std::size_t j=i; j<i+8; ++j) {
+        out[j] = ToLowerChar(in[j]);
+      }
+
+      continue;
+    }
+
+    const __m128i upper = _mm_and_si128(
+      _mm_cmpgt_epi16(v, beforeA), _mm_cmplt_epi16(v, afterZ));
+
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out + i),
+      _mm_add_epi16(v, _mm_and_si128(upper, delta)));
+  }
+
+  for (; i < n; ++i) {
+    out[i] = ToLowerChar(in[i]);
+  }
+}
+
+// same as above, sixteen characters at a time
+//
+static void lowerA(const char* in, char* out, std::size_t n)
+{
+  const __m128i beforeA = _mm_set1_epi8('A' - 1);
+  const __m128i afterZ = _mm_set1_epi8('Z' + 1);
+  const __m128i delta = _mm_set1_epi8(0x20);
+
+  std::size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+
+    // the high bit is set for anything that's not ascii
+    if (_mm_movemask_epi8(v) != 0) {
+      for (std::size_t j=i; j<i+16; ++j) {
+        out[j] = lowerTableA()[static_cast<unsigned char>(in[j])];
+      }
+
+      continue;
+    }
+
+    const __m128i upper = _mm_and_si128(
+      _mm_cmpgt_epi8(v, beforeA), _mm_cmplt_epi8(v, afterZ));
+
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out + i),
+      _mm_add_epi8(v, _mm_and_si128(upper, delta)));
+  }
+
+  for (; i < n; ++i) {
+    out[i] = lowerTableA()[static_cast<unsigned char>(in[i])];
+  }
+}
+
+wchar_t ToLowerChar(wchar_t c)
+{
+  if (c < 0x80) {
+    return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c + 0x20) : c;
+  }
+
+  return lowerTableW()[c];
+}
+
+std::string& ToLowerInPlace(std::string& text)
+{
+  lowerA(text.data(), text.data(), text.size());
+  return text;
+}
+
+std::string ToLowerCopy(const std::string& text)
+{
+  std::string result(text);
+  return ToLowerInPlace(result);
+}
+
+std::wstring& ToLowerInPlace(std::wstring& text)
+{
+  lowerW(text.data(), text.data(), text.size());
+  return text;
+}
+
+std::wstring ToLowerCopy(const std::wstring& text)
+{
+  return ToLowerCopy(std::wstring_view(text));
+}
+
+std::wstring ToLowerCopy(std::wstring_view text)
+{
+  std::wstring result;
+  ToLowerCopy(text, result);
+  return result;
+}
+
+std::wstring& ToLowerCopy(std::wstring_view text, std::wstring& out)
+{
+  out.resize(text.size());
+  lowerW(text.data(), out.data(), text.size());
+  return out;
+}
+
+bool CaseInsensitiveEqual(const std::wstring &lhs, const std::wstring &rhs)
+{
+  return (lhs.length() == rhs.length())
+      && std::equal(lhs.begin(), lhs.end(),
+                    rhs.begin(),
+                    [] (wchar_t lhs, wchar_t rhs) -> bool {
+                      return ToLowerChar(lhs) == ToLowerChar(rhs);
+                    });
+}
+
+VS_FIXEDFILEINFO GetFileVersion(const std::wstring &fileName)
+{
+  DWORD handle = 0UL;
+  DWORD size = ::GetFileVersionInfoSizeW(fileName.c_str(), &handle);
+  if (size == 0) {
+    throw windows_error("failed to determine file version info size");
+  }
+
+  boost::scoped_array<char> buffer(new char[size]);
+  try {
+    handle = 0UL;
+    if (!::GetFileVersionInfoW(fileName.c_str(), handle, size, buffer.get())) {
+      throw windows_error("failed to determine file version info");
+    }
+
+    void *versionInfoPtr = nullptr;
+    UINT versionInfoLength = 0;
+    if (!::VerQueryValue(buffer.get(), L"\\", &versionInfoPtr, &versionInfoLength)) {
+      throw windows_error("failed to determine file version");
+    }
+
+    VS_FIXEDFILEINFO result = *(VS_FIXEDFILEINFO*)versionInfoPtr;
+    return result;
+  } catch (...) {
+    throw;
+  }
+}
+
+std::wstring GetFileVersionString(const std::wstring &fileName)
+{
+  DWORD handle = 0UL;
+  DWORD size = ::GetFileVersionInfoSizeW(fileName.c_str(), &handle);
+  if (size == 0) {
+    throw windows_error("failed to determine file version info size");
+  }
+
+  boost::scoped_array<char> buffer(new char[size]);
+  try {
+    handle = 0UL;
+    if (!::GetFileVersionInfoW(fileName.c_str(), handle, size, buffer.get())) {
+      throw windows_error("failed to determine file version info");
+    }
+
+    LPVOID strBuffer = nullptr;
+    UINT strLength = 0;
+    if (!::VerQueryValue(buffer.get(), L"\\StringFileInfo\\040904B0\\ProductVersion", &strBuffer, &strLength)) {
+      throw windows_error("failed to determine file version");
+    }
+
+    return std::wstring((LPCTSTR)strBuffer);
+  }
+  catch (...) {
+    throw;
+  }
+}
+
+VersionInfo createVersionInfo()
+{
+  VS_FIXEDFILEINFO version = GetFileVersion(env::thisProcessPath().native());
+
+  if (version.dwFileFlags & VS_FF_PRERELEASE)
+  {
+    // Pre-release builds need annotating
+    QString versionString = QString::fromStdWString(
+      GetFileVersionString(env::thisProcessPath().native()));
+
+    // The pre-release flag can be set without the string specifying what type of pre-release
+    bool noLetters = true;
+    for (QChar character : versionString)
+    {
+      if (character.isLetter())
+      {
+        noLetters = false;
+        break;
+      }
+    }
+
+    if (noLetters)
+    {
+      // Default to pre-alpha when release type is unspecified
+      return VersionInfo(version.dwFileVersionMS >> 16,
+                         version.dwFileVersionMS & 0xFFFF,
+                         version.dwFileVersionLS >> 16,
+                         version.dwFileVersionLS & 0xFFFF,
+                         VersionInfo::RELEASE_PREALPHA);
+    }
+    else
+    {
+      // Trust the string to make sense
+      return VersionInfo(versionString);
+    }
+  }
+  else
+  {
+    // Non-pre-release builds just need their version numbers reading
+    return VersionInfo(version.dwFileVersionMS >> 16,
+                       version.dwFileVersionMS & 0xFFFF,
+                       version.dwFileVersionLS >> 16,
+                       version.dwFileVersionLS & 0xFFFF);
+  }
+}
+
+QString getUsvfsDLLVersion()
+{
+  // once 2.2.2 is released, this can be changed to call USVFSVersionString()
+  // directly; until then, using GetProcAddress() allows for mixing up devbuilds
+  // and usvfs dlls
+
+  using USVFSVersionStringType = const char* WINAPI ();
+
+  QString s;
+
+  const auto m = ::LoadLibraryW(L"usvfs_x64.dll");
+
+  if (m) {
+    auto* f = reinterpret_cast<USVFSVersionStringType*>(
+      ::GetProcAddress(m, "USVFSVersionString"));
+
+    if (f) {
+      s = f();
+    }
+
+    ::FreeLibrary(m);
+  }
+
+  if (s.isEmpty()) {
+    s = "?";
+  }
+
+  return s;
+}
+
+QString getUsvfsVersionString()
+{
+  const QString dll = getUsvfsDLLVersion();
+  const QString header = USVFS_VERSION_STRING;
+
+  QString usvfsVersion;
+
+  if (dll == header) {
+    return dll;
+  } else {
+    return "dll is " + dll + ", compiled against " + header;
+  }
+}
+
+void SetThisThreadName(const QString& s)
+{
+  using SetThreadDescriptionType = HRESULT (
+    HANDLE hThread,
+    PCWSTR lpThreadDescription
+  );
+
+  static SetThreadDescriptionType* SetThreadDescription = [] {
+    SetThreadDescriptionType* p = nullptr;
+
+    env::LibraryPtr kernel32(LoadLibraryW(L"kernel32.dll"));
+    if (!kernel32) {
+      return p;
+    }
+
+    p = reinterpret_cast<SetThreadDescriptionType*>(
+      GetProcAddress(kernel32.get(), "SetThreadDescription"));
+
+    return p;
+  }();
+
+  if (SetThreadDescription) {
+    SetThreadDescription(GetCurrentThread(), s.toStdWString().c_str());
+  }
+}
+
+
+char shortcutChar(const QAction* a)
+{
+  const auto text = a->text();
+  char shortcut = 0;
+
+  for (int i=0; i<text.size(); ++i) {
+    const auto c = text[i];
+    if (c == '&') {
+      if (i >= (text.size() - 1)) {
+        log::error("ampersand at the end");
+        return 0;
+      }
+
+      return text[i + 1].toLatin1();
+    }
+  }
+
+  log::error("action {} has no shortcut", text);
+  return 0;
+}
+
+void checkDuplicateShortcuts(const QMenu& m)
+{
+  const auto actions = m.actions();
+
+  for (int i=0; i<actions.size(); ++i) {
+    const auto* action1 = actions[i];
+    if (action1->isSeparator()) {
+      continue;
+    }
+
+    const char shortcut1 = shortcutChar(action1);
+    if (shortcut1 == 0) {
+      continue;
+    }
+
+    for (int j=i+1; j<actions.size(); ++j) {
+      const auto* action2 = actions[j];
+      if (action2->isSeparator()) {
+        continue;
+      }
+
+      const char shortcut2 = shortcutChar(action2);
+
+      if (shortcut1 == shortcut2) {
+        log::error(
+          "duplicate shortcut {} for {} and {}",
+          shortcut1, action1->text(), action2->text());
+
+        break;
+      }
+    }
+  }
+}
+
+} // namespace MOShared
+
+
+static bool g_exiting = false;
+static bool g_canClose = false;
+
+MainWindow* findMainWindow()
+{
+  for (auto* tl : qApp->topLevelWidgets()) {
+    if (auto* mw=dynamic_cast<MainWindow*>(tl)) {
+      return mw;
+    }
+  }
+
+  return nullptr;
+}
+
+bool ExitModOrganizer(ExitFlags e)
+{
+  if (g_exiting) {
+    return true;
+  }
+
+  g_exiting = true;
+  Guard g([&]{ g_exiting = false; });
+
+  if (!e.testFlag(Exit::Force)) {
+    if (auto* mw=findMainWindow()) {
+      if (!mw->canExit()) {
+        return false;
+      }
+    }
+  }
+
+  g_canClose = true;
+
+  const int code = (e.testFlag(Exit::Restart) ? RestartExitCode : 0);
+  qApp->exit(code);
+
+  return true;
+}
+
+bool ModOrganizerCanCloseNow()
+{
+  return g_canClose;
+}
+
+bool ModOrganizerExiting()
+{
+  return g_exiting;
+}
+
+void ResetExitFlag()
+{
+  g_exiting = false;
+}
+
+
+bool isNxmLink(const QString& link)
+{
+  return link.startsWith("nxm://", Qt::CaseInsensitive);
+}
@@ -1,88 +1,131 @@
-/*
-Copyright (C) 2012 Sebastian Herbord. All rights reserved.
-
-This file is part of Mod Organizer.
-
-Mod Organizer is free software: you can redistribute it and/or modify
-it under the terms of the GNU General Public License as published by
-the Free Software Foundation, either version 3 of the License, or
-(at your option) any later version.
-
-Mod Organizer is distributed in the hope that it will be useful,
-but WITHOUT ANY WARRANTY; without even the implied warranty of
-MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-GNU General Public License for more details.
-
-You should have received a copy of the GNU General Public License
-along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
-*/
-
-#ifndef UTIL_H
-#define UTIL_H
-
-#include <log.h>
-#include <string>
-#include <filesystem>
-#include <versioninfo.h>
-
-class Executable;
-
-namespace MOShared {
-
-/// Test if a file (or directory) by the specified name exists
-bool FileExists(const std::string &filename);
-bool FileExists(const std::wstring &filename);
-
-bool FileExists(const std::wstring &searchPath, const std::wstring &filename);
-
-std::string ToString(const std::wstring &source, bool utf8);
-std::wstring ToWString(const std::string &source, bool utf8);
-
-std::string& ToLowerInPlace(std::string& text);
-std::string ToLowerCopy(const std::string& text);
-
-std::wstring& ToLowerInPlace(std::wstring& text);
-std::wstring ToLowerCopy(const std::wstring& text);
-std::wstring ToLowerCopy(std::wstring_view text);
-
-bool CaseInsensitiveEqual(const std::wstring &lhs, const std::wstring &rhs);
-
-MOBase::VersionInfo createVersionInfo();
-QString getUsvfsVersionString();
-
-void SetThisThreadName(const QString& s);
-void checkDuplicateShortcuts(const QMenu& m);
-
-inline FILETIME ToFILETIME(std::filesystem::file_time_type t)
-{
-  FILETIME ft;
-  static_assert(sizeof(t) == sizeof(ft));
-
-  std::memcpy(&ft, &t, sizeof(FILETIME));
-  return ft;
-}
-
-} // namespace MOShared
-
-
-enum class Exit
-{
-  None    = 0x00,
-  Normal  = 0x01,
-  Restart = 0x02,
-  Force   = 0x04
-};
-
-const int RestartExitCode = INT_MAX;
-
-using ExitFlags = QFlags<Exit>;
-Q_DECLARE_OPERATORS_FOR_FLAGS(ExitFlags);
-
-bool ExitModOrganizer(ExitFlags e=Exit::Normal);
-bool ModOrganizerExiting();
-bool ModOrganizerCanCloseNow();
-void ResetExitFlag();
-
-bool isNxmLink(const QString& link);
-
-#endif // UTIL_H
+/*
+Copyright (C) 2012 Sebastian Herbord. All rights reserved.
+
+This file is part of Mod Organizer.
+
+Mod Organizer is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Mod Organizer is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <log.h>
+#include <QString>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <versioninfo.h>
+
+class Executable;
+
+namespace MOShared {
+
+/// Test if a file (or directory) by the specified name exists
+bool FileExists(const std::string &filename);
+bool FileExists(const std::wstring &filename);
+
+bool FileExists(const std::wstring &searchPath, const std::wstring &filename);
+
+std::string ToString(const std::wstring &source, bool utf8);
+std::wstring ToWString(const std::string &source, bool utf8);
+
+// MOBase::ToQString() only takes std::wstring, this is mostly used for file
+// names in the structure, which are views into the FileRegister's arena
+QString ToQString(std::wstring_view source);
+
+// both QString and std::wstring are utf-16 on windows, so the functions below
+// change the string type without copying the characters
+
+// a view of the characters of the given string; it's only valid while the
+// string is alive and unmodified
+//
+inline std::wstring_view ToWStringView(const QString& s)
+{
+  return {
+    reinterpret_cast<const wchar_t*>(s.constData()),
+    static_cast<std::size_t>(s.size())};
+}
+
+// a QString over the given characters, see QString::fromRawData(); the
+// characters must outlive the QString and every copy of it, so this is for
+// temporaries, not for strings that are kept or given to plugins
+//
+inline QString ToQStringRaw(std::wstring_view s)
+{
+  return QString::fromRawData(
+    reinterpret_cast<const QChar*>(s.data()), static_cast<int>(s.size()));
+}
+
+// copies the characters into `out`, which only allocates when its buffer is
+// too small or shared with another string; used to reuse a single QString for
+// a series of names
+//
+void AssignQString(QString& out, std::wstring_view s);
+
+std::string& ToLowerInPlace(std::string& text);
+std::string ToLowerCopy(const std::string& text);
+
+std::wstring& ToLowerInPlace(std::wstring& text);
+std::wstring ToLowerCopy(const std::wstring& text);
+std::wstring ToLowerCopy(std::wstring_view text);
+
+// same as above, but writes into `out`, which is resized; this doesn't
+// allocate when `out` already has the capacity, such as when it's reused for
+// a series of names
+std::wstring& ToLowerCopy(std::wstring_view text, std::wstring& out);
+
+// lowercase of a single character, same as the functions above
+wchar_t ToLowerChar(wchar_t c);
+
+bool CaseInsensitiveEqual(const std::wstring &lhs, const std::wstring &rhs);
+
+MOBase::VersionInfo createVersionInfo();
+QString getUsvfsVersionString();
+
+void SetThisThreadName(const QString& s);
+void checkDuplicateShortcuts(const QMenu& m);
+
+inline FILETIME ToFILETIME(std::filesystem::file_time_type t)
+{
+  FILETIME ft;
+  static_assert(sizeof(t) == sizeof(ft));
+
+  std::memcpy(&ft, &t, sizeof(FILETIME));
+  return ft;
+}
+
+} // namespace MOShared
+
+
+enum class Exit
+{
+  None    = 0x00,
+  Normal  = 0x01,
+  Restart = 0x02,
+  Force   = 0x04
+};
+
+const int RestartExitCode = INT_MAX;
+
+using ExitFlags = QFlags<Exit>;
+Q_DECLARE_OPERATORS_FOR_FLAGS(ExitFlags);
+
+bool ExitModOrganizer(ExitFlags e=Exit::Normal);
+bool ModOrganizerExiting();
+bool ModOrganizerCanCloseNow();
+void ResetExitFlag();
+
+bool isNxmLink(const QString& link);
+
+#endif // UTIL_H
@@ -0,0 +1,369 @@
+#include "stalldetector.h"
+#include "metrics.h"
+#include <log.h>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <windows.h>
+#include <DbgHelp.h>
+
+#pragma comment(lib, "dbghelp.lib")
+
+using namespace MOBase;
+
+using Clock = std::chrono::steady_clock;
+
+// how often the watchdog checks whether the last ping was answered
+static constexpr std::chrono::milliseconds CheckInterval(50);
+
+// time between two captures of the stack while the ui thread is stalled
+static constexpr std::chrono::seconds SampleInterval(1);
+
+// captures of the stack for one stall
+static constexpr std::size_t MaxSamples = 5;
+
+// frames captured for one stack
+static constexpr std::size_t MaxFrames = 64;
+
+// frames of the first stack that are logged, the report has all of them
+static constexpr std::size_t LoggedFrames = 10;
+
+
+namespace
+{
+
+struct Sample
+{
+  // time since the ping was posted
+  std::chrono::milliseconds at;
+
+  std::array<DWORD64, MaxFrames> frames;
+  std::size_t count = 0;
+};
+
+// captures the stack of the given thread; nothing is allocated and no locks
+// are taken while the thread is suspended, the thread could be holding the
+// heap lock
+//
+void captureStack(HANDLE thread, Sample& s)
+{
+  s.count = 0;
+
+  if (::SuspendThread(thread) == static_cast<DWORD>(-1)) {
+    return;
+  }
+
+  CONTEXT ctx = {};
+  ctx.ContextFlags = CONTEXT_FULL;
+
+  if (::GetThreadContext(thread, &ctx)) {
+    while (s.count < MaxFrames && ctx.Rip != 0) {
+      s.frames[s.count++] = ctx.Rip;
+
+      DWORD64 imageBase = 0;
+      auto* f = ::RtlLookupFunctionEntry(ctx.Rip, &imageBase, nullptr);
+
+      if (!f) {
+        // leaf function, the return address is on top of the stack
+        ctx.Rip = *reinterpret_cast<DWORD64*>(ctx.Rsp);
+        ctx.Rsp += sizeof(DWORD64);
+        continue;
+      }
+
+      void* handlerData = nullptr;
+      DWORD64 establisherFrame = 0;
+
+      ::RtlVirtualUnwind(
+        UNW_FLAG_NHANDLER, imageBase, ctx.Rip, f, &ctx,
+        &handlerData, &establisherFrame, nullptr);
+    }
+  }
+
+  ::ResumeThread(thread);
+}
+
+// "module!function+0x12 (file.cpp:34)" if symbols are available, or
+// "module+0x1234"
+//
+QString frameName(DWORD64 address)
+{
+  QString module = "?";
+  DWORD64 moduleBase = 0;
+
+  HMODULE m = nullptr;
+  const auto flags =
+    GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+    GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT;
+
+  if (::GetModuleHandleExW(flags, reinterpret_cast<LPCWSTR>(address), &m)) {
+    wchar_t path[MAX_PATH] = {};
+    const DWORD n = ::GetModuleFileNameW(m, path, MAX_PATH);
+    module = QString::fromWCharArray(path, static_cast<int>(n));
+    module = module.mid(module.lastIndexOf('\\') + 1);
+    moduleBase = reinterpret_cast<DWORD64>(m);
+  }
+
+  const HANDLE process = ::GetCurrentProcess();
+
+  // SYMBOL_INFO is followed by the name
+  std::array<char, sizeof(SYMBOL_INFOW) + MAX_SYM_NAME * sizeof(wchar_t)> buffer = {};
+  auto* symbol = reinterpret_cast<SYMBOL_INFOW*>(buffer.data());
+  symbol->SizeOfStruct = sizeof(SYMBOL_INFOW);
+  symbol->MaxNameLen = MAX_SYM_NAME;
+
+  DWORD64 displacement = 0;
+
+  if (!::SymFromAddrW(process, address, &displacement, symbol)) {
+    return QString("%1+0x%2").arg(module).arg(address - moduleBase, 0, 16);
+  }
+
+  QString s = QString("%1!%2+0x%3")
+    .arg(module)
+    .arg(QString::fromWCharArray(symbol->Name, static_cast<int>(symbol->NameLen)))
+    .arg(displacement, 0, 16);
+
+  IMAGEHLP_LINEW64 line = {};
+  line.SizeOfStruct = sizeof(line);
+  DWORD lineDisplacement = 0;
+
+  if (::SymGetLineFromAddrW64(process, address, &lineDisplacement, &line)) {
+    QString file = QString::fromWCharArray(line.FileName);
+    file = file.mid(file.lastIndexOf('\\') + 1);
+
+    s += QString(" (%1:%2)").arg(file).arg(line.LineNumber);
+  }
+
+  return s;
+}
+
+
+// state shared between the watchdog thread and the pings posted to the ui
+// thread, which can run after the watchdog is gone
+//
+struct PingState
+{
+  // incremented by the watchdog for every ping, set by the ui thread to the
+  // ping it answered
+  std::atomic<std::uint64_t> sent = 0;
+  std::atomic<std::uint64_t> answered = 0;
+
+  // when the last ping was answered
+  std::atomic<Clock::rep> answeredAt = 0;
+};
+
+
+class Watchdog
+{
+public:
+  Watchdog()
+    : m_ui(nullptr), m_ping(std::make_shared<PingState>()), m_stop(false)
+  {
+    // the handle of the calling thread, GetCurrentThread() is a pseudo
+    // handle that would be the watchdog thread from the watchdog
+    ::DuplicateHandle(
+      ::GetCurrentProcess(), ::GetCurrentThread(), ::GetCurrentProcess(),
+      &m_ui, THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION,
+      FALSE, 0);
+
+    m_thread = std::thread([this] { run(); });
+  }
+
+  ~Watchdog()
+  {
+    {
+      std::scoped_lock lock(m_mutex);
+      m_stop = true;
+    }
+
+    m_cv.notify_one();
+    m_thread.join();
+
+    if (m_ui) {
+      ::CloseHandle(m_ui);
+    }
+  }
+
+  Watchdog(const Watchdog&) = delete;
+  Watchdog& operator=(const Watchdog&) = delete;
+
+  static void setReportFile(const QString& path)
+  {
+    std::scoped_lock lock(s_reportMutex);
+    s_reportFile = path;
+  }
+
+private:
+  HANDLE m_ui;
+  std::shared_ptr<PingState> m_ping;
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop;
+
+  static inline std::mutex s_reportMutex;
+  static inline QString s_reportFile;
+
+  // sleeps for the given time, returns false if the watchdog is stopping
+  //
+  bool sleep(std::chrono::milliseconds d)
+  {
+    std::unique_lock lock(m_mutex);
+    return !m_cv.wait_for(lock, d, [&]{ return m_stop; });
+  }
+
+  void post()
+  {
+    const auto n = ++m_ping->sent;
+
+    QMetaObject::invokeMethod(qApp, [p=m_ping, n] {
+      p->answeredAt = Clock::now().time_since_epoch().count();
+      p->answered = n;
+    }, Qt::QueuedConnection);
+  }
+
+  bool answered() const
+  {
+    return (m_ping->answered == m_ping->sent);
+  }
+
+  void run()
+  {
+    if (!m_ui) {
+      log::error("stall detector: can't open the ui thread");
+      return;
+    }
+
+    std::vector<Sample> samples;
+    samples.reserve(MaxSamples);
+
+    while (sleep(CheckInterval)) {
+      post();
+      const auto sentAt = Clock::now();
+
+      // waits for the ping, capturing the stack at the threshold and then
+      // every second
+      auto nextSample = sentAt + StallDetector::Threshold;
+      samples.clear();
+
+      while (!answered()) {
+        const auto now = Clock::now();
+
+        if (now >= nextSample && samples.size() < MaxSamples) {
+          Sample& s = samples.emplace_back();
+          s.at = std::chrono::duration_cast<std::chrono::milliseconds>(now - sentAt);
+          captureStack(m_ui, s);
+
+          nextSample = now + SampleInterval;
+        }
+
+        if (!sleep(CheckInterval)) {
+          return;
+        }
+      }
+
+      if (!samples.empty()) {
+        const Clock::time_point answeredAt(Clock::duration(m_ping->answeredAt));
+        report(answeredAt - sentAt, samples);
+      }
+    }
+  }
+
+  void report(Clock::duration d, const std::vector<Sample>& samples)
+  {
+    using namespace std::chrono;
+
+    Metrics::duration("ui stall", d);
+
+    // symbols are only loaded once there's a stack to resolve, this can take
+    // a while but it's on this thread
+    static const bool symbols = [] {
+      ::SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS | SYMOPT_LOAD_LINES);
+      return (::SymInitializeW(::GetCurrentProcess(), nullptr, TRUE) != FALSE);
+    }();
+
+    if (!symbols) {
+      log::debug("stall detector: can't load symbols, frames are offsets");
+    }
+
+    const auto ms = duration_cast<milliseconds>(d).count();
+
+    QString file;
+    {
+      std::scoped_lock lock(s_reportMutex);
+      file = s_reportFile;
+    }
+
+    log::warn(
+      "the interface was stalled for {}ms{}", ms,
+      (file.isEmpty() ? QString() : ", see " + file));
+
+    QString text;
+    QTextStream out(&text);
+
+    out
+      << QDateTime::currentDateTime().toString(Qt::ISODateWithMs)
+      << " ui thread stalled for " << ms << "ms\n";
+
+    for (std::size_t i=0; i<samples.size(); ++i) {
+      const auto& s = samples[i];
+      out << "  stack at " << s.at.count() << "ms:\n";
+
+      for (std::size_t f=0; f<s.count; ++f) {
+        const auto name = frameName(s.frames[f]);
+        out << "    " << name << "\n";
+
+        if (i == 0 && f < LoggedFrames) {
+          log::debug("  {}", name);
+        }
+      }
+    }
+
+    out << "\n";
+    out.flush();
+
+    if (file.isEmpty()) {
+      return;
+    }
+
+    QFile f(file);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+      log::error("can't open stall report {}: {}", file, f.errorString());
+      return;
+    }
+
+    f.write(text.toUtf8());
+  }
+};
+
+// only used from the ui thread
+std::unique_ptr<Watchdog> g_watchdog;
+
+} // namespace
+
+
+void StallDetector::setEnabled(bool b)
+{
+  if (b == static_cast<bool>(g_watchdog)) {
+    return;
+  }
+
+  if (b) {
+    log::debug("stall detection enabled, threshold {}ms", Threshold.count());
+    g_watchdog = std::make_unique<Watchdog>();
+  } else {
+    g_watchdog.reset();
+  }
+}
+
+void StallDetector::setReportFile(const QString& path)
+{
+  Watchdog::setReportFile(path);
+}
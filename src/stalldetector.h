@@ -0,0 +1,39 @@
+#ifndef MODORGANIZER_STALLDETECTOR_INCLUDED
+#define MODORGANIZER_STALLDETECTOR_INCLUDED
+
+#include <QString>
+#include <chrono>
+
+// watches the ui thread for stalls when stall detection is enabled in the
+// diagnostics settings
+//
+// a thread posts an empty call to the event loop of the ui thread and waits for
+// it to run; when it hasn't run after the threshold, the stack of the ui thread
+// is captured, and again every second while it's still stalled, up to a few
+// samples
+//
+// once the ui thread responds again, the stall is logged with its duration and
+// the top of the first stack, and appended to the report file with all the
+// stacks; the duration is also recorded in the metrics
+//
+// stacks are captured by suspending the ui thread and unwinding it with the
+// unwind data of the modules, which doesn't allocate or take locks the ui
+// thread could be holding; frames are resolved with dbghelp once the thread
+// has been resumed
+//
+class StallDetector
+{
+public:
+  // the ui thread is stalled once it hasn't processed events for this long
+  static constexpr std::chrono::milliseconds Threshold{250};
+
+  // starts or stops watching the calling thread, which must be the ui thread
+  //
+  static void setEnabled(bool b);
+
+  // the file stalls are appended to, typically in the logs directory
+  //
+  static void setReportFile(const QString& path);
+};
+
+#endif // MODORGANIZER_STALLDETECTOR_INCLUDED
@@ -0,0 +1,235 @@
+#include "startuptrace.h"
+#include "shared/appconfig.h"
+#include <log.h>
+#include <QApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+
+using namespace MOBase;
+
+struct StartupTrace::Data
+{
+  bool active = false;
+  Clock::time_point start;
+  std::optional<Clock::time_point> refreshStart;
+  int depth = 0;
+  Report current;
+  std::optional<Report> last;
+  bool exitWhenFinished = false;
+};
+
+
+StartupTrace::Scope::Scope(QString name)
+  : m_name(std::move(name)), m_depth(0), m_active(StartupTrace::active())
+{
+  if (m_active) {
+    m_depth = data().depth++;
+    m_start = Clock::now();
+  }
+}
+
+StartupTrace::Scope::~Scope()
+{
+  stop();
+}
+
+void StartupTrace::Scope::next(QString name)
+{
+  stop();
+
+  m_name = std::move(name);
+  m_active = StartupTrace::active();
+
+  if (m_active) {
+    m_depth = data().depth++;
+    m_start = Clock::now();
+  }
+}
+
+void StartupTrace::Scope::stop()
+{
+  if (!m_active) {
+    return;
+  }
+
+  m_active = false;
+
+  auto& d = data();
+
+  if (d.depth > 0) {
+    --d.depth;
+  }
+
+  // the trace may have been finished or restarted since
+  if (d.active) {
+    d.current.spans.push_back({
+      std::move(m_name), m_start, Clock::now() - m_start, m_depth, false});
+  }
+}
+
+
+void StartupTrace::begin()
+{
+  auto& d = data();
+
+  d.active = true;
+  d.start = Clock::now();
+  d.refreshStart = {};
+  d.depth = 0;
+  d.current = {};
+  d.current.time = QDateTime::currentDateTime();
+}
+
+bool StartupTrace::active()
+{
+  return data().active;
+}
+
+void StartupTrace::refreshStarted()
+{
+  auto& d = data();
+
+  if (d.active && !d.refreshStart) {
+    d.refreshStart = Clock::now();
+  }
+}
+
+void StartupTrace::finish()
+{
+  auto& d = data();
+
+  if (!d.active) {
+    return;
+  }
+
+  const auto now = Clock::now();
+
+  if (d.refreshStart) {
+    d.current.spans.push_back({
+      "first directory refresh", *d.refreshStart, now - *d.refreshStart,
+      0, true});
+  }
+
+  d.active = false;
+  d.current.total = now - d.start;
+
+  // scopes are added when they end, so children are before their parent
+  std::stable_sort(
+    d.current.spans.begin(), d.current.spans.end(),
+    [](auto&& a, auto&& b) {
+      if (a.start == b.start) {
+        return a.depth < b.depth;
+      }
+
+      return a.start < b.start;
+    });
+
+  d.last = std::move(d.current);
+  d.current = {};
+
+  logReport(*d.last);
+  write(*d.last);
+
+  if (d.exitWhenFinished) {
+    log::info("startup has been profiled, exiting");
+
+    // MOApplication::run() doesn't start the event loop if the trace is
+    // finished before it gets there
+    QTimer::singleShot(0, qApp, []{ qApp->exit(0); });
+  }
+}
+
+std::optional<StartupTrace::Report> StartupTrace::lastReport()
+{
+  return data().last;
+}
+
+bool StartupTrace::exitWhenFinished()
+{
+  return data().exitWhenFinished;
+}
+
+void StartupTrace::setExitWhenFinished(bool b)
+{
+  data().exitWhenFinished = b;
+}
+
+QString StartupTrace::traceFilename()
+{
+  return
+    qApp->property("dataPath").toString() + "/" +
+    QString::fromStdWString(AppConfig::logPath()) + "/startup_trace.json";
+}
+
+StartupTrace::Data& StartupTrace::data()
+{
+  static Data d;
+  return d;
+}
+
+void StartupTrace::logReport(const Report& r)
+{
+  using namespace std::chrono;
+
+  auto ms = [](nanoseconds ns) {
+    return duration_cast<milliseconds>(ns).count();
+  };
+
+  log::info("startup took {}ms", ms(r.total));
+
+  for (const auto& s : r.spans) {
+    log::debug(
+      "  {}{}: {}ms", std::string(s.depth * 2, ' '), s.name, ms(s.duration));
+  }
+}
+
+void StartupTrace::write(const Report& r)
+{
+  using namespace std::chrono;
+
+  auto us = [](nanoseconds ns) {
+    return static_cast<double>(duration_cast<microseconds>(ns).count());
+  };
+
+  // spans are relative to the first one so the trace starts at 0
+  Clock::time_point origin = Clock::time_point::max();
+  for (const auto& s : r.spans) {
+    origin = std::min(origin, s.start);
+  }
+
+  QJsonArray events;
+
+  for (const auto& s : r.spans) {
+    QJsonObject o;
+
+    o["name"] = s.name;
+    o["cat"] = "startup";
+    o["ph"] = "X";
+    o["ts"] = us(s.start - origin);
+    o["dur"] = us(s.duration);
+    o["pid"] = 1;
+
+    // background spans overlap with the others, they're shown on their own
+    // row
+    o["tid"] = (s.background ? 2 : 1);
+
+    events.append(o);
+  }
+
+  QJsonObject root;
+  root["traceEvents"] = events;
+  root["displayTimeUnit"] = "ms";
+
+  QFile f(traceFilename());
+
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    log::error(
+      "can't write startup trace to '{}', {}", f.fileName(), f.errorString());
+    return;
+  }
+
+  f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+}
@@ -0,0 +1,124 @@
+#ifndef MODORGANIZER_STARTUPTRACE_INCLUDED
+#define MODORGANIZER_STARTUPTRACE_INCLUDED
+
+#include <QDateTime>
+#include <QString>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+// collects the timings of MO's startup, from main() until the first
+// directory refresh is done: MOApplication's setup, each plugin loaded by
+// PluginContainer, OrganizerCore, the construction of the MainWindow and the
+// refresh itself
+//
+// a trace is started with begin() and ended with finish(), which writes it in
+// the chrome trace-event format to the logs directory, like RefreshTrace, and
+// keeps it so it can be shown in the diagnostics settings
+//
+// spans are nested by the order in which their Scope objects are created;
+// this must only be used from the ui thread
+//
+class StartupTrace
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // one timed phase of the startup
+  //
+  struct Span
+  {
+    QString name;
+    Clock::time_point start;
+    std::chrono::nanoseconds duration;
+
+    // 0 for top-level spans
+    int depth;
+
+    // spans that run in the background and aren't nested in the others, like
+    // the refresh
+    bool background;
+  };
+
+  // a finished trace
+  //
+  struct Report
+  {
+    QDateTime time;
+    std::chrono::nanoseconds total{0};
+
+    // sorted by start time, so children follow their parent
+    std::vector<Span> spans;
+  };
+
+  // records the lifetime of this object as a span nested inside the scopes
+  // that are still alive, does nothing when no trace is active
+  //
+  class Scope
+  {
+  public:
+    Scope(QString name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    // ends the current span and starts a new one at the same depth
+    //
+    void next(QString name);
+
+    // ends the current span, does nothing if it was already ended
+    //
+    void stop();
+
+  private:
+    QString m_name;
+    Clock::time_point m_start;
+    int m_depth;
+    bool m_active;
+  };
+
+  // starts a new trace, discarding the spans of a trace that was never
+  // finished; called from main() and when MO restarts
+  //
+  static void begin();
+
+  // whether begin() was called and finish() wasn't
+  //
+  static bool active();
+
+  // remembers the time the first refresh was started, it's added as a span
+  // by finish(); ignored if no trace is active or if it was already called
+  //
+  static void refreshStarted();
+
+  // ends the current trace, writes it to traceFilename() and keeps it as the
+  // last report; does nothing if no trace is active
+  //
+  // if exitWhenFinished() is set, this also asks the application to quit
+  //
+  static void finish();
+
+  // the last finished trace, if any
+  //
+  static std::optional<Report> lastReport();
+
+  // whether MO should exit once the startup has been traced, set by
+  // --startup-profile
+  //
+  static bool exitWhenFinished();
+  static void setExitWhenFinished(bool b);
+
+  // path of the file written by finish()
+  //
+  static QString traceFilename();
+
+private:
+  struct Data;
+  static Data& data();
+
+  static void write(const Report& r);
+  static void logReport(const Report& r);
+};
+
+#endif // MODORGANIZER_STARTUPTRACE_INCLUDED
@@ -3,19 +3,27 @@
 #include "settings.h"
 #include "organizercore.h"
 #include "instancemanager.h"
+#include "taskexecutor.h"
+#include "shared/directoryentry.h"
+#include "shared/fileregister.h"
+#include "shared/originconnection.h"
 #include "ui_mainwindow.h"
+#include <utility.h>
 
 StatusBar::StatusBar(QWidget* parent) :
   QStatusBar(parent), ui(nullptr), m_normal(new QLabel),
   m_progress(new QProgressBar), m_progressSpacer1(new QWidget),
   m_progressSpacer2(new QWidget), m_notifications(nullptr), m_update(nullptr),
-  m_api(new QLabel)
+  m_api(new QLabel), m_core(nullptr), m_perf(new QLabel)
 {
+  m_perfTimer.setInterval(1000);
+  connect(&m_perfTimer, &QTimer::timeout, [this]{ updatePerformance(); });
 }
 
-void StatusBar::setup(Ui::MainWindow* mainWindowUI, const Settings& settings)
+void StatusBar::setup(Ui::MainWindow* mainWindowUI, OrganizerCore& core)
 {
   ui = mainWindowUI;
+  m_core = &core;
   m_notifications = new StatusBarAction(ui->actionNotifications);
   m_update = new StatusBarAction(ui->actionUpdate);
 
@@ -30,6 +38,7 @@ void StatusBar::setup(Ui::MainWindow* mainWindowUI, const Settings& settings)
 
   addPermanentWidget(m_notifications);
   addPermanentWidget(m_update);
+  addPermanentWidget(m_perf);
   addPermanentWidget(m_api);
 
 
@@ -42,19 +51,13 @@ void StatusBar::setup(Ui::MainWindow* mainWindowUI, const Settings& settings)
   m_notifications->set(false);
 
   m_api->setObjectName("apistats");
-  m_api->setToolTip(QObject::tr(
-    "This tracks the number of queued Nexus API requests, as well as the "
-    "remaining daily and hourly requests. The Nexus API limits you to a pool "
-    "of requests per day and requests per hour. It is dynamically updated "
-    "every time a request is completed. If you run out of requests, you will "
-    "be unable to queue downloads, check updates, parse mod info, or even log "
-    "in. Both pools must be consumed before this happens."));
+  m_perf->setObjectName("perfstats");
 
   clearMessage();
   setProgress(-1);
   setAPI({}, {});
 
-  checkSettings(settings);
+  checkSettings(core.settings());
 }
 
 void StatusBar::setProgress(int percent)
@@ -111,6 +114,24 @@ void StatusBar::setAPI(const APIStats& stats, const APIUserAccount& user)
 
   m_api->setText(text);
 
+  QString tooltip = QObject::tr(
+    "This tracks the number of queued Nexus API requests, as well as the "
+    "remaining daily and hourly requests. The Nexus API limits you to a pool "
+    "of requests per day and requests per hour. It is dynamically updated "
+    "every time a request is completed. If you run out of requests, you will "
+    "be unable to queue downloads, check updates, parse mod info, or even log "
+    "in. Both pools must be consumed before this happens.");
+
+  if (stats.requestsSent > 0) {
+    tooltip += "\n\n" + QObject::tr(
+      "Requests sent: %1, over HTTP/2: %2, on a reused connection: %3")
+      .arg(stats.requestsSent)
+      .arg(stats.http2Requests)
+      .arg(std::max(stats.requestsSent - stats.handshakes, 0));
+  }
+
+  m_api->setToolTip(tooltip);
+
   QString ss(R"(
     QLabel
     {
@@ -141,6 +162,79 @@ void StatusBar::setUpdateAvailable(bool b)
 void StatusBar::checkSettings(const Settings& settings)
 {
   m_api->setVisible(!settings.interface().hideAPICounter());
+
+  const bool perf = settings.diagnostics().performanceStats();
+  m_perf->setVisible(perf);
+
+  if (perf) {
+    updatePerformance();
+    m_perfTimer.start();
+  } else {
+    m_perfTimer.stop();
+  }
+}
+
+void StatusBar::updatePerformance()
+{
+  using namespace std::chrono;
+
+  if (!m_core || !isVisible()) {
+    return;
+  }
+
+  auto s = [](nanoseconds ns) {
+    return QString::number(duration_cast<milliseconds>(ns).count() / 1000.0, 'f', 2);
+  };
+
+  QStringList parts, tooltip;
+
+  const auto& t = m_core->lastRefreshTimings();
+
+  if (t.time.isNull()) {
+    parts.push_back(tr("Refresh: -"));
+  } else {
+    parts.push_back(tr("Refresh: %1s").arg(s(t.total)));
+
+    tooltip.push_back(
+      (t.incremental ?
+        tr("Last refresh at %1 (incremental):") :
+        tr("Last refresh at %1:"))
+      .arg(t.time.toString(Qt::DefaultLocaleShortDate)));
+
+    for (auto&& [name, d] : t.phases) {
+      tooltip.push_back(tr("  %1: %2s").arg(name).arg(s(d)));
+    }
+  }
+
+  // the structure is only replaced on this thread
+  if (auto* root = m_core->directoryStructure()) {
+    const auto fr = root->getFileRegister();
+
+    std::size_t origins = 0;
+    root->getOriginConnection()->forEachOrigin([&](auto&&) { ++origins; });
+
+    parts.push_back(tr("Files: %1").arg(fr->highestCount()));
+    parts.push_back(tr("Origins: %1").arg(origins));
+    parts.push_back(tr("Structure: %1").arg(
+      MOBase::localizedByteSize(
+        static_cast<unsigned long long>(fr->allocatedBytes()))));
+  }
+
+  parts.push_back(tr("Nexus queue: %1")
+    .arg(NexusInterface::instance().getAPIStats().requestsQueued));
+
+  parts.push_back(tr("Downloads: %1")
+    .arg(MOBase::localizedByteSpeed(m_core->downloadManager()->currentSpeed())));
+
+  const auto& te = MOShared::TaskExecutor::instance();
+  parts.push_back(tr("Threads: %1/%2")
+    .arg(te.busyThreads())
+    .arg(te.threadCount()));
+
+  tooltip.push_back(tr("Tasks waiting for a thread: %1").arg(te.queuedTasks()));
+
+  m_perf->setText(parts.join(" | "));
+  m_perf->setToolTip(tooltip.join("\n"));
 }
 
 void StatusBar::updateNormalMessage(OrganizerCore& core)
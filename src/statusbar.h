@@ -3,6 +3,7 @@
 
 #include <QStatusBar>
 #include <QProgressBar>
+#include <QTimer>
 
 struct APIStats;
 class APIUserAccount;
@@ -38,7 +39,7 @@ class StatusBar : public QStatusBar
 public:
   StatusBar(QWidget* parent=nullptr);
 
-  void setup(Ui::MainWindow* ui, const Settings& settings);
+  void setup(Ui::MainWindow* ui, OrganizerCore& core);
 
   void setProgress(int percent);
   void setNotifications(bool hasNotifications);
@@ -61,7 +62,14 @@ private:
   StatusBarAction* m_update;
   QLabel* m_api;
 
+  // performance of the structure, the downloads and the background threads,
+  // see DiagnosticsSettings::performanceStats()
+  OrganizerCore* m_core;
+  QLabel* m_perf;
+  QTimer m_perfTimer;
+
   void visibilityChanged(bool visible);
+  void updatePerformance();
 };
 
 #endif // MO_STATUSBAR_H
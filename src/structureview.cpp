@@ -0,0 +1,210 @@
+#include "structureview.h"
+#include "shared/directoryentry.h"
+#include "shared/directorysnapshot.h"
+#include "shared/fileentry.h"
+#include "shared/filesorigin.h"
+#include "shared/util.h"
+#include <utility.h>
+#include <QDir>
+#include <QHash>
+
+using namespace MOShared;
+using namespace MOBase;
+
+StructureView::Pin::Pin(DirectoryEntry* root)
+  : m_root(root), m_retired(false)
+{
+}
+
+StructureView::Pin::~Pin()
+{
+  // the structure is still owned by OrganizerCore unless it was replaced
+  if (m_retired) {
+    delete m_root;
+  }
+}
+
+DirectoryEntry* StructureView::Pin::root() const
+{
+  return m_root;
+}
+
+void StructureView::Pin::retire()
+{
+  m_retired = true;
+}
+
+
+StructureView::StructureView(std::shared_ptr<Pin> pin)
+  : m_pin(std::move(pin))
+{
+}
+
+bool StructureView::valid() const
+{
+  return (root() != nullptr);
+}
+
+DirectoryEntry* StructureView::root() const
+{
+  return m_pin ? m_pin->root() : nullptr;
+}
+
+DirectoryEntry* StructureView::findDirectory(const QString& path) const
+{
+  auto* r = root();
+  if (!r) {
+    return nullptr;
+  }
+
+  if (path.isEmpty() || path == ".") {
+    return r;
+  }
+
+  return r->findSubDirectoryRecursive(ToWString(path));
+}
+
+// calls `f` with the file entry of each path, or null if it doesn't exist;
+// the parent directory of consecutive files is only looked up once
+//
+template <class F>
+void forEachPath(
+  DirectoryEntry* root, const QStringList& files, F&& f)
+{
+  QHash<QString, DirectoryEntry*> dirs;
+
+  for (auto&& path : files) {
+    FileEntryPtr file;
+
+    if (root) {
+      const int sep = std::max(path.lastIndexOf('\\'), path.lastIndexOf('/'));
+
+      if (sep == -1) {
+        file = root->findFile(ToWString(path));
+      } else {
+        const QString parent = path.left(sep).toLower();
+
+        auto itor = dirs.find(parent);
+        if (itor == dirs.end()) {
+          itor = dirs.insert(
+            parent, root->findSubDirectoryRecursive(ToWString(parent)));
+        }
+
+        if (*itor) {
+          file = (*itor)->findFile(ToWString(path.mid(sep + 1)));
+        }
+      }
+    }
+
+    f(file);
+  }
+}
+
+QStringList StructureView::resolvePaths(const QStringList& files) const
+{
+  QStringList result;
+  result.reserve(files.size());
+
+  std::wstring fullPath;
+
+  forEachPath(root(), files, [&](const FileEntryPtr& file) {
+    fullPath.clear();
+
+    if (file && file->appendFullPath(fullPath)) {
+      result.append(ToQString(fullPath));
+    } else {
+      result.append(QString());
+    }
+  });
+
+  return result;
+}
+
+std::vector<QStringList> StructureView::fileOrigins(const QStringList& files) const
+{
+  std::vector<QStringList> result;
+  result.reserve(files.size());
+
+  auto* r = root();
+
+  forEachPath(r, files, [&](const FileEntryPtr& file) {
+    QStringList origins;
+
+    if (file) {
+      origins.append(ToQString(
+        r->getOriginByID(file->getOrigin()).getName()));
+
+      for (const auto& i : file->getAlternatives()) {
+        origins.append(ToQString(r->getOriginByID(i.originID()).getName()));
+      }
+    }
+
+    result.push_back(std::move(origins));
+  });
+
+  return result;
+}
+
+QStringList StructureView::listDirectories(const QString& path) const
+{
+  QStringList result;
+
+  if (auto* dir=findDirectory(path)) {
+    dir->forEachDirectory([&](const DirectoryEntry& d) {
+      result.append(ToQString(d.getName()));
+      return true;
+    });
+  }
+
+  return result;
+}
+
+// appends the relative paths of all the files in the given directory and its
+// subdirectories
+//
+static void listTreeRecursive(const DirectoryEntry& dir, QStringList& out)
+{
+  // relative paths start with a separator
+  const auto& parent = dir.getRelativePath();
+  const QString prefix = parent.empty() ?
+    QString() : ToQString(parent.substr(1)) + "\\";
+
+  dir.forEachFile([&](const FileEntry& file) {
+    out.append(prefix + ToQString(file.getName()));
+    return true;
+  });
+
+  dir.forEachDirectory([&](const DirectoryEntry& d) {
+    listTreeRecursive(d, out);
+    return true;
+  });
+}
+
+bool StructureView::dump(const QString& path, DumpFormat format) const
+{
+  auto* r = root();
+  if (!r) {
+    return false;
+  }
+
+  switch (format)
+  {
+    case DumpFormat::Snapshot:
+      return DirectorySnapshot::write(*r, ToWString(path));
+
+    case DumpFormat::Text:
+    default:
+      return r->dump(ToWString(QDir::toNativeSeparators(path)));
+  }
+}
+
+QStringList StructureView::listTree(const QString& path) const
+{
+  QStringList result;
+
+  if (auto* dir=findDirectory(path)) {
+    listTreeRecursive(*dir, result);
+  }
+
+  return result;
+}
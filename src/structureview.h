@@ -0,0 +1,113 @@
+#ifndef MODORGANIZER_STRUCTUREVIEW_INCLUDED
+#define MODORGANIZER_STRUCTUREVIEW_INCLUDED
+
+#include "shared/fileregisterfwd.h"
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+// a read-only handle over the directory structure as it was when the view was
+// created, see OrganizerCore::structureView()
+//
+// the structure is not deleted while a view on it exists: a refresh still
+// replaces the structure of OrganizerCore, but the old one is only deleted
+// once the last view on it is destroyed, so a view held across a refresh
+// keeps seeing the files it had
+//
+// refreshes and the sync of overwrite don't change a structure held by views
+// in place, they build a new one instead, see OrganizerCore::structureShared();
+// the few edits made directly from the ui, like hiding files, are still
+// visible to views, so they must be used on the ui thread, like the structure
+// itself
+//
+// the calls take lists so many lookups can be done at once; the parent
+// directories are looked up once per call instead of once per path
+//
+class StructureView
+{
+public:
+  // owns the structure once it has been replaced, shared by all the views of
+  // the same structure
+  //
+  class Pin
+  {
+  public:
+    Pin(MOShared::DirectoryEntry* root);
+    ~Pin();
+
+    Pin(const Pin&) = delete;
+    Pin& operator=(const Pin&) = delete;
+
+    MOShared::DirectoryEntry* root() const;
+
+    // called when the structure is replaced, the pin deletes it when the
+    // last view is gone
+    //
+    void retire();
+
+  private:
+    MOShared::DirectoryEntry* m_root;
+    bool m_retired;
+  };
+
+
+  enum class DumpFormat
+  {
+    // one line per loose file with its origin, see DirectoryEntry::dump()
+    Text,
+
+    // the complete structure in the binary format of DirectorySnapshot
+    Snapshot
+  };
+
+
+  // an empty view
+  //
+  StructureView() = default;
+
+  StructureView(std::shared_ptr<Pin> pin);
+
+  // whether this view has a structure
+  //
+  bool valid() const;
+
+  // full path of each file, as resolvePath() does, or an empty string for
+  // files that don't exist
+  //
+  QStringList resolvePaths(const QStringList& files) const;
+
+  // origins of each file, as getFileOrigins() does, or an empty list for
+  // files that don't exist
+  //
+  std::vector<QStringList> fileOrigins(const QStringList& files) const;
+
+  // names of the subdirectories of the given directory
+  //
+  QStringList listDirectories(const QString& path) const;
+
+  // paths relative to the data directory of all the files in the given
+  // directory and its subdirectories
+  //
+  QStringList listTree(const QString& path) const;
+
+  // writes the structure to the given file; the view keeps the structure
+  // alive, so this can run in the background; returns false on failure,
+  // which has been logged
+  //
+  bool dump(const QString& path, DumpFormat format) const;
+
+private:
+  // walks the whole structure
+  friend class FileSearchIndex;
+
+  std::shared_ptr<Pin> m_pin;
+
+  MOShared::DirectoryEntry* root() const;
+
+  // finds the given directory, "" and "." are the root
+  //
+  MOShared::DirectoryEntry* findDirectory(const QString& path) const;
+};
+
+#endif // MODORGANIZER_STRUCTUREVIEW_INCLUDED
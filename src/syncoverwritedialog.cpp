@@ -21,6 +21,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "shared/directoryentry.h"
 #include "shared/fileentry.h"
 #include "shared/filesorigin.h"
+#include "taskexecutor.h"
 #include "ui_syncoverwritedialog.h"
 
 #include <utility.h>
@@ -30,12 +31,22 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDir>
 #include <QDirIterator>
 #include <QComboBox>
+#include <QEventLoop>
+#include <QProgressDialog>
+#include <QStorageInfo>
 #include <QStringList>
+#include <QTimer>
+
+#include <atomic>
+#include <mutex>
 
 
 using namespace MOBase;
 using namespace MOShared;
 
+// number of files moved by a single task
+static constexpr std::size_t MovesPerTask = 256;
+
 
 SyncOverwriteDialog::SyncOverwriteDialog(const QString &path, DirectoryEntry *directoryStructure, QWidget *parent)
   : TutorableDialog("SyncOverwrite", parent),
@@ -128,7 +139,9 @@ void SyncOverwriteDialog::refresh(const QString &path)
 }
 
 
-void SyncOverwriteDialog::applyTo(QTreeWidgetItem *item, const QString &path, const QString &modDirectory)
+void SyncOverwriteDialog::collectMoves(
+  QTreeWidgetItem *item, const QString &path, const QString &modDirectory,
+  std::vector<Move> &moves)
 {
   for (int i = 0; i < item->childCount(); ++i) {
     QTreeWidgetItem *child = item->child(i);
@@ -139,33 +152,218 @@ void SyncOverwriteDialog::applyTo(QTreeWidgetItem *item, const QString &path, co
       filePath = child->text(0);
     }
     if (child->childCount() != 0) {
-      applyTo(child, filePath, modDirectory);
+      collectMoves(child, filePath, modDirectory, moves);
     } else {
       QComboBox *comboBox = qobject_cast<QComboBox*>(ui->syncTree->itemWidget(child, 1));
       if (comboBox != nullptr) {
         int originID = comboBox->itemData(comboBox->currentIndex(), Qt::UserRole).toInt();
         if (originID != -1) {
           FilesOrigin &origin = m_DirectoryStructure->getOriginByID(originID);
-          QString source = m_SourcePath + "/" + filePath;
-          QString destination = modDirectory + "/" + ToQString(origin.getName()) + "/" + filePath;
-          if (!QFile::remove(destination)) {
-            reportError(tr("failed to remove %1").arg(destination));
-          } else if (!QFile::rename(source, destination)) {
-            reportError(tr("failed to move %1 to %2").arg(source).arg(destination));
-          }
+
+          moves.push_back({
+            filePath, originID,
+            m_SourcePath + "/" + filePath,
+            modDirectory + "/" + ToQString(origin.getName()) + "/" + filePath});
         }
       }
     }
   }
+}
+
+
+std::vector<char> SyncOverwriteDialog::runMoves(
+  const std::vector<Move> &moves, bool parallel)
+{
+  std::vector<char> moved(moves.size(), 0);
+  std::atomic<std::size_t> done = 0;
+
+  std::mutex errorsMutex;
+  QStringList errors;
+
+  TaskGroup group(TaskPriority::High);
+
+  auto moveRange = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i=begin; i<end; ++i) {
+      if (group.cancelled()) {
+        return;
+      }
+
+      const Move& m = moves[i];
+
+      // replaces the file in the mod; copies are allowed in case a mod is on
+      // another volume
+      const BOOL r = ::MoveFileExW(
+        QDir::toNativeSeparators(m.source).toStdWString().c_str(),
+        QDir::toNativeSeparators(m.destination).toStdWString().c_str(),
+        MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED);
+
+      if (r) {
+        moved[i] = 1;
+      } else {
+        const auto e = ::GetLastError();
+
+        std::scoped_lock lock(errorsMutex);
+        errors.append(tr("failed to move %1 to %2, %3")
+          .arg(m.source).arg(m.destination).arg(formatSystemMessage(e)));
+      }
+
+      ++done;
+    }
+  };
+
+  if (parallel) {
+    for (std::size_t begin=0; begin<moves.size(); begin+=MovesPerTask) {
+      const auto end = std::min(begin + MovesPerTask, moves.size());
+      group.run([&, begin, end]{ moveRange(begin, end); });
+    }
+  } else {
+    // copies between volumes are only slowed down by running concurrently
+    group.run([&]{ moveRange(0, moves.size()); });
+  }
+
+  QProgressDialog progress(
+    tr("Moving files to mods..."), tr("Cancel"),
+    0, static_cast<int>(moves.size()), parentWidget());
+
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setAutoReset(false);
+  progress.setMinimumDuration(500);
+
+  QEventLoop loop;
+  QTimer timer;
+
+  connect(&progress, &QProgressDialog::canceled, [&]{ group.cancel(); });
+
+  connect(&timer, &QTimer::timeout, [&]{
+    progress.setValue(static_cast<int>(done.load()));
+
+    if (group.finished()) {
+      loop.quit();
+    }
+  });
+
+  timer.start(50);
+  loop.exec();
+  group.wait();
+
+  for (const auto& e : errors) {
+    log::error("{}", e);
+  }
+
+  if (!errors.isEmpty()) {
+    reportError(tr("%n file(s) could not be moved, see the log for details.\n\n%1", "",
+      errors.size()).arg(errors.first()));
+  }
+
+  return moved;
+}
+
+
+void SyncOverwriteDialog::removeEmptyDirectories(const std::vector<Move> &moves)
+{
+  // all the directories that contained moved files, including their parents
+  std::set<QString> dirs;
+
+  for (const auto& m : moves) {
+    QString dir = m.path;
+
+    for (;;) {
+      const int slash = dir.lastIndexOf('/');
+      if (slash == -1) {
+        break;
+      }
+
+      dir.truncate(slash);
+      if (!dirs.insert(dir).second) {
+        break;
+      }
+    }
+  }
+
+  // children sort after their parent, rmdir() fails if it's not empty
+  QDir root(m_SourcePath);
 
-  QDir dir(m_SourcePath + "/" + path);
-  if ((path.length() > 0) && (dir.count() == 2)) {
-    dir.rmpath(".");
+  for (auto itor=dirs.rbegin(); itor!=dirs.rend(); ++itor) {
+    root.rmdir(*itor);
   }
 }
 
 
-void SyncOverwriteDialog::apply(const QString &modDirectory)
+void SyncOverwriteDialog::patchStructure(
+  const std::vector<Move> &moves, const std::vector<char> &moved)
 {
-  applyTo(ui->syncTree->topLevelItem(0), "", modDirectory);
+  auto fileRegister = m_DirectoryStructure->getFileRegister();
+  std::vector<OriginID> owIDs;
+
+  for (std::size_t i=0; i<moves.size(); ++i) {
+    if (!moved[i]) {
+      continue;
+    }
+
+    const FileEntryPtr entry = m_DirectoryStructure->searchFile(
+      ToWString(moves[i].path));
+
+    if (!entry) {
+      continue;
+    }
+
+    bool ignore;
+    const OriginID owID = entry->getOrigin(ignore);
+
+    if (owID == moves[i].originID) {
+      continue;
+    }
+
+    if (owIDs.empty()) {
+      // the graph must be updated around the change, see ConflictGraph
+      owIDs.push_back(owID);
+      fileRegister->conflicts().exclude(owIDs);
+    }
+
+    // the mod provides the file now
+    m_DirectoryStructure->getOriginByID(owID).removeFile(entry->getIndex());
+
+    if (entry->removeOrigin(owID)) {
+      fileRegister->removeFile(entry->getIndex());
+    }
+  }
+
+  if (!owIDs.empty()) {
+    fileRegister->conflicts().include(owIDs);
+  }
+}
+
+
+std::set<QString> SyncOverwriteDialog::apply(
+  const QString &modDirectory, bool patch)
+{
+  std::vector<Move> moves;
+  collectMoves(ui->syncTree->topLevelItem(0), "", modDirectory, moves);
+
+  std::set<QString> origins;
+
+  if (moves.empty()) {
+    return origins;
+  }
+
+  const bool sameVolume =
+    (QStorageInfo(m_SourcePath).rootPath() ==
+     QStorageInfo(modDirectory).rootPath());
+
+  const auto moved = runMoves(moves, sameVolume);
+
+  removeEmptyDirectories(moves);
+
+  if (patch) {
+    patchStructure(moves, moved);
+  }
+
+  for (std::size_t i=0; i<moves.size(); ++i) {
+    if (moved[i]) {
+      origins.insert(ToQString(
+        m_DirectoryStructure->getOriginByID(moves[i].originID).getName()));
+    }
+  }
+
+  return origins;
 }
@@ -23,6 +23,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "tutorabledialog.h"
 #include "shared/fileregisterfwd.h"
 #include <QTreeWidgetItem>
+#include <set>
+#include <vector>
 
 namespace Ui {
 class SyncOverwriteDialog;
@@ -39,11 +41,35 @@ public:
 
   ~SyncOverwriteDialog();
 
-  void apply(const QString &modDirectory);
+  // moves the files to the mods selected by the user in the background while
+  // showing progress, then removes the moved files from the overwrite origin
+  // of the structure instead of refreshing it, unless `patch` is false;
+  // returns the names of the origins that received files
+  //
+  std::set<QString> apply(const QString &modDirectory, bool patch=true);
+
 private:
+  struct Move
+  {
+    // relative to the overwrite directory
+    QString path;
+    MOShared::OriginID originID;
+    QString source;
+    QString destination;
+  };
+
   void refresh(const QString &path);
   void readTree(const QString &path, MOShared::DirectoryEntry *directoryStructure, QTreeWidgetItem *subTree);
-  void applyTo(QTreeWidgetItem *item, const QString &path, const QString &modDirectory);
+  void collectMoves(QTreeWidgetItem *item, const QString &path, const QString &modDirectory, std::vector<Move> &moves);
+
+  // moves the files on the task executor, in parallel if the mods and the
+  // overwrite directory are on the same volume; returns whether each file
+  // was moved
+  //
+  std::vector<char> runMoves(const std::vector<Move> &moves, bool parallel);
+
+  void removeEmptyDirectories(const std::vector<Move> &moves);
+  void patchStructure(const std::vector<Move> &moves, const std::vector<char> &moved);
 
 private:
 
@@ -0,0 +1,315 @@
+#include "taskexecutor.h"
+#include "thread_utils.h"
+#include "shared/util.h"
+#include <log.h>
+#include <algorithm>
+
+namespace MOShared
+{
+
+using namespace MOBase;
+
+static std::size_t g_threadCount = 0;
+
+thread_local TaskExecutor::Worker* TaskExecutor::t_worker = nullptr;
+
+
+struct TaskGroup::State
+{
+  TaskPriority priority;
+  std::atomic<bool> cancelled = false;
+
+  mutable std::mutex mutex;
+  std::condition_variable cv;
+  std::size_t pending = 0;
+
+  explicit State(TaskPriority p)
+    : priority(p)
+  {
+  }
+
+  void add()
+  {
+    std::scoped_lock lock(mutex);
+    ++pending;
+  }
+
+  void done()
+  {
+    bool last = false;
+
+    {
+      std::scoped_lock lock(mutex);
+      --pending;
+      last = (pending == 0);
+    }
+
+    if (last) {
+      cv.notify_all();
+    }
+  }
+};
+
+
+TaskGroup::TaskGroup(TaskPriority priority)
+  : m_state(std::make_shared<State>(priority))
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+  wait();
+}
+
+void TaskGroup::run(std::function<void()> f)
+{
+  m_state->add();
+  TaskExecutor::instance().push(m_state->priority, m_state, std::move(f));
+}
+
+void TaskGroup::wait()
+{
+  auto& e = TaskExecutor::instance();
+
+  if (e.isExecutorThread()) {
+    // blocking here could deadlock if all the threads end up waiting for
+    // tasks that are still queued, so help instead
+    while (!finished()) {
+      if (!e.runOne()) {
+        // the remaining tasks are running on other threads
+        std::unique_lock lock(m_state->mutex);
+        m_state->cv.wait_for(
+          lock, std::chrono::milliseconds(1),
+          [&]{ return m_state->pending == 0; });
+      }
+    }
+  } else {
+    std::unique_lock lock(m_state->mutex);
+    m_state->cv.wait(lock, [&]{ return m_state->pending == 0; });
+  }
+}
+
+void TaskGroup::cancel()
+{
+  m_state->cancelled = true;
+}
+
+bool TaskGroup::cancelled() const
+{
+  return m_state->cancelled;
+}
+
+bool TaskGroup::finished() const
+{
+  std::scoped_lock lock(m_state->mutex);
+  return (m_state->pending == 0);
+}
+
+
+void TaskExecutor::setThreadCount(std::size_t n)
+{
+  g_threadCount = n;
+}
+
+TaskExecutor& TaskExecutor::instance()
+{
+  static TaskExecutor e([] {
+    if (g_threadCount > 0) {
+      return g_threadCount;
+    }
+
+    return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  }());
+
+  return e;
+}
+
+TaskExecutor::TaskExecutor(std::size_t threadCount)
+  : m_next(0), m_queued(0), m_busy(0), m_stop(false)
+{
+  log::debug("task executor: using {} threads", threadCount);
+
+  for (std::size_t i=0; i<threadCount; ++i) {
+    auto w = std::make_unique<Worker>();
+    w->index = i;
+    m_workers.push_back(std::move(w));
+  }
+
+  // started once all the workers exist, they steal from each other
+  for (auto& w : m_workers) {
+    w->thread = startSafeThread([this, w=w.get()]{ workerRun(*w); });
+  }
+}
+
+TaskExecutor::~TaskExecutor()
+{
+  {
+    std::scoped_lock lock(m_sleepMutex);
+    m_stop = true;
+  }
+
+  m_sleepCv.notify_all();
+
+  for (auto& w : m_workers) {
+    if (w->thread.joinable()) {
+      w->thread.join();
+    }
+  }
+}
+
+void TaskExecutor::post(TaskPriority priority, std::function<void()> f)
+{
+  auto state = std::make_shared<TaskGroup::State>(priority);
+  state->add();
+
+  push(priority, std::move(state), std::move(f));
+}
+
+bool TaskExecutor::isExecutorThread() const
+{
+  return (t_worker != nullptr);
+}
+
+std::size_t TaskExecutor::threadCount() const
+{
+  return m_workers.size();
+}
+
+std::size_t TaskExecutor::busyThreads() const
+{
+  return m_busy.load(std::memory_order_relaxed);
+}
+
+std::size_t TaskExecutor::queuedTasks() const
+{
+  // can briefly be negative, see m_queued
+  return static_cast<std::size_t>(
+    std::max<std::int64_t>(m_queued.load(std::memory_order_relaxed), 0));
+}
+
+void TaskExecutor::push(
+  TaskPriority priority, std::shared_ptr<TaskGroup::State> group,
+  std::function<void()> f)
+{
+  // tasks queued from a worker stay on it, they're likely to use the same
+  // data as the task that queued them
+  Worker* w = t_worker;
+  if (!w) {
+    w = m_workers[m_next++ % m_workers.size()].get();
+  }
+
+  {
+    std::scoped_lock lock(w->mutex);
+    w->queues[static_cast<std::size_t>(priority)].push_back(
+      {std::move(f), std::move(group)});
+  }
+
+  {
+    // incremented under the lock so a thread that's about to sleep can't
+    // miss it
+    std::scoped_lock lock(m_sleepMutex);
+    ++m_queued;
+  }
+
+  m_sleepCv.notify_one();
+}
+
+bool TaskExecutor::take(std::size_t worker, Task& out)
+{
+  const auto n = m_workers.size();
+
+  for (std::size_t p=0; p<PriorityCount; ++p) {
+    // own queue, most recent task first
+    {
+      auto& w = *m_workers[worker];
+      std::scoped_lock lock(w.mutex);
+
+      if (!w.queues[p].empty()) {
+        out = std::move(w.queues[p].back());
+        w.queues[p].pop_back();
+        --m_queued;
+        return true;
+      }
+    }
+
+    // other queues, oldest task first
+    for (std::size_t i=1; i<n; ++i) {
+      auto& w = *m_workers[(worker + i) % n];
+      std::scoped_lock lock(w.mutex);
+
+      if (!w.queues[p].empty()) {
+        out = std::move(w.queues[p].front());
+        w.queues[p].pop_front();
+        --m_queued;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool TaskExecutor::runOne()
+{
+  if (!t_worker) {
+    return false;
+  }
+
+  Task t;
+  if (!take(t_worker->index, t)) {
+    return false;
+  }
+
+  execute(t);
+  return true;
+}
+
+void TaskExecutor::execute(Task& t)
+{
+  if (!t.group->cancelled) {
+    try
+    {
+      t.f();
+    }
+    catch(std::exception& e)
+    {
+      log::error("unhandled exception in task: {}", e.what());
+    }
+    catch(...)
+    {
+      log::error("unhandled exception in task");
+    }
+  }
+
+  // the function may hold resources, release them before waking up waiters
+  t.f = {};
+  t.group->done();
+}
+
+void TaskExecutor::workerRun(Worker& w)
+{
+  t_worker = &w;
+  SetThisThreadName(QString("task executor %1").arg(w.index));
+
+  for (;;) {
+    Task t;
+
+    if (take(w.index, t)) {
+      ++m_busy;
+      execute(t);
+      --m_busy;
+      continue;
+    }
+
+    std::unique_lock lock(m_sleepMutex);
+    m_sleepCv.wait(lock, [&]{ return m_stop || m_queued > 0; });
+
+    if (m_stop) {
+      break;
+    }
+  }
+
+  t_worker = nullptr;
+}
+
+} // namespace
@@ -0,0 +1,188 @@
+#ifndef MO2_TASKEXECUTOR_H
+#define MO2_TASKEXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MOShared
+{
+
+// queued tasks with a higher priority are always started before the ones with
+// a lower priority; a task that has started is never interrupted
+//
+enum class TaskPriority
+{
+  // work the user is waiting for, such as refreshing the directory structure
+  High = 0,
+
+  // work that should be done soon, such as prefetching mod information
+  Normal,
+
+  // housekeeping, such as closing handles or saving metadata
+  Low
+};
+
+
+// a set of tasks that can be waited for and cancelled together, see
+// TaskExecutor
+//
+// tasks keep the state of their group alive, but the destructor waits for all
+// the tasks to finish, so tasks can safely reference the group or anything
+// that outlives it
+//
+class TaskGroup
+{
+public:
+  explicit TaskGroup(TaskPriority priority=TaskPriority::Normal);
+  ~TaskGroup();
+
+  // noncopyable
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  // queues the given function in the executor
+  //
+  void run(std::function<void()> f);
+
+  // blocks until all the tasks of this group have finished or have been
+  // skipped; when called from a thread of the executor, this runs other
+  // tasks while waiting so nested groups can't starve the executor
+  //
+  void wait();
+
+  // tasks that haven't started yet are skipped, running tasks can check
+  // cancelled() to stop early; tasks added after this are skipped as well
+  //
+  void cancel();
+
+  bool cancelled() const;
+
+  // whether no tasks are queued or running in this group
+  //
+  bool finished() const;
+
+private:
+  friend class TaskExecutor;
+  struct State;
+
+  std::shared_ptr<State> m_state;
+};
+
+
+// a fixed set of threads shared by everything that needs to run work in the
+// background, so concurrent jobs don't oversubscribe the cpu
+//
+// each thread has its own queues, one per priority; a thread takes the most
+// recent task from its own queues first and steals the oldest task from the
+// other threads when it has nothing to do, tasks queued from outside the
+// executor are spread across the threads
+//
+// idle threads sleep until a task is queued
+//
+class TaskExecutor
+{
+public:
+  // sets the number of threads used by the executor, this must be called
+  // before the executor is first used or it's ignored
+  //
+  static void setThreadCount(std::size_t n);
+
+  // the shared executor, created on first use
+  //
+  static TaskExecutor& instance();
+
+  // queues a task that isn't part of any group; it can't be waited for or
+  // cancelled
+  //
+  void post(TaskPriority priority, std::function<void()> f);
+
+  // whether the calling thread is one of the executor's threads
+  //
+  bool isExecutorThread() const;
+
+  std::size_t threadCount() const;
+
+  // number of threads currently running a task, for diagnostics
+  //
+  std::size_t busyThreads() const;
+
+  // number of tasks waiting in the queues, for diagnostics
+  //
+  std::size_t queuedTasks() const;
+
+  ~TaskExecutor();
+
+  // noncopyable
+  TaskExecutor(const TaskExecutor&) = delete;
+  TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+private:
+  friend class TaskGroup;
+
+  static constexpr std::size_t PriorityCount = 3;
+
+  struct Task
+  {
+    std::function<void()> f;
+    std::shared_ptr<TaskGroup::State> group;
+  };
+
+  struct Worker
+  {
+    std::size_t index = 0;
+    std::thread thread;
+
+    std::mutex mutex;
+    std::deque<Task> queues[PriorityCount];
+  };
+
+  // the worker of the calling thread, null on threads that are not part of
+  // the executor
+  static thread_local Worker* t_worker;
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+
+  // next worker that gets a task queued from outside the executor
+  std::atomic<std::size_t> m_next;
+
+  // number of tasks in all the queues; this can briefly be negative when a
+  // task is taken before the count is incremented
+  std::atomic<std::int64_t> m_queued;
+
+  // number of threads running a task, tasks run by a thread that's waiting
+  // for a group are not counted again
+  std::atomic<std::size_t> m_busy;
+
+  std::mutex m_sleepMutex;
+  std::condition_variable m_sleepCv;
+  bool m_stop;
+
+  explicit TaskExecutor(std::size_t threadCount);
+
+  void push(
+    TaskPriority priority, std::shared_ptr<TaskGroup::State> group,
+    std::function<void()> f);
+
+  // takes a task for the given worker, returns false if all the queues are
+  // empty
+  //
+  bool take(std::size_t worker, Task& out);
+
+  // takes and runs a task on the calling worker thread, returns false if
+  // there was nothing to run
+  //
+  bool runOne();
+
+  void execute(Task& t);
+  void workerRun(Worker& w);
+};
+
+} // namespace
+
+#endif // MO2_TASKEXECUTOR_H
@@ -1,14 +1,26 @@
 #include "texteditor.h"
 #include "utility.h"
 #include <log.h>
+#include <QScrollBar>
 #include <QSplitter>
+#include <cstring>
 
 using namespace MOBase;
 
+// files at least this large are shown in a read-only LargeTextView instead
+// of being loaded in the editor
+static const qint64 LargeFileSize = 16 * 1024 * 1024;
+
+// size of the blocks indexed before the lines are made available to the view
+static const qint64 IndexBlockSize = 4 * 1024 * 1024;
+
+// lines longer than this are cut when they're shown
+static const qint64 MaxLineBytes = 64 * 1024;
+
 TextEditor::TextEditor(QWidget* parent) :
   QPlainTextEdit(parent),
   m_toolbar(nullptr), m_lineNumbers(nullptr), m_highlighter(nullptr),
-  m_dirty(false), m_loading(false)
+  m_largeView(nullptr), m_dirty(false), m_loading(false)
 {
   m_toolbar = new TextEditorToolbar(*this);
   m_lineNumbers = new TextEditorLineNumbers(*this);
@@ -70,6 +82,12 @@ void TextEditor::clear()
   dirty(false);
   document()->setModified(false);
 
+  if (m_largeView && !m_largeView->isHidden()) {
+    m_largeView->clear();
+    m_largeView->hide();
+    show();
+  }
+
   emit loaded("");
 }
 
@@ -81,6 +99,22 @@ bool TextEditor::load(const QString& filename)
 
   m_filename = filename;
 
+  if (m_largeView && QFileInfo(filename).size() >= LargeFileSize) {
+    // the encoding is left empty, which makes save() refuse to write the
+    // file since the editor is empty
+    if (m_largeView->load(filename)) {
+      hide();
+      m_largeView->show();
+
+      onModified(false);
+      emit loaded(m_filename);
+
+      return true;
+    }
+
+    // the file couldn't be mapped, try loading it normally
+  }
+
   const QString s = MOBase::readFileText(filename, &m_encoding);
 
   setPlainText(s);
@@ -225,9 +259,15 @@ void TextEditor::setupToolbar()
   layout->addWidget(m_toolbar);
   layout->addWidget(this);
 
+  // shown instead of the edit for large files
+  m_largeView = new LargeTextView(*this);
+  m_largeView->hide();
+  layout->addWidget(m_largeView);
+
   // make the edit stretch
   layout->setStretch(0, 0);
   layout->setStretch(1, 1);
+  layout->setStretch(2, 1);
 
   // visuals
   layout->setContentsMargins(0, 0, 0, 0);
@@ -457,6 +497,308 @@ void TextEditorLineNumbers::updateArea(const QRect &rect, int dy)
 }
 
 
+LargeTextView::LargeTextView(TextEditor& editor) :
+  m_editor(editor), m_data(nullptr), m_size(0), m_codec(nullptr),
+  m_unit(1), m_bigEndian(false), m_indexed(false), m_maxWidth(0)
+{
+  setFont(editor.font());
+  viewport()->setAutoFillBackground(false);
+
+  m_progress.setInterval(100);
+  connect(&m_progress, &QTimer::timeout, [&]{ checkProgress(); });
+}
+
+LargeTextView::~LargeTextView()
+{
+  clear();
+}
+
+bool LargeTextView::load(const QString& filename)
+{
+  clear();
+
+  m_file.setFileName(filename);
+
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    log::error("can't open '{}', {}", filename, m_file.errorString());
+    return false;
+  }
+
+  m_size = m_file.size();
+  m_data = m_file.map(0, m_size);
+
+  if (!m_data) {
+    log::error("can't map '{}', {}", filename, m_file.errorString());
+    m_file.close();
+    m_size = 0;
+    return false;
+  }
+
+  // same detection as readFileText(), utf-8 is assumed without a bom
+  const QByteArray start = QByteArray::fromRawData(
+    reinterpret_cast<const char*>(m_data), static_cast<int>(std::min<qint64>(m_size, 4)));
+
+  m_codec = QTextCodec::codecForUtfText(start, QTextCodec::codecForName("UTF-8"));
+
+  qint64 first = 0;
+
+  if (m_codec->mibEnum() == 1014) {
+    // utf-16le
+    m_unit = 2;
+    m_bigEndian = false;
+    first = 2;
+  } else if (m_codec->mibEnum() == 1013) {
+    // utf-16be
+    m_unit = 2;
+    m_bigEndian = true;
+    first = 2;
+  } else if (m_codec->mibEnum() == 106) {
+    // utf-8, skip the bom if there's one
+    if (start.startsWith("\xef\xbb\xbf")) {
+      first = 3;
+    }
+  } else {
+    // utf-32 and others, not supported
+    log::error("'{}' has an unsupported encoding for a large file", filename);
+    clear();
+    return false;
+  }
+
+  m_lines.push_back(first);
+  m_indexed = false;
+
+  m_indexing.reset(new MOShared::TaskGroup(MOShared::TaskPriority::Normal));
+
+  // the group waits for its tasks when it's destroyed, so it outlives the
+  // task
+  auto* group = m_indexing.get();
+  group->run([this, group]{ index(*group); });
+
+  m_progress.start();
+  updateScrollBars();
+  verticalScrollBar()->setValue(0);
+  horizontalScrollBar()->setValue(0);
+  viewport()->update();
+
+  return true;
+}
+
+void LargeTextView::clear()
+{
+  m_progress.stop();
+
+  if (m_indexing) {
+    // waits for the current block
+    m_indexing->cancel();
+    m_indexing.reset();
+  }
+
+  if (m_data) {
+    m_file.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+  }
+
+  m_file.close();
+  m_size = 0;
+  m_codec = nullptr;
+  m_unit = 1;
+  m_maxWidth = 0;
+  m_indexed = false;
+
+  {
+    std::scoped_lock lock(m_mutex);
+    m_lines.clear();
+  }
+
+  updateScrollBars();
+  viewport()->update();
+}
+
+void LargeTextView::index(const MOShared::TaskGroup& g)
+{
+  qint64 offset = 0;
+  {
+    std::scoped_lock lock(m_mutex);
+    offset = m_lines.front();
+  }
+
+  const char* data = reinterpret_cast<const char*>(m_data);
+  std::vector<qint64> found;
+
+  while (offset < m_size && !g.cancelled()) {
+    const qint64 end = std::min(m_size, offset + IndexBlockSize);
+
+    if (m_unit == 1) {
+      const char* p = data + offset;
+      const char* const blockEnd = data + end;
+
+      while (p < blockEnd) {
+        p = static_cast<const char*>(std::memchr(p, '\n', blockEnd - p));
+        if (!p) {
+          break;
+        }
+
+        ++p;
+        found.push_back(p - data);
+      }
+    } else {
+      // the block size is even and so is the start of the text
+      const int low = (m_bigEndian ? 1 : 0);
+
+      for (qint64 i=offset; i + 1 < end; i += 2) {
+        if (data[i + low] == '\n' && data[i + 1 - low] == 0) {
+          found.push_back(i + 2);
+        }
+      }
+    }
+
+    offset = end;
+
+    std::scoped_lock lock(m_mutex);
+    m_lines.insert(m_lines.end(), found.begin(), found.end());
+    found.clear();
+  }
+
+  if (!g.cancelled()) {
+    m_indexed = true;
+  }
+}
+
+void LargeTextView::checkProgress()
+{
+  if (m_indexed) {
+    m_progress.stop();
+  }
+
+  updateScrollBars();
+  viewport()->update();
+}
+
+std::size_t LargeTextView::lineCount() const
+{
+  std::scoped_lock lock(m_mutex);
+
+  if (m_lines.empty()) {
+    return 0;
+  }
+
+  if (m_indexed && m_lines.back() < m_size) {
+    // the last line has no line break
+    return m_lines.size();
+  }
+
+  return m_lines.size() - 1;
+}
+
+QString LargeTextView::lineText(std::size_t i) const
+{
+  qint64 begin = 0, end = 0;
+
+  {
+    std::scoped_lock lock(m_mutex);
+
+    begin = m_lines[i];
+    end = (i + 1 < m_lines.size() ? m_lines[i + 1] : m_size);
+  }
+
+  end = std::min(end, begin + MaxLineBytes);
+
+  QString s = m_codec->toUnicode(
+    reinterpret_cast<const char*>(m_data) + begin, static_cast<int>(end - begin));
+
+  while (s.endsWith('\n') || s.endsWith('\r')) {
+    s.chop(1);
+  }
+
+  return s;
+}
+
+int LargeTextView::lineNumbersWidth() const
+{
+  int digits = 1;
+  auto max = std::max<std::size_t>(1, lineCount());
+
+  while (max >= 10) {
+    max /= 10;
+    ++digits;
+  }
+
+  digits = std::max(3, digits);
+
+  return 3 + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits + 3;
+}
+
+void LargeTextView::updateScrollBars()
+{
+  const int lineHeight = std::max(1, fontMetrics().height());
+  const int visible = viewport()->height() / lineHeight;
+  const auto count = static_cast<int>(std::min<std::size_t>(lineCount(), INT_MAX));
+
+  verticalScrollBar()->setRange(0, std::max(0, count - visible));
+  verticalScrollBar()->setPageStep(visible);
+  verticalScrollBar()->setSingleStep(1);
+
+  const int textWidth = viewport()->width() - lineNumbersWidth();
+
+  horizontalScrollBar()->setRange(0, std::max(0, m_maxWidth - textWidth));
+  horizontalScrollBar()->setPageStep(textWidth);
+  horizontalScrollBar()->setSingleStep(fontMetrics().horizontalAdvance(QLatin1Char('9')));
+}
+
+void LargeTextView::paintEvent(QPaintEvent*)
+{
+  QPainter painter(viewport());
+
+  const auto& lineNumbers = *m_editor.m_lineNumbers;
+  const int numbersWidth = lineNumbersWidth();
+  const int lineHeight = std::max(1, fontMetrics().height());
+  const QRect r = viewport()->rect();
+
+  painter.fillRect(r, m_editor.backgroundColor());
+  painter.fillRect(
+    QRect(r.left(), r.top(), numbersWidth, r.height()),
+    lineNumbers.backgroundColor());
+
+  if (!m_data) {
+    return;
+  }
+
+  const std::size_t count = lineCount();
+  const std::size_t first = static_cast<std::size_t>(verticalScrollBar()->value());
+  const int x = numbersWidth - horizontalScrollBar()->value();
+  const int oldMaxWidth = m_maxWidth;
+
+  int y = 0;
+
+  for (std::size_t i=first; i < count && y < r.height(); ++i) {
+    const QString text = lineText(i);
+
+    painter.setClipRect(QRect(numbersWidth, 0, r.width() - numbersWidth, r.height()));
+    painter.setPen(m_editor.textColor());
+    painter.drawText(x, y, r.width() - x, lineHeight, Qt::AlignLeft, text);
+
+    painter.setClipping(false);
+    painter.setPen(lineNumbers.textColor());
+    painter.drawText(
+      0, y, numbersWidth - 3, lineHeight,
+      Qt::AlignRight, QString::number(i + 1));
+
+    m_maxWidth = std::max(m_maxWidth, fontMetrics().horizontalAdvance(text));
+    y += lineHeight;
+  }
+
+  if (m_maxWidth != oldMaxWidth) {
+    updateScrollBars();
+  }
+}
+
+void LargeTextView::resizeEvent(QResizeEvent* e)
+{
+  QAbstractScrollArea::resizeEvent(e);
+  updateScrollBars();
+}
+
+
 TextEditorToolbar::TextEditorToolbar(TextEditor& editor) :
   m_editor(editor), m_save(nullptr), m_wordWrap(nullptr), m_explore(nullptr),
   m_path(nullptr)
@@ -1,7 +1,13 @@
 #ifndef MO_TEXTEDITOR_H
 #define MO_TEXTEDITOR_H
 
+#include "taskexecutor.h"
+#include <QAbstractScrollArea>
+#include <QFile>
 #include <QPlainTextEdit>
+#include <QTimer>
+#include <atomic>
+#include <mutex>
 
 class TextEditor;
 
@@ -80,6 +86,84 @@ private:
 };
 
 
+// read-only view used by TextEditor for files that are too large to be
+// loaded in a QPlainTextEdit, like huge logs
+//
+// the file is mapped in memory and the offsets of its lines are indexed on a
+// background task; only the visible lines are decoded and painted, with the
+// colours of the editor
+//
+class LargeTextView : public QAbstractScrollArea
+{
+  Q_OBJECT;
+
+public:
+  LargeTextView(TextEditor& editor);
+  ~LargeTextView();
+
+  // maps the given file and starts indexing it, returns false if the file
+  // can't be mapped
+  //
+  bool load(const QString& filename);
+
+  // stops indexing and unmaps the file
+  //
+  void clear();
+
+protected:
+  void paintEvent(QPaintEvent* e) override;
+  void resizeEvent(QResizeEvent* e) override;
+
+private:
+  TextEditor& m_editor;
+  QFile m_file;
+  const uchar* m_data;
+  qint64 m_size;
+
+  // codec of the file and the size of a code unit, 2 for utf-16
+  QTextCodec* m_codec;
+  int m_unit;
+  bool m_bigEndian;
+
+  // indexes the lines
+  std::unique_ptr<MOShared::TaskGroup> m_indexing;
+
+  // offsets of the start of each line, guarded by m_mutex while indexing
+  mutable std::mutex m_mutex;
+  std::vector<qint64> m_lines;
+
+  // set by the task when the whole file has been indexed
+  std::atomic<bool> m_indexed;
+
+  // updates the scrollbars while the file is being indexed
+  QTimer m_progress;
+
+  // widest line painted so far, for the horizontal scrollbar
+  int m_maxWidth;
+
+
+  // called on the background task
+  //
+  void index(const MOShared::TaskGroup& g);
+
+  // called by m_progress, stops the timer once the file is indexed
+  //
+  void checkProgress();
+
+  // number of lines that can be shown, lines are only known once the start
+  // of the next one has been found
+  //
+  std::size_t lineCount() const;
+
+  // decodes the given line, without the line break
+  //
+  QString lineText(std::size_t i) const;
+
+  int lineNumbersWidth() const;
+  void updateScrollBars();
+};
+
+
 class TextEditor : public QPlainTextEdit
 {
   Q_OBJECT;
@@ -88,6 +172,7 @@ class TextEditor : public QPlainTextEdit
   Q_PROPERTY(QColor highlightBackgroundColor READ highlightBackgroundColor WRITE setHighlightBackgroundColor);
 
   friend class TextEditorLineNumbers;
+  friend class LargeTextView;
 
 public:
   TextEditor(QWidget* parent=nullptr);
@@ -129,6 +214,10 @@ private:
   TextEditorToolbar* m_toolbar;
   TextEditorLineNumbers* m_lineNumbers;
   TextEditorHighlighter* m_highlighter;
+
+  // shown instead of the editor for large files, created by setupToolbar()
+  LargeTextView* m_largeView;
+
   QColor m_highlightBackground;
   QString m_filename;
   QString m_encoding;
@@ -0,0 +1,47 @@
+#include "tokenbucket.h"
+#include <algorithm>
+#include <limits>
+
+TokenBucket::TokenBucket(qint64 bytesPerSecond)
+  : m_Rate(0), m_Tokens(0)
+{
+  setRate(bytesPerSecond);
+}
+
+void TokenBucket::setRate(qint64 bytesPerSecond)
+{
+  m_Rate = std::max<qint64>(bytesPerSecond, 0);
+  m_Tokens = m_Rate;
+  m_Timer.start();
+}
+
+bool TokenBucket::limited() const
+{
+  return (m_Rate > 0);
+}
+
+qint64 TokenBucket::available()
+{
+  if (!limited()) {
+    return std::numeric_limits<qint64>::max();
+  }
+
+  refill();
+  return std::max<qint64>(m_Tokens, 0);
+}
+
+void TokenBucket::consume(qint64 bytes)
+{
+  if (!limited()) {
+    return;
+  }
+
+  refill();
+  m_Tokens -= bytes;
+}
+
+void TokenBucket::refill()
+{
+  const qint64 ms = m_Timer.restart();
+  m_Tokens = std::min(m_Rate, m_Tokens + (m_Rate * ms) / 1000);
+}
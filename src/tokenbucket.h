@@ -0,0 +1,46 @@
+#ifndef MODORGANIZER_TOKENBUCKET_INCLUDED
+#define MODORGANIZER_TOKENBUCKET_INCLUDED
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+// limits the number of bytes per second going through something
+//
+// the bucket fills up at the given rate and holds at most one second's worth,
+// so a reader that was idle can take a short burst; readers check available()
+// and consume() what they actually took
+//
+class TokenBucket
+{
+public:
+  // a rate of 0 means no limit
+  //
+  explicit TokenBucket(qint64 bytesPerSecond=0);
+
+  // changes the rate, the bucket starts full
+  //
+  void setRate(qint64 bytesPerSecond);
+
+  // whether there is a limit at all
+  //
+  bool limited() const;
+
+  // number of bytes that can be taken right now, never negative
+  //
+  qint64 available();
+
+  // takes the given number of bytes from the bucket
+  //
+  void consume(qint64 bytes);
+
+private:
+  qint64 m_Rate;
+  qint64 m_Tokens;
+  QElapsedTimer m_Timer;
+
+  // adds the tokens accumulated since the last call
+  //
+  void refill();
+};
+
+#endif // MODORGANIZER_TOKENBUCKET_INCLUDED
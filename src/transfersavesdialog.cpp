@@ -23,12 +23,14 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "iplugingame.h"
 #include "isavegame.h"
 #include "savegameinfo.h"
+#include "taskexecutor.h"
 #include <utility.h>
 #include <log.h>
 
 #include <QtDebug>
 #include <QDateTime>
 #include <QDir>
+#include <QEventLoop>
 #include <QFile>
 #include <QFileInfo>
 #include <QFlags>
@@ -36,8 +38,15 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QListWidget>
 #include <QListWidgetItem>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QPushButton>
 #include <QStringList>
+#include <QStorageInfo>
+#include <QTimer>
+
+#include <atomic>
+#include <mutex>
+#include <set>
 
 using namespace MOBase;
 using namespace MOShared;
@@ -118,10 +127,7 @@ void TransferSavesDialog::on_moveToLocalBtn_clicked()
           m_GamePlugin->savesDirectory(),
           m_GlobalSaves[character],
           m_Profile.savePath(),
-          [this](const QString &source, const QString &destination) -> bool {
-            return shellMove(source, destination, this);
-          },
-          "Failed to move {} to {}")) {
+          TRANSFER_MOVE)) {
     refreshGlobalSaves();
     refreshGlobalCharacters();
     refreshLocalSaves();
@@ -137,10 +143,7 @@ void TransferSavesDialog::on_copyToLocalBtn_clicked()
           m_GamePlugin->savesDirectory(),
           m_GlobalSaves[character],
           m_Profile.savePath(),
-          [this](const QString &source, const QString &destination) -> bool {
-            return shellCopy(source, destination, this);
-          },
-          "Failed to copy {} to {}")) {
+          TRANSFER_COPY)) {
     refreshLocalSaves();
     refreshLocalCharacters();
   }
@@ -154,10 +157,7 @@ void TransferSavesDialog::on_moveToGlobalBtn_clicked()
           m_Profile.savePath(),
           m_LocalSaves[character],
           m_GamePlugin->savesDirectory().absolutePath(),
-          [this](const QString &source, const QString &destination) -> bool {
-            return shellMove(source, destination, this);
-          },
-          "Failed to move {} to {}")) {
+          TRANSFER_MOVE)) {
     refreshGlobalSaves();
     refreshGlobalCharacters();
     refreshLocalSaves();
@@ -173,10 +173,7 @@ void TransferSavesDialog::on_copyToGlobalBtn_clicked()
           m_Profile.savePath(),
           m_LocalSaves[character],
           m_GamePlugin->savesDirectory().absolutePath(),
-          [this](const QString &source, const QString &destination) -> bool {
-            return shellCopy(source, destination, this);
-          },
-          "Failed to copy {} to {}")) {
+          TRANSFER_COPY)) {
     refreshGlobalSaves();
     refreshGlobalCharacters();
   }
@@ -248,9 +245,7 @@ bool TransferSavesDialog::transferCharacters(
     QString const &character, char const *message,
     QDir const& sourceDirectory,
     SaveList &saves,
-    QDir const& destination,
-    const std::function<bool(const QString &, const QString &)> &method,
-    char const *errmsg)
+    QDir const& destination, TransferMode mode)
 {
   if (QMessageBox::question(this, tr("Confirm"),
         tr(message).arg(character),
@@ -259,6 +254,8 @@ bool TransferSavesDialog::transferCharacters(
   }
 
   OverwriteMode overwriteMode = OVERWRITE_ASK;
+  std::vector<FileTransfer> files;
+  std::set<QString> directories;
 
   for (SaveListItem const &save : saves) {
     for (QString source : save->allFiles()) {
@@ -274,10 +271,118 @@ bool TransferSavesDialog::transferCharacters(
         QFile::remove(destinationFile);
       }
 
-      if (!method(sourceFile.absoluteFilePath(), destinationFile)) {
-        log::error(errmsg, sourceFile.absoluteFilePath(), destinationFile);
-      }
+      files.push_back({sourceFile.absoluteFilePath(), destinationFile});
+      directories.insert(QFileInfo(destinationFile).absolutePath());
     }
   }
+
+  for (const auto& dir : directories) {
+    QDir().mkpath(dir);
+  }
+
+  runTransfer(files, mode);
   return true;
 }
+
+// transfers a single file, returns 0 on success or the error code
+//
+static DWORD transferFile(
+  const QString& source, const QString& destination, bool move, bool link)
+{
+  const auto from = QDir::toNativeSeparators(source).toStdWString();
+  const auto to = QDir::toNativeSeparators(destination).toStdWString();
+
+  if (move) {
+    // a rename on the same volume, a copy and a delete otherwise
+    if (::MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_COPY_ALLOWED)) {
+      return 0;
+    }
+
+    return ::GetLastError();
+  }
+
+  if (link && ::CreateHardLinkW(to.c_str(), from.c_str(), nullptr)) {
+    return 0;
+  }
+
+  // also used when the link failed, such as on file systems without links
+  if (::CopyFileW(from.c_str(), to.c_str(), TRUE)) {
+    return 0;
+  }
+
+  return ::GetLastError();
+}
+
+void TransferSavesDialog::runTransfer(
+  const std::vector<FileTransfer> &files, TransferMode mode)
+{
+  if (files.empty()) {
+    return;
+  }
+
+  const bool move = (mode == TRANSFER_MOVE);
+
+  // links can't cross volumes, the files are copied in that case
+  const bool link =
+    !move && ui->linkCopies->isChecked() &&
+    QStorageInfo(files.front().first).rootPath() ==
+    QStorageInfo(QFileInfo(files.front().second).absolutePath()).rootPath();
+
+  std::atomic<std::size_t> done = 0;
+  std::mutex errorsMutex;
+  QStringList errors;
+
+  // one task per file, saves are few but can be large
+  TaskGroup group(TaskPriority::High);
+
+  for (std::size_t i=0; i<files.size(); ++i) {
+    group.run([&, i] {
+      const auto& [source, destination] = files[i];
+      const DWORD e = transferFile(source, destination, move, link);
+
+      if (e != 0) {
+        std::scoped_lock lock(errorsMutex);
+        errors.append((move ? tr("Failed to move %1 to %2, %3") : tr("Failed to copy %1 to %2, %3"))
+          .arg(source).arg(destination).arg(formatSystemMessage(e)));
+      }
+
+      ++done;
+    });
+  }
+
+  QProgressDialog progress(
+    move ? tr("Moving save games...") : tr("Copying save games..."),
+    tr("Cancel"), 0, static_cast<int>(files.size()), this);
+
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setAutoReset(false);
+  progress.setMinimumDuration(500);
+
+  QEventLoop loop;
+  QTimer timer;
+
+  // files that are being transferred are finished, the others are skipped
+  connect(&progress, &QProgressDialog::canceled, [&]{ group.cancel(); });
+
+  connect(&timer, &QTimer::timeout, [&]{
+    progress.setValue(static_cast<int>(done.load()));
+
+    if (group.finished()) {
+      loop.quit();
+    }
+  });
+
+  timer.start(50);
+  loop.exec();
+  group.wait();
+
+  for (const auto& e : errors) {
+    log::error("{}", e);
+  }
+
+  if (!errors.isEmpty()) {
+    QMessageBox::warning(this, tr("Transfer failed"),
+      tr("%n file(s) could not be transferred, see the log for details.\n\n%1", "",
+        errors.size()).arg(errors.first()));
+  }
+}
@@ -64,6 +64,10 @@ private slots:
 
 private:
   enum OverwriteMode { OVERWRITE_ASK, OVERWRITE_YES, OVERWRITE_NO };
+  enum TransferMode { TRANSFER_COPY, TRANSFER_MOVE };
+
+  // source and destination of a file
+  using FileTransfer = std::pair<QString, QString>;
 
 private:
   void refreshGlobalCharacters();
@@ -95,9 +99,13 @@ private:
   bool transferCharacters(
       QString const &character, char const *message,
       QDir const& sourceDirectory, SaveList &saves,
-      QDir const& dest,
-      const std::function<bool(const QString &, const QString &)> &method,
-      char const *errmsg);
+      QDir const& dest, TransferMode mode);
+
+  // transfers the files on the task executor while showing a progress
+  // dialog that can cancel it; moves are renames on the same volume and
+  // copies are hard links if the user asked for it and it's possible
+  //
+  void runTransfer(const std::vector<FileTransfer> &files, TransferMode mode);
 };
 
 #endif // TRANSFERSAVESDIALOG_H
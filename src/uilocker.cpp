@@ -4,6 +4,9 @@
 #include <QMenuBar>
 #include <QStatusBar>
 
+// milliseconds before the overlay is shown for a light lock
+static constexpr int LightLockDelay = 300;
+
 class UILockerInterface
 {
 public:
@@ -371,6 +374,61 @@ private:
   }
 };
 
+// installed on the application for light locks, drops input events sent to
+// anything but the overlay
+//
+class UILockerFilter : public QObject
+{
+public:
+  UILockerFilter(UILocker& locker)
+    : m_locker(locker)
+  {
+  }
+
+protected:
+  bool eventFilter(QObject* o, QEvent* e) override
+  {
+    switch (e->type())
+    {
+      case QEvent::MouseButtonPress:     // fall-through
+      case QEvent::MouseButtonRelease:
+      case QEvent::MouseButtonDblClick:
+      case QEvent::Wheel:
+      case QEvent::KeyPress:
+      case QEvent::KeyRelease:
+      case QEvent::ContextMenu:
+      case QEvent::Drop:
+      case QEvent::TouchBegin:
+      case QEvent::Shortcut:
+      {
+        // shortcuts are sent to actions, which are never part of the overlay
+        return !m_locker.isOverlay(o);
+      }
+
+      case QEvent::ShortcutOverride:
+      {
+        if (m_locker.isOverlay(o)) {
+          return false;
+        }
+
+        // accepting the override keeps shortcuts from being triggered, the
+        // key press is then dropped above
+        e->accept();
+        return true;
+      }
+
+      default:
+      {
+        return false;
+      }
+    }
+  }
+
+private:
+  UILocker& m_locker;
+};
+
+
 UILocker::Session::~Session()
 {
   unlock();
@@ -413,15 +471,45 @@ UILocker::Results UILocker::Session::result() const
   return UILocker::instance().result();
 }
 
+void UILocker::Session::setResultCallback(std::function<void ()> f)
+{
+  std::scoped_lock lock(m_mutex);
+  m_resultCallback = std::move(f);
+}
+
+void UILocker::Session::resultChanged()
+{
+  std::function<void ()> f;
+
+  {
+    std::scoped_lock lock(m_mutex);
+    f = m_resultCallback;
+  }
+
+  if (f) {
+    f();
+  }
+}
+
 
 static UILocker* g_instance = nullptr;
 
 
 UILocker::UILocker()
-  : m_parent(nullptr), m_result(NoResult)
+  : m_parent(nullptr), m_result(NoResult), m_reason(NoReason)
 {
   Q_ASSERT(!g_instance);
   g_instance = this;
+
+  m_showTimer.setSingleShot(true);
+  m_showTimer.setInterval(LightLockDelay);
+
+  QObject::connect(&m_showTimer, &QTimer::timeout, [&]{
+    if (!m_sessions.empty()) {
+      createUi(m_reason);
+      updateLabel();
+    }
+  });
 }
 
 UILocker::~UILocker()
@@ -448,10 +536,27 @@ void UILocker::setUserInterface(QWidget* parent)
   m_parent = parent;
 }
 
-std::shared_ptr<UILocker::Session> UILocker::lock(Reasons reason)
+std::shared_ptr<UILocker::Session> UILocker::lock(Reasons reason, Modes mode)
 {
   m_result = StillLocked;
-  createUi(reason);
+  m_reason = reason;
+
+  if (mode == LightLock) {
+    if (!m_filter) {
+      m_filter.reset(new UILockerFilter(*this));
+      qApp->installEventFilter(m_filter.get());
+    }
+
+    if (m_ui) {
+      m_ui->update(reason);
+    } else if (!m_showTimer.isActive()) {
+      m_showTimer.start();
+    }
+  } else {
+    m_showTimer.stop();
+    createUi(reason);
+    disableAll();
+  }
 
   auto ls = std::make_shared<Session>();
   m_sessions.push_back(ls);
@@ -488,6 +593,8 @@ void UILocker::unlock(Session* s)
   }
 
   if (m_sessions.empty()) {
+    m_showTimer.stop();
+    m_filter.reset();
     m_ui.reset();
     enableAll();
   } else {
@@ -541,22 +648,42 @@ void UILocker::createUi(Reasons reason)
   }
 
   m_ui->update(reason);
+}
+
+bool UILocker::isOverlay(QObject* o) const
+{
+  QWidget* top = (m_ui ? m_ui->topLevel() : nullptr);
+  if (!top) {
+    return false;
+  }
 
-  disableAll();
+  auto* w = qobject_cast<QWidget*>(o);
+  return (w && (w == top || top->isAncestorOf(w)));
 }
 
 void UILocker::onForceUnlock()
 {
   m_result = ForceUnlocked;
+  notifyResult();
   unlockCurrent();
 }
 
 void UILocker::onCancel()
 {
   m_result = Cancelled;
+  notifyResult();
   unlockCurrent();
 }
 
+void UILocker::notifyResult()
+{
+  for (auto& s : m_sessions) {
+    if (auto ss=s.lock()) {
+      ss->resultChanged();
+    }
+  }
+}
+
 template <class T>
 QList<T> findChildrenImmediate(QWidget* parent)
 {
@@ -2,13 +2,17 @@
 #define MODORGANIZER_UILOCKER_INCLUDED
 
 #include <QMainWindow>
+#include <QTimer>
+#include <functional>
 #include <mutex>
 
 class UILockerInterface;
+class UILockerFilter;
 
 class UILocker
 {
   friend class UILockerInterface;
+  friend class UILockerFilter;
 
 public:
   // reason to show the widget
@@ -43,6 +47,19 @@ public:
     Cancelled
   };
 
+  // how the ui is locked, given to lock()
+  //
+  enum Modes
+  {
+    // every window is disabled and the overlay is shown
+    FullLock = 0,
+
+    // input to anything but the overlay is dropped, nothing is disabled; the
+    // overlay is only shown if the lock lasts more than a moment, so quickly
+    // locking and unlocking doesn't repaint the windows
+    LightLock
+  };
+
 
   class Session
   {
@@ -56,10 +73,21 @@ public:
     DWORD pid() const;
     const QString& name() const;
 
+    // called on the ui thread when result() changes, so threads waiting on
+    // something else can be woken up instead of polling result(); an empty
+    // function removes the callback
+    //
+    void setResultCallback(std::function<void ()> f);
+
+    // calls the callback, if any
+    //
+    void resultChanged();
+
   private:
     mutable std::mutex m_mutex;
     DWORD m_pid;
     QString m_name;
+    std::function<void ()> m_resultCallback;
   };
 
 
@@ -70,7 +98,7 @@ public:
 
   void setUserInterface(QWidget* parent);
 
-  std::shared_ptr<Session> lock(Reasons reason);
+  std::shared_ptr<Session> lock(Reasons reason, Modes mode=FullLock);
   bool locked() const;
 
   Results result() const;
@@ -82,9 +110,20 @@ private:
   std::atomic<Results> m_result;
   std::vector<QPointer<QWidget>> m_disabled;
 
+  // drops input while light sessions are active
+  std::unique_ptr<UILockerFilter> m_filter;
+
+  // shows the overlay for light sessions, see LightLock
+  QTimer m_showTimer;
+  Reasons m_reason;
+
   void createUi(Reasons reason);
 
+  // whether the given object is the overlay or one of its children
+  bool isOverlay(QObject* o) const;
+
   void unlockCurrent();
+  void notifyResult();
   void unlock(Session* s);
   void updateLabel();
 
@@ -0,0 +1,152 @@
+#include "updatescheduler.h"
+#include "modinfo.h"
+#include "nexusinterface.h"
+#include "nxmaccessmanager.h"
+#include "organizercore.h"
+#include "plugincontainer.h"
+#include "settings.h"
+#include <iplugingame.h>
+#include <log.h>
+#include <algorithm>
+
+using namespace MOBase;
+
+// how often the timer checks whether a mod can be checked; the actual
+// interval between two checks is given by interval()
+static constexpr std::chrono::seconds TimerInterval(30);
+
+
+UpdateScheduler::UpdateScheduler(OrganizerCore& core, QObject* receiver)
+  : m_core(core), m_receiver(receiver)
+{
+  // the first check is done once startup has settled
+  m_next = QDateTime::currentDateTimeUtc().addSecs(
+    std::chrono::duration_cast<std::chrono::seconds>(MinInterval).count());
+
+  connect(&m_timer, &QTimer::timeout, [&]{ onTimer(); });
+  m_timer.start(std::chrono::milliseconds(TimerInterval).count());
+}
+
+void UpdateScheduler::onTimer()
+{
+  if (!m_core.settings().nexus().backgroundUpdateChecks()) {
+    return;
+  }
+
+  const auto now = QDateTime::currentDateTimeUtc();
+  if (now < m_next) {
+    return;
+  }
+
+  auto& ni = NexusInterface::instance();
+
+  if (!ni.getAccessManager()->validated()) {
+    return;
+  }
+
+  const auto user = ni.getAPIUserAccount();
+  if (user.shouldThrottle()) {
+    return;
+  }
+
+  if (ni.getAPIStats().requestsQueued > 0) {
+    // the queue is busy, this would only delay the requests that are waiting
+    return;
+  }
+
+  if (checkNext()) {
+    m_next = now.addSecs(interval().count());
+  } else {
+    // nothing is stale, no point in looking again on every tick
+    m_next = now.addSecs(
+      std::chrono::duration_cast<std::chrono::seconds>(MaxInterval).count());
+  }
+}
+
+bool UpdateScheduler::checkNext()
+{
+  const auto now = QDateTime::currentDateTimeUtc();
+  const auto cutoff = now.addSecs(
+    -std::chrono::duration_cast<std::chrono::seconds>(MinAge).count());
+
+  ModInfo::Ptr stalest;
+
+  for (unsigned int i=0; i<ModInfo::getNumMods(); ++i) {
+    auto mod = ModInfo::getByIndex(i);
+
+    if (!mod->canBeUpdated()) {
+      continue;
+    }
+
+    // never checked mods have an invalid time, which is earlier than anything
+    const auto last = mod->getLastNexusUpdate();
+    if (last.isValid() && last >= cutoff) {
+      continue;
+    }
+
+    auto itor = m_attempted.find(mod->name());
+    if (itor != m_attempted.end() && itor->second >= cutoff) {
+      continue;
+    }
+
+    if (!validGame(mod->gameName())) {
+      continue;
+    }
+
+    if (!stalest || last < stalest->getLastNexusUpdate()) {
+      stalest = mod;
+    }
+  }
+
+  if (!stalest) {
+    return false;
+  }
+
+  m_attempted[stalest->name()] = now;
+
+  log::debug(
+    "background update check for '{}', last checked {}",
+    stalest->name(),
+    stalest->getLastNexusUpdate().isValid() ?
+      stalest->getLastNexusUpdate().toString(Qt::ISODate) : QString("never"));
+
+  NexusInterface::instance().requestUpdates(
+    stalest->nexusId(), m_receiver, QVariant(),
+    stalest->gameName().toLower(), QString());
+
+  return true;
+}
+
+std::chrono::seconds UpdateScheduler::interval() const
+{
+  using namespace std::chrono;
+
+  const auto user = NexusInterface::instance().getAPIUserAccount();
+
+  const double budget = user.limits().maxDailyRequests * LimitShare;
+  const double checks = budget / RequestsPerCheck;
+
+  if (checks < 1) {
+    return duration_cast<seconds>(MaxInterval);
+  }
+
+  const auto d = duration_cast<seconds>(hours(24)) / checks;
+
+  return std::clamp(
+    duration_cast<seconds>(d),
+    duration_cast<seconds>(MinInterval),
+    duration_cast<seconds>(MaxInterval));
+}
+
+bool UpdateScheduler::validGame(const QString& gameName) const
+{
+  for (auto* game : m_core.pluginContainer().plugins<IPluginGame>()) {
+    if (game->gameShortName().compare(gameName, Qt::CaseInsensitive) == 0) {
+      return !game->gameNexusName().isEmpty();
+    }
+  }
+
+  // mods from games without a plugin are checked with the managed game, see
+  // ModInfo::checkAllForUpdate()
+  return !m_core.managedGame()->gameNexusName().isEmpty();
+}
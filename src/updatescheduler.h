@@ -0,0 +1,76 @@
+#ifndef MODORGANIZER_UPDATESCHEDULER_INCLUDED
+#define MODORGANIZER_UPDATESCHEDULER_INCLUDED
+
+#include <QDateTime>
+#include <QObject>
+#include <QTimer>
+#include <chrono>
+#include <map>
+
+class OrganizerCore;
+
+// checks mods for updates in the background, one at a time, when enabled in
+// the nexus settings
+//
+// instead of the burst of requests sent by ModInfo::checkAllForUpdate(), the
+// mod whose last check on nexus is the oldest is checked regularly, spending
+// a small share of the daily api limit; a mod is checked again at the
+// earliest a day later, so new updates show up steadily without ever having
+// to check everything at once
+//
+// nothing is checked while the user isn't logged in, when requests are
+// already waiting in the queue, or when the api limits are low enough that
+// requests should be throttled
+//
+// replies go to the receiver, the same one as for the manual update checks,
+// which updates the last check time of the mod
+//
+class UpdateScheduler : public QObject
+{
+  Q_OBJECT;
+
+public:
+  UpdateScheduler(OrganizerCore& core, QObject* receiver);
+
+private:
+  // share of the daily api limit used for background checks
+  static constexpr double LimitShare = 0.05;
+
+  // requests a check can use, the update list and possibly the mod info
+  static constexpr int RequestsPerCheck = 2;
+
+  // bounds of the time between two checks
+  static constexpr std::chrono::minutes MinInterval{1};
+  static constexpr std::chrono::minutes MaxInterval{30};
+
+  // mods checked more recently than this are left alone
+  static constexpr std::chrono::hours MinAge{24};
+
+  OrganizerCore& m_core;
+  QObject* m_receiver;
+  QTimer m_timer;
+
+  // when the next check can be done
+  QDateTime m_next;
+
+  // when each mod was last asked for, by name; a check can fail, in which
+  // case the last check time of the mod isn't updated and it would be asked
+  // for again on every tick
+  std::map<QString, QDateTime> m_attempted;
+
+  void onTimer();
+
+  // checks the stalest mod, returns false if none needed to be checked
+  //
+  bool checkNext();
+
+  // time between two checks for the current api limits
+  //
+  std::chrono::seconds interval() const;
+
+  // whether the given game can be checked on nexus
+  //
+  bool validGame(const QString& gameName) const;
+};
+
+#endif // MODORGANIZER_UPDATESCHEDULER_INCLUDED
@@ -70,23 +70,69 @@ LogWorker::~LogWorker()
 
 void LogWorker::process()
 {
+  using namespace std::chrono;
+
   MOShared::SetThisThreadName("LogWorker");
 
+  // messages are written in batches, the file is flushed when the batch gets
+  // large, once in a while when messages keep coming, and when there's
+  // nothing left to read
+  const int maxPending = 256 * 1024;
+  const auto flushInterval = milliseconds(500);
+
+  m_Pending.reserve(maxPending + static_cast<int>(m_Buffer.size()));
+  auto lastFlush = steady_clock::now();
+
   int noLogCycles = 0;
   while (!m_QuitRequested) {
-    if (GetLogMessages(&m_Buffer[0], m_Buffer.size(), false)) {
-      m_LogFile.write(m_Buffer.c_str());
-      m_LogFile.write("\n");
-      m_LogFile.flush();
+    // drains everything that's queued before touching the file
+    int count = 0;
+    while (GetLogMessages(&m_Buffer[0], m_Buffer.size(), false)) {
+      m_Pending.append(m_Buffer.c_str());
+      m_Pending.append('\n');
+      ++count;
+
+      if (m_Pending.size() >= maxPending) {
+        break;
+      }
+    }
+
+    if (count > 0) {
       noLogCycles = 0;
+
+      const auto now = steady_clock::now();
+      if (m_Pending.size() >= maxPending || (now - lastFlush) >= flushInterval) {
+        writePending();
+        lastFlush = now;
+      }
     } else {
+      // usvfs has no way of signalling new messages, so this still sleeps,
+      // but only once everything has been written
+      writePending();
+      lastFlush = steady_clock::now();
+
       QThread::msleep(std::min(40, noLogCycles) * 5);
       ++noLogCycles;
     }
   }
+
+  writePending();
   emit finished();
 }
 
+void LogWorker::writePending()
+{
+  if (m_Pending.isEmpty()) {
+    return;
+  }
+
+  m_LogFile.write(m_Pending);
+  m_LogFile.flush();
+
+  // keeps the reserved capacity
+  m_Pending.resize(0);
+}
+
 void LogWorker::exit()
 {
   m_QuitRequested = true;
@@ -107,6 +153,82 @@ LogLevel toUsvfsLogLevel(log::Levels level)
   }
 }
 
+static bool sameMapping(const Mapping& a, const Mapping& b)
+{
+  return
+    a.isDirectory == b.isDirectory &&
+    a.createTarget == b.createTarget &&
+    a.source == b.source &&
+    a.destination == b.destination;
+}
+
+// links to add to usvfs, all the paths are null-terminated and stored one
+// after the other in a single buffer
+//
+struct LinkTable
+{
+  struct Link
+  {
+    // offsets in `paths`
+    std::size_t source;
+    std::size_t destination;
+
+    bool isDirectory;
+    unsigned int flags;
+  };
+
+  std::wstring paths;
+  std::vector<Link> links;
+
+  const wchar_t* path(std::size_t offset) const
+  {
+    return paths.c_str() + offset;
+  }
+};
+
+// encodes the given mappings, starting at `begin`, before usvfs is called so
+// linking doesn't have to convert and allocate strings for every entry
+//
+static LinkTable makeLinkTable(const MappingType& mapping, std::size_t begin)
+{
+  LinkTable t;
+
+  std::size_t size = 0;
+  for (std::size_t i = begin; i < mapping.size(); ++i) {
+    size += mapping[i].source.size() + mapping[i].destination.size() + 2;
+  }
+
+  t.paths.reserve(size);
+  t.links.reserve(mapping.size() - begin);
+
+  // QString is already utf-16, which is what wchar_t is on windows
+  auto add = [&](const QString& s) {
+    const auto offset = t.paths.size();
+    t.paths.append(reinterpret_cast<const wchar_t*>(s.utf16()), s.size());
+    t.paths.push_back(L'\0');
+    return offset;
+  };
+
+  for (std::size_t i = begin; i < mapping.size(); ++i) {
+    const auto& map = mapping[i];
+
+    LinkTable::Link link;
+    link.source = add(map.source);
+    link.destination = add(map.destination);
+    link.isDirectory = map.isDirectory;
+
+    if (map.isDirectory) {
+      link.flags = (map.createTarget ? LINKFLAG_CREATETARGET : 0) | LINKFLAG_RECURSIVE;
+    } else {
+      link.flags = 0;
+    }
+
+    t.links.push_back(link);
+  }
+
+  return t;
+}
+
 CrashDumpsType toUsvfsCrashDumpsType(env::CoreDumpTypes type)
 {
   switch (type)
@@ -186,47 +308,76 @@ UsvfsConnector::~UsvfsConnector()
 }
 
 
-void UsvfsConnector::updateMapping(const MappingType &mapping)
+void UsvfsConnector::updateMapping(const MappingType &mapping, bool interactive)
 {
   const auto start = std::chrono::high_resolution_clock::now();
 
-  QProgressDialog progress(qApp->activeWindow());
-  progress.setLabelText(tr("Preparing vfs"));
-  progress.setMaximum(static_cast<int>(mapping.size()));
-  progress.show();
+  // links are applied in order and later ones win, so the installed mapping
+  // can only be reused when it's a prefix of the new one
+  std::size_t reused = 0;
+  while (reused < m_Mapping.size() && reused < mapping.size() &&
+         sameMapping(m_Mapping[reused], mapping[reused])) {
+    ++reused;
+  }
+
+  if (reused < m_Mapping.size()) {
+    reused = 0;
+  }
+
+  if (reused == mapping.size() && !mapping.empty()) {
+    log::debug("VFS mappings unchanged, reusing {} links", reused);
+    return;
+  }
+
+  const LinkTable table = makeLinkTable(mapping, reused);
+
+  std::unique_ptr<QProgressDialog> progress;
+
+  if (interactive) {
+    progress.reset(new QProgressDialog(qApp->activeWindow()));
+    progress->setLabelText(tr("Preparing vfs"));
+    progress->setMaximum(static_cast<int>(table.links.size()));
+    progress->show();
+  }
 
   int value = 0;
   int files = 0;
   int dirs = 0;
 
-  log::debug("Updating VFS mappings...");
+  log::debug("Updating VFS mappings, reusing {} links...", reused);
 
-  ClearVirtualMappings();
+  if (reused == 0) {
+    ClearVirtualMappings();
+  }
 
-  for (auto map : mapping) {
-    if (progress.wasCanceled()) {
-      ClearVirtualMappings();
-      throw UsvfsConnectorException("VFS mapping canceled by user");
-    }
-    progress.setValue(value++);
-    if (value % 10 == 0) {
+  m_Mapping.clear();
+
+  for (const auto& link : table.links) {
+    // the dialog is only updated every so often, repainting it is slower
+    // than adding a link
+    if (progress && (value++ % 100) == 0) {
+      if (progress->wasCanceled()) {
+        ClearVirtualMappings();
+        throw UsvfsConnectorException("VFS mapping canceled by user");
+      }
+
+      progress->setValue(value);
       QCoreApplication::processEvents();
     }
 
-    if (map.isDirectory) {
-      VirtualLinkDirectoryStatic(map.source.toStdWString().c_str(),
-                                 map.destination.toStdWString().c_str(),
-                                 (map.createTarget ? LINKFLAG_CREATETARGET : 0)
-                                     | LINKFLAG_RECURSIVE
-                                 );
+    if (link.isDirectory) {
+      VirtualLinkDirectoryStatic(
+        table.path(link.source), table.path(link.destination), link.flags);
       ++dirs;
     } else {
-      VirtualLinkFile(map.source.toStdWString().c_str(),
-                      map.destination.toStdWString().c_str(), 0);
+      VirtualLinkFile(
+        table.path(link.source), table.path(link.destination), link.flags);
       ++files;
     }
   }
 
+  m_Mapping = mapping;
+
   const auto end = std::chrono::high_resolution_clock::now();
   const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 
@@ -235,6 +386,11 @@ void UsvfsConnector::updateMapping(const MappingType &mapping)
     dirs, files, time.count());
 }
 
+void UsvfsConnector::invalidateMapping()
+{
+  m_Mapping.clear();
+}
+
 void UsvfsConnector::updateParams(
   MOBase::log::Levels logLevel, env::CoreDumpTypes coreDumpType,
   const QString& crashDumpsPath, std::chrono::seconds spawnDelay,
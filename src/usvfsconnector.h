@@ -21,6 +21,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef USVFSCONNECTOR_H
 #define USVFSCONNECTOR_H
 
+#include <atomic>
 #include <exception>
 #include <filemapping.h>
 #include <QString>
@@ -56,9 +57,15 @@ signals:
 private:
 
   std::string m_Buffer;
-  bool m_QuitRequested;
+  std::atomic<bool> m_QuitRequested;
   QFile m_LogFile;
 
+  // messages that haven't been written to the file yet
+  QByteArray m_Pending;
+
+  // writes the pending messages and flushes the file
+  void writePending();
+
 };
 
 
@@ -85,7 +92,18 @@ public:
   UsvfsConnector();
   ~UsvfsConnector();
 
-  void updateMapping(const MappingType &mapping);
+  // installs the given mapping in usvfs; nothing is done if it's the same as
+  // the one that's installed and only the new links are added if it extends
+  // it, since usvfs can't remove individual links; a cancellable progress
+  // dialog is shown unless `interactive` is false
+  //
+  void updateMapping(const MappingType &mapping, bool interactive=true);
+
+  // forgets the installed mapping so the next updateMapping() links
+  // everything again; directories are linked statically, so this must be
+  // called when the content of the mods changes on disk
+  //
+  void invalidateMapping();
 
   void updateParams(
     MOBase::log::Levels logLevel, env::CoreDumpTypes coreDumpType,
@@ -100,6 +118,9 @@ private:
   LogWorker m_LogWorker;
   QThread m_WorkerThread;
 
+  // the mapping currently installed in usvfs, empty if it's unknown
+  MappingType m_Mapping;
+
 };
 
 CrashDumpsType crashDumpsType(int type);
@@ -10,9 +10,20 @@ ViewMarkingScrollBar::ViewMarkingScrollBar(QTreeView* view, int role)
   : QScrollBar(view)
   , m_view(view)
   , m_role(role)
+  , m_dirty(true)
 {
   // not implemented for horizontal sliders
   Q_ASSERT(this->orientation() == Qt::Vertical);
+
+  // collapsed rows have no markers
+  connect(view, &QTreeView::expanded, [=]{ invalidateMarkers(); });
+  connect(view, &QTreeView::collapsed, [=]{ invalidateMarkers(); });
+}
+
+void ViewMarkingScrollBar::invalidateMarkers()
+{
+  m_dirty = true;
+  update();
 }
 
 QColor ViewMarkingScrollBar::color(const QModelIndex& index) const
@@ -24,32 +35,97 @@ QColor ViewMarkingScrollBar::color(const QModelIndex& index) const
   return QColor();
 }
 
-void ViewMarkingScrollBar::paintEvent(QPaintEvent* event)
+void ViewMarkingScrollBar::resizeEvent(QResizeEvent* event)
 {
-  if (m_view->model() == nullptr) {
+  m_dirty = true;
+  QScrollBar::resizeEvent(event);
+}
+
+void ViewMarkingScrollBar::watchModel()
+{
+  auto* model = m_view->model();
+  if (model == m_model) {
     return;
   }
-  QScrollBar::paintEvent(event);
 
-  QStyleOptionSlider styleOption;
-  initStyleOption(&styleOption);
+  for (auto&& c : m_connections) {
+    disconnect(c);
+  }
 
-  QPainter painter(this);
+  m_connections.clear();
+  m_model = model;
+  m_dirty = true;
 
-  QRect handleRect = style()->subControlRect(QStyle::CC_ScrollBar, &styleOption, QStyle::SC_ScrollBarSlider, this);
-  QRect innerRect = style()->subControlRect(QStyle::CC_ScrollBar, &styleOption, QStyle::SC_ScrollBarGroove, this);
+  if (!model) {
+    return;
+  }
 
-  auto indices = visibleIndex(m_view, 0);
+  auto invalidate = [=]{ invalidateMarkers(); };
 
-  painter.translate(innerRect.topLeft() + QPoint(0, 3));
-  qreal scale = static_cast<qreal>(innerRect.height() - 3) / static_cast<qreal>(indices.size());
+  m_connections = {
+    connect(model, &QAbstractItemModel::dataChanged, [=](
+      const QModelIndex&, const QModelIndex&, const QVector<int>& roles) {
+        if (roles.isEmpty() || roles.contains(m_role)) {
+          invalidateMarkers();
+        }
+      }),
+
+    connect(model, &QAbstractItemModel::layoutChanged, invalidate),
+    connect(model, &QAbstractItemModel::modelReset, invalidate),
+    connect(model, &QAbstractItemModel::rowsInserted, invalidate),
+    connect(model, &QAbstractItemModel::rowsRemoved, invalidate),
+    connect(model, &QAbstractItemModel::rowsMoved, invalidate)
+  };
+}
+
+void ViewMarkingScrollBar::drawMarkers(const QSize& size, int width)
+{
+  const qreal dpr = devicePixelRatioF();
+
+  m_markers = QPixmap(size * dpr);
+  m_markers.setDevicePixelRatio(dpr);
+  m_markers.fill(Qt::transparent);
+
+  const auto indices = visibleIndex(m_view, 0);
+  if (indices.isEmpty()) {
+    return;
+  }
+
+  QPainter painter(&m_markers);
+
+  painter.translate(QPoint(0, 3));
+  qreal scale = static_cast<qreal>(size.height() - 3) / static_cast<qreal>(indices.size());
 
   for (int i = 0; i < indices.size(); ++i) {
     QColor color = this->color(indices[i]);
     if (color.isValid()) {
       painter.setPen(color);
       painter.setBrush(color);
-      painter.drawRect(QRect(2, i * scale - 2, handleRect.width() - 5, 3));
+      painter.drawRect(QRect(2, i * scale - 2, width - 5, 3));
     }
   }
 }
+
+void ViewMarkingScrollBar::paintEvent(QPaintEvent* event)
+{
+  if (m_view->model() == nullptr) {
+    return;
+  }
+  QScrollBar::paintEvent(event);
+
+  watchModel();
+
+  QStyleOptionSlider styleOption;
+  initStyleOption(&styleOption);
+
+  QRect handleRect = style()->subControlRect(QStyle::CC_ScrollBar, &styleOption, QStyle::SC_ScrollBarSlider, this);
+  QRect innerRect = style()->subControlRect(QStyle::CC_ScrollBar, &styleOption, QStyle::SC_ScrollBarGroove, this);
+
+  if (m_dirty || m_markers.size() != innerRect.size() * m_markers.devicePixelRatio()) {
+    drawMarkers(innerRect.size(), handleRect.width());
+    m_dirty = false;
+  }
+
+  QPainter painter(this);
+  painter.drawPixmap(innerRect.topLeft(), m_markers);
+}
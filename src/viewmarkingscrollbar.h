@@ -3,15 +3,31 @@
 
 #include <QTreeView>
 #include <QScrollBar>
-
-
+#include <QPixmap>
+#include <QPointer>
+#include <vector>
+
+
+// draws a marker in the groove for each row of the view that has a color
+//
+// the markers are drawn once in a pixmap, which is redrawn when the model
+// changes, when rows are expanded or collapsed, when the scroll bar is
+// resized or when invalidateMarkers() is called; hovering and scrolling only
+// paint the pixmap
+//
 class ViewMarkingScrollBar : public QScrollBar
 {
 public:
   ViewMarkingScrollBar(QTreeView* view, int role);
 
+  // redraws the markers on the next paint, must be called when color() would
+  // return something different without the model having changed
+  //
+  void invalidateMarkers();
+
 protected:
   void paintEvent(QPaintEvent *event) override;
+  void resizeEvent(QResizeEvent* event) override;
 
   // retrieve the color of the marker for the given index
   //
@@ -20,6 +36,21 @@ protected:
 private:
   QTreeView* m_view;
   int m_role;
+
+  // model the connections are for, the view can change models
+  QPointer<QAbstractItemModel> m_model;
+  std::vector<QMetaObject::Connection> m_connections;
+
+  QPixmap m_markers;
+  bool m_dirty;
+
+  // connects to the signals of the current model if it changed
+  //
+  void watchModel();
+
+  // draws the markers in m_markers for a groove of the given size
+  //
+  void drawMarkers(const QSize& size, int width);
 };
 
 
@@ -0,0 +1,379 @@
+#include "volumescheduler.h"
+#include "taskexecutor.h"
+#include <log.h>
+#include <QString>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <windows.h>
+#include <winioctl.h>
+
+using namespace MOBase;
+using namespace MOShared;
+
+// throughput is measured over windows at least this long, walks of small
+// mods take a few milliseconds and vary too much to be compared one by one
+static constexpr std::chrono::milliseconds MeasureWindow(250);
+
+// throughput changes smaller than this are noise, the number of walks is
+// left alone
+static constexpr double Tolerance = 0.1;
+
+
+// the walks of one volume; workers take directories from the queue until it's
+// empty or until there are more workers than the current number of walks
+//
+class VolumeScheduler::Lane
+{
+public:
+  Lane(
+    std::wstring root, DriveKind kind, int concurrency, int max,
+    TaskGroup& group, const WalkF& walk, bool background)
+      : m_root(std::move(root)), m_kind(kind), m_group(group), m_walk(walk),
+        m_background(background), m_limit(concurrency), m_max(max),
+        m_active(0), m_direction(1), m_windowEntries(0), m_lastRate(0),
+        m_totalEntries(0)
+  {
+  }
+
+  void add(std::size_t i)
+  {
+    m_pending.push_back(i);
+  }
+
+  void start()
+  {
+    m_start = std::chrono::steady_clock::now();
+    m_windowStart = m_start;
+
+    std::scoped_lock lock(m_mutex);
+    spawn();
+  }
+
+  int concurrency() const
+  {
+    return m_limit;
+  }
+
+  void report() const
+  {
+    using namespace std::chrono;
+
+    const auto s = duration<double>(steady_clock::now() - m_start).count();
+
+    log::debug(
+      "volume {} ({}): {} entries, {:.0f}/s, ended with {} walks",
+      QString::fromStdWString(m_root), kindName(m_kind), m_totalEntries,
+      (s > 0 ? m_totalEntries / s : 0.0), m_limit);
+  }
+
+private:
+  const std::wstring m_root;
+  const DriveKind m_kind;
+  TaskGroup& m_group;
+  const WalkF& m_walk;
+  const bool m_background;
+
+  std::mutex m_mutex;
+  std::deque<std::size_t> m_pending;
+
+  // current number of walks and the number of workers running
+  int m_limit;
+  const int m_max;
+  int m_active;
+
+  // +1 or -1, where the number of walks moved last
+  int m_direction;
+
+  // entries walked since the start of the window and the rate of the last
+  // window, in entries per second
+  std::chrono::steady_clock::time_point m_windowStart;
+  std::size_t m_windowEntries;
+  double m_lastRate;
+
+  std::chrono::steady_clock::time_point m_start;
+  std::size_t m_totalEntries;
+
+  // starts workers until there are as many as the number of walks; called
+  // with the lock held
+  //
+  void spawn()
+  {
+    const int wanted = std::min(
+      m_limit, m_active + static_cast<int>(m_pending.size()));
+
+    for (; m_active < wanted; ++m_active) {
+      m_group.run([this] { work(); });
+    }
+  }
+
+  void work()
+  {
+    // lowers the io and memory priorities of this thread, the walks are the
+    // only thing it runs until this task returns
+    if (m_background) {
+      ::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+    }
+
+    for (;;) {
+      std::size_t i = 0;
+
+      {
+        std::scoped_lock lock(m_mutex);
+
+        if (m_pending.empty() || m_active > m_limit) {
+          --m_active;
+          break;
+        }
+
+        i = m_pending.front();
+        m_pending.pop_front();
+      }
+
+      const std::size_t entries = m_walk(i);
+
+      std::scoped_lock lock(m_mutex);
+      record(entries);
+      spawn();
+    }
+
+    if (m_background) {
+      ::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+    }
+  }
+
+  // adds the entries of a walk to the current window and adjusts the number
+  // of walks once the window is long enough; called with the lock held
+  //
+  void record(std::size_t entries)
+  {
+    using namespace std::chrono;
+
+    m_totalEntries += entries;
+    m_windowEntries += entries;
+
+    const auto now = steady_clock::now();
+    const auto elapsed = now - m_windowStart;
+
+    if (elapsed < MeasureWindow) {
+      return;
+    }
+
+    const double rate = m_windowEntries / duration<double>(elapsed).count();
+
+    int step = 0;
+
+    if (m_lastRate == 0) {
+      // first window, try more walks
+      step = 1;
+    } else if (rate > m_lastRate * (1 + Tolerance)) {
+      // the last change helped
+      step = m_direction;
+    } else if (rate < m_lastRate * (1 - Tolerance)) {
+      // the last change made it worse, go back
+      step = -m_direction;
+    }
+
+    if (step != 0) {
+      const int next = std::clamp(m_limit + step, 1, m_max);
+
+      if (next != m_limit) {
+        m_direction = step;
+        m_limit = next;
+      }
+    }
+
+    m_lastRate = rate;
+    m_windowStart = now;
+    m_windowEntries = 0;
+  }
+};
+
+
+void VolumeScheduler::run(
+  const std::vector<std::wstring>& paths, bool background, const WalkF& walk)
+{
+  const int threads = std::max(
+    1, static_cast<int>(TaskExecutor::instance().threadCount()));
+
+  // mods are all in the same directory most of the time, so the volume is
+  // only looked up once per parent directory
+  std::map<std::wstring, std::wstring> rootsByParent;
+
+  // declared before the group so it waits for the workers before the lanes
+  // are destroyed
+  std::map<std::wstring, std::unique_ptr<Lane>> lanes;
+
+  TaskGroup group(TaskPriority::High);
+
+  for (std::size_t i=0; i<paths.size(); ++i) {
+    const auto& path = paths[i];
+    const auto parent = path.substr(0, path.find_last_of(L'\\'));
+
+    auto itor = rootsByParent.find(parent);
+
+    if (itor == rootsByParent.end()) {
+      wchar_t buffer[MAX_PATH + 1] = {};
+
+      // an empty root is used for everything that can't be figured out, it
+      // gets the concurrency of an unknown drive
+      std::wstring root;
+      if (::GetVolumePathNameW(path.c_str(), buffer, MAX_PATH + 1)) {
+        root = buffer;
+      }
+
+      itor = rootsByParent.emplace(parent, std::move(root)).first;
+    }
+
+    auto& lane = lanes[itor->second];
+
+    if (!lane) {
+      std::scoped_lock lock(m_mutex);
+
+      const Volume& v = volume(itor->second);
+      const int max = maxConcurrency(v.kind, threads);
+      const int initial = (v.concurrency > 0 ?
+        v.concurrency : initialConcurrency(v.kind, threads));
+
+      lane = std::make_unique<Lane>(
+        itor->second, v.kind, std::clamp(initial, 1, max), max,
+        group, walk, background);
+    }
+
+    lane->add(i);
+  }
+
+  for (auto&& [root, lane] : lanes) {
+    lane->start();
+  }
+
+  group.wait();
+
+  std::scoped_lock lock(m_mutex);
+
+  for (auto&& [root, lane] : lanes) {
+    Volume& v = volume(root);
+    v.concurrency = lane->concurrency();
+    lane->report();
+  }
+}
+
+VolumeScheduler::Volume& VolumeScheduler::volume(const std::wstring& root)
+{
+  auto itor = m_volumes.find(root);
+
+  if (itor == m_volumes.end()) {
+    Volume v;
+    v.kind = root.empty() ? DriveKind::Unknown : driveKind(root);
+
+    log::debug(
+      "volume {} is {}", QString::fromStdWString(root), kindName(v.kind));
+
+    itor = m_volumes.emplace(root, v).first;
+  }
+
+  return itor->second;
+}
+
+VolumeScheduler::DriveKind VolumeScheduler::driveKind(const std::wstring& root)
+{
+  if (::GetDriveTypeW(root.c_str()) == DRIVE_REMOTE) {
+    return DriveKind::Remote;
+  }
+
+  // the volume device, without the trailing backslash, which would open the
+  // root directory instead
+  wchar_t name[MAX_PATH + 1] = {};
+  if (!::GetVolumeNameForVolumeMountPointW(root.c_str(), name, MAX_PATH + 1)) {
+    return DriveKind::Unknown;
+  }
+
+  std::wstring device = name;
+  if (!device.empty() && device.back() == L'\\') {
+    device.pop_back();
+  }
+
+  // no access rights are needed to query the properties of the device
+  HANDLE h = ::CreateFileW(
+    device.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+    OPEN_EXISTING, 0, nullptr);
+
+  if (h == INVALID_HANDLE_VALUE) {
+    return DriveKind::Unknown;
+  }
+
+  STORAGE_PROPERTY_QUERY query = {};
+  query.PropertyId = StorageDeviceSeekPenaltyProperty;
+  query.QueryType = PropertyStandardQuery;
+
+  DEVICE_SEEK_PENALTY_DESCRIPTOR d = {};
+  DWORD bytes = 0;
+
+  const BOOL ok = ::DeviceIoControl(
+    h, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query),
+    &d, sizeof(d), &bytes, nullptr);
+
+  ::CloseHandle(h);
+
+  if (!ok || bytes < sizeof(d)) {
+    return DriveKind::Unknown;
+  }
+
+  return (d.IncursSeekPenalty ? DriveKind::Rotational : DriveKind::Solid);
+}
+
+const char* VolumeScheduler::kindName(DriveKind k)
+{
+  switch (k)
+  {
+    case DriveKind::Solid:
+      return "solid state";
+
+    case DriveKind::Rotational:
+      return "rotational";
+
+    case DriveKind::Remote:
+      return "remote";
+
+    case DriveKind::Unknown:  // fall-through
+    default:
+      return "unknown";
+  }
+}
+
+int VolumeScheduler::maxConcurrency(DriveKind k, int threads)
+{
+  switch (k)
+  {
+    case DriveKind::Rotational:
+      return std::min(threads, 2);
+
+    case DriveKind::Remote:
+      return std::min(threads, 8);
+
+    case DriveKind::Solid:  // fall-through
+    case DriveKind::Unknown:
+    default:
+      return threads;
+  }
+}
+
+int VolumeScheduler::initialConcurrency(DriveKind k, int threads)
+{
+  switch (k)
+  {
+    case DriveKind::Solid:
+      return threads;
+
+    case DriveKind::Rotational:
+      return 1;
+
+    case DriveKind::Remote:
+      return std::min(threads, 4);
+
+    case DriveKind::Unknown:  // fall-through
+    default:
+      return std::max(1, threads / 2);
+  }
+}
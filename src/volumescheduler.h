@@ -0,0 +1,79 @@
+#ifndef MODORGANIZER_VOLUMESCHEDULER_INCLUDED
+#define MODORGANIZER_VOLUMESCHEDULER_INCLUDED
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// runs the walks of a refresh grouped by the volume the directories are on,
+// with a number of concurrent walks per volume that's adjusted while they run
+//
+// more threads help on solid state drives, but they make rotational drives
+// and network shares seek between directories, which can make the walks much
+// slower; so each volume starts with a number of walks that depends on the
+// kind of drive it's on, and the number of directory entries walked per
+// second is measured regularly: the number of walks keeps moving in the same
+// direction while the throughput improves and goes back the other way when it
+// gets worse
+//
+// the number of walks that was reached for a volume is used as the starting
+// point by the next refresh
+//
+// walks can also run with background priority, which lowers the io priority
+// of the thread, used when refreshing while programs are running so they
+// don't stutter
+//
+class VolumeScheduler
+{
+public:
+  // walks a single directory, returns the number of entries that were found
+  using WalkF = std::function<std::size_t (std::size_t)>;
+
+  // calls walk(i) for every directory, in parallel on the task executor, and
+  // returns once they're all done; directories are walked in order for each
+  // volume
+  //
+  void run(
+    const std::vector<std::wstring>& paths, bool background, const WalkF& walk);
+
+private:
+  class Lane;
+
+  enum class DriveKind
+  {
+    Unknown = 0,
+    Solid,
+    Rotational,
+    Remote
+  };
+
+  struct Volume
+  {
+    DriveKind kind = DriveKind::Unknown;
+
+    // number of walks reached by the last refresh, 0 if the volume was never
+    // walked
+    int concurrency = 0;
+  };
+
+  std::mutex m_mutex;
+
+  // by volume path, as given by GetVolumePathName()
+  std::map<std::wstring, Volume> m_volumes;
+
+  // the volume for the given root, creating it if it's new
+  //
+  Volume& volume(const std::wstring& root);
+
+  static DriveKind driveKind(const std::wstring& root);
+  static const char* kindName(DriveKind k);
+
+  // maximum and initial number of walks for the given volume
+  //
+  static int maxConcurrency(DriveKind k, int threads);
+  static int initialConcurrency(DriveKind k, int threads);
+};
+
+#endif // MODORGANIZER_VOLUMESCHEDULER_INCLUDED